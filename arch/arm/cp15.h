@@ -219,4 +219,22 @@ static inline void cp15_dcache_clean_invalidate_mva(uint32_t mva)
 	asm("mcr p15, 0, %0, c7, c14, 1" :: "r"(mva));
 }
 
+/**
+ * \brief TLBIALL: Invalidate entire unified TLB
+ */
+static inline void cp15_tlb_invalidate(void)
+{
+	asm("mcr p15, 0, %0, c8, c7, 0" :: "r"(0));
+}
+
+#ifdef CONFIG_ARCH_ARMV7A
+/**
+ * \brief BPIALL: Invalidate all branch predictors
+ */
+static inline void cp15_bp_invalidate(void)
+{
+	asm("mcr p15, 0, %0, c7, c5, 6" :: "r"(0));
+}
+#endif
+
 #endif /* CP15_H_ */
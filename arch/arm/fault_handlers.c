@@ -36,6 +36,8 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#include "serial/console.h"
+
 /*----------------------------------------------------------------------------
  *        Constants
  *----------------------------------------------------------------------------*/
@@ -101,6 +103,7 @@ static const char* _data_abort_status[32] = {
 void undefined_instruction_irq_handler(void)
 {
 #ifdef CONFIG_HAVE_FAULT_DEBUG
+	console_panic_flush();
 	printf("\r\n");
 	printf("#####################\r\n");
 	printf("Undefined Instruction\r\n");
@@ -120,6 +123,7 @@ void undefined_instruction_irq_handler(void)
 void software_interrupt_irq_handler(void)
 {
 #ifdef CONFIG_HAVE_FAULT_DEBUG
+	console_panic_flush();
 	printf("\r\n");
 	printf("##################\r\n");
 	printf("Software Interrupt\r\n");
@@ -140,6 +144,7 @@ void data_abort_irq_handler(void)
 #ifdef CONFIG_HAVE_FAULT_DEBUG
 	uint32_t v1, v2, dfsr;
 
+	console_panic_flush();
 	asm("mrc p15, 0, %0, c5, c0, 0" : "=r"(v1));
 	asm("mrc p15, 0, %0, c6, c0, 0" : "=r"(v2));
 
@@ -173,6 +178,7 @@ void prefetch_abort_irq_handler(void)
 #ifdef CONFIG_HAVE_FAULT_DEBUG
 	uint32_t v1, v2, ifsr;
 
+	console_panic_flush();
 	asm("mrc p15, 0, %0, c5, c0, 1" : "=r"(v1));
 	asm("mrc p15, 0, %0, c6, c0, 2" : "=r"(v2));
 
@@ -136,7 +136,18 @@ void dcache_clean_invalidate(void)
 	dsb();
 }
 
+void dcache_sync(void)
+{
+	dsb();
+}
+
 void dcache_invalidate_region(uint32_t start, uint32_t end)
+{
+	dcache_invalidate_lines(start, end);
+	dcache_sync();
+}
+
+void dcache_invalidate_lines(uint32_t start, uint32_t end)
 {
 	uint32_t mva;
 
@@ -144,11 +155,15 @@ void dcache_invalidate_region(uint32_t start, uint32_t end)
 
 	for (mva = start & ~(L1_CACHE_BYTES - 1); mva < end; mva += L1_CACHE_BYTES)
 		cp15_dcache_invalidate_mva(mva);
-
-	dsb();
 }
 
 void dcache_clean_region(uint32_t start, uint32_t end)
+{
+	dcache_clean_lines(start, end);
+	dcache_sync();
+}
+
+void dcache_clean_lines(uint32_t start, uint32_t end)
 {
 	uint32_t mva;
 
@@ -156,11 +171,15 @@ void dcache_clean_region(uint32_t start, uint32_t end)
 
 	for (mva = start & ~(L1_CACHE_BYTES - 1); mva < end; mva += L1_CACHE_BYTES)
 		cp15_dcache_clean_mva(mva);
-
-	dsb();
 }
 
 void dcache_clean_invalidate_region(uint32_t start, uint32_t end)
+{
+	dcache_clean_invalidate_lines(start, end);
+	dcache_sync();
+}
+
+void dcache_clean_invalidate_lines(uint32_t start, uint32_t end)
 {
 	uint32_t mva;
 
@@ -168,8 +187,6 @@ void dcache_clean_invalidate_region(uint32_t start, uint32_t end)
 
 	for (mva = start & ~(L1_CACHE_BYTES - 1); mva < end; mva += L1_CACHE_BYTES)
 		cp15_dcache_clean_invalidate_mva(mva);
-
-	dsb();
 }
 
 void dcache_set_exclusive(void)
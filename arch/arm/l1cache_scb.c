@@ -140,7 +140,19 @@ void dcache_clean_invalidate(void)
 	isb();
 }
 
+void dcache_sync(void)
+{
+	dsb();
+	isb();
+}
+
 void dcache_invalidate_region(uint32_t start, uint32_t end)
+{
+	dcache_invalidate_lines(start, end);
+	dcache_sync();
+}
+
+void dcache_invalidate_lines(uint32_t start, uint32_t end)
 {
 	uint32_t mva;
 
@@ -148,12 +160,15 @@ void dcache_invalidate_region(uint32_t start, uint32_t end)
 
 	for (mva = start & ~(L1_CACHE_BYTES - 1); mva < end; mva += L1_CACHE_BYTES)
 		SCB->SCB_DCIMVAC = mva;
-
-	dsb();
-	isb();
 }
 
 void dcache_clean_region(uint32_t start, uint32_t end)
+{
+	dcache_clean_lines(start, end);
+	dcache_sync();
+}
+
+void dcache_clean_lines(uint32_t start, uint32_t end)
 {
 	uint32_t mva;
 
@@ -161,12 +176,15 @@ void dcache_clean_region(uint32_t start, uint32_t end)
 
 	for (mva = start & ~(L1_CACHE_BYTES - 1); mva < end; mva += L1_CACHE_BYTES)
 		SCB->SCB_DCCMVAC = mva;
-
-	dsb();
-	isb();
 }
 
 void dcache_clean_invalidate_region(uint32_t start, uint32_t end)
+{
+	dcache_clean_invalidate_lines(start, end);
+	dcache_sync();
+}
+
+void dcache_clean_invalidate_lines(uint32_t start, uint32_t end)
 {
 	uint32_t mva;
 
@@ -174,9 +192,6 @@ void dcache_clean_invalidate_region(uint32_t start, uint32_t end)
 
 	for (mva = start & ~(L1_CACHE_BYTES - 1); mva < end; mva += L1_CACHE_BYTES)
 		SCB->SCB_DCCIMVAC = mva;
-
-	dsb();
-	isb();
 }
 
 void dcache_set_exclusive(void)
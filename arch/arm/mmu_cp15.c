@@ -33,14 +33,192 @@
 
 #include "compiler.h"
 #include "barriers.h"
+#include "irqflags.h"
 
 #include "arm/cp15.h"
 #include "arm/mmu_cp15.h"
 
+#include "mm/cache.h"
 #include "mm/l1cache.h"
 #include "mm/mmu.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+/*------------------------------------------------------------------------------ */
+/*         Local definitions                                                     */
+/*------------------------------------------------------------------------------ */
+
+#if MMU_PAGE_TABLES > 32
+#error "MMU_PAGE_TABLES must not exceed 32"
+#endif
+
+/* Number of entries of a second-level (coarse) page table */
+#define PAGE_TABLE_ENTRIES (MMU_SECTION_SIZE / MMU_PAGE_SIZE)
+
+#if defined(CONFIG_ARCH_ARMV5TE)
+#define SECT_COMMON       (TTB_TYPE_SECT | TTB_SECT_SBO | TTB_SECT_AP_FULL_ACCESS)
+#define SECT_EXEC_NEVER   0
+#define PAGE_COMMON       (TTB_TYPE_SMALL_PAGE | TTB_PAGE_AP_FULL_ACCESS)
+#define PAGE_EXEC_NEVER   0
+#define PAGE_TABLE_COMMON (TTB_TYPE_PAGE_TABLE | TTB_PAGE_TABLE_SBO)
+#elif defined(CONFIG_ARCH_ARMV7A)
+#define SECT_COMMON       (TTB_TYPE_SECT | TTB_SECT_AP_FULL_ACCESS)
+#define SECT_EXEC_NEVER   TTB_SECT_EXEC_NEVER
+#define PAGE_COMMON       (TTB_TYPE_SMALL_PAGE | TTB_PAGE_AP_FULL_ACCESS)
+#define PAGE_EXEC_NEVER   TTB_PAGE_EXEC_NEVER
+#define PAGE_TABLE_COMMON TTB_TYPE_PAGE_TABLE
+#endif
+
+/*------------------------------------------------------------------------------ */
+/*         Local variables                                                       */
+/*------------------------------------------------------------------------------ */
+
+/* Section descriptors for each memory attribute */
+static const uint32_t _sect_attrs[] = {
+	[MMU_ATTR_CACHED] = SECT_COMMON | TTB_SECT_CACHEABLE_WB,
+	[MMU_ATTR_WRITE_COMBINE] = SECT_COMMON | SECT_EXEC_NEVER | TTB_SECT_WRITE_COMBINE,
+	[MMU_ATTR_DEVICE] = SECT_COMMON | SECT_EXEC_NEVER | TTB_SECT_SHAREABLE_DEVICE,
+	[MMU_ATTR_STRONGLY_ORDERED] = SECT_COMMON | SECT_EXEC_NEVER | TTB_SECT_STRONGLY_ORDERED,
+	[MMU_ATTR_NO_ACCESS] = TTB_TYPE_FAULT,
+};
+
+/* Small page descriptors for each memory attribute */
+static const uint32_t _page_attrs[] = {
+	[MMU_ATTR_CACHED] = PAGE_COMMON | TTB_PAGE_CACHEABLE_WB,
+	[MMU_ATTR_WRITE_COMBINE] = PAGE_COMMON | PAGE_EXEC_NEVER | TTB_PAGE_WRITE_COMBINE,
+	[MMU_ATTR_DEVICE] = PAGE_COMMON | PAGE_EXEC_NEVER | TTB_PAGE_SHAREABLE_DEVICE,
+	[MMU_ATTR_STRONGLY_ORDERED] = PAGE_COMMON | PAGE_EXEC_NEVER | TTB_PAGE_STRONGLY_ORDERED,
+	[MMU_ATTR_NO_ACCESS] = TTB_TYPE_FAULT,
+};
+
+/* First-level translation table, as given to mmu_configure() */
+static uint32_t *_tlb;
+
+/* Second-level page tables used to split sections */
+ALIGNED(1024) static uint32_t _page_tables[MMU_PAGE_TABLES][PAGE_TABLE_ENTRIES];
+
+/* Bitmap of the second-level page tables in use */
+static uint32_t _page_tables_used;
+
+/*------------------------------------------------------------------------------ */
+/*         Local functions                                                       */
+/*------------------------------------------------------------------------------ */
+
+static bool _is_cacheable(uint32_t desc, uint32_t tex_shift)
+{
+	if ((desc & TTB_TYPE_MASK) == TTB_TYPE_FAULT)
+		return false;
+#ifdef CONFIG_ARCH_ARMV7A
+	/* TEX[2] set: normal memory with separate inner/outer policies */
+	if (desc & (4 << tex_shift))
+		return true;
+#endif
+	return (desc & TTB_SECT_CACHEABLE) != 0;
+}
+
+static uint32_t _get_domain(uint32_t desc)
+{
+	if ((desc & TTB_TYPE_MASK) == TTB_TYPE_FAULT)
+		return TTB_SECT_DOMAIN(0xf);
+	return desc & TTB_SECT_DOMAIN_MASK;
+}
+
+/* Convert a first-level descriptor to the equivalent small page descriptor */
+static uint32_t _section_to_page(uint32_t sect, uint32_t addr)
+{
+	uint32_t page;
+
+	if ((sect & TTB_TYPE_MASK) != TTB_TYPE_SECT)
+		return TTB_TYPE_FAULT;
+
+	page = TTB_PAGE_ADDR(addr) | TTB_TYPE_SMALL_PAGE;
+	page |= sect & (TTB_SECT_CACHEABLE | TTB_SECT_WRITE_BACK);
+#if defined(CONFIG_ARCH_ARMV5TE)
+	/* same access privilege for the four subpages */
+	page |= (((sect >> 10) & 3) * 0x55) << 4;
+#elif defined(CONFIG_ARCH_ARMV7A)
+	page |= (sect >> 4) & 1;          /* XN */
+	page |= ((sect >> 10) & 3) << 4;  /* AP[1:0] */
+	page |= ((sect >> 12) & 7) << 6;  /* TEX */
+	page |= ((sect >> 15) & 1) << 9;  /* AP[2] */
+	page |= ((sect >> 16) & 3) << 10; /* S, nG */
+#endif
+	return page;
+}
+
+static uint32_t *_page_table_alloc(void)
+{
+	int i;
+
+	for (i = 0; i < MMU_PAGE_TABLES; i++) {
+		if ((_page_tables_used & (1u << i)) == 0) {
+			_page_tables_used |= 1u << i;
+			return _page_tables[i];
+		}
+	}
+	return NULL;
+}
+
+static void _page_table_free(uint32_t desc)
+{
+	uint32_t offset;
+
+	if ((desc & TTB_TYPE_MASK) != TTB_TYPE_PAGE_TABLE)
+		return;
+	offset = TTB_PAGE_TABLE_ADDR(desc) - (uint32_t)_page_tables;
+	if (offset < sizeof(_page_tables))
+		_page_tables_used &= ~(1u << (offset / sizeof(_page_tables[0])));
+}
+
+static int _page_tables_free_count(void)
+{
+	return MMU_PAGE_TABLES - __builtin_popcount(_page_tables_used);
+}
+
+/* Write back and invalidate cached data of a region about to be remapped.
+ * Large regions go through the whole-cache operations of the DMA functions,
+ * which are much cheaper than a walk by line. */
+static bool _flush_region(uint32_t desc, uint32_t tex_shift,
+		uint32_t start, uint32_t length)
+{
+	if (!_is_cacheable(desc, tex_shift))
+		return false;
+	cache_dma_map_for_device((void*)start, length, CACHE_DMA_BIDIRECTIONAL);
+	return true;
+}
+
+static bool _flush_pages(const uint32_t *table, uint32_t first,
+		uint32_t last, uint32_t base)
+{
+	struct _cache_dma_batch batch;
+	uint32_t i, run = 0;
+	bool flushed = false;
+
+	/* Contiguous cacheable pages are flushed together, so that the
+	 * threshold applies to the whole region and not to each page */
+	cache_dma_batch_init(&batch);
+	for (i = first; i <= last + 1; i++) {
+		if (i <= last && _is_cacheable(table[i], 6)) {
+			run++;
+			continue;
+		}
+		if (!run)
+			continue;
+		if (cache_dma_batch_add(&batch, (void*)(base + (i - run) * MMU_PAGE_SIZE),
+				run * MMU_PAGE_SIZE, CACHE_DMA_BIDIRECTIONAL) < 0) {
+			cache_dma_batch_map_for_device(&batch);
+			cache_dma_batch_init(&batch);
+			cache_dma_batch_add(&batch, (void*)(base + (i - run) * MMU_PAGE_SIZE),
+					run * MMU_PAGE_SIZE, CACHE_DMA_BIDIRECTIONAL);
+		}
+		flushed = true;
+		run = 0;
+	}
+	cache_dma_batch_map_for_device(&batch);
+	return flushed;
+}
 
 /*------------------------------------------------------------------------------ */
 /*         Exported functions                                                    */
@@ -50,6 +228,8 @@ void mmu_configure(void *tlb)
 {
 	assert(!mmu_is_enabled());
 
+	_tlb = (uint32_t*)tlb;
+
 	/* Translation Table Base Register 0 */
 	cp15_write_ttbr0((unsigned int)tlb);
 
@@ -87,3 +267,110 @@ void mmu_disable(void)
 		dcache_invalidate();
 	}
 }
+
+int mmu_set_region_attrs(uint32_t start, uint32_t size, enum _mmu_attr attr)
+{
+	uint32_t end, first, last, i, flags;
+	int needed = 0;
+	bool flushed = false;
+
+	if (!_tlb || attr > MMU_ATTR_NO_ACCESS || size == 0)
+		return -EINVAL;
+	if ((start | size) & (MMU_PAGE_SIZE - 1))
+		return -EINVAL;
+	end = start + size - 1;
+	if (end < start)
+		return -EINVAL;
+	first = start / MMU_SECTION_SIZE;
+	last = end / MMU_SECTION_SIZE;
+
+	flags = arch_irq_save();
+
+	/* Reserve second-level tables first so that the update is all or
+	 * nothing */
+	for (i = first; i <= last; i++) {
+		uint32_t base = i * MMU_SECTION_SIZE;
+		bool partial = start > base || end < base + MMU_SECTION_SIZE - 1;
+		if (partial && (_tlb[i] & TTB_TYPE_MASK) != TTB_TYPE_PAGE_TABLE)
+			needed++;
+	}
+	if (needed > _page_tables_free_count()) {
+		arch_irq_restore(flags);
+		return -ENOMEM;
+	}
+
+	for (i = first; i <= last; i++) {
+		uint32_t base = i * MMU_SECTION_SIZE;
+		uint32_t lo = start > base ? start : base;
+		uint32_t hi = end < base + MMU_SECTION_SIZE - 1 ?
+			end : base + MMU_SECTION_SIZE - 1;
+		uint32_t desc = _tlb[i];
+		uint32_t *table;
+		uint32_t page, first_page, last_page;
+
+		if (lo == base && hi == base + MMU_SECTION_SIZE - 1) {
+			/* whole section: use a section descriptor */
+			if ((desc & TTB_TYPE_MASK) == TTB_TYPE_PAGE_TABLE) {
+				table = (uint32_t*)TTB_PAGE_TABLE_ADDR(desc);
+				flushed |= _flush_pages(table, 0,
+						PAGE_TABLE_ENTRIES - 1, base);
+				_page_table_free(desc);
+			} else {
+				flushed |= _flush_region(desc, 12, base,
+						MMU_SECTION_SIZE);
+			}
+			if (attr == MMU_ATTR_NO_ACCESS)
+				_tlb[i] = TTB_TYPE_FAULT;
+			else
+				_tlb[i] = TTB_SECT_ADDR(base) | _get_domain(desc) |
+					_sect_attrs[attr];
+			cache_clean_region(&_tlb[i], sizeof(_tlb[i]));
+			continue;
+		}
+
+		/* part of a section: split it into pages if not done yet */
+		if ((desc & TTB_TYPE_MASK) != TTB_TYPE_PAGE_TABLE) {
+			table = _page_table_alloc();
+			assert(table != NULL);
+			for (page = 0; page < PAGE_TABLE_ENTRIES; page++)
+				table[page] = _section_to_page(desc,
+						base + page * MMU_PAGE_SIZE);
+			cache_clean_region(table, sizeof(_page_tables[0]));
+			_tlb[i] = TTB_PAGE_TABLE_ADDR((uint32_t)table) |
+				_get_domain(desc) | PAGE_TABLE_COMMON;
+			cache_clean_region(&_tlb[i], sizeof(_tlb[i]));
+		} else {
+			table = (uint32_t*)TTB_PAGE_TABLE_ADDR(desc);
+		}
+
+		first_page = (lo - base) / MMU_PAGE_SIZE;
+		last_page = (hi - base) / MMU_PAGE_SIZE;
+		flushed |= _flush_pages(table, first_page, last_page, base);
+		for (page = first_page; page <= last_page; page++) {
+			if (attr == MMU_ATTR_NO_ACCESS)
+				table[page] = TTB_TYPE_FAULT;
+			else
+				table[page] = TTB_PAGE_ADDR(base + page * MMU_PAGE_SIZE) |
+					_page_attrs[attr];
+		}
+		cache_clean_region(&table[first_page],
+				(last_page - first_page + 1) * sizeof(table[0]));
+	}
+
+	/* Discard stale translations */
+	dsb();
+	cp15_tlb_invalidate();
+#ifdef CONFIG_ARCH_ARMV7A
+	cp15_bp_invalidate();
+#endif
+	dsb();
+	isb();
+
+	/* Drop lines speculatively refilled through the old mapping */
+	if (flushed && attr != MMU_ATTR_CACHED && attr != MMU_ATTR_NO_ACCESS)
+		cache_dma_unmap_for_cpu((void*)start, size, CACHE_DMA_FROM_DEVICE);
+
+	arch_irq_restore(flags);
+
+	return 0;
+}
@@ -43,9 +43,18 @@
  *        Exported definitions
  *----------------------------------------------------------------------------*/
 
+/* TTB descriptor type for Fault descriptor (any access aborts) */
+#define TTB_TYPE_FAULT             (0 << 0)
+
+/* TTB descriptor type for Page Table descriptor (coarse, 256 entries) */
+#define TTB_TYPE_PAGE_TABLE        (1 << 0)
+
 /* TTB descriptor type for Section descriptor */
 #define TTB_TYPE_SECT              (2 << 0)
 
+/* TTB descriptor type mask */
+#define TTB_TYPE_MASK              (3 << 0)
+
 /* TTB Section Descriptor: Buffered/Non-Buffered (B) */
 #define TTB_SECT_WRITE_THROUGH     (0 << 2)
 #define TTB_SECT_WRITE_BACK        (1 << 2)
@@ -62,11 +71,46 @@
 /* TTB Section Descriptor: Domain */
 #define TTB_SECT_DOMAIN(x)         (((x) & 15) << 5)
 
+/* TTB Section Descriptor: Domain mask */
+#define TTB_SECT_DOMAIN_MASK       (15 << 5)
+
+/* TTB Page Table Descriptor: Domain */
+#define TTB_PAGE_TABLE_DOMAIN(x)   (((x) & 15) << 5)
+
+/* TTB Page Table Descriptor: Page Table Base Address */
+#define TTB_PAGE_TABLE_ADDR(x)     ((x) & 0xFFFFFC00)
+
+/* Page Table descriptor type for Small Page descriptor (4KB) */
+#define TTB_TYPE_SMALL_PAGE        (2 << 0)
+
+/* TTB Small Page Descriptor: B and C bits, same encoding as sections */
+#define TTB_PAGE_STRONGLY_ORDERED  TTB_SECT_STRONGLY_ORDERED
+#define TTB_PAGE_SHAREABLE_DEVICE  TTB_SECT_SHAREABLE_DEVICE
+#define TTB_PAGE_CACHEABLE_WT      TTB_SECT_CACHEABLE_WT
+#define TTB_PAGE_CACHEABLE_WB      TTB_SECT_CACHEABLE_WB
+
+/* TTB Small Page Descriptor: Small Page Base Address */
+#define TTB_PAGE_ADDR(x)           ((x) & 0xFFFFF000)
+
 #if defined(CONFIG_ARCH_ARMV5TE)
 
 /* TTB Section Descriptor: Should-Be-One (SBO) */
 #define TTB_SECT_SBO               (1 << 4)
 
+/* TTB Page Table Descriptor: Should-Be-One (SBO) */
+#define TTB_PAGE_TABLE_SBO         (1 << 4)
+
+/* TTB Section Descriptor: Non-Cacheable, Bufferable (write-combining) */
+#define TTB_SECT_WRITE_COMBINE     (TTB_SECT_NON_CACHEABLE | TTB_SECT_WRITE_BACK)
+
+/* TTB Small Page Descriptor: Non-Cacheable, Bufferable (write-combining) */
+#define TTB_PAGE_WRITE_COMBINE     TTB_SECT_WRITE_COMBINE
+
+/* TTB Small Page Descriptor: Access Privilege (AP0 to AP3, all subpages) */
+#define TTB_PAGE_AP_PRIV_ONLY      (0x55 << 4)
+#define TTB_PAGE_AP_NO_USER_WRITE  (0xAA << 4)
+#define TTB_PAGE_AP_FULL_ACCESS    (0xFF << 4)
+
 /* TTB Section Descriptor: Access Privilege (AP) */
 #define TTB_SECT_AP_PRIV_ONLY      (1 << 10)
 #define TTB_SECT_AP_NO_USER_WRITE  (2 << 10)
@@ -85,6 +129,29 @@
 #define TTB_SECT_AP_PRIV_READ_ONLY ((1 << 15) | (1 << 10))
 #define TTB_SECT_AP_READ_ONLY      ((1 << 15) | (2 << 10))
 
+/* TTB Section Descriptor: Type Extension (TEX) */
+#define TTB_SECT_TEX(x)            (((x) & 7) << 12)
+
+/* TTB Section Descriptor: Normal memory, Non-Cacheable (write-combining) */
+#define TTB_SECT_WRITE_COMBINE     (TTB_SECT_TEX(1) | TTB_SECT_NON_CACHEABLE | TTB_SECT_WRITE_THROUGH)
+
+/* TTB Small Page Descriptor: Execute/Execute-Never (XN) */
+#define TTB_PAGE_EXEC              (0 << 0)
+#define TTB_PAGE_EXEC_NEVER        (1 << 0)
+
+/* TTB Small Page Descriptor: Access Privilege (AP) */
+#define TTB_PAGE_AP_PRIV_ONLY      ((0 << 9) | (1 << 4))
+#define TTB_PAGE_AP_NO_USER_WRITE  ((0 << 9) | (2 << 4))
+#define TTB_PAGE_AP_FULL_ACCESS    ((0 << 9) | (3 << 4))
+#define TTB_PAGE_AP_PRIV_READ_ONLY ((1 << 9) | (1 << 4))
+#define TTB_PAGE_AP_READ_ONLY      ((1 << 9) | (2 << 4))
+
+/* TTB Small Page Descriptor: Type Extension (TEX) */
+#define TTB_PAGE_TEX(x)            (((x) & 7) << 6)
+
+/* TTB Small Page Descriptor: Normal memory, Non-Cacheable (write-combining) */
+#define TTB_PAGE_WRITE_COMBINE     (TTB_PAGE_TEX(1) | TTB_SECT_NON_CACHEABLE | TTB_SECT_WRITE_THROUGH)
+
 #endif /* CONFIG_ARCH_* */
 
 /* TTB Section Descriptor: Section Base Address */
@@ -0,0 +1,368 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio/audio_convert.h"
+#include "errno.h"
+#include "intmath.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Taps per branch when the rate is increased, scaled up when decimating */
+#define BASE_TAPS 16
+
+/** Below this number of taps per branch the image rejection is too poor */
+#define MIN_TAPS 8
+
+/** Passband edge, relative to the Nyquist frequency of the slower rate */
+#define CUTOFF 0.90f
+
+#define PI 3.14159265358979f
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/* sine approximation, the filter is only computed once at init and the
+ * library does not link against libm */
+static float _sin(float x)
+{
+	float x2, y;
+
+	while (x > PI)
+		x -= 2.0f * PI;
+	while (x < -PI)
+		x += 2.0f * PI;
+	if (x > PI / 2.0f)
+		x = PI - x;
+	else if (x < -PI / 2.0f)
+		x = -PI - x;
+
+	x2 = x * x;
+	y = 1.0f - x2 / 110.0f;
+	y = 1.0f - x2 / 72.0f * y;
+	y = 1.0f - x2 / 42.0f * y;
+	y = 1.0f - x2 / 20.0f * y;
+	y = 1.0f - x2 / 6.0f * y;
+	return x * y;
+}
+
+static float _cos(float x)
+{
+	return _sin(x + PI / 2.0f);
+}
+
+static uint32_t _gcd(uint32_t a, uint32_t b)
+{
+	while (b) {
+		uint32_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+static uint32_t _sample_size(uint16_t bits_per_sample)
+{
+	return bits_per_sample == 16 ? 2 : 4;
+}
+
+/* Blackman windowed sinc, split into 'up' branches of 'taps' coefficients,
+ * each branch normalized to unity gain */
+static void _design_filter(struct _audio_convert *conv)
+{
+	uint32_t up = conv->up;
+	uint32_t taps = conv->taps;
+	uint32_t len = up * taps;
+	float fc = 0.5f * CUTOFF / max_u32(up, conv->down);
+	float center = (len - 1) / 2.0f;
+	uint32_t p, k;
+
+	for (p = 0; p < up; p++) {
+		float branch[AUDIO_CONVERT_MAX_TAPS];
+		float sum = 0.0f;
+
+		for (k = 0; k < taps; k++) {
+			uint32_t n = p + k * up;
+			float t = n - center;
+			float h, w;
+
+			if (t > -0.5f && t < 0.5f)
+				h = 2.0f * fc;
+			else
+				h = _sin(2.0f * PI * fc * t) / (PI * t);
+			w = 0.42f - 0.5f * _cos(2.0f * PI * n / (len - 1))
+			    + 0.08f * _cos(4.0f * PI * n / (len - 1));
+			branch[k] = h * w;
+			sum += branch[k];
+		}
+
+		for (k = 0; k < taps; k++) {
+			float v = branch[k] / sum * 32768.0f;
+			int32_t q = (int32_t)(v >= 0.0f ? v + 0.5f : v - 0.5f);
+			if (q > INT16_MAX)
+				q = INT16_MAX;
+			else if (q < INT16_MIN)
+				q = INT16_MIN;
+			conv->coefs[p * taps + k] = (int16_t)q;
+		}
+	}
+}
+
+static int32_t _read_sample(const uint8_t *p, uint16_t bits_per_sample)
+{
+	switch (bits_per_sample) {
+	case 16:
+		return (int32_t)((uint32_t)(int32_t)*(const int16_t*)p << 16);
+	case 24:
+		return (int32_t)((uint32_t)*(const int32_t*)p << 8);
+	default:
+		return *(const int32_t*)p;
+	}
+}
+
+static void _write_sample(uint8_t *p, uint16_t bits_per_sample, int32_t value)
+{
+	switch (bits_per_sample) {
+	case 16:
+		if (value > INT32_MAX - 0x8000)
+			*(int16_t*)p = INT16_MAX;
+		else
+			*(int16_t*)p = (int16_t)((value + 0x8000) >> 16);
+		break;
+	case 24:
+		if (value > INT32_MAX - 0x80)
+			*(int32_t*)p = 0x7FFFFF;
+		else
+			*(int32_t*)p = (value + 0x80) >> 8;
+		break;
+	default:
+		*(int32_t*)p = value;
+		break;
+	}
+}
+
+static void _mix(const int32_t *src, uint32_t src_channels,
+		int32_t *dst, uint32_t dst_channels)
+{
+	uint32_t i, j;
+
+	if (dst_channels >= src_channels) {
+		/* copy or duplicate */
+		for (j = 0; j < dst_channels; j++)
+			dst[j] = src[j % src_channels];
+	} else {
+		/* average the channels folded onto each output */
+		for (j = 0; j < dst_channels; j++) {
+			int64_t sum = 0;
+			uint32_t count = 0;
+			for (i = j; i < src_channels; i += dst_channels) {
+				sum += src[i];
+				count++;
+			}
+			dst[j] = (int32_t)(sum / (int32_t)count);
+		}
+	}
+}
+
+static int32_t _fir(const int32_t *x, const int16_t *h, uint32_t taps)
+{
+	int64_t acc = 0;
+	uint32_t k;
+
+	for (k = 0; k + 4 <= taps; k += 4) {
+		acc += (int64_t)x[k] * h[k];
+		acc += (int64_t)x[k + 1] * h[k + 1];
+		acc += (int64_t)x[k + 2] * h[k + 2];
+		acc += (int64_t)x[k + 3] * h[k + 3];
+	}
+	for (; k < taps; k++)
+		acc += (int64_t)x[k] * h[k];
+
+	acc >>= 15;
+	if (acc > INT32_MAX)
+		return INT32_MAX;
+	if (acc < INT32_MIN)
+		return INT32_MIN;
+	return (int32_t)acc;
+}
+
+static bool _is_format_valid(const struct _audio_format *format)
+{
+	if (format->sample_rate == 0)
+		return false;
+	if (format->num_channels == 0 ||
+	    format->num_channels > AUDIO_CONVERT_MAX_CHANNELS)
+		return false;
+	return format->bits_per_sample == 16 ||
+	       format->bits_per_sample == 24 ||
+	       format->bits_per_sample == 32;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int audio_convert_init(struct _audio_convert *conv,
+		const struct _audio_format *in, const struct _audio_format *out)
+{
+	uint32_t gcd, taps;
+
+	if (!_is_format_valid(in) || !_is_format_valid(out))
+		return -EINVAL;
+
+	conv->in = *in;
+	conv->out = *out;
+	conv->src_channels = min_u32(in->num_channels, out->num_channels);
+
+	if (in->sample_rate == out->sample_rate) {
+		conv->up = 1;
+		conv->down = 1;
+		conv->taps = 0;
+	} else {
+		gcd = _gcd(in->sample_rate, out->sample_rate);
+		if (out->sample_rate / gcd > UINT16_MAX ||
+		    in->sample_rate / gcd > UINT16_MAX)
+			return -EINVAL;
+		conv->up = out->sample_rate / gcd;
+		conv->down = in->sample_rate / gcd;
+
+		/* widen the branches when decimating, the cutoff is lower */
+		taps = (BASE_TAPS * max_u32(conv->up, conv->down) + conv->up - 1) / conv->up;
+		taps = min_u32(taps, AUDIO_CONVERT_MAX_TAPS);
+		taps = min_u32(taps, AUDIO_CONVERT_MAX_COEFS / conv->up);
+		if (taps < MIN_TAPS)
+			return -EINVAL;
+		conv->taps = taps;
+
+		_design_filter(conv);
+	}
+
+	audio_convert_reset(conv);
+	return 0;
+}
+
+void audio_convert_reset(struct _audio_convert *conv)
+{
+	conv->phase = 0;
+	conv->pos = 0;
+	memset(conv->history, 0, sizeof(conv->history));
+}
+
+uint32_t audio_convert_get_output_size(const struct _audio_convert *conv,
+		uint32_t in_size)
+{
+	uint32_t in_frame = conv->in.num_channels * _sample_size(conv->in.bits_per_sample);
+	uint32_t out_frame = conv->out.num_channels * _sample_size(conv->out.bits_per_sample);
+	uint64_t frames = in_size / in_frame;
+
+	if (conv->taps)
+		frames = (frames * conv->up + conv->down - 1) / conv->down + 1;
+
+	return (uint32_t)(frames * out_frame);
+}
+
+uint32_t audio_convert_process(struct _audio_convert *conv,
+		const void *in, uint32_t in_size, void *out, uint32_t out_size,
+		uint32_t *consumed)
+{
+	const uint8_t *src = (const uint8_t*)in;
+	uint8_t *dst = (uint8_t*)out;
+	uint32_t in_sample = _sample_size(conv->in.bits_per_sample);
+	uint32_t out_sample = _sample_size(conv->out.bits_per_sample);
+	uint32_t in_frame = conv->in.num_channels * in_sample;
+	uint32_t out_frame = conv->out.num_channels * out_sample;
+	uint32_t in_frames = in_size / in_frame;
+	uint32_t out_frames = out_size / out_frame;
+	uint32_t up = conv->up;
+	uint32_t down = conv->down;
+	uint32_t taps = conv->taps;
+	uint32_t i, o, c;
+	int32_t frame[AUDIO_CONVERT_MAX_CHANNELS];
+	int32_t mixed[AUDIO_CONVERT_MAX_CHANNELS];
+
+	for (i = 0, o = 0; i < in_frames; i++) {
+		/* outputs produced by this input frame */
+		uint32_t count = 1;
+		if (taps)
+			count = conv->phase < up ? (up - conv->phase + down - 1) / down : 0;
+		if (o + count > out_frames)
+			break;
+
+		for (c = 0; c < conv->in.num_channels; c++)
+			frame[c] = _read_sample(src + c * in_sample, conv->in.bits_per_sample);
+		src += in_frame;
+
+		if (conv->in.num_channels > conv->out.num_channels) {
+			_mix(frame, conv->in.num_channels, mixed, conv->src_channels);
+			memcpy(frame, mixed, conv->src_channels * sizeof(int32_t));
+		}
+
+		if (taps) {
+			conv->pos = conv->pos ? conv->pos - 1 : taps - 1;
+			for (c = 0; c < conv->src_channels; c++) {
+				conv->history[c][conv->pos] = frame[c];
+				conv->history[c][conv->pos + taps] = frame[c];
+			}
+		}
+
+		while (count--) {
+			if (taps) {
+				const int16_t *h = &conv->coefs[conv->phase * taps];
+				for (c = 0; c < conv->src_channels; c++)
+					mixed[c] = _fir(&conv->history[c][conv->pos], h, taps);
+				conv->phase += down;
+			} else {
+				memcpy(mixed, frame, conv->src_channels * sizeof(int32_t));
+			}
+
+			_mix(mixed, conv->src_channels, frame, conv->out.num_channels);
+			for (c = 0; c < conv->out.num_channels; c++)
+				_write_sample(dst + c * out_sample, conv->out.bits_per_sample, frame[c]);
+			dst += out_frame;
+			o++;
+		}
+
+		if (taps)
+			conv->phase -= up;
+	}
+
+	if (consumed)
+		*consumed = i * in_frame;
+	return o * out_frame;
+}
@@ -0,0 +1,153 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef AUDIO_CONVERT_H
+#define AUDIO_CONVERT_H
+
+/*---------------------------------------------------------------------------
+ *         Includes
+ *---------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*---------------------------------------------------------------------------
+ *         Definitions
+ *---------------------------------------------------------------------------*/
+
+/** Maximum number of channels of a converted stream */
+#ifndef AUDIO_CONVERT_MAX_CHANNELS
+#define AUDIO_CONVERT_MAX_CHANNELS 8
+#endif
+
+/** Size of the polyphase coefficient table (phases * taps per phase) */
+#ifndef AUDIO_CONVERT_MAX_COEFS
+#define AUDIO_CONVERT_MAX_COEFS 7680
+#endif
+
+/** Maximum number of taps per polyphase branch */
+#ifndef AUDIO_CONVERT_MAX_TAPS
+#define AUDIO_CONVERT_MAX_TAPS 48
+#endif
+
+/*---------------------------------------------------------------------------
+ *         Types
+ *---------------------------------------------------------------------------*/
+
+/**
+ * \brief Format of an audio stream. Samples are interleaved, signed and
+ * little-endian. 24-bit samples are stored right-aligned and sign-extended
+ * in 32-bit words, as moved by the SSC and CLASSD DMA.
+ */
+struct _audio_format {
+	/* Sample rate in Hz */
+	uint32_t sample_rate;
+	/* Mono = 1, Stereo = 2, etc. */
+	uint16_t num_channels;
+	/* 16, 24 or 32 */
+	uint16_t bits_per_sample;
+};
+
+/**
+ * \brief Streaming converter between two audio formats: channel up/down-mix,
+ * fixed-point polyphase sample rate conversion and sample format conversion.
+ */
+struct _audio_convert {
+	struct _audio_format in;
+	struct _audio_format out;
+
+	/* Interpolation (L) and decimation (M) factors */
+	uint16_t up;
+	uint16_t down;
+	/* Taps per polyphase branch, 0 if no rate conversion */
+	uint16_t taps;
+	/* Number of channels going through the rate converter */
+	uint16_t src_channels;
+	/* Current phase, in [0, up) while processing */
+	uint32_t phase;
+	/* Position of the newest sample in the history */
+	uint32_t pos;
+
+	/* Q15 coefficients, stored branch by branch */
+	int16_t coefs[AUDIO_CONVERT_MAX_COEFS];
+	/* Q31 input history, duplicated to avoid wrapping in the FIR loop */
+	int32_t history[AUDIO_CONVERT_MAX_CHANNELS][2 * AUDIO_CONVERT_MAX_TAPS];
+};
+
+/*---------------------------------------------------------------------------
+ *         Exported functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a converter and compute its polyphase filter
+ * \param conv  Converter instance
+ * \param in    Format of the input stream
+ * \param out   Format of the output stream
+ * \return 0 on success, -EINVAL if the formats or the rate ratio are not
+ * supported
+ */
+extern int audio_convert_init(struct _audio_convert *conv,
+		const struct _audio_format *in, const struct _audio_format *out);
+
+/**
+ * \brief Clear the filter history, e.g. when the stream restarts
+ * \param conv  Converter instance
+ */
+extern void audio_convert_reset(struct _audio_convert *conv);
+
+/**
+ * \brief Get the largest output produced from a given input
+ * \param conv     Converter instance
+ * \param in_size  Input size in bytes
+ * \return Output size in bytes
+ */
+extern uint32_t audio_convert_get_output_size(const struct _audio_convert *conv,
+		uint32_t in_size);
+
+/**
+ * \brief Convert a block of samples. Conversion stops when the input is
+ * exhausted or when the output buffer is full; the remaining input must be
+ * presented again on the next call.
+ *
+ * \a in and \a out may be the same buffer when the conversion does not
+ * increase the sample rate nor the frame size, so that blocks can be
+ * converted in place between DMA transfers.
+ *
+ * \param conv      Converter instance
+ * \param in        Input samples
+ * \param in_size   Input size in bytes
+ * \param out       Output samples
+ * \param out_size  Output buffer size in bytes
+ * \param consumed  Set to the number of input bytes consumed (optional)
+ * \return Number of output bytes written
+ */
+extern uint32_t audio_convert_process(struct _audio_convert *conv,
+		const void *in, uint32_t in_size, void *out, uint32_t out_size,
+		uint32_t *consumed);
+
+#endif /* AUDIO_CONVERT_H */
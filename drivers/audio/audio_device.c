@@ -39,6 +39,7 @@
 #include "callback.h"
 #include "chip.h"
 #include "dma/dma.h"
+#include "errno.h"
 #include "mm/cache.h"
 #include "trace.h"
 
@@ -137,6 +138,29 @@ static void _configure_pdmic(struct _audio_desc *desc)
 /**
  * Configure audio play/record
  */
+static struct _dma_channel* _audio_dma_channel(struct _audio_desc *desc)
+{
+	switch (desc->type) {
+#if defined(CONFIG_HAVE_CLASSD)
+	case AUDIO_DEVICE_CLASSD:
+		return desc->device.classd.desc.tx.dma.channel;
+#endif
+#if defined(CONFIG_HAVE_SSC)
+	case AUDIO_DEVICE_SSC:
+		if (desc->direction == AUDIO_DEVICE_PLAY)
+			return desc->device.ssc.desc.tx.dma.channel;
+		else
+			return desc->device.ssc.desc.rx.dma.channel;
+#endif
+#if defined(CONFIG_HAVE_PDMIC)
+	case AUDIO_DEVICE_PDMIC:
+		return desc->device.pdmic.desc.rx.dma.channel;
+#endif
+	default:
+		return NULL;
+	}
+}
+
 void audio_configure(struct _audio_desc *desc)
 {
 	switch (desc->type) {
@@ -458,6 +482,86 @@ void audio_transfer(struct _audio_desc *desc, void *buffer, uint32_t size, struc
 	}
 }
 
+int audio_transfer_cyclic(struct _audio_desc *desc, void *buffer, uint32_t size,
+			  uint8_t periods, struct _callback* cb)
+{
+	switch (desc->type) {
+#if defined(CONFIG_HAVE_CLASSD)
+	case AUDIO_DEVICE_CLASSD:
+		if (desc->direction == AUDIO_DEVICE_PLAY) {
+			struct _buffer _tx = {
+				.data = (uint8_t*)buffer,
+				.size = size,
+				.attr = CLASSD_BUF_ATTR_WRITE,
+			};
+
+			return classd_transfer_cyclic(&desc->device.classd.desc, &_tx, periods, cb);
+		}
+		break;
+#endif
+#if defined(CONFIG_HAVE_SSC)
+	case AUDIO_DEVICE_SSC:
+		{
+			struct _buffer buf = {
+				.data = (uint8_t*)buffer,
+				.size = size,
+				.attr = desc->direction == AUDIO_DEVICE_PLAY ?
+					SSC_BUF_ATTR_WRITE : SSC_BUF_ATTR_READ,
+			};
+
+			return ssc_transfer_cyclic(&desc->device.ssc.desc, &buf, periods, cb);
+		}
+#endif
+#if defined(CONFIG_HAVE_PDMIC)
+	case AUDIO_DEVICE_PDMIC:
+		if (desc->direction == AUDIO_DEVICE_RECORD) {
+			struct _buffer rx = {
+				.data = (uint8_t*)buffer,
+				.size = size,
+				.attr = PDMIC_BUF_ATTR_READ,
+			};
+
+			return pdmic_transfer_cyclic(&desc->device.pdmic.desc, &rx, periods, cb);
+		}
+		break;
+#endif
+	default:
+		break;
+	}
+
+	/* No audio device or direction not supported */
+	return -ENOTSUP;
+}
+
+uint32_t audio_get_position(struct _audio_desc *desc)
+{
+	struct _dma_channel* channel = _audio_dma_channel(desc);
+
+	return channel ? dma_get_cyclic_position(channel) : 0;
+}
+
+void* audio_get_period(struct _audio_desc *desc)
+{
+	struct _dma_channel* channel = _audio_dma_channel(desc);
+
+	return channel ? dma_get_cyclic_period(channel) : NULL;
+}
+
+void audio_ack_periods(struct _audio_desc *desc, uint32_t count)
+{
+	struct _dma_channel* channel = _audio_dma_channel(desc);
+
+	if (channel)
+		dma_ack_cyclic_periods(channel, count);
+}
+
+uint32_t audio_get_xruns(struct _audio_desc *desc)
+{
+	struct _dma_channel* channel = _audio_dma_channel(desc);
+
+	return channel ? channel->cyclic.xruns : 0;
+}
+
 bool audio_transfer_is_done(struct _audio_desc *desc)
 {
 	switch (desc->type) {
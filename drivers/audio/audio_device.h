@@ -191,6 +191,49 @@ extern void audio_stop(struct _audio_desc *desc);
  */
 extern void audio_transfer(struct _audio_desc *desc, void *buffer, uint32_t size, struct _callback* cb);
 
+/**
+ * \brief Configure and start a cyclic audio transfer over a ring buffer
+ * The transfer runs until audio_stop() is called, \a cb is invoked from
+ * interrupt context each time periods complete.
+ * \param desc     Audio descriptor
+ * \param buffer   Ring buffer, cache aligned
+ * \param size     Ring buffer size, multiple of \a periods samples
+ * \param periods  Number of periods in the ring
+ * \param cb       Period elapsed callback
+ * \return 0 on success, negative error code otherwise
+ */
+extern int audio_transfer_cyclic(struct _audio_desc *desc, void *buffer, uint32_t size,
+				 uint8_t periods, struct _callback* cb);
+
+/**
+ * \brief Get the hardware position of a cyclic transfer
+ * \param desc     Audio descriptor
+ * \return Offset in bytes from the start of the ring
+ */
+extern uint32_t audio_get_position(struct _audio_desc *desc);
+
+/**
+ * \brief Get the oldest period of a cyclic transfer to process
+ * Recorded data for capture, the period to refill for playback.
+ * \param desc     Audio descriptor
+ * \return Period address or NULL if none is pending
+ */
+extern void* audio_get_period(struct _audio_desc *desc);
+
+/**
+ * \brief Release processed periods of a cyclic transfer
+ * \param desc     Audio descriptor
+ * \param count    Number of periods
+ */
+extern void audio_ack_periods(struct _audio_desc *desc, uint32_t count);
+
+/**
+ * \brief Get the number of periods lost (capture) or replayed (playback)
+ * because the application did not keep up with a cyclic transfer
+ * \param desc     Audio descriptor
+ */
+extern uint32_t audio_get_xruns(struct _audio_desc *desc);
+
 /**
  * \brief Check the audio transfer status
  * \param desc     Audio descriptor
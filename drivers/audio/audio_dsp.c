@@ -0,0 +1,252 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio/audio_dsp.h"
+#include "errno.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Fractional bits of the DC-blocking filter state */
+#define DC_STATE_SHIFT 8
+
+/** AGC envelope decay, as a right shift per sample */
+#define AGC_DECAY_SHIFT 10
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static int32_t _beamform(struct _audio_dsp *dsp, const uint8_t *frame)
+{
+	uint32_t channels = dsp->cfg.num_channels;
+	uint32_t pos = dsp->beam.pos;
+	int32_t sum = 0;
+	uint32_t c;
+
+	for (c = 0; c < channels; c++) {
+		int16_t sample;
+
+		if (dsp->cfg.bits_per_sample == 16)
+			sample = ((const int16_t*)frame)[c];
+		else
+			sample = (int16_t)(((const int32_t*)frame)[c] >> 16);
+
+		if (channels == 1)
+			return sample;
+
+		dsp->beam.line[c][pos] = sample;
+		sum += dsp->beam.line[c][(pos + AUDIO_DSP_MAX_DELAY - dsp->cfg.delays[c]) % AUDIO_DSP_MAX_DELAY];
+	}
+	dsp->beam.pos = (pos + 1) % AUDIO_DSP_MAX_DELAY;
+
+	return sum / (int32_t)channels;
+}
+
+static int32_t _dc_block(struct _audio_dsp *dsp, int32_t x)
+{
+	/* the output state keeps DC_STATE_SHIFT fractional bits, otherwise the
+	 * truncation of the feedback term leaves a DC offset of its own; the
+	 * difference is scaled by a multiplication as it may be negative */
+	int32_t y = (x - dsp->dc.x1) * (1 << DC_STATE_SHIFT)
+	          + (int32_t)(((int64_t)dsp->cfg.dc_pole * dsp->dc.y1) >> 15);
+
+	dsp->dc.x1 = x;
+	dsp->dc.y1 = y;
+	return y >> DC_STATE_SHIFT;
+}
+
+static int32_t _fir(struct _audio_dsp *dsp, int32_t x)
+{
+	uint32_t taps = dsp->cfg.fir_taps;
+	const int16_t *h = dsp->cfg.fir;
+	const int32_t *v;
+	int64_t acc = 0;
+	uint32_t k;
+
+	/* newest sample first, duplicated to avoid wrapping */
+	dsp->fir.pos = dsp->fir.pos ? dsp->fir.pos - 1 : taps - 1;
+	dsp->fir.history[dsp->fir.pos] = x;
+	dsp->fir.history[dsp->fir.pos + taps] = x;
+	v = &dsp->fir.history[dsp->fir.pos];
+
+	for (k = 0; k + 4 <= taps; k += 4) {
+		acc += (int64_t)v[k] * h[k];
+		acc += (int64_t)v[k + 1] * h[k + 1];
+		acc += (int64_t)v[k + 2] * h[k + 2];
+		acc += (int64_t)v[k + 3] * h[k + 3];
+	}
+	for (; k < taps; k++)
+		acc += (int64_t)v[k] * h[k];
+
+	return (int32_t)(acc >> 15);
+}
+
+static int32_t _biquads(struct _audio_dsp *dsp, int32_t x)
+{
+	uint32_t i;
+
+	for (i = 0; i < dsp->cfg.num_biquads; i++) {
+		const struct _audio_biquad *q = &dsp->cfg.biquads[i];
+		int64_t acc;
+		int32_t y;
+
+		acc = (int64_t)q->b0 * x
+		    + (int64_t)q->b1 * dsp->biquad[i].x1
+		    + (int64_t)q->b2 * dsp->biquad[i].x2
+		    - (int64_t)q->a1 * dsp->biquad[i].y1
+		    - (int64_t)q->a2 * dsp->biquad[i].y2;
+		y = (int32_t)(acc >> AUDIO_DSP_BIQUAD_SHIFT);
+
+		dsp->biquad[i].x2 = dsp->biquad[i].x1;
+		dsp->biquad[i].x1 = x;
+		dsp->biquad[i].y2 = dsp->biquad[i].y1;
+		dsp->biquad[i].y1 = y;
+		x = y;
+	}
+
+	return x;
+}
+
+static int32_t _agc(struct _audio_dsp *dsp, int32_t x)
+{
+	uint32_t level = x < 0 ? -x : x;
+	uint32_t desired;
+	int32_t delta;
+
+	if (level > dsp->agc.envelope)
+		dsp->agc.envelope = level;
+	else
+		dsp->agc.envelope -= dsp->agc.envelope >> AGC_DECAY_SHIFT;
+
+	if (dsp->agc.envelope)
+		desired = ((uint32_t)dsp->cfg.agc_target << 16) / dsp->agc.envelope;
+	else
+		desired = dsp->cfg.agc_max_gain;
+	if (desired > dsp->cfg.agc_max_gain)
+		desired = dsp->cfg.agc_max_gain;
+	else if (desired < dsp->cfg.agc_min_gain)
+		desired = dsp->cfg.agc_min_gain;
+
+	delta = (int32_t)(desired - dsp->agc.gain);
+	if (delta < 0)
+		dsp->agc.gain += delta >> dsp->cfg.agc_attack_shift;
+	else
+		dsp->agc.gain += delta >> dsp->cfg.agc_release_shift;
+
+	return (int32_t)(((int64_t)x * dsp->agc.gain) >> 16);
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int audio_dsp_init(struct _audio_dsp *dsp, const struct _audio_dsp_config *cfg)
+{
+	uint32_t c;
+
+	if (cfg->num_channels == 0 || cfg->num_channels > AUDIO_DSP_MAX_CHANNELS)
+		return -EINVAL;
+	if (cfg->bits_per_sample != 16 && cfg->bits_per_sample != 32)
+		return -EINVAL;
+	for (c = 0; c < cfg->num_channels; c++)
+		if (cfg->delays[c] >= AUDIO_DSP_MAX_DELAY)
+			return -EINVAL;
+	if (cfg->fir && (cfg->fir_taps == 0 || cfg->fir_taps > AUDIO_DSP_MAX_FIR_TAPS))
+		return -EINVAL;
+	if (cfg->biquads && (cfg->num_biquads == 0 || cfg->num_biquads > AUDIO_DSP_MAX_BIQUADS))
+		return -EINVAL;
+	if (cfg->agc_target && (cfg->agc_min_gain > cfg->agc_max_gain ||
+				cfg->agc_attack_shift > 31 || cfg->agc_release_shift > 31))
+		return -EINVAL;
+
+	dsp->cfg = *cfg;
+	if (!cfg->fir)
+		dsp->cfg.fir_taps = 0;
+	if (!cfg->biquads)
+		dsp->cfg.num_biquads = 0;
+
+	audio_dsp_reset(dsp);
+	return 0;
+}
+
+void audio_dsp_reset(struct _audio_dsp *dsp)
+{
+	memset(&dsp->beam, 0, sizeof(dsp->beam));
+	memset(&dsp->dc, 0, sizeof(dsp->dc));
+	memset(&dsp->fir, 0, sizeof(dsp->fir));
+	memset(&dsp->biquad, 0, sizeof(dsp->biquad));
+	dsp->agc.envelope = 0;
+	dsp->agc.gain = AUDIO_DSP_AGC_UNITY;
+	dsp->clipped = 0;
+}
+
+uint32_t audio_dsp_process(struct _audio_dsp *dsp,
+		const void *in, uint32_t in_size, int16_t *out)
+{
+	const uint8_t *src = (const uint8_t*)in;
+	uint32_t frame_size = dsp->cfg.num_channels * (dsp->cfg.bits_per_sample / 8);
+	uint32_t count = in_size / frame_size;
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		int32_t x = _beamform(dsp, src);
+		src += frame_size;
+
+		if (dsp->cfg.dc_pole)
+			x = _dc_block(dsp, x);
+		if (dsp->cfg.fir_taps)
+			x = _fir(dsp, x);
+		if (dsp->cfg.num_biquads)
+			x = _biquads(dsp, x);
+		if (dsp->cfg.agc_target)
+			x = _agc(dsp, x);
+
+		if (x > INT16_MAX) {
+			x = INT16_MAX;
+			dsp->clipped++;
+		} else if (x < INT16_MIN) {
+			x = INT16_MIN;
+			dsp->clipped++;
+		}
+		/* output never overtakes input: in place is safe */
+		out[i] = (int16_t)x;
+	}
+
+	return count;
+}
@@ -0,0 +1,185 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef AUDIO_DSP_H
+#define AUDIO_DSP_H
+
+/*---------------------------------------------------------------------------
+ *         Includes
+ *---------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*---------------------------------------------------------------------------
+ *         Definitions
+ *---------------------------------------------------------------------------*/
+
+/** Maximum number of microphones combined by the beamformer */
+#ifndef AUDIO_DSP_MAX_CHANNELS
+#define AUDIO_DSP_MAX_CHANNELS 4
+#endif
+
+/** Maximum beamformer steering delay, in samples */
+#ifndef AUDIO_DSP_MAX_DELAY
+#define AUDIO_DSP_MAX_DELAY 32
+#endif
+
+/** Maximum number of FIR taps */
+#ifndef AUDIO_DSP_MAX_FIR_TAPS
+#define AUDIO_DSP_MAX_FIR_TAPS 64
+#endif
+
+/** Maximum number of cascaded biquads */
+#ifndef AUDIO_DSP_MAX_BIQUADS
+#define AUDIO_DSP_MAX_BIQUADS 8
+#endif
+
+/** Fractional bits of the biquad coefficients (Q2.14) */
+#define AUDIO_DSP_BIQUAD_SHIFT 14
+
+/** Unity AGC gain (Q16.16) */
+#define AUDIO_DSP_AGC_UNITY (1 << 16)
+
+/*---------------------------------------------------------------------------
+ *         Types
+ *---------------------------------------------------------------------------*/
+
+/**
+ * \brief Biquad section, Q2.14 coefficients normalized so that a0 = 1:
+ * y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+ */
+struct _audio_biquad {
+	int16_t b0;
+	int16_t b1;
+	int16_t b2;
+	int16_t a1;
+	int16_t a2;
+};
+
+/**
+ * \brief Capture chain configuration. Stages run in this order, disabled
+ * stages are skipped: delay-and-sum beamformer (num_channels > 1),
+ * DC-blocking high-pass, FIR, biquad cascade and AGC.
+ */
+struct _audio_dsp_config {
+	/* Interleaved microphone channels in the input buffers */
+	uint8_t num_channels;
+	/* Input sample size: 16 or 32 (16-bit data left-aligned) */
+	uint8_t bits_per_sample;
+	/* Beamformer steering delay of each channel, in samples */
+	uint8_t delays[AUDIO_DSP_MAX_CHANNELS];
+
+	/* DC-blocking high-pass pole (Q15, e.g. 32604 for 0.995), 0 to disable */
+	int16_t dc_pole;
+
+	/* FIR coefficients (Q15), NULL to disable */
+	const int16_t *fir;
+	uint8_t fir_taps;
+
+	/* Biquad cascade, NULL to disable */
+	const struct _audio_biquad *biquads;
+	uint8_t num_biquads;
+
+	/* AGC target peak level (0 to disable) and gain limits (Q16.16) */
+	uint16_t agc_target;
+	uint32_t agc_min_gain;
+	uint32_t agc_max_gain;
+	/* AGC gain slew: right shifts applied per sample when the gain
+	 * decreases (attack) or increases (release) */
+	uint8_t agc_attack_shift;
+	uint8_t agc_release_shift;
+};
+
+/**
+ * \brief Capture chain instance
+ */
+struct _audio_dsp {
+	struct _audio_dsp_config cfg;
+
+	struct {
+		int16_t line[AUDIO_DSP_MAX_CHANNELS][AUDIO_DSP_MAX_DELAY];
+		uint8_t pos;
+	} beam;
+	struct {
+		int32_t x1;
+		int32_t y1;
+	} dc;
+	struct {
+		int32_t history[2 * AUDIO_DSP_MAX_FIR_TAPS];
+		uint8_t pos;
+	} fir;
+	struct {
+		int32_t x1, x2;
+		int32_t y1, y2;
+	} biquad[AUDIO_DSP_MAX_BIQUADS];
+	struct {
+		uint32_t envelope;
+		uint32_t gain;
+	} agc;
+
+	/* Number of output samples saturated since the last reset */
+	uint32_t clipped;
+};
+
+/*---------------------------------------------------------------------------
+ *         Exported functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a capture chain
+ * \param dsp  Chain instance
+ * \param cfg  Chain configuration, copied (FIR and biquad coefficients are
+ * referenced and must stay valid)
+ * \return 0 on success, -EINVAL if the configuration is not supported
+ */
+extern int audio_dsp_init(struct _audio_dsp *dsp,
+		const struct _audio_dsp_config *cfg);
+
+/**
+ * \brief Clear the filter states and restart the AGC at unity gain
+ * \param dsp  Chain instance
+ */
+extern void audio_dsp_reset(struct _audio_dsp *dsp);
+
+/**
+ * \brief Process one block of interleaved captured samples into mono 16-bit
+ * samples. The chain adds no latency beyond the beamformer delays, so a DMA
+ * ping-pong half can be processed while the other one is filled. \a out may
+ * be the same buffer as \a in.
+ * \param dsp      Chain instance
+ * \param in       Captured samples
+ * \param in_size  Size of the captured block in bytes
+ * \param out      Processed samples, (in_size / frame size) samples
+ * \return Number of output samples
+ */
+extern uint32_t audio_dsp_process(struct _audio_dsp *dsp,
+		const void *in, uint32_t in_size, int16_t *out);
+
+#endif /* AUDIO_DSP_H */
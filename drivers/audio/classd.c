@@ -230,6 +230,29 @@ static void _classd_dma_transfer(struct _classd_desc* desc, struct _buffer* buff
 	dma_start_transfer(desc->tx.dma.channel);
 }
 
+static int _classd_dma_cyclic_transfer(struct _classd_desc* desc, struct _buffer* buffer, uint8_t periods)
+{
+	int err;
+
+	memset(&desc->tx.dma.cfg, 0x0, sizeof(desc->tx.dma.cfg));
+
+	desc->tx.dma.cfg.saddr = buffer->data;
+	desc->tx.dma.cfg.daddr = (void*)&desc->addr->CLASSD_THR;
+
+	if (desc->left_enable && desc->right_enable) {
+		desc->tx.dma.cfg_dma.data_width = DMA_DATA_WIDTH_WORD;
+		desc->tx.dma.cfg.len = buffer->size / 4;
+	} else {
+		desc->tx.dma.cfg_dma.data_width = DMA_DATA_WIDTH_HALF_WORD;
+		desc->tx.dma.cfg.len = buffer->size / 2;
+	}
+	err = dma_configure_cyclic_transfer(desc->tx.dma.channel, &desc->tx.dma.cfg_dma, &desc->tx.dma.cfg, periods);
+	if (err < 0)
+		return err;
+	dma_set_callback(desc->tx.dma.channel, &desc->tx.callback);
+	return dma_start_transfer(desc->tx.dma.channel);
+}
+
 static void _classd_polling_transfer(struct _classd_desc* desc, struct _buffer* buffer)
 {
 	uint16_t* start = (uint16_t*)buffer->data;
@@ -490,6 +513,34 @@ int classd_transfer(struct _classd_desc* desc, struct _buffer* buf, struct _call
 	return 0;
 }
 
+int classd_transfer_cyclic(struct _classd_desc* desc, struct _buffer* buf, uint8_t periods, struct _callback* cb)
+{
+	int err;
+
+	if ((buf == NULL) || (buf->size == 0))
+		return -EINVAL;
+
+	if (!(buf->attr & CLASSD_BUF_ATTR_WRITE))
+		return -EINVAL;
+
+	if (desc->transfer_mode != CLASSD_MODE_DMA)
+		return -ENOTSUP;
+
+	mutex_lock(&desc->tx.mutex);
+
+	desc->tx.transferred = 0;
+	desc->tx.buffer.data = buf->data;
+	desc->tx.buffer.size = buf->size;
+	desc->tx.buffer.attr = buf->attr;
+
+	callback_copy(&desc->tx.callback, cb);
+
+	err = _classd_dma_cyclic_transfer(desc, buf, periods);
+	if (err < 0)
+		mutex_unlock(&desc->tx.mutex);
+	return err;
+}
+
 bool classd_tx_transfer_is_done(struct _classd_desc* desc)
 {
 	return (!mutex_is_locked(&desc->tx.mutex));
@@ -154,6 +154,15 @@ extern void classd_volume_unmute(struct _classd_desc *desc, bool left, bool righ
 
 extern int classd_transfer(struct _classd_desc* desc, struct _buffer* buf, struct _callback* cb);
 
+/**
+ * \brief Start a cyclic DMA transfer over a ring buffer.
+ * The ring is split in \a periods periods and \a cb is invoked from
+ * interrupt context when periods complete, until classd_tx_stop() is called.
+ * Only available in DMA mode.
+ * \return 0 on success, negative error code otherwise
+ */
+extern int classd_transfer_cyclic(struct _classd_desc* desc, struct _buffer* buf, uint8_t periods, struct _callback* cb);
+
 extern bool classd_tx_transfer_is_done(struct _classd_desc* desc);
 
 extern void classd_tx_stop(struct _classd_desc* desc);
@@ -83,6 +83,29 @@ static void _pdmic_dma_transfer(struct _pdmic_desc* desc, struct _buffer* buffer
 	dma_start_transfer(desc->rx.dma.channel);
 }
 
+static int _pdmic_dma_cyclic_transfer(struct _pdmic_desc* desc, struct _buffer* buffer, uint8_t periods)
+{
+	int err;
+
+	memset(&desc->rx.dma.cfg, 0, sizeof(desc->rx.dma.cfg));
+
+	desc->rx.dma.cfg.saddr = (void*)&desc->addr->PDMIC_CDR;
+	desc->rx.dma.cfg.daddr = buffer->data;
+
+	if (desc->dsp_size == PDMIC_CONVERTED_DATA_SIZE_32) {
+		desc->rx.dma.cfg.len = buffer->size / 4;
+		desc->rx.dma.cfg_dma.data_width = DMA_DATA_WIDTH_WORD;
+	} else {
+		desc->rx.dma.cfg.len = buffer->size / 2;
+		desc->rx.dma.cfg_dma.data_width = DMA_DATA_WIDTH_HALF_WORD;
+	}
+	err = dma_configure_cyclic_transfer(desc->rx.dma.channel, &desc->rx.dma.cfg_dma, &desc->rx.dma.cfg, periods);
+	if (err < 0)
+		return err;
+	dma_set_callback(desc->rx.dma.channel, &desc->rx.callback);
+	return dma_start_transfer(desc->rx.dma.channel);
+}
+
 static void _pdmic_polling_transfer(struct _pdmic_desc* desc, struct _buffer* buffer)
 {
 	uint16_t* data = (uint16_t*)buffer->data;
@@ -339,6 +362,34 @@ int pdmic_transfer(struct _pdmic_desc* desc, struct _buffer* buf, struct _callba
 	return 0;
 }
 
+int pdmic_transfer_cyclic(struct _pdmic_desc* desc, struct _buffer* buf, uint8_t periods, struct _callback* cb)
+{
+	int err;
+
+	if ((buf == NULL) || (buf->size == 0))
+		return -EINVAL;
+
+	if (!(buf->attr & PDMIC_BUF_ATTR_READ))
+		return -EINVAL;
+
+	if (desc->transfer_mode != PDMIC_MODE_DMA)
+		return -ENOTSUP;
+
+	mutex_lock(&desc->rx.mutex);
+
+	callback_copy(&desc->rx.callback, cb);
+
+	desc->rx.transferred = 0;
+	desc->rx.buffer.data = buf->data;
+	desc->rx.buffer.size = buf->size;
+	desc->rx.buffer.attr = buf->attr;
+
+	err = _pdmic_dma_cyclic_transfer(desc, buf, periods);
+	if (err < 0)
+		mutex_unlock(&desc->rx.mutex);
+	return err;
+}
+
 bool pdmic_rx_transfer_is_done(struct _pdmic_desc* desc)
 {
 	return (!mutex_is_locked(&desc->rx.mutex));
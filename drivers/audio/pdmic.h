@@ -130,6 +130,15 @@ extern bool pdmic_data_ready(struct _pdmic_desc* desc);
 
 extern int pdmic_transfer(struct _pdmic_desc* desc, struct _buffer* buf, struct _callback* cb);
 
+/**
+ * \brief Start a cyclic DMA capture into a ring buffer.
+ * The ring is split in \a periods periods and \a cb is invoked from
+ * interrupt context when periods are filled, until pdmic_rx_stop() is
+ * called. Only available in DMA mode.
+ * \return 0 on success, negative error code otherwise
+ */
+extern int pdmic_transfer_cyclic(struct _pdmic_desc* desc, struct _buffer* buf, uint8_t periods, struct _callback* cb);
+
 extern void pdmic_rx_stop(struct _pdmic_desc* desc);
 
 extern bool pdmic_rx_transfer_is_done(struct _pdmic_desc* desc);
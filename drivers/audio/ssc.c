@@ -160,6 +160,42 @@ static void _ssc_dma_tx_transfer(struct _ssc_desc* desc, struct _buffer* buffer)
 	dma_start_transfer(desc->tx.dma.channel);
 }
 
+static int _ssc_dma_cyclic_transfer(struct _ssc_desc* desc, struct _buffer* buffer, uint8_t periods)
+{
+	bool rx = (buffer->attr & SSC_BUF_ATTR_READ) != 0;
+	struct _dma_channel* channel = rx ? desc->rx.dma.channel : desc->tx.dma.channel;
+	struct _dma_cfg* cfg_dma = rx ? &desc->rx.dma.cfg_dma : &desc->tx.dma.cfg_dma;
+	struct _dma_transfer_cfg* cfg = rx ? &desc->rx.dma.cfg : &desc->tx.dma.cfg;
+	int err;
+
+	memset(cfg, 0x0, sizeof(*cfg));
+
+	if (rx) {
+		cfg->saddr = (void*)&desc->addr->SSC_RHR;
+		cfg->daddr = buffer->data;
+	} else {
+		cfg->saddr = buffer->data;
+		cfg->daddr = (void*)&desc->addr->SSC_THR;
+	}
+
+	if (desc->slot_length == 8) {
+		cfg_dma->data_width = DMA_DATA_WIDTH_BYTE;
+		cfg->len = buffer->size;
+	} else if (desc->slot_length == 16) {
+		cfg_dma->data_width = DMA_DATA_WIDTH_HALF_WORD;
+		cfg->len = buffer->size / 2;
+	} else {
+		cfg_dma->data_width = DMA_DATA_WIDTH_WORD;
+		cfg->len = buffer->size / 4;
+	}
+
+	err = dma_configure_cyclic_transfer(channel, cfg_dma, cfg, periods);
+	if (err < 0)
+		return err;
+	dma_set_callback(channel, rx ? &desc->rx.callback : &desc->tx.callback);
+	return dma_start_transfer(channel);
+}
+
 /*----------------------------------------------------------------------------
  *       Exported functions
  *----------------------------------------------------------------------------*/
@@ -334,6 +370,44 @@ int ssc_transfer(struct _ssc_desc* desc, struct _buffer* buf, struct _callback*
 	return 0;
 }
 
+int ssc_transfer_cyclic(struct _ssc_desc* desc, struct _buffer* buf, uint8_t periods, struct _callback* cb)
+{
+	int err;
+
+	if ((buf == NULL) || (buf->size == 0))
+		return -EINVAL;
+
+	if (buf->attr & SSC_BUF_ATTR_READ) {
+		mutex_lock(&desc->rx.mutex);
+
+		callback_copy(&desc->rx.callback, cb);
+
+		desc->rx.transferred = 0;
+		desc->rx.buffer.data = buf->data;
+		desc->rx.buffer.size = buf->size;
+		desc->rx.buffer.attr = buf->attr;
+		err = _ssc_dma_cyclic_transfer(desc, buf, periods);
+		if (err < 0)
+			mutex_unlock(&desc->rx.mutex);
+	} else if (buf->attr & SSC_BUF_ATTR_WRITE) {
+		mutex_lock(&desc->tx.mutex);
+
+		callback_copy(&desc->tx.callback, cb);
+
+		desc->tx.transferred = 0;
+		desc->tx.buffer.data = buf->data;
+		desc->tx.buffer.size = buf->size;
+		desc->tx.buffer.attr = buf->attr;
+		err = _ssc_dma_cyclic_transfer(desc, buf, periods);
+		if (err < 0)
+			mutex_unlock(&desc->tx.mutex);
+	} else {
+		err = -EINVAL;
+	}
+
+	return err;
+}
+
 bool ssc_tx_transfer_is_done(struct _ssc_desc* desc)
 {
 	return (!mutex_is_locked(&desc->tx.mutex));
@@ -183,6 +183,20 @@ extern bool ssc_is_rx_ready(struct _ssc_desc* desc);
 
 extern int ssc_transfer(struct _ssc_desc* desc, struct _buffer* buf, struct _callback* cb);
 
+/**
+ * \brief Start a cyclic DMA transfer over a ring buffer.
+ * The ring is split in \a periods periods and \a cb is invoked from
+ * interrupt context when periods complete, until ssc_tx_stop() or
+ * ssc_rx_stop() is called. Use the dma_*_cyclic_* functions on the channel
+ * to get the position and the pending periods.
+ * \param desc     Pointer to an SSC instance.
+ * \param buf      Ring buffer, cache aligned, direction given by attr
+ * \param periods  Number of periods in the ring
+ * \param cb       Period elapsed callback
+ * \return 0 on success, negative error code otherwise
+ */
+extern int ssc_transfer_cyclic(struct _ssc_desc* desc, struct _buffer* buf, uint8_t periods, struct _callback* cb);
+
 extern bool ssc_tx_transfer_is_done(struct _ssc_desc* desc);
 
 extern void ssc_tx_stop(struct _ssc_desc* desc);
@@ -0,0 +1,241 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \addtogroup trngd_module Buffered TRNG driver
+ * \ingroup peripherals_module
+ * The TRNGD driver collects TRNG output from the interrupt handler into an
+ * entropy pool, so that consumers never have to wait for the peripheral
+ * when enough samples have been accumulated.
+ *
+ * Every sample is checked by continuous health tests before being added to
+ * the pool. The pool is meant to seed a deterministic random bit generator
+ * (see random.h) rather than to be used directly for bulk random data:
+ *
+ * \code
+ * trngd_init();
+ * random_init(trngd_get_entropy, NULL);
+ * random_fill(nonce, sizeof(nonce));
+ * \endcode
+ *
+ * Related files :\n
+ * \ref trngd.c\n
+ * \ref trngd.h\n
+ */
+/*@{*/
+/*@}*/
+
+/**
+ * \file
+ *
+ * Implementation of the buffered TRNG driver
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+
+#include "barriers.h"
+#include "compiler.h"
+#include "crypto/trng.h"
+#include "crypto/trngd.h"
+#include "errno.h"
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#if !IS_POWER_OF_TWO(TRNGD_POOL_SIZE)
+#error TRNGD_POOL_SIZE must be a power of two
+#endif
+
+#define TRNGD_POOL_MASK (TRNGD_POOL_SIZE - 1)
+
+/*----------------------------------------------------------------------------
+ *        Local Data
+ *----------------------------------------------------------------------------*/
+
+static struct {
+	bool initialized;
+	volatile bool paused;
+	volatile bool failed;
+
+	/* pool indexes are free-running, the producer (interrupt) only writes
+	 * head and the consumer only writes tail */
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	uint32_t pool[TRNGD_POOL_SIZE];
+
+	/* health tests state */
+	uint32_t rct_last;
+	uint32_t rct_count;
+	uint32_t apt_first;
+	uint32_t apt_count;
+	uint32_t apt_samples;
+
+	struct _trngd_stats stats;
+} _trngd;
+
+/*------------------------------------------------------------------------------
+ *         Local functions
+ *------------------------------------------------------------------------------*/
+
+static bool _trngd_health_test(uint32_t sample)
+{
+	/* Repetition Count Test */
+	if (_trngd.stats.produced > 1 && sample == _trngd.rct_last) {
+		if (++_trngd.rct_count >= TRNGD_RCT_CUTOFF) {
+			_trngd.stats.rct_failures++;
+			return false;
+		}
+	} else {
+		_trngd.rct_last = sample;
+		_trngd.rct_count = 1;
+	}
+
+	/* Adaptive Proportion Test */
+	if (_trngd.apt_samples == 0) {
+		_trngd.apt_first = sample;
+		_trngd.apt_count = 1;
+	} else if (sample == _trngd.apt_first) {
+		if (++_trngd.apt_count >= TRNGD_APT_CUTOFF) {
+			_trngd.stats.apt_failures++;
+			return false;
+		}
+	}
+	if (++_trngd.apt_samples >= TRNGD_APT_WINDOW)
+		_trngd.apt_samples = 0;
+
+	return true;
+}
+
+static void _trngd_callback(uint32_t random_value, void* user_arg)
+{
+	uint32_t head = _trngd.head;
+
+	_trngd.stats.produced++;
+
+	if (!_trngd_health_test(random_value)) {
+		_trngd.failed = true;
+		trng_disable_it();
+		return;
+	}
+
+	if (head - _trngd.tail >= TRNGD_POOL_SIZE) {
+		/* pool is full, stop interrupts until samples are consumed */
+		_trngd.stats.pool_full++;
+		_trngd.paused = true;
+		trng_disable_it();
+		return;
+	}
+
+	_trngd.pool[head & TRNGD_POOL_MASK] = random_value;
+	dmb();
+	_trngd.head = head + 1;
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+void trngd_init(void)
+{
+	trng_disable_it();
+
+	memset(&_trngd, 0, sizeof(_trngd));
+	_trngd.initialized = true;
+
+	trng_enable();
+	trng_enable_it(_trngd_callback, NULL);
+}
+
+void trngd_cleanup(void)
+{
+	trng_disable_it();
+	trng_disable();
+
+	memset(&_trngd, 0, sizeof(_trngd));
+}
+
+uint32_t trngd_get_count(void)
+{
+	return _trngd.head - _trngd.tail;
+}
+
+bool trngd_is_healthy(void)
+{
+	return _trngd.initialized && !_trngd.failed;
+}
+
+int trngd_get_entropy(uint8_t* buffer, uint32_t len, void* arg)
+{
+	uint32_t tail = _trngd.tail;
+
+	if (!_trngd.initialized)
+		return -ENODEV;
+	if (_trngd.failed)
+		return -EIO;
+
+	while (len > 0) {
+		uint32_t sample;
+		uint32_t chunk = len < 4 ? len : 4;
+
+		while (_trngd.head == tail) {
+			if (_trngd.failed)
+				return -EIO;
+		}
+		dmb();
+
+		sample = _trngd.pool[tail & TRNGD_POOL_MASK];
+		_trngd.pool[tail & TRNGD_POOL_MASK] = 0;
+		memcpy(buffer, &sample, chunk);
+		buffer += chunk;
+		len -= chunk;
+
+		dmb();
+		_trngd.tail = ++tail;
+		_trngd.stats.consumed++;
+
+		if (_trngd.paused) {
+			_trngd.paused = false;
+			trng_enable_it(_trngd_callback, NULL);
+		}
+	}
+
+	return _trngd.failed ? -EIO : 0;
+}
+
+void trngd_get_stats(struct _trngd_stats* stats)
+{
+	*stats = _trngd.stats;
+}
@@ -0,0 +1,125 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _TRNGD_H_
+#define _TRNGD_H_
+
+#ifdef CONFIG_HAVE_TRNG
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Size of the entropy pool, in 32-bit words (must be a power of two) */
+#ifndef TRNGD_POOL_SIZE
+#define TRNGD_POOL_SIZE 64
+#endif
+
+/** Repetition Count Test cutoff: number of consecutive identical samples
+ * considered as a TRNG failure */
+#define TRNGD_RCT_CUTOFF 3
+
+/** Adaptive Proportion Test window size, in samples */
+#define TRNGD_APT_WINDOW 512
+
+/** Adaptive Proportion Test cutoff: maximum number of occurrences of the
+ * first sample of a window within this window */
+#define TRNGD_APT_CUTOFF 3
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+struct _trngd_stats {
+	uint32_t produced;      /**< samples received from the TRNG */
+	uint32_t consumed;      /**< samples read from the pool */
+	uint32_t rct_failures;  /**< Repetition Count Test failures */
+	uint32_t apt_failures;  /**< Adaptive Proportion Test failures */
+	uint32_t pool_full;     /**< times the TRNG was paused on a full pool */
+};
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Enable the TRNG and start filling the entropy pool from the TRNG
+ * interrupt. Every sample goes through continuous health tests (Repetition
+ * Count Test and Adaptive Proportion Test, as described in NIST SP 800-90B)
+ * before being added to the pool. The interrupt is paused while the pool is
+ * full and resumed as soon as samples are consumed.
+ */
+extern void trngd_init(void);
+
+/**
+ * \brief Stop the TRNG and flush the entropy pool.
+ */
+extern void trngd_cleanup(void);
+
+/**
+ * \brief Return the number of 32-bit samples currently available in the pool.
+ */
+extern uint32_t trngd_get_count(void);
+
+/**
+ * \brief Tell if the health tests detected a TRNG failure. Once a failure has
+ * been detected, no more entropy is delivered until trngd_init() is called
+ * again.
+ */
+extern bool trngd_is_healthy(void);
+
+/**
+ * \brief Read entropy from the pool, waiting for samples if needed.
+ *
+ * The prototype matches random_seed_source_t, so this function can be given
+ * directly to random_init().
+ *
+ * \param buffer destination buffer
+ * \param len number of bytes requested
+ * \param arg unused
+ * \return 0 on success, -EIO if the TRNG failed its health tests, -ENODEV if
+ * the driver is not initialized
+ */
+extern int trngd_get_entropy(uint8_t* buffer, uint32_t len, void* arg);
+
+/**
+ * \brief Get a copy of the driver statistics.
+ */
+extern void trngd_get_stats(struct _trngd_stats* stats);
+
+#endif /* CONFIG_HAVE_TRNG */
+
+#endif /* _TRNGD_H_ */
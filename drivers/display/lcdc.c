@@ -39,8 +39,11 @@
 
 #include "chip.h"
 #include "compiler.h"
+#include "errno.h"
 #include "display/lcdc.h"
 #include "gpio/pio.h"
+#include "intmath.h"
+#include "irq/irq.h"
 #include "mm/cache.h"
 #include "peripherals/pmc.h"
 #include "trace.h"
@@ -71,6 +74,7 @@ struct _layer_info {
 	volatile uint32_t  *reg_color;      /**< regs: RGB Default, RGB Key, RGB Mask */
 	volatile uint32_t  *reg_scale;      /**< regs: scale */
 	volatile uint32_t  *reg_clut;       /**< regs: CLUT */
+	uint32_t            irq_mask;       /**< LCDIER/LCDISR bit of the layer */
 };
 
 /** DMA descriptor for LCDC */
@@ -81,11 +85,40 @@ struct _lcdc_dma_desc {
 	uint32_t for_alignment_only;
 };
 
+/** States of a swap chain buffer */
+enum _swap_state {
+	SWAP_FREE = 0,  /**< Not on screen, can be acquired */
+	SWAP_ACQUIRED,  /**< Being drawn by the application */
+	SWAP_QUEUED,    /**< Presented, waiting for its turn */
+	SWAP_PENDING,   /**< Added to the DMA queue, shown at next frame */
+	SWAP_DISPLAYED, /**< Being scanned out */
+};
+
+/** Swap chain of a layer, one DMA descriptor per buffer so that the
+ * descriptor being fetched by the DMA is never modified */
+struct _swap_chain {
+	struct _lcdc_dma_desc  dma_desc[LCDC_SWAP_CHAIN_MAX_BUFFERS];
+	void                  *buffers[LCDC_SWAP_CHAIN_MAX_BUFFERS];
+	uint32_t               present_frame[LCDC_SWAP_CHAIN_MAX_BUFFERS];
+	volatile uint8_t       state[LCDC_SWAP_CHAIN_MAX_BUFFERS];
+	uint8_t                queue[LCDC_SWAP_CHAIN_MAX_BUFFERS]; /**< Presented buffers, oldest first */
+	uint8_t                queue_len;
+	uint8_t                count;     /**< Number of buffers, 0 if unused */
+	int8_t                 pending;   /**< Buffer in the DMA queue or -1 */
+	int8_t                 displayed; /**< Buffer on screen or -1 */
+	uint32_t               start_frame;
+	uint32_t               flip_frame;
+	lcdc_buffer_released_t callback;
+	void                  *arg;
+	struct _lcdc_swap_chain_stats stats;
+};
+
 /** Variable layer data */
 struct _layer_data {
 	struct _lcdc_dma_desc *dma_desc;
 	struct _lcdc_dma_desc *dma_u_desc;
 	struct _lcdc_dma_desc *dma_v_desc;
+	struct _swap_chain    *swap_chain;
 	void                  *buffer;
 	uint8_t                bpp;
 };
@@ -98,15 +131,23 @@ static struct _lcdc_desc lcdc_config;         /**< Current LCD configuration */
 
 static struct _lcdc_layer lcdc_canvas;        /**< Current selected canvas */
 
+static volatile uint32_t lcdc_frame_count;    /**< Start of frames seen */
+
 CACHE_ALIGNED_DDR
 static struct _lcdc_dma_desc base_dma_desc;  /**< DMA desc. for Base Layer */
 
+CACHE_ALIGNED_DDR
+static struct _swap_chain base_swap_chain;   /**< Swap chain for Base Layer */
+
 static struct _layer_data lcdc_base;         /**< Base Layer */
 
 #ifdef CONFIG_HAVE_LCDC_OVR1
 CACHE_ALIGNED_DDR
 static struct _lcdc_dma_desc ovr1_dma_desc;  /**< DMA desc. for OVR1 Layer */
 
+CACHE_ALIGNED_DDR
+static struct _swap_chain ovr1_swap_chain;   /**< Swap chain for OVR1 Layer */
+
 static struct _layer_data lcdc_ovr1;         /**< OVR1 Layer */
 #endif
 
@@ -114,6 +155,9 @@ static struct _layer_data lcdc_ovr1;         /**< OVR1 Layer */
 CACHE_ALIGNED_DDR
 static struct _lcdc_dma_desc ovr2_dma_desc;  /**< DMA desc. for OVR2 Layer */
 
+CACHE_ALIGNED_DDR
+static struct _swap_chain ovr2_swap_chain;   /**< Swap chain for OVR2 Layer */
+
 static struct _layer_data lcdc_ovr2;         /**< OVR2 Layer */
 #endif
 
@@ -126,6 +170,9 @@ static struct _lcdc_dma_desc heo_dma_u_desc; /**< DMA desc. for HEO U-UV Layer *
 CACHE_ALIGNED_DDR
 static struct _lcdc_dma_desc heo_dma_v_desc; /**< DMA desc. for HEO V Layer */
 
+CACHE_ALIGNED_DDR
+static struct _swap_chain heo_swap_chain;    /**< Swap chain for HEO Layer */
+
 static struct _layer_data lcdc_heo;          /**< HEO Layer */
 
 #ifdef CONFIG_HAVE_LCDC_PP
@@ -156,7 +203,8 @@ static const struct _layer_info lcdc_layers[] = {
 		.reg_cfg = &LCDC->LCDC_BASECFG0,
 		.reg_stride = &LCDC->LCDC_BASECFG2,
 		.reg_color = &LCDC->LCDC_BASECFG3,
-		.reg_clut = &LCDC->LCDC_BASECLUT[0]
+		.reg_clut = &LCDC->LCDC_BASECLUT[0],
+		.irq_mask = LCDC_LCDIER_BASEIE,
 	},
 #ifdef CONFIG_HAVE_LCDC_OVR1
 	/* 2: LCDC_OVR1 */
@@ -171,6 +219,7 @@ static const struct _layer_info lcdc_layers[] = {
 		.reg_stride = &LCDC->LCDC_OVR1CFG4,
 		.reg_color = &LCDC->LCDC_OVR1CFG6,
 		.reg_clut = &LCDC->LCDC_OVR1CLUT[0],
+		.irq_mask = LCDC_LCDIER_OVR1IE,
 	},
 #else
 	/* 2: N/A */
@@ -193,6 +242,7 @@ static const struct _layer_info lcdc_layers[] = {
 		.reg_color = &LCDC->LCDC_HEOCFG9,
 		.reg_scale = &LCDC->LCDC_HEOCFG13,
 		.reg_clut = &LCDC->LCDC_HEOCLUT[0],
+		.irq_mask = LCDC_LCDIER_HEOIE,
 	},
 #ifdef CONFIG_HAVE_LCDC_OVR2
 	/* 4: LCDC_OVR2 */
@@ -207,6 +257,7 @@ static const struct _layer_info lcdc_layers[] = {
 		.reg_stride = &LCDC->LCDC_OVR2CFG4,
 		.reg_color = &LCDC->LCDC_OVR2CFG6,
 		.reg_clut = &LCDC->LCDC_OVR2CLUT[0],
+		.irq_mask = LCDC_LCDIER_OVR2IE,
 	},
 #else
 	/* 4: N/A */
@@ -433,6 +484,123 @@ static void _build_color_lut1(volatile uint32_t *clut)
 	clut[1] = 0xFFFFFF;
 }
 
+/**
+ * Get the swap chain of a layer, NULL if the layer cannot have one
+ */
+static struct _swap_chain *_get_swap_chain(uint8_t layer_id)
+{
+	if (layer_id >= ARRAY_SIZE(lcdc_layers) || !lcdc_layers[layer_id].data)
+		return NULL;
+	return lcdc_layers[layer_id].data->swap_chain;
+}
+
+/**
+ * Check if a layer still has a swap chain, the start of frame interrupt is
+ * only needed until the last one is destroyed
+ */
+static bool _swap_chain_any_active(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < ARRAY_SIZE(lcdc_layers); i++) {
+		struct _swap_chain *chain = _get_swap_chain(i);
+		if (chain && chain->count)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Give the oldest presented buffer to the DMA, unless a buffer is already
+ * waiting for the next frame. Called with the LCDC interrupt masked.
+ */
+static void _swap_chain_submit(const struct _layer_info *layer,
+		struct _swap_chain *chain)
+{
+	struct _lcdc_dma_desc *desc;
+	uint8_t index;
+
+	if (chain->pending >= 0 || chain->queue_len == 0)
+		return;
+
+	index = chain->queue[0];
+	chain->queue_len--;
+	memmove(chain->queue, chain->queue + 1, chain->queue_len);
+	chain->state[index] = SWAP_PENDING;
+	chain->pending = index;
+
+	/* Loop on the new buffer once it is loaded at the start of next frame,
+	 * the interrupt tells when the previous one is released */
+	desc = &chain->dma_desc[index];
+	desc->addr = (uint32_t)chain->buffers[index];
+	desc->ctrl = LCDC_BASECTRL_DFETCH | LCDC_BASECTRL_ADDIEN;
+	desc->next = (uint32_t)desc;
+	cache_clean_region(desc, sizeof(*desc));
+	layer->reg_dma_head[0] = (uint32_t)desc;
+	layer->reg_enable[0] = LCDC_BASECHER_A2QEN;
+}
+
+/**
+ * The pending buffer of a swap chain has been loaded by the DMA: it is now
+ * scanned out and the previous one can be released
+ */
+static void _swap_chain_flip(uint8_t layer_id)
+{
+	const struct _layer_info *layer = &lcdc_layers[layer_id];
+	struct _swap_chain *chain = layer->data->swap_chain;
+	struct _lcdc_swap_chain_stats *stats = &chain->stats;
+	uint32_t frame = lcdc_frame_count;
+	int8_t released = chain->displayed;
+
+	if (chain->pending < 0)
+		return;
+
+	chain->displayed = chain->pending;
+	chain->pending = -1;
+	chain->state[chain->displayed] = SWAP_DISPLAYED;
+	layer->data->buffer = chain->buffers[chain->displayed];
+
+	stats->last_latency = frame - chain->present_frame[chain->displayed];
+	stats->max_latency = max_u32(stats->max_latency, stats->last_latency);
+	if (stats->flips++) {
+		stats->last_interval = frame - chain->flip_frame;
+		stats->max_interval = max_u32(stats->max_interval,
+				stats->last_interval);
+	}
+	chain->flip_frame = frame;
+
+	_swap_chain_submit(layer, chain);
+
+	if (released >= 0) {
+		chain->state[released] = SWAP_FREE;
+		if (chain->callback)
+			chain->callback(layer_id, chain->buffers[released],
+					chain->arg);
+	}
+}
+
+/**
+ * LCDC interrupt handler, counts frames and advances the swap chains
+ */
+static void _lcdc_handler(uint32_t source, void* user_arg)
+{
+	uint32_t status = LCDC->LCDC_LCDISR & LCDC->LCDC_LCDIMR;
+	uint8_t i;
+
+	if (status & LCDC_LCDISR_SOF)
+		lcdc_frame_count++;
+
+	for (i = 0; i < ARRAY_SIZE(lcdc_layers); i++) {
+		const struct _layer_info *layer = &lcdc_layers[i];
+
+		if (!(status & layer->irq_mask))
+			continue;
+		/* Reading the layer status clears it */
+		if (layer->reg_enable[6] & LCDC_BASEISR_ADD)
+			_swap_chain_flip(i);
+	}
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -448,21 +616,29 @@ void lcdc_configure(const struct _lcdc_desc *desc)
 	lcdc_base.bpp = 0;
 	lcdc_base.buffer = NULL;
 	lcdc_base.dma_desc = &base_dma_desc;
+	lcdc_base.swap_chain = &base_swap_chain;
+	base_swap_chain.count = 0;
 #ifdef CONFIG_HAVE_LCDC_OVR1
 	lcdc_ovr1.bpp = 0;
 	lcdc_ovr1.buffer = NULL;
 	lcdc_ovr1.dma_desc = &ovr1_dma_desc;
+	lcdc_ovr1.swap_chain = &ovr1_swap_chain;
+	ovr1_swap_chain.count = 0;
 #endif
 #ifdef CONFIG_HAVE_LCDC_OVR2
 	lcdc_ovr2.bpp = 0;
 	lcdc_ovr2.buffer = NULL;
 	lcdc_ovr2.dma_desc = &ovr2_dma_desc;
+	lcdc_ovr2.swap_chain = &ovr2_swap_chain;
+	ovr2_swap_chain.count = 0;
 #endif
 	lcdc_heo.bpp = 0;
 	lcdc_heo.buffer = NULL;
 	lcdc_heo.dma_desc = &heo_dma_desc;
 	lcdc_heo.dma_u_desc = &heo_dma_u_desc;
 	lcdc_heo.dma_v_desc = &heo_dma_v_desc;
+	lcdc_heo.swap_chain = &heo_swap_chain;
+	heo_swap_chain.count = 0;
 #ifdef CONFIG_HAVE_LCDC_PP
 	/* Reset layer information */
 	lcdc_pp.bpp = 0;
@@ -1657,7 +1833,8 @@ void lcdc_flush_canvas(void)
 	struct _lcdc_layer *layer;
 
 	layer = lcdc_get_canvas();
-	cache_clean_region(layer->buffer, layer->height * layer->width * 4);
+	cache_clean_region(layer->buffer, layer->height *
+			ROUND_UP_MULT(layer->width * (layer->bpp / 8), 4));
 }
 
 /**
@@ -1848,6 +2025,184 @@ void *lcdc_create_canvas_yuv_semiplanar(uint8_t layer_id,
 	return 0;
 }
 
+/**
+ * \brief Create a swap chain on a layer for tear-free display.
+ *
+ * The layer must already be configured and shown with lcdc_put_image() or
+ * one of the lcdc_show_xxx() functions (position, size, bpp). If the buffer
+ * displayed at that time belongs to the chain it is considered on screen,
+ * all the other buffers are free. Only single plane formats are supported.
+ * While the chain exists, the layer buffer must only be changed through
+ * lcdc_swap_chain_present().
+ *
+ * \param layer_id  Layer ID (BASE, OVR1, OVR2 or HEO).
+ * \param buffers   Frame buffers of the layer.
+ * \param count     Number of buffers (2 to LCDC_SWAP_CHAIN_MAX_BUFFERS).
+ * \param callback  Called from interrupt when a buffer leaves the screen
+ *                  (optional).
+ * \param arg       Callback argument.
+ * \return 0 on success, -EINVAL if the layer or buffer count is invalid.
+ */
+int lcdc_swap_chain_create(uint8_t layer_id, void **buffers, uint8_t count,
+		lcdc_buffer_released_t callback, void *arg)
+{
+	struct _swap_chain *chain = _get_swap_chain(layer_id);
+	const struct _layer_info *layer;
+	uint8_t i;
+
+	if (!chain || count < 2 || count > LCDC_SWAP_CHAIN_MAX_BUFFERS)
+		return -EINVAL;
+	layer = &lcdc_layers[layer_id];
+
+	irq_disable(ID_LCDC);
+	layer->reg_enable[4] = LCDC_BASEIDR_ADD;
+	(void)layer->reg_enable[6];
+
+	memset(chain, 0, sizeof(*chain));
+	chain->count = count;
+	chain->pending = -1;
+	chain->displayed = -1;
+	for (i = 0; i < count; i++) {
+		chain->buffers[i] = buffers[i];
+		if (buffers[i] == layer->data->buffer && chain->displayed < 0) {
+			chain->state[i] = SWAP_DISPLAYED;
+			chain->displayed = i;
+		}
+	}
+	chain->callback = callback;
+	chain->arg = arg;
+	chain->start_frame = lcdc_frame_count;
+	chain->flip_frame = lcdc_frame_count;
+
+	irq_add_handler(ID_LCDC, _lcdc_handler, NULL);
+	layer->reg_enable[3] = LCDC_BASEIER_ADD;
+	LCDC->LCDC_LCDIER = LCDC_LCDIER_SOFIE | layer->irq_mask;
+	irq_enable(ID_LCDC);
+
+	return 0;
+}
+
+/**
+ * \brief Remove the swap chain of a layer. The buffer on screen, or the one
+ * about to be, stays displayed.
+ * \param layer_id  Layer ID.
+ */
+void lcdc_swap_chain_destroy(uint8_t layer_id)
+{
+	struct _swap_chain *chain = _get_swap_chain(layer_id);
+	const struct _layer_info *layer;
+
+	if (!chain || !chain->count)
+		return;
+	layer = &lcdc_layers[layer_id];
+
+	irq_disable(ID_LCDC);
+	layer->reg_enable[4] = LCDC_BASEIDR_ADD;
+	if (chain->pending >= 0)
+		layer->data->buffer = chain->buffers[chain->pending];
+	chain->count = 0;
+	/* Stop the start of frame interrupt with the last chain */
+	LCDC->LCDC_LCDIDR = layer->irq_mask |
+		(_swap_chain_any_active() ? 0 : LCDC_LCDIDR_SOFID);
+	irq_enable(ID_LCDC);
+}
+
+/**
+ * \brief Get a buffer of the swap chain to draw into. The buffer is neither
+ * on screen nor queued for display.
+ * \param layer_id  Layer ID.
+ * \return Pointer to the buffer, NULL if all the buffers are in use.
+ */
+void *lcdc_swap_chain_acquire(uint8_t layer_id)
+{
+	struct _swap_chain *chain = _get_swap_chain(layer_id);
+	void *buffer = NULL;
+	uint8_t i;
+
+	if (!chain || !chain->count)
+		return NULL;
+
+	irq_disable(ID_LCDC);
+	for (i = 0; i < chain->count; i++) {
+		if (chain->state[i] == SWAP_FREE) {
+			chain->state[i] = SWAP_ACQUIRED;
+			buffer = chain->buffers[i];
+			break;
+		}
+	}
+	irq_enable(ID_LCDC);
+	return buffer;
+}
+
+/**
+ * \brief Queue a buffer for display. Buffers are shown in the order they
+ * are presented, each one for at least one frame, the switch happening at
+ * the start of a frame. The data cache must have been cleaned for the
+ * buffer content.
+ * \param layer_id  Layer ID.
+ * \param buffer    Buffer of the swap chain, acquired or free.
+ * \return 0 on success, -EINVAL if the buffer is not part of the chain,
+ * -EBUSY if it is already queued or on screen.
+ */
+int lcdc_swap_chain_present(uint8_t layer_id, void *buffer)
+{
+	struct _swap_chain *chain = _get_swap_chain(layer_id);
+	int err = -EINVAL;
+	uint8_t i;
+
+	if (!chain || !chain->count)
+		return -EINVAL;
+
+	irq_disable(ID_LCDC);
+	for (i = 0; i < chain->count; i++) {
+		if (chain->buffers[i] != buffer)
+			continue;
+		if (chain->state[i] != SWAP_FREE &&
+		    chain->state[i] != SWAP_ACQUIRED) {
+			err = -EBUSY;
+			break;
+		}
+		chain->state[i] = SWAP_QUEUED;
+		chain->present_frame[i] = lcdc_frame_count;
+		chain->queue[chain->queue_len++] = i;
+		_swap_chain_submit(&lcdc_layers[layer_id], chain);
+		err = 0;
+		break;
+	}
+	irq_enable(ID_LCDC);
+	return err;
+}
+
+/**
+ * \brief Get the timing statistics of a swap chain.
+ * \param layer_id  Layer ID.
+ * \param stats     Pointer for storing the statistics.
+ * \return 0 on success, -EINVAL if the layer has no swap chain.
+ */
+int lcdc_swap_chain_get_stats(uint8_t layer_id,
+		struct _lcdc_swap_chain_stats *stats)
+{
+	struct _swap_chain *chain = _get_swap_chain(layer_id);
+
+	if (!chain || !chain->count)
+		return -EINVAL;
+
+	irq_disable(ID_LCDC);
+	*stats = chain->stats;
+	stats->frames = lcdc_frame_count - chain->start_frame;
+	irq_enable(ID_LCDC);
+	return 0;
+}
+
+/**
+ * \brief Number of frames started while a swap chain existed, the count
+ * pauses when the last swap chain is destroyed.
+ */
+uint32_t lcdc_get_frame_count(void)
+{
+	return lcdc_frame_count;
+}
+
 #ifdef CONFIG_HAVE_LCDC_PP
 /**
  * Connfigure PPC with DMA enabled.
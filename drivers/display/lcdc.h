@@ -58,6 +58,13 @@
  *    -# lcdc_show_base(), lcdc_stop_base()
  *    -# lcdc_show_ovr1(), lcdc_stop_ovr1()
  *    -# lcdc_show_heo(), lcdc_stop_heo()
+ * -# Tear-free animation on a layer uses a swap chain of 2 or more buffers:
+ *    -# Show the first buffer with lcdc_put_image() or lcdc_show_xxx() to
+ *       configure the layer, then lcdc_swap_chain_create().
+ *    -# lcdc_swap_chain_acquire() returns a buffer that is not on screen,
+ *       lcdc_swap_chain_present() queues it for display at the next start
+ *       of frame. A callback signals buffers leaving the screen.
+ *    -# lcdc_get_frame_count(), lcdc_swap_chain_get_stats(): Timing.
  * -# Drawing supporting functions, for drawing canvas:
  *    -# lcdc_create_canvas(): Create blank canvas on specified layer for
  *                            drawing on
@@ -115,6 +122,9 @@ enum {
 };
 /**     @}*/
 
+/** Maximum number of buffers in a layer swap chain */
+#define LCDC_SWAP_CHAIN_MAX_BUFFERS 4
+
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -145,6 +155,20 @@ struct _lcdc_desc {
 	uint8_t timing_hpw; /**< Horizontal pulse width in LCDDOTCLK cycles */
 };
 
+/** Swap chain callback, invoked from the LCDC interrupt when a buffer is no
+ * longer scanned out and can be drawn again */
+typedef void (*lcdc_buffer_released_t)(uint8_t layer, void *buffer, void *arg);
+
+/** Swap chain statistics, all durations are in frames */
+struct _lcdc_swap_chain_stats {
+	uint32_t frames;        /**< Frames scanned out since the chain creation */
+	uint32_t flips;         /**< Buffers that reached the screen */
+	uint32_t last_latency;  /**< Delay from present to display, last flip */
+	uint32_t max_latency;   /**< Delay from present to display, worst */
+	uint32_t last_interval; /**< Delay between the two last flips */
+	uint32_t max_interval;  /**< Delay between two flips, worst */
+};
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -231,6 +255,21 @@ extern void *lcdc_create_canvas_yuv_planar(uint8_t layer,
 extern void *lcdc_create_canvas_yuv_semiplanar(uint8_t layer,
 		void *buffer_y, void *buffer_uv, uint8_t bpp,
 		uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+extern int lcdc_swap_chain_create(uint8_t layer, void **buffers, uint8_t count,
+		lcdc_buffer_released_t callback, void *arg);
+
+extern void lcdc_swap_chain_destroy(uint8_t layer);
+
+extern void *lcdc_swap_chain_acquire(uint8_t layer);
+
+extern int lcdc_swap_chain_present(uint8_t layer, void *buffer);
+
+extern int lcdc_swap_chain_get_stats(uint8_t layer,
+		struct _lcdc_swap_chain_stats *stats);
+
+extern uint32_t lcdc_get_frame_count(void);
+
 #ifdef CONFIG_HAVE_LCDC_PP
 extern void lcdc_configure_pp(void *buffer, uint32_t output_mode);
 #endif
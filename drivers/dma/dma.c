@@ -42,13 +42,18 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "barriers.h"
 #include "callback.h"
 #include "compiler.h"
 #include "dma/dma.h"
 #include "irq/irq.h"
 #include "errno.h"
+#include "intmath.h"
+#include "mempool.h"
 #include "mm/cache.h"
-#include "mutex.h"
+#ifdef CONFIG_HAVE_MMU
+#include "mm/coherent_pool.h"
+#endif
 #include "peripherals/pmc.h"
 
 /*----------------------------------------------------------------------------
@@ -117,15 +122,6 @@ struct _dma_sg_desc {
 #endif
 };
 
-struct _dma_sg_pool {
-	struct _dma_sg_desc desc[DMA_SG_ITEM_POOL_SIZE];
-	struct _dma_sg_desc* head;
-	struct _dma_sg_desc* tail;
-
-	uint16_t count; /* Count elements in list  */
-	mutex_t mutex;
-};
-
 
 /** DMA driver instance */
 struct _dma_ctrl {
@@ -138,7 +134,12 @@ struct _dma_ctrl {
  *        Local variables
  *----------------------------------------------------------------------------*/
 
-CACHE_ALIGNED static struct _dma_sg_pool _dma_sg_pool;
+/* One descriptor per cache line, so that a list is cleaned on its own. Only
+ * used when the descriptors cannot be taken from the coherent pool. */
+MEMPOOL_DECLARE(_dma_sg_pool, sizeof(struct _dma_sg_desc), DMA_SG_ITEM_POOL_SIZE);
+
+/* Descriptors are in uncached memory, no cache maintenance is needed */
+static bool _dma_sg_coherent;
 
 static struct _dma_ctrl _dma_ctrl;
 
@@ -157,87 +158,63 @@ static inline bool is_dest_periph(struct _dma_channel* channel)
 }
 
 /**
- * \brief Preinitialize all descriptors and pool and link them together
+ * \brief Empty the descriptor pool
  */
 static void _dma_sg_init(void)
 {
-	uint32_t i;
-
-	memset(&_dma_sg_pool, 0, sizeof(_dma_sg_pool));
-
-	mutex_lock(&_dma_sg_pool.mutex);
-
-	for (i = 0; i < ARRAY_SIZE(_dma_sg_pool.desc); i++)
-		DMA_SG_DESC_SET_NEXT(&_dma_sg_pool.desc[i], &_dma_sg_pool.desc[i + 1]);
-	DMA_SG_DESC_SET_NEXT(&_dma_sg_pool.desc[i - 1], 0);
-
-	_dma_sg_pool.head = _dma_sg_pool.desc;
-	_dma_sg_pool.tail = &_dma_sg_pool.desc[i - 1];
-	_dma_sg_pool.count = ARRAY_SIZE(_dma_sg_pool.desc);
-
-	mutex_unlock(&_dma_sg_pool.mutex);
+#ifdef CONFIG_HAVE_MMU
+	const uint32_t block_size =
+		MEMPOOL_BLOCK_SIZE(sizeof(struct _dma_sg_desc), sizeof(uint32_t));
+	static void* storage;
+
+	/* The coherent pool is never freed: allocate the descriptors once */
+	if (!storage)
+		storage = coherent_alloc(DMA_SG_ITEM_POOL_SIZE * block_size, 0);
+	if (storage) {
+		mempool_init(&_dma_sg_pool, storage, block_size,
+			DMA_SG_ITEM_POOL_SIZE);
+		_dma_sg_coherent = true;
+		return;
+	}
+#endif
+	mempool_init(&_dma_sg_pool, _dma_sg_pool_storage,
+		MEMPOOL_BLOCK_SIZE(sizeof(struct _dma_sg_desc), L1_CACHE_BYTES),
+		DMA_SG_ITEM_POOL_SIZE);
+	_dma_sg_coherent = false;
 }
 
-static struct _dma_sg_desc* _dma_sg_desc_alloc(uint8_t count)
+static void _dma_sg_desc_free(struct _dma_sg_desc* list_head)
 {
-	struct _dma_sg_desc* list_head;
-	struct _dma_sg_desc* curr;
+	struct _dma_sg_desc* curr = list_head;
 	struct _dma_sg_desc* next;
-	uint8_t i;
-
-	if (count == 0)
-		return NULL;
-	if (count > _dma_sg_pool.count)
-		return NULL;
 
-	mutex_lock(&_dma_sg_pool.mutex);
-
-	list_head = _dma_sg_pool.head;
-	curr = list_head;
-	for (i = 0; i < (count - 1); i++) {
-		curr = DMA_SG_DESC_GET_NEXT(curr);
-	}
+	while (curr != NULL) {
 		next = DMA_SG_DESC_GET_NEXT(curr);
-	DMA_SG_DESC_SET_NEXT(curr, 0);
-
-	_dma_sg_pool.count -= count;
-	_dma_sg_pool.head = next;
-
-	if (_dma_sg_pool.count == 0) {
-		_dma_sg_pool.head = NULL;
-		_dma_sg_pool.tail = NULL;
+		mempool_free(&_dma_sg_pool, curr);
+		if (next == list_head)
+			break;
+		curr = next;
 	}
-
-	mutex_unlock(&_dma_sg_pool.mutex);
-
-	return list_head;
 }
 
-static void _dma_sg_desc_free(struct _dma_sg_desc* list_head)
+static struct _dma_sg_desc* _dma_sg_desc_alloc(uint8_t count)
 {
-	struct _dma_sg_desc* curr = list_head;
-	struct _dma_sg_desc* tail;
-
-	if (list_head == NULL)
-		return;
-
-	do {
-		tail = curr;
-		curr = DMA_SG_DESC_GET_NEXT(curr);
-	} while ((curr != NULL) && (curr != list_head));
-	curr = list_head;
-
-	mutex_lock(&_dma_sg_pool.mutex);
-
-	if (_dma_sg_pool.head == NULL)
-		_dma_sg_pool.head = list_head;
+	struct _dma_sg_desc* list_head = NULL;
+	struct _dma_sg_desc* curr;
+	uint8_t i;
 
-	if (_dma_sg_pool.tail != NULL)
-		DMA_SG_DESC_SET_NEXT(_dma_sg_pool.tail, list_head);
-	_dma_sg_pool.tail = tail;
-	DMA_SG_DESC_SET_NEXT(_dma_sg_pool.tail, 0);
+	/* link the descriptors backwards, the last one ends the list */
+	for (i = 0; i < count; i++) {
+		curr = mempool_alloc(&_dma_sg_pool);
+		if (curr == NULL) {
+			_dma_sg_desc_free(list_head);
+			return NULL;
+		}
+		DMA_SG_DESC_SET_NEXT(curr, list_head);
+		list_head = curr;
+	}
 
-	mutex_unlock(&_dma_sg_pool.mutex);
+	return list_head;
 }
 
 static int _dma_configure_transfer(struct _dma_channel* channel,
@@ -428,7 +405,16 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 	}
 	channel->sg_list = _sg_head;
 
-	cache_clean_region(_dma_sg_pool.desc, sizeof(_dma_sg_pool.desc));
+	if (_dma_sg_coherent) {
+		/* Drain the write buffer before the controller fetches them */
+		dsb();
+	} else {
+		curr = _sg_head;
+		for (idx = 0; idx < sg_list_size; idx++) {
+			cache_clean_region(curr, sizeof(*curr));
+			curr = DMA_SG_DESC_GET_NEXT(curr);
+		}
+	}
 
 	/* Update configuration */
 #if defined(CONFIG_HAVE_XDMAC)
@@ -473,6 +459,46 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 #endif
 }
 
+/**
+ * \brief Get the period a cyclic transfer is working on.
+ * The controller holds the address of the next descriptor to fetch, the
+ * period in progress is the one described before it.
+ */
+static uint8_t _dma_cyclic_hw_period(struct _dma_channel* channel)
+{
+	struct _dma_sg_desc* desc = channel->sg_list;
+	uint8_t periods = channel->cyclic.periods;
+	uint32_t next;
+	uint8_t i;
+
+#if defined(CONFIG_HAVE_XDMAC)
+	next = xdmac_get_descriptor_addr(channel->hw, channel->id);
+#elif defined(CONFIG_HAVE_DMAC)
+	next = dmac_get_descriptor_addr(channel->hw, channel->id);
+#endif
+
+	for (i = 0; i < periods; i++) {
+		if ((uint32_t)desc == next)
+			return (i + periods - 1) % periods;
+		desc = DMA_SG_DESC_GET_NEXT(desc);
+	}
+	return 0;
+}
+
+/**
+ * \brief Skip the periods of a cyclic transfer the DMA went over again
+ * before the client released them.
+ * \return Count of pending periods
+ */
+static uint32_t _dma_cyclic_resync(struct _dma_cyclic* cyclic)
+{
+	uint32_t elapsed = cyclic->elapsed;
+
+	if (elapsed - cyclic->acked >= cyclic->periods)
+		cyclic->acked = elapsed - (cyclic->periods - 1);
+	return elapsed - cyclic->acked;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -559,6 +585,7 @@ struct _dma_channel* dma_allocate_channel(uint8_t src, uint8_t dest)
 				dma_prepare_channel(channel);
 
 				channel->sg_list = NULL;
+				memset(&channel->cyclic, 0, sizeof(channel->cyclic));
 
 				return channel;
 			}
@@ -591,6 +618,7 @@ int dma_reset_channel(struct _dma_channel* channel)
 
 	_dma_sg_desc_free(channel->sg_list);
 	channel->sg_list = NULL;
+	channel->cyclic.periods = 0;
 
 	/* Change state to 'allocated' */
 	channel->state = DMA_STATE_ALLOCATED;
@@ -706,12 +734,174 @@ int dma_configure_transfer(struct _dma_channel* channel,
 	if (list_size == 0)
 		return -EINVAL;
 
+	if (channel->state == DMA_STATE_STARTED)
+		return -EBUSY;
+
+	/* Release the linked list of a previous configuration */
+	_dma_sg_desc_free(channel->sg_list);
+	channel->sg_list = NULL;
+	channel->cyclic.periods = 0;
+
 	if ((list_size == 1) && (!cfg_dma->loop))
 		return _dma_configure_transfer(channel, cfg_dma, list);
 	else
 		return _dma_sg_configure_transfer(channel, cfg_dma, list, list_size);
 }
 
+int dma_configure_cyclic_transfer(struct _dma_channel* channel,
+				  struct _dma_cfg* cfg_dma,
+				  struct _dma_transfer_cfg* cfg,
+				  uint8_t periods)
+{
+	struct _dma_transfer_cfg list[DMA_CYCLIC_MAX_PERIODS];
+	struct _dma_cyclic* cyclic = &channel->cyclic;
+	struct _dma_cfg cfg_loop;
+	uint32_t period_len, period_size;
+	uint8_t i;
+	int err;
+
+	if ((periods < 2) || (periods > DMA_CYCLIC_MAX_PERIODS))
+		return -EINVAL;
+	if ((cfg->len == 0) || (cfg->len % periods))
+		return -EINVAL;
+
+	period_len = cfg->len / periods;
+	if (period_len > DMA_MAX_BT_SIZE)
+		return -EINVAL;
+	period_size = period_len * DMA_DATA_WIDTH_IN_BYTE(cfg_dma->data_width);
+
+	if (channel->state == DMA_STATE_STARTED)
+		return -EBUSY;
+
+	_dma_sg_desc_free(channel->sg_list);
+	channel->sg_list = NULL;
+
+	/* One linked list item per period */
+	for (i = 0; i < periods; i++) {
+		list[i].saddr = cfg_dma->incr_saddr ?
+			(const uint8_t*)cfg->saddr + i * period_size : cfg->saddr;
+		list[i].daddr = cfg_dma->incr_daddr ?
+			(uint8_t*)cfg->daddr + i * period_size : cfg->daddr;
+		list[i].len = period_len;
+	}
+
+	cyclic->periods = 0;
+	cyclic->rx = is_source_periph(channel);
+	cyclic->buffer = cyclic->rx ? (uint8_t*)cfg->daddr : (uint8_t*)cfg->saddr;
+	cyclic->period_len = period_len;
+	cyclic->period_size = period_size;
+	cyclic->hw_period = 0;
+	cyclic->elapsed = 0;
+	cyclic->acked = 0;
+	cyclic->xruns = 0;
+
+	if (cyclic->rx)
+		cache_invalidate_region(cyclic->buffer, periods * period_size);
+	else
+		cache_clean_region(cyclic->buffer, periods * period_size);
+
+	cfg_loop = *cfg_dma;
+	cfg_loop.loop = true;
+	err = _dma_sg_configure_transfer(channel, &cfg_loop, list, periods);
+	if (err < 0)
+		return err;
+
+#if defined(CONFIG_HAVE_XDMAC)
+	/* Each linked list item is a block, interrupt on each one */
+	xdmac_enable_channel_it(channel->hw, channel->id, XDMAC_CIE_BIE);
+#endif
+	cyclic->periods = periods;
+
+	return 0;
+}
+
+uint32_t dma_get_cyclic_position(struct _dma_channel* channel)
+{
+	struct _dma_cyclic* cyclic = &channel->cyclic;
+	uint32_t done;
+	uint8_t period;
+
+	if (cyclic->periods == 0)
+		return 0;
+
+	/* Sample again if the DMA moved to another period meanwhile */
+	do {
+		period = _dma_cyclic_hw_period(channel);
+#if defined(CONFIG_HAVE_XDMAC)
+		done = cyclic->period_len - xdmac_get_microblock_control(channel->hw, channel->id);
+#elif defined(CONFIG_HAVE_DMAC)
+		done = dmac_get_btsize(channel->hw, channel->id);
+#endif
+	} while (period != _dma_cyclic_hw_period(channel));
+
+	done = min_u32(done, cyclic->period_len);
+	return period * cyclic->period_size
+		+ done * (cyclic->period_size / cyclic->period_len);
+}
+
+void* dma_get_cyclic_period(struct _dma_channel* channel)
+{
+	struct _dma_cyclic* cyclic = &channel->cyclic;
+
+	if (cyclic->periods == 0)
+		return NULL;
+	if (_dma_cyclic_resync(cyclic) == 0)
+		return NULL;
+
+	return cyclic->buffer + (cyclic->acked % cyclic->periods) * cyclic->period_size;
+}
+
+uint32_t dma_get_cyclic_avail(struct _dma_channel* channel)
+{
+	if (channel->cyclic.periods == 0)
+		return 0;
+
+	return _dma_cyclic_resync(&channel->cyclic);
+}
+
+void dma_ack_cyclic_periods(struct _dma_channel* channel, uint32_t count)
+{
+	struct _dma_cyclic* cyclic = &channel->cyclic;
+
+	if (cyclic->periods == 0)
+		return;
+
+	count = min_u32(count, _dma_cyclic_resync(cyclic));
+	while (count--) {
+		if (!cyclic->rx)
+			cache_clean_region(cyclic->buffer + (cyclic->acked % cyclic->periods) * cyclic->period_size,
+					   cyclic->period_size);
+		cyclic->acked++;
+	}
+}
+
+bool dma_update_cyclic_transfer(struct _dma_channel* channel)
+{
+	struct _dma_cyclic* cyclic = &channel->cyclic;
+	uint8_t period, count;
+
+	if (cyclic->periods == 0)
+		return false;
+
+	period = _dma_cyclic_hw_period(channel);
+	count = (period + cyclic->periods - cyclic->hw_period) % cyclic->periods;
+	/* End of block may be flagged before the next descriptor is fetched */
+	if (count == 0)
+		count = 1;
+
+	while (count--) {
+		if (cyclic->rx)
+			cache_invalidate_region(cyclic->buffer + cyclic->hw_period * cyclic->period_size,
+						cyclic->period_size);
+		cyclic->hw_period = (cyclic->hw_period + 1) % cyclic->periods;
+		cyclic->elapsed++;
+		if (cyclic->elapsed - cyclic->acked >= cyclic->periods)
+			cyclic->xruns++;
+	}
+
+	return true;
+}
+
 uint32_t dma_get_transferred_data_len(struct _dma_channel* channel, uint8_t chunk_size, uint32_t len)
 {
 #if defined(CONFIG_HAVE_XDMAC)
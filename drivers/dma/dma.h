@@ -104,6 +104,10 @@ enum {
 #define DMA_SG_ITEM_POOL_SIZE   64
 #endif
 
+#ifndef DMA_CYCLIC_MAX_PERIODS
+#define DMA_CYCLIC_MAX_PERIODS  16
+#endif
+
 #define DMA_DATA_WIDTH_IN_BYTE(w)   (1 << w)
 
 /*----------------------------------------------------------------------------
@@ -113,6 +117,19 @@ enum {
 /** \addtogroup dma_structs DMA Driver Structs
 		@{*/
 
+/** Cyclic (ring) transfer state, see dma_configure_cyclic_transfer() */
+struct _dma_cyclic {
+	uint8_t* buffer;            /* Memory side of the ring */
+	uint32_t period_size;       /* Period size in bytes */
+	uint32_t period_len;        /* Period length in data units */
+	uint8_t periods;            /* Number of periods, 0 if not cyclic */
+	uint8_t hw_period;          /* Period in progress at last update */
+	bool rx;                    /* Ring is written by the DMA */
+	volatile uint32_t elapsed;  /* Periods completed by the DMA */
+	volatile uint32_t acked;    /* Periods released by the client */
+	volatile uint32_t xruns;    /* Periods replayed or overwritten */
+};
+
 /** DMA driver channel */
 struct _dma_channel {
 #if defined(CONFIG_HAVE_DMAC)
@@ -134,6 +151,7 @@ struct _dma_channel {
 	volatile uint8_t state;		/* Channel State */
 
 	struct _dma_sg_desc* sg_list;
+	struct _dma_cyclic cyclic;
 };
 
 struct _dma_transfer_cfg {
@@ -225,6 +243,67 @@ extern int dma_configure_transfer(struct _dma_channel* channel,
 				  struct _dma_transfer_cfg* list,
 				  uint8_t list_size);
 
+/**
+ * \brief Configure DMA for a cyclic transfer over a ring buffer.
+ * The ring is split in \a periods equal blocks chained in a circular linked
+ * list, so the channel runs until dma_stop_transfer() without being
+ * reprogrammed. The channel callback is invoked from interrupt context each
+ * time one or more periods complete.
+ * The memory side of the ring must be cache aligned. For memory to
+ * peripheral transfers the ring must be filled before the transfer starts.
+ * \param channel Channel pointer
+ * \param cfg_dma DMA transfer configuration (loop is ignored)
+ * \param cfg     Whole ring transfer, len in data units
+ * \param periods Number of periods, from 2 to DMA_CYCLIC_MAX_PERIODS
+ * \return error code
+ */
+extern int dma_configure_cyclic_transfer(struct _dma_channel* channel,
+					 struct _dma_cfg* cfg_dma,
+					 struct _dma_transfer_cfg* cfg,
+					 uint8_t periods);
+
+/**
+ * \brief Get the hardware position in a cyclic transfer.
+ * \param channel Channel pointer
+ * \return Offset in bytes from the start of the ring
+ */
+extern uint32_t dma_get_cyclic_position(struct _dma_channel* channel);
+
+/**
+ * \brief Get the oldest period of a cyclic transfer not released yet.
+ * For peripheral to memory transfers, this is the oldest period filled by
+ * the DMA. For memory to peripheral transfers, this is the oldest period
+ * already sent, which must be refilled.
+ * If the client fell behind by a whole ring, the overwritten (or replayed)
+ * periods are skipped and counted as xruns.
+ * \param channel Channel pointer
+ * \return Period address, or NULL if no period is pending
+ */
+extern void* dma_get_cyclic_period(struct _dma_channel* channel);
+
+/**
+ * \brief Get the count of periods of a cyclic transfer not released yet.
+ * \param channel Channel pointer
+ */
+extern uint32_t dma_get_cyclic_avail(struct _dma_channel* channel);
+
+/**
+ * \brief Release periods of a cyclic transfer back to the DMA.
+ * For memory to peripheral transfers, the released periods are cleaned from
+ * the data cache.
+ * \param channel Channel pointer
+ * \param count   Number of periods processed by the client
+ */
+extern void dma_ack_cyclic_periods(struct _dma_channel* channel, uint32_t count);
+
+/**
+ * \brief Account for the periods completed by a cyclic transfer.
+ * Called by the controller interrupt handler on end of block events.
+ * \param channel Channel pointer
+ * \return true if the channel is in cyclic mode
+ */
+extern bool dma_update_cyclic_transfer(struct _dma_channel* channel);
+
 /**
  * \brief Stop DMA transfer.
  * \param channel Channel pointer
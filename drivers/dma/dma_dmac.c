@@ -175,7 +175,12 @@ void dma_irq_handler(uint32_t source, void* user_arg)
 			continue;
 		if (channel->state == DMA_STATE_FREE)
 			continue;
-		if (gis & (DMAC_EBCISR_CBTC0 << chan)) {
+		if (channel->cyclic.periods) {
+			/* Cyclic transfer: the chain never ends, report each
+			 * buffer transfer */
+			if (gis & (DMAC_EBCISR_BTC0 << chan))
+				exec = dma_update_cyclic_transfer(channel);
+		} else if (gis & (DMAC_EBCISR_CBTC0 << chan)) {
 			if (channel->rep_count) {
 				if (channel->rep_count == 1) {
 					dmac_auto_clear(dmac, chan);
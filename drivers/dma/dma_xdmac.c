@@ -180,7 +180,14 @@ void dma_irq_handler(uint32_t source, void* user_arg)
 		if (channel->state == DMA_STATE_FREE)
 			continue;
 
-		if (!(gcs & (1 << chan))) {
+		if (channel->cyclic.periods) {
+			/* Cyclic transfer: the channel keeps running, report
+			 * each end of block */
+			uint32_t cis = xdmac_get_channel_isr(xdmac, chan);
+
+			if (cis & XDMAC_CIS_BIS)
+				exec = dma_update_cyclic_transfer(channel);
+		} else if (!(gcs & (1 << chan))) {
 			uint32_t cis = xdmac_get_channel_isr(xdmac, chan);
 
 			if (cis & XDMAC_CIS_BIS) {
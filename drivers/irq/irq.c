@@ -32,6 +32,8 @@
  *----------------------------------------------------------------------------*/
 
 #include "chip.h"
+#include "irqflags.h"
+#include "mempool.h"
 
 #if defined(CONFIG_HAVE_AIC2) || defined(CONFIG_HAVE_AIC5)
 #include "irq/aic.h"
@@ -41,7 +43,30 @@
 #include "irq/nvic.h"
 #endif
 
+#ifdef CONFIG_HAVE_IRQ_STATS
+#include "peripherals/pmc.h"
+#include "peripherals/tc.h"
+#endif
+
 #include <assert.h>
+#include <errno.h>
+#ifdef CONFIG_HAVE_IRQ_STATS
+#include <stdio.h>
+#include <string.h>
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Local definitions
+ *------------------------------------------------------------------------------*/
+
+#ifdef CONFIG_HAVE_IRQ_STATS
+
+/** Maximum dispatch nesting depth accounted, one per AIC priority level */
+#define IRQ_STATS_MAX_NESTING 8
+
+#define IRQ_STATS_MASK ((uint32_t)((1ull << TC_CHANNEL_SIZE) - 1))
+
+#endif /* CONFIG_HAVE_IRQ_STATS */
 
 /*------------------------------------------------------------------------------
  *         Local types
@@ -53,13 +78,51 @@ struct handler_entry {
 	struct handler_entry* next;
 };
 
+/*
+ * The first handler of a source is stored in the table itself so that the
+ * common case of a single handler per source is dispatched without walking a
+ * list. Additional handlers of shared sources are chained from the pool.
+ */
+struct _irq_source {
+	irq_handler_t handler;
+	void* user_arg;
+	struct handler_entry* shared;
+};
+
 /*------------------------------------------------------------------------------
  *         Local variables
  *------------------------------------------------------------------------------*/
 
-static struct handler_entry  handlers_pool[ID_PERIPH_COUNT * 2];
-static struct handler_entry* next_free_handler;
-static struct handler_entry* handlers[ID_PERIPH_COUNT];
+MEMPOOL_DECLARE_ALIGNED(_shared_handlers, sizeof(struct handler_entry),
+		IRQ_SHARED_HANDLERS, sizeof(void*));
+static struct _irq_source sources[ID_PERIPH_COUNT];
+
+/** Number of handlers being dispatched, nested ones included */
+static volatile uint32_t _irq_depth;
+
+#ifdef CONFIG_HAVE_IRQ_STATS
+
+static struct {
+	Tc* tc;
+	uint8_t channel;
+	uint32_t freq;
+	const volatile uint32_t* cv;  /* NULL when statistics are disabled */
+
+	/* dispatch nesting */
+	uint32_t depth;
+	uint32_t nested_ticks[IRQ_STATS_MAX_NESTING];
+	uint32_t last_source;
+	uint32_t last_end;
+
+	/* latency probe */
+	uint32_t probe_period;
+	uint32_t probe_next;
+
+	struct _irq_latency latency;
+	struct _irq_stats stats[ID_PERIPH_COUNT];
+} _irq_stats;
+
+#endif /* CONFIG_HAVE_IRQ_STATS */
 
 /*------------------------------------------------------------------------------
  *         Local functions
@@ -67,25 +130,18 @@ static struct handler_entry* handlers[ID_PERIPH_COUNT];
 
 static void _initialize_handlers_pool(void)
 {
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(handlers_pool); i++) {
-		handlers_pool[i].handler = NULL;
-		handlers_pool[i].next = &handlers_pool[i + 1];
-	}
-	handlers_pool[i - 1].next = NULL;
-
-	next_free_handler = &handlers_pool[0];
+	mempool_init(&_shared_handlers, _shared_handlers_storage,
+		MEMPOOL_BLOCK_SIZE(sizeof(struct handler_entry), sizeof(void*)),
+		IRQ_SHARED_HANDLERS);
 }
 
 static struct handler_entry* _alloc_handler(void)
 {
 	struct handler_entry* entry;
 
-	assert(next_free_handler);
-
-	entry = next_free_handler;
-	next_free_handler = next_free_handler->next;
+	entry = mempool_alloc(&_shared_handlers);
+	if (!entry)
+		return NULL;
 	entry->handler = NULL;
 	entry->user_arg = NULL;
 	entry->next = NULL;
@@ -94,15 +150,98 @@ static struct handler_entry* _alloc_handler(void)
 
 static void _free_handler(struct handler_entry* entry)
 {
-	entry->handler = NULL;
-	entry->next = next_free_handler;
-	next_free_handler = entry;
+	mempool_free(&_shared_handlers, entry);
 }
 
+#ifdef CONFIG_HAVE_IRQ_STATS
+
+static uint32_t _irq_stats_begin(uint32_t* depth)
+{
+	uint32_t flags = arch_irq_save();
+	uint32_t start = *_irq_stats.cv;
+
+	*depth = _irq_stats.depth++;
+	if (*depth < IRQ_STATS_MAX_NESTING)
+		_irq_stats.nested_ticks[*depth] = 0;
+	arch_irq_restore(flags);
+	return start;
+}
+
+static void _irq_stats_end(uint32_t source, uint32_t start, uint32_t depth)
+{
+	uint32_t flags = arch_irq_save();
+	struct _irq_stats* stats = &_irq_stats.stats[source];
+	uint32_t end = *_irq_stats.cv;
+	uint32_t elapsed = (end - start) & IRQ_STATS_MASK;
+	uint32_t service = elapsed;
+
+	/* service time excludes the handlers that preempted this one */
+	if (depth < IRQ_STATS_MAX_NESTING)
+		service -= _irq_stats.nested_ticks[depth];
+	if (depth > 0) {
+		if (depth <= IRQ_STATS_MAX_NESTING)
+			_irq_stats.nested_ticks[depth - 1] += elapsed;
+		stats->nested++;
+	}
+	_irq_stats.depth = depth;
+
+	stats->count++;
+	stats->service_total += service;
+	if (service > stats->service_max)
+		stats->service_max = service;
+
+	_irq_stats.last_source = source;
+	_irq_stats.last_end = end;
+	arch_irq_restore(flags);
+}
+
+static void _irq_stats_probe_handler(uint32_t source, void* user_arg)
+{
+	uint32_t now = *_irq_stats.cv;
+	uint32_t due = _irq_stats.probe_next;
+	uint32_t latency = (now - due) & IRQ_STATS_MASK;
+	uint32_t next;
+
+	tc_get_status(_irq_stats.tc, _irq_stats.channel);
+
+	_irq_stats.latency.count++;
+	if (latency > _irq_stats.latency.max)
+		_irq_stats.latency.max = latency;
+
+	/* Charge the latency to the handler that ended while the probe was
+	 * pending, if any. Otherwise interrupts were masked outside of any
+	 * handler. */
+	if (((_irq_stats.last_end - due) & IRQ_STATS_MASK) <= latency) {
+		struct _irq_stats* stats = &_irq_stats.stats[_irq_stats.last_source];
+		if (latency > stats->latency_max)
+			stats->latency_max = latency;
+	} else if (latency > _irq_stats.latency.masked_max) {
+		_irq_stats.latency.masked_max = latency;
+	}
+
+	/* keep the probe period, unless a whole period was missed */
+	next = (due + _irq_stats.probe_period) & IRQ_STATS_MASK;
+	if (latency >= _irq_stats.probe_period)
+		next = (now + _irq_stats.probe_period) & IRQ_STATS_MASK;
+	_irq_stats.probe_next = next;
+	tc_set_ra_rb_rc(_irq_stats.tc, _irq_stats.channel, NULL, NULL, &next);
+}
+
+static uint32_t _irq_stats_ticks_to_ns(uint64_t ticks)
+{
+	return (uint32_t)((ticks * 1000000000ull) / _irq_stats.freq);
+}
+
+#endif /* CONFIG_HAVE_IRQ_STATS */
+
 static void _default_irq_handler(void)
 {
 	uint32_t source;
+	struct _irq_source* src;
 	struct handler_entry *entry;
+#ifdef CONFIG_HAVE_IRQ_STATS
+	uint32_t start = 0, depth = 0;
+#endif
 
 #if defined(CONFIG_HAVE_AIC2) || defined(CONFIG_HAVE_AIC5)
 	source = aic_get_current_interrupt_source();
@@ -112,17 +251,27 @@ static void _default_irq_handler(void)
 #error Unknown IRQ controller!
 #endif
 
-	entry = handlers[source];
-	if (!entry) {
+	src = &sources[source];
+	if (!src->handler) {
 		// no handler for interrupt, block
 		while (1);
 	}
 
-	while (entry) {
-		if (entry->handler)
-			entry->handler(source, entry->user_arg);
-		entry = entry->next;
-	}
+#ifdef CONFIG_HAVE_IRQ_STATS
+	if (_irq_stats.cv)
+		start = _irq_stats_begin(&depth);
+#endif
+
+	_irq_depth++;
+	src->handler(source, src->user_arg);
+	for (entry = src->shared; entry; entry = entry->next)
+		entry->handler(source, entry->user_arg);
+	_irq_depth--;
+
+#ifdef CONFIG_HAVE_IRQ_STATS
+	if (_irq_stats.cv)
+		_irq_stats_end(source, start, depth);
+#endif
 }
 
 /*----------------------------------------------------------------------------
@@ -164,45 +313,89 @@ void irq_configure_priority(uint32_t source, uint8_t priority)
 #endif
 }
 
-void irq_add_handler(uint32_t source, irq_handler_t handler, void* user_arg)
+int irq_add_handler(uint32_t source, irq_handler_t handler, void* user_arg)
 {
+	struct _irq_source* src = &sources[source];
+	struct handler_entry** pentry;
 	struct handler_entry* entry;
+	uint32_t flags;
+	int err = 0;
+
+	assert(source < ID_PERIPH_COUNT);
+
+	flags = arch_irq_save();
 
 	/* check if handler is already registered */
-	entry = handlers[source];
-	while (entry) {
-		if (entry->handler == handler) {
-			entry->user_arg = user_arg;
-			return;
+	if (src->handler == handler) {
+		src->user_arg = user_arg;
+		goto exit;
+	}
+	for (pentry = &src->shared; *pentry; pentry = &(*pentry)->next) {
+		if ((*pentry)->handler == handler) {
+			(*pentry)->user_arg = user_arg;
+			goto exit;
 		}
-		entry = entry->next;
 	}
 
-	/* add handler to linked list */
+	if (!src->handler) {
+		src->user_arg = user_arg;
+		src->handler = handler;
+		goto exit;
+	}
+
+	/* shared source, append to the list of additional handlers */
 	entry = _alloc_handler();
+	/* Most callers cannot recover: catch the exhausted pool in debug
+	 * builds, the error is still returned otherwise */
+	assert(entry);
+	if (!entry) {
+		err = -ENOMEM;
+		goto exit;
+	}
 	entry->handler = handler;
 	entry->user_arg = user_arg;
-	entry->next = handlers[source];
-	handlers[source] = entry;
+	*pentry = entry;
+
+exit:
+	arch_irq_restore(flags);
+	return err;
 }
 
 void irq_remove_handler(uint32_t source, irq_handler_t handler)
 {
-	struct handler_entry* prev;
-	struct handler_entry* cur;
-
-	/* remove handler from linked list */
-	prev = NULL;
-	cur = handlers[source];
-	while (cur) {
-		if (cur->handler == handler) {
-			if (prev)
-				prev->next = cur->next;
-			_free_handler(cur);
-			return;
+	struct _irq_source* src = &sources[source];
+	struct handler_entry** pentry;
+	struct handler_entry* entry;
+	uint32_t flags;
+
+	assert(source < ID_PERIPH_COUNT);
+
+	flags = arch_irq_save();
+
+	if (src->handler == handler) {
+		/* promote the next shared handler, if any */
+		entry = src->shared;
+		if (entry) {
+			src->handler = entry->handler;
+			src->user_arg = entry->user_arg;
+			src->shared = entry->next;
+			_free_handler(entry);
+		} else {
+			src->handler = NULL;
+			src->user_arg = NULL;
+		}
+	} else {
+		for (pentry = &src->shared; *pentry; pentry = &(*pentry)->next) {
+			entry = *pentry;
+			if (entry->handler == handler) {
+				*pentry = entry->next;
+				_free_handler(entry);
+				break;
+			}
 		}
-		cur = cur->next;
 	}
+
+	arch_irq_restore(flags);
 }
 
 void irq_enable(uint32_t source)
@@ -226,3 +419,158 @@ void irq_disable(uint32_t source)
 #error Unknown IRQ controller!
 #endif
 }
+
+bool irq_is_in_handler(void)
+{
+	return _irq_depth != 0;
+}
+
+#ifdef CONFIG_HAVE_IRQ_STATS
+
+int irq_stats_enable(Tc* tc, uint8_t channel, uint32_t probe_period)
+{
+	uint32_t tc_id = get_tc_id_from_addr(tc, channel);
+	uint32_t clock_source;
+	uint32_t rc;
+	int err;
+
+	irq_stats_disable();
+
+	if (!pmc_is_peripheral_enabled(tc_id))
+		pmc_configure_peripheral(tc_id, NULL, true);
+
+	/* free running counter at the highest available frequency */
+	clock_source = tc_find_best_clock_source(tc, channel, UINT32_MAX);
+	tc_configure(tc, channel, TC_CMR_WAVE | TC_CMR_WAVSEL_UP | clock_source);
+	_irq_stats.tc = tc;
+	_irq_stats.channel = channel;
+	_irq_stats.freq = tc_get_channel_freq(tc, channel);
+	irq_stats_reset();
+
+	if (probe_period) {
+		_irq_stats.probe_period = (uint32_t)(((uint64_t)probe_period * _irq_stats.freq) / 1000000);
+		if (_irq_stats.probe_period == 0 ||
+		    _irq_stats.probe_period > IRQ_STATS_MASK / 2) {
+			_irq_stats.probe_period = 0;
+			_irq_stats.tc = NULL;
+			return -EINVAL;
+		}
+		err = irq_add_handler(tc_id, _irq_stats_probe_handler, NULL);
+		if (err < 0) {
+			_irq_stats.probe_period = 0;
+			_irq_stats.tc = NULL;
+			return err;
+		}
+	}
+
+	tc_start(tc, channel);
+	_irq_stats.cv = &tc->TC_CHANNEL[channel].TC_CV;
+
+	if (probe_period) {
+		rc = (*_irq_stats.cv + _irq_stats.probe_period) & IRQ_STATS_MASK;
+		_irq_stats.probe_next = rc;
+		tc_set_ra_rb_rc(tc, channel, NULL, NULL, &rc);
+		tc_get_status(tc, channel);
+		tc_enable_it(tc, channel, TC_IER_CPCS);
+		irq_enable(tc_id);
+	}
+
+	return 0;
+}
+
+void irq_stats_disable(void)
+{
+	uint32_t tc_id;
+
+	if (!_irq_stats.tc)
+		return;
+
+	tc_id = get_tc_id_from_addr(_irq_stats.tc, _irq_stats.channel);
+	_irq_stats.cv = NULL;
+	if (_irq_stats.probe_period) {
+		tc_disable_it(_irq_stats.tc, _irq_stats.channel, TC_IDR_CPCS);
+		irq_remove_handler(tc_id, _irq_stats_probe_handler);
+		_irq_stats.probe_period = 0;
+	}
+	tc_stop(_irq_stats.tc, _irq_stats.channel);
+	_irq_stats.tc = NULL;
+}
+
+void irq_stats_reset(void)
+{
+	uint32_t flags = arch_irq_save();
+
+	memset(&_irq_stats.latency, 0, sizeof(_irq_stats.latency));
+	memset(_irq_stats.stats, 0, sizeof(_irq_stats.stats));
+	_irq_stats.last_end = 0;
+	arch_irq_restore(flags);
+}
+
+uint32_t irq_stats_get_freq(void)
+{
+	return _irq_stats.freq;
+}
+
+void irq_stats_get(uint32_t source, struct _irq_stats* stats)
+{
+	uint32_t flags;
+
+	assert(source < ID_PERIPH_COUNT);
+
+	flags = arch_irq_save();
+	*stats = _irq_stats.stats[source];
+	arch_irq_restore(flags);
+}
+
+void irq_stats_get_latency(struct _irq_latency* latency)
+{
+	uint32_t flags = arch_irq_save();
+	*latency = _irq_stats.latency;
+	arch_irq_restore(flags);
+}
+
+void irq_stats_dump(uint32_t count)
+{
+	const struct _irq_stats* stats = _irq_stats.stats;
+	struct _irq_latency latency;
+	uint8_t order[ID_PERIPH_COUNT];
+	uint32_t i, j;
+	uint8_t tmp;
+
+	if (!_irq_stats.freq)
+		return;
+
+	/* sort the sources by decreasing worst service time */
+	for (i = 0; i < ID_PERIPH_COUNT; i++) {
+		order[i] = i;
+		for (j = i; j > 0 && stats[order[j]].service_max > stats[order[j - 1]].service_max; j--) {
+			tmp = order[j];
+			order[j] = order[j - 1];
+			order[j - 1] = tmp;
+		}
+	}
+
+	printf("IRQ statistics, times in ns (timer at %u Hz)\r\n",
+	       (unsigned)_irq_stats.freq);
+	printf("  ID      count   nested   avg svc   max svc  max lat\r\n");
+	for (i = 0; i < ID_PERIPH_COUNT && i < count; i++) {
+		struct _irq_stats s;
+		irq_stats_get(order[i], &s);
+		if (!s.count)
+			break;
+		printf("  %2u %10u %8u %9u %9u %8u\r\n", (unsigned)order[i],
+		       (unsigned)s.count, (unsigned)s.nested,
+		       (unsigned)_irq_stats_ticks_to_ns(s.service_total / s.count),
+		       (unsigned)_irq_stats_ticks_to_ns(s.service_max),
+		       (unsigned)_irq_stats_ticks_to_ns(s.latency_max));
+	}
+
+	irq_stats_get_latency(&latency);
+	if (latency.count)
+		printf("Probe: %u samples, max latency %u ns, max with IRQs masked %u ns\r\n",
+		       (unsigned)latency.count,
+		       (unsigned)_irq_stats_ticks_to_ns(latency.max),
+		       (unsigned)_irq_stats_ticks_to_ns(latency.masked_max));
+}
+
+#endif /* CONFIG_HAVE_IRQ_STATS */
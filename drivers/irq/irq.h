@@ -34,8 +34,13 @@
  *         Headers
  *------------------------------------------------------------------------------*/
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#ifdef CONFIG_HAVE_IRQ_STATS
+#include "chip.h"
+#endif
+
 typedef void (*irq_handler_t)(uint32_t source, void* user_arg);
 
 enum _irq_mode {
@@ -45,6 +50,31 @@ enum _irq_mode {
 	IRQ_MODE_NEGATIVE_EDGE,
 };
 
+/** Number of additional handlers that can be chained on shared sources */
+#ifndef IRQ_SHARED_HANDLERS
+#define IRQ_SHARED_HANDLERS 16
+#endif
+
+#ifdef CONFIG_HAVE_IRQ_STATS
+
+/** Per-source statistics, times in ticks of the statistics timer */
+struct _irq_stats {
+	uint32_t count;          /**< number of dispatches */
+	uint32_t nested;         /**< dispatches that preempted another handler */
+	uint64_t service_total;  /**< total time in the handlers */
+	uint32_t service_max;    /**< worst time in the handlers */
+	uint32_t latency_max;    /**< worst probe latency caused by the source */
+};
+
+/** Entry latency measured by the probe, in ticks of the statistics timer */
+struct _irq_latency {
+	uint32_t count;          /**< number of probe interrupts */
+	uint32_t max;            /**< worst latency */
+	uint32_t masked_max;     /**< worst latency not caused by a handler */
+};
+
+#endif /* CONFIG_HAVE_IRQ_STATS */
+
 /*------------------------------------------------------------------------------
  *         Global functions
  *------------------------------------------------------------------------------*/
@@ -82,14 +112,21 @@ extern void irq_configure_priority(uint32_t source, uint8_t priority);
 /**
  * \brief Add a handler for a given interrupt source (ID_xxx).
  *
- * If the handler is already configured for the interrupt source, this function
- * does nothing.
+ * If the handler is already configured for the interrupt source, only its
+ * user argument is updated. The first handler of a source is dispatched
+ * directly, the handlers added next share the source and are called after
+ * it, in registration order.
+ *
+ * Handlers run with interrupts unmasked at core level: on the AIC, sources
+ * with a higher priority (see irq_configure_priority()) preempt them.
  *
  * \param source   Interrupt source to configure
  * \param handler  Handler for the interrupt
  * \param user_arg User argument for the interrupt
+ * \return 0 on success, -ENOMEM if no entry is left for a shared handler
+ * (this also fails an assertion in debug builds)
  */
-extern void irq_add_handler(uint32_t source, irq_handler_t handler, void* user_arg);
+extern int irq_add_handler(uint32_t source, irq_handler_t handler, void* user_arg);
 
 /**
  * \brief Add a handler for a given interrupt source (ID_xxx).
@@ -116,6 +153,68 @@ extern void irq_enable(uint32_t source);
  */
 extern void irq_disable(uint32_t source);
 
+/**
+ * \brief Check if the caller runs from an interrupt handler.
+ *
+ * Code running from a handler cannot wait for an interrupt of the same or
+ * lower priority.
+ */
+extern bool irq_is_in_handler(void);
+
+#ifdef CONFIG_HAVE_IRQ_STATS
+
+/**
+ * \brief Start collecting interrupt statistics.
+ *
+ * The given TC channel is used as a free-running time base to measure the
+ * service time of every dispatch, excluding the handlers that preempted it.
+ *
+ * If probe_period is not 0, the channel RC compare also raises an interrupt
+ * every probe_period microseconds. The delay between the compare and its
+ * handler is the entry latency at the priority of the TC source. It is
+ * charged to the source whose handler ended while the probe was pending, or
+ * to masked sections outside of handlers.
+ *
+ * \param tc           TC instance, used exclusively
+ * \param channel      TC channel
+ * \param probe_period Latency probe period in microseconds, 0 to disable
+ * \return 0 on success, a negative error code otherwise
+ */
+extern int irq_stats_enable(Tc* tc, uint8_t channel, uint32_t probe_period);
+
+/**
+ * \brief Stop collecting interrupt statistics and stop the TC channel.
+ */
+extern void irq_stats_disable(void);
+
+/**
+ * \brief Clear all the interrupt statistics.
+ */
+extern void irq_stats_reset(void);
+
+/**
+ * \brief Frequency of the ticks used in the statistics, in Hz.
+ */
+extern uint32_t irq_stats_get_freq(void);
+
+/**
+ * \brief Get the statistics of an interrupt source.
+ */
+extern void irq_stats_get(uint32_t source, struct _irq_stats* stats);
+
+/**
+ * \brief Get the entry latency measured by the probe.
+ */
+extern void irq_stats_get_latency(struct _irq_latency* latency);
+
+/**
+ * \brief Print the sources with the worst service times.
+ * \param count Maximum number of sources to print
+ */
+extern void irq_stats_dump(uint32_t count);
+
+#endif /* CONFIG_HAVE_IRQ_STATS */
+
 #ifdef __cplusplus
 }
 #endif
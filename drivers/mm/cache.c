@@ -37,6 +37,176 @@
 #include "mm/l1cache.h"
 #include "mm/l2cache.h"
 
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define CACHE_LINE_MASK (L1_CACHE_BYTES - 1)
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+enum _cache_op {
+	CACHE_OP_NONE,
+	CACHE_OP_CLEAN,
+	CACHE_OP_INVALIDATE,
+	CACHE_OP_CLEAN_INVALIDATE,
+};
+
+/** Maintenance operations of one cache level */
+struct _cache_level {
+	void (*clean)(uint32_t start, uint32_t end);
+	void (*invalidate)(uint32_t start, uint32_t end);
+	void (*clean_invalidate)(uint32_t start, uint32_t end);
+	void (*sync)(void);
+	void (*clean_all)(void);
+	void (*clean_invalidate_all)(void);
+	uint32_t threshold;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+#ifdef CONFIG_HAVE_L1CACHE
+static struct _cache_level _l1 = {
+	.clean = dcache_clean_lines,
+	.invalidate = dcache_invalidate_lines,
+	.clean_invalidate = dcache_clean_invalidate_lines,
+	.sync = dcache_sync,
+	.clean_all = dcache_clean,
+	.clean_invalidate_all = dcache_clean_invalidate,
+	.threshold = L1_CACHE_WAYS * L1_CACHE_SETS * L1_CACHE_BYTES,
+};
+#endif
+
+#ifdef CONFIG_HAVE_L2CACHE
+static struct _cache_level _l2 = {
+	.clean = l2cache_clean_region,
+	.invalidate = l2cache_invalidate_region,
+	.clean_invalidate = l2cache_clean_invalidate_region,
+	.sync = l2cache_sync,
+	.clean_all = l2cache_clean,
+	.clean_invalidate_all = l2cache_clean_invalidate,
+	.threshold = CACHE_DMA_L2_THRESHOLD,
+};
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+#ifdef CONFIG_HAVE_L1CACHE
+
+static enum _cache_op _cache_dma_op(enum _cache_dma_dir dir, bool map)
+{
+	switch (dir) {
+	case CACHE_DMA_TO_DEVICE:
+		return map ? CACHE_OP_CLEAN : CACHE_OP_NONE;
+	case CACHE_DMA_FROM_DEVICE:
+		return CACHE_OP_INVALIDATE;
+	case CACHE_DMA_BIDIRECTIONAL:
+		return map ? CACHE_OP_CLEAN_INVALIDATE : CACHE_OP_INVALIDATE;
+	default:
+		return CACHE_OP_NONE;
+	}
+}
+
+static void _cache_dma_lines(const struct _cache_level* level,
+		enum _cache_op op, uint32_t start, uint32_t end, bool map)
+{
+	switch (op) {
+	case CACHE_OP_CLEAN:
+		level->clean(start, end);
+		break;
+	case CACHE_OP_CLEAN_INVALIDATE:
+		level->clean_invalidate(start, end);
+		break;
+	case CACHE_OP_INVALIDATE:
+		if (map) {
+			/* keep the data sharing the partial lines */
+			if (start & CACHE_LINE_MASK) {
+				level->clean_invalidate(start, start + 1);
+				start = (start | CACHE_LINE_MASK) + 1;
+			}
+			if ((end & CACHE_LINE_MASK) && start < end) {
+				level->clean_invalidate(end & ~CACHE_LINE_MASK, end);
+				end &= ~CACHE_LINE_MASK;
+			}
+		}
+		if (start < end)
+			level->invalidate(start, end);
+		break;
+	default:
+		break;
+	}
+}
+
+static void _cache_dma_level(const struct _cache_level* level,
+		const struct _cache_dma_batch* batch, bool map)
+{
+	enum _cache_op op;
+	uint32_t i, length = 0;
+	bool clean_only = true;
+
+	for (i = 0; i < batch->count; i++) {
+		op = _cache_dma_op(batch->regions[i].dir, map);
+		if (op == CACHE_OP_NONE)
+			continue;
+		length += batch->regions[i].end - batch->regions[i].start;
+		if (op != CACHE_OP_CLEAN)
+			clean_only = false;
+	}
+	if (length == 0)
+		return;
+
+	/* Above the threshold, going through the whole cache is cheaper. The
+	 * lines are never only invalidated there, since other data may be
+	 * dirty. The whole-cache functions include their own barrier. */
+	if (length >= level->threshold) {
+		if (clean_only)
+			level->clean_all();
+		else
+			level->clean_invalidate_all();
+		return;
+	}
+
+	for (i = 0; i < batch->count; i++) {
+		op = _cache_dma_op(batch->regions[i].dir, map);
+		_cache_dma_lines(level, op, batch->regions[i].start,
+				batch->regions[i].end, map);
+	}
+	level->sync();
+}
+
+#endif /* CONFIG_HAVE_L1CACHE */
+
+static void _cache_dma_batch_sync(const struct _cache_dma_batch* batch, bool map)
+{
+#ifdef CONFIG_HAVE_L1CACHE
+	if (!dcache_is_enabled())
+		return;
+
+	/* Clean from the inner to the outer level. Invalidate after the
+	 * transfer from the outer to the inner level, so that the L1 cache is
+	 * not refilled from stale L2 lines. */
+#ifdef CONFIG_HAVE_L2CACHE
+	if (!map && l2cache_is_enabled())
+		_cache_dma_level(&_l2, batch, map);
+#endif
+	_cache_dma_level(&_l1, batch, map);
+#ifdef CONFIG_HAVE_L2CACHE
+	if (map && l2cache_is_enabled())
+		_cache_dma_level(&_l2, batch, map);
+#endif
+#endif /* CONFIG_HAVE_L1CACHE */
+}
+
 /*----------------------------------------------------------------------------
  *        Functions
  *----------------------------------------------------------------------------*/
@@ -72,3 +242,68 @@ void cache_clean_region(const void *start, uint32_t length)
 	}
 #endif /* CONFIG_HAVE_L1CACHE */
 }
+
+void cache_dma_set_thresholds(uint32_t l1, uint32_t l2)
+{
+#ifdef CONFIG_HAVE_L1CACHE
+	_l1.threshold = l1;
+#endif
+#ifdef CONFIG_HAVE_L2CACHE
+	_l2.threshold = l2;
+#endif
+}
+
+void cache_dma_batch_init(struct _cache_dma_batch *batch)
+{
+	batch->count = 0;
+}
+
+int cache_dma_batch_add(struct _cache_dma_batch *batch,
+		const void *start, uint32_t length, enum _cache_dma_dir dir)
+{
+	/* a device write to a partial line would be lost or would corrupt the
+	 * data sharing the line */
+	assert(dir == CACHE_DMA_TO_DEVICE ||
+	       (IS_CACHE_ALIGNED(start) && IS_CACHE_ALIGNED(length)));
+
+	if (length == 0)
+		return 0;
+	if (batch->count >= CACHE_DMA_BATCH_SIZE)
+		return -ENOSPC;
+
+	batch->regions[batch->count].start = (uint32_t)start;
+	batch->regions[batch->count].end = (uint32_t)start + length;
+	batch->regions[batch->count].dir = dir;
+	batch->count++;
+	return 0;
+}
+
+void cache_dma_batch_map_for_device(const struct _cache_dma_batch *batch)
+{
+	_cache_dma_batch_sync(batch, true);
+}
+
+void cache_dma_batch_unmap_for_cpu(const struct _cache_dma_batch *batch)
+{
+	_cache_dma_batch_sync(batch, false);
+}
+
+void cache_dma_map_for_device(const void *start, uint32_t length,
+		enum _cache_dma_dir dir)
+{
+	struct _cache_dma_batch batch;
+
+	batch.count = 0;
+	cache_dma_batch_add(&batch, start, length, dir);
+	_cache_dma_batch_sync(&batch, true);
+}
+
+void cache_dma_unmap_for_cpu(void *start, uint32_t length,
+		enum _cache_dma_dir dir)
+{
+	struct _cache_dma_batch batch;
+
+	batch.count = 0;
+	cache_dma_batch_add(&batch, start, length, dir);
+	_cache_dma_batch_sync(&batch, false);
+}
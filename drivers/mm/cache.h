@@ -44,6 +44,14 @@
  * address on a cache line.  Since these sections will contain only cache
  * aligned variables, we can be certain that flushing/invalidating any variable
  * in these regions will not flush/invalidate more than expected.
+ *
+ * The cache_dma_xxx functions maintain the caches around DMA transfers. A
+ * buffer is handed to the device with cache_dma_map_for_device() before the
+ * transfer is started, and back to the CPU with cache_dma_unmap_for_cpu()
+ * once it is complete. The CPU must not access the buffer in between. Large
+ * regions are maintained with whole-cache operations instead of line by line,
+ * and several regions can be grouped in a struct _cache_dma_batch so that
+ * they share a single barrier sequence.
  */
 
 #ifndef CACHE_H_
@@ -103,6 +111,39 @@
  */
 #define IS_CACHE_ALIGNED(x) ((((uint32_t)(x)) & (L1_CACHE_BYTES - 1)) == 0)
 
+/**
+ * Default size from which the L2 cache is maintained with whole-cache
+ * operations by the DMA functions, see cache_dma_set_thresholds()
+ */
+#ifndef CACHE_DMA_L2_THRESHOLD
+#define CACHE_DMA_L2_THRESHOLD (64 * 1024)
+#endif
+
+/**
+ * Maximum number of regions in a struct _cache_dma_batch
+ */
+#define CACHE_DMA_BATCH_SIZE 8
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Direction of a DMA transfer, seen from the memory */
+enum _cache_dma_dir {
+	CACHE_DMA_TO_DEVICE,      /**< the device reads the buffer */
+	CACHE_DMA_FROM_DEVICE,    /**< the device writes the buffer */
+	CACHE_DMA_BIDIRECTIONAL,  /**< the device reads and writes the buffer */
+};
+
+struct _cache_dma_batch {
+	uint32_t count;
+	struct {
+		uint32_t start;
+		uint32_t end;
+		enum _cache_dma_dir dir;
+	} regions[CACHE_DMA_BATCH_SIZE];
+};
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -123,4 +164,66 @@ extern void cache_invalidate_region(void *start, uint32_t length);
  */
 extern void cache_clean_region(const void *start, uint32_t length);
 
+/**
+ *  \brief Hand a buffer to a device before a DMA transfer.
+ *
+ *  The buffer is cleaned if the device reads it and invalidated if the device
+ *  writes it. Buffers written by the device must start and end on a cache
+ *  line, this is checked in debug builds. In release builds, the partial
+ *  lines are cleaned to preserve the data that shares them.
+ *
+ *  \param start Beginning of the buffer
+ *  \param length Length of the buffer
+ *  \param dir Direction of the transfer
+ */
+extern void cache_dma_map_for_device(const void *start, uint32_t length,
+		enum _cache_dma_dir dir);
+
+/**
+ *  \brief Hand a buffer back to the CPU after a DMA transfer.
+ *
+ *  The buffer is invalidated if the device wrote it, to drop the lines
+ *  speculatively loaded during the transfer. Nothing is done otherwise.
+ *
+ *  \param start Beginning of the buffer
+ *  \param length Length of the buffer
+ *  \param dir Direction of the transfer, as given to the map function
+ */
+extern void cache_dma_unmap_for_cpu(void *start, uint32_t length,
+		enum _cache_dma_dir dir);
+
+/**
+ *  \brief Set the sizes from which the DMA functions switch from maintenance
+ *  by line to whole-cache operations.
+ *
+ *  The defaults are the size of the L1 cache and CACHE_DMA_L2_THRESHOLD.
+ *
+ *  \param l1 Threshold for the L1 cache, in bytes
+ *  \param l2 Threshold for the L2 cache, in bytes
+ */
+extern void cache_dma_set_thresholds(uint32_t l1, uint32_t l2);
+
+/**
+ *  \brief Empty a batch of DMA buffers.
+ */
+extern void cache_dma_batch_init(struct _cache_dma_batch *batch);
+
+/**
+ *  \brief Add a buffer to a batch, see cache_dma_map_for_device().
+ *
+ *  \return 0 on success, -ENOSPC if the batch is full
+ */
+extern int cache_dma_batch_add(struct _cache_dma_batch *batch,
+		const void *start, uint32_t length, enum _cache_dma_dir dir);
+
+/**
+ *  \brief Hand all the buffers of a batch to the devices.
+ */
+extern void cache_dma_batch_map_for_device(const struct _cache_dma_batch *batch);
+
+/**
+ *  \brief Hand all the buffers of a batch back to the CPU.
+ */
+extern void cache_dma_batch_unmap_for_cpu(const struct _cache_dma_batch *batch);
+
 #endif /* #ifndef CACHE_H_ */
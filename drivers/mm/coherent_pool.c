@@ -0,0 +1,108 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "compiler.h"
+#include "irqflags.h"
+
+#include "mm/coherent_pool.h"
+#include "mm/mmu.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+SECTION(".region_ddr") ALIGNED(MMU_PAGE_SIZE)
+static uint8_t _pool[COHERENT_POOL_SIZE];
+
+static uint32_t _pool_used;
+
+static bool _pool_ready;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int coherent_pool_init(void)
+{
+	uint32_t flags;
+	int err = 0;
+
+	if (!_pool_ready) {
+		flags = arch_irq_save();
+		/* Remap once, even if several contexts race for the first
+		 * allocation */
+		if (!_pool_ready) {
+			err = mmu_set_region_attrs((uint32_t)_pool, sizeof(_pool),
+					MMU_ATTR_WRITE_COMBINE);
+			if (err == 0) {
+				_pool_used = 0;
+				_pool_ready = true;
+			}
+		}
+		arch_irq_restore(flags);
+	}
+	return err;
+}
+
+void *coherent_alloc(uint32_t size, uint32_t align)
+{
+	uint32_t flags, offset;
+	void *ptr = NULL;
+
+	if (align < sizeof(uint32_t))
+		align = sizeof(uint32_t);
+	assert((align & (align - 1)) == 0);
+
+	if (coherent_pool_init() < 0)
+		return NULL;
+
+	flags = arch_irq_save();
+	offset = (_pool_used + align - 1) & ~(align - 1);
+	if (offset >= _pool_used && offset <= sizeof(_pool) &&
+	    size <= sizeof(_pool) - offset) {
+		ptr = &_pool[offset];
+		_pool_used = offset + size;
+	}
+	arch_irq_restore(flags);
+
+	return ptr;
+}
+
+uint32_t coherent_pool_get_free(void)
+{
+	return sizeof(_pool) - _pool_used;
+}
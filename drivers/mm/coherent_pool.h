@@ -0,0 +1,89 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef COHERENT_POOL_H_
+#define COHERENT_POOL_H_
+
+#ifdef CONFIG_HAVE_MMU
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * Size of the coherent pool, multiple of MMU_PAGE_SIZE. The pool is placed in
+ * DDR and remapped as MMU_ATTR_WRITE_COMBINE on first use.
+ */
+#ifndef COHERENT_POOL_SIZE
+#define COHERENT_POOL_SIZE (64 * 1024)
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Remap the coherent pool as normal non-cacheable memory.
+ *
+ * Called by the first coherent_alloc(), may be called earlier to move the
+ * cost of the remapping out of driver initialization. The pool is remapped
+ * only once, even when called concurrently.
+ *
+ * \return 0 on success, a negative error code from mmu_set_region_attrs()
+ * otherwise.
+ */
+extern int coherent_pool_init(void);
+
+/**
+ * \brief Allocate memory shared with DMA masters, such as descriptors.
+ *
+ * The memory is neither cached nor freed: no cache maintenance is needed
+ * when handing it to a device, only a dsb() to drain the write buffer.
+ * Intended for buffers allocated once at driver initialization.
+ *
+ * \param size  Size of the allocation in bytes
+ * \param align  Alignment in bytes, power of two (0 for word alignment)
+ * \return a pointer to the allocated memory or NULL if the pool is exhausted.
+ */
+extern void *coherent_alloc(uint32_t size, uint32_t align);
+
+/**
+ * \brief Get the number of bytes left in the coherent pool.
+ */
+extern uint32_t coherent_pool_get_free(void);
+
+#endif /* CONFIG_HAVE_MMU */
+
+#endif /* COHERENT_POOL_H_ */
@@ -121,6 +121,35 @@ extern void dcache_clean_region(uint32_t start, uint32_t end);
  */
 extern void dcache_clean_invalidate_region(uint32_t start, uint32_t end);
 
+/**
+ * \brief Invalidate the data cache lines of the specified region, without
+ * barrier.  dcache_sync() must be called before the region is used.
+ * \param start virtual start address of region
+ * \param end virtual end address of region
+ */
+extern void dcache_invalidate_lines(uint32_t start, uint32_t end);
+
+/**
+ * \brief Clean the data cache lines of the specified region, without
+ * barrier.  dcache_sync() must be called before the region is used.
+ * \param start virtual start address of region
+ * \param end virtual end address of region
+ */
+extern void dcache_clean_lines(uint32_t start, uint32_t end);
+
+/**
+ * \brief Clean and invalidate the data cache lines of the specified region,
+ * without barrier.  dcache_sync() must be called before the region is used.
+ * \param start virtual start address of region
+ * \param end virtual end address of region
+ */
+extern void dcache_clean_invalidate_lines(uint32_t start, uint32_t end);
+
+/**
+ * \brief Wait for the completion of the previous data cache line operations.
+ */
+extern void dcache_sync(void);
+
 /**
  * \brief Enable exclusive caching for the L1 cache.
  *
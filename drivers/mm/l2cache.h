@@ -99,6 +99,11 @@ extern void l2cache_clean_region(uint32_t start, uint32_t end);
  */
 extern void l2cache_clean_invalidate_region(uint32_t start, uint32_t end);
 
+/**
+ * \brief Wait for the completion of the previous L2 cache operations.
+ */
+extern void l2cache_sync(void);
+
 /**
  * \brief Enable exclusive caching for the L2 cache.
  *
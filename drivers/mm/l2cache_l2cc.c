@@ -352,11 +352,10 @@ void l2cache_invalidate_region(uint32_t start, uint32_t end)
 	assert(start < end);
 	uint32_t current = start & ~0x1f;
 	if (l2cache_is_enabled()) {
-		while (current <= end) {
+		while (current < end) {
 			l2cc_invalidate_pal(current);
 			current += 32;
 		}
-		l2cc_invalidate_pal(end);
 	}
 }
 
@@ -365,11 +364,10 @@ void l2cache_clean_region(uint32_t start, uint32_t end)
 	assert(start < end);
 	uint32_t current = start & ~0x1f;
 	if (l2cache_is_enabled()) {
-		while (current <= end) {
+		while (current < end) {
 			l2cc_clean_pal(current);
 			current += 32;
 		}
-		l2cc_clean_pal(end);
 	}
 }
 
@@ -378,14 +376,19 @@ void l2cache_clean_invalidate_region(uint32_t start, uint32_t end)
 	assert(start < end);
 	uint32_t current = start & ~0x1f;
 	if (l2cache_is_enabled()) {
-		while (current <= end) {
+		while (current < end) {
 			l2cc_clean_invalidate_pal(current);
 			current += 32;
 		}
-		l2cc_clean_invalidate_pal(end);
 	}
 }
 
+void l2cache_sync(void)
+{
+	if (l2cache_is_enabled())
+		l2cc_cache_sync();
+}
+
 void l2cc_configure(const struct _l2cc_config* cfg)
 {
 	assert(!l2cache_is_enabled());
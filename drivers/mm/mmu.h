@@ -37,6 +37,48 @@
  *----------------------------------------------------------------------------*/
 
 #include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Granularity of the regions handled by mmu_set_region_attrs() */
+#define MMU_PAGE_SIZE    4096
+
+/** Size of the region mapped by a single first-level (section) descriptor */
+#define MMU_SECTION_SIZE 0x100000
+
+/**
+ * Number of second-level page tables (1KB each) available to split sections
+ * into pages. Sections are only split when a region does not start or end on
+ * a section boundary.
+ */
+#ifndef MMU_PAGE_TABLES
+#define MMU_PAGE_TABLES  8
+#endif
+
+/** Memory attributes applied by mmu_set_region_attrs() */
+enum _mmu_attr {
+	/** Normal memory, write-back cacheable, executable */
+	MMU_ATTR_CACHED,
+
+	/**
+	 * Normal memory, non-cacheable and bufferable: writes are buffered
+	 * and merged (write-combining). Suitable for framebuffers and DMA
+	 * descriptors; issue dsb() before handing the data to a device.
+	 */
+	MMU_ATTR_WRITE_COMBINE,
+
+	/** Device memory, non-cacheable and bufferable, never executed */
+	MMU_ATTR_DEVICE,
+
+	/** Strongly-ordered memory, never executed */
+	MMU_ATTR_STRONGLY_ORDERED,
+
+	/** No access: any access aborts (guard pages) */
+	MMU_ATTR_NO_ACCESS,
+};
 
 /*----------------------------------------------------------------------------
  *        Exported functions
@@ -62,6 +104,25 @@ extern void mmu_enable(void);
  */
 extern void mmu_disable(void);
 
+/**
+ * \brief Change the memory attributes of an identity-mapped region.
+ *
+ * The translation table given to mmu_configure() is updated in place:
+ * sections fully covered by the region are rewritten, partially covered
+ * sections are split into 4KB pages using one of the MMU_PAGE_TABLES
+ * second-level tables. Cached data of the region is written back and
+ * invalidated before the attributes change, and the TLBs are invalidated
+ * afterwards. The update is done with interrupts masked.
+ *
+ * \param start  Start address of the region, aligned on MMU_PAGE_SIZE
+ * \param size  Size of the region, multiple of MMU_PAGE_SIZE
+ * \param attr  New memory attributes
+ * \return 0 on success, -EINVAL if the region is not page-aligned or the MMU
+ * has not been configured, -ENOMEM if no second-level table is left.
+ */
+extern int mmu_set_region_attrs(uint32_t start, uint32_t size,
+		enum _mmu_attr attr);
+
 #endif /* CONFIG_HAVE_MMU */
 
 #endif  /* MMU_H_ */
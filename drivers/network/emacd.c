@@ -165,6 +165,7 @@ static void _emacd_tx_complete_handler(struct _ethd* emacd)
 	struct _ethd_queue* q = &emacd->queues[0];
 	struct _eth_desc *desc;
 	ethd_callback_t callback;
+	uint16_t tail;
 	uint32_t tsr;
 
 	//printf("<TX>\r\n");
@@ -173,8 +174,12 @@ static void _emacd_tx_complete_handler(struct _ethd* emacd)
 	tsr = emac_get_tx_status(emac);
 	emac_clear_tx_status(emac, tsr);
 
-	while (!RING_EMPTY(q->tx_head, q->tx_tail)) {
-		desc = &q->tx_desc[q->tx_tail];
+	tail = q->tx_tail;
+	while (!RING_EMPTY(q->tx_head, tail)) {
+		/* Read the frame after the head that published it, pairs
+		 * with the dmb() of ethd_send_sg() */
+		dmb();
+		desc = &q->tx_desc[tail];
 
 		/* Exit if frame has not been sent yet:
 		 * On TX completion, the EMAC set the USED bit only into the
@@ -187,19 +192,22 @@ static void _emacd_tx_complete_handler(struct _ethd* emacd)
 
 		/* Process all buffers of the current transmitted frame */
 		while ((desc->status & ETH_TX_STATUS_LASTBUF) == 0) {
-			RING_INC(q->tx_tail, q->tx_size);
-			desc = &q->tx_desc[q->tx_tail];
+			RING_INC(tail, q->tx_size);
+			desc = &q->tx_desc[tail];
 		}
 
 		/* Notify upper layer that a frame has been sent */
 		if (q->tx_callbacks) {
-			callback = q->tx_callbacks[q->tx_tail];
+			callback = q->tx_callbacks[tail];
 			if (callback)
 				callback(0, tsr);
 		}
 
-		/* Go to next frame */
-		RING_INC(q->tx_tail, q->tx_size);
+		/* Go to next frame, releasing the slots to ethd_send_sg()
+		 * only once they have been read */
+		RING_INC(tail, q->tx_size);
+		dmb();
+		q->tx_tail = tail;
 	}
 
 	/* If a wakeup callback has been set, notify upper layer that it can
@@ -251,6 +259,9 @@ static void _emacd_tx_error_handler(struct _ethd* emacd)
 	/* Treat frames in TX queue including the ones that caused the error. */
 	while (!RING_EMPTY(q->tx_head, q->tx_tail)) {
 		int tx_completed = 0;
+
+		/* Pairs with the dmb() of ethd_send_sg() */
+		dmb();
 		desc = &q->tx_desc[q->tx_tail];
 
 		/* Check USED bit on the very first buffer descriptor to validate
@@ -131,6 +131,10 @@ uint8_t ethd_send_sg(struct _ethd* ethd, uint8_t queue, const struct _eth_sg_lis
 		return ETH_TX_BUSY;
 	}
 
+	/* Do not reuse the slots before the interrupt handler has read them:
+	 * pairs with the dmb() preceding its tx_tail update */
+	dmb();
+
 	/* Tag end of TX queue */
 	tx_head = fixed_mod(q->tx_head + sgl->size, q->tx_size);
 	idx = tx_head;
@@ -181,7 +185,9 @@ uint8_t ethd_send_sg(struct _ethd* ethd, uint8_t queue, const struct _eth_sg_lis
 		dsb();
 	}
 
-	/* Update TX ring buffer pointers */
+	/* Update TX ring buffer pointers once the descriptors and callbacks
+	 * are written, the interrupt handler reads them after the head */
+	dmb();
 	q->tx_head = tx_head;
 
 	/* Now start to transmit if it is not already done */
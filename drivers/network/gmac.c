@@ -27,6 +27,9 @@
  * ----------------------------------------------------------------------------
  */
 
+/* Runtime trace filtering of this file, see trace_set_module_level() */
+#define TRACE_MODULE TRACE_MODULE_NET
+
 /*----------------------------------------------------------------------------
  *        Headers
  *----------------------------------------------------------------------------*/
@@ -27,6 +27,9 @@
  * ----------------------------------------------------------------------------
  */
 
+/* Runtime trace filtering of this file, see trace_set_module_level() */
+#define TRACE_MODULE TRACE_MODULE_NET
+
 /*---------------------------------------------------------------------------
  *         Headers
  *---------------------------------------------------------------------------*/
@@ -202,6 +205,7 @@ static void _gmacd_tx_complete_handler(struct _ethd* gmacd, uint8_t queue)
 	struct _ethd_queue* q = &gmacd->queues[queue];
 	struct _eth_desc *desc;
 	ethd_callback_t callback;
+	uint16_t tail;
 	uint32_t tsr;
 
 	//printf("<TX>\r\n");
@@ -210,8 +214,12 @@ static void _gmacd_tx_complete_handler(struct _ethd* gmacd, uint8_t queue)
 	tsr = gmac_get_tx_status(gmac);
 	gmac_clear_tx_status(gmac, tsr);
 
-	while (!RING_EMPTY(q->tx_head, q->tx_tail)) {
-		desc = &q->tx_desc[q->tx_tail];
+	tail = q->tx_tail;
+	while (!RING_EMPTY(q->tx_head, tail)) {
+		/* Read the frame after the head that published it, pairs
+		 * with the dmb() of ethd_send_sg() */
+		dmb();
+		desc = &q->tx_desc[tail];
 
 		/* Exit if frame has not been sent yet:
 		 * On TX completion, the GMAC set the USED bit only into the
@@ -224,19 +232,22 @@ static void _gmacd_tx_complete_handler(struct _ethd* gmacd, uint8_t queue)
 
 		/* Process all buffers of the current transmitted frame */
 		while ((desc->status & ETH_TX_STATUS_LASTBUF) == 0) {
-			RING_INC(q->tx_tail, q->tx_size);
-			desc = &q->tx_desc[q->tx_tail];
+			RING_INC(tail, q->tx_size);
+			desc = &q->tx_desc[tail];
 		}
 
 		/* Notify upper layer that a frame has been sent */
 		if (q->tx_callbacks) {
-			callback = q->tx_callbacks[q->tx_tail];
+			callback = q->tx_callbacks[tail];
 			if (callback)
 				callback(queue, tsr);
 		}
 
-		/* Go to next frame */
-		RING_INC(q->tx_tail, q->tx_size);
+		/* Go to next frame, releasing the slots to ethd_send_sg()
+		 * only once they have been read */
+		RING_INC(tail, q->tx_size);
+		dmb();
+		q->tx_tail = tail;
 	}
 
 	/* If a wakeup callback has been set, notify upper layer that it can
@@ -288,6 +299,9 @@ static void _gmacd_tx_error_handler(struct _ethd* gmacd, uint8_t queue)
 	/* Treat frames in TX queue including the ones that caused the error. */
 	while (!RING_EMPTY(q->tx_head, q->tx_tail)) {
 		int tx_completed = 0;
+
+		/* Pairs with the dmb() of ethd_send_sg() */
+		dmb();
 		desc = &q->tx_desc[q->tx_tail];
 
 		/* Check USED bit on the very first buffer descriptor to validate
@@ -39,6 +39,7 @@
 #include "eefc.h"
 #include "errno.h"
 #include "flashd.h"
+#include "heap.h"
 #include "intmath.h"
 #include "mm/cache.h"
 #include "trace.h"
@@ -51,8 +52,6 @@
 #define MAX_PAGE_SIZE 512
 #define MAX_LOCK_REGIONS 128
 
-static uint32_t page_buffer[MAX_PAGE_SIZE / sizeof(uint32_t)];
-
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -278,10 +277,16 @@ int flashd_write(struct _flash* flash, uint32_t addr, const uint8_t* data, uint3
 {
 	int i, rc = 0;
 	uint32_t offset = 0;
+	uint32_t* page_buffer;
 
 	if ((addr + length) > flash->total_size)
 		return -EINVAL;
 
+	/* page buffer from the shared driver region, only held while writing */
+	page_buffer = heap_alloc(flash->page_size, sizeof(uint32_t));
+	if (!page_buffer)
+		return -ENOMEM;
+
 	board_cfg_mpu_for_flash_write();
 
 	while (offset < length) {
@@ -315,5 +320,7 @@ int flashd_write(struct _flash* flash, uint32_t addr, const uint8_t* data, uint3
 
 	board_cfg_mpu_for_flash_read();
 
+	heap_free(page_buffer);
+
 	return rc;
 }
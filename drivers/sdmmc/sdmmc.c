@@ -60,6 +60,9 @@
 # define TRACE_LEVEL 4
 #endif
 
+/* Runtime trace filtering of this file, see trace_set_module_level() */
+#define TRACE_MODULE TRACE_MODULE_SDMMC
+
 /*----------------------------------------------------------------------------
  *        Headers
  *----------------------------------------------------------------------------*/
@@ -51,6 +51,8 @@
 
 static struct _seriald console;
 
+static struct _seriald_tx console_tx;
+
 /*------------------------------------------------------------------------------
  *         Exported functions
  *------------------------------------------------------------------------------*/
@@ -79,6 +81,36 @@ void console_put_string(const char* str)
 	seriald_put_string(&console, (const uint8_t*)str);
 }
 
+void console_put_buffer(const char* buf, uint32_t len)
+{
+	seriald_write(&console, (const uint8_t*)buf, len);
+}
+
+int console_set_tx_buffer(void* buffer, uint32_t size,
+		enum _console_tx_policy policy)
+{
+	enum _seriald_tx_policy tx_policy = policy == CONSOLE_TX_BLOCK ?
+		SERIALD_TX_BLOCK : SERIALD_TX_DROP;
+
+	return seriald_enable_tx_buffer(&console, &console_tx,
+			(uint8_t*)buffer, size, tx_policy);
+}
+
+void console_flush(void)
+{
+	seriald_flush(&console);
+}
+
+void console_panic_flush(void)
+{
+	seriald_panic_flush(&console);
+}
+
+uint32_t console_get_tx_dropped(void)
+{
+	return console.tx ? console.tx->dropped : 0;
+}
+
 bool console_is_tx_empty(void)
 {
 	return seriald_is_tx_empty(&console);
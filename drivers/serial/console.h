@@ -50,6 +50,12 @@ struct _console_cfg {
 	struct _pin rx_pin;
 };
 
+/** Behaviour of the buffered console when its TX ring is full */
+enum _console_tx_policy {
+	CONSOLE_TX_DROP,  /**< discard what does not fit, never wait */
+	CONSOLE_TX_BLOCK, /**< wait for the ring to drain */
+};
+
 /** Handler for character reception using interrupts */
 typedef void (*console_rx_handler_t)(uint8_t received_char);
 
@@ -81,6 +87,46 @@ extern void console_put_char(char c);
  */
 extern void console_put_string(const char* str);
 
+/**
+ * \brief Outputs a buffer on the CONSOLE.
+ *
+ * \note This function is synchronous unless a TX buffer has been set with
+ * console_set_tx_buffer().
+ * \param buf  Data to send.
+ * \param len  Number of bytes to send.
+ */
+extern void console_put_buffer(const char* buf, uint32_t len);
+
+/**
+ * \brief Make CONSOLE output asynchronous: data is copied into a ring buffer
+ * and sent from the peripheral TX interrupt.
+ *
+ * Must be called after console_configure().
+ *
+ * \param buffer  Ring storage, its size must be a power of two.
+ * \param size    Size of the ring in bytes.
+ * \param policy  What to do when the ring is full.
+ * \return 0 on success, a negative error code otherwise.
+ */
+extern int console_set_tx_buffer(void* buffer, uint32_t size,
+		enum _console_tx_policy policy);
+
+/**
+ * \brief Wait until all buffered TX data has been handed to the peripheral.
+ */
+extern void console_flush(void);
+
+/**
+ * \brief Switch the CONSOLE back to polled output and send any buffered
+ * data. Safe to call from fault handlers and with interrupts masked.
+ */
+extern void console_panic_flush(void);
+
+/**
+ * \brief Number of bytes discarded because the TX ring was full.
+ */
+extern uint32_t console_get_tx_dropped(void);
+
 /**
  * \brief Check if any pending TX character has been sent
  */
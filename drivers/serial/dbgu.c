@@ -79,6 +79,16 @@ void dbgu_configure(Dbgu* dbgu, uint32_t mode, uint32_t baudrate)
 	dbgu->DBGU_CR = DBGU_CR_RXEN | DBGU_CR_TXEN;
 }
 
+/**
+ * \brief Return true if a character can be written to the DBGU
+ *
+ * \param Pointer to the DBGU peripheral
+ */
+bool dbgu_is_tx_ready(Dbgu* dbgu)
+{
+	return (dbgu->DBGU_SR & DBGU_SR_TXRDY) != 0;
+}
+
 /**
  * \brief Outputs a character on the DBGU line.
  *
@@ -147,3 +157,12 @@ void dbgu_disable_it(Dbgu* dbgu, uint32_t mode)
 {
 	dbgu->DBGU_IDR = mode;
 }
+
+/**
+ * \brief Return the enabled interrupt bits
+ * \param dbgu  Pointer to the DBGU peripheral.
+ */
+uint32_t dbgu_get_it_mask(Dbgu* dbgu)
+{
+	return dbgu->DBGU_IMR;
+}
@@ -38,7 +38,9 @@
 #include "board.h"
 #include "chip.h"
 #include "gpio/pio.h"
+#include "intmath.h"
 #include "irq/irq.h"
+#include "irqflags.h"
 #ifdef CONFIG_HAVE_L1CACHE
 #include "mm/l1cache.h"
 #endif
@@ -65,22 +67,27 @@
 
 typedef void (*init_handler_t)(void*, uint32_t, uint32_t);
 typedef void (*put_char_handler_t)(void*, uint8_t);
+typedef bool (*tx_ready_handler_t)(void*);
 typedef bool (*tx_empty_handler_t)(void*);
 typedef uint8_t (*get_char_handler_t)(void*);
 typedef bool (*rx_ready_handler_t)(void*);
 typedef void (*enable_it_handler_t)(void*, uint32_t);
 typedef void (*disable_it_handler_t)(void*, uint32_t);
+typedef uint32_t (*get_it_mask_handler_t)(void*);
 
 struct _seriald_ops {
 	uint32_t             mode;
 	uint32_t             rx_int_mask;
+	uint32_t             tx_int_mask;
 	init_handler_t       init;
 	put_char_handler_t   put_char;
+	tx_ready_handler_t   tx_ready;
 	tx_empty_handler_t   tx_empty;
 	get_char_handler_t   get_char;
 	rx_ready_handler_t   rx_ready;
 	enable_it_handler_t  enable_it;
 	disable_it_handler_t disable_it;
+	get_it_mask_handler_t get_it_mask;
 };
 
 /*----------------------------------------------------------------------------
@@ -91,13 +98,16 @@ struct _seriald_ops {
 static const struct _seriald_ops seriald_ops_usart = {
 	.mode = US_MR_CHMODE_NORMAL | US_MR_PAR_NO | US_MR_CHRL_8_BIT,
 	.rx_int_mask = US_IER_RXRDY,
+	.tx_int_mask = US_IER_TXRDY,
 	.init = (init_handler_t)usart_configure,
 	.put_char = (put_char_handler_t)usart_put_char,
+	.tx_ready = (tx_ready_handler_t)usart_is_tx_ready,
 	.tx_empty = (tx_empty_handler_t)usart_is_tx_empty,
 	.get_char = (get_char_handler_t)usart_get_char,
 	.rx_ready = (rx_ready_handler_t)usart_is_rx_ready,
 	.enable_it = (enable_it_handler_t)usart_enable_it,
 	.disable_it = (disable_it_handler_t)usart_disable_it,
+	.get_it_mask = (get_it_mask_handler_t)usart_get_it_mask,
 };
 #endif
 
@@ -105,13 +115,16 @@ static const struct _seriald_ops seriald_ops_usart = {
 static const struct _seriald_ops seriald_ops_uart = {
 	.mode = UART_MR_CHMODE_NORMAL | UART_MR_PAR_NO,
 	.rx_int_mask = UART_IER_RXRDY,
+	.tx_int_mask = UART_IER_TXRDY,
 	.init = (init_handler_t)uart_configure,
 	.put_char = (put_char_handler_t)uart_put_char,
+	.tx_ready = (tx_ready_handler_t)uart_is_tx_ready,
 	.tx_empty = (tx_empty_handler_t)uart_is_tx_empty,
 	.get_char = (get_char_handler_t)uart_get_char,
 	.rx_ready = (rx_ready_handler_t)uart_is_rx_ready,
 	.enable_it = (enable_it_handler_t)uart_enable_it,
 	.disable_it = (disable_it_handler_t)uart_disable_it,
+	.get_it_mask = (get_it_mask_handler_t)uart_get_it_mask,
 };
 #endif
 
@@ -119,13 +132,16 @@ static const struct _seriald_ops seriald_ops_uart = {
 static const struct _seriald_ops seriald_ops_dbgu = {
 	.mode = DBGU_MR_CHMODE_NORM | DBGU_MR_PAR_NONE,
 	.rx_int_mask = DBGU_IER_RXRDY,
+	.tx_int_mask = DBGU_IER_TXRDY,
 	.init = (init_handler_t)dbgu_configure,
 	.put_char = (put_char_handler_t)dbgu_put_char,
+	.tx_ready = (tx_ready_handler_t)dbgu_is_tx_ready,
 	.tx_empty = (tx_empty_handler_t)dbgu_is_tx_empty,
 	.get_char = (get_char_handler_t)dbgu_get_char,
 	.rx_ready = (rx_ready_handler_t)dbgu_is_rx_ready,
 	.enable_it = (enable_it_handler_t)dbgu_enable_it,
 	.disable_it = (disable_it_handler_t)dbgu_disable_it,
+	.get_it_mask = (get_it_mask_handler_t)dbgu_get_it_mask,
 };
 #endif
 
@@ -133,11 +149,101 @@ static const struct _seriald_ops seriald_ops_dbgu = {
  *         Local functions
  *------------------------------------------------------------------------------*/
 
+/**
+ * \brief Send committed characters while the transmitter accepts them,
+ * must be called with interrupts masked: a nested flush would otherwise
+ * send the same characters again
+ * \return true if all committed characters have been sent
+ */
+static bool _seriald_tx_drain(const struct _seriald* serial)
+{
+	struct _seriald_tx* tx = serial->tx;
+	uint32_t tail = tx->tail;
+
+	while (tail != tx->commit && serial->ops->tx_ready(serial->addr)) {
+		serial->ops->put_char(serial->addr, tx->buffer[tail & (tx->size - 1)]);
+		tail++;
+	}
+	tx->tail = tail;
+
+	return tail == tx->commit;
+}
+
+/**
+ * \brief Reserve space in the ring buffer
+ * \return Number of characters reserved, at most len, starting at *start
+ */
+static uint32_t _seriald_tx_reserve(const struct _seriald* serial,
+		uint32_t len, uint32_t* start)
+{
+	struct _seriald_tx* tx = serial->tx;
+	uint32_t flags, avail;
+
+	while (true) {
+		flags = arch_irq_save();
+		avail = tx->size - (tx->head - tx->tail);
+		if (avail) {
+			len = min_u32(len, avail);
+			*start = tx->head;
+			tx->head += len;
+			tx->writers++;
+			arch_irq_restore(flags);
+			return len;
+		}
+
+		if (tx->policy != SERIALD_TX_BLOCK || tx->commit == tx->tail) {
+			/* Full of reservations from preempted writers */
+			arch_irq_restore(flags);
+			return 0;
+		}
+
+		if (flags || irq_is_in_handler()) {
+			/* The UART interrupt may not be able to preempt the
+			 * caller, send from here */
+			while (!serial->ops->tx_ready(serial->addr));
+			_seriald_tx_drain(serial);
+			arch_irq_restore(flags);
+		} else {
+			arch_irq_restore(flags);
+			while (tx->head - tx->tail == tx->size && tx->commit != tx->tail);
+		}
+	}
+}
+
+/**
+ * \brief Make reserved characters available for transmission
+ */
+static void _seriald_tx_commit(const struct _seriald* serial)
+{
+	struct _seriald_tx* tx = serial->tx;
+	uint32_t flags;
+
+	flags = arch_irq_save();
+	if (--tx->writers == 0)
+		tx->commit = tx->head;
+	arch_irq_restore(flags);
+
+	serial->ops->enable_it(serial->addr, serial->ops->tx_int_mask);
+}
+
 static void seriald_handler(uint32_t source, void* user_arg)
 {
 	const struct _seriald* serial = (struct _seriald*)user_arg;
+	uint32_t flags;
 	uint8_t c;
 
+	if (serial->tx) {
+		flags = arch_irq_save();
+		if (_seriald_tx_drain(serial))
+			serial->ops->disable_it(serial->addr, serial->ops->tx_int_mask);
+		arch_irq_restore(flags);
+	}
+
+	/* Leave the received characters to polling readers */
+	if (!serial->rx_handler &&
+	    !(serial->ops->get_it_mask(serial->addr) & serial->ops->rx_int_mask))
+		return;
+
 	if (!seriald_is_rx_ready(serial))
 		return;
 
@@ -205,7 +311,10 @@ void seriald_put_char(const struct _seriald* serial, uint8_t c)
 	if (!serial || !serial->id)
 		return;
 
-	serial->ops->put_char(serial->addr, c);
+	if (serial->tx && !serial->tx->sync)
+		seriald_write(serial, &c, 1);
+	else
+		serial->ops->put_char(serial->addr, c);
 }
 
 void seriald_put_string(const struct _seriald* serial, const uint8_t* str)
@@ -213,18 +322,119 @@ void seriald_put_string(const struct _seriald* serial, const uint8_t* str)
 	if (!serial || !serial->id)
 		return;
 
+	if (serial->tx && !serial->tx->sync) {
+		seriald_write(serial, str, strlen((const char*)str));
+		return;
+	}
+
 	while (*str)
 		serial->ops->put_char(serial->addr, *str++);
 }
 
+uint32_t seriald_write(const struct _seriald* serial, const uint8_t* data,
+		uint32_t len)
+{
+	struct _seriald_tx* tx;
+	uint32_t written = 0;
+	uint32_t start, count, first;
+
+	if (!serial || !serial->id)
+		return 0;
+
+	tx = serial->tx;
+	if (!tx || tx->sync) {
+		for (written = 0; written < len; written++)
+			serial->ops->put_char(serial->addr, data[written]);
+		return written;
+	}
+
+	while (written < len) {
+		count = _seriald_tx_reserve(serial, len - written, &start);
+		if (!count) {
+			uint32_t flags = arch_irq_save();
+			tx->dropped += len - written;
+			arch_irq_restore(flags);
+			break;
+		}
+
+		/* Copy with interrupts enabled, wrapping around the end */
+		start &= tx->size - 1;
+		first = min_u32(count, tx->size - start);
+		memcpy(tx->buffer + start, data + written, first);
+		memcpy(tx->buffer, data + written + first, count - first);
+		written += count;
+
+		_seriald_tx_commit(serial);
+	}
+
+	return written;
+}
+
 bool seriald_is_tx_empty(const struct _seriald* serial)
 {
 	if (!serial || !serial->id)
 		return true;
 
+	if (serial->tx && serial->tx->tail != serial->tx->head)
+		return false;
+
 	return serial->ops->tx_empty(serial->addr);
 }
 
+int seriald_enable_tx_buffer(struct _seriald* serial, struct _seriald_tx* tx,
+		uint8_t* buffer, uint32_t size, enum _seriald_tx_policy policy)
+{
+	if (!serial || !serial->id)
+		return -ENODEV;
+	if (!buffer || !size || (size & (size - 1)))
+		return -EINVAL;
+
+	memset(tx, 0, sizeof(*tx));
+	tx->buffer = buffer;
+	tx->size = size;
+	tx->policy = policy;
+	serial->tx = tx;
+
+	irq_add_handler(serial->id, seriald_handler, (void*)serial);
+	irq_enable(serial->id);
+
+	return 0;
+}
+
+void seriald_flush(const struct _seriald* serial)
+{
+	if (!serial || !serial->id || !serial->tx)
+		return;
+
+	if (arch_irq_is_masked() || irq_is_in_handler()) {
+		/* The interrupt may not be able to run, send from here */
+		uint32_t flags = arch_irq_save();
+		while (!_seriald_tx_drain(serial));
+		arch_irq_restore(flags);
+		return;
+	}
+
+	while (serial->tx->tail != serial->tx->commit);
+}
+
+void seriald_panic_flush(const struct _seriald* serial)
+{
+	struct _seriald_tx* tx;
+	uint32_t flags;
+
+	if (!serial || !serial->id || !serial->tx)
+		return;
+
+	tx = serial->tx;
+	flags = arch_irq_save();
+	serial->ops->disable_it(serial->addr, serial->ops->tx_int_mask);
+	tx->sync = true;
+	/* Reservations interrupted by the fault are sent as they are */
+	while (tx->tail != tx->head)
+		serial->ops->put_char(serial->addr, tx->buffer[tx->tail++ & (tx->size - 1)]);
+	arch_irq_restore(flags);
+}
+
 uint8_t seriald_get_char(const struct _seriald* serial)
 {
 	if (!serial || !serial->id) {
@@ -267,6 +477,9 @@ void seriald_disable_rx_interrupt(const struct _seriald* serial)
 		return;
 
 	serial->ops->disable_it(serial->addr, serial->ops->rx_int_mask);
+	/* The handler also drains buffered transmission */
+	if (serial->tx)
+		return;
 	irq_disable(serial->id);
 	irq_remove_handler(serial->id, seriald_handler);
 }
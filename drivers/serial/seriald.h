@@ -48,12 +48,39 @@ typedef void (*seriald_rx_handler_t)(uint8_t received_char);
 /** Forward declaration of internal structure */
 struct _seriald_ops;
 
+/** Behavior of buffered transmission when the buffer is full */
+enum _seriald_tx_policy {
+	SERIALD_TX_DROP,  /* discard the characters that do not fit */
+	SERIALD_TX_BLOCK, /* wait for the buffer to drain, by polling the
+	                     transmitter when called from an interrupt handler
+	                     or with interrupts masked */
+};
+
+/**
+ * Buffered transmission state. Writers reserve space by moving head and
+ * commit it once copied, characters are sent up to the commit point from
+ * the TXRDY interrupt. Reservations from nested contexts complete in
+ * reverse order, so the commit point moves when the outermost one is done.
+ */
+struct _seriald_tx {
+	uint8_t *buffer;
+	uint32_t size; /* power of 2 */
+	uint8_t policy; /* enum _seriald_tx_policy */
+	volatile bool sync; /* buffering bypassed after a panic flush */
+	volatile uint32_t head; /* reserved by writers */
+	volatile uint32_t commit; /* ready to be sent */
+	volatile uint32_t tail; /* sent */
+	volatile uint32_t writers; /* reservations in progress */
+	volatile uint32_t dropped; /* characters discarded */
+};
+
 /** Serial driver */
 struct _seriald {
 	uint32_t id; /* peripheral identifier */
 	void *addr; /* peripheral address */
 	seriald_rx_handler_t rx_handler; /* rx callback */
 	const struct _seriald_ops* ops; /* low-level operations */
+	struct _seriald_tx* tx; /* buffered transmission, NULL if synchronous */
 };
 
 /* ----------------------------------------------------------------------------
@@ -84,11 +111,49 @@ extern void seriald_put_char(const struct _seriald* seriald, uint8_t c);
  */
 extern void seriald_put_string(const struct _seriald* seriald, const uint8_t* str);
 
+/**
+ * \brief Outputs a buffer on the SERIAL.
+ *
+ * \note This function is synchronous unless buffered transmission is
+ * enabled.
+ * \param data  Characters to send.
+ * \param len   Number of characters.
+ * \return Number of characters sent or buffered.
+ */
+extern uint32_t seriald_write(const struct _seriald* seriald,
+		const uint8_t* data, uint32_t len);
+
 /**
  * \brief Check if any pending TX character has been sent
  */
 extern bool seriald_is_tx_empty(const struct _seriald* seriald);
 
+/**
+ * \brief Enable buffered transmission: characters written to the SERIAL
+ * are copied to a ring buffer, which is drained from the TXRDY interrupt.
+ *
+ * \param tx      Transmission state, must stay valid while in use.
+ * \param buffer  Ring buffer.
+ * \param size    Size of the ring buffer, a power of 2.
+ * \param policy  Behavior when the ring buffer is full.
+ * \return 0 on success, -EINVAL if the size is not a power of 2.
+ */
+extern int seriald_enable_tx_buffer(struct _seriald* seriald,
+		struct _seriald_tx* tx, uint8_t* buffer, uint32_t size,
+		enum _seriald_tx_policy policy);
+
+/**
+ * \brief Wait until all the buffered characters have been sent.
+ */
+extern void seriald_flush(const struct _seriald* seriald);
+
+/**
+ * \brief Send all the buffered characters by polling, with interrupts
+ * masked, and make all further output synchronous. Intended for fault
+ * handlers, when interrupts cannot be relied upon.
+ */
+extern void seriald_panic_flush(const struct _seriald* seriald);
+
 /**
  * \brief Input a character from the SERIAL line.
  *
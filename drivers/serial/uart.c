@@ -101,6 +101,14 @@ void uart_disable_it(Uart* uart, uint32_t mask)
 	uart->UART_IDR = mask;
 }
 
+/* Return the enabled interrupt bits
+ *
+ */
+uint32_t uart_get_it_mask(Uart* uart)
+{
+	return uart->UART_IMR;
+}
+
 /**
  * Return true if a character can be written in UART
  */
@@ -58,6 +58,7 @@ extern void uart_set_transmitter_enabled(Uart* uart, bool enabled);
 extern void uart_set_receiver_enabled (Uart* uart, bool enabled);
 extern void uart_enable_it(Uart* uart, uint32_t mask);
 extern void uart_disable_it(Uart* uart, uint32_t mask);
+extern uint32_t uart_get_it_mask(Uart* uart);
 extern bool uart_is_tx_ready(Uart* uart);
 extern bool uart_is_tx_empty(Uart* uart);
 extern void uart_put_char(Uart* uart, uint8_t c);
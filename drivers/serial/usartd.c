@@ -37,9 +37,12 @@
 
 #include "callback.h"
 #include "chip.h"
+#include "compiler.h"
 #include "dma/dma.h"
+#include "intmath.h"
 #include "io.h"
 #include "irq/irq.h"
+#include "irqflags.h"
 #include "mm/cache.h"
 #include "mutex.h"
 #ifdef CONFIG_HAVE_FLEXCOM
@@ -48,6 +51,7 @@
 #include "peripherals/pmc.h"
 #include "serial/usart.h"
 #include "serial/usartd.h"
+#include "ring.h"
 #include "trace.h"
 
 /*----------------------------------------------------------------------------
@@ -57,6 +61,9 @@
 #define USARTD_ATTRIBUTE_MASK     (0)
 #define USARTD_POLLING_THRESHOLD  16
 
+/* The ring is split in periods, the DMA interrupts at the end of each one */
+#define USARTD_RING_PERIODS       4
+
 static struct _usart_desc *_serial[USART_IFACE_COUNT];
 
 /*----------------------------------------------------------------------------
@@ -146,6 +153,53 @@ static void _usartd_dma_write(uint8_t iface)
 	dma_start_transfer(desc->dma.tx.channel);
 }
 
+/**
+ * \brief Account for the bytes written by the DMA in the ring since last call.
+ * Must be called with interrupts masked. The DMA position is sampled at least
+ * once per period (end of block interrupt), so it cannot lap unnoticed.
+ */
+static void _usartd_rx_ring_update(struct _usart_desc* desc)
+{
+	uint32_t size = desc->ring.size;
+	uint32_t pos, count;
+
+	/* Push the bytes still in the DMA FIFO to memory */
+	dma_fifo_flush(desc->dma.rx.channel);
+	pos = dma_get_cyclic_position(desc->dma.rx.channel) & (size - 1);
+	desc->ring.head += (pos - desc->ring.head) & (size - 1);
+
+	/* As with utils/ring.h, one byte stays free: older data is lost */
+	count = desc->ring.head - desc->ring.tail;
+	if (count > size - 1) {
+		desc->ring.overruns += count - (size - 1);
+		desc->ring.tail = desc->ring.head - (size - 1);
+	}
+}
+
+static void _usartd_rx_ring_event(struct _usart_desc* desc, bool idle)
+{
+	uint32_t flags, count;
+
+	flags = arch_irq_save();
+	_usartd_rx_ring_update(desc);
+	count = desc->ring.head - desc->ring.tail;
+	desc->ring.idle = idle;
+	arch_irq_restore(flags);
+
+	if (count || idle)
+		callback_call(&desc->ring.callback, (void*)count);
+}
+
+static int _usartd_rx_ring_dma_callback(void* arg, void* arg2)
+{
+	uint8_t iface = (uint32_t)arg;
+	assert(iface < USART_IFACE_COUNT);
+
+	_usartd_rx_ring_event(_serial[iface], false);
+
+	return 0;
+}
+
 static void _usartd_handler(uint32_t source, void* user_arg)
 {
 	int iface;
@@ -171,6 +225,20 @@ static void _usartd_handler(uint32_t source, void* user_arg)
 	status = usart_get_masked_status(addr);
 	desc->rx.has_timeout = false;
 
+	if (desc->ring.active) {
+		/* Idle line after a frame: report it and wait for the next one */
+		if (USART_STATUS_TIMEOUT(status)) {
+			addr->US_CR = US_CR_STTTO;
+			_usartd_rx_ring_event(desc, true);
+		}
+		if (status & US_CSR_OVRE) {
+			desc->ring.hw_overruns++;
+			addr->US_CR = US_CR_RSTSTA;
+		}
+		status &= ~(US_CSR_TIMEOUT | US_CSR_RXRDY);
+		_rx_stop = false;
+	}
+
 	if (USART_STATUS_RXRDY(status)) {
 		if (desc->rx.buffer.size) {
 			desc->rx.buffer.data[desc->rx.transferred] = usart_get_char(addr);
@@ -470,3 +538,152 @@ void usartd_wait_tx_transfer(const uint8_t iface)
 	assert(iface < USART_IFACE_COUNT);
 	while (mutex_is_locked(&_serial[iface]->tx.mutex));
 }
+
+uint32_t usartd_start_rx_ring(uint8_t iface, struct _buffer* buf,
+		uint32_t idle_bits, struct _callback* cb)
+{
+	assert(iface < USART_IFACE_COUNT);
+	struct _usart_desc *desc = _serial[iface];
+	struct _callback _cb;
+	struct _dma_transfer_cfg cfg;
+
+	if (!buf || !IS_POWER_OF_TWO(buf->size) ||
+	    buf->size < 2 * USARTD_RING_PERIODS)
+		return USARTD_INVALID_SIZE;
+
+	if (!mutex_try_lock(&desc->rx.mutex))
+		return USARTD_ERROR_LOCK;
+
+	desc->ring.data = buf->data;
+	desc->ring.size = buf->size;
+	desc->ring.head = 0;
+	desc->ring.tail = 0;
+	desc->ring.overruns = 0;
+	desc->ring.hw_overruns = 0;
+	desc->ring.idle = false;
+	callback_copy(&desc->ring.callback, cb);
+
+	cfg.saddr = (void*)&desc->addr->US_RHR;
+	cfg.daddr = buf->data;
+	cfg.len = buf->size;
+	if (dma_configure_cyclic_transfer(desc->dma.rx.channel, &desc->dma.rx.cfg_dma,
+				&cfg, USARTD_RING_PERIODS) < 0) {
+		mutex_unlock(&desc->rx.mutex);
+		return USARTD_ERROR_DMA;
+	}
+	callback_set(&_cb, _usartd_rx_ring_dma_callback, (void*)(uint32_t)iface);
+	dma_set_callback(desc->dma.rx.channel, &_cb);
+
+	if (idle_bits)
+		desc->addr->US_RTOR = US_RTOR_TO(min_u32(idle_bits, US_RTOR_TO_Msk));
+
+	/* Clear errors left by a previous reception */
+	desc->addr->US_CR = US_CR_RSTSTA;
+
+	desc->ring.active = true;
+	dma_start_transfer(desc->dma.rx.channel);
+
+	/* The timeout only starts counting after the next character */
+	usart_start_rx_timeout(desc->addr);
+	usart_enable_it(desc->addr, US_IER_TIMEOUT | US_IER_OVRE);
+
+	return USARTD_SUCCESS;
+}
+
+void usartd_stop_rx_ring(uint8_t iface)
+{
+	assert(iface < USART_IFACE_COUNT);
+	struct _usart_desc *desc = _serial[iface];
+
+	if (!desc->ring.active)
+		return;
+
+	usart_disable_it(desc->addr, US_IDR_TIMEOUT | US_IDR_OVRE);
+	dma_stop_transfer(desc->dma.rx.channel);
+	dma_reset_channel(desc->dma.rx.channel);
+	desc->ring.active = false;
+
+	usart_set_rx_timeout(desc->addr, desc->baudrate, desc->timeout);
+	mutex_unlock(&desc->rx.mutex);
+}
+
+uint32_t usartd_rx_ring_peek(uint8_t iface, uint8_t** data,
+		uint32_t* tail_pos)
+{
+	assert(iface < USART_IFACE_COUNT);
+	struct _usart_desc *desc = _serial[iface];
+	uint32_t flags, head, tail, count;
+
+	if (!desc->ring.active)
+		return 0;
+
+	flags = arch_irq_save();
+	_usartd_rx_ring_update(desc);
+	*tail_pos = desc->ring.tail;
+	head = desc->ring.head & (desc->ring.size - 1);
+	tail = desc->ring.tail & (desc->ring.size - 1);
+	arch_irq_restore(flags);
+
+	count = RING_CNT_TO_END(head, tail, desc->ring.size);
+	*data = desc->ring.data + tail;
+
+	/* The span may belong to a period not completed yet */
+	if (count)
+		cache_invalidate_region(*data, count);
+
+	return count;
+}
+
+uint32_t usartd_rx_ring_consume(uint8_t iface, uint32_t tail, uint32_t len)
+{
+	assert(iface < USART_IFACE_COUNT);
+	struct _usart_desc *desc = _serial[iface];
+	uint32_t flags, status = USARTD_SUCCESS;
+
+	flags = arch_irq_save();
+	if (desc->ring.active)
+		_usartd_rx_ring_update(desc);
+	/* On overrun the update moved the tail past the start of the span,
+	 * the lost bytes being already counted: only release what remains
+	 * of the span, never the bytes received after it */
+	if ((int32_t)(desc->ring.tail - tail) > 0)
+		status = USARTD_ERROR_OVERRUN;
+	len = min_u32(len, desc->ring.head - tail);
+	if ((int32_t)(tail + len - desc->ring.tail) > 0)
+		desc->ring.tail = tail + len;
+	arch_irq_restore(flags);
+
+	return status;
+}
+
+uint32_t usartd_rx_ring_count(uint8_t iface)
+{
+	assert(iface < USART_IFACE_COUNT);
+	struct _usart_desc *desc = _serial[iface];
+	uint32_t flags, count;
+
+	if (!desc->ring.active)
+		return 0;
+
+	flags = arch_irq_save();
+	_usartd_rx_ring_update(desc);
+	count = desc->ring.head - desc->ring.tail;
+	arch_irq_restore(flags);
+
+	return count;
+}
+
+void usartd_rx_ring_get_stats(uint8_t iface, struct _usartd_rx_stats* stats)
+{
+	assert(iface < USART_IFACE_COUNT);
+	struct _usart_desc *desc = _serial[iface];
+	uint32_t flags;
+
+	flags = arch_irq_save();
+	if (desc->ring.active)
+		_usartd_rx_ring_update(desc);
+	stats->received = desc->ring.head;
+	stats->overruns = desc->ring.overruns;
+	stats->hw_overruns = desc->ring.hw_overruns;
+	arch_irq_restore(flags);
+}
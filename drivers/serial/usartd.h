@@ -52,6 +52,9 @@
 #define USARTD_ERROR_LOCK      (3)
 #define USARTD_ERROR_DUPLEX    (4)
 #define USARTD_ERROR_TIMEOUT   (5)
+#define USARTD_INVALID_SIZE    (6)
+#define USARTD_ERROR_DMA       (7)
+#define USARTD_ERROR_OVERRUN   (8)
 
 /*----------------------------------------------------------------------------
  *        Type definitions
@@ -102,6 +105,26 @@ struct _usart_desc
 			struct _dma_cfg cfg_dma;
 		} tx;
 	} dma;
+
+	/* Circular DMA reception, see usartd_start_rx_ring() */
+	struct {
+		uint8_t* data;
+		uint32_t size;
+		uint32_t head;          /* bytes written by the DMA, free running */
+		uint32_t tail;          /* bytes consumed, free running */
+		uint32_t overruns;      /* bytes overwritten before being consumed */
+		uint32_t hw_overruns;   /* USART overrun errors */
+		bool active;
+		bool idle;              /* last event was a receiver timeout */
+		struct _callback callback;
+	} ring;
+};
+
+/** Reception statistics of the circular DMA mode */
+struct _usartd_rx_stats {
+	uint32_t received;      /**< bytes received since the ring was started */
+	uint32_t overruns;      /**< bytes lost because the ring was full */
+	uint32_t hw_overruns;   /**< characters lost by the USART itself */
 };
 
 enum _usartd_trans_mode
@@ -125,6 +148,73 @@ extern void usartd_finish_tx_transfer(uint8_t iface);
 extern uint32_t usartd_tx_is_busy(const uint8_t iface);
 extern void usartd_wait_tx_transfer(const uint8_t iface);
 
+/**
+ * \brief Start continuous reception into a ring buffer.
+ *
+ * The DMA writes the ring in a loop and is never reprogrammed, so no byte is
+ * lost between frames. The callback is invoked from interrupt context with
+ * the number of available bytes as second argument, each time a quarter of
+ * the ring is filled and when the line stays idle for idle_bits bit periods
+ * after a character (receiver timeout). The idle field of the ring tells the
+ * callback which event occurred, an idle event is reported even when all the
+ * bytes have already been consumed.
+ * The receiver stays owned by the ring until usartd_stop_rx_ring().
+ *
+ * \param iface      USART interface
+ * \param buf        Ring buffer, cache aligned, its size must be a power of
+ *                   two
+ * \param idle_bits  Idle time reported as end of frame, in bit periods, 0 to
+ *                   keep the timeout set by usartd_configure()
+ * \param cb         Callback, may be NULL
+ * \return USARTD_SUCCESS or an error code
+ */
+extern uint32_t usartd_start_rx_ring(uint8_t iface, struct _buffer* buf,
+		uint32_t idle_bits, struct _callback* cb);
+
+/**
+ * \brief Stop the circular DMA reception and release the receiver.
+ */
+extern void usartd_stop_rx_ring(uint8_t iface);
+
+/**
+ * \brief Get the oldest contiguous span of received data without copying it.
+ *
+ * \param iface  USART interface
+ * \param data   Filled with the address of the span in the ring
+ * \param tail   Filled with the position of the span, to be given back to
+ *               usartd_rx_ring_consume()
+ * \return Length of the span, 0 if no data is available. More data may be
+ * available from the start of the ring once this span is consumed.
+ */
+extern uint32_t usartd_rx_ring_peek(uint8_t iface, uint8_t** data,
+		uint32_t* tail);
+
+/**
+ * \brief Release bytes returned by usartd_rx_ring_peek() back to the DMA.
+ *
+ * If the ring overflowed since the peek, the DMA has overwritten the start
+ * of the span: these bytes are counted as overruns and the data read from
+ * the span may be torn. Bytes received after the span are never dropped.
+ *
+ * \param iface  USART interface
+ * \param tail   Position of the span returned by usartd_rx_ring_peek()
+ * \param len    Number of bytes of the span to release
+ * \return USARTD_SUCCESS, or USARTD_ERROR_OVERRUN if the span was
+ * overwritten before being released
+ */
+extern uint32_t usartd_rx_ring_consume(uint8_t iface, uint32_t tail,
+		uint32_t len);
+
+/**
+ * \brief Get the number of bytes waiting in the ring.
+ */
+extern uint32_t usartd_rx_ring_count(uint8_t iface);
+
+/**
+ * \brief Get the reception statistics of the ring.
+ */
+extern void usartd_rx_ring_get_stats(uint8_t iface, struct _usartd_rx_stats* stats);
+
 #endif /* CONFIG_HAVE_USART */
 
 #endif /* USARTD_H_ */
@@ -39,6 +39,9 @@
 /** \addtogroup usbd_hal
  *@{*/
 
+/* Runtime trace filtering of this file, see trace_set_module_level() */
+#define TRACE_MODULE TRACE_MODULE_USB
+
 /*---------------------------------------------------------------------------
  *      Headers
  *---------------------------------------------------------------------------*/
@@ -52,6 +55,7 @@
 
 #include "barriers.h"
 #include "chip.h"
+#include "intmath.h"
 #include "irq/irq.h"
 #include "mm/cache.h"
 #include "peripherals/pmc.h"
@@ -241,6 +245,9 @@ static bool force_full_speed = false;
 /** DMA link list */
 CACHE_ALIGNED static struct _usb_dma_desc dma_desc[4];
 
+/** DMA link list for chained payloads */
+CACHE_ALIGNED static struct _usb_dma_desc chain_desc[USBD_HAL_CHAIN_DESC_COUNT];
+
 /*---------------------------------------------------------------------------
  *      Internal Functions
  *---------------------------------------------------------------------------*/
@@ -1734,6 +1741,129 @@ uint8_t usbd_hal_write_with_header(uint8_t ep,
 	return USBD_STATUS_SUCCESS;
 }
 
+/**
+ * Sends a series of payloads through a USB endpoint with a single DMA
+ * descriptor chain, without CPU intervention between payloads.
+ * Payload i is made of the header at \a headers + i * \a header_len,
+ * followed by the next bytes of \a data, at most \a payload_len bytes in
+ * total. Each payload is split in endpoint sized banks so a high bandwidth
+ * isochronous endpoint sends one payload per microframe. The transfer
+ * callback is invoked once, when the whole chain has been loaded.
+ *
+ * *Both the headers and the data must be kept allocated until the
+ *  transfer is finished*.
+ *
+ * \param ep Endpoint number.
+ * \param headers Pointer to the payload headers.
+ * \param header_len Size of one header.
+ * \param data Pointer to the data to send.
+ * \param data_len Size of the data.
+ * \param payload_len Maximum size of a payload, header included.
+ * \param count Maximum number of payloads.
+ * \return USBD_STATUS_SUCCESS if the transfer has been started;
+ *         otherwise, the corresponding error status code.
+ */
+uint8_t usbd_hal_write_payloads(uint8_t ep,
+			   const void *headers, uint32_t header_len,
+			   const void *data, uint32_t data_len,
+			   uint32_t payload_len, uint8_t count)
+{
+	struct _endpoint *endpoint = &endpoints[ep];
+	struct _single_xfer *xfer = &endpoint->transfer.single;
+	const uint8_t *header_ptr = (const uint8_t*)headers;
+	uint8_t *data_ptr = (uint8_t*)data;
+	uint32_t remaining = data_len;
+	uint32_t total = 0;
+	uint32_t nb_trans;
+	uint32_t d = 0;
+
+	/* Return if DMA is not supported */
+	if (!CHIP_USB_ENDPOINT_HAS_DMA(ep))
+		return USBD_STATUS_HW_NOT_SUPPORTED;
+
+	nb_trans = (_usbd_hal_endpoint_get_config(ep) & UDPHS_EPTCFG_NB_TRANS_Msk) >> UDPHS_EPTCFG_NB_TRANS_Pos;
+	nb_trans = max_u32(nb_trans, 1);
+
+	if (header_len == 0 || data_len == 0 || count == 0
+	    || payload_len <= header_len
+	    || payload_len > nb_trans * endpoint->size
+	    || header_len >= endpoint->size
+	    || count * (nb_trans + 1) > ARRAY_SIZE(chain_desc))
+		return USBD_STATUS_INVALID_PARAMETER;
+
+	/* Return if busy */
+	if (endpoint->state != USB_HAL_ENDPOINT_IDLE)
+		return USBD_STATUS_LOCKED;
+
+	cache_clean_region(headers, count * header_len);
+	cache_clean_region(data, data_len);
+
+	/* Sending state */
+	endpoint->state = USB_HAL_ENDPOINT_SENDING;
+	endpoint->send_zlp = 0;
+
+	while (count-- && remaining) {
+		uint32_t payload = min_u32(payload_len - header_len, remaining);
+		uint32_t pkt_len = endpoint->size - header_len;
+
+		/* Header, loaded at the start of the first bank */
+		chain_desc[d].next = &chain_desc[d + 1];
+		chain_desc[d].addr = (void*)header_ptr;
+		chain_desc[d].ctrl = UDPHS_DMACONTROL_CHANN_ENB
+			| UDPHS_DMACONTROL_BUFF_LENGTH(header_len)
+			| UDPHS_DMACONTROL_LDNXT_DSC;
+		chain_desc[d].reserved = 0;
+		header_ptr += header_len;
+		total += header_len;
+		d++;
+
+		/* Data, one descriptor per bank */
+		remaining -= payload;
+		total += payload;
+		while (payload) {
+			pkt_len = min_u32(pkt_len, payload);
+			chain_desc[d].next = &chain_desc[d + 1];
+			chain_desc[d].addr = data_ptr;
+			chain_desc[d].ctrl = UDPHS_DMACONTROL_CHANN_ENB
+				| UDPHS_DMACONTROL_BUFF_LENGTH(pkt_len)
+				| UDPHS_DMACONTROL_END_B_EN
+				| UDPHS_DMACONTROL_LDNXT_DSC;
+			chain_desc[d].reserved = 0;
+			data_ptr += pkt_len;
+			payload -= pkt_len;
+			pkt_len = endpoint->size;
+			d++;
+		}
+	}
+
+	/* Interrupt at the end of the chain only */
+	chain_desc[d - 1].next = NULL;
+	chain_desc[d - 1].ctrl &= ~UDPHS_DMACONTROL_LDNXT_DSC;
+	chain_desc[d - 1].ctrl |= UDPHS_DMACONTROL_END_BUFFIT;
+
+	USB_HAL_TRACE("WrP%d(%d) ", ep, (unsigned)total);
+
+	/* Setup transfer descriptor */
+	endpoint->transfer.use_multi = false;
+	xfer->data = (void*)data;
+	xfer->remaining = total;
+	xfer->buffered = total;
+	xfer->transferred = 0;
+
+	/* Flush DMA descriptors */
+	cache_clean_region(chain_desc, d * sizeof(chain_desc[0]));
+
+	/* Interrupt enable */
+	_usbd_hal_endpoint_dma_interrupt_enable(ep);
+
+	/* Start transfer with LLI */
+	UDPHS->UDPHS_DMA[ep].UDPHS_DMANXTDSC = (uint32_t)chain_desc;
+	UDPHS->UDPHS_DMA[ep].UDPHS_DMACONTROL = 0;
+	UDPHS->UDPHS_DMA[ep].UDPHS_DMACONTROL = UDPHS_DMACONTROL_LDNXT_DSC;
+
+	return USBD_STATUS_SUCCESS;
+}
+
 /**
  * Get the size of data is available for read or write
  * \param ep Endpoint number
@@ -2025,6 +2155,17 @@ bool usbd_hal_is_high_speed(void)
 	return (UDPHS->UDPHS_INTSTA & UDPHS_INTSTA_SPEED) != 0;
 }
 
+/**
+ * Returns the last received (micro)frame number, in 125us units: bits 13..3
+ * hold the 11-bit frame number and bits 2..0 the microframe (always 0 when
+ * running at full-speed).
+ */
+uint16_t usbd_hal_get_frame_number(void)
+{
+	return UDPHS->UDPHS_FNUM & (UDPHS_FNUM_FRAME_NUMBER_Msk |
+				    UDPHS_FNUM_MICRO_FRAME_NUM_Msk);
+}
+
 /**
  * Suspend USB Device HW Interface
  * -# Disable transceiver
@@ -0,0 +1,865 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "errno.h"
+#include "intmath.h"
+
+#include "video/image_convert.h"
+
+#ifdef CONFIG_HAVE_LCDC
+#include "chip.h"
+#include "display/lcdc.h"
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define IMAGE_USE_NEON
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of pixels converted at once through the intermediate buffers */
+#define CHUNK_PIXELS 64
+
+/** Side of the square tiles used for rotation, keeps both images in cache */
+#define ROTATE_TILE 16
+
+/*
+ * ITU-R BT.601 studio swing. YUV to RGB uses Q6 coefficients so that the
+ * NEON kernels can work on 16-bit lanes and give the same results as the C
+ * ones; RGB to YUV uses Q8 coefficients.
+ */
+#define YUV_Y(y)        (75 * ((int32_t)(y) - 16))
+#define YUV_R(y, u, v)  _clip_u8(((y) + 102 * (v) + 32) >> 6)
+#define YUV_G(y, u, v)  _clip_u8(((y) - 25 * (u) - 52 * (v) + 32) >> 6)
+#define YUV_B(y, u, v)  _clip_u8(((y) + 129 * (u) + 32) >> 6)
+
+#define RGB_Y(r, g, b)  ((uint8_t)(((66 * (r) + 129 * (g) + 25 * (b) + 128) >> 8) + 16))
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+/** Plane of 8-bit samples, used for scaling and rotation */
+struct _plane {
+	uint8_t *data;
+	uint32_t stride;
+	uint16_t width;
+	uint16_t height;
+	/* Number of samples per element and distance between them */
+	uint8_t channels;
+	uint8_t channel_step;
+	/* Distance between two elements */
+	uint8_t pixel_step;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline uint8_t _clip_u8(int32_t value)
+{
+	if ((uint32_t)value > 255)
+		return value < 0 ? 0 : 255;
+	return (uint8_t)value;
+}
+
+static inline bool _is_yuv(uint8_t format)
+{
+	return format == IMAGE_FORMAT_YUV422 || format == IMAGE_FORMAT_YUV420SP;
+}
+
+static bool _is_valid(const struct _image *image)
+{
+	if (!image->data || !image->width || !image->height)
+		return false;
+	if (image_get_bpp(image->format) == 0)
+		return false;
+	if (_is_yuv(image->format) && (image->width & 1))
+		return false;
+	if (image->format == IMAGE_FORMAT_YUV420SP && !image->data_uv)
+		return false;
+	return true;
+}
+
+static inline void _rgb_to_uv(uint32_t r, uint32_t g, uint32_t b,
+		uint8_t *u, uint8_t *v)
+{
+	/* r, g and b are sums of two pixels */
+	*u = (uint8_t)(((-38 * (int32_t)r - 74 * (int32_t)g + 112 * (int32_t)b + 256) >> 9) + 128);
+	*v = (uint8_t)(((112 * (int32_t)r - 94 * (int32_t)g - 18 * (int32_t)b + 256) >> 9) + 128);
+}
+
+static void _rgb565_to_argb(const uint8_t *src, uint32_t *dst, uint32_t width)
+{
+	const uint16_t *s = (const uint16_t*)src;
+	uint32_t i;
+
+	for (i = 0; i < width; i++) {
+		uint32_t p = s[i];
+		uint32_t r = (p >> 11) & 0x1f;
+		uint32_t g = (p >> 5) & 0x3f;
+		uint32_t b = p & 0x1f;
+		dst[i] = 0xff000000 | (((r << 3) | (r >> 2)) << 16) |
+			(((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+	}
+}
+
+static void _rgb888_to_argb(const uint8_t *src, uint32_t *dst, uint32_t width)
+{
+	uint32_t i;
+
+	for (i = 0; i < width; i++, src += 3)
+		dst[i] = 0xff000000 | (src[2] << 16) | (src[1] << 8) | src[0];
+}
+
+static void _argb_to_rgb565(const uint32_t *src, uint8_t *dst, uint32_t width)
+{
+	uint16_t *d = (uint16_t*)dst;
+	uint32_t i;
+
+	for (i = 0; i < width; i++) {
+		uint32_t p = src[i];
+		d[i] = ((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) | ((p >> 3) & 0x001f);
+	}
+}
+
+static void _argb_to_rgb888(const uint32_t *src, uint8_t *dst, uint32_t width)
+{
+	uint32_t i;
+
+	for (i = 0; i < width; i++, dst += 3) {
+		uint32_t p = src[i];
+		dst[0] = p;
+		dst[1] = p >> 8;
+		dst[2] = p >> 16;
+	}
+}
+
+static void _argb_to_yuv422(const uint32_t *src, uint8_t *dst, uint32_t width)
+{
+	uint32_t i;
+
+	for (i = 0; i < width; i += 2, dst += 4) {
+		uint32_t p0 = src[i], p1 = src[i + 1];
+		uint32_t r0 = (p0 >> 16) & 0xff, g0 = (p0 >> 8) & 0xff, b0 = p0 & 0xff;
+		uint32_t r1 = (p1 >> 16) & 0xff, g1 = (p1 >> 8) & 0xff, b1 = p1 & 0xff;
+
+		dst[0] = RGB_Y(r0, g0, b0);
+		dst[2] = RGB_Y(r1, g1, b1);
+		_rgb_to_uv(r0 + r1, g0 + g1, b0 + b1, &dst[1], &dst[3]);
+	}
+}
+
+static void _yuv420sp_to_yuv422(const uint8_t *src_y, const uint8_t *src_uv,
+		uint8_t *dst, uint32_t width)
+{
+	uint32_t i;
+
+	for (i = 0; i < width; i += 2, dst += 4) {
+		dst[0] = src_y[i];
+		dst[1] = src_uv[i];
+		dst[2] = src_y[i + 1];
+		dst[3] = src_uv[i + 1];
+	}
+}
+
+static void _yuv422_to_yuv420sp(const uint8_t *src, uint8_t *dst_y,
+		uint8_t *dst_uv, uint32_t width)
+{
+	uint32_t i;
+
+	for (i = 0; i < width; i += 2, src += 4) {
+		dst_y[i] = src[0];
+		dst_y[i + 1] = src[2];
+		if (dst_uv) {
+			dst_uv[i] = src[1];
+			dst_uv[i + 1] = src[3];
+		}
+	}
+}
+
+#ifdef IMAGE_USE_NEON
+/**
+ * Convert 16 YUV 4:2:2 pixels to 8-bit R, G and B components, in pixel
+ * order (val[0] holds pixels 0-7, val[1] pixels 8-15)
+ */
+static inline void _neon_yuv422_to_rgb(const uint8_t *src,
+		uint8x8x2_t *r, uint8x8x2_t *g, uint8x8x2_t *b)
+{
+	/* val[0]: Y0, val[1]: Cb, val[2]: Y1, val[3]: Cr */
+	uint8x8x4_t yuyv = vld4_u8(src);
+	int16x8_t u = vreinterpretq_s16_u16(vsubl_u8(yuyv.val[1], vdup_n_u8(128)));
+	int16x8_t v = vreinterpretq_s16_u16(vsubl_u8(yuyv.val[3], vdup_n_u8(128)));
+	int16x8_t rv = vmulq_n_s16(v, 102);
+	int16x8_t guv = vaddq_s16(vmulq_n_s16(u, 25), vmulq_n_s16(v, 52));
+	int16x8_t bu = vmulq_n_s16(u, 129);
+	uint8x8_t re[2], ge[2], be[2];
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		int16x8_t y = vreinterpretq_s16_u16(vsubl_u8(yuyv.val[2 * i], vdup_n_u8(16)));
+		y = vmulq_n_s16(y, 75);
+		/* Saturating, only overflows when the result is above 255 */
+		re[i] = vqrshrun_n_s16(vqaddq_s16(y, rv), 6);
+		ge[i] = vqrshrun_n_s16(vqsubq_s16(y, guv), 6);
+		be[i] = vqrshrun_n_s16(vqaddq_s16(y, bu), 6);
+	}
+
+	/* Interleave even and odd pixels */
+	*r = vzip_u8(re[0], re[1]);
+	*g = vzip_u8(ge[0], ge[1]);
+	*b = vzip_u8(be[0], be[1]);
+}
+#endif /* IMAGE_USE_NEON */
+
+static inline uint8_t* _line(const struct _image *image, uint32_t y)
+{
+	return image->data + y * image_get_stride(image);
+}
+
+static inline uint8_t* _line_uv(const struct _image *image, uint32_t y)
+{
+	return image->data_uv + (y >> 1) * image_get_stride(image);
+}
+
+/**
+ * Convert part of a line through the ARGB8888 and YUV 4:2:2 intermediate
+ * formats. dst_uv is NULL when no chroma must be written.
+ */
+static void _convert_chunk(uint8_t src_format, const uint8_t *src,
+		const uint8_t *src_uv, uint8_t dst_format, uint8_t *dst,
+		uint8_t *dst_uv, uint32_t width)
+{
+	uint32_t argb[CHUNK_PIXELS];
+	uint8_t yuv[2 * CHUNK_PIXELS];
+	const uint32_t *pa = NULL;
+	const uint8_t *py = NULL;
+
+	/* Source to the intermediate format of its family */
+	switch (src_format) {
+	case IMAGE_FORMAT_RGB565:
+		_rgb565_to_argb(src, argb, width);
+		pa = argb;
+		break;
+	case IMAGE_FORMAT_RGB888:
+		_rgb888_to_argb(src, argb, width);
+		pa = argb;
+		break;
+	case IMAGE_FORMAT_ARGB8888:
+		pa = (const uint32_t*)src;
+		break;
+	case IMAGE_FORMAT_YUV422:
+		py = src;
+		break;
+	case IMAGE_FORMAT_YUV420SP:
+		_yuv420sp_to_yuv422(src, src_uv, yuv, width);
+		py = yuv;
+		break;
+	}
+
+	/* Change of color space */
+	if (_is_yuv(dst_format) && pa) {
+		_argb_to_yuv422(pa, yuv, width);
+		py = yuv;
+	} else if (!_is_yuv(dst_format) && py) {
+		image_yuv422_to_argb8888_row(py, argb, width);
+		pa = argb;
+	}
+
+	switch (dst_format) {
+	case IMAGE_FORMAT_RGB565:
+		_argb_to_rgb565(pa, dst, width);
+		break;
+	case IMAGE_FORMAT_RGB888:
+		_argb_to_rgb888(pa, dst, width);
+		break;
+	case IMAGE_FORMAT_ARGB8888:
+		memcpy(dst, pa, 4 * width);
+		break;
+	case IMAGE_FORMAT_YUV422:
+		memcpy(dst, py, 2 * width);
+		break;
+	case IMAGE_FORMAT_YUV420SP:
+		_yuv422_to_yuv420sp(py, dst, dst_uv, width);
+		break;
+	}
+}
+
+static void _convert_line(const struct _image *src, struct _image *dst,
+		uint32_t y)
+{
+	uint32_t src_bpp = image_get_bpp(src->format);
+	uint32_t dst_bpp = image_get_bpp(dst->format);
+	const uint8_t *s = _line(src, y);
+	const uint8_t *s_uv = NULL;
+	uint8_t *d = _line(dst, y);
+	uint8_t *d_uv = NULL;
+	uint32_t x, n;
+
+	/* Luma plane of YUV420SP has one byte per pixel */
+	if (src->format == IMAGE_FORMAT_YUV420SP) {
+		s_uv = _line_uv(src, y);
+		src_bpp = 8;
+	}
+	if (dst->format == IMAGE_FORMAT_YUV420SP) {
+		if ((y & 1) == 0)
+			d_uv = _line_uv(dst, y);
+		dst_bpp = 8;
+	}
+
+	for (x = 0; x < src->width; x += n) {
+		n = min_u32(src->width - x, CHUNK_PIXELS);
+		_convert_chunk(src->format, s + x * src_bpp / 8, s_uv ? s_uv + x : NULL,
+				dst->format, d + x * dst_bpp / 8, d_uv ? d_uv + x : NULL, n);
+	}
+}
+
+static void _scale_plane_nearest(const struct _plane *src, struct _plane *dst)
+{
+	uint32_t x_step = ((uint32_t)src->width << 16) / dst->width;
+	uint32_t y_step = ((uint32_t)src->height << 16) / dst->height;
+	uint32_t y_pos = y_step / 2;
+	uint32_t dx, dy, c;
+
+	for (dy = 0; dy < dst->height; dy++, y_pos += y_step) {
+		const uint8_t *s = src->data + (y_pos >> 16) * src->stride;
+		uint8_t *d = dst->data + dy * dst->stride;
+		uint32_t x_pos = x_step / 2;
+
+		for (dx = 0; dx < dst->width; dx++, x_pos += x_step) {
+			const uint8_t *p = s + (x_pos >> 16) * src->pixel_step;
+			for (c = 0; c < src->channels; c++)
+				d[c * dst->channel_step] = p[c * src->channel_step];
+			d += dst->pixel_step;
+		}
+	}
+}
+
+static void _scale_plane_bilinear(const struct _plane *src, struct _plane *dst)
+{
+	int32_t x_step = ((int32_t)src->width << 16) / dst->width;
+	int32_t y_step = ((int32_t)src->height << 16) / dst->height;
+	/* Sample at pixel centers */
+	int32_t y_pos = y_step / 2 - 0x8000;
+	uint32_t dx, dy, c;
+
+	for (dy = 0; dy < dst->height; dy++, y_pos += y_step) {
+		uint32_t yp = y_pos < 0 ? 0 : y_pos;
+		uint32_t y0 = yp >> 16;
+		uint32_t y1 = min_u32(y0 + 1, src->height - 1);
+		uint32_t fy = (yp >> 8) & 0xff;
+		const uint8_t *s0 = src->data + y0 * src->stride;
+		const uint8_t *s1 = src->data + y1 * src->stride;
+		uint8_t *d = dst->data + dy * dst->stride;
+		int32_t x_pos = x_step / 2 - 0x8000;
+
+		for (dx = 0; dx < dst->width; dx++, x_pos += x_step) {
+			uint32_t xp = x_pos < 0 ? 0 : x_pos;
+			uint32_t x0 = xp >> 16;
+			uint32_t x1 = min_u32(x0 + 1, src->width - 1);
+			uint32_t fx = (xp >> 8) & 0xff;
+
+			x0 *= src->pixel_step;
+			x1 *= src->pixel_step;
+			for (c = 0; c < src->channels; c++) {
+				uint32_t o = c * src->channel_step;
+				uint32_t top = s0[x0 + o] * (256 - fx) + s0[x1 + o] * fx;
+				uint32_t bot = s1[x0 + o] * (256 - fx) + s1[x1 + o] * fx;
+				d[c * dst->channel_step] = (top * (256 - fy) + bot * fy + 0x8000) >> 16;
+			}
+			d += dst->pixel_step;
+		}
+	}
+}
+
+/**
+ * Spread the components of a RGB565 pixel so that they can be interpolated at
+ * once: G in bits 26:21, R in 15:11, B in 4:0, with 5 bits of headroom for the
+ * weights.
+ */
+static inline uint32_t _rgb565_spread(uint16_t pixel)
+{
+	return (pixel | ((uint32_t)pixel << 16)) & 0x07e0f81f;
+}
+
+static void _scale_rgb565_bilinear(const struct _plane *src, struct _plane *dst)
+{
+	int32_t x_step = ((int32_t)src->width << 16) / dst->width;
+	int32_t y_step = ((int32_t)src->height << 16) / dst->height;
+	int32_t y_pos = y_step / 2 - 0x8000;
+	uint32_t dx, dy;
+
+	for (dy = 0; dy < dst->height; dy++, y_pos += y_step) {
+		uint32_t yp = y_pos < 0 ? 0 : y_pos;
+		uint32_t y0 = yp >> 16;
+		uint32_t y1 = min_u32(y0 + 1, src->height - 1);
+		uint32_t fy = (yp >> 11) & 0x1f;
+		const uint16_t *s0 = (const uint16_t*)(src->data + y0 * src->stride);
+		const uint16_t *s1 = (const uint16_t*)(src->data + y1 * src->stride);
+		uint16_t *d = (uint16_t*)(dst->data + dy * dst->stride);
+		int32_t x_pos = x_step / 2 - 0x8000;
+
+		for (dx = 0; dx < dst->width; dx++, x_pos += x_step) {
+			uint32_t xp = x_pos < 0 ? 0 : x_pos;
+			uint32_t x0 = xp >> 16;
+			uint32_t x1 = min_u32(x0 + 1, src->width - 1);
+			uint32_t fx = (xp >> 11) & 0x1f;
+			uint32_t p00 = _rgb565_spread(s0[x0]);
+			uint32_t p01 = _rgb565_spread(s0[x1]);
+			uint32_t p10 = _rgb565_spread(s1[x0]);
+			uint32_t p11 = _rgb565_spread(s1[x1]);
+			uint32_t top = ((p00 * (32 - fx) + p01 * fx) >> 5) & 0x07e0f81f;
+			uint32_t bot = ((p10 * (32 - fx) + p11 * fx) >> 5) & 0x07e0f81f;
+			uint32_t p = ((top * (32 - fy) + bot * fy) >> 5) & 0x07e0f81f;
+
+			d[dx] = (uint16_t)(p | (p >> 16));
+		}
+	}
+}
+
+static inline void _copy_element(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+	switch (size) {
+	case 1:
+		*dst = *src;
+		break;
+	case 2:
+		*(uint16_t*)dst = *(const uint16_t*)src;
+		break;
+	case 4:
+		*(uint32_t*)dst = *(const uint32_t*)src;
+		break;
+	default:
+		memcpy(dst, src, size);
+		break;
+	}
+}
+
+/**
+ * Rotate a plane of elements of the given size clockwise, walking the
+ * source by tiles so that the scattered destination writes stay in cache.
+ */
+static void _rotate_plane(const uint8_t *src, uint32_t src_stride,
+		uint32_t width, uint32_t height, uint8_t *dst,
+		uint32_t dst_stride, uint32_t size, int16_t rotation)
+{
+	uint32_t tx, ty, x, y;
+
+	if (rotation == 0) {
+		for (y = 0; y < height; y++)
+			memcpy(dst + y * dst_stride, src + y * src_stride, width * size);
+		return;
+	}
+
+	for (ty = 0; ty < height; ty += ROTATE_TILE) {
+		uint32_t y_end = min_u32(ty + ROTATE_TILE, height);
+		for (tx = 0; tx < width; tx += ROTATE_TILE) {
+			uint32_t x_end = min_u32(tx + ROTATE_TILE, width);
+			for (y = ty; y < y_end; y++) {
+				const uint8_t *s = src + y * src_stride + tx * size;
+				for (x = tx; x < x_end; x++, s += size) {
+					uint32_t dx, dy;
+					switch (rotation) {
+					case 90:
+						dx = height - 1 - y;
+						dy = x;
+						break;
+					case 180:
+						dx = width - 1 - x;
+						dy = height - 1 - y;
+						break;
+					default:
+						dx = y;
+						dy = width - 1 - x;
+						break;
+					}
+					_copy_element(dst + dy * dst_stride + dx * size, s, size);
+				}
+			}
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+uint32_t image_get_bpp(uint8_t format)
+{
+	switch (format) {
+	case IMAGE_FORMAT_RGB565:
+	case IMAGE_FORMAT_YUV422:
+		return 16;
+	case IMAGE_FORMAT_RGB888:
+		return 24;
+	case IMAGE_FORMAT_ARGB8888:
+		return 32;
+	case IMAGE_FORMAT_YUV420SP:
+		return 12;
+	default:
+		return 0;
+	}
+}
+
+uint32_t image_get_stride(const struct _image *image)
+{
+	if (image->stride)
+		return image->stride;
+	if (image->format == IMAGE_FORMAT_YUV420SP)
+		return image->width;
+	return image->width * image_get_bpp(image->format) / 8;
+}
+
+uint32_t image_get_size(const struct _image *image)
+{
+	uint32_t size = image_get_stride(image) * image->height;
+
+	if (image->format == IMAGE_FORMAT_YUV420SP)
+		size += image_get_stride(image) * ((image->height + 1) / 2);
+	return size;
+}
+
+void image_yuv422_to_rgb565_row(const uint8_t *src, uint16_t *dst,
+		uint32_t width)
+{
+	uint32_t i = 0;
+
+#ifdef IMAGE_USE_NEON
+	for (; i + 16 <= width; i += 16, src += 32, dst += 16) {
+		uint8x8x2_t r, g, b;
+		int j;
+
+		_neon_yuv422_to_rgb(src, &r, &g, &b);
+		for (j = 0; j < 2; j++) {
+			uint16x8_t p = vshll_n_u8(r.val[j], 8);
+			p = vsriq_n_u16(p, vshll_n_u8(g.val[j], 8), 5);
+			p = vsriq_n_u16(p, vshll_n_u8(b.val[j], 8), 11);
+			vst1q_u16(dst + 8 * j, p);
+		}
+	}
+#endif
+
+	for (; i < width; i += 2, src += 4, dst += 2) {
+		int32_t u = src[1] - 128;
+		int32_t v = src[3] - 128;
+		int32_t y0 = YUV_Y(src[0]);
+		int32_t y1 = YUV_Y(src[2]);
+
+		dst[0] = ((YUV_R(y0, u, v) & 0xf8) << 8) |
+			((YUV_G(y0, u, v) & 0xfc) << 3) | (YUV_B(y0, u, v) >> 3);
+		dst[1] = ((YUV_R(y1, u, v) & 0xf8) << 8) |
+			((YUV_G(y1, u, v) & 0xfc) << 3) | (YUV_B(y1, u, v) >> 3);
+	}
+}
+
+void image_yuv422_to_argb8888_row(const uint8_t *src, uint32_t *dst,
+		uint32_t width)
+{
+	uint32_t i = 0;
+
+#ifdef IMAGE_USE_NEON
+	for (; i + 16 <= width; i += 16, src += 32, dst += 16) {
+		uint8x8x2_t r, g, b;
+		uint8x8x4_t bgra;
+		int j;
+
+		_neon_yuv422_to_rgb(src, &r, &g, &b);
+		bgra.val[3] = vdup_n_u8(0xff);
+		for (j = 0; j < 2; j++) {
+			bgra.val[0] = b.val[j];
+			bgra.val[1] = g.val[j];
+			bgra.val[2] = r.val[j];
+			vst4_u8((uint8_t*)(dst + 8 * j), bgra);
+		}
+	}
+#endif
+
+	for (; i < width; i += 2, src += 4, dst += 2) {
+		int32_t u = src[1] - 128;
+		int32_t v = src[3] - 128;
+		int32_t y0 = YUV_Y(src[0]);
+		int32_t y1 = YUV_Y(src[2]);
+
+		dst[0] = 0xff000000 | (YUV_R(y0, u, v) << 16) |
+			(YUV_G(y0, u, v) << 8) | YUV_B(y0, u, v);
+		dst[1] = 0xff000000 | (YUV_R(y1, u, v) << 16) |
+			(YUV_G(y1, u, v) << 8) | YUV_B(y1, u, v);
+	}
+}
+
+void image_rgb565_to_yuv422_row(const uint16_t *src, uint8_t *dst,
+		uint32_t width)
+{
+	uint32_t i;
+
+	for (i = 0; i < width; i += 2, src += 2, dst += 4) {
+		uint32_t p0 = src[0], p1 = src[1];
+		uint32_t r0 = (p0 >> 8) & 0xf8, g0 = (p0 >> 3) & 0xfc, b0 = (p0 << 3) & 0xf8;
+		uint32_t r1 = (p1 >> 8) & 0xf8, g1 = (p1 >> 3) & 0xfc, b1 = (p1 << 3) & 0xf8;
+
+		/* Replicate the high bits in the low ones */
+		r0 |= r0 >> 5; g0 |= g0 >> 6; b0 |= b0 >> 5;
+		r1 |= r1 >> 5; g1 |= g1 >> 6; b1 |= b1 >> 5;
+
+		dst[0] = RGB_Y(r0, g0, b0);
+		dst[2] = RGB_Y(r1, g1, b1);
+		_rgb_to_uv(r0 + r1, g0 + g1, b0 + b1, &dst[1], &dst[3]);
+	}
+}
+
+int image_convert(const struct _image *src, struct _image *dst)
+{
+	uint32_t y;
+
+	if (!_is_valid(src) || !_is_valid(dst))
+		return -EINVAL;
+	if (src->width != dst->width || src->height != dst->height)
+		return -EINVAL;
+
+	for (y = 0; y < src->height; y++) {
+		const uint8_t *s = _line(src, y);
+		uint8_t *d = _line(dst, y);
+
+		if (src->format == dst->format) {
+			if (src->format == IMAGE_FORMAT_YUV420SP) {
+				memcpy(d, s, src->width);
+				if ((y & 1) == 0)
+					memcpy(_line_uv(dst, y), _line_uv(src, y), src->width);
+			} else {
+				memcpy(d, s, src->width * image_get_bpp(src->format) / 8);
+			}
+		} else if (src->format == IMAGE_FORMAT_YUV422 &&
+			   dst->format == IMAGE_FORMAT_RGB565) {
+			image_yuv422_to_rgb565_row(s, (uint16_t*)d, src->width);
+		} else if (src->format == IMAGE_FORMAT_YUV422 &&
+			   dst->format == IMAGE_FORMAT_ARGB8888) {
+			image_yuv422_to_argb8888_row(s, (uint32_t*)d, src->width);
+		} else if (src->format == IMAGE_FORMAT_RGB565 &&
+			   dst->format == IMAGE_FORMAT_YUV422) {
+			image_rgb565_to_yuv422_row((const uint16_t*)s, d, src->width);
+		} else {
+			_convert_line(src, dst, y);
+		}
+	}
+
+	return 0;
+}
+
+int image_scale(const struct _image *src, struct _image *dst, uint8_t scaling)
+{
+	struct _plane s, d;
+
+	if (!_is_valid(src) || !_is_valid(dst) || src->format != dst->format)
+		return -EINVAL;
+	if (scaling != IMAGE_SCALING_NEAREST && scaling != IMAGE_SCALING_BILINEAR)
+		return -EINVAL;
+
+	s.data = src->data;
+	s.stride = image_get_stride(src);
+	s.width = src->width;
+	s.height = src->height;
+	d.data = dst->data;
+	d.stride = image_get_stride(dst);
+	d.width = dst->width;
+	d.height = dst->height;
+
+	switch (src->format) {
+	case IMAGE_FORMAT_RGB565:
+		s.channels = d.channels = 2;
+		s.channel_step = d.channel_step = 1;
+		s.pixel_step = d.pixel_step = 2;
+		if (scaling == IMAGE_SCALING_BILINEAR) {
+			_scale_rgb565_bilinear(&s, &d);
+			return 0;
+		}
+		break;
+	case IMAGE_FORMAT_RGB888:
+		s.channels = d.channels = 3;
+		s.channel_step = d.channel_step = 1;
+		s.pixel_step = d.pixel_step = 3;
+		break;
+	case IMAGE_FORMAT_ARGB8888:
+		s.channels = d.channels = 4;
+		s.channel_step = d.channel_step = 1;
+		s.pixel_step = d.pixel_step = 4;
+		break;
+	case IMAGE_FORMAT_YUV422:
+		/* Luma first, chroma of each pixel pair below */
+		s.channels = d.channels = 1;
+		s.channel_step = d.channel_step = 1;
+		s.pixel_step = d.pixel_step = 2;
+		break;
+	case IMAGE_FORMAT_YUV420SP:
+		s.channels = d.channels = 1;
+		s.channel_step = d.channel_step = 1;
+		s.pixel_step = d.pixel_step = 1;
+		break;
+	}
+
+	if (scaling == IMAGE_SCALING_BILINEAR)
+		_scale_plane_bilinear(&s, &d);
+	else
+		_scale_plane_nearest(&s, &d);
+
+	if (!_is_yuv(src->format))
+		return 0;
+
+	/* Chroma planes */
+	s.width = src->width / 2;
+	d.width = dst->width / 2;
+	s.channels = d.channels = 2;
+	if (src->format == IMAGE_FORMAT_YUV422) {
+		s.data = src->data + 1;
+		d.data = dst->data + 1;
+		s.channel_step = d.channel_step = 2;
+		s.pixel_step = d.pixel_step = 4;
+	} else {
+		s.data = src->data_uv;
+		d.data = dst->data_uv;
+		s.height = (src->height + 1) / 2;
+		d.height = (dst->height + 1) / 2;
+		s.pixel_step = d.pixel_step = 2;
+	}
+
+	if (scaling == IMAGE_SCALING_BILINEAR)
+		_scale_plane_bilinear(&s, &d);
+	else
+		_scale_plane_nearest(&s, &d);
+
+	return 0;
+}
+
+int image_rotate(const struct _image *src, struct _image *dst, int16_t rotation)
+{
+	uint32_t src_stride, dst_stride, y, x;
+
+	if (!_is_valid(src) || !_is_valid(dst) || src->format != dst->format)
+		return -EINVAL;
+
+	switch (rotation) {
+	case 0:
+	case 180:
+		if (src->width != dst->width || src->height != dst->height)
+			return -EINVAL;
+		break;
+	case 90:
+	case 270:
+		if (src->width != dst->height || src->height != dst->width)
+			return -EINVAL;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	src_stride = image_get_stride(src);
+	dst_stride = image_get_stride(dst);
+
+	switch (src->format) {
+	case IMAGE_FORMAT_YUV422:
+		if (rotation == 90 || rotation == 270)
+			return -ENOTSUP;
+		/* Rotate pixel pairs, then swap the two lumas of each pair */
+		_rotate_plane(src->data, src_stride, src->width / 2, src->height,
+				dst->data, dst_stride, 4, rotation);
+		if (rotation == 180) {
+			for (y = 0; y < dst->height; y++) {
+				uint8_t *d = dst->data + y * dst_stride;
+				for (x = 0; x < dst->width; x += 2, d += 4) {
+					uint8_t tmp = d[0];
+					d[0] = d[2];
+					d[2] = tmp;
+				}
+			}
+		}
+		break;
+	case IMAGE_FORMAT_YUV420SP:
+		if ((src->height & 1) && rotation != 0 && rotation != 180)
+			return -EINVAL;
+		_rotate_plane(src->data, src_stride, src->width, src->height,
+				dst->data, dst_stride, 1, rotation);
+		_rotate_plane(src->data_uv, src_stride, src->width / 2,
+				(src->height + 1) / 2, dst->data_uv, dst_stride, 2,
+				rotation);
+		break;
+	default:
+		_rotate_plane(src->data, src_stride, src->width, src->height,
+				dst->data, dst_stride,
+				image_get_bpp(src->format) / 8, rotation);
+		break;
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_HAVE_LCDC
+int image_show_heo(const struct _image *image, uint32_t x, uint32_t y,
+		uint32_t w, uint32_t h, int16_t rotation)
+{
+	uint8_t bpp = image_get_bpp(image->format);
+
+	if (!_is_valid(image))
+		return -EINVAL;
+	if (image->stride && image->stride != image->width * bpp / 8)
+		return -ENOTSUP;
+
+	switch (image->format) {
+	case IMAGE_FORMAT_RGB565:
+	case IMAGE_FORMAT_RGB888:
+	case IMAGE_FORMAT_ARGB8888:
+		lcdc_configure_input_mode(LCDC_HEO, 0);
+		break;
+#ifdef LCDC_HEOCFG1_YUVEN
+	case IMAGE_FORMAT_YUV422:
+		lcdc_configure_input_mode(LCDC_HEO, LCDC_HEOCFG1_YUVEN |
+				LCDC_HEOCFG1_YUVMODE_16BPP_YCBCR_MODE0);
+		break;
+#endif
+	default:
+		return -ENOTSUP;
+	}
+
+	if (rotation % 90)
+		return -EINVAL;
+
+	lcdc_put_image_rotated(LCDC_HEO, image->data, bpp, x, y, w, h,
+			image->width, image->height, rotation);
+	return 0;
+}
+#endif /* CONFIG_HAVE_LCDC */
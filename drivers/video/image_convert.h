@@ -0,0 +1,203 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Image format conversion, scaling and rotation.
+ *
+ * Kernels work row by row so that they can be used on part of a frame, e.g.
+ * between two DMA transfers. When built with NEON enabled (-mfpu=neon-vfpv4
+ * on SAMA5D2/SAMA5D4), the YUV 4:2:2 to RGB kernels process 16 pixels per
+ * iteration.
+ *
+ * Conversions that can be done by the hardware should not go through this
+ * module: the ISC post-processing outputs RGB565, YUV 4:2:2 packed or
+ * semi-planar frames directly, and the LCDC HEO layer converts, scales and
+ * rotates RGB and YUV 4:2:2 packed images on the fly (see image_show_heo()).
+ */
+
+#ifndef IMAGE_CONVERT_H
+#define IMAGE_CONVERT_H
+
+/*---------------------------------------------------------------------------
+ *         Includes
+ *---------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*---------------------------------------------------------------------------
+ *         Types
+ *---------------------------------------------------------------------------*/
+
+/** Pixel formats, in the memory layout used by the ISC, ISI and LCDC */
+enum _image_format {
+	/** 16-bit words, R in bits 15:11, G in 10:5, B in 4:0 */
+	IMAGE_FORMAT_RGB565,
+	/** 3 bytes per pixel: B, G, R (LCDC 24 bpp packed) */
+	IMAGE_FORMAT_RGB888,
+	/** 32-bit words 0xAARRGGBB */
+	IMAGE_FORMAT_ARGB8888,
+	/** Y0, Cb, Y1, Cr byte order (YUYV, LCDC YCbCr mode 0, UVC YUY2) */
+	IMAGE_FORMAT_YUV422,
+	/** Y plane followed by an interleaved Cb, Cr plane subsampled by 2
+	 * in both directions (NV12) */
+	IMAGE_FORMAT_YUV420SP,
+};
+
+/** Interpolation used when scaling */
+enum _image_scaling {
+	IMAGE_SCALING_NEAREST,
+	IMAGE_SCALING_BILINEAR,
+};
+
+/** Description of an image in memory */
+struct _image {
+	/* Pixels, or luma plane for YUV420SP */
+	uint8_t *data;
+	/* Chroma plane for YUV420SP */
+	uint8_t *data_uv;
+	/* Size in bytes of a line of data (and data_uv), 0 if lines are
+	 * contiguous */
+	uint32_t stride;
+	uint16_t width;
+	uint16_t height;
+	/* enum _image_format */
+	uint8_t format;
+};
+
+/*---------------------------------------------------------------------------
+ *         Exported functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * \brief Get the number of bits per pixel of a format
+ * \param format  Pixel format (enum _image_format)
+ * \return Bits per pixel, 0 if the format is unknown
+ */
+extern uint32_t image_get_bpp(uint8_t format);
+
+/**
+ * \brief Get the size in bytes of a line of an image
+ * \param image  Image description
+ * \return Line size of the first plane
+ */
+extern uint32_t image_get_stride(const struct _image *image);
+
+/**
+ * \brief Get the size in bytes of an image (all planes)
+ * \param image  Image description
+ */
+extern uint32_t image_get_size(const struct _image *image);
+
+/**
+ * \brief Convert a row of YUV 4:2:2 pixels to RGB565
+ * \param src    Source pixels
+ * \param dst    Destination pixels
+ * \param width  Number of pixels, must be even
+ */
+extern void image_yuv422_to_rgb565_row(const uint8_t *src, uint16_t *dst,
+		uint32_t width);
+
+/**
+ * \brief Convert a row of YUV 4:2:2 pixels to ARGB8888, alpha is set to 0xff
+ * \param src    Source pixels
+ * \param dst    Destination pixels
+ * \param width  Number of pixels, must be even
+ */
+extern void image_yuv422_to_argb8888_row(const uint8_t *src, uint32_t *dst,
+		uint32_t width);
+
+/**
+ * \brief Convert a row of RGB565 pixels to YUV 4:2:2, chroma of each pixel
+ * pair is averaged
+ * \param src    Source pixels
+ * \param dst    Destination pixels
+ * \param width  Number of pixels, must be even
+ */
+extern void image_rgb565_to_yuv422_row(const uint16_t *src, uint8_t *dst,
+		uint32_t width);
+
+/**
+ * \brief Convert an image to another format. Both images must have the
+ * same size.
+ *
+ * Lines are converted in chunks through a small on-stack buffer when
+ * there is no direct kernel, so the function is reentrant. When converting
+ * to YUV420SP, chroma is taken from even lines.
+ *
+ * \param src  Source image
+ * \param dst  Destination image
+ * \return 0 on success, -EINVAL if the images do not match
+ */
+extern int image_convert(const struct _image *src, struct _image *dst);
+
+/**
+ * \brief Scale an image to the size of the destination image. Both images
+ * must have the same format.
+ * \param src      Source image
+ * \param dst      Destination image
+ * \param scaling  Interpolation (enum _image_scaling)
+ * \return 0 on success, -EINVAL if the images do not match
+ */
+extern int image_scale(const struct _image *src, struct _image *dst,
+		uint8_t scaling);
+
+/**
+ * \brief Rotate an image clockwise. Both images must have the same
+ * format, and the destination size must be swapped for 90 and 270 degrees.
+ * YUV 4:2:2 packed images can only be rotated by 180 degrees, the LCDC HEO
+ * layer rotates them when they are displayed.
+ * \param src       Source image
+ * \param dst       Destination image
+ * \param rotation  0, 90, 180 or 270
+ * \return 0 on success, -EINVAL if the images do not match, -ENOTSUP if
+ * the rotation is not supported for this format
+ */
+extern int image_rotate(const struct _image *src, struct _image *dst,
+		int16_t rotation);
+
+#ifdef CONFIG_HAVE_LCDC
+/**
+ * \brief Show an image on the LCDC HEO layer, which converts YUV 4:2:2 to
+ * RGB, scales the image to the window size and rotates it by hardware.
+ * \param image     Image, lines must be contiguous
+ * \param x         Window X position
+ * \param y         Window Y position
+ * \param w         Window width
+ * \param h         Window height
+ * \param rotation  0, 90, 180 or 270
+ * \return 0 on success, -ENOTSUP if the format must first be converted
+ * with image_convert()
+ */
+extern int image_show_heo(const struct _image *image, uint32_t x, uint32_t y,
+		uint32_t w, uint32_t h, int16_t rotation);
+#endif
+
+#endif /* IMAGE_CONVERT_H */
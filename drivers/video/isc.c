@@ -92,6 +92,20 @@ void isc_update_profile(void)
 	while ((ISC->ISC_CTRLSR & ISC_CTRLSR_UPPRO) == ISC_CTRLSR_UPPRO);
 }
 
+/**
+ * \brief Request a profile update without waiting for it to be applied.
+ * \return false if a previous update or synchronization is still in
+ * progress, in which case nothing is done.
+ */
+bool isc_request_profile_update(void)
+{
+	if (isc_is_sip_asserted() ||
+	    (ISC->ISC_CTRLSR & ISC_CTRLSR_UPPRO) == ISC_CTRLSR_UPPRO)
+		return false;
+	ISC->ISC_CTRLEN = ISC_CTRLEN_UPPRO;
+	return true;
+}
+
 /**
  * \brief Perform software reset of the interface.
  */
@@ -41,6 +41,7 @@
 #define ISC_H
 
 #ifdef CONFIG_HAVE_ISC
+#include <stdbool.h>
 #include <stdint.h>
 
 /*------------------------------------------------------------------------------
@@ -169,6 +170,7 @@ extern void isc_start_capture(void);
 extern void isc_stop_capture(void);
 extern uint32_t isc_get_ctrl_status(void);
 extern void isc_update_profile(void);
+extern bool isc_request_profile_update(void);
 extern void isc_software_reset(void);
 
 /*------------------------------------------
@@ -27,6 +27,9 @@
  * ----------------------------------------------------------------------------
  */
 
+#include <string.h>
+
+#include "intmath.h"
 #include "irq/irq.h"
 
 #include "mm/cache.h"
@@ -37,6 +40,56 @@
 
 #include "trace.h"
 
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Gains are computed in Q16 */
+#define GAIN_ONE (1u << 16)
+
+/** Largest gain of the WB module (unsigned 0:4:9) in Q16 */
+#define GAIN_MAX (0x1fffu << 7)
+
+/** Smallest gain used by the 3A engine */
+#define GAIN_MIN (GAIN_ONE / 4)
+
+/** Fraction of the pixels allowed to clip after the exposure gain */
+#define AE_CLIP_SHIFT (6)
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+/** Histogram pipeline of the 3A engine, advanced at each frame start */
+enum _iscd_3a_state {
+	ISCD_3A_OFF = 0,
+	ISCD_3A_IDLE,    /**< Next histogram can be requested */
+	ISCD_3A_COMPUTE, /**< Histogram requested, waiting for HISDONE */
+	ISCD_3A_READ,    /**< Histogram entries being read by DMA */
+};
+
+/** State of the 3A engine */
+struct _iscd_3a {
+	struct _iscd_desc* iscd;
+	struct _iscd_3a_cfg cfg;
+	volatile uint8_t state;
+	volatile bool read_done;
+	uint32_t bay_sel;
+	uint8_t channel;                       /**< Component being captured */
+	uint8_t wr;                            /**< Buffer written by DMA */
+	uint8_t rd;                            /**< Buffer to process */
+	volatile bool ready[2];
+	uint8_t ready_channel[2];
+	bool profile_dirty;                    /**< Profile update to retry */
+	volatile bool gains_pending;
+	volatile uint16_t pending_gain[BAYER_COUNT];
+	uint32_t gain[BAYER_COUNT];            /**< Current gains, Q16 */
+	uint32_t high[BAYER_COUNT];            /**< Bin under the brightest pixels */
+	volatile uint32_t frame;
+	uint32_t disturb_frame;                /**< Frame the gains left target */
+	struct _iscd_3a_stats stats;
+};
+
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
@@ -49,6 +102,8 @@ CACHE_ALIGNED static union {
 
 static struct _iscd_awb awb;
 
+static struct _iscd_3a three_a;
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
@@ -168,6 +223,156 @@ static void _awb_count_up(uint32_t* buf)
 		awb.count[awb.op_mode] += (*buf++) * i;
 }
 
+/**
+ * \brief Callback entry for histogram DMA transfer done, 3A engine.
+ */
+static int _dma_3a_histo_callback(void *arg, void* arg2)
+{
+	if (three_a.state == ISCD_3A_OFF)
+		return _dma_histo_callback(three_a.iscd, arg2);
+
+	dma_reset_channel(awb.dma.dma_histo_channel);
+	cache_invalidate_region(three_a.cfg.histo_buf + three_a.wr * HIST_ENTRIES,
+			HIST_ENTRIES * sizeof(uint32_t));
+	three_a.read_done = true;
+
+	return 0;
+}
+
+/**
+ * \brief Advance the 3A histogram pipeline at the start of a frame.
+ *
+ * Gains computed since the last frame are written, a histogram read by DMA
+ * is handed to iscd_3a_process() and the histogram of the next component
+ * is requested, unless both buffers are still waiting to be processed.
+ * Called from the ISC interrupt.
+ */
+static void _iscd_3a_frame_start(void)
+{
+	bool update = three_a.profile_dirty;
+	bool request = false;
+	uint8_t i;
+
+	three_a.frame++;
+
+	if (three_a.gains_pending) {
+		isc_wb_adjust_bayer_color(0, 0, 0, 0,
+				three_a.pending_gain[HISTOGRAM_R],
+				three_a.pending_gain[HISTOGRAM_GR],
+				three_a.pending_gain[HISTOGRAM_B],
+				three_a.pending_gain[HISTOGRAM_GB]);
+		for (i = 0; i < BAYER_COUNT; i++)
+			three_a.stats.gain[i] = three_a.pending_gain[i];
+		three_a.gains_pending = false;
+		update = true;
+	}
+
+	if (three_a.state == ISCD_3A_READ && three_a.read_done) {
+		three_a.read_done = false;
+		three_a.ready_channel[three_a.wr] = three_a.channel;
+		three_a.ready[three_a.wr] = true;
+		three_a.wr ^= 1;
+		three_a.channel = (three_a.channel + 1) % BAYER_COUNT;
+		three_a.state = ISCD_3A_IDLE;
+	}
+
+	if (three_a.state == ISCD_3A_IDLE) {
+		if (three_a.ready[three_a.wr]) {
+			three_a.stats.stalls++;
+		} else {
+			isc_histogram_configure(three_a.channel, three_a.bay_sel, 1);
+			update = true;
+			request = true;
+		}
+	}
+
+	/* Histogram configuration and gains are applied together at the next
+	 * frame, retry on the following one if the ISC is busy */
+	if (update)
+		three_a.profile_dirty = !isc_request_profile_update();
+	if (request && !three_a.profile_dirty) {
+		isc_update_histogram_table();
+		three_a.state = ISCD_3A_COMPUTE;
+	}
+}
+
+/**
+ * \brief Compute the gains once the 4 components have been measured and
+ * move the current gains toward them.
+ */
+static void _iscd_3a_update(void)
+{
+	const uint32_t* mean = three_a.stats.mean;
+	uint32_t target[BAYER_COUNT];
+	uint32_t green, high, ae, tol;
+	bool within = true;
+	bool outside = false;
+	uint8_t i;
+
+	green = max_u32((mean[HISTOGRAM_GR] + mean[HISTOGRAM_GB]) / 2, 1);
+
+	/* Exposure: bring the green mean to target without clipping more
+	 * than 1/2^AE_CLIP_SHIFT of the pixels */
+	ae = GAIN_ONE;
+	if (three_a.cfg.ae_enable) {
+		high = max_u32(three_a.high[HISTOGRAM_GR], three_a.high[HISTOGRAM_GB]);
+		ae = (uint32_t)(((uint64_t)three_a.cfg.ae_target << 24) / green);
+		ae = min_u32(ae, (HIST_ENTRIES << 16) / (high + 1));
+	}
+
+	/* White balance: grey world, every component brought to the green
+	 * mean */
+	for (i = 0; i < BAYER_COUNT; i++) {
+		uint32_t awb_gain = GAIN_ONE;
+		if (three_a.cfg.awb_enable)
+			awb_gain = (uint32_t)(((uint64_t)green << 16) /
+					max_u32(mean[i], 1));
+		target[i] = (uint32_t)(((uint64_t)awb_gain * ae) >> 16);
+		target[i] = max_u32(min_u32(target[i], GAIN_MAX), GAIN_MIN);
+	}
+
+	for (i = 0; i < BAYER_COUNT; i++) {
+		int32_t diff = (int32_t)(target[i] - three_a.gain[i]);
+		int32_t step = diff >> three_a.cfg.smoothing;
+
+		/* First update jumps to target, later ones are smoothed */
+		if (!three_a.stats.updates)
+			step = diff;
+		else if (!step && diff)
+			step = diff > 0 ? 1 : -1;
+		three_a.gain[i] += step;
+
+		tol = target[i] >> three_a.cfg.tolerance;
+		diff = (int32_t)(target[i] - three_a.gain[i]);
+		if (abs_u32(diff) > tol)
+			within = false;
+		if (abs_u32(diff) > 2 * tol)
+			outside = true;
+	}
+
+	if (within && !three_a.stats.converged) {
+		uint32_t frames = three_a.frame - three_a.disturb_frame;
+		three_a.stats.converged = true;
+		three_a.stats.convergences++;
+		three_a.stats.convergence_frames = frames;
+		three_a.stats.max_convergence_frames =
+			max_u32(three_a.stats.max_convergence_frames, frames);
+	} else if (outside && three_a.stats.converged) {
+		three_a.stats.converged = false;
+		three_a.disturb_frame = three_a.frame;
+	}
+
+	/* Registers are written at the next frame start, the current gains
+	 * are published again on the next update if the previous ones are
+	 * still pending */
+	if (!three_a.gains_pending) {
+		for (i = 0; i < BAYER_COUNT; i++)
+			three_a.pending_gain[i] = min_u32(three_a.gain[i] >> 7, 0x1fff);
+		three_a.gains_pending = true;
+	}
+	three_a.stats.updates++;
+}
+
 /**
  * \brief ISC interrupt handler.
  */
@@ -185,8 +390,18 @@ static void _isc_handler(uint32_t source, void* arg)
 		if (iscd->dma.callback)
 			iscd->dma.callback(iscd->pipe.frame_idx);
 	}
-	if ((status & ISC_INTSR_HISDONE) == ISC_INTSR_HISDONE)
-		awb.dma.dma_histo_ready = true;
+	if ((status & ISC_INTSR_HISDONE) == ISC_INTSR_HISDONE) {
+		if (three_a.state == ISCD_3A_COMPUTE) {
+			three_a.state = ISCD_3A_READ;
+			_iscd_dma_read_histogram((uint32_t)(three_a.cfg.histo_buf +
+					three_a.wr * HIST_ENTRIES));
+		} else {
+			awb.dma.dma_histo_ready = true;
+		}
+	}
+	if ((status & ISC_INTSR_VD) == ISC_INTSR_VD &&
+	    three_a.state != ISCD_3A_OFF)
+		_iscd_3a_frame_start();
 }
 
 /**
@@ -464,3 +679,120 @@ void iscd_auto_white_balance_ref_algo(uint32_t* histo_buf)
 		break;
 	}
 }
+
+/**
+ * \brief Start the auto exposure / auto white balance engine.
+ *
+ * The histogram of one bayer component is captured per frame, or every
+ * other frame when the DMA read is not over before the next one starts,
+ * into a double buffer. iscd_3a_process() must then be called from a
+ * thread or the main loop to reduce the histograms and compute the gains,
+ * which are written to the white balance module at the next frame start.
+ * The pipe must have been started with histogram enabled.
+ *
+ * \param desc  ISC driver descriptor.
+ * \param cfg   Engine configuration.
+ * \return ISCD_OK on success, ISCD_ERROR_CONFIG if histogram is not
+ * available.
+ */
+uint8_t iscd_3a_start(struct _iscd_desc* desc, const struct _iscd_3a_cfg* cfg)
+{
+	struct _callback _cb;
+	uint8_t i;
+
+	if (!desc->pipe.histo_enable || !awb.dma.dma_histo_channel ||
+	    !cfg->histo_buf || cfg->tolerance < 1)
+		return ISCD_ERROR_CONFIG;
+
+	irq_disable(ID_ISC);
+	memset(&three_a, 0, sizeof(three_a));
+	three_a.iscd = desc;
+	three_a.cfg = *cfg;
+	if (!three_a.cfg.ae_target)
+		three_a.cfg.ae_target = ISCD_3A_AE_TARGET_DEFAULT;
+	three_a.bay_sel = ISC_HIS_CFG_BAYSEL(desc->pipe.bayer_pattern);
+	/* Gains programmed by iscd_pipe_start() */
+	for (i = 0; i < BAYER_COUNT; i++) {
+		three_a.gain[i] = GAIN_ONE;
+		three_a.stats.gain[i] = 0x200;
+	}
+
+	callback_set(&_cb, _dma_3a_histo_callback, NULL);
+	dma_set_callback(awb.dma.dma_histo_channel, &_cb);
+
+	three_a.state = ISCD_3A_IDLE;
+	irq_enable(ID_ISC);
+
+	return ISCD_OK;
+}
+
+/**
+ * \brief Stop the auto exposure / auto white balance engine, the last gains
+ * are kept.
+ */
+void iscd_3a_stop(void)
+{
+	irq_disable(ID_ISC);
+	three_a.state = ISCD_3A_OFF;
+	irq_enable(ID_ISC);
+}
+
+/**
+ * \brief Process the captured histograms, must be called regularly, at
+ * least once every two frames to avoid stalling the capture.
+ * \return true if new gains were computed.
+ */
+bool iscd_3a_process(void)
+{
+	const uint32_t* buf;
+	uint64_t sum = 0;
+	uint32_t count = 0;
+	uint32_t clip, above;
+	uint8_t channel;
+	int i;
+
+	if (three_a.state == ISCD_3A_OFF || !three_a.ready[three_a.rd])
+		return false;
+
+	buf = three_a.cfg.histo_buf + three_a.rd * HIST_ENTRIES;
+	channel = three_a.ready_channel[three_a.rd];
+
+	for (i = 0; i < HIST_ENTRIES; i++) {
+		count += buf[i];
+		sum += (uint64_t)buf[i] * i;
+	}
+
+	/* Find the bin under the brightest 1/2^AE_CLIP_SHIFT pixels */
+	clip = count >> AE_CLIP_SHIFT;
+	above = 0;
+	for (i = HIST_ENTRIES - 1; i > 0; i--) {
+		above += buf[i];
+		if (above > clip)
+			break;
+	}
+
+	three_a.ready[three_a.rd] = false;
+	three_a.rd ^= 1;
+	three_a.stats.histograms++;
+
+	if (count) {
+		three_a.stats.mean[channel] = (uint32_t)((sum << 8) / count);
+		three_a.high[channel] = i;
+	}
+
+	if (channel != HISTOGRAM_B)
+		return false;
+
+	_iscd_3a_update();
+	return true;
+}
+
+/**
+ * \brief Get the statistics of the auto exposure / auto white balance
+ * engine, including the time taken by the gains to converge.
+ */
+void iscd_3a_get_stats(struct _iscd_3a_stats* stats)
+{
+	*stats = three_a.stats;
+	stats->frames = three_a.frame;
+}
@@ -35,6 +35,7 @@
  *        Header
  *----------------------------------------------------------------------------*/
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "callback.h"
@@ -59,6 +60,9 @@
 
 #define HIST_ENTRIES (512)
 
+/** Default target of the auto exposure, mean of the green histograms */
+#define ISCD_3A_AE_TARGET_DEFAULT (HIST_ENTRIES / 5)
+
 #define ISCD_OK           (0)
 #define ISCD_ERROR_LOCK   (1)
 #define ISCD_ERROR_CONFIG (2)
@@ -161,6 +165,30 @@ struct _iscd_awb {
 	enum _iscd_awb_state state;
 };
 
+/** Configuration of the auto exposure / auto white balance engine */
+struct _iscd_3a_cfg {
+	uint32_t* histo_buf; /**< 2 * HIST_ENTRIES words, cache aligned */
+	bool ae_enable;      /**< Adjust the global gain */
+	bool awb_enable;     /**< Adjust the gain of each bayer component */
+	uint16_t ae_target;  /**< Green mean to reach, 0 for the default */
+	uint8_t smoothing;   /**< Gains move by 1/2^smoothing of the error */
+	uint8_t tolerance;   /**< Converged within 1/2^tolerance of target */
+};
+
+/** Statistics of the auto exposure / auto white balance engine */
+struct _iscd_3a_stats {
+	uint32_t frames;                 /**< Frames since the engine start */
+	uint32_t histograms;             /**< Channel histograms processed */
+	uint32_t stalls;                 /**< Frames without capture, processing late */
+	uint32_t updates;                /**< Gain updates computed */
+	uint32_t mean[BAYER_COUNT];      /**< Channel means, histogram bins in Q8 */
+	uint16_t gain[BAYER_COUNT];      /**< Gains written, unsigned 0:4:9 */
+	bool converged;                  /**< Gains within tolerance of target */
+	uint32_t convergences;           /**< Number of times gains converged */
+	uint32_t convergence_frames;     /**< Frames taken by the last convergence */
+	uint32_t max_convergence_frames; /**< Frames taken by the slowest one */
+};
+
 /*------------------------------------------------------------------------------
  *        Functions
  *----------------------------------------------------------------------------*/
@@ -169,4 +197,13 @@ extern uint8_t iscd_pipe_start(struct _iscd_desc* desc);
 
 extern void iscd_auto_white_balance_ref_algo(uint32_t* histo_buf);
 
+extern uint8_t iscd_3a_start(struct _iscd_desc* desc,
+		const struct _iscd_3a_cfg* cfg);
+
+extern void iscd_3a_stop(void);
+
+extern bool iscd_3a_process(void);
+
+extern void iscd_3a_get_stats(struct _iscd_3a_stats* stats);
+
 #endif /* ISCD_H_ */
@@ -119,6 +119,7 @@
 
 #include "compiler.h"
 
+#include "audio/audio_dsp.h"
 #include "mm/cache.h"
 #include "serial/console.h"
 
@@ -155,6 +156,12 @@
 /* record 10 seconds */
 #define SAMPLE_COUNT (10 * SAMPLE_RATE)
 
+/* capture block, 10ms */
+#define BLOCK_SAMPLES (SAMPLE_RATE / 100)
+
+/* capture ring, in blocks */
+#define CAPTURE_PERIODS (4)
+
 
 /*----------------------------------------------------------------------------
  *         Internal variables
@@ -163,6 +170,37 @@ static uint32_t _start_tick;
 
 CACHE_ALIGNED_DDR static uint16_t _sound_buffer[SAMPLE_COUNT];
 
+/* capture ring, periods are invalidated one by one so each block must
+ * span whole cache lines */
+CACHE_ALIGNED static int16_t _capture_ring[CAPTURE_PERIODS * BLOCK_SAMPLES];
+
+/* rumble filter: 2nd order Butterworth high-pass at 150Hz (fs = 48kHz) */
+static const struct _audio_biquad _rumble_filter[] = {
+	{ 16158, -32316, 16158, -32313, 15935 },
+};
+
+/* capture chain: DC blocking, rumble filter and AGC */
+static const struct _audio_dsp_config _dsp_config = {
+	.num_channels = 1,
+	.bits_per_sample = 16,
+	.dc_pole = 32604, /* 0.995 */
+	.biquads = _rumble_filter,
+	.num_biquads = ARRAY_SIZE(_rumble_filter),
+	.agc_target = 16000,
+	.agc_min_gain = AUDIO_DSP_AGC_UNITY / 4,
+	.agc_max_gain = AUDIO_DSP_AGC_UNITY * 8,
+	.agc_attack_shift = 6,
+	.agc_release_shift = 13,
+};
+
+static struct _audio_dsp _dsp;
+
+static bool _dsp_enabled = true;
+
+static struct {
+	volatile uint32_t recorded;
+} _capture;
+
 static volatile bool _sound_recorded = false;
 
 /** audio playing volume */
@@ -205,12 +243,33 @@ static int _audio_play_finish_callback(void* arg, void* arg2)
 }
 
 /**
- *  \brief DMA RX callback
+ *  \brief DMA RX period callback, runs the capture chain on the filled
+ *  blocks of the ring while the DMA keeps capturing in the others.
  */
-static int _audio_record_finish_callback(void* arg, void* arg2)
+static int _audio_record_period_callback(void* arg, void* arg2)
 {
-	mutex_unlock(&mutex.rx);
-	_record_stop();
+	int16_t *block;
+
+	if (!mutex_is_locked(&mutex.rx))
+		return 0;
+
+	while ((block = audio_get_period(&audio_record_device)) != NULL) {
+		int16_t *dest = (int16_t*)&_sound_buffer[_capture.recorded];
+
+		if (_dsp_enabled)
+			audio_dsp_process(&_dsp, block, BLOCK_SAMPLES * sizeof(int16_t), dest);
+		else
+			memcpy(dest, block, BLOCK_SAMPLES * sizeof(int16_t));
+		audio_ack_periods(&audio_record_device, 1);
+		_capture.recorded += BLOCK_SAMPLES;
+
+		if (_capture.recorded + BLOCK_SAMPLES > SAMPLE_COUNT) {
+			audio_stop(&audio_record_device);
+			mutex_unlock(&mutex.rx);
+			_record_stop();
+			break;
+		}
+	}
 
 	return 0;
 }
@@ -227,6 +286,8 @@ static void _display_menu(void)
 	printf("P -> Playback the record sound \n\r");
 	printf("+ -> Increase the volume of playback sound \n\r");
 	printf("- -> Decrease the volume of playback sound \n\r");
+	printf("F -> Enable/disable the capture chain (%s) \n\r",
+	       _dsp_enabled ? "enabled" : "disabled");
 	printf("=>");
 }
 
@@ -250,15 +311,28 @@ static void _play_start(void)
  */
 static void _record_sound(void)
 {
-	uint32_t  audio_length = SAMPLE_COUNT * 2;
 	struct _callback _cb;
 
 	mutex_lock(&mutex.rx);
+	memset(_sound_buffer, 0, sizeof(_sound_buffer));
+	audio_dsp_reset(&_dsp);
+	_capture.recorded = 0;
 	_record_start();
-	callback_set(&_cb, _audio_record_finish_callback, &audio_record_device);
-	audio_transfer(&audio_record_device, (void *)_sound_buffer, audio_length, &_cb);
+	callback_set(&_cb, _audio_record_period_callback, &audio_record_device);
+	if (audio_transfer_cyclic(&audio_record_device, _capture_ring,
+				  sizeof(_capture_ring), CAPTURE_PERIODS, &_cb) < 0) {
+		printf("Cannot start the capture\r\n");
+		mutex_unlock(&mutex.rx);
+		_record_stop();
+		return;
+	}
 
 	while (mutex_is_locked(&mutex.rx));
+
+	if (audio_get_xruns(&audio_record_device))
+		printf("%u blocks lost\r\n", (unsigned)audio_get_xruns(&audio_record_device));
+	if (_dsp_enabled && _dsp.clipped)
+		printf("%u samples clipped\r\n", (unsigned)_dsp.clipped);
 }
 
 /**
@@ -312,6 +386,9 @@ extern int main(void)
 	/* Configure audio play volume */
 	audio_set_volume(&audio_play_device, play_vol);
 
+	/* Configure the capture chain */
+	audio_dsp_init(&_dsp, &_dsp_config);
+
 	/* Infinite loop */
 	while (1) {
 		_display_menu();
@@ -322,6 +399,8 @@ extern int main(void)
 			_record_sound();
 		else if (key == 'p' || key == 'P')
 			_playback_sound();
+		else if (key == 'f' || key == 'F')
+			_dsp_enabled = !_dsp_enabled;
 		else if (key == '+') {
 			if (play_vol < AUDIO_PLAY_MAX_VOLUME) {
 				play_vol += 10;
@@ -0,0 +1,246 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page cache_dma Cache maintenance for DMA benchmark
+ *
+ * \section Purpose
+ *
+ * This example measures the cost of the cache maintenance done around DMA
+ * transfers, depending on the buffer size, to tune the thresholds used by
+ * the cache_dma_xxx functions.
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAMA5 and SAM9 boards, in DDRAM.
+ *
+ * \section Description
+ *
+ * For each buffer size, the buffer is written by the CPU to dirty the
+ * caches, then handed to a device and the time spent in the cache
+ * maintenance is measured with a free running TC channel:
+ * - legacy: cache_clean_region()
+ * - by line: cache_dma_map_for_device(), maintenance line by line only
+ * - whole L1: the L1 cache is cleaned by set/way, the L2 cache by line
+ * - whole: both caches are cleaned entirely
+ * - 8 maps / batch: the buffer split in 8 regions mapped one by one, then
+ *   as one struct _cache_dma_batch
+ *
+ * Invalidation for a device to memory transfer is measured the same way.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the evaluation board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 bauds
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed in nanoseconds.
+ *
+ * \section References
+ * - cache_dma/main.c
+ * - mm/cache.h
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+#include "chip.h"
+#include "compiler.h"
+#include "trace.h"
+
+#include "mm/cache.h"
+#include "peripherals/pmc.h"
+#include "peripherals/tc.h"
+#include "serial/console.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** TC channel used for the measures, next to the system timer */
+#define BENCH_TC       BOARD_TIMER_TC
+#define BENCH_CHANNEL  ((BOARD_TIMER_CHANNEL + 1) % 3)
+
+#define BUFFER_SIZE    (1024 * 1024)
+#define MIN_SIZE       256
+#define ROUNDS         8
+#define REGIONS        8
+
+#define L1_CACHE_SIZE  (L1_CACHE_WAYS * L1_CACHE_SETS * L1_CACHE_BYTES)
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+enum _bench_mode {
+	BENCH_LEGACY,
+	BENCH_BY_LINE,
+	BENCH_WHOLE_L1,
+	BENCH_WHOLE,
+	BENCH_SPLIT,
+	BENCH_BATCH,
+	BENCH_MODE_COUNT,
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+CACHE_ALIGNED_DDR static uint8_t buffer[BUFFER_SIZE];
+
+static uint32_t bench_freq;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _bench_timer_configure(void)
+{
+	uint32_t tc_id = get_tc_id_from_addr(BENCH_TC, BENCH_CHANNEL);
+	uint32_t clock_source;
+
+	if (!pmc_is_peripheral_enabled(tc_id))
+		pmc_configure_peripheral(tc_id, NULL, true);
+
+	clock_source = tc_find_best_clock_source(BENCH_TC, BENCH_CHANNEL, UINT32_MAX);
+	tc_configure(BENCH_TC, BENCH_CHANNEL, TC_CMR_WAVE | TC_CMR_WAVSEL_UP | clock_source);
+	bench_freq = tc_get_channel_freq(BENCH_TC, BENCH_CHANNEL);
+	tc_start(BENCH_TC, BENCH_CHANNEL);
+}
+
+static uint32_t _bench_ticks_to_ns(uint32_t ticks)
+{
+	return (uint32_t)(((uint64_t)ticks * 1000000000ull) / bench_freq);
+}
+
+static void _bench_map(enum _bench_mode mode, uint32_t size,
+		enum _cache_dma_dir dir)
+{
+	struct _cache_dma_batch batch;
+	uint32_t i, chunk = size / REGIONS;
+
+	switch (mode) {
+	case BENCH_LEGACY:
+		if (dir == CACHE_DMA_TO_DEVICE)
+			cache_clean_region(buffer, size);
+		else
+			cache_invalidate_region(buffer, size);
+		break;
+	case BENCH_SPLIT:
+		for (i = 0; i < REGIONS; i++)
+			cache_dma_map_for_device(buffer + i * chunk, chunk, dir);
+		break;
+	case BENCH_BATCH:
+		cache_dma_batch_init(&batch);
+		for (i = 0; i < REGIONS; i++)
+			cache_dma_batch_add(&batch, buffer + i * chunk, chunk, dir);
+		cache_dma_batch_map_for_device(&batch);
+		break;
+	default:
+		cache_dma_map_for_device(buffer, size, dir);
+		break;
+	}
+}
+
+static uint32_t _bench_run(enum _bench_mode mode, uint32_t size,
+		enum _cache_dma_dir dir)
+{
+	uint32_t round, start, total = 0;
+
+	switch (mode) {
+	case BENCH_WHOLE_L1:
+		cache_dma_set_thresholds(0, UINT32_MAX);
+		break;
+	case BENCH_WHOLE:
+		cache_dma_set_thresholds(0, 0);
+		break;
+	default:
+		cache_dma_set_thresholds(UINT32_MAX, UINT32_MAX);
+		break;
+	}
+
+	for (round = 0; round < ROUNDS; round++) {
+		/* the CPU fills the buffer, as before a transfer */
+		memset(buffer, round, size);
+
+		start = tc_get_cv(BENCH_TC, BENCH_CHANNEL);
+		_bench_map(mode, size, dir);
+		total += tc_get_cv(BENCH_TC, BENCH_CHANNEL) - start;
+	}
+
+	return _bench_ticks_to_ns(total / ROUNDS);
+}
+
+static void _bench_print(enum _cache_dma_dir dir)
+{
+	uint32_t size, mode;
+
+	printf("\r\n%s, times in ns\r\n", dir == CACHE_DMA_TO_DEVICE ?
+	       "Memory to device (clean)" : "Device to memory (invalidate)");
+	printf("    size    legacy   by line  whole L1     whole   8 maps     batch\r\n");
+	for (size = MIN_SIZE; size <= BUFFER_SIZE; size <<= 1) {
+		printf("%8u", (unsigned)size);
+		for (mode = 0; mode < BENCH_MODE_COUNT; mode++)
+			printf(" %9u", (unsigned)_bench_run(mode, size, dir));
+		printf("\r\n");
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	/* Output example information */
+	console_example_info("Cache DMA Benchmark");
+
+	_bench_timer_configure();
+	printf("Timer at %u Hz, L1 cache %u bytes\r\n",
+	       (unsigned)bench_freq, (unsigned)L1_CACHE_SIZE);
+
+	_bench_print(CACHE_DMA_TO_DEVICE);
+	_bench_print(CACHE_DMA_FROM_DEVICE);
+
+	cache_dma_set_thresholds(L1_CACHE_SIZE, CACHE_DMA_L2_THRESHOLD);
+
+	printf("\r\nDone\r\n");
+	while (1);
+}
@@ -70,12 +70,16 @@
  *      -- SAMxxxxxx-xx
  *      -- Compiled: xxx xx xxxx xx:xx:xx --
  *      \endcode
- *  -# Input command according to the menu.
+ *  -# Input command according to the menu:
+ *    - 'd' dumps raw TRNG values from the TRNG interrupt handler
+ *    - 'b' runs a throughput benchmark of the raw TRNG (polling), of the
+ *      buffered TRNG entropy pool and of the ChaCha20 generator seeded from it
  *
  * \section References
  * - trng/main.c
  * - trng.h
- * - trng.h
+ * - trngd.h
+ * - random.h
  */
 
 /** \file
@@ -93,9 +97,28 @@
 #include "serial/console.h"
 
 #include "crypto/trng.h"
+#include "crypto/trngd.h"
+
+#include "random.h"
+#include "timer.h"
 
+#include <ctype.h>
 #include <stdio.h>
 
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of bytes generated by each benchmark step */
+#define BENCH_TRNG_SIZE   (64 * 1024)
+#define BENCH_RANDOM_SIZE (4 * 1024 * 1024)
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint32_t bench_buffer[1024];
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
@@ -105,6 +128,83 @@ static void trng_callback(uint32_t random_value, void* user_arg)
 	printf("0x%08x\n\r", (unsigned int)random_value);
 }
 
+static void _display_menu(void)
+{
+	printf("\r\nSelect an option:\r\n");
+	printf("  d: dump raw TRNG values (any key to stop)\r\n");
+	printf("  b: run throughput benchmark\r\n");
+}
+
+static void _print_rate(const char* name, uint32_t bytes, uint64_t start, uint64_t end)
+{
+	uint32_t ms = (uint32_t)timer_get_interval(start, end);
+
+	if (ms == 0)
+		ms = 1;
+	printf("  %-24s %8u bytes in %6u ms: %6u KB/s\r\n", name,
+	       (unsigned)bytes, (unsigned)ms, (unsigned)(bytes / ms));
+}
+
+static void _dump(void)
+{
+	trng_enable();
+	trng_enable_it(&trng_callback, NULL);
+	console_get_char();
+	trng_disable_it();
+	trng_disable();
+}
+
+static void _benchmark(void)
+{
+	struct _trngd_stats stats;
+	uint64_t start;
+	uint32_t i, j;
+	int err;
+
+	printf("\r\nBenchmarking...\r\n");
+
+	/* Raw TRNG, one blocking read per word */
+	trng_enable();
+	start = timer_get_tick();
+	for (i = 0; i < BENCH_TRNG_SIZE; i += sizeof(bench_buffer))
+		for (j = 0; j < ARRAY_SIZE(bench_buffer); j++)
+			bench_buffer[j] = trng_get_random_data();
+	_print_rate("trng_get_random_data", BENCH_TRNG_SIZE, start, timer_get_tick());
+	trng_disable();
+
+	/* Interrupt-fed entropy pool */
+	trngd_init();
+	start = timer_get_tick();
+	for (i = 0; i < BENCH_TRNG_SIZE; i += sizeof(bench_buffer)) {
+		err = trngd_get_entropy((uint8_t*)bench_buffer, sizeof(bench_buffer), NULL);
+		if (err < 0) {
+			printf("  trngd_get_entropy failed (%d)\r\n", err);
+			trngd_cleanup();
+			return;
+		}
+	}
+	_print_rate("trngd_get_entropy", BENCH_TRNG_SIZE, start, timer_get_tick());
+
+	/* ChaCha20 generator, reseeded from the pool */
+	err = random_init(trngd_get_entropy, NULL);
+	if (err < 0) {
+		printf("  random_init failed (%d)\r\n", err);
+		trngd_cleanup();
+		return;
+	}
+	start = timer_get_tick();
+	for (i = 0; i < BENCH_RANDOM_SIZE; i += sizeof(bench_buffer))
+		random_fill(bench_buffer, sizeof(bench_buffer));
+	_print_rate("random_fill", BENCH_RANDOM_SIZE, start, timer_get_tick());
+
+	trngd_get_stats(&stats);
+	printf("  pool: produced=%u consumed=%u paused=%u rct=%u apt=%u\r\n",
+	       (unsigned)stats.produced, (unsigned)stats.consumed,
+	       (unsigned)stats.pool_full, (unsigned)stats.rct_failures,
+	       (unsigned)stats.apt_failures);
+	trngd_cleanup();
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -120,8 +220,20 @@ int main(void)
 	/* Output example information */
 	console_example_info("TRNG Example");
 
-	trng_enable();
-	trng_enable_it(&trng_callback, NULL);
+	_display_menu();
 
-	while (1) ;
+	while (1) {
+		switch (tolower(console_get_char())) {
+		case 'd':
+			_dump();
+			_display_menu();
+			break;
+		case 'b':
+			_benchmark();
+			_display_menu();
+			break;
+		default:
+			break;
+		}
+	}
 }
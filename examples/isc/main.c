@@ -134,7 +134,8 @@
 /** Supported sensor profiles */
 static struct sensor_profile *sensor;
 
-CACHE_ALIGNED uint32_t buffer_histogram[HIST_ENTRIES];
+/** Histogram double buffer of the AE/AWB engine */
+CACHE_ALIGNED uint32_t buffer_histogram[2 * HIST_ENTRIES];
 
 /** LCD buffer.*/
 static uint8_t *heo_buffer = (uint8_t*)ISC_OUTPUT_BASE_ADDRESS;
@@ -150,6 +151,7 @@ static uint8_t sensor_mode;
 /* LCD mode */
 static uint32_t lcd_mode;
 static bool awb;
+static bool converged;
 static struct _iscd_desc iscd;
 /* Color space matrix setting */
 static struct _color_space ref_cs = {
@@ -356,17 +358,36 @@ restart_sensor:
 			switch (key) {
 			case 'S':
 			case 's':
+				iscd_3a_stop();
 				isc_stop_capture();
 				goto restart_sensor;
 			case 'A':
 			case 'a':
-				if (sensor_mode == RAW_BAYER)
-					awb = true;
+				if (sensor_mode == RAW_BAYER && !awb) {
+					struct _iscd_3a_cfg cfg_3a = {
+						.histo_buf = buffer_histogram,
+						.ae_enable = true,
+						.awb_enable = true,
+						.smoothing = 2,
+						.tolerance = 5,
+					};
+					awb = iscd_3a_start(&iscd, &cfg_3a) == ISCD_OK;
+					converged = false;
+				}
 				break;
 			}
 		}
-		if (awb)
-			iscd_auto_white_balance_ref_algo(iscd.pipe.histo_buf);
+		if (awb && iscd_3a_process()) {
+			struct _iscd_3a_stats stats;
+			iscd_3a_get_stats(&stats);
+			if (stats.converged && !converged)
+				printf("-I- AE/AWB converged in %u frames, gains R %x G %x B %x\n\r",
+						(unsigned)stats.convergence_frames,
+						(unsigned)stats.gain[HISTOGRAM_R],
+						(unsigned)stats.gain[HISTOGRAM_GR],
+						(unsigned)stats.gain[HISTOGRAM_B]);
+			converged = stats.converged;
+		}
 	}
 
 }
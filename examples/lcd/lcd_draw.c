@@ -32,6 +32,10 @@
  * Implementation of draw function on LCD, Include draw text, image
  * and basic shapes (line, rectangle, circle).
  *
+ * The drawing itself is done by the graphics library (graphics/raster.h)
+ * on the current canvas, which also tracks the modified lines so that
+ * lcd_flush() only cleans the cache where needed.
+ *
  */
 
 /** \file */
@@ -45,9 +49,11 @@
 
 #include "display/lcdc.h"
 
+#include "graphics/font.h"
+#include "graphics/raster.h"
+
 #include "lcd_draw.h"
 #include "lcd_font.h"
-#include "font.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -57,230 +63,121 @@
  *        Local variable
  *----------------------------------------------------------------------------*/
 
-/** Front color cache */
-static uint32_t front_color;
+/** Raster bound to the current canvas */
+static struct _raster _raster;
 
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
 
 /**
- * Hide canvas layer
- */
-static void _hide_canvas(void)
-{
-	//lcdc_enable_layer(lcdc_get_canvas()->layer_id, false);
-}
-
-/**
- * Update canvas
+ * Draw the corners of a rounded rectangle
  */
-static void _show_canvas(void)
-{
-	//lcdc_enable_layer(lcdc_get_canvas()->layer_id, true);
-}
-
-/**
- * Set front color
- * \param color Pixel color.
- */
-static void _set_front_color(uint32_t color)
+static void _lcd_draw_circle (uint32_t x0, uint32_t y0, uint32_t r, uint8_t corner, uint32_t color)
 {
-	front_color = color;
-}
+	struct _raster *raster = lcd_get_raster();
+	int32_t f = 1 - r;
+	int32_t ddF_x = 1;
+	int32_t ddF_y = -2 * (int32_t)r;
+	int32_t x = 0;
+	int32_t y = r;
 
-/**
- * \brief Draw a pixel on LCD of front color.
- *
- * \param dwX       X-coordinate of pixel.
- * \param dwY       Y-coordinate of pixel.
- */
-static void _draw_pixel(uint32_t dwX, uint32_t dwY)
-{
-	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	uint8_t *buffer = pDisp->buffer;
-	uint16_t w = pDisp->width;
-	//uint16_t h = pDisp->height;
-	uint16_t cw = pDisp->bpp / 8;	/* color width */
-	uint32_t rw = w * cw;	/* row width in bytes */
-	//uint8_t  r, g, b;
-	uint8_t *pPix;
-
-	if (buffer == NULL)
-		return;
-
-	if (rw & 0x3)
-		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
-	pPix = &buffer[dwY * rw + cw * dwX];
-
-	switch (pDisp->bpp) {
-	case 16:		/* TRGB 1555 */
-		pPix[0] = (front_color) & 0xFF;
-		pPix[1] = (front_color >> 8) & 0xFF;
-		break;
-	case 24:		/*  RGB  888 */
-		pPix[0] = (front_color) & 0xFF;
-		pPix[1] = (front_color >> 8) & 0xFF;
-		pPix[2] = (front_color >> 16) & 0xFF;
-		break;
-	case 32:		/* ARGB 8888 */
-		pPix[0] = (front_color) & 0xFF;
-		pPix[1] = (front_color >> 8) & 0xFF;
-		pPix[2] = (front_color >> 16) & 0xFF;
-		pPix[3] = (front_color >> 24) & 0xFF;
-		break;
+	while (x<y) {
+		if (f >= 0)
+		{
+			y--;
+			ddF_y += 2;
+			f     += ddF_y;
+		}
+		x++;
+		ddF_x += 2;
+		f     += ddF_x;
+		if (corner & 0x4) {
+			raster_draw_pixel(raster, x0 + x, y0 + y, color);
+			raster_draw_pixel(raster, x0 + y, y0 + x, color);
+		}
+		if (corner & 0x2) {
+			raster_draw_pixel(raster, x0 + x, y0 - y, color);
+			raster_draw_pixel(raster, x0 + y, y0 - x, color);
+		}
+		if (corner & 0x8) {
+			raster_draw_pixel(raster, x0 - y, y0 + x, color);
+			raster_draw_pixel(raster, x0 - x, y0 + y, color);
+		}
+		if (corner & 0x1) {
+			raster_draw_pixel(raster, x0 - y, y0 - x, color);
+			raster_draw_pixel(raster, x0 - x, y0 - y, color);
+		}
 	}
 }
 
 /**
- * \brief Fill rectangle with front color.
- * \param dwX1  X-coordinate of top left.
- * \param dwY1  Y-coordinate of top left.
- * \param dwX2  X-coordinate of bottom right.
- * \param dwY1  Y-coordinate of bottom right.
+ * Fill the corners of a rounded rectangle
  */
-static void _fill_rect(uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2)
+static void _lcd_fill_circle (uint32_t x0, uint32_t y0, uint32_t r, uint8_t corner, uint32_t delta, uint32_t color)
 {
-	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	uint16_t w = pDisp->width;
-	uint16_t cw = pDisp->bpp / 8;	/* color width */
-	uint32_t rw = w * cw;	/* row width in bytes */
-	uint8_t *base;
-	uint8_t *buffer = pDisp->buffer;
-	uint32_t fillStart, fillEnd;
-	uint32_t i;
-	if (buffer == NULL)
-		return;
-
-	/* 4-byte aligned rows */
-	if (rw & 0x3)
-		rw = (rw | 0x3) + 1;
-	/* Buffer address for the starting row */
-	base = &buffer[dwY1 * rw];
-
-	fillStart = dwX1 * cw;
-	fillEnd = dwX2 * cw;
-
-#if 1				/* Memcopy pixel */
-	buffer = base;
-	for (; dwY1 <= dwY2; dwY1++) {
-		for (i = fillStart; i <= fillEnd; i += cw) {
-			memcpy(&buffer[i], &front_color, cw);
-		}
-		buffer = &buffer[rw];
-	}
-#endif
+	struct _raster *raster = lcd_get_raster();
+	int32_t f = 1 - r;
+	int32_t ddF_x = 1;
+	int32_t ddF_y = -2 * (int32_t)r;
+	int32_t x = 0;
+	int32_t y = r;
 
-#if 0				/* Pixel by pixel */
-	for (; dwY1 <= dwY2; dwY1++) {
-		for (i = dwX1; i <= dwX2; i++) {
-			_draw_pixel(i, dwY1);
+	while (x<y) {
+		if (f >= 0) {
+			y--;
+			ddF_y += 2;
+			f += ddF_y;
 		}
-	}
-#endif
+		x++;
+		ddF_x += 2;
+		f += ddF_x;
 
-#if 0				/* Optimized */
-	/* First row */
-	for (i = fillStart; i <= fillEnd; i += cw) {
-		memcpy(&base[i], &front_color, cw);
-	}
-	/* Next rows, copy first */
-	buffer = &base[rw + fillStart];
-	for (i = dwY1 + 1; i <= dwY2; i++) {
-		memcpy(buffer, &base[fillStart], fillEnd - fillStart + cw);
-		buffer = &buffer[rw];
+		if (corner & 0x1) {
+			raster_draw_vline(raster, x0+x, y0-y, 2*y+1+delta, color);
+			raster_draw_vline(raster, x0+y, y0-x, 2*x+1+delta, color);
+		}
+		if (corner & 0x2) {
+			raster_draw_vline(raster, x0-x, y0-y, 2*y+1+delta, color);
+			raster_draw_vline(raster, x0-y, y0-x, 2*x+1+delta, color);
+		}
 	}
-#endif
 }
 
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
 /**
- * \brief Draw a line on LCD, which is not horizontal or vertical.
+ * \brief Get the raster of the current canvas.
  *
- * \param dwX1       X-coordinate of line start.
- * \param dwY1       Y-coordinate of line start.
- * \param dwX2       X-coordinate of line end.
- * \param dwY2       Y-coordinate of line end.
+ * The raster is bound again when the canvas buffer or geometry changed, in
+ * which case the pending dirty region of the previous canvas is lost: call
+ * lcd_flush() before selecting another canvas.
  */
-
-/*
-static uint32_t _draw_line_bresenham (uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2)
+struct _raster* lcd_get_raster(void)
 {
-	int dx, dy;
-	int i;
-	int xinc, yinc, cumul;
-	int x, y;
-
-	x = dwX1;
-	y = dwY1;
-	dx = dwX2 - dwX1;
-	dy = dwY2 - dwY1;
-
-	xinc = (dx > 0) ? 1 : -1;
-	yinc = (dy > 0) ? 1 : -1;
-	dx = (dx > 0) ? dx : -dx;
-	dy = (dy > 0) ? dy : -dy;
-
-	_draw_pixel(x, y);
-
-	if (dx > dy) {
-		cumul = dx / 2;
-		for (i = 1; i <= dx; i++) {
-			x += xinc;
-			cumul += dy;
-
-			if (cumul >= dx) {
-				cumul -= dx;
-				y += yinc;
-			}
-			_draw_pixel(x, y);
-		}
-	} else {
-		cumul = dy / 2;
-		for (i = 1; i <= dy; i++) {
-			y += yinc;
-			cumul += dx;
-
-			if (cumul >= dy) {
-				cumul -= dy;
-				x += xinc;
-			}
-
-			_draw_pixel(x, y);
-		}
-	}
+	struct _lcdc_layer *pDisp = lcdc_get_canvas();
 
-	return 0;
+	if (_raster.buffer != pDisp->buffer ||
+	    _raster.width != pDisp->width ||
+	    _raster.height != pDisp->height ||
+	    _raster.bpp != pDisp->bpp) {
+		if (raster_init(&_raster, pDisp->buffer, pDisp->width,
+				pDisp->height, pDisp->bpp, 0) < 0)
+			raster_init(&_raster, NULL, 0, 0, 32, 0);
+	}
+	return &_raster;
 }
-*/
 
-static uint32_t _draw_line_bresenham (uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2)
+/**
+ * \brief Clean the cache for the canvas lines modified since the last call.
+ */
+void lcd_flush(void)
 {
-    int dx = abs(dwX2 - dwX1);
-    int dy = abs(dwY2 - dwY1);
-    int sx = (dwX1 < dwX2) ? 1 : -1;
-    int sy = (dwY1 < dwY2) ? 1 : -1;
-    int err = dx - dy;
-    int e2 ;
-
-    while (1) {
-      _draw_pixel(dwX1, dwY1);
-      if ((dwX1 == dwX2) && (dwY1 == dwY2))
-        break;
-      e2 = 2 * err;
-	  if (e2 > -dy) {
-		  err -= dy; dwX1 += sx;
-	  }
-      if (e2 < dx) {
-		  err += dx; dwY1 += sy;
-	  }
-    }
-	return 0;
+	raster_flush(lcd_get_raster());
 }
 
-/*----------------------------------------------------------------------------
- *        Exported functions
- *----------------------------------------------------------------------------*/
-
 /**
  * \brief Fills the given LCD buffer with a particular color.
  *
@@ -288,88 +185,49 @@ static uint32_t _draw_line_bresenham (uint32_t dwX1, uint32_t dwY1, uint32_t dwX
  */
 void lcd_fill(uint32_t color)
 {
-	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	_set_front_color(color);
-	_hide_canvas();
-	_fill_rect(0, 0, pDisp->width, pDisp->height);
-	_show_canvas();
+	struct _raster *raster = lcd_get_raster();
+
+	raster_fill_rect(raster, 0, 0, raster->width, raster->height, color);
 }
 
 void lcd_fill_white(void)
 {
-	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	_hide_canvas();
-	_set_front_color(0x0000FF);
-	_fill_rect(0, 0, pDisp->width / 3, pDisp->height);
-	_set_front_color(0xFFFFFF);
-	_fill_rect(pDisp->width/3, 0, pDisp->width/3+pDisp->width/3, pDisp->height);
-	_set_front_color(0xFF0000);
-	_fill_rect(pDisp->width/3+pDisp->width/3, 0, pDisp->width-1, pDisp->height);
-	_show_canvas();
+	struct _raster *raster = lcd_get_raster();
+	uint32_t third = raster->width / 3;
+
+	raster_fill_rect(raster, 0, 0, third, raster->height, 0x0000FF);
+	raster_fill_rect(raster, third, 0, third, raster->height, 0xFFFFFF);
+	raster_fill_rect(raster, 2 * third, 0, raster->width - 2 * third,
+			raster->height, 0xFF0000);
 }
 
 void lcd_fill_yuv422(void)
 {
+	/* Y0 Cb Y1 Cr of the left and right halves of each band */
+	static const uint8_t bars[8][2][4] = {
+		{ {  81, 239,  81,  90 }, { 165, 180, 165,  42 } },
+		{ { 107, 202, 107, 222 }, { 127, 134, 127, 102 } },
+		{ { 170,  16, 170, 166 }, {  40, 109,  40, 239 } },
+		{ { 144,  34, 144,  53 }, {  81, 239,  81,  90 } },
+		{ {  40, 109,  40, 239 }, { 107, 202, 107, 222 } },
+		{ { 211, 146, 211,  15 }, { 127, 134, 127, 102 } },
+		{ { 165, 180, 165,  42 }, { 144,  34, 144,  53 } },
+		{ { 127, 134, 127, 102 }, { 170,  16, 170, 166 } },
+	};
 	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	uint8_t *buffur = pDisp->buffer;
-	uint32_t i;
-	uint32_t h = pDisp->width;
-	uint32_t v = pDisp->height;
-	for(i=0;i<h*v*2/8;) {
-		if(((i/h)%2)==0) {
-			buffur[i++]=81; buffur[i++]=239;buffur[i++]=81;buffur[i++]=90;
-		} else {
-			buffur[i++]=165;buffur[i++]=180;buffur[i++]=165;buffur[i++]=42;
-		}
-	}
-	for(i=h*v*2/8;i<h*v*2/8*2;) {
-		if(((i/h)%2)==0) {
-			buffur[i++]=107; buffur[i++]=202;buffur[i++]=107;buffur[i++]=222;
-		} else {
-			buffur[i++]=127;buffur[i++]=134;buffur[i++]=127;buffur[i++]=102;
-		}
-	}
-	for(i=h*v*2/8*2;i<h*v*2/8*3;) {
-		if(((i/h)%2)==0) {
-			buffur[i++]=170; buffur[i++]=16;buffur[i++]=170;buffur[i++]=166;
-		} else {
-			buffur[i++]=40;buffur[i++]=109;buffur[i++]=40;buffur[i++]=239;
-		}
-	}
-	for(i=h*v*2/8*3;i<h*v*2/8*4;) {
-		if(((i/h)%2)==0) {
-			buffur[i++]=144;buffur[i++]=34;buffur[i++]=144;buffur[i++]=53;
-		} else {
-			buffur[i++]=81; buffur[i++]=239;buffur[i++]=81;buffur[i++]=90;
-		}
-	}
-	for(i=h*v*2/8*4;i<h*v*2/8*5;) {
-		if(((i/h)%2)==0) {
-			buffur[i++]=40;buffur[i++]=109;buffur[i++]=40;buffur[i++]=239;
-		} else {
-			buffur[i++]=107; buffur[i++]=202;buffur[i++]=107;buffur[i++]=222;
-		}
-	}
-	for(i=h*v*2/8*5;i<h*v*2/8*6;) {
-		if(((i/h)%2)==0) {
-			buffur[i++]=211;buffur[i++]=146;buffur[i++]=211;buffur[i++]=15;
-		} else {
-			buffur[i++]=127;buffur[i++]=134;buffur[i++]=127;buffur[i++]=102;
-		}
-	}
-	for(i=h*v*2/8*6;i<h*v*2/8*7;) {
-		if(((i/h)%2)==0) {
-			buffur[i++]=165;buffur[i++]=180;buffur[i++]=165;buffur[i++]=42;
-		} else {
-			buffur[i++]=144;buffur[i++]=34;buffur[i++]=144;buffur[i++]=53;
-		}
-	}
-	for(i=h*v*2/8*7;i<h*v*2/8*8;) {
-		if(((i/h)%2)==0) {
-			buffur[i++]=127;buffur[i++]=134;buffur[i++]=127;buffur[i++]=102;
-		} else {
-			buffur[i++]=170; buffur[i++]=16;buffur[i++]=170;buffur[i++]=166;
-		}
+	uint8_t *buffer = pDisp->buffer;
+	uint32_t line = pDisp->width * 2;
+	uint32_t band = pDisp->height / 8;
+	uint32_t i, j;
+
+	for (i = 0; i < 8; i++) {
+		uint8_t *first = buffer + i * band * line;
+
+		/* Build the first line of the band and copy it to the others */
+		for (j = 0; j < line; j += 4)
+			memcpy(first + j, bars[i][j >= line / 2], 4);
+		for (j = 1; j < band; j++)
+			memcpy(first + j * line, first, line);
 	}
 }
 
@@ -382,10 +240,7 @@ void lcd_fill_yuv422(void)
  */
 void lcd_draw_pixel(uint32_t x, uint32_t y, uint32_t color)
 {
-	_set_front_color(color);
-	_hide_canvas();
-	_draw_pixel(x, y);
-	_show_canvas();
+	raster_draw_pixel(lcd_get_raster(), x, y, color);
 }
 
 /**
@@ -398,40 +253,11 @@ void lcd_draw_pixel(uint32_t x, uint32_t y, uint32_t color)
  */
 extern uint32_t lcd_read_pixel(uint32_t x, uint32_t y)
 {
-	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	uint8_t *buffer = pDisp->buffer;
-	uint16_t w = pDisp->width;
-	//uint16_t h = pDisp->height;
-	uint16_t cw = pDisp->bpp / 8;	/* color width */
-	uint32_t rw = w * cw;	/* row width in bytes */
-	uint8_t *pPix;
-	uint32_t color = 0;
-
-	if (buffer == NULL)
-		return 0;
-
-	if (rw & 0x3)
-		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
-	pPix = &buffer[x * rw + cw * y];
-
-	switch (pDisp->bpp) {
-	case 16:		/* TRGB 1555 */
-		color = pPix[0] | (pPix[1] << 8);
-		break;
-	case 24:		/*  RGB  888 */
-		color = pPix[0] | (pPix[1] << 8) | (pPix[2] << 16);
-		break;
-	case 32:		/* ARGB 8888 */
-		color =
-			pPix[0] | (pPix[1] << 8) | (pPix[2] << 16) | (pPix[3] <<
-								      24);
-		break;
-	}
-	return color;
+	return raster_read_pixel(lcd_get_raster(), x, y);
 }
 
 /**
- * \brief Draw a line on LCD, horizontal and vertical line are supported.
+ * \brief Draw a line on LCD.
  *
  * \param x1        X-coordinate of line start.
  * \param y1        Y-coordinate of line start.
@@ -442,22 +268,7 @@ extern uint32_t lcd_read_pixel(uint32_t x, uint32_t y)
 void lcd_draw_line(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2,
 		    uint32_t color)
 {
-	_set_front_color(color);
-
-	if ((x1 == x2) && (y1 > y2)) {
-		SWAP(y1, y2);
-	}
-	if ((x1 > x2) & (y1 == y2)) {
-		SWAP(x1, x2);
-	}
-
-	if ((x1 == x2) || (y1 == y2)) {
-		lcd_draw_filled_rectangle(x1, y1, x2, y2, color);
-	} else {
-		_hide_canvas();
-		_draw_line_bresenham(x1, y1, x2, y2);
-		_show_canvas();
-	}
+	raster_draw_line(lcd_get_raster(), x1, y1, x2, y2, color);
 }
 
 /**
@@ -472,16 +283,7 @@ void lcd_draw_line(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2,
 void lcd_draw_rectangle(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
 			 uint32_t color)
 {
-	uint32_t x1 = x + width - 1;
-	uint32_t y1 = y + height - 1;
-
-	_set_front_color(color);
-	_hide_canvas();
-	_fill_rect(x, y, x1, y);
-	_fill_rect(x1, y, x1, y1);
-	_fill_rect(x, y, x, y1);
-	_fill_rect(x, y1, x1, y1);
-	_show_canvas();
+	raster_draw_rect(lcd_get_raster(), x, y, width, height, color);
 }
 
 /**
@@ -496,10 +298,12 @@ void lcd_draw_rectangle(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
 void lcd_draw_filled_rectangle(uint32_t dwX1, uint32_t dwY1,
 				uint32_t dwX2, uint32_t dwY2, uint32_t color)
 {
-	_set_front_color(color);
-	_hide_canvas();
-	_fill_rect(dwX1, dwY1, dwX2, dwY2);
-	_show_canvas();
+	if (dwX1 > dwX2)
+		SWAP(dwX1, dwX2);
+	if (dwY1 > dwY2)
+		SWAP(dwY1, dwY2);
+	raster_fill_rect(lcd_get_raster(), dwX1, dwY1, dwX2 - dwX1 + 1,
+			dwY2 - dwY1 + 1, color);
 }
 
 /**
@@ -512,38 +316,7 @@ void lcd_draw_filled_rectangle(uint32_t dwX1, uint32_t dwY1,
  */
 void lcd_draw_circle(uint32_t dwX, uint32_t dwY, uint32_t dwR, uint32_t color)
 {
-	int32_t d;		/* Decision Variable */
-	uint32_t curX;		/* Current X Value */
-	uint32_t curY;		/* Current Y Value */
-
-	if (dwR == 0)
-		return;
-	_set_front_color(color);
-
-	d = 3 - (dwR << 1);
-	curX = 0;
-	curY = dwR;
-
-	_hide_canvas();
-	while (curX <= curY) {
-		_draw_pixel(dwX + curX, dwY + curY);
-		_draw_pixel(dwX + curX, dwY - curY);
-		_draw_pixel(dwX - curX, dwY + curY);
-		_draw_pixel(dwX - curX, dwY - curY);
-		_draw_pixel(dwX + curY, dwY + curX);
-		_draw_pixel(dwX + curY, dwY - curX);
-		_draw_pixel(dwX - curY, dwY + curX);
-		_draw_pixel(dwX - curY, dwY - curX);
-
-		if (d < 0) {
-			d += (curX << 2) + 6;
-		} else {
-			d += ((curX - curY) << 2) + 10;
-			curY--;
-		}
-		curX++;
-	}
-	_show_canvas();
+	raster_draw_circle(lcd_get_raster(), dwX, dwY, dwR, color);
 }
 
 /**
@@ -557,40 +330,7 @@ void lcd_draw_circle(uint32_t dwX, uint32_t dwY, uint32_t dwR, uint32_t color)
 void lcd_draw_filled_circle(uint32_t dwX, uint32_t dwY, uint32_t dwR,
 			     uint32_t color)
 {
-	signed int d;		// Decision Variable
-	uint32_t dwCurX;	// Current X Value
-	uint32_t dwCurY;	// Current Y Value
-	uint32_t dwXmin, dwYmin;
-
-	if (dwR == 0)
-		return;
-	_set_front_color(color);
-
-	d = 3 - (dwR << 1);
-	dwCurX = 0;
-	dwCurY = dwR;
-
-	_hide_canvas();
-	while (dwCurX <= dwCurY) {
-		dwXmin = (dwCurX > dwX) ? 0 : dwX - dwCurX;
-		dwYmin = (dwCurY > dwY) ? 0 : dwY - dwCurY;
-		_fill_rect(dwXmin, dwYmin, dwX + dwCurX, dwYmin);
-		_fill_rect(dwXmin, dwY + dwCurY, dwX + dwCurX, dwY + dwCurY);
-		dwXmin = (dwCurY > dwX) ? 0 : dwX - dwCurY;
-		dwYmin = (dwCurX > dwY) ? 0 : dwY - dwCurX;
-		_fill_rect(dwXmin, dwYmin, dwX + dwCurY, dwYmin);
-		_fill_rect(dwXmin, dwY + dwCurX, dwX + dwCurY, dwY + dwCurX);
-
-		if (d < 0) {
-			d += (dwCurX << 2) + 6;
-		} else {
-			d += ((dwCurX - dwCurY) << 2) + 10;
-			dwCurY--;
-		}
-
-		dwCurX++;
-	}
-	_show_canvas();
+	raster_fill_circle(lcd_get_raster(), dwX, dwY, dwR, color);
 }
 
 /**
@@ -604,28 +344,8 @@ void lcd_draw_filled_circle(uint32_t dwX, uint32_t dwY, uint32_t dwR,
  */
 void lcd_draw_string(uint32_t x, uint32_t y, const char *p_string, uint32_t color)
 {
-	uint32_t xorg = x;
-	uint8_t font_sel = lcd_get_selected_font();
-	uint8_t width = font_param[font_sel].width ;
-	uint8_t height = font_param[font_sel].height;
-	uint8_t char_space = font_param[font_sel].char_space;
-
-	/* Font 10*8 reverse height and width */
-	if (font_sel == FONT10x8) {
-		width = font_param[font_sel].height ;
-		height = font_param[font_sel].width;
-	}
-
-	while (*p_string) {
-		if (*p_string == '\n') {
-			y += height + char_space;
-			x = xorg;
-		} else {
-			lcd_draw_char(x, y, *p_string, color);
-			x += width + char_space;
-		}
-		p_string++;
-	}
+	raster_draw_string(lcd_get_raster(), lcd_get_selected_font(), x, y,
+			p_string, color);
 }
 
 /**
@@ -643,28 +363,8 @@ void lcd_draw_string_with_bgcolor(uint32_t x, uint32_t y,
 								   uint32_t fontColor,
 								   uint32_t bgColor)
 {
-	uint32_t xorg = x;
-	uint8_t font_sel = lcd_get_selected_font();
-	uint8_t width = font_param[font_sel].width ;
-	uint8_t height = font_param[font_sel].height;
-	uint8_t char_space = font_param[font_sel].char_space;
-
-	/* Font 10*8 reverse height and width */
-	if (font_sel == FONT10x8) {
-		width = font_param[font_sel].height ;
-		height = font_param[font_sel].width;
-	}
-
-	while (*p_string) {
-		if (*p_string == '\n') {
-			y += height + char_space;;
-			x = xorg;
-		} else {
-			lcd_draw_char_with_bgcolor(x, y, *p_string, fontColor, bgColor);
-			x += width + char_space;;
-		}
-		p_string++;
-	}
+	raster_draw_string_with_bgcolor(lcd_get_raster(),
+			lcd_get_selected_font(), x, y, p_string, fontColor, bgColor);
 }
 
 /**
@@ -674,37 +374,11 @@ void lcd_draw_string_with_bgcolor(uint32_t x, uint32_t y,
  * \param p_string  String.
  * \param p_width   Pointer for storing the string width (optional).
  * \param p_height  Pointer for storing the string height (optional).
- *
- * \return String width in pixels.
  */
 void lcd_get_string_size(const char *p_string, uint32_t * p_width, uint32_t * p_height)
 {
-	uint8_t font_sel = lcd_get_selected_font();
-	uint8_t width = font_param[font_sel].width;
-	uint8_t height = font_param[font_sel].height;
-	uint8_t char_space = font_param[font_sel].char_space;
-	uint32_t str_width = 0;
-
-	/* Font 10*8 reverse height and width */
-	if (font_sel == FONT10x8) {
-		width = font_param[font_sel].height ;
-		height = font_param[font_sel].width;
-	}
-
-	while (*p_string) {
-		if (*p_string == '\n')
-			height += height + char_space;
-		else
-			str_width += width + char_space;
-		p_string++;
-	}
-	if (width > 0)
-		str_width -= char_space;
-
-	if (p_width != NULL)
-		*p_width = str_width;
-	if (p_height != NULL)
-		*p_height = height;
+	raster_get_string_size(lcd_get_selected_font(), p_string, p_width,
+			p_height);
 }
 
 /**
@@ -712,31 +386,17 @@ void lcd_get_string_size(const char *p_string, uint32_t * p_width, uint32_t * p_
  *
  * \param dwX       X-coordinate of image start.
  * \param dwY       Y-coordinate of image start.
- * \param pImage    Image buffer.
+ * \param pImage    Image buffer, lines padded to 4 bytes.
  * \param width     Image width.
  * \param height    Image height.
  */
 void lcd_draw_image(uint32_t dwX, uint32_t dwY, const uint8_t * pImage,
 		     uint32_t width, uint32_t height)
 {
-	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	uint16_t cw = pDisp->bpp / 8;	/* color width */
-	uint32_t rw = pDisp->width * cw;	/* Row width in bytes */
-	uint32_t rws = width * cw;	/* Source Row Width */
-	uint32_t rl = (rw & 0x3) ? ((rw | 0x3) + 1) : rw;	/* Aligned length */
-	uint32_t rls = (rws & 0x3) ? ((rws | 0x3) + 1) : rws;	/* Aligned length */
-	uint8_t *pSrc, *pDst;
-	uint32_t i;
-
-	pSrc = (uint8_t *) pImage;
-	pDst = pDisp->buffer;
-	pDst = &pDst[dwX * cw + dwY * rl];
-
-	for (i = 0; i < height; i++) {
-		memcpy(pDst, pSrc, rws);
-		pSrc = &pSrc[rls];
-		pDst = &pDst[rl];
-	}
+	struct _raster *raster = lcd_get_raster();
+	uint32_t stride = ROUND_UP_MULT(width * (raster->bpp / 8), 4);
+
+	raster_blit(raster, dwX, dwY, pImage, width, height, stride);
 }
 
 /**
@@ -751,121 +411,30 @@ void lcd_draw_image(uint32_t dwX, uint32_t dwY, const uint8_t * pImage,
 void lcd_clear_window(uint32_t dwX, uint32_t dwY, uint32_t width,
 		       uint32_t height, uint32_t color)
 {
-	_set_front_color(color);
-	_hide_canvas();
-	_fill_rect(0, 0, dwX + width - 1, dwY + height - 1);
-	_show_canvas();
+	raster_fill_rect(lcd_get_raster(), dwX, dwY, width, height, color);
 }
 
-/*----------------------------------------------------------------------------
- *        Local functions
- *----------------------------------------------------------------------------*/
-
 /**
  * Draw fast vertical line
  */
 void lcd_draw_fast_vline (uint32_t x, uint32_t y, uint32_t h, uint32_t color)
 {
-	lcd_draw_line(x, y, x, y+h-1, color);
+	raster_draw_vline(lcd_get_raster(), x, y, h, color);
 }
+
 /**
  * Draw fast horizontal line
  */
 void lcd_draw_fast_hline (uint32_t x, uint32_t y, uint32_t w, uint32_t color)
 {
-	lcd_draw_line(x, y, x+w-1, y, color);
-}
-/**
- * Fill rectangle with color
- */
-static void _lcd_fill_rectangle (uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color)
-{
-	uint32_t i;
-	for (i=x; i<x+w; i++) lcd_draw_fast_vline(i, y, h, color);
-}
-/**
- * Draw a circle
- */
-static void _lcd_draw_circle (uint32_t x0, uint32_t y0, uint32_t r, uint8_t corner, uint32_t color)
-{
-	int32_t f = 1 - r;
-	int32_t ddF_x = 1;
-	int32_t ddF_y = -2 * (int32_t)r;
-	int32_t x = 0;
-	int32_t y = r;
-
-	while (x<y) {
-		if (f >= 0)
-		{
-			y--;
-			ddF_y += 2;
-			f     += ddF_y;
-		}
-		x++;
-		ddF_x += 2;
-		f     += ddF_x;
-		if (corner & 0x4) {
-			_draw_pixel(x0 + x, y0 + y);
-			_draw_pixel(x0 + y, y0 + x);
-		}
-		if (corner & 0x2) {
-			_draw_pixel(x0 + x, y0 - y);
-			_draw_pixel(x0 + y, y0 - x);
-		}
-		if (corner & 0x8) {
-			_draw_pixel(x0 - y, y0 + x);
-			_draw_pixel(x0 - x, y0 + y);
-		}
-		if (corner & 0x1) {
-			_draw_pixel(x0 - y, y0 - x);
-			_draw_pixel(x0 - x, y0 - y);
-		}
-	}
-}
-/**
- * Fill a circle
- */
-static void _lcd_fill_circle (uint32_t x0, uint32_t y0, uint32_t r, uint8_t corner, uint32_t delta, uint32_t color)
-{
-	int32_t f = 1 - r;
-	int32_t ddF_x = 1;
-	int32_t ddF_y = -2 * (int32_t)r;
-	int32_t x = 0;
-	int32_t y = r;
-
-	while (x<y) {
-		if (f >= 0) {
-			y--;
-			ddF_y += 2;
-			f += ddF_y;
-		}
-		x++;
-		ddF_x += 2;
-		f += ddF_x;
-
-		if (corner & 0x1) {
-			lcd_draw_fast_vline(x0+x, y0-y, 2*y+1+delta, color);
-			lcd_draw_fast_vline(x0+y, y0-x, 2*x+1+delta, color);
-		}
-		if (corner & 0x2) {
-			lcd_draw_fast_vline(x0-x, y0-y, 2*y+1+delta, color);
-			lcd_draw_fast_vline(x0-y, y0-x, 2*x+1+delta, color);
-		}
-	}
+	raster_draw_hline(lcd_get_raster(), x, y, w, color);
 }
 
-/*----------------------------------------------------------------------------
- *        Global functions
- *----------------------------------------------------------------------------*/
-
 /**
  * Draw a rectangle with rounded corners
  */
 void lcd_draw_rounded_rect (uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t r, uint32_t color)
 {
-	_set_front_color(color);
-	_hide_canvas();
-	// smarter version
 	lcd_draw_fast_hline(x+r, y, w-2*r, color); // Top
 	lcd_draw_fast_hline(x+r, y+h-1, w-2*r, color); // Bottom
 	lcd_draw_fast_vline(x, y+r, h-2*r, color); // Left
@@ -875,20 +444,17 @@ void lcd_draw_rounded_rect (uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint
 	_lcd_draw_circle(x+w-r-1, y+r, r, 2, color);
 	_lcd_draw_circle(x+w-r-1, y+h-r-1, r, 4, color);
 	_lcd_draw_circle(x+r, y+h-r-1, r, 8, color);
-	_show_canvas();
 }
+
 /**
  * Fill a rectangle with rounded corners
  */
 void lcd_fill_rounded_rect(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t r, uint32_t color)
 {
-	_set_front_color(color);
-	_hide_canvas();
 	if (w>(2*r)) {
-		_lcd_fill_rectangle(x+r, y, w-(2*r), h, color);
+		raster_fill_rect(lcd_get_raster(), x+r, y, w-(2*r), h, color);
 		// draw four corners
 		_lcd_fill_circle(x+w-r-1, y+r, r, 1, h-2*r-1, color);
 		_lcd_fill_circle(x+r, y+r, r, 2, h-2*r-1, color);
 	}
-	_show_canvas();
 }
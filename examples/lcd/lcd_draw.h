@@ -48,6 +48,8 @@
  * - String related:
  *   - lcdc_draw_string()
  *   - lcdc_get_string_size()
+ * - Cache maintenance:
+ *   - lcd_flush()
  *
  * \sa \ref lcdc_module, \ref lcdc_font
  */
@@ -62,6 +64,8 @@
  *        Headers
  *----------------------------------------------------------------------------*/
 
+#include "graphics/raster.h"
+
 #include <stdint.h>
 
 /*----------------------------------------------------------------------------
@@ -74,6 +78,10 @@
 
 	 /** \addtogroup lcdc_draw_func LCD Drawing Functions */
 /** @{*/
+extern struct _raster* lcd_get_raster(void);
+
+extern void lcd_flush(void);
+
 extern void lcd_fill_white(void);
 
 extern void lcd_fill(uint32_t color);
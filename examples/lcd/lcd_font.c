@@ -37,11 +37,12 @@
  *        Headers
  *----------------------------------------------------------------------------*/
 
+#include "graphics/font.h"
+#include "graphics/raster.h"
+
 #include "lcd_font.h"
 #include "lcd_draw.h"
 
-#include "font.h"
-
 #include <assert.h>
 
 /*----------------------------------------------------------------------------
@@ -70,59 +71,9 @@ uint8_t lcd_get_selected_font (void)
 
 void lcd_draw_char(uint32_t x, uint32_t y, uint8_t c, uint32_t color)
 {
-	uint32_t row, col;
-	uint8_t Ch;
-	uint8_t width = font_param[font_sel].width ;
-    uint8_t height = font_param[font_sel].height;
-	const uint8_t* pfont = font_param[font_sel].pfont;
-
 	assert((c >= 0x20) && (c <= 0x7F));
 
-    switch (font_sel)
-    {
-      case FONT10x14:
-        for (col=0 ; col < width ; col++ ) {
-          for (row=0 ; row<8 ; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row, color) ;
-          }
-          for (row=0; row<6; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2 + 1] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row+8, color) ;
-          }
-        }
-        break;
-
-       case FONT10x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-		  if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1) {
-                  lcd_draw_pixel( x+(height-row), y+col, color) ;
-              }
-            }
-          }
-        }
-        break;
-
-      case FONT8x8:
-      case FONT6x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-          if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1)  {
-                if (font_sel == FONT8x8)
-                  lcd_draw_pixel( x+row, y+col, color) ;
-                else
-                  lcd_draw_pixel( x+col, y+row, color) ;
-              }
-            }
-          }
-        }
-        break;
-    }
+	raster_draw_char(lcd_get_raster(), font_sel, x, y, c, color);
 }
 
 /**
@@ -137,68 +88,8 @@ void lcd_draw_char(uint32_t x, uint32_t y, uint8_t c, uint32_t color)
 void lcd_draw_char_with_bgcolor(uint32_t x, uint32_t y, uint8_t c, uint32_t fontColor,
 			 uint32_t bgColor)
 {
-	uint32_t row, col;
-	uint8_t Ch;
-	uint8_t width = font_param[font_sel].width ;
-    uint8_t height = font_param[font_sel].height;
-	const uint8_t* pfont = font_param[font_sel].pfont;
-
 	assert((c >= 0x20) && (c <= 0x7F));
 
-    switch (font_sel)
-    {
-      case FONT10x14:
-        for (col=0 ; col < width ; col++ ) {
-          for (row=0 ; row<8 ; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row, fontColor) ;
-			else lcd_draw_pixel( x+col, y+row, bgColor) ;
-          }
-          for (row=0; row<6; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2 + 1] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row+8, fontColor) ;
-			else lcd_draw_pixel( x+col, y+row+8, bgColor) ;
-          }
-        }
-        break;
-
-       case FONT10x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-		  if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1) {
-                  lcd_draw_pixel( x+(height-row), y+col, fontColor) ;
-			  }
-			  else {
-				  lcd_draw_pixel( x+(height-row), y+col, bgColor) ;
-			  }
-            }
-          }
-        }
-        break;
-
-      case FONT8x8:
-      case FONT6x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-          if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1)  {
-                if (font_sel == FONT8x8)
-                  lcd_draw_pixel( x+row, y+col, fontColor) ;
-                else
-                  lcd_draw_pixel( x+col, y+row, fontColor) ;
-              }
-			  else {
-				  if (font_sel == FONT8x8)
-                  lcd_draw_pixel( x+row, y+col, bgColor) ;
-                else
-                  lcd_draw_pixel( x+col, y+row, bgColor) ;
-			  }
-            }
-          }
-        }
-        break;
-    }
+	raster_draw_char_with_bgcolor(lcd_get_raster(), font_sel, x, y, c,
+			fontColor, bgColor);
 }
@@ -71,7 +71,7 @@
  *        Headers
  *----------------------------------------------------------------------------*/
 
-#include "font.h"
+#include "graphics/font.h"
 
 #include <stdint.h>
 
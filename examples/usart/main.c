@@ -106,6 +106,12 @@
 #define READ_BUFFER_SIZE  256
 #endif
 
+/* Must be a power of two */
+#define RING_BUFFER_SIZE  1024
+
+/* End of frame after 3.5 characters of silence (8N1) */
+#define RING_IDLE_BITS    35
+
 #if defined(CONFIG_BOARD_SAMA5D2_PTC_EK)
 #define USART_ADDR FLEXUSART4
 #define USART_PINS PINS_FLEXCOM4_USART_IOS3
@@ -174,6 +180,9 @@ static const struct _pin usart_pins[] = USART_PINS;
 
 CACHE_ALIGNED static uint8_t cmd_buffer[CMD_BUFFER_SIZE];
 CACHE_ALIGNED static uint8_t read_buffer[READ_BUFFER_SIZE];
+CACHE_ALIGNED static uint8_t ring_buffer[RING_BUFFER_SIZE];
+
+static volatile bool ring_event = false;
 
 typedef void (*_parser)(const uint8_t*, uint32_t);
 
@@ -273,6 +282,52 @@ static void _usart_write_arg_parser(const uint8_t* buffer, uint32_t len)
 	usartd_wait_tx_transfer(0);
 }
 
+static int _usart_ring_callback(void* arg, void* arg2)
+{
+	ring_event = true;
+	return 0;
+}
+
+static void _usart_ring_dump(void)
+{
+	uint8_t* data;
+	uint32_t len, tail;
+
+	ring_event = false;
+	while ((len = usartd_rx_ring_peek(0, &data, &tail)) > 0) {
+		printf("%.*s", (int)len, (char*)data);
+		if (usartd_rx_ring_consume(0, tail, len) != USARTD_SUCCESS)
+			printf("\r\n<overrun>\r\n");
+	}
+}
+
+static void _usart_ring_arg_parser(const uint8_t* buffer, uint32_t len)
+{
+	if (!strncmp((char*)buffer, "start", 5)) {
+		struct _buffer ring = {
+			.data = ring_buffer,
+			.size = sizeof(ring_buffer),
+		};
+		struct _callback _cb = {
+			.method = _usart_ring_callback,
+			.arg = 0,
+		};
+		if (usartd_start_rx_ring(0, &ring, RING_IDLE_BITS, &_cb) == USARTD_SUCCESS)
+			printf("Ring reception started\r\n");
+		else
+			printf("Receiver busy\r\n");
+	} else if (!strncmp((char*)buffer, "stop", 4)) {
+		struct _usartd_rx_stats stats;
+
+		_usart_ring_dump();
+		usartd_rx_ring_get_stats(0, &stats);
+		usartd_stop_rx_ring(0);
+		printf("\r\nReceived %u bytes, %u lost in ring, %u overrun errors\r\n",
+		       (unsigned)stats.received, (unsigned)stats.overruns,
+		       (unsigned)stats.hw_overruns);
+	}
+}
+
 static void print_menu(void)
 {
 	printf("\r\n\r\nUSART transfer mode: ");
@@ -298,6 +353,10 @@ static void print_menu(void)
 	       "| m async                                               |\r\n"
 	       "| m dma                                                 |\r\n"
 	       "|      Select transfer mode                             |\r\n"
+	       "| l start                                               |\r\n"
+	       "| l stop                                                |\r\n"
+	       "|      Receive continuously in a DMA ring and print the |\r\n"
+	       "|      data at the end of each frame (idle line)        |\r\n"
 #ifdef CONFIG_HAVE_USART_FIFO
 	       "| f fifo                                                |\r\n"
 	       "|      Toggle FIFO feature                              |\r\n"
@@ -361,6 +420,9 @@ static void _usart_cmd_parser(const uint8_t* buffer, uint32_t len)
 	case 'm':
 		_usart_mode_arg_parser(buffer+2, len-2);
 		break;
+	case 'l':
+		_usart_ring_arg_parser(buffer+2, len-2);
+		break;
 #ifdef CONFIG_HAVE_USART_FIFO
 	case 'f':
 		_usart_feature_arg_parser(buffer+2, len-2);
@@ -391,6 +453,8 @@ int main (void)
 
 	while (1) {
 		cpu_idle();
+		if (ring_event)
+			_usart_ring_dump();
 		if (cmd_index > 0) {
 			_cmd_parser(cmd_buffer, cmd_index);
 			cmd_index = 0;
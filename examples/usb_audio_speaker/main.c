@@ -122,6 +122,7 @@
 #include "serial/console.h"
 #include "trace.h"
 #include "../usb_common/main_usb_common.h"
+#include "usb/device/audio/audd_feedback.h"
 #include "usb/device/audio/audd_speaker_driver.h"
 
 #if defined(CONFIG_BOARD_SAMA5D2_XPLAINED)
@@ -156,12 +157,18 @@
 #define BUFFERS (32)
 
 /**  Size of one buffer in bytes. */
-#define BUFFER_SIZE ROUND_UP_MULT(AUDDSpeakerDriver_BYTESPERFRAME, L1_CACHE_BYTES)
+#define BUFFER_SIZE ROUND_UP_MULT(AUDDSpeakerDriver_MAXBYTESPERFRAME, L1_CACHE_BYTES)
 
 /**  Delay (in number of buffers) before starting the DAC transmission
      after data has been received. */
 #define BUFFER_THRESHOLD (8)
 
+/**  Number of samples (per channel) in one ms frame. */
+#define FRAME_SAMPLES (AUDDSpeakerDriver_SAMPLERATE / 1000)
+
+/**  Ring fill level (in samples) the feedback keeps the stream at. */
+#define FEEDBACK_TARGET (BUFFER_THRESHOLD * FRAME_SAMPLES)
+
 /*----------------------------------------------------------------------------
  *         External variables
  *----------------------------------------------------------------------------*/
@@ -176,9 +183,15 @@ extern const USBDDriverDescriptors audd_speaker_driver_descriptors;
 /**  Data buffers for receiving audio frames from the USB host. */
 CACHE_ALIGNED static uint8_t _buffer[BUFFERS][BUFFER_SIZE];
 
-/**  Number of samples stored in each data buffer. */
+/**  Number of bytes stored in each data buffer. */
 static uint32_t _samples[BUFFERS];
 
+/**  Feedback packet for the asynchronous stream. */
+CACHE_ALIGNED static uint8_t _feedback_buffer[L1_CACHE_BYTES];
+
+/**  Feedback rate controller. */
+static AUDDFeedback _feedback;
+
 /**  Audio context */
 static struct _audio_ctx {
 	uint32_t* samples;
@@ -187,9 +200,14 @@ static struct _audio_ctx {
 		uint16_t rx;
 		uint16_t tx;
 		uint32_t count;
+		uint32_t level;
 	} circ;
+	uint32_t playing_size;
 	uint8_t volume;
 	bool playing;
+	bool streaming;
+	uint32_t underruns;
+	uint32_t overruns;
 } _audio_ctx = {
 	.samples = _samples,
 	.threshold = BUFFER_THRESHOLD,
@@ -197,9 +215,14 @@ static struct _audio_ctx {
 		.rx = 0,
 		.tx = 0,
 		.count = 0,
+		.level = 0,
 	},
+	.playing_size = 0,
 	.volume =  (AUDIO_PLAY_MAX_VOLUME * 80) / 100,
 	.playing = false,
+	.streaming = false,
+	.underruns = 0,
+	.overruns = 0,
 };
 
 #ifdef PINS_PUSHBUTTONS
@@ -211,31 +234,64 @@ static const struct _pin button_pins[] = PINS_PUSHBUTTONS;
  *         Internal functions
  *----------------------------------------------------------------------------*/
 
+static int _audio_transfer_callback(void* arg, void* arg2);
+
 /**
- *  \brief Audio TX callback
+ *  \brief Hand the oldest received buffer to the DAC, or stop playing on
+ *  underrun.
  */
-static int _audio_transfer_callback(void* arg, void* arg2)
+static void _audio_play_next(struct _audio_desc* desc)
 {
-	struct _audio_desc* desc = (struct _audio_desc*)arg;
 	struct _callback _cb;
+	uint16_t index;
 
-	if (_audio_ctx.circ.count > 0) {
-		_audio_ctx.circ.tx = (_audio_ctx.circ.tx + 1) % BUFFERS;
-		_audio_ctx.circ.count--;
-		/* Load next buffer */
-		callback_set(&_cb, _audio_transfer_callback, desc);
-		audio_transfer(desc,
-			       _buffer[_audio_ctx.circ.tx],
-			       _audio_ctx.samples[_audio_ctx.circ.tx],
-			       &_cb);
-	} else {
+	if (_audio_ctx.circ.count == 0) {
+		if (_audio_ctx.streaming)
+			_audio_ctx.underruns++;
 		_audio_ctx.playing = false;
 		audio_enable(desc, false);
+		return;
 	}
 
+	index = _audio_ctx.circ.tx;
+	_audio_ctx.circ.tx = (_audio_ctx.circ.tx + 1) % BUFFERS;
+	_audio_ctx.circ.count--;
+	_audio_ctx.circ.level -= _audio_ctx.samples[index];
+	_audio_ctx.playing_size = _audio_ctx.samples[index];
+
+	callback_set(&_cb, _audio_transfer_callback, desc);
+	audio_transfer(desc, _buffer[index], _audio_ctx.samples[index], &_cb);
+}
+
+/**
+ *  \brief Audio TX callback
+ */
+static int _audio_transfer_callback(void* arg, void* arg2)
+{
+	struct _audio_desc* desc = (struct _audio_desc*)arg;
+
+	audd_feedback_consumed(&_feedback, _audio_ctx.playing_size /
+			       AUDDSpeakerDriver_BYTESPERSUBFRAME);
+	_audio_play_next(desc);
+
 	return 0;
 }
 
+/**
+ *  Invoked when the feedback value has been sent, queues the next one.
+ */
+static void _usb_feedback_callback(void* arg, uint8_t status, uint32_t transferred, uint32_t remaining)
+{
+	uint32_t size;
+
+	if (status != USBD_STATUS_SUCCESS || !_audio_ctx.streaming)
+		return;
+
+	size = audd_feedback_encode(&_feedback, _feedback_buffer);
+	audd_speaker_driver_write_feedback(_feedback_buffer, size,
+					   _usb_feedback_callback, NULL);
+}
+
 /**
  *  Invoked when a frame has been received.
  */
@@ -244,31 +300,28 @@ static void _usb_frame_recv_callback(void* arg, uint8_t status, uint32_t transfe
 	struct _audio_desc* desc = (struct _audio_desc*)arg;
 
 	if (status == USBD_STATUS_SUCCESS) {
-		if (_audio_ctx.circ.count >= (BUFFERS - 1)) {
+		/* Keep one buffer for the DAC and one for the USB */
+		if (_audio_ctx.circ.count >= (BUFFERS - 2)) {
+			_audio_ctx.circ.level -= _audio_ctx.samples[_audio_ctx.circ.tx];
 			_audio_ctx.circ.tx = (_audio_ctx.circ.tx + 1) % BUFFERS;
 			_audio_ctx.circ.count--;
+			_audio_ctx.overruns++;
 		}
 
 		_audio_ctx.samples[_audio_ctx.circ.rx] = transferred;
 		_audio_ctx.circ.rx = (_audio_ctx.circ.rx + 1) % BUFFERS;
 		_audio_ctx.circ.count++;
+		_audio_ctx.circ.level += transferred;
+
+		audd_feedback_update(&_feedback, _audio_ctx.circ.level /
+				     AUDDSpeakerDriver_BYTESPERSUBFRAME);
 
 		if (_audio_ctx.circ.count >= _audio_ctx.threshold) {
 			if (!_audio_ctx.playing) {
 				audio_enable(desc, true);
 				_audio_ctx.playing = true;
-			}
-			if (audio_transfer_is_done(&audio_device)) {
-				struct _callback _cb;
-
-				/* Start DAC transmission if necessary */
-				callback_set(&_cb, _audio_transfer_callback, desc);
-				audio_transfer(desc,
-					       _buffer[_audio_ctx.circ.tx],
-					       _audio_ctx.samples[_audio_ctx.circ.tx],
-					       &_cb);
-				_audio_ctx.circ.tx = (_audio_ctx.circ.tx + 1) % BUFFERS;
-				_audio_ctx.circ.count--;
+				/* Start DAC transmission */
+				_audio_play_next(desc);
 			}
 		}
 	} else if (status == USBD_STATUS_ABORTED) {
@@ -280,10 +333,27 @@ static void _usb_frame_recv_callback(void* arg, uint8_t status, uint32_t transfe
 
 	/* Receive next packet */
 	audd_speaker_driver_read(_buffer[_audio_ctx.circ.rx],
-				 AUDDSpeakerDriver_BYTESPERFRAME,
+				 AUDDSpeakerDriver_MAXBYTESPERFRAME,
 				 _usb_frame_recv_callback, desc);
 }
 
+/**
+ *  Display the stream statistics.
+ */
+static void _display_stats(void)
+{
+	uint32_t value = _feedback.dValue;
+
+	printf("Level %u samples (target %u), underruns %u, overruns %u\r\n",
+	       (unsigned)(_audio_ctx.circ.level / AUDDSpeakerDriver_BYTESPERSUBFRAME),
+	       (unsigned)FEEDBACK_TARGET,
+	       (unsigned)_audio_ctx.underruns, (unsigned)_audio_ctx.overruns);
+	printf("Feedback %u.%03u samples/ms, %u updates\r\n",
+	       (unsigned)(value >> 16),
+	       (unsigned)(((value & 0xFFFF) * 1000) >> 16),
+	       (unsigned)_feedback.dUpdates);
+}
+
 static void console_handler(uint8_t key)
 {
 	switch (key) {
@@ -318,6 +388,11 @@ static void console_handler(uint8_t key)
 		audio_mute(&audio_device, true);
 		break;
 
+	case 's':
+	case 'S':
+		_display_stats();
+		break;
+
 	default:
 		break;
 	}
@@ -426,10 +501,22 @@ void audd_speaker_driver_mute_changed(uint8_t channel, uint8_t muted)
 void audd_speaker_driver_stream_setting_changed(uint8_t new_setting)
 {
 	if (new_setting) {
+		uint32_t size;
+
 		audio_stop(&audio_device);
 		_audio_ctx.circ.count = 0;
 		_audio_ctx.circ.tx = 0;
 		_audio_ctx.circ.rx = 0;
+		_audio_ctx.circ.level = 0;
+		_audio_ctx.streaming = true;
+
+		/* Restart the feedback from the nominal rate */
+		audd_feedback_reset(&_feedback);
+		size = audd_feedback_encode(&_feedback, _feedback_buffer);
+		audd_speaker_driver_write_feedback(_feedback_buffer, size,
+						   _usb_feedback_callback, NULL);
+	} else {
+		_audio_ctx.streaming = false;
 	}
 }
 
@@ -446,9 +533,6 @@ int main(void)
 {
 	bool usb_conn = false;
 
-	int32_t jitter = 0, _jitter_curr;
-	int8_t clock_adjust = 0;
-
 	console_set_rx_handler(console_handler);
 	console_enable_rx_interrupt();
 
@@ -468,6 +552,11 @@ int main(void)
 	configure_buttons();
 #endif
 
+	/* Feedback rate controller initialization */
+	audd_feedback_initialize(&_feedback, AUDDSpeakerDriver_SAMPLERATE,
+				 FEEDBACK_TARGET,
+				 AUDDSpeakerDriverDescriptors_FEEDBACK_REFRESH);
+
 	/* USB audio driver initialization */
 	audd_speaker_driver_initialize(&audd_speaker_driver_descriptors);
 
@@ -478,6 +567,7 @@ int main(void)
 	printf("Input '+' or '-' to increase or decrease volume\n\r");
 	printf("Input '0' or '1' to set volume to min / max\n\r");
 	printf("Input 'm' or 'u' to mute or unmute sound\n\r");
+	printf("Input 's' to display stream statistics\n\r");
 	printf("=========================================================\n\r");
 
 	/* Infinite loop */
@@ -487,27 +577,11 @@ int main(void)
 			continue;
 		}
 
-		_jitter_curr = (_audio_ctx.circ.count - _audio_ctx.threshold);
-
-		if (jitter != _jitter_curr) {
-			jitter = _jitter_curr;
-			if (jitter > 0 && clock_adjust != 1) {
-				/* USB too fast or SSC too slow: faster clock */
-				clock_adjust = 1;
-				audio_sync_adjust(&audio_device, clock_adjust);
-			}
-			if (jitter < 0 && clock_adjust != -1) {
-				/* USB too slow or SSC too fast: slower clock */
-				clock_adjust = -1;
-				audio_sync_adjust(&audio_device, clock_adjust);
-			}
-		}
-
 		if (!usb_conn) {
 			trace_info("USB connected\r\n");
 			/* Start Reading the incoming audio stream */
 			audd_speaker_driver_read(_buffer[_audio_ctx.circ.rx],
-					AUDDSpeakerDriver_BYTESPERFRAME,
+					AUDDSpeakerDriver_MAXBYTESPERFRAME,
 					_usb_frame_recv_callback, &audio_device);
 
 			usb_conn = true;
@@ -79,13 +79,13 @@ static const USBDeviceQualifierDescriptor qualifierDescriptor = {
 	0x00
 };
 /** Configuration descriptors for a USB audio speaker driver. */
-const AUDDSpeakerDriverConfigurationDescriptors fsConfigurationDescriptors = {
+const AUDDSpeakerDriverAsyncConfigurationDescriptors fsConfigurationDescriptors = {
 
 	/* Configuration descriptor */
 	{
 		sizeof(USBConfigurationDescriptor),
 		USBGenericDescriptor_CONFIGURATION,
-		sizeof(AUDDSpeakerDriverConfigurationDescriptors),
+		sizeof(AUDDSpeakerDriverAsyncConfigurationDescriptors),
 		2, /* This configuration has 2 interfaces */
 		1, /* This is configuration #1 */
 		0, /* No string descriptor */
@@ -179,7 +179,7 @@ const AUDDSpeakerDriverConfigurationDescriptors fsConfigurationDescriptors = {
 		USBGenericDescriptor_INTERFACE,
 		AUDDSpeakerDriverDescriptors_STREAMING,
 		1, /* This is alternate setting #1 */
-		1, /* This interface uses 1 endpoint */
+		2, /* This interface uses 2 endpoints (data & feedback) */
 		AUDStreamingInterfaceDescriptor_CLASS,
 		AUDStreamingInterfaceDescriptor_SUBCLASS,
 		AUDStreamingInterfaceDescriptor_PROTOCOL,
@@ -219,11 +219,14 @@ const AUDDSpeakerDriverConfigurationDescriptors fsConfigurationDescriptors = {
 		USBEndpointDescriptor_ADDRESS(
 			USBEndpointDescriptor_OUT,
 			AUDDSpeakerDriverDescriptors_DATAOUT),
-		USBEndpointDescriptor_ISOCHRONOUS,
-		AUDDSpeakerDriver_BYTESPERFRAME,
+		USBEndpointDescriptor_ISOCHRONOUS
+		| USBEndpointDescriptor_Asynchronous_ISOCHRONOUS,
+		AUDDSpeakerDriver_MAXBYTESPERFRAME,
 		AUDDSpeakerDriverDescriptors_FS_INTERVAL, /* Polling interval = 1 ms */
 		0, /* This is not a synchronization endpoint */
-		0  /* No associated synchronization endpoint */
+		USBEndpointDescriptor_ADDRESS(
+			USBEndpointDescriptor_IN,
+			AUDDSpeakerDriverDescriptors_FEEDBACK)
 	},
 	/* Audio streaming endpoint class-specific descriptor */
 	{
@@ -233,17 +236,31 @@ const AUDDSpeakerDriverConfigurationDescriptors fsConfigurationDescriptors = {
 		0, /* No attributes */
 		0, /* Endpoint is not synchronized */
 		0  /* Endpoint is not synchronized */
+	},
+	/* Feedback endpoint standard descriptor */
+	{
+		sizeof(AUDEndpointDescriptor),
+		USBGenericDescriptor_ENDPOINT,
+		USBEndpointDescriptor_ADDRESS(
+			USBEndpointDescriptor_IN,
+			AUDDSpeakerDriverDescriptors_FEEDBACK),
+		USBEndpointDescriptor_ISOCHRONOUS
+		| USBEndpointDescriptor_Feedback_ISOCHRONOUS,
+		3, /* 10.14 feedback value */
+		AUDDSpeakerDriverDescriptors_FS_INTERVAL, /* Polling interval = 1 ms */
+		AUDDSpeakerDriverDescriptors_FEEDBACK_REFRESH,
+		0  /* No associated synchronization endpoint */
 	}
 };
 
 /** Configuration descriptors for a USB audio speaker driver. */
-const AUDDSpeakerDriverConfigurationDescriptors hsConfigurationDescriptors = {
+const AUDDSpeakerDriverAsyncConfigurationDescriptors hsConfigurationDescriptors = {
 
 	/* Configuration descriptor */
 	{
 		sizeof(USBConfigurationDescriptor),
 		USBGenericDescriptor_CONFIGURATION,
-		sizeof(AUDDSpeakerDriverConfigurationDescriptors),
+		sizeof(AUDDSpeakerDriverAsyncConfigurationDescriptors),
 		2, /* This configuration has 2 interfaces */
 		1, /* This is configuration #1 */
 		0, /* No string descriptor */
@@ -337,7 +354,7 @@ const AUDDSpeakerDriverConfigurationDescriptors hsConfigurationDescriptors = {
 		USBGenericDescriptor_INTERFACE,
 		AUDDSpeakerDriverDescriptors_STREAMING,
 		1, /* This is alternate setting #1 */
-		1, /* This interface uses 1 endpoint */
+		2, /* This interface uses 2 endpoints (data & feedback) */
 		AUDStreamingInterfaceDescriptor_CLASS,
 		AUDStreamingInterfaceDescriptor_SUBCLASS,
 		AUDStreamingInterfaceDescriptor_PROTOCOL,
@@ -377,11 +394,14 @@ const AUDDSpeakerDriverConfigurationDescriptors hsConfigurationDescriptors = {
 		USBEndpointDescriptor_ADDRESS(
 			USBEndpointDescriptor_OUT,
 			AUDDSpeakerDriverDescriptors_DATAOUT),
-		USBEndpointDescriptor_ISOCHRONOUS,
-		AUDDSpeakerDriver_BYTESPERFRAME,
+		USBEndpointDescriptor_ISOCHRONOUS
+		| USBEndpointDescriptor_Asynchronous_ISOCHRONOUS,
+		AUDDSpeakerDriver_MAXBYTESPERFRAME,
 		AUDDSpeakerDriverDescriptors_HS_INTERVAL, /* Polling interval = 1 ms */
 		0, /* This is not a synchronization endpoint */
-		0  /* No associated synchronization endpoint */
+		USBEndpointDescriptor_ADDRESS(
+			USBEndpointDescriptor_IN,
+			AUDDSpeakerDriverDescriptors_FEEDBACK)
 	},
 	/* Audio streaming endpoint class-specific descriptor */
 	{
@@ -391,6 +411,20 @@ const AUDDSpeakerDriverConfigurationDescriptors hsConfigurationDescriptors = {
 		0, /* No attributes */
 		0, /* Endpoint is not synchronized */
 		0  /* Endpoint is not synchronized */
+	},
+	/* Feedback endpoint standard descriptor */
+	{
+		sizeof(AUDEndpointDescriptor),
+		USBGenericDescriptor_ENDPOINT,
+		USBEndpointDescriptor_ADDRESS(
+			USBEndpointDescriptor_IN,
+			AUDDSpeakerDriverDescriptors_FEEDBACK),
+		USBEndpointDescriptor_ISOCHRONOUS
+		| USBEndpointDescriptor_Feedback_ISOCHRONOUS,
+		4, /* 16.16 feedback value */
+		AUDDSpeakerDriverDescriptors_HS_INTERVAL, /* Polling interval = 1 ms */
+		AUDDSpeakerDriverDescriptors_FEEDBACK_REFRESH,
+		0  /* No associated synchronization endpoint */
 	}
 };
 
@@ -56,6 +56,7 @@
  * - \ref AUDDSpeakerDriver_BITSPERSAMPLE
  * - \ref AUDDSpeakerDriver_SAMPLESPERFRAME
  * - \ref AUDDSpeakerDriver_BYTESPERFRAME
+ * - \ref AUDDSpeakerDriver_MAXBYTESPERFRAME
  */
 
 /** Sample rate in Hz. */
@@ -75,6 +76,10 @@
 /** Number of bytes in one USB frame. */
 #define AUDDSpeakerDriver_BYTESPERFRAME     (AUDDSpeakerDriver_SAMPLESPERFRAME * \
 		AUDDSpeakerDriver_BYTESPERSAMPLE)
+/** Maximum number of bytes in one USB frame: the asynchronous stream carries
+ *  one extra sample when the host follows the feedback. */
+#define AUDDSpeakerDriver_MAXBYTESPERFRAME  (AUDDSpeakerDriver_BYTESPERFRAME + \
+		AUDDSpeakerDriver_BYTESPERSUBFRAME)
 /**     @}*/
 
 /** \addtogroup usbd_audio_id USB Device Audio Speaker Codes
@@ -97,6 +102,8 @@
  *      @{
  * This page lists the definitions for USB Audio Speaker Device Driver.
  * - \ref AUDDSpeakerDriverDescriptors_DATAOUT
+ * - \ref AUDDSpeakerDriverDescriptors_FEEDBACK
+ * - \ref AUDDSpeakerDriverDescriptors_FEEDBACK_REFRESH
  * - \ref AUDDSpeakerDriverDescriptors_FS_INTERVAL
  * - \ref AUDDSpeakerDriverDescriptors_HS_INTERVAL
  *
@@ -105,6 +112,10 @@
  */
 /** Data out endpoint number. */
 #define AUDDSpeakerDriverDescriptors_DATAOUT            0x02
+/** Feedback in endpoint number. */
+#define AUDDSpeakerDriverDescriptors_FEEDBACK           0x03
+/** Feedback refresh period 2^x ms */
+#define AUDDSpeakerDriverDescriptors_FEEDBACK_REFRESH   0x05
 /** Endpoint polling interval 2^(x-1) * 125us */
 #define AUDDSpeakerDriverDescriptors_HS_INTERVAL        0x04
 /** Endpoint polling interval 2^(x-1) * ms */
@@ -49,9 +49,9 @@
  * USB cable, the board appears as a serial COM port for the host, after driver
  * installation with the offered 6119.inf. Then the host can send or receive
  * data through the port with host software. The data stream from the host is
- * then sent to the board, and forward to USART port of AT91SAM chips. The USART
- * port of the board is monitored by the timer and the incoming data will be sent
- * to the host.
+ * then sent to the board, and forward to USART port of AT91SAM chips. The data
+ * received on the USART port of the board is sent to the host. Both directions
+ * are buffered in rings and use DMA (see cdcd_serial_bridge.h).
  *
  * \section Usage
  *
@@ -126,6 +126,7 @@
 #include "serial/usartd.h"
 #include "serial/usart.h"
 
+#include "usb/device/cdc/cdcd_serial_bridge.h"
 #include "usb/device/cdc/cdcd_serial_driver.h"
 #include "usb/device/usbd.h"
 #include "usb/device/usbd_hal.h"
@@ -141,21 +142,15 @@
  *      Definitions
  *----------------------------------------------------------------------------*/
 
-/** Size in bytes of the packet used for reading data from the USB & USART */
-#define DATAPACKETSIZE (64)
+/** Size in bytes of the ring buffers between the USB & USART, a power of two */
+#define RING_BUFFER_SIZE    (8*1024)
 
-/** Size in bytes of the buffer used for reading data from the USB & USART */
-#define DATABUFFERSIZE (DATAPACKETSIZE+2)
+/** Size in bytes of the buffer used for reading data from the USB */
+#define USB_PACKET_SIZE     (4*512)
 
 /** Basic asynchronous mode, i.e. 8 bits no parity.*/
 #define USART_MODE_ASYNCHRONOUS        (US_MR_CHMODE_NORMAL | US_MR_CHRL_8_BIT | US_MR_PAR_NO)
 
-/** test buffer size */
-#define TEST_BUFFER_SIZE    (2*1024)
-
-/** write loop count */
-#define TEST_COUNT          (1)
-
 /** define the peripherals and pins used for USART */
 #if defined(CONFIG_BOARD_SAMA5D2_PTC_EK)
 #define USART_ADDR FLEXUSART4
@@ -233,29 +228,40 @@ extern const USBDDriverDescriptors cdcd_serial_driver_descriptors;
 
 static const struct _pin usart_pins[] = USART_PINS;
 
-/** Buffer for storing incoming USB data. */
-CACHE_ALIGNED static uint8_t usb_buffer[DATABUFFERSIZE];
+/** Ring buffer for the data from the USART to the USB */
+CACHE_ALIGNED static uint8_t usart_to_usb_buffer[RING_BUFFER_SIZE];
 
-/** Serial Port ON/OFF */
-static uint8_t is_cdc_serial_on = 0;
+/** Ring buffer for the data from the USB to the USART */
+CACHE_ALIGNED static uint8_t usb_to_usart_buffer[RING_BUFFER_SIZE];
 
-/** CDC Echo back ON/OFF */
-static uint8_t is_cdc_echo_on = 0;
-
-/** USB Tx flag */
-static volatile uint8_t tx_done_flag = 0;
-/** Test buffer */
-CACHE_ALIGNED static uint8_t test_buffer[TEST_BUFFER_SIZE];
+/** Buffer for storing incoming USB data. */
+CACHE_ALIGNED static uint8_t usb_packet[USB_PACKET_SIZE];
 
 static struct _usart_desc usart_desc = {
 	.addr           = USART_ADDR,
 	.baudrate       = 115200,
 	.mode           = US_MR_CHMODE_NORMAL | US_MR_PAR_NO | US_MR_CHRL_8_BIT,
 	.transfer_mode = USARTD_MODE_DMA,
+	.timeout        = 1,
 };
 
-static volatile bool usart_rx_flag = false;
-static volatile uint8_t char_recv;
+static struct _cdcd_serial_bridge bridge = {
+	.usart_iface = 0,
+	.usart = &usart_desc,
+	.rts_flow_control = false,
+	.usart_to_usb = {
+		.data = usart_to_usb_buffer,
+		.size = sizeof(usart_to_usb_buffer),
+	},
+	.usb_to_usart = {
+		.data = usb_to_usart_buffer,
+		.size = sizeof(usb_to_usart_buffer),
+	},
+	.usb_packet = {
+		.data = usb_packet,
+		.size = sizeof(usb_packet),
+	},
+};
 
 /*----------------------------------------------------------------------------
  *         Internal Prototypes
@@ -265,25 +271,6 @@ static volatile uint8_t char_recv;
  *  Interrupt handlers
  *----------------------------------------------------------------------------*/
 
-/**
- * USART interrupt handler
- */
-static void usart_irq_handler(uint32_t source, void* user_arg)
-{
-	assert(source == get_usart_id_from_addr(usart_desc.addr));
-
-	Usart* p_us = usart_desc.addr;
-
-	/* If USB device is not configured, do nothing */
-	if (!is_cdc_serial_on) {
-		usart_disable_it(p_us, 0xFFFFFFFF);
-		return;
-	}
-	char_recv = usart_get_char(p_us);
-	usart_rx_flag = true;
-	p_us->US_CR = US_CR_RSTSTA;
-}
-
 /*-----------------------------------------------------------------------------
  *         Callback re-implementation
  *-----------------------------------------------------------------------------*/
@@ -311,129 +298,39 @@ void usbd_callbacks_request_received(const USBGenericRequest *request)
  *         Internal functions
  *----------------------------------------------------------------------------*/
 
-static int _usart_finish_tx_transfer_callback(void* arg, void* arg2)
-{
-	usartd_finish_tx_transfer(0);
-	return 0;
-}
-
-/**
- *  \brief Send single buffer data through DMA
- */
-static void _usart_dma_tx(const uint8_t* buffer, uint32_t len )
-{
-
-	struct _buffer tx = {
-		.data = (unsigned char*)buffer,
-		.size = len,
-		.attr = USARTD_BUF_ATTR_WRITE,
-	};
-	struct _callback _cb = {
-		.method = _usart_finish_tx_transfer_callback,
-		.arg = 0,
-	};
-	usartd_transfer(0, &tx, &_cb);
-
-}
-
-/**
- * Callback invoked when data has been received on the USB.
- */
-static void _usb_data_received(void *read, uint8_t status,
-		uint32_t received, uint32_t remaining)
-{
-	/* Check that data has been received successfully */
-	if (status == USBD_STATUS_SUCCESS) {
-		*(uint8_t *)read = 1;
-		/* Send back CDC data */
-		if (is_cdc_echo_on){
-
-			cdcd_serial_driver_write(usb_buffer, received, 0, 0);
-		}
-		/* Send data through USART */
-		if (is_cdc_serial_on) {
-
-			_usart_dma_tx( usb_buffer, received );
-		}
-
-		/* Check if bytes have been discarded */
-		if ((received == DATAPACKETSIZE) && (remaining > 0)) {
-
-			trace_warning(
-				"_usb_data_received: %u bytes discarded\n\r",
-					(unsigned int)remaining);
-		}
-	} else {
-
-		trace_warning( "_usb_data_received: Transfer error\n\r");
-	}
-}
-
-
-
 /**
  * console help dump
  */
 static void _debug_help(void)
 {
-	printf("-- ESC to Enable/Disable ECHO on cdc serial --\n\r");
-	printf("-- Press 't' to test trasfer --\n\r");
+	printf("-- Press 's' to show the bridge statistics --\n\r");
 }
 
-
 /**
- * Callback invoked when data has been sent.
+ * Display the bridge statistics
  */
-static void _usb_data_sent(void *arg, uint8_t status, uint32_t transferred, uint32_t remaining)
+static void _show_stats(void)
 {
-	tx_done_flag = 1;
+	struct _cdcd_serial_bridge_stats stats;
+
+	cdcd_serial_bridge_get_stats(&bridge, &stats);
+	printf("USART rx %u tx %u, USB rx %u tx %u (%u ZLP)\n\r",
+	       (unsigned)stats.usart_rx, (unsigned)stats.usart_tx,
+	       (unsigned)stats.usb_rx, (unsigned)stats.usb_tx,
+	       (unsigned)stats.usb_zlp);
+	printf("RTS off %u, bytes dropped %u, torn transfers %u\n\r",
+	       (unsigned)stats.rts_off, (unsigned)stats.overruns,
+	       (unsigned)stats.torn);
 }
 
-
 /**
  * Configure USART to work @ 115200
  */
 static void _configure_usart(void)
 {
-	Usart* usart = usart_desc.addr;
-	uint32_t id = get_usart_id_from_addr(usart);
 	/* Driver initialize */
 	usartd_configure(0, &usart_desc);
 	pio_configure(usart_pins, ARRAY_SIZE(usart_pins));
-	usart_enable_it(usart, US_IER_RXRDY);
-	irq_add_handler(id, usart_irq_handler, NULL);
-	irq_enable(id);
-}
-
-/**
- * Test USB CDC Serial
- */
-static void _send_text(void)
-{
-	uint32_t i, test_cnt;
-
-	if (!is_cdc_serial_on) {
-
-		printf("\n\r!! Host serial program not ready!\n\r");
-		return;
-	}
-	printf("\n\r- USB CDC Serial writing ...\n\r");
-
-	/* Test data initialize */
-	for (i = 0; i < TEST_BUFFER_SIZE; i ++) test_buffer[i] = (i % 10) + '0';
-
-	printf("- Send 0,1,2 ... to host:\n\r");
-	for (test_cnt = 0; test_cnt < TEST_COUNT; test_cnt ++) {
-
-		tx_done_flag = 0;
-		cdcd_serial_driver_write(test_buffer, TEST_BUFFER_SIZE,
-				_usb_data_sent, NULL);
-		while(!tx_done_flag);
-	}
-
-	/* Finish sending */
-	cdcd_serial_driver_write(NULL, 0, NULL, NULL);
-	_usart_dma_tx(test_buffer, TEST_BUFFER_SIZE);
 }
 
 /*----------------------------------------------------------------------------
@@ -447,9 +344,6 @@ static void _send_text(void)
  */
 int main(void)
 {
-	uint8_t is_usb_connected = 0;
-	uint8_t usb_serial_read = 1;
-
 	/* Output example information */
 	console_example_info("USB Device CDC Serial Example");
 
@@ -462,6 +356,9 @@ int main(void)
 	/* CDC serial driver initialization */
 	cdcd_serial_driver_initialize(&cdcd_serial_driver_descriptors);
 
+	/* Start the USB <-> Serial bridge */
+	cdcd_serial_bridge_initialize(&bridge);
+
 	/* Help informaiton */
 	_debug_help();
 
@@ -470,60 +367,14 @@ int main(void)
 
 	/* Driver loop */
 	while (1) {
-
-		/* Device is not configured */
-		if (usbd_get_state() < USBD_STATE_CONFIGURED) {
-
-			if (is_usb_connected) {
-				is_usb_connected = 0;
-				is_cdc_serial_on  = 0;
-			}
-
-		} else if (is_usb_connected == 0) {
-				is_usb_connected = 1;
-		}
-
-		/* Serial port ON/OFF */
-		if (cdcd_serial_driver_get_control_line_state()
-					& CDCControlLineState_DTR) {
-			if (!is_cdc_serial_on) {
-				is_cdc_serial_on = 1;
-				}
-			if(usb_serial_read == 1) {
-				usb_serial_read = 0;
-				/* Start receiving data on the USB */
-				cdcd_serial_driver_read(usb_buffer, DATAPACKETSIZE,
-							_usb_data_received, &usb_serial_read);
-			}
-			if(usart_rx_flag == true) {
-				usart_rx_flag = false;
-				cdcd_serial_driver_write((void *)&char_recv, 1, 0, 0);
-				if(is_cdc_echo_on) {
-					_usart_dma_tx((uint8_t*)&char_recv, 1);
-				}
-			}
-		} else if (is_cdc_serial_on) {
-			is_cdc_serial_on = 0;
-		}
+		cdcd_serial_bridge_process(&bridge);
 
 		if (console_is_rx_ready()) {
 			uint8_t key = console_get_char();
-			/* ESC: CDC Echo ON/OFF */
-			if (key == 27) {
-
-				printf("** CDC Echo %s\n\r",
-						is_cdc_echo_on ? "OFF" : "ON");
-				is_cdc_echo_on = !is_cdc_echo_on;
-
-			} else if (key == 't') {
-				/* 't': Test CDC writing  */
-				_send_text();
-
+			if (key == 's') {
+				_show_stats();
 			} else {
 				printf("Alive\n\r");
-				cdcd_serial_driver_write((char*)"Alive\n\r", 8,
-						NULL, NULL);
-				_usart_dma_tx((uint8_t*)"Alive\n\r", 8);
 				_debug_help();
 			}
 		}
@@ -50,6 +50,8 @@
  * controller) to connects a CMOS-type image sensor to the processor and
  * provides image capture in various formats.
  * Data stream Pipe line: ISC PFE->RLP(DAT8)->DAM8->USB YUV2 display
+ * When the host selects the MJPEG format, the frames captured by the ISC are
+ * compressed in strips by the JPEG encoder before being sent.
  *
  * \section Usage
  *
@@ -106,6 +108,7 @@
 #include "chip.h"
 #include "trace.h"
 #include "compiler.h"
+#include "intmath.h"
 
 #include "gpio/pio.h"
 
@@ -128,6 +131,8 @@
 #include "usb/device/uvc/uvc_driver.h"
 #include "usb/device/uvc/uvc_function.h"
 
+#include "jpeg/jpeg_enc.h"
+
 #include "../usb_common/main_usb_common.h"
 
 #include <string.h>
@@ -140,6 +145,10 @@
 #define FRAME_DEBUG_ENABLED
 
 #define NUM_FRAME_BUFFER     4
+/** ISC frames encoded to MJPEG, one is captured while another is encoded */
+#define NUM_CAPTURE_BUFFER   3
+/** Lines read from the capture at a time by the JPEG encoder */
+#define JPEG_STRIP_LINES     16
 #define SENSOR_TWI_BUS BOARD_ISC_TWI_BUS
 #define COUNTER_FREQ         1
 
@@ -171,7 +180,24 @@ static struct _iscd_desc iscd;
 
 /** Video buffers */
 CACHE_ALIGNED_DDR
-static uint8_t stream_buffers[FRAME_BUFFER_SIZEC(640, 480) * NUM_FRAME_BUFFER];
+static uint8_t stream_buffers[FRAME_SLOT_SIZEC(640, 480) * NUM_FRAME_BUFFER];
+
+/** ISC frames to be encoded in MJPEG mode */
+CACHE_ALIGNED_DDR
+static uint8_t capture_buffers[FRAME_SLOT_SIZEC(640, 480) * NUM_CAPTURE_BUFFER];
+
+/** Stream MJPEG */
+static bool is_mjpeg;
+
+/** ISC frames completed and next capture slot, in MJPEG mode */
+static volatile uint32_t capture_count;
+static volatile uint8_t capture_idx;
+
+/** ISC frames encoded and next stream slot */
+static uint32_t encode_count;
+static uint8_t jpeg_idx;
+
+static struct _jpeg_enc jpeg;
 
 #ifdef FRAME_DEBUG_ENABLED
 /** define Timer Counter descriptor for counter/timer */
@@ -180,6 +206,8 @@ static struct _tcd_desc tc_counter = {
 	.channel = 1,
 };
 static uint32_t _isc_frame_count = 0;
+static uint32_t _jpeg_frame_count = 0;
+static uint32_t _jpeg_bytes = 0;
 #endif
 /*----------------------------------------------------------------------------
  *        Local functions
@@ -190,7 +218,62 @@ static void isc_vd_callback(uint8_t frame_idx)
 #ifdef FRAME_DEBUG_ENABLED
 	_isc_frame_count++;
 #endif
-	uvc_function_update_frame_idx(frame_idx);
+	if (is_mjpeg) {
+		capture_idx = frame_idx;
+		capture_count++;
+	} else {
+		uvc_function_update_frame_idx(frame_idx);
+	}
+}
+
+/**
+ * \brief Encode the last frame captured by the ISC into the next stream
+ * slot, strip by strip, and hand it to the UVC function.
+ */
+static void encode_frame(void)
+{
+	uint32_t slot_size = FRAME_SLOT_SIZEC(image_width, image_height);
+	uint32_t frame_size = FRAME_BUFFER_SIZEC(image_width, image_height);
+	uint32_t stride = image_width * FRAME_BPP / 8;
+	struct _jpeg_enc_cfg cfg = {
+		.format = JPEG_ENC_FORMAT_YUYV,
+		.width = image_width,
+		.height = image_height,
+		.quality = JPEG_ENC_QUALITY_DEFAULT,
+	};
+	const uint8_t *src;
+	uint8_t *dst;
+	uint32_t line, lines;
+	int size;
+
+	/* The capture moves to the next slot when a frame completes */
+	encode_count = capture_count;
+	src = capture_buffers + slot_size *
+		((capture_idx + NUM_CAPTURE_BUFFER - 1) % NUM_CAPTURE_BUFFER);
+	dst = stream_buffers + slot_size * jpeg_idx;
+
+	size = jpeg_enc_start(&jpeg, &cfg, dst, frame_size);
+	for (line = 0; !size && line < image_height; line += lines) {
+		lines = min_u32(JPEG_STRIP_LINES, image_height - line);
+		cache_invalidate_region((void*)(src + line * stride), lines * stride);
+		size = jpeg_enc_write_lines(&jpeg, src + line * stride, stride, lines);
+	}
+	if (!size)
+		size = jpeg_enc_finish(&jpeg);
+	if (size <= 0) {
+		trace_warning("JPEG encoding failed (%d)\r\n", size);
+		return;
+	}
+
+	/* The last payload may be extended past the end of the image */
+	cache_clean_region(dst, min_u32(size + FRAME_PACKET_SIZE_HS *
+				(ISO_HIGH_BW_MODE + 1), frame_size));
+	jpeg_idx = (jpeg_idx + 1) % NUM_FRAME_BUFFER;
+#ifdef FRAME_DEBUG_ENABLED
+	_jpeg_frame_count++;
+	_jpeg_bytes += size;
+#endif
+	uvc_function_update_frame(jpeg_idx, size);
 }
 
 /**
@@ -208,11 +291,11 @@ static void configure_isc(void)
 	iscd.pipe.histo_enable = false;
 	iscd.pipe.histo_buf = NULL;
 
-	iscd.cfg.multi_bufs = NUM_FRAME_BUFFER;
+	iscd.cfg.multi_bufs = is_mjpeg ? NUM_CAPTURE_BUFFER : NUM_FRAME_BUFFER;
 	iscd.pipe.rlp_mode = ISCD_RLP_MODE_DAT8;
 	iscd.cfg.layout = ISCD_LAYOUT_PACKED8;
-	iscd.dma.address0 = (uint32_t)stream_buffers;
-	iscd.dma.size = FRAME_BUFFER_SIZEC(image_width, image_height);
+	iscd.dma.address0 = (uint32_t)(is_mjpeg ? capture_buffers : stream_buffers);
+	iscd.dma.size = FRAME_SLOT_SIZEC(image_width, image_height);
 	iscd.dma.callback = isc_vd_callback;
 	iscd_pipe_start(&iscd);
 }
@@ -261,9 +344,15 @@ void usbd_driver_callbacks_interface_setting_changed(uint8_t interface, uint8_t
 #ifdef FRAME_DEBUG_ENABLED
 static int _tc_counter_callback(void* arg, void* arg2)
 {
-	printf("ISC %lu frames, UVC %lu frames per second\r\n",
-			_isc_frame_count, uvc_get_frame_count());
+	printf("ISC %lu frames, UVC %lu frames per second, %lu dropped, %lu torn\r\n",
+			_isc_frame_count, uvc_get_frame_count(),
+			uvc_get_dropped_frame_count(), uvc_get_torn_frame_count());
+	if (_jpeg_frame_count)
+		printf("JPEG %lu frames per second, %lu bytes per frame\r\n",
+				_jpeg_frame_count, _jpeg_bytes / _jpeg_frame_count);
 	_isc_frame_count = 0;
+	_jpeg_frame_count = 0;
+	_jpeg_bytes = 0;
 	uvc_reset_frame_count();
 	return 0;
 }
@@ -328,6 +417,8 @@ extern int main( void )
 		}
 
 		if (is_usb_vid_on) {
+			if (is_mjpeg && capture_count != encode_count)
+				encode_frame();
 			if (!uvc_function_is_video_on()) {
 				is_usb_vid_on = false;
 				isc_stop_capture();
@@ -339,6 +430,10 @@ extern int main( void )
 			if (uvc_function_is_video_on()) {
 				is_usb_vid_on = true;
 				frame_format = uvc_function_get_frame_format();
+				is_mjpeg = uvc_function_get_format_index() == VIDCAMD_FormatIndexMJPEG;
+				capture_count = 0;
+				encode_count = 0;
+				jpeg_idx = 0;
 				if (frame_format == 1) {
 					image_resolution = QVGA;
 				}
@@ -351,8 +446,7 @@ extern int main( void )
 				memset(stream_buffers, 0, sizeof(stream_buffers));
 				cache_clean_region(stream_buffers, sizeof(stream_buffers));
 				start_preview();
-				uvc_function_payload_sent(NULL, USBD_STATUS_SUCCESS, 0, 0);
-				printf("vidS\r\n");
+				printf("vidS%s\r\n", is_mjpeg ? " MJPEG" : "");
 			}
 		}
 	}
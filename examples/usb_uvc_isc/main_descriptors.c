@@ -86,13 +86,13 @@ static const USBDeviceQualifierDescriptor qualifierDescriptor = {
 
 /**  Configuration descriptors. */
 
-const struct UsbVideoCamConfigurationDescriptors configurationDescriptorsFS =
+const struct UsbVideoCamMJPEGConfigurationDescriptors configurationDescriptorsFS =
 {
 	/* Configuration descriptor */
 	{
 		sizeof(USBConfigurationDescriptor),
 		USBGenericDescriptor_CONFIGURATION,
-		sizeof(struct UsbVideoCamConfigurationDescriptors),
+		sizeof(struct UsbVideoCamMJPEGConfigurationDescriptors),
 		2, /* 2 interface in this configuration */
 		1, /* This is configuration #1 */
 		0, /* No string descriptor for this configuration */
@@ -178,19 +178,20 @@ const struct UsbVideoCamConfigurationDescriptors configurationDescriptorsFS =
 	{
 		/* VS Input Header */
 		{
-			sizeof(UsbVideoInputHeaderDescriptor1),
+			sizeof(UsbVideoInputHeaderDescriptor2),
 			VIDGenericDescriptor_INTERFACE, /* CS_INTERFACE */
 			VIDStreamingInterfaceDescriptor_INPUTHEADER, /* VS_INPUT_HEADER */
-			1, /* Only 1 payload format */
-			sizeof(UsbVideoStreamingInterfaceDescriptor),
+			2, /* Uncompressed and MJPEG formats */
+			sizeof(UsbVideoStreamingInterfaceDescriptor2),
 			0x80 | VIDCAMD_IsoInEndpointNum, /* Endpoint address is 0x82 */
 			0x00, /* Dynamic Format Change not supported */
 			2, /* Terminal Link to #2 */
 			0, /* Still Capture not supported */
 			0, /* Trigger not supported */
 			0, /* No trigger usage */
-			1, /* 1 bmaControls */
-			0  /* No bmaControls */
+			1, /* 1 byte per bmaControls */
+			0, /* No bmaControls for format #1 */
+			0  /* No bmaControls for format #2 */
 		},
 		/* VS Format Uncompressed */
 		{
@@ -278,6 +279,92 @@ const struct UsbVideoCamConfigurationDescriptors configurationDescriptorsFS =
 				1, /* BT.709 */
 				4, /* BT.601 */
 			}
+		},
+		/* VS Format MJPEG */
+		{
+			/* Payload MJPEG format */
+			{
+				sizeof(USBVideoMJPEGFormatDescriptor),
+				VIDGenericDescriptor_INTERFACE, /* CS_INTERFACE */
+				VIDStreamingInterfaceDescriptor_FMT_MJPEG,
+				/* VS_FORMAT_MJPEG */
+				VIDCAMD_FormatIndexMJPEG, /* Format index #2 */
+				VIDCAMD_NumFrameTypes, /* 3 frame types */
+				0, /* Variable size samples */
+				1, /* Default frame index: #1 */
+				0, /* bAspectRatioX */
+				0, /* bAspectRatioY */
+				0, /* No interlace */
+				0  /* No copy protect restrictions */
+			},
+			/* Frame format 320x240 */
+			{
+				sizeof(USBVideoMJPEGFrameDescriptor1),
+				VIDGenericDescriptor_INTERFACE, /* CS_INTERFACE */
+				VIDStreamingInterfaceDescriptor_FRM_MJPEG,
+				/* VS_FRAME_MJPEG */
+				1, /* Frame index #1 */
+				0, /* Still image not supported */
+				VIDCAMD_FW_1, /* wWidth */
+				VIDCAMD_FH_1, /* wHeight */
+				FRAME_BITRATEC(VIDCAMD_FW_1, VIDCAMD_FH_1, 30), /* Min bitrate */
+				FRAME_BITRATEC(VIDCAMD_FW_1, VIDCAMD_FH_1, 30), /* Max bitrate */
+				FRAME_BUFFER_SIZEC(VIDCAMD_FW_1, VIDCAMD_FH_1),
+				/* maxFrameBufferSize: worst case */
+				FRAME_INTERVALC(30), /* Default interval: 4F/s */
+				1, /* 1 Interval setting */
+				{
+					FRAME_INTERVALC(30), /* 4F/s, 614.4KB/s */
+				},
+			},
+			/* Frame format 640x480 */
+			{
+				sizeof(USBVideoMJPEGFrameDescriptor1),
+				VIDGenericDescriptor_INTERFACE, /* CS_INTERFACE */
+				VIDStreamingInterfaceDescriptor_FRM_MJPEG, /* VS_FRAME_MJPEG */
+				2, /* Frame index #2 */
+				0, /* Still image not supported */
+				VIDCAMD_FW_2, /* wWidth */
+				VIDCAMD_FH_2, /* wHeight */
+				FRAME_BITRATEC(VIDCAMD_FW_2, VIDCAMD_FH_2, 15), /* Min bitrate */
+				FRAME_BITRATEC(VIDCAMD_FW_2, VIDCAMD_FH_2, 15), /* Max bitrate */
+				FRAME_BUFFER_SIZEC(VIDCAMD_FW_2, VIDCAMD_FH_2),
+				/* maxFrameBufferSize: worst case */
+				FRAME_INTERVALC(15), /* Default interval: 1F/s */
+				1, /* 1 Interval setting */
+				{
+					FRAME_INTERVALC(15), /* 1F/s, 614.4KB/s */
+				},
+			},
+			/* Frame format 176x144 */
+			{
+				sizeof(USBVideoMJPEGFrameDescriptor1),
+				VIDGenericDescriptor_INTERFACE, /* CS_INTERFACE */
+				VIDStreamingInterfaceDescriptor_FRM_MJPEG,
+				/* VS_FRAME_MJPEG */
+				3, /* Frame index #3 */
+				0, /* Still image not supported */
+				VIDCAMD_FW_3, /* wWidth */
+				VIDCAMD_FH_3, /* wHeight */
+				FRAME_BITRATEC(VIDCAMD_FW_3, VIDCAMD_FH_3, 30), /* Min bitrate */
+				FRAME_BITRATEC(VIDCAMD_FW_3, VIDCAMD_FH_3, 30), /* Max bitrate */
+				FRAME_BUFFER_SIZEC(VIDCAMD_FW_3, VIDCAMD_FH_3),
+				/* maxFrameBufferSize: worst case */
+				FRAME_INTERVALC(30), /* Default interval: 12F/s */
+				1, /* 1 Interval setting */
+				{
+					FRAME_INTERVALC(30), /* 12F/s, 608.256KB/s */
+				},
+			},
+			/* Color format MJPEG */
+			{
+				sizeof(USBVideoColorMatchingDescriptor),
+				VIDGenericDescriptor_INTERFACE, /* CS_INTERFACE */
+				VIDStreamingInterfaceDescriptor_COLORFORMAT, /* VS_COLORFORMAT */
+				1, /* BT.709, sRGB */
+				1, /* BT.709 */
+				4, /* BT.601 */
+			}
 		}
 	},
 	/* VS Interface Descriptor: 400K */
@@ -305,13 +392,13 @@ const struct UsbVideoCamConfigurationDescriptors configurationDescriptorsFS =
 };
 
 /**  Configuration descriptors. */
-const struct UsbVideoCamConfigurationDescriptors configurationDescriptorsHS =
+const struct UsbVideoCamMJPEGConfigurationDescriptors configurationDescriptorsHS =
 {
 	/* Configuration descriptor */
 	{
 		sizeof(USBConfigurationDescriptor),
 		USBGenericDescriptor_CONFIGURATION,
-		sizeof(struct UsbVideoCamConfigurationDescriptors),
+		sizeof(struct UsbVideoCamMJPEGConfigurationDescriptors),
 		2, /* 2 interface in this configuration */
 		1, /* This is configuration #1 */
 		0, /* No string descriptor for this configuration */
@@ -397,19 +484,20 @@ const struct UsbVideoCamConfigurationDescriptors configurationDescriptorsHS =
 	{
 		/* VS Input Header */
 		{
-			sizeof(UsbVideoInputHeaderDescriptor1),
+			sizeof(UsbVideoInputHeaderDescriptor2),
 			VIDGenericDescriptor_INTERFACE, /* CS_INTERFACE */
 			VIDStreamingInterfaceDescriptor_INPUTHEADER, /* VS_INPUT_HEADER */
-			1, /* Only 1 payload format */
-			sizeof(UsbVideoStreamingInterfaceDescriptor),
+			2, /* Uncompressed and MJPEG formats */
+			sizeof(UsbVideoStreamingInterfaceDescriptor2),
 			0x80 | VIDCAMD_IsoInEndpointNum, /* Endpoint address is 0x82 */
 			0x00, /* Dynamic Format Change not supported */
 			2, /* Terminal Link to #2 */
 			0, /* Still Capture not supported */
 			0, /* Trigger not supported */
 			0, /* No trigger usage */
-			1, /* 1 bmaControls */
-			0  /* No bmaControls */
+			1, /* 1 byte per bmaControls */
+			0, /* No bmaControls for format #1 */
+			0  /* No bmaControls for format #2 */
 		},
 		/* VS Format Uncompressed */
 		{
@@ -498,6 +586,93 @@ const struct UsbVideoCamConfigurationDescriptors configurationDescriptorsHS =
 				1, /* BT.709 */
 				4, /* BT.601 */
 			}
+		},
+		/* VS Format MJPEG */
+		{
+			/* Payload MJPEG format */
+			{
+				sizeof(USBVideoMJPEGFormatDescriptor),
+				VIDGenericDescriptor_INTERFACE, /* CS_INTERFACE */
+				VIDStreamingInterfaceDescriptor_FMT_MJPEG,
+				/* VS_FORMAT_MJPEG */
+				VIDCAMD_FormatIndexMJPEG, /* Format index #2 */
+				VIDCAMD_NumFrameTypes, /* 3 frame types */
+				0, /* Variable size samples */
+				1, /* Default frame index: #1 */
+				0, /* bAspectRatioX */
+				0, /* bAspectRatioY */
+				0, /* No interlace */
+				0  /* No copy protect restrictions */
+			},
+			/* Frame format 320x240 */
+			{
+				sizeof(USBVideoMJPEGFrameDescriptor1),
+				VIDGenericDescriptor_INTERFACE, /* CS_INTERFACE */
+				VIDStreamingInterfaceDescriptor_FRM_MJPEG,
+				/* VS_FRAME_MJPEG */
+				1, /* Frame index #1 */
+				0, /* Still image not supported */
+				VIDCAMD_FW_1, /* wWidth */
+				VIDCAMD_FH_1, /* wHeight */
+				FRAME_BITRATEC(VIDCAMD_FW_1, VIDCAMD_FH_1, 1), /* Min bitrate */
+				FRAME_BITRATEC(VIDCAMD_FW_1, VIDCAMD_FH_1, 1), /* Max bitrate */
+				FRAME_BUFFER_SIZEC(VIDCAMD_FW_1, VIDCAMD_FH_1),
+				/* maxFrameBufferSize: worst case */
+				FRAME_INTERVALC(1), /* Default interval: 30F/s */
+				1, /* 1 Interval setting */
+				{
+					FRAME_INTERVALC(1), /* 30F/s, 4608KB/s */
+				},
+			},
+			/* Frame format 640x480 */
+			{
+				sizeof(USBVideoMJPEGFrameDescriptor1),
+				VIDGenericDescriptor_INTERFACE, /* CS_INTERFACE */
+				VIDStreamingInterfaceDescriptor_FRM_MJPEG,
+				/* VS_FRAME_MJPEG */
+				2, /* Frame index #4 */
+				0, /* Still image not supported */
+				VIDCAMD_FW_2, /* wWidth */
+				VIDCAMD_FH_2, /* wHeight */
+				FRAME_BITRATEC(VIDCAMD_FW_2, VIDCAMD_FH_2, 1), /* Min bitrate */
+				FRAME_BITRATEC(VIDCAMD_FW_2, VIDCAMD_FH_2, 1), /* Max bitrate */
+				FRAME_BUFFER_SIZEC(VIDCAMD_FW_2, VIDCAMD_FH_2),
+				/* maxFrameBufferSize: worst case */
+				FRAME_INTERVALC(1), /* Default interval: 12F/s */
+				1, /* 1 Interval setting */
+				{
+					FRAME_INTERVALC(1), /* 12F/s, 7372.8KB/s */
+				},
+			},
+			/* Frame format 176x144 */
+			{
+				sizeof(USBVideoMJPEGFrameDescriptor1),
+				VIDGenericDescriptor_INTERFACE, /* CS_INTERFACE */
+				VIDStreamingInterfaceDescriptor_FRM_MJPEG,
+				/* VS_FRAME_MJPEG */
+				3, /* Frame index #1 */
+				0, /* Still image not supported */
+				VIDCAMD_FW_3, /* wWidth */
+				VIDCAMD_FH_3, /* wHeight */
+				FRAME_BITRATEC(VIDCAMD_FW_3, VIDCAMD_FH_3, 30), /* Min bitrate */
+				FRAME_BITRATEC(VIDCAMD_FW_3, VIDCAMD_FH_3, 30), /* Max bitrate */
+				FRAME_BUFFER_SIZEC(VIDCAMD_FW_3, VIDCAMD_FH_3),
+				/* maxFrameBufferSize: worst case */
+				FRAME_INTERVALC(30), /* Default interval: 30F/s */
+				1, /* 1 Interval setting */
+				{
+					FRAME_INTERVALC(30), /* 30F/s, 1520.4KB/s */
+				}
+			},
+			/* Color format MJPEG */
+			{
+				sizeof(USBVideoColorMatchingDescriptor),
+				VIDGenericDescriptor_INTERFACE, /* CS_INTERFACE */
+				VIDStreamingInterfaceDescriptor_COLORFORMAT, /* VS_COLORFORMAT */
+				1, /* BT.709, sRGB */
+				1, /* BT.709 */
+				4, /* BT.601 */
+			}
 		}
 	},
 	/* VS Interface Descriptor: 400K */
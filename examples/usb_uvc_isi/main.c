@@ -165,7 +165,7 @@ static struct _isid_desc isid;
 
 /** Video buffers */
 CACHE_ALIGNED_DDR
-static uint8_t stream_buffers[FRAME_BUFFER_SIZEC(640, 480) * NUM_FRAME_BUFFER];
+static uint8_t stream_buffers[FRAME_SLOT_SIZEC(640, 480) * NUM_FRAME_BUFFER];
 
 #ifdef FRAME_DEBUG_ENABLED
 /** define Timer Counter descriptor for counter/timer */
@@ -207,7 +207,7 @@ static void configure_isi(void)
 	isid.pipe.yuv2rgb_matrix = NULL;
 	isid.pipe.rgb2yuv_matrix = NULL;
 	isid.dma.address_p = (uint32_t)stream_buffers;
-	isid.dma.size_p = FRAME_BUFFER_SIZEC(image_width, image_height);
+	isid.dma.size_p = FRAME_SLOT_SIZEC(image_width, image_height);
 	isid.dma.callback = isi_vd_callback;
 
 	isid_pipe_start(&isid);
@@ -257,8 +257,9 @@ void usbd_driver_callbacks_interface_setting_changed( uint8_t interface, uint8_t
 #ifdef FRAME_DEBUG_ENABLED
 static int _tc_counter_callback(void* arg, void* arg2)
 {
-	printf("ISI %lu frames, UVC %lu frames per second\r\n",
-			_isi_frame_count, uvc_get_frame_count());
+	printf("ISI %lu frames, UVC %lu frames per second, %lu dropped, %lu torn\r\n",
+			_isi_frame_count, uvc_get_frame_count(),
+			uvc_get_dropped_frame_count(), uvc_get_torn_frame_count());
 	_isi_frame_count = 0;
 	uvc_reset_frame_count();
 	return 0;
@@ -350,7 +351,6 @@ extern int main( void )
 				memset(stream_buffers, 0, sizeof(stream_buffers));
 				cache_clean_region(stream_buffers, sizeof(stream_buffers));
 				start_preview();
-				uvc_function_payload_sent(NULL, USBD_STATUS_SUCCESS, 0, 0);
 				printf("vidS\r\n");
 			}
 		}
@@ -35,6 +35,7 @@
 #include "gpio/pio.h"
 #include "peripherals/pit.h"
 #include "board.h"
+#include "cpuidle.h"
 
 /*
  * The FreeRTOS tick handler.  This function must be installed as the handler
@@ -59,6 +60,135 @@ static void System_Handler( void )
 }
 /*-----------------------------------------------------------*/
 
+#if configUSE_TICKLESS_IDLE == 1
+
+/*
+ * Tickless idle.  The PIT counts up to PIV, then restarts from 0 and raises
+ * its interrupt.  While all the tasks are blocked, PIV is stretched so that
+ * the current period ends on the tick at which the next task unblocks, and
+ * the core waits for interrupt in between.  On wake-up the elapsed complete
+ * ticks are added to the tick count and the current period is cut at the
+ * next tick boundary.  The tick interrupt that ends a stretched period
+ * accounts for its last tick and restores the normal PIV.
+ *
+ * configPRE_SLEEP_PROCESSING() and configPOST_SLEEP_PROCESSING() can be
+ * defined in FreeRTOSConfig.h to enter a deeper state, for instance with the
+ * helpers of the low_power_mode example.  The PIT is clocked from MCK, so
+ * MCK must be kept when the tick count has to stay accurate.
+ */
+
+/* Minimum number of PIT clock cycles between the counter and a new PIV. */
+#define portTICKLESS_PIT_MARGIN		( 4UL )
+
+/* Number of PIT clock cycles in one tick, read from the PIT configuration. */
+static uint32_t ulCyclesPerTick = 0;
+
+/* Set when PIV has been changed, cleared by the next tick interrupt. */
+static volatile BaseType_t xTickPeriodStretched = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+void vPortRestoreTickPeriod( void )
+{
+	if( xTickPeriodStretched != pdFALSE )
+	{
+		pit_set_piv( ulCyclesPerTick - 1UL );
+		xTickPeriodStretched = pdFALSE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+{
+	TickType_t xModifiableIdleTime, xMaximumIdleTime;
+	uint32_t ulStatus, ulCPIV, ulCompleteTicks;
+
+	if( ulCyclesPerTick == 0UL )
+	{
+		ulCyclesPerTick = ( ( pit_get_mode() & PIT_MR_PIV_Msk ) >> PIT_MR_PIV_Pos ) + 1UL;
+	}
+
+	xMaximumIdleTime = ( ( PIT_MR_PIV_Msk >> PIT_MR_PIV_Pos ) + 1UL ) / ulCyclesPerTick;
+	if( xExpectedIdleTime > xMaximumIdleTime )
+	{
+		xExpectedIdleTime = xMaximumIdleTime;
+	}
+
+	portDISABLE_INTERRUPTS();
+
+	/* Give up if a task became ready or if a tick is pending. */
+	ulStatus = pit_get_piir();
+	ulCPIV = ( ulStatus & PIT_PIIR_CPIV_Msk ) >> PIT_PIIR_CPIV_Pos;
+	if( ( eTaskConfirmSleepModeStatus() == eAbortSleep ) ||
+		( ( ulStatus & PIT_PIIR_PICNT_Msk ) != 0UL ) )
+	{
+		portENABLE_INTERRUPTS();
+		return;
+	}
+
+	/* The period was already cut after an early wake-up, wait for the tick
+	that ends it. */
+	if( xTickPeriodStretched != pdFALSE )
+	{
+		cpu_idle();
+		portENABLE_INTERRUPTS();
+		return;
+	}
+
+	if( ulCPIV + portTICKLESS_PIT_MARGIN >= ulCyclesPerTick )
+	{
+		portENABLE_INTERRUPTS();
+		return;
+	}
+
+	/* Make the current period end xExpectedIdleTime ticks after its
+	start. */
+	pit_set_piv( ( xExpectedIdleTime * ulCyclesPerTick ) - 1UL );
+	xTickPeriodStretched = pdTRUE;
+
+	xModifiableIdleTime = xExpectedIdleTime;
+	configPRE_SLEEP_PROCESSING( xModifiableIdleTime );
+	if( xModifiableIdleTime > 0 )
+	{
+		cpu_idle();
+	}
+	configPOST_SLEEP_PROCESSING( xExpectedIdleTime );
+
+	ulStatus = pit_get_piir();
+	if( ( ulStatus & PIT_PIIR_PICNT_Msk ) != 0UL )
+	{
+		/* The whole period elapsed, the pending tick interrupt counts the
+		last tick. */
+		vTaskStepTick( xExpectedIdleTime - 1UL );
+	}
+	else
+	{
+		/* Woken up early by another interrupt, end the current period on
+		the next tick boundary that is not too close. */
+		ulCPIV = ( ulStatus & PIT_PIIR_CPIV_Msk ) >> PIT_PIIR_CPIV_Pos;
+		ulCompleteTicks = ulCPIV / ulCyclesPerTick;
+		if( ulCPIV + portTICKLESS_PIT_MARGIN >= ( ulCompleteTicks + 1UL ) * ulCyclesPerTick )
+		{
+			ulCompleteTicks++;
+		}
+		if( ulCompleteTicks + 1UL < xExpectedIdleTime )
+		{
+			pit_set_piv( ( ( ulCompleteTicks + 1UL ) * ulCyclesPerTick ) - 1UL );
+		}
+		else
+		{
+			/* The stretched period already ends on the next tick. */
+			ulCompleteTicks = xExpectedIdleTime - 1UL;
+		}
+		vTaskStepTick( ulCompleteTicks );
+	}
+
+	portENABLE_INTERRUPTS();
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configUSE_TICKLESS_IDLE == 1 */
+
 /*
  * The application must provide a function that configures a peripheral to
  * create the FreeRTOS tick interrupt, then define configSETUP_TICK_INTERRUPT()
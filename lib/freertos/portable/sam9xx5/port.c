@@ -250,6 +250,10 @@ static void vPortTickISR( void )
 	/* Increment the tick count - which may wake some tasks but as the
 	preemptive scheduler is not being used any woken task is not given
 	processor time no matter what its priority. */
+	#if configUSE_TICKLESS_IDLE == 1
+		vPortRestoreTickPeriod();
+	#endif
+
 	if( xTaskIncrementTick() != pdFALSE )
 	{
 		vTaskSwitchContext();
@@ -324,6 +328,11 @@ void FreeRTOS_Tick_Handler( void )
 {
 
 	portDISABLE_INTERRUPTS();
+
+	#if configUSE_TICKLESS_IDLE == 1
+		vPortRestoreTickPeriod();
+	#endif
+
 	/* Increment the RTOS tick. */
 	if( xTaskIncrementTick() != pdFALSE )
 	{
@@ -308,6 +308,11 @@ void FreeRTOS_Tick_Handler( void )
 {
 
 	portDISABLE_INTERRUPTS();
+
+	#if configUSE_TICKLESS_IDLE == 1
+		vPortRestoreTickPeriod();
+	#endif
+
 	/* Increment the RTOS tick. */
 	if( xTaskIncrementTick() != pdFALSE )
 	{
@@ -0,0 +1,840 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "chip.h"
+#include "compiler.h"
+#include "errno.h"
+#include "intmath.h"
+#include "mm/cache.h"
+
+#include "graphics/font.h"
+#include "graphics/raster.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RASTER_USE_NEON
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+/** Decoded glyph, one word per line, leftmost pixel in bit 15 */
+struct _glyph {
+	uint8_t font;
+	uint8_t c;
+	uint16_t rows[16];
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _glyph glyph_cache[RASTER_GLYPH_CACHE];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline uint8_t* _pixel_addr(const struct _raster *raster, int32_t x,
+		int32_t y)
+{
+	return raster->buffer + y * raster->stride + x * (raster->bpp >> 3);
+}
+
+/**
+ * Clip a rectangle to the clip rectangle
+ * \return false if nothing is left
+ */
+static bool _clip(const struct _raster *raster, int32_t *x, int32_t *y,
+		int32_t *w, int32_t *h)
+{
+	int32_t x0 = max_s32(*x, raster->clip.x0);
+	int32_t y0 = max_s32(*y, raster->clip.y0);
+	int32_t x1 = min_s32(*x + *w, raster->clip.x1);
+	int32_t y1 = min_s32(*y + *h, raster->clip.y1);
+
+	if (x0 >= x1 || y0 >= y1)
+		return false;
+
+	*x = x0;
+	*y = y0;
+	*w = x1 - x0;
+	*h = y1 - y0;
+	return true;
+}
+
+static inline bool _in_clip(const struct _raster *raster, int32_t x, int32_t y)
+{
+	return x >= raster->clip.x0 && x < raster->clip.x1 &&
+		y >= raster->clip.y0 && y < raster->clip.y1;
+}
+
+static inline uint32_t _area(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+	return (x1 - x0) * (y1 - y0);
+}
+
+/**
+ * Add an area, already clipped, to the dirty rectangles. It is merged with
+ * a rectangle it touches, or with the one growing the least when all
+ * rectangles are used.
+ */
+static void _mark_dirty(struct _raster *raster, int32_t x0, int32_t y0,
+		int32_t x1, int32_t y1)
+{
+	struct _raster_rect *d = NULL;
+	uint32_t best = UINT32_MAX;
+	int i;
+
+	for (i = 0; i < raster->dirty_count; i++) {
+		struct _raster_rect *r = &raster->dirty[i];
+		if (x0 <= r->x1 && r->x0 <= x1 && y0 <= r->y1 && r->y0 <= y1) {
+			d = r;
+			break;
+		}
+	}
+
+	if (!d && raster->dirty_count < RASTER_DIRTY_RECTS) {
+		d = &raster->dirty[raster->dirty_count++];
+		d->x0 = x0;
+		d->y0 = y0;
+		d->x1 = x1;
+		d->y1 = y1;
+		return;
+	}
+
+	if (!d) {
+		for (i = 0; i < raster->dirty_count; i++) {
+			struct _raster_rect *r = &raster->dirty[i];
+			uint32_t growth = _area(min_s32(x0, r->x0), min_s32(y0, r->y0),
+					max_s32(x1, r->x1), max_s32(y1, r->y1)) -
+				_area(r->x0, r->y0, r->x1, r->y1);
+			if (growth < best) {
+				best = growth;
+				d = r;
+			}
+		}
+	}
+
+	d->x0 = min_s32(x0, d->x0);
+	d->y0 = min_s32(y0, d->y0);
+	d->x1 = max_s32(x1, d->x1);
+	d->y1 = max_s32(y1, d->y1);
+}
+
+static void _fill_words(uint32_t *p, uint32_t count, uint32_t pattern)
+{
+#ifdef RASTER_USE_NEON
+	uint32x4_t v = vdupq_n_u32(pattern);
+
+	for (; count >= 8; count -= 8, p += 8) {
+		vst1q_u32(p, v);
+		vst1q_u32(p + 4, v);
+	}
+#else
+	for (; count >= 4; count -= 4, p += 4) {
+		p[0] = pattern;
+		p[1] = pattern;
+		p[2] = pattern;
+		p[3] = pattern;
+	}
+#endif
+	while (count--)
+		*p++ = pattern;
+}
+
+/**
+ * Fill n pixels from p, storing whole words once p is aligned
+ */
+static void _fill_span(const struct _raster *raster, uint8_t *p, uint32_t n,
+		uint32_t color)
+{
+	switch (raster->bpp) {
+	case 16:
+	{
+		uint16_t *q = (uint16_t*)p;
+		if (((uint32_t)q & 2) && n) {
+			*q++ = color;
+			n--;
+		}
+		_fill_words((uint32_t*)q, n >> 1, (color & 0xffff) * 0x10001);
+		if (n & 1)
+			q[n - 1] = color;
+		break;
+	}
+	case 24:
+	{
+		uint32_t c = color & 0xffffff;
+		uint32_t w0 = c | (c << 24);
+		uint32_t w1 = (c >> 8) | (c << 16);
+		uint32_t w2 = (c >> 16) | (c << 8);
+
+		for (; ((uint32_t)p & 3) && n; n--, p += 3) {
+			p[0] = c;
+			p[1] = c >> 8;
+			p[2] = c >> 16;
+		}
+		/* 4 pixels in 3 words */
+		for (; n >= 4; n -= 4, p += 12) {
+			((uint32_t*)p)[0] = w0;
+			((uint32_t*)p)[1] = w1;
+			((uint32_t*)p)[2] = w2;
+		}
+		for (; n; n--, p += 3) {
+			p[0] = c;
+			p[1] = c >> 8;
+			p[2] = c >> 16;
+		}
+		break;
+	}
+	case 32:
+		_fill_words((uint32_t*)p, n, color);
+		break;
+	}
+}
+
+/**
+ * Clip and fill a rectangle, the caller marks it dirty
+ * \return false if the rectangle is outside the clip rectangle
+ */
+static bool _fill(struct _raster *raster, int32_t *x, int32_t *y, int32_t *w,
+		int32_t *h, uint32_t color)
+{
+	uint8_t *p;
+	int32_t i;
+
+	if (!_clip(raster, x, y, w, h))
+		return false;
+
+	p = _pixel_addr(raster, *x, *y);
+	for (i = 0; i < *h; i++, p += raster->stride)
+		_fill_span(raster, p, *w, color);
+	return true;
+}
+
+static inline void _put_pixel(struct _raster *raster, int32_t x, int32_t y,
+		uint32_t color)
+{
+	uint8_t *p;
+
+	if (!_in_clip(raster, x, y))
+		return;
+
+	p = _pixel_addr(raster, x, y);
+	switch (raster->bpp) {
+	case 16:
+		*(uint16_t*)p = color;
+		break;
+	case 24:
+		p[0] = color;
+		p[1] = color >> 8;
+		p[2] = color >> 16;
+		break;
+	case 32:
+		*(uint32_t*)p = color;
+		break;
+	}
+}
+
+static inline uint32_t _get_pixel(const struct _raster *raster, const uint8_t *p)
+{
+	switch (raster->bpp) {
+	case 16:
+		return *(const uint16_t*)p;
+	case 24:
+		return p[0] | (p[1] << 8) | (p[2] << 16);
+	default:
+		return *(const uint32_t*)p;
+	}
+}
+
+/** Mark the clipped part of a bounding box dirty */
+static void _mark_box(struct _raster *raster, int32_t x, int32_t y, int32_t w,
+		int32_t h)
+{
+	if (_clip(raster, &x, &y, &w, &h))
+		_mark_dirty(raster, x, y, x + w, y + h);
+}
+
+/** Blend two RGB565 pixels, alpha from 0 to 32 */
+static inline uint32_t _blend_565(uint32_t dst, uint32_t src, uint32_t alpha)
+{
+	/* G moved to bits 26:21 leaves room for the products */
+	uint32_t d = (dst | (dst << 16)) & 0x07e0f81f;
+	uint32_t s = (src | (src << 16)) & 0x07e0f81f;
+
+	d = ((d * (32 - alpha) + s * alpha) >> 5) & 0x07e0f81f;
+	return (d | (d >> 16)) & 0xffff;
+}
+
+/** Blend two RGB888 pixels, alpha from 0 to 256 */
+static inline uint32_t _blend_888(uint32_t dst, uint32_t src, uint32_t alpha)
+{
+	uint32_t rb = ((dst & 0xff00ff) * (256 - alpha) + (src & 0xff00ff) * alpha) >> 8;
+	uint32_t g = ((dst & 0x00ff00) * (256 - alpha) + (src & 0x00ff00) * alpha) >> 8;
+
+	return (rb & 0xff00ff) | (g & 0x00ff00);
+}
+
+/** Blend a color in the raster format, alpha from 0 to 255 */
+static void _blend_pixel(const struct _raster *raster, uint8_t *p,
+		uint32_t color, uint32_t alpha)
+{
+	uint32_t d;
+
+	switch (raster->bpp) {
+	case 16:
+		*(uint16_t*)p = _blend_565(*(uint16_t*)p, color, (alpha + 4) >> 3);
+		break;
+	case 24:
+		d = _blend_888(_get_pixel(raster, p), color, alpha + (alpha >> 7));
+		p[0] = d;
+		p[1] = d >> 8;
+		p[2] = d >> 16;
+		break;
+	case 32:
+		d = *(uint32_t*)p;
+		*(uint32_t*)p = (d & 0xff000000) |
+			_blend_888(d, color, alpha + (alpha >> 7));
+		break;
+	}
+}
+
+static void _get_glyph_cell(uint8_t font, int32_t *width, int32_t *height)
+{
+	const struct _font_parameters *param = &font_param[font];
+
+	switch (font) {
+	case FONT10x8:
+		/* Drawn rotated, one column to the right */
+		*width = param->height + 1;
+		*height = param->width;
+		break;
+	case FONT8x8:
+		*width = param->height;
+		*height = param->width;
+		break;
+	default:
+		*width = param->width;
+		*height = param->height;
+		break;
+	}
+}
+
+/** Advance of a character, matching the former lcd_draw_string() */
+static void _get_char_advance(uint8_t font, int32_t *width, int32_t *height)
+{
+	const struct _font_parameters *param = &font_param[font];
+
+	if (font == FONT10x8) {
+		*width = param->height + param->char_space;
+		*height = param->width + param->char_space;
+	} else {
+		*width = param->width + param->char_space;
+		*height = param->height + param->char_space;
+	}
+}
+
+/**
+ * Get the bitmap of a character, decoding it from the font table the first
+ * time
+ */
+static const uint16_t* _get_glyph(uint8_t font, uint8_t c)
+{
+	const struct _font_parameters *param;
+	const uint8_t *data;
+	struct _glyph *glyph;
+	uint32_t index, col, row;
+
+	if (font >= NB_FONT || c < 0x20 || c > 0x7f)
+		return NULL;
+
+	index = c - 0x20;
+	glyph = &glyph_cache[(font * 96 + index) % RASTER_GLYPH_CACHE];
+	if (glyph->c == c && glyph->font == font)
+		return glyph->rows;
+
+	param = &font_param[font];
+	data = param->pfont;
+	memset(glyph->rows, 0, sizeof(glyph->rows));
+
+#define SET(x, y) glyph->rows[(y)] |= 0x8000 >> (x)
+	switch (font) {
+	case FONT10x14:
+		for (col = 0; col < param->width; col++) {
+			uint8_t hi = data[index * 20 + col * 2];
+			uint8_t lo = data[index * 20 + col * 2 + 1];
+			for (row = 0; row < 8; row++)
+				if ((hi >> (7 - row)) & 1)
+					SET(col, row);
+			for (row = 0; row < 6; row++)
+				if ((lo >> (7 - row)) & 1)
+					SET(col, row + 8);
+		}
+		break;
+	default:
+		for (col = 0; col < param->width; col++) {
+			uint8_t bits = data[index * param->width + col];
+			for (row = 0; row < param->height; row++) {
+				if (!((bits >> row) & 1))
+					continue;
+				if (font == FONT10x8)
+					SET(param->height - row, col);
+				else if (font == FONT8x8)
+					SET(row, col);
+				else
+					SET(col, row);
+			}
+		}
+		break;
+	}
+#undef SET
+
+	glyph->font = font;
+	glyph->c = c;
+	return glyph->rows;
+}
+
+static void _draw_glyph(struct _raster *raster, uint8_t font, int32_t x,
+		int32_t y, uint8_t c, uint32_t color, uint32_t bg_color, bool opaque)
+{
+	const uint16_t *rows = _get_glyph(font, c);
+	uint32_t bytes = raster->bpp >> 3;
+	int32_t cx = x, cy = y, cw, ch;
+	int32_t row;
+
+	if (!rows)
+		return;
+
+	_get_glyph_cell(font, &cw, &ch);
+	if (!_clip(raster, &cx, &cy, &cw, &ch))
+		return;
+
+	for (row = cy - y; row < cy - y + ch; row++) {
+		uint32_t bits = rows[row];
+		uint8_t *line = _pixel_addr(raster, x, y + row);
+		int32_t col = cx - x;
+		int32_t end = col + cw;
+
+		/* Fill runs of pixels of the same value */
+		while (col < end) {
+			uint32_t on = (bits >> (15 - col)) & 1;
+			int32_t start = col;
+
+			while (col < end && ((bits >> (15 - col)) & 1) == on)
+				col++;
+			if (on)
+				_fill_span(raster, line + start * bytes, col - start, color);
+			else if (opaque)
+				_fill_span(raster, line + start * bytes, col - start, bg_color);
+		}
+	}
+
+	_mark_dirty(raster, cx, cy, cx + cw, cy + ch);
+}
+
+static void _draw_string(struct _raster *raster, uint8_t font, int32_t x,
+		int32_t y, const char *str, uint32_t color, uint32_t bg_color,
+		bool opaque)
+{
+	int32_t x_org = x;
+	int32_t advance_x, advance_y;
+
+	if (font >= NB_FONT)
+		return;
+
+	_get_char_advance(font, &advance_x, &advance_y);
+	for (; *str; str++) {
+		if (*str == '\n') {
+			x = x_org;
+			y += advance_y;
+		} else {
+			_draw_glyph(raster, font, x, y, *str, color, bg_color, opaque);
+			x += advance_x;
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int raster_init(struct _raster *raster, void *buffer, uint16_t width,
+		uint16_t height, uint8_t bpp, uint32_t stride)
+{
+	if (bpp != 16 && bpp != 24 && bpp != 32)
+		return -EINVAL;
+
+	raster->buffer = buffer;
+	raster->width = width;
+	raster->height = height;
+	raster->bpp = bpp;
+	raster->stride = stride ? stride : ROUND_UP_MULT(width * (bpp >> 3), 4);
+	raster->dirty_count = 0;
+	raster_reset_clip(raster);
+	return 0;
+}
+
+void raster_set_clip(struct _raster *raster, int32_t x, int32_t y,
+		int32_t w, int32_t h)
+{
+	raster->clip.x0 = max_s32(x, 0);
+	raster->clip.y0 = max_s32(y, 0);
+	raster->clip.x1 = max_s32(min_s32(x + w, raster->width), raster->clip.x0);
+	raster->clip.y1 = max_s32(min_s32(y + h, raster->height), raster->clip.y0);
+}
+
+void raster_reset_clip(struct _raster *raster)
+{
+	raster_set_clip(raster, 0, 0, raster->width, raster->height);
+}
+
+void raster_mark_dirty(struct _raster *raster, int32_t x, int32_t y,
+		int32_t w, int32_t h)
+{
+	x = max_s32(x, 0);
+	y = max_s32(y, 0);
+	w = min_s32(x + w, raster->width) - x;
+	h = min_s32(y + h, raster->height) - y;
+	if (w > 0 && h > 0)
+		_mark_dirty(raster, x, y, x + w, y + h);
+}
+
+bool raster_is_dirty(const struct _raster *raster)
+{
+	return raster->dirty_count != 0;
+}
+
+void raster_flush(struct _raster *raster)
+{
+	uint32_t bytes = raster->bpp >> 3;
+	int i, y;
+
+	for (i = 0; i < raster->dirty_count; i++) {
+		const struct _raster_rect *d = &raster->dirty[i];
+		uint32_t len = (d->x1 - d->x0) * bytes;
+
+		if (len + L1_CACHE_BYTES >= raster->stride) {
+			/* Nearly whole lines, clean them at once */
+			cache_clean_region(_pixel_addr(raster, 0, d->y0),
+					(d->y1 - d->y0) * raster->stride);
+		} else {
+			for (y = d->y0; y < d->y1; y++)
+				cache_clean_region(_pixel_addr(raster, d->x0, y), len);
+		}
+	}
+	raster->dirty_count = 0;
+}
+
+void raster_draw_pixel(struct _raster *raster, int32_t x, int32_t y,
+		uint32_t color)
+{
+	if (!_in_clip(raster, x, y))
+		return;
+
+	_put_pixel(raster, x, y, color);
+	_mark_dirty(raster, x, y, x + 1, y + 1);
+}
+
+uint32_t raster_read_pixel(const struct _raster *raster, int32_t x, int32_t y)
+{
+	if (x < 0 || y < 0 || x >= raster->width || y >= raster->height)
+		return 0;
+	return _get_pixel(raster, _pixel_addr(raster, x, y));
+}
+
+void raster_draw_hline(struct _raster *raster, int32_t x, int32_t y,
+		int32_t w, uint32_t color)
+{
+	raster_fill_rect(raster, x, y, w, 1, color);
+}
+
+void raster_draw_vline(struct _raster *raster, int32_t x, int32_t y,
+		int32_t h, uint32_t color)
+{
+	raster_fill_rect(raster, x, y, 1, h, color);
+}
+
+void raster_draw_line(struct _raster *raster, int32_t x0, int32_t y0,
+		int32_t x1, int32_t y1, uint32_t color)
+{
+	int32_t dx = abs_u32(x1 - x0);
+	int32_t dy = abs_u32(y1 - y0);
+	int32_t sx = x0 < x1 ? 1 : -1;
+	int32_t sy = y0 < y1 ? 1 : -1;
+	int32_t err = dx - dy;
+
+	if (y0 == y1) {
+		raster_fill_rect(raster, min_s32(x0, x1), y0, dx + 1, 1, color);
+		return;
+	}
+	if (x0 == x1) {
+		raster_fill_rect(raster, x0, min_s32(y0, y1), 1, dy + 1, color);
+		return;
+	}
+
+	_mark_box(raster, min_s32(x0, x1), min_s32(y0, y1), dx + 1, dy + 1);
+	while (1) {
+		int32_t e2 = 2 * err;
+
+		_put_pixel(raster, x0, y0, color);
+		if (x0 == x1 && y0 == y1)
+			break;
+		if (e2 > -dy) {
+			err -= dy;
+			x0 += sx;
+		}
+		if (e2 < dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+}
+
+void raster_draw_rect(struct _raster *raster, int32_t x, int32_t y,
+		int32_t w, int32_t h, uint32_t color)
+{
+	if (w <= 0 || h <= 0)
+		return;
+
+	raster_fill_rect(raster, x, y, w, 1, color);
+	raster_fill_rect(raster, x, y + h - 1, w, 1, color);
+	raster_fill_rect(raster, x, y + 1, 1, h - 2, color);
+	raster_fill_rect(raster, x + w - 1, y + 1, 1, h - 2, color);
+}
+
+void raster_fill_rect(struct _raster *raster, int32_t x, int32_t y,
+		int32_t w, int32_t h, uint32_t color)
+{
+	if (_fill(raster, &x, &y, &w, &h, color))
+		_mark_dirty(raster, x, y, x + w, y + h);
+}
+
+void raster_draw_circle(struct _raster *raster, int32_t x, int32_t y,
+		int32_t r, uint32_t color)
+{
+	int32_t d = 3 - 2 * r;
+	int32_t cx = 0;
+	int32_t cy = r;
+
+	if (r <= 0)
+		return;
+
+	_mark_box(raster, x - r, y - r, 2 * r + 1, 2 * r + 1);
+	while (cx <= cy) {
+		_put_pixel(raster, x + cx, y + cy, color);
+		_put_pixel(raster, x + cx, y - cy, color);
+		_put_pixel(raster, x - cx, y + cy, color);
+		_put_pixel(raster, x - cx, y - cy, color);
+		_put_pixel(raster, x + cy, y + cx, color);
+		_put_pixel(raster, x + cy, y - cx, color);
+		_put_pixel(raster, x - cy, y + cx, color);
+		_put_pixel(raster, x - cy, y - cx, color);
+
+		if (d < 0) {
+			d += 4 * cx + 6;
+		} else {
+			d += 4 * (cx - cy) + 10;
+			cy--;
+		}
+		cx++;
+	}
+}
+
+void raster_fill_circle(struct _raster *raster, int32_t x, int32_t y,
+		int32_t r, uint32_t color)
+{
+	int32_t d = 3 - 2 * r;
+	int32_t cx = 0;
+	int32_t cy = r;
+
+	if (r <= 0)
+		return;
+
+	_mark_box(raster, x - r, y - r, 2 * r + 1, 2 * r + 1);
+	while (cx <= cy) {
+		int32_t sx, sy, sw, sh;
+
+		/* Spans are clipped by _fill, copies let it update them */
+		sx = x - cx; sy = y - cy; sw = 2 * cx + 1; sh = 1;
+		_fill(raster, &sx, &sy, &sw, &sh, color);
+		sx = x - cx; sy = y + cy; sw = 2 * cx + 1; sh = 1;
+		_fill(raster, &sx, &sy, &sw, &sh, color);
+		sx = x - cy; sy = y - cx; sw = 2 * cy + 1; sh = 1;
+		_fill(raster, &sx, &sy, &sw, &sh, color);
+		sx = x - cy; sy = y + cx; sw = 2 * cy + 1; sh = 1;
+		_fill(raster, &sx, &sy, &sw, &sh, color);
+
+		if (d < 0) {
+			d += 4 * cx + 6;
+		} else {
+			d += 4 * (cx - cy) + 10;
+			cy--;
+		}
+		cx++;
+	}
+}
+
+void raster_blend_rect(struct _raster *raster, int32_t x, int32_t y,
+		int32_t w, int32_t h, uint32_t color, uint8_t alpha)
+{
+	uint32_t bytes = raster->bpp >> 3;
+	int32_t i, j;
+
+	if (alpha == 0)
+		return;
+	if (alpha == 255) {
+		raster_fill_rect(raster, x, y, w, h, color);
+		return;
+	}
+	if (!_clip(raster, &x, &y, &w, &h))
+		return;
+
+	for (j = 0; j < h; j++) {
+		uint8_t *p = _pixel_addr(raster, x, y + j);
+		for (i = 0; i < w; i++, p += bytes)
+			_blend_pixel(raster, p, color, alpha);
+	}
+	_mark_dirty(raster, x, y, x + w, y + h);
+}
+
+void raster_blit(struct _raster *raster, int32_t x, int32_t y,
+		const void *image, int32_t w, int32_t h, uint32_t stride)
+{
+	uint32_t bytes = raster->bpp >> 3;
+	int32_t cx = x, cy = y, j;
+	const uint8_t *src;
+	uint8_t *dst;
+
+	if (!_clip(raster, &cx, &cy, &w, &h))
+		return;
+
+	src = (const uint8_t*)image + (cy - y) * stride + (cx - x) * bytes;
+	dst = _pixel_addr(raster, cx, cy);
+	for (j = 0; j < h; j++, src += stride, dst += raster->stride)
+		memcpy(dst, src, w * bytes);
+	_mark_dirty(raster, cx, cy, cx + w, cy + h);
+}
+
+void raster_blit_argb(struct _raster *raster, int32_t x, int32_t y,
+		const uint32_t *image, int32_t w, int32_t h, uint32_t stride)
+{
+	uint32_t bytes = raster->bpp >> 3;
+	int32_t cx = x, cy = y, i, j;
+
+	if (!_clip(raster, &cx, &cy, &w, &h))
+		return;
+
+	for (j = 0; j < h; j++) {
+		const uint32_t *src = (const uint32_t*)((const uint8_t*)image +
+				(cy - y + j) * stride) + (cx - x);
+		uint8_t *dst = _pixel_addr(raster, cx, cy + j);
+
+		for (i = 0; i < w; i++, dst += bytes) {
+			uint32_t p = src[i];
+			uint32_t alpha = p >> 24;
+			uint32_t color = p & 0xffffff;
+
+			if (alpha == 0)
+				continue;
+			if (raster->bpp == 16)
+				color = ((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) |
+					((p >> 3) & 0x001f);
+			if (alpha == 255) {
+				if (raster->bpp == 32)
+					color |= 0xff000000;
+				_fill_span(raster, dst, 1, color);
+			} else {
+				_blend_pixel(raster, dst, color, alpha);
+			}
+		}
+	}
+	_mark_dirty(raster, cx, cy, cx + w, cy + h);
+}
+
+void raster_draw_char(struct _raster *raster, uint8_t font, int32_t x,
+		int32_t y, uint8_t c, uint32_t color)
+{
+	_draw_glyph(raster, font, x, y, c, color, 0, false);
+}
+
+void raster_draw_char_with_bgcolor(struct _raster *raster, uint8_t font,
+		int32_t x, int32_t y, uint8_t c, uint32_t color, uint32_t bg_color)
+{
+	_draw_glyph(raster, font, x, y, c, color, bg_color, true);
+}
+
+void raster_draw_string(struct _raster *raster, uint8_t font, int32_t x,
+		int32_t y, const char *str, uint32_t color)
+{
+	_draw_string(raster, font, x, y, str, color, 0, false);
+}
+
+void raster_draw_string_with_bgcolor(struct _raster *raster, uint8_t font,
+		int32_t x, int32_t y, const char *str, uint32_t color,
+		uint32_t bg_color)
+{
+	_draw_string(raster, font, x, y, str, color, bg_color, true);
+}
+
+void raster_get_string_size(uint8_t font, const char *str, uint32_t *width,
+		uint32_t *height)
+{
+	int32_t advance_x, advance_y;
+	uint32_t line = 0, max_line = 0, lines = 1;
+
+	if (font >= NB_FONT)
+		return;
+
+	_get_char_advance(font, &advance_x, &advance_y);
+	for (; *str; str++) {
+		if (*str == '\n') {
+			lines++;
+			line = 0;
+		} else {
+			line += advance_x;
+			max_line = max_u32(max_line, line);
+		}
+	}
+
+	/* No spacing after the last character and line */
+	if (width)
+		*width = max_line ? max_line - font_param[font].char_space : 0;
+	if (height)
+		*height = lines * advance_y - font_param[font].char_space;
+}
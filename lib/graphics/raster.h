@@ -0,0 +1,231 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * 2D raster operations on a frame buffer: span fills, alpha blending,
+ * image and glyph blits, all clipped to a clip rectangle.
+ *
+ * Every operation records the area it modified. raster_flush() then cleans
+ * the data cache for these areas only, so that the LCDC DMA sees the
+ * changes without cleaning the whole frame buffer.
+ *
+ * Colors are raw pixel values in the format of the frame buffer: RGB565
+ * for 16 bpp, RGB888 packed for 24 bpp and ARGB8888 for 32 bpp.
+ */
+
+#ifndef RASTER_H
+#define RASTER_H
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of dirty rectangles tracked before they are merged */
+#ifndef RASTER_DIRTY_RECTS
+#define RASTER_DIRTY_RECTS 8
+#endif
+
+/** Number of decoded glyphs kept in cache */
+#ifndef RASTER_GLYPH_CACHE
+#define RASTER_GLYPH_CACHE 64
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Rectangle, x1 and y1 excluded */
+struct _raster_rect {
+	int16_t x0;
+	int16_t y0;
+	int16_t x1;
+	int16_t y1;
+};
+
+/** Frame buffer description */
+struct _raster {
+	uint8_t *buffer;
+	/* Size in bytes of a line */
+	uint32_t stride;
+	uint16_t width;
+	uint16_t height;
+	/* 16, 24 or 32 */
+	uint8_t bpp;
+
+	/* Operations are limited to this area */
+	struct _raster_rect clip;
+
+	/* Areas modified since the last flush */
+	struct _raster_rect dirty[RASTER_DIRTY_RECTS];
+	uint8_t dirty_count;
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a raster on a frame buffer. The clip rectangle is set
+ * to the whole buffer and nothing is dirty.
+ * \param raster  Raster instance
+ * \param buffer  Frame buffer
+ * \param width   Width in pixels
+ * \param height  Height in pixels
+ * \param bpp     Bits per pixel (16, 24 or 32)
+ * \param stride  Size of a line in bytes, 0 for the LCDC layout (lines
+ *                padded to 4 bytes)
+ * \return 0 on success, -EINVAL if bpp is not supported
+ */
+extern int raster_init(struct _raster *raster, void *buffer, uint16_t width,
+		uint16_t height, uint8_t bpp, uint32_t stride);
+
+/**
+ * \brief Limit the following operations to a rectangle
+ */
+extern void raster_set_clip(struct _raster *raster, int32_t x, int32_t y,
+		int32_t w, int32_t h);
+
+/**
+ * \brief Remove the clip rectangle
+ */
+extern void raster_reset_clip(struct _raster *raster);
+
+/**
+ * \brief Record an area as modified, for buffers written directly
+ */
+extern void raster_mark_dirty(struct _raster *raster, int32_t x, int32_t y,
+		int32_t w, int32_t h);
+
+/**
+ * \brief Check if the raster has been modified since the last flush
+ */
+extern bool raster_is_dirty(const struct _raster *raster);
+
+/**
+ * \brief Clean the data cache for the lines, or parts of lines, modified
+ * since the last flush
+ */
+extern void raster_flush(struct _raster *raster);
+
+extern void raster_draw_pixel(struct _raster *raster, int32_t x, int32_t y,
+		uint32_t color);
+
+extern uint32_t raster_read_pixel(const struct _raster *raster, int32_t x,
+		int32_t y);
+
+extern void raster_draw_hline(struct _raster *raster, int32_t x, int32_t y,
+		int32_t w, uint32_t color);
+
+extern void raster_draw_vline(struct _raster *raster, int32_t x, int32_t y,
+		int32_t h, uint32_t color);
+
+extern void raster_draw_line(struct _raster *raster, int32_t x0, int32_t y0,
+		int32_t x1, int32_t y1, uint32_t color);
+
+extern void raster_draw_rect(struct _raster *raster, int32_t x, int32_t y,
+		int32_t w, int32_t h, uint32_t color);
+
+extern void raster_fill_rect(struct _raster *raster, int32_t x, int32_t y,
+		int32_t w, int32_t h, uint32_t color);
+
+extern void raster_draw_circle(struct _raster *raster, int32_t x, int32_t y,
+		int32_t r, uint32_t color);
+
+extern void raster_fill_circle(struct _raster *raster, int32_t x, int32_t y,
+		int32_t r, uint32_t color);
+
+/**
+ * \brief Blend a color over a rectangle
+ * \param alpha  Opacity of the color, 0 (transparent) to 255 (opaque)
+ */
+extern void raster_blend_rect(struct _raster *raster, int32_t x, int32_t y,
+		int32_t w, int32_t h, uint32_t color, uint8_t alpha);
+
+/**
+ * \brief Copy an image in the frame buffer format
+ * \param stride  Size in bytes of a line of the image
+ */
+extern void raster_blit(struct _raster *raster, int32_t x, int32_t y,
+		const void *image, int32_t w, int32_t h, uint32_t stride);
+
+/**
+ * \brief Blend an ARGB8888 image using its alpha channel
+ * \param stride  Size in bytes of a line of the image
+ */
+extern void raster_blit_argb(struct _raster *raster, int32_t x, int32_t y,
+		const uint32_t *image, int32_t w, int32_t h, uint32_t stride);
+
+/**
+ * \brief Draw a character of one of the fonts of font.h. Glyphs are
+ * decoded once into bitmaps kept in a small cache and drawn span by span.
+ * \param font  Font (_FONT_enum)
+ * \param c     Character, 0x20 to 0x7f
+ */
+extern void raster_draw_char(struct _raster *raster, uint8_t font,
+		int32_t x, int32_t y, uint8_t c, uint32_t color);
+
+/**
+ * \brief Draw a character and fill the rest of its cell with a background
+ * color
+ */
+extern void raster_draw_char_with_bgcolor(struct _raster *raster,
+		uint8_t font, int32_t x, int32_t y, uint8_t c, uint32_t color,
+		uint32_t bg_color);
+
+/**
+ * \brief Draw a string, line breaks are honored
+ */
+extern void raster_draw_string(struct _raster *raster, uint8_t font,
+		int32_t x, int32_t y, const char *str, uint32_t color);
+
+/**
+ * \brief Draw a string with a background color, line breaks are honored
+ */
+extern void raster_draw_string_with_bgcolor(struct _raster *raster,
+		uint8_t font, int32_t x, int32_t y, const char *str,
+		uint32_t color, uint32_t bg_color);
+
+/**
+ * \brief Get the size a string occupies when drawn
+ * \param width   Pointer for storing the string width (optional)
+ * \param height  Pointer for storing the string height (optional)
+ */
+extern void raster_get_string_size(uint8_t font, const char *str,
+		uint32_t *width, uint32_t *height);
+
+#endif /* RASTER_H */
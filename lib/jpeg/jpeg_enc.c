@@ -0,0 +1,773 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "errno.h"
+#include "intmath.h"
+
+#include "jpeg/jpeg_enc.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define JPEG_ENC_USE_NEON
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Fixed point constants of the AAN DCT, 8 fractional bits */
+#define FIX_0_382683433 98
+#define FIX_0_541196100 139
+#define FIX_0_707106781 181
+#define FIX_1_306562965 334
+
+/** Fractional bits of the AAN scale factors */
+#define AAN_BITS 14
+
+/** Fractional bits of the quantizer reciprocals */
+#define RECIP_BITS 24
+
+/** Entropy coding tables */
+#define HUFF_DC_LUMA   0
+#define HUFF_AC_LUMA   1
+#define HUFF_DC_CHROMA 2
+#define HUFF_AC_CHROMA 3
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+/** Huffman table as defined in a DHT segment */
+struct _huff_spec {
+	const uint8_t *bits;
+	const uint8_t *vals;
+	uint8_t count;
+};
+
+/** Huffman codes, indexed by symbol */
+struct _huff_codes {
+	uint16_t code[256];
+	uint8_t size[256];
+};
+
+/*----------------------------------------------------------------------------
+ *        Local constants
+ *----------------------------------------------------------------------------*/
+
+/** Natural index of each coefficient in zigzag order */
+static const uint8_t zigzag[64] = {
+	 0,  1,  8, 16,  9,  2,  3, 10,
+	17, 24, 32, 25, 18, 11,  4,  5,
+	12, 19, 26, 33, 40, 48, 41, 34,
+	27, 20, 13,  6,  7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36,
+	29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46,
+	53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+/** AAN DCT output scale factors, natural order */
+static const uint16_t aan_scales[64] = {
+	16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+	22725, 31521, 29692, 26722, 22725, 17855, 12299,  6270,
+	21407, 29692, 27969, 25172, 21407, 16819, 11585,  5906,
+	19266, 26722, 25172, 22654, 19266, 15137, 10426,  5315,
+	16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+	12873, 17855, 16819, 15137, 12873, 10114,  6967,  3552,
+	 8867, 12299, 11585, 10426,  8867,  6967,  4799,  2446,
+	 4520,  6270,  5906,  5315,  4520,  3552,  2446,  1247,
+};
+
+/** Quantization tables of Annex K.1 in zigzag order, quality 50 */
+static const uint8_t qt_luma[64] = {
+	0x10, 0x0b, 0x0c, 0x0e, 0x0c, 0x0a, 0x10, 0x0e,
+	0x0d, 0x0e, 0x12, 0x11, 0x10, 0x13, 0x18, 0x28,
+	0x1a, 0x18, 0x16, 0x16, 0x18, 0x31, 0x23, 0x25,
+	0x1d, 0x28, 0x3a, 0x33, 0x3d, 0x3c, 0x39, 0x33,
+	0x38, 0x37, 0x40, 0x48, 0x5c, 0x4e, 0x40, 0x44,
+	0x57, 0x45, 0x37, 0x38, 0x50, 0x6d, 0x51, 0x57,
+	0x5f, 0x62, 0x67, 0x68, 0x67, 0x3e, 0x4d, 0x71,
+	0x79, 0x70, 0x64, 0x78, 0x5c, 0x65, 0x67, 0x63,
+};
+
+static const uint8_t qt_chroma[64] = {
+	0x11, 0x12, 0x12, 0x18, 0x15, 0x18, 0x2f, 0x1a,
+	0x1a, 0x2f, 0x63, 0x42, 0x38, 0x42, 0x63, 0x63,
+	0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63,
+	0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63,
+	0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63,
+	0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63,
+	0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63,
+	0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63,
+};
+
+/** Huffman tables of Annex K.3 */
+static const uint8_t dc_luma_bits[16] = {
+	0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const uint8_t dc_luma_vals[12] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+};
+
+static const uint8_t ac_luma_bits[16] = {
+	0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05, 0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7d,
+};
+
+static const uint8_t ac_luma_vals[162] = {
+	0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06,
+	0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08,
+	0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72,
+	0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45,
+	0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+	0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75,
+	0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+	0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3,
+	0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6,
+	0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9,
+	0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+	0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4,
+	0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+};
+
+static const uint8_t dc_chroma_bits[16] = {
+	0x00, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const uint8_t dc_chroma_vals[12] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+};
+
+static const uint8_t ac_chroma_bits[16] = {
+	0x00, 0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00, 0x01, 0x02, 0x77,
+};
+
+static const uint8_t ac_chroma_vals[162] = {
+	0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41,
+	0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+	0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1,
+	0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+	0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44,
+	0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+	0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74,
+	0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+	0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+	0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+	0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+	0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+	0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+	0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+};
+
+static const struct _huff_spec huff_specs[4] = {
+	[HUFF_DC_LUMA] = { dc_luma_bits, dc_luma_vals, sizeof(dc_luma_vals) },
+	[HUFF_AC_LUMA] = { ac_luma_bits, ac_luma_vals, sizeof(ac_luma_vals) },
+	[HUFF_DC_CHROMA] = { dc_chroma_bits, dc_chroma_vals, sizeof(dc_chroma_vals) },
+	[HUFF_AC_CHROMA] = { ac_chroma_bits, ac_chroma_vals, sizeof(ac_chroma_vals) },
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Huffman codes, built on first use and shared by all encoders */
+static struct _huff_codes huff_codes[4];
+static bool huff_ready;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Generate the codes of the Huffman tables (Annex C)
+ */
+static void _build_huff_codes(void)
+{
+	int t, i, j, k;
+
+	for (t = 0; t < 4; t++) {
+		const struct _huff_spec *spec = &huff_specs[t];
+		struct _huff_codes *codes = &huff_codes[t];
+		uint16_t code = 0;
+
+		k = 0;
+		for (i = 0; i < 16; i++) {
+			for (j = 0; j < spec->bits[i]; j++) {
+				codes->code[spec->vals[k]] = code++;
+				codes->size[spec->vals[k]] = i + 1;
+				k++;
+			}
+			code <<= 1;
+		}
+	}
+	huff_ready = true;
+}
+
+static void _put_byte(struct _jpeg_enc *enc, uint8_t byte)
+{
+	if (enc->len < enc->size)
+		enc->out[enc->len++] = byte;
+	else
+		enc->overflow = true;
+}
+
+static void _put_word(struct _jpeg_enc *enc, uint16_t word)
+{
+	_put_byte(enc, word >> 8);
+	_put_byte(enc, word & 0xff);
+}
+
+/**
+ * \brief Append up to 16 bits to the entropy coded data, 0xFF bytes being
+ * stuffed with a 0x00
+ */
+static inline void _put_bits(struct _jpeg_enc *enc, uint32_t code, uint8_t size)
+{
+	enc->bits = (enc->bits << size) | code;
+	enc->nbits += size;
+	while (enc->nbits >= 8) {
+		uint8_t byte;
+
+		enc->nbits -= 8;
+		byte = (enc->bits >> enc->nbits) & 0xff;
+		_put_byte(enc, byte);
+		if (byte == 0xff)
+			_put_byte(enc, 0);
+	}
+}
+
+/**
+ * \brief Pad the entropy coded data to a byte boundary with 1 bits
+ */
+static void _flush_bits(struct _jpeg_enc *enc)
+{
+	if (enc->nbits)
+		_put_bits(enc, (1u << (8 - enc->nbits)) - 1, 8 - enc->nbits);
+}
+
+static void _write_dqt(struct _jpeg_enc *enc, uint8_t tables)
+{
+	uint8_t t;
+	int i;
+
+	_put_word(enc, 0xffdb);
+	_put_word(enc, 2 + tables * 65);
+	for (t = 0; t < tables; t++) {
+		_put_byte(enc, t);
+		for (i = 0; i < 64; i++)
+			_put_byte(enc, enc->qt[t][i]);
+	}
+}
+
+static void _write_dht(struct _jpeg_enc *enc, uint8_t tables)
+{
+	uint32_t length = 2;
+	uint8_t t;
+	int i;
+
+	for (t = 0; t < tables; t++)
+		length += 17 + huff_specs[t].count;
+
+	_put_word(enc, 0xffc4);
+	_put_word(enc, length);
+	for (t = 0; t < tables; t++) {
+		/* Class in high nibble (0: DC, 1: AC), destination in low nibble */
+		_put_byte(enc, ((t & 1) << 4) | (t >> 1));
+		for (i = 0; i < 16; i++)
+			_put_byte(enc, huff_specs[t].bits[i]);
+		for (i = 0; i < huff_specs[t].count; i++)
+			_put_byte(enc, huff_specs[t].vals[i]);
+	}
+}
+
+static void _write_headers(struct _jpeg_enc *enc)
+{
+	static const uint8_t jfif[] = {
+		'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0,
+	};
+	uint8_t components = enc->format == JPEG_ENC_FORMAT_GRAY ? 1 : 3;
+	uint8_t i;
+
+	/* SOI, APP0 */
+	_put_word(enc, 0xffd8);
+	_put_word(enc, 0xffe0);
+	_put_word(enc, 2 + sizeof(jfif));
+	for (i = 0; i < sizeof(jfif); i++)
+		_put_byte(enc, jfif[i]);
+
+	_write_dqt(enc, components == 1 ? 1 : 2);
+
+	/* SOF0: baseline, 8-bit samples */
+	_put_word(enc, 0xffc0);
+	_put_word(enc, 8 + 3 * components);
+	_put_byte(enc, 8);
+	_put_word(enc, enc->height);
+	_put_word(enc, enc->width);
+	_put_byte(enc, components);
+	for (i = 0; i < components; i++) {
+		_put_byte(enc, i + 1);
+		/* Luma is 2x1 subsampled relatively to chroma */
+		_put_byte(enc, (i == 0 && components > 1) ? 0x21 : 0x11);
+		_put_byte(enc, i == 0 ? 0 : 1);
+	}
+
+	_write_dht(enc, components == 1 ? 2 : 4);
+
+	/* SOS: whole spectrum, no successive approximation */
+	_put_word(enc, 0xffda);
+	_put_word(enc, 6 + 2 * components);
+	_put_byte(enc, components);
+	for (i = 0; i < components; i++) {
+		_put_byte(enc, i + 1);
+		_put_byte(enc, i == 0 ? 0x00 : 0x11);
+	}
+	_put_byte(enc, 0);
+	_put_byte(enc, 63);
+	_put_byte(enc, 0);
+}
+
+/**
+ * \brief Scale the reference quantization tables to the requested quality
+ * and compute the reciprocals used to quantize the unscaled DCT output
+ */
+static void _setup_quant(struct _jpeg_enc *enc, uint8_t quality)
+{
+	const uint8_t *ref[2] = { qt_luma, qt_chroma };
+	uint32_t scale;
+	uint8_t t;
+	int i;
+
+	quality = min_u32(max_u32(quality, 1), 100);
+	scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+
+	for (t = 0; t < 2; t++) {
+		for (i = 0; i < 64; i++) {
+			uint32_t q = (ref[t][i] * scale + 50) / 100;
+			uint8_t n = zigzag[i];
+
+			q = min_u32(max_u32(q, 1), 255);
+			enc->qt[t][i] = q;
+			/* The AAN DCT output is scaled by aan_scales / 2^AAN_BITS
+			 * and by 8 */
+			enc->recip[t][n] = (uint32_t)(((1ull << (RECIP_BITS + AAN_BITS - 3)) +
+					q * aan_scales[n] / 2) / (q * aan_scales[n]));
+		}
+	}
+}
+
+#define MULTIPLY(v, c) (((v) * (c)) >> 8)
+
+#ifdef JPEG_ENC_USE_NEON
+
+#define VMULTIPLY(v, c) vshrq_n_s32(vmulq_n_s32((v), (c)), 8)
+
+/**
+ * \brief One dimension AAN DCT on 8 vectors of 4 lanes
+ */
+static void _fdct_1d_neon(int32x4_t *v)
+{
+	int32x4_t tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+	int32x4_t tmp10, tmp11, tmp12, tmp13, z1, z2, z3, z4, z5, z11, z13;
+
+	tmp0 = vaddq_s32(v[0], v[7]);
+	tmp7 = vsubq_s32(v[0], v[7]);
+	tmp1 = vaddq_s32(v[1], v[6]);
+	tmp6 = vsubq_s32(v[1], v[6]);
+	tmp2 = vaddq_s32(v[2], v[5]);
+	tmp5 = vsubq_s32(v[2], v[5]);
+	tmp3 = vaddq_s32(v[3], v[4]);
+	tmp4 = vsubq_s32(v[3], v[4]);
+
+	/* Even part */
+	tmp10 = vaddq_s32(tmp0, tmp3);
+	tmp13 = vsubq_s32(tmp0, tmp3);
+	tmp11 = vaddq_s32(tmp1, tmp2);
+	tmp12 = vsubq_s32(tmp1, tmp2);
+	v[0] = vaddq_s32(tmp10, tmp11);
+	v[4] = vsubq_s32(tmp10, tmp11);
+	z1 = VMULTIPLY(vaddq_s32(tmp12, tmp13), FIX_0_707106781);
+	v[2] = vaddq_s32(tmp13, z1);
+	v[6] = vsubq_s32(tmp13, z1);
+
+	/* Odd part */
+	tmp10 = vaddq_s32(tmp4, tmp5);
+	tmp11 = vaddq_s32(tmp5, tmp6);
+	tmp12 = vaddq_s32(tmp6, tmp7);
+	z5 = VMULTIPLY(vsubq_s32(tmp10, tmp12), FIX_0_382683433);
+	z2 = vaddq_s32(VMULTIPLY(tmp10, FIX_0_541196100), z5);
+	z4 = vaddq_s32(VMULTIPLY(tmp12, FIX_1_306562965), z5);
+	z3 = VMULTIPLY(tmp11, FIX_0_707106781);
+	z11 = vaddq_s32(tmp7, z3);
+	z13 = vsubq_s32(tmp7, z3);
+	v[5] = vaddq_s32(z13, z2);
+	v[3] = vsubq_s32(z13, z2);
+	v[1] = vaddq_s32(z11, z4);
+	v[7] = vsubq_s32(z11, z4);
+}
+
+/**
+ * \brief Transpose a 4x4 block
+ */
+static void _transpose_4x4_neon(int32x4_t *r0, int32x4_t *r1,
+		int32x4_t *r2, int32x4_t *r3)
+{
+	int32x4x2_t t0 = vtrnq_s32(*r0, *r1);
+	int32x4x2_t t1 = vtrnq_s32(*r2, *r3);
+
+	*r0 = vcombine_s32(vget_low_s32(t0.val[0]), vget_low_s32(t1.val[0]));
+	*r1 = vcombine_s32(vget_low_s32(t0.val[1]), vget_low_s32(t1.val[1]));
+	*r2 = vcombine_s32(vget_high_s32(t0.val[0]), vget_high_s32(t1.val[0]));
+	*r3 = vcombine_s32(vget_high_s32(t0.val[1]), vget_high_s32(t1.val[1]));
+}
+
+/**
+ * \brief Transpose an 8x8 block held as the left and right halves of its
+ * rows
+ */
+static void _transpose_8x8_neon(int32x4_t *lo, int32x4_t *hi)
+{
+	int32x4_t tmp;
+	int i;
+
+	_transpose_4x4_neon(&lo[0], &lo[1], &lo[2], &lo[3]);
+	_transpose_4x4_neon(&hi[0], &hi[1], &hi[2], &hi[3]);
+	_transpose_4x4_neon(&lo[4], &lo[5], &lo[6], &lo[7]);
+	_transpose_4x4_neon(&hi[4], &hi[5], &hi[6], &hi[7]);
+	/* Swap the off-diagonal blocks */
+	for (i = 0; i < 4; i++) {
+		tmp = hi[i];
+		hi[i] = lo[i + 4];
+		lo[i + 4] = tmp;
+	}
+}
+
+/**
+ * \brief Forward DCT of an 8x8 block, in place. Output is scaled by the
+ * AAN factors, which are compensated by the quantization.
+ */
+static void _fdct(int32_t *data)
+{
+	int32x4_t lo[8], hi[8];
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		lo[i] = vld1q_s32(data + 8 * i);
+		hi[i] = vld1q_s32(data + 8 * i + 4);
+	}
+
+	/* Rows, then columns */
+	_transpose_8x8_neon(lo, hi);
+	_fdct_1d_neon(lo);
+	_fdct_1d_neon(hi);
+	_transpose_8x8_neon(lo, hi);
+	_fdct_1d_neon(lo);
+	_fdct_1d_neon(hi);
+
+	for (i = 0; i < 8; i++) {
+		vst1q_s32(data + 8 * i, lo[i]);
+		vst1q_s32(data + 8 * i + 4, hi[i]);
+	}
+}
+
+#else /* !JPEG_ENC_USE_NEON */
+
+/**
+ * \brief One dimension AAN DCT on 8 samples spaced by step
+ */
+static void _fdct_1d(int32_t *p, int step)
+{
+	int32_t tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+	int32_t tmp10, tmp11, tmp12, tmp13, z1, z2, z3, z4, z5, z11, z13;
+
+	tmp0 = p[0 * step] + p[7 * step];
+	tmp7 = p[0 * step] - p[7 * step];
+	tmp1 = p[1 * step] + p[6 * step];
+	tmp6 = p[1 * step] - p[6 * step];
+	tmp2 = p[2 * step] + p[5 * step];
+	tmp5 = p[2 * step] - p[5 * step];
+	tmp3 = p[3 * step] + p[4 * step];
+	tmp4 = p[3 * step] - p[4 * step];
+
+	/* Even part */
+	tmp10 = tmp0 + tmp3;
+	tmp13 = tmp0 - tmp3;
+	tmp11 = tmp1 + tmp2;
+	tmp12 = tmp1 - tmp2;
+	p[0 * step] = tmp10 + tmp11;
+	p[4 * step] = tmp10 - tmp11;
+	z1 = MULTIPLY(tmp12 + tmp13, FIX_0_707106781);
+	p[2 * step] = tmp13 + z1;
+	p[6 * step] = tmp13 - z1;
+
+	/* Odd part */
+	tmp10 = tmp4 + tmp5;
+	tmp11 = tmp5 + tmp6;
+	tmp12 = tmp6 + tmp7;
+	z5 = MULTIPLY(tmp10 - tmp12, FIX_0_382683433);
+	z2 = MULTIPLY(tmp10, FIX_0_541196100) + z5;
+	z4 = MULTIPLY(tmp12, FIX_1_306562965) + z5;
+	z3 = MULTIPLY(tmp11, FIX_0_707106781);
+	z11 = tmp7 + z3;
+	z13 = tmp7 - z3;
+	p[5 * step] = z13 + z2;
+	p[3 * step] = z13 - z2;
+	p[1 * step] = z11 + z4;
+	p[7 * step] = z11 - z4;
+}
+
+/**
+ * \brief Forward DCT of an 8x8 block, in place. Output is scaled by the
+ * AAN factors, which are compensated by the quantization.
+ */
+static void _fdct(int32_t *data)
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+		_fdct_1d(data + 8 * i, 1);
+	for (i = 0; i < 8; i++)
+		_fdct_1d(data + i, 8);
+}
+
+#endif /* !JPEG_ENC_USE_NEON */
+
+/**
+ * \brief Number of bits of the magnitude of a coefficient
+ */
+static inline uint8_t _bit_length(uint32_t value)
+{
+	return value ? 32 - __builtin_clz(value) : 0;
+}
+
+/**
+ * \brief Transform, quantize and entropy code one 8x8 block of level
+ * shifted samples
+ * \param enc    Encoder instance
+ * \param block  Samples, natural order, overwritten
+ * \param comp   Component index (0: Y, 1: Cb, 2: Cr)
+ */
+static void _encode_block(struct _jpeg_enc *enc, int32_t *block, uint8_t comp)
+{
+	const uint8_t chroma = comp ? 1 : 0;
+	const uint32_t *recip = enc->recip[chroma];
+	const struct _huff_codes *dc = &huff_codes[chroma ? HUFF_DC_CHROMA : HUFF_DC_LUMA];
+	const struct _huff_codes *ac = &huff_codes[chroma ? HUFF_AC_CHROMA : HUFF_AC_LUMA];
+	int16_t coefs[64];
+	int32_t diff;
+	uint32_t mag;
+	uint8_t nbits, run;
+	int i;
+
+	_fdct(block);
+
+	/* Quantize with rounding to nearest, in zigzag order */
+	for (i = 0; i < 64; i++) {
+		uint8_t n = zigzag[i];
+		int32_t v = block[n];
+		uint32_t a = (uint32_t)(((uint64_t)abs_u32(v) * recip[n] +
+				(1u << (RECIP_BITS - 1))) >> RECIP_BITS);
+		coefs[i] = v < 0 ? -(int32_t)a : (int32_t)a;
+	}
+
+	/* DC difference */
+	diff = coefs[0] - enc->dc[comp];
+	enc->dc[comp] = coefs[0];
+	mag = abs_u32(diff);
+	nbits = _bit_length(mag);
+	_put_bits(enc, dc->code[nbits], dc->size[nbits]);
+	if (nbits)
+		_put_bits(enc, (diff < 0 ? diff - 1 : diff) & ((1u << nbits) - 1), nbits);
+
+	/* AC run lengths */
+	run = 0;
+	for (i = 1; i < 64; i++) {
+		int32_t v = coefs[i];
+
+		if (!v) {
+			run++;
+			continue;
+		}
+		while (run > 15) {
+			_put_bits(enc, ac->code[0xf0], ac->size[0xf0]);
+			run -= 16;
+		}
+		mag = abs_u32(v);
+		nbits = _bit_length(mag);
+		_put_bits(enc, ac->code[(run << 4) | nbits], ac->size[(run << 4) | nbits]);
+		_put_bits(enc, (v < 0 ? v - 1 : v) & ((1u << nbits) - 1), nbits);
+		run = 0;
+	}
+	if (run)
+		_put_bits(enc, ac->code[0x00], ac->size[0x00]);
+}
+
+/**
+ * \brief Encode a row of MCUs from a YUYV strip, edges being extended by
+ * repeating the last column and line
+ */
+static void _encode_mcu_row_yuyv(struct _jpeg_enc *enc, const uint8_t *data,
+		uint32_t stride, uint32_t lines)
+{
+	int32_t y[2][64], cb[64], cr[64];
+	uint32_t last = enc->width - 1;
+	uint32_t x0, r, c;
+
+	for (x0 = 0; x0 < enc->width; x0 += 16) {
+		for (r = 0; r < 8; r++) {
+			const uint8_t *line = data + min_u32(r, lines - 1) * stride;
+
+			if (x0 + 16 <= enc->width) {
+				const uint8_t *p = line + 2 * x0;
+
+				for (c = 0; c < 8; c++, p += 4) {
+					int32_t *yp = &y[c >> 2][r * 8 + 2 * (c & 3)];
+
+					yp[0] = p[0] - 128;
+					cb[r * 8 + c] = p[1] - 128;
+					yp[1] = p[2] - 128;
+					cr[r * 8 + c] = p[3] - 128;
+				}
+			} else {
+				for (c = 0; c < 16; c++) {
+					uint32_t x = min_u32(x0 + c, last);
+
+					y[c >> 3][r * 8 + (c & 7)] = line[2 * x] - 128;
+				}
+				for (c = 0; c < 8; c++) {
+					/* Chroma of the pixel pair containing x */
+					uint32_t x = min_u32(x0 + 2 * c, last) & ~1u;
+
+					cb[r * 8 + c] = line[2 * x + 1] - 128;
+					cr[r * 8 + c] = line[2 * x + 3] - 128;
+				}
+			}
+		}
+		_encode_block(enc, y[0], 0);
+		_encode_block(enc, y[1], 0);
+		_encode_block(enc, cb, 1);
+		_encode_block(enc, cr, 2);
+	}
+}
+
+/**
+ * \brief Encode a row of MCUs from a grayscale strip
+ */
+static void _encode_mcu_row_gray(struct _jpeg_enc *enc, const uint8_t *data,
+		uint32_t stride, uint32_t lines)
+{
+	int32_t block[64];
+	uint32_t last = enc->width - 1;
+	uint32_t x0, r, c;
+
+	for (x0 = 0; x0 < enc->width; x0 += 8) {
+		for (r = 0; r < 8; r++) {
+			const uint8_t *line = data + min_u32(r, lines - 1) * stride;
+
+			for (c = 0; c < 8; c++)
+				block[r * 8 + c] = line[min_u32(x0 + c, last)] - 128;
+		}
+		_encode_block(enc, block, 0);
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int jpeg_enc_start(struct _jpeg_enc *enc, const struct _jpeg_enc_cfg *cfg,
+		uint8_t *out, uint32_t size)
+{
+	if (!cfg->width || !cfg->height)
+		return -EINVAL;
+	if (cfg->format != JPEG_ENC_FORMAT_YUYV &&
+	    cfg->format != JPEG_ENC_FORMAT_GRAY)
+		return -EINVAL;
+	/* YUYV carries chroma for pixel pairs */
+	if (cfg->format == JPEG_ENC_FORMAT_YUYV && (cfg->width & 1))
+		return -EINVAL;
+
+	if (!huff_ready)
+		_build_huff_codes();
+
+	memset(enc, 0, sizeof(*enc));
+	enc->format = cfg->format;
+	enc->width = cfg->width;
+	enc->height = cfg->height;
+	enc->out = out;
+	enc->size = size;
+	_setup_quant(enc, cfg->quality ? cfg->quality : JPEG_ENC_QUALITY_DEFAULT);
+
+	_write_headers(enc);
+
+	return enc->overflow ? -ENOSPC : 0;
+}
+
+int jpeg_enc_write_lines(struct _jpeg_enc *enc, const uint8_t *data,
+		uint32_t stride, uint32_t lines)
+{
+	uint32_t n;
+
+	if (lines > (uint32_t)(enc->height - enc->line))
+		return -EINVAL;
+	if ((lines % JPEG_ENC_MCU_LINES) && enc->line + lines != enc->height)
+		return -EINVAL;
+
+	while (lines) {
+		n = min_u32(lines, JPEG_ENC_MCU_LINES);
+		if (enc->format == JPEG_ENC_FORMAT_YUYV)
+			_encode_mcu_row_yuyv(enc, data, stride, n);
+		else
+			_encode_mcu_row_gray(enc, data, stride, n);
+		data += n * stride;
+		enc->line += n;
+		lines -= n;
+	}
+
+	return enc->overflow ? -ENOSPC : 0;
+}
+
+int jpeg_enc_finish(struct _jpeg_enc *enc)
+{
+	if (enc->line != enc->height)
+		return -EINVAL;
+
+	_flush_bits(enc);
+	_put_word(enc, 0xffd9);
+
+	return enc->overflow ? -ENOSPC : (int)enc->len;
+}
@@ -0,0 +1,152 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Baseline JPEG encoder.
+ *
+ * The image is fed by strips of lines, as they are produced by the capture
+ * interface, so that it never has to be stored whole before compression.
+ * The forward DCT and the quantization are done in fixed point, entropy
+ * coding uses the standard Huffman tables of the JPEG specification (Annex
+ * K) which makes the output suitable for MJPEG streams that omit them.
+ *
+ * Packed YUV 4:2:2 images are encoded with 2x1 chroma subsampling, as
+ * output by the ISC and ISI, without any color conversion.
+ */
+
+#ifndef JPEG_ENC_H
+#define JPEG_ENC_H
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Height of a row of MCUs, all strips but the last one must be a multiple
+ *  of it */
+#define JPEG_ENC_MCU_LINES 8
+
+/** Default quality */
+#define JPEG_ENC_QUALITY_DEFAULT 75
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Input pixel formats */
+enum _jpeg_enc_format {
+	/** Packed YUV 4:2:2, Y0 Cb Y1 Cr (YUY2) */
+	JPEG_ENC_FORMAT_YUYV,
+	/** 8-bit luminance only */
+	JPEG_ENC_FORMAT_GRAY,
+};
+
+/** Encoder configuration */
+struct _jpeg_enc_cfg {
+	enum _jpeg_enc_format format;
+	uint16_t width;
+	uint16_t height;
+	/* 1 (smallest) to 100 (best), 0 for JPEG_ENC_QUALITY_DEFAULT */
+	uint8_t quality;
+};
+
+/** Encoder instance */
+struct _jpeg_enc {
+	enum _jpeg_enc_format format;
+	uint16_t width;
+	uint16_t height;
+	/* Next line to be encoded */
+	uint16_t line;
+
+	/* Output buffer */
+	uint8_t *out;
+	uint32_t size;
+	uint32_t len;
+	bool overflow;
+
+	/* Pending bits of the entropy coder, LSB aligned */
+	uint32_t bits;
+	uint8_t nbits;
+
+	/* DC predictors of Y, Cb and Cr */
+	int16_t dc[3];
+
+	/* Quantization tables (luma, chroma) in zigzag order */
+	uint8_t qt[2][64];
+	/* Quantizer reciprocals including the DCT scaling, natural order */
+	uint32_t recip[2][64];
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Start encoding an image: write the JPEG headers to the output
+ * buffer.
+ * \param enc   Encoder instance
+ * \param cfg   Image format and quality
+ * \param out   Output buffer
+ * \param size  Size of the output buffer in bytes
+ * \return 0 on success, -EINVAL if the configuration is not supported,
+ * -ENOSPC if the headers do not fit in the output buffer
+ */
+extern int jpeg_enc_start(struct _jpeg_enc *enc, const struct _jpeg_enc_cfg *cfg,
+		uint8_t *out, uint32_t size);
+
+/**
+ * \brief Encode a strip of lines.
+ * \param enc     Encoder instance
+ * \param data    First line of the strip
+ * \param stride  Size of a line in bytes
+ * \param lines   Number of lines, a multiple of JPEG_ENC_MCU_LINES unless
+ *                the strip ends the image
+ * \return 0 on success, -EINVAL if the strip size is not valid, -ENOSPC if
+ * the output buffer is full
+ */
+extern int jpeg_enc_write_lines(struct _jpeg_enc *enc, const uint8_t *data,
+		uint32_t stride, uint32_t lines);
+
+/**
+ * \brief Terminate the image once all its lines have been written.
+ * \param enc  Encoder instance
+ * \return Size of the JPEG image in bytes, -EINVAL if lines are missing,
+ * -ENOSPC if the output buffer was too small
+ */
+extern int jpeg_enc_finish(struct _jpeg_enc *enc);
+
+#endif /* JPEG_ENC_H */
@@ -48,7 +48,7 @@
  * \param media Pointer to a Media instance
  * \param address Address of the data to read
  * \param data Pointer to the buffer in which to store the retrieved data
- * \param length Length of the buffer
+ * \param length Number of blocks to read
  * \param callback Optional pointer to a callback function to invoke when
  *                 the operation is finished
  * \param callback_arg Optional pointer to an argument for the callback
@@ -73,7 +73,7 @@ static uint8_t media_ramdisk_read(struct _media *media,
 
 	// Copy data
 	source = (uint8_t*)((media->base_address + address) * media->block_size);
-	memcpy(data, source, length);
+	memcpy(data, source, length * media->block_size);
 
 	// Leave the Busy state
 	media->state = MEDIA_STATE_READY;
@@ -90,7 +90,7 @@ static uint8_t media_ramdisk_read(struct _media *media,
  *  \param media Pointer to a Media instance
  *  \param address Address at which to write
  *  \param data Pointer to the data to write
- *  \param length Size of the data buffer
+ *  \param length Number of blocks to write
  *  \param callback Optional pointer to a callback function to invoke when
  *                  the write operation terminates
  *  \param callback_arg Optional argument for the callback function
@@ -115,7 +115,7 @@ static uint8_t media_ramdisk_write(struct _media *media,
 
 	// Copy data
 	dest = (uint8_t*)((media->base_address + address) * media->block_size);
-	memcpy(dest, data, length);
+	memcpy(dest, data, length * media->block_size);
 
 	// Leave the Busy state
 	media->state = MEDIA_STATE_READY;
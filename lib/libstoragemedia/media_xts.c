@@ -0,0 +1,374 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*---------------------------------------------------------------------------
+ *         Headers
+ *---------------------------------------------------------------------------*/
+
+#include "errno.h"
+#include "trace.h"
+
+#include "media.h"
+#include "media_private.h"
+#include "media_xts.h"
+
+#include <string.h>
+
+/*---------------------------------------------------------------------------
+ *      Internal Functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * \brief Multiply a tweak by the primitive element alpha of GF(2^128).
+ * The tweak is stored as four little-endian 32-bit words.
+ */
+static void _media_xts_mul_alpha(uint32_t* t)
+{
+	uint32_t carry = t[3] >> 31;
+
+	t[3] = (t[3] << 1) | (t[2] >> 31);
+	t[2] = (t[2] << 1) | (t[1] >> 31);
+	t[1] = (t[1] << 1) | (t[0] >> 31);
+	t[0] = (t[0] << 1) ^ (carry ? 0x87 : 0);
+}
+
+/**
+ * \brief XOR every AES block of \a count media blocks with its tweak.
+ * \param tweaks Encrypted tweak of each media block
+ * \param block_size Media block size in bytes
+ * \param in Input data
+ * \param out Output data, may be equal to \a in
+ * \param count Number of media blocks
+ */
+static void _media_xts_whiten(const uint8_t* tweaks, uint32_t block_size,
+		const uint8_t* in, uint8_t* out, uint32_t count)
+{
+	uint32_t i, j, k;
+
+	for (i = 0; i < count; i++) {
+		uint32_t t[4];
+
+		memcpy(t, tweaks + i * MEDIA_XTS_AES_BLOCK_SIZE, sizeof(t));
+		for (j = 0; j < block_size; j += MEDIA_XTS_AES_BLOCK_SIZE) {
+			uint32_t d[4];
+
+			memcpy(d, in, sizeof(d));
+			for (k = 0; k < 4; k++)
+				d[k] ^= t[k];
+			memcpy(out, d, sizeof(d));
+
+			in += MEDIA_XTS_AES_BLOCK_SIZE;
+			out += MEDIA_XTS_AES_BLOCK_SIZE;
+			_media_xts_mul_alpha(t);
+		}
+	}
+}
+
+/**
+ * \brief Encrypt or decrypt up to MEDIA_XTS_MAX_BATCH media blocks with two
+ * ECB engine calls.
+ */
+static int _media_xts_crypt(struct _media_xts* xts, bool encrypt,
+		uint32_t block, const uint8_t* in, uint8_t* out, uint32_t count)
+{
+	uint8_t* tweaks = xts->buffer;
+	uint32_t block_size = xts->backend->block_size;
+	uint32_t i;
+	int err;
+
+	/* Encrypt the tweak of every data unit in one pass with key2 */
+	for (i = 0; i < count; i++) {
+		uint32_t t[4] = { block + i, 0, 0, 0 };
+		memcpy(tweaks + i * MEDIA_XTS_AES_BLOCK_SIZE, t, sizeof(t));
+	}
+	err = xts->engine.ecb(xts->engine.arg, true, true, tweaks, tweaks,
+			count * MEDIA_XTS_AES_BLOCK_SIZE);
+	if (err < 0)
+		return err;
+
+	/* C = E(K1, P ^ T) ^ T for the whole batch */
+	_media_xts_whiten(tweaks, block_size, in, out, count);
+	err = xts->engine.ecb(xts->engine.arg, false, encrypt, out, out,
+			count * block_size);
+	if (err < 0)
+		return err;
+	_media_xts_whiten(tweaks, block_size, out, out, count);
+
+	return 0;
+}
+
+/**
+ * \brief Reads and decrypts blocks from the backend media
+ * \param media Pointer to a Media instance
+ * \param address Address of the first block to read
+ * \param data Pointer to the buffer in which to store the plaintext
+ * \param length Number of blocks to read
+ * \param callback Optional pointer to a callback function to invoke when
+ *                 the operation is finished
+ * \param callback_arg Optional pointer to an argument for the callback
+ * \return Operation result code
+ */
+static uint8_t media_xts_read(struct _media *media,
+		uint32_t address, void *data, uint32_t length,
+		media_callback_t callback, void *callback_arg)
+{
+	struct _media_xts* xts = (struct _media_xts*)media->interface;
+	uint8_t* buf = (uint8_t*)data;
+	uint32_t done, count;
+	uint8_t status;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	if ((address + length) > media->size)
+		return MEDIA_STATUS_ERROR;
+
+	media->state = MEDIA_STATE_BUSY;
+
+	/* Ciphertext lands directly in the user buffer and is decrypted in
+	 * place */
+	status = media_read(xts->backend, address, data, length, NULL, NULL);
+	for (done = 0; status == MEDIA_STATUS_SUCCESS && done < length;
+	     done += count) {
+		count = length - done;
+		if (count > MEDIA_XTS_MAX_BATCH)
+			count = MEDIA_XTS_MAX_BATCH;
+		if (_media_xts_crypt(xts, false, address + done, buf, buf, count) < 0) {
+			trace_warning("media_xts_read: decryption failed\n\r");
+			status = MEDIA_STATUS_ERROR;
+		}
+		buf += count * media->block_size;
+	}
+
+	media->state = MEDIA_STATE_READY;
+
+	if (callback)
+		callback(callback_arg, status, 0, 0);
+
+	return status;
+}
+
+/**
+ *  \brief Encrypts and writes blocks to the backend media
+ *  \param media Pointer to a Media instance
+ *  \param address Address of the first block to write
+ *  \param data Pointer to the plaintext to write (left unmodified)
+ *  \param length Number of blocks to write
+ *  \param callback Optional pointer to a callback function to invoke when
+ *                  the write operation terminates
+ *  \param callback_arg Optional argument for the callback function
+ *  \return Operation result code
+ */
+static uint8_t media_xts_write(struct _media *media,
+		uint32_t address, void *data, uint32_t length,
+		media_callback_t callback, void *callback_arg)
+{
+	struct _media_xts* xts = (struct _media_xts*)media->interface;
+	uint8_t* bounce = xts->buffer + MEDIA_XTS_TWEAK_AREA_SIZE;
+	const uint8_t* buf = (const uint8_t*)data;
+	uint32_t done, count;
+	uint8_t status = MEDIA_STATUS_SUCCESS;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	if ((address + length) > media->size)
+		return MEDIA_STATUS_ERROR;
+
+	media->state = MEDIA_STATE_BUSY;
+
+	for (done = 0; status == MEDIA_STATUS_SUCCESS && done < length;
+	     done += count) {
+		count = length - done;
+		if (count > xts->batch)
+			count = xts->batch;
+		if (_media_xts_crypt(xts, true, address + done, buf, bounce, count) < 0) {
+			trace_warning("media_xts_write: encryption failed\n\r");
+			status = MEDIA_STATUS_ERROR;
+			break;
+		}
+		status = media_write(xts->backend, address + done, bounce, count,
+				NULL, NULL);
+		buf += count * media->block_size;
+	}
+
+	media->state = MEDIA_STATE_READY;
+
+	if (callback)
+		callback(callback_arg, status, 0, 0);
+
+	return status;
+}
+
+static uint8_t media_xts_flush(struct _media *media)
+{
+	struct _media_xts* xts = (struct _media_xts*)media->interface;
+
+	return media_flush(xts->backend);
+}
+
+static void media_xts_handler(struct _media *media)
+{
+	struct _media_xts* xts = (struct _media_xts*)media->interface;
+
+	media_handler(xts->backend);
+}
+
+#ifdef CONFIG_HAVE_AES
+static int _media_xts_aesd_ecb(void* arg, bool tweak_key, bool encrypt,
+		const uint8_t* in, uint8_t* out, uint32_t length)
+{
+	struct _media_xts_aesd* ctx = (struct _media_xts_aesd*)arg;
+	struct _aesd_desc* desc = ctx->aesd;
+	struct _buffer buf_in = {
+		.data = (uint8_t*)in,
+		.size = length,
+	};
+	struct _buffer buf_out = {
+		.data = out,
+		.size = length,
+	};
+
+	desc->cfg.mode = AESD_MODE_ECB;
+	desc->cfg.encrypt = encrypt;
+	memcpy(desc->cfg.key, tweak_key ? ctx->key2 : ctx->key1,
+			sizeof(desc->cfg.key));
+
+	if (aesd_transfer(desc, &buf_in, &buf_out, NULL, NULL) != AESD_SUCCESS)
+		return -EBUSY;
+	aesd_wait_transfer(desc);
+
+	return 0;
+}
+#endif
+
+/*---------------------------------------------------------------------------
+ *      Exported Functions
+ *---------------------------------------------------------------------------*/
+
+uint8_t media_xts_initialize(struct _media* media,
+		struct _media_xts* xts, struct _media* backend,
+		const struct _media_xts_engine* engine,
+		uint8_t* buffer, uint32_t buffer_size)
+{
+	uint32_t batch;
+
+	if (backend->block_size == 0 ||
+	    (backend->block_size % MEDIA_XTS_AES_BLOCK_SIZE) != 0) {
+		trace_error("media_xts: block size %u not supported\n\r",
+				(unsigned)backend->block_size);
+		return MEDIA_STATUS_ERROR;
+	}
+
+	if (buffer_size < MEDIA_XTS_TWEAK_AREA_SIZE + backend->block_size) {
+		trace_error("media_xts: work buffer too small\n\r");
+		return MEDIA_STATUS_ERROR;
+	}
+
+	batch = (buffer_size - MEDIA_XTS_TWEAK_AREA_SIZE) / backend->block_size;
+	if (batch > MEDIA_XTS_MAX_BATCH)
+		batch = MEDIA_XTS_MAX_BATCH;
+
+	xts->backend = backend;
+	xts->engine = *engine;
+	xts->buffer = buffer;
+	xts->buffer_size = buffer_size;
+	xts->batch = batch;
+
+	memset(media, 0, sizeof(*media));
+
+	media->write = media_xts_write;
+	media->read = media_xts_read;
+	media->flush = media_xts_flush;
+	media->handler = media_xts_handler;
+
+	media->interface = xts;
+	media->block_size = backend->block_size;
+	media->base_address = 0;
+	media->size = backend->size;
+
+	/* Never expose the ciphertext through mapped accesses */
+	media->mapped_read = false;
+	media->mapped_write = false;
+	media->write_protected = backend->write_protected;
+	media->removable = backend->removable;
+	media->state = backend->state;
+
+	return MEDIA_STATUS_SUCCESS;
+}
+
+int media_xts_process(struct _media_xts* xts, bool encrypt,
+		uint32_t block, uint8_t* data, uint32_t count)
+{
+	uint32_t n;
+	int err;
+
+	while (count > 0) {
+		n = count < MEDIA_XTS_MAX_BATCH ? count : MEDIA_XTS_MAX_BATCH;
+		err = _media_xts_crypt(xts, encrypt, block, data, data, n);
+		if (err < 0)
+			return err;
+		block += n;
+		data += n * xts->backend->block_size;
+		count -= n;
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_HAVE_AES
+void media_xts_aesd_engine_init(struct _media_xts_engine* engine,
+		struct _media_xts_aesd* ctx, struct _aesd_desc* aesd,
+		const uint32_t* key1, const uint32_t* key2)
+{
+	uint32_t key_len;
+
+	switch (aesd->cfg.key_size) {
+	case AESD_AES128:
+		key_len = 16;
+		break;
+	case AESD_AES192:
+		key_len = 24;
+		break;
+	default:
+		key_len = 32;
+		break;
+	}
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->aesd = aesd;
+	memcpy(ctx->key1, key1, key_len);
+	memcpy(ctx->key2, key2, key_len);
+
+	engine->ecb = _media_xts_aesd_ecb;
+	engine->arg = ctx;
+}
+#endif
@@ -0,0 +1,215 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *
+ *  \section Purpose
+ *
+ *  Encrypting media wrapper: AES-XTS (IEEE P1619) applied transparently on
+ *  top of any other media (SD card, RAM disk...).
+ *
+ *  Each media block is one XTS data unit, and its absolute block number on
+ *  the backend is used as the tweak, so the same block always encrypts to the
+ *  same position-dependent ciphertext and nothing but the media size leaks.
+ *
+ *  The XTS tweak chaining is done in software around plain AES-ECB passes:
+ *  the sector tweaks of a whole batch are encrypted in one ECB pass with the
+ *  tweak key, then the data of the whole batch in one ECB pass with the data
+ *  key. With the AESD engine, this amortizes the AES/DMA setup over up to
+ *  MEDIA_XTS_MAX_BATCH blocks instead of paying it for every sector.
+ *
+ *  The ECB engine is pluggable:
+ *  - media_xts_aesd_engine_init() uses the AES peripheral (AESD driver)
+ *  - media_xts_soft_engine_init() is a portable software AES, used as a
+ *    reference implementation (host builds, chips without AES).
+ *
+ *  \section Usage
+ *  -# Initialize the backend media (e.g. media_sdcard_initialize()).
+ *  -# Initialize an ECB engine with the data and tweak keys.
+ *  -# Call media_xts_initialize() with a cache-aligned work buffer, and use
+ *     the resulting media as any other one.
+ *
+ *  \note The backend is expected to complete its read/write operations before
+ *  returning (this is the case for media_sdcard and media_ramdisk).
+ *  \note When the AESD engine is used in DMA mode, the data buffers given to
+ *  media_read() must be aligned on a cache line.
+ */
+
+#ifndef _MEDIA_XTS_H
+#define _MEDIA_XTS_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "libstoragemedia/media.h"
+#ifdef CONFIG_HAVE_AES
+#include "crypto/aesd.h"
+#endif
+
+/*------------------------------------------------------------------------------
+ *      Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Size of an AES block (XTS tweak granularity) */
+#define MEDIA_XTS_AES_BLOCK_SIZE 16
+
+/** Maximum number of media blocks processed per engine call */
+#ifndef MEDIA_XTS_MAX_BATCH
+#define MEDIA_XTS_MAX_BATCH 32
+#endif
+
+/** Space reserved for the sector tweaks at the beginning of the work buffer */
+#define MEDIA_XTS_TWEAK_AREA_SIZE (MEDIA_XTS_MAX_BATCH * MEDIA_XTS_AES_BLOCK_SIZE)
+
+/*------------------------------------------------------------------------------
+ *      Types
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief AES-ECB engine used by the XTS layer.
+ *
+ * \param arg engine private data
+ * \param tweak_key true to use the tweak key (key2), false for the data
+ * key (key1)
+ * \param encrypt true to encrypt, false to decrypt
+ * \param in input data
+ * \param out output data, may be equal to \a in
+ * \param length number of bytes to process, multiple of
+ * MEDIA_XTS_AES_BLOCK_SIZE
+ * \return 0 on success, <0 on error
+ */
+typedef int (*media_xts_ecb_t)(void* arg, bool tweak_key, bool encrypt,
+		const uint8_t* in, uint8_t* out, uint32_t length);
+
+struct _media_xts_engine {
+	media_xts_ecb_t ecb;
+	void* arg;
+};
+
+struct _media_xts {
+	struct _media* backend;          /**< Media holding the ciphertext */
+	struct _media_xts_engine engine; /**< AES-ECB engine */
+	uint8_t* buffer;                 /**< Cache-aligned work buffer */
+	uint32_t buffer_size;            /**< Work buffer size in bytes */
+	uint32_t batch;                  /**< Blocks processed per engine call */
+};
+
+#ifdef CONFIG_HAVE_AES
+/** Context of the AESD (AES peripheral) engine */
+struct _media_xts_aesd {
+	struct _aesd_desc* aesd;  /**< Initialized AESD descriptor */
+	uint32_t key1[8];         /**< Data key */
+	uint32_t key2[8];         /**< Tweak key */
+};
+#endif
+
+/** Context of the software AES engine */
+struct _media_xts_soft {
+	uint8_t rounds;           /**< 10, 12 or 14 rounds */
+	uint8_t rk1[240];          /**< Data key schedule */
+	uint8_t rk2[240];          /**< Tweak key schedule */
+};
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize an encrypting media on top of a backend media.
+ *
+ * \param media Media instance to initialize
+ * \param xts XTS descriptor, must stay valid while the media is used
+ * \param backend Initialized backend media
+ * \param engine AES-ECB engine
+ * \param buffer Cache-aligned work buffer, at least
+ * MEDIA_XTS_TWEAK_AREA_SIZE plus one media block. Larger buffers allow
+ * writes to be batched (up to MEDIA_XTS_MAX_BATCH blocks).
+ * \param buffer_size Size of the work buffer, in bytes
+ * \return MEDIA_STATUS_SUCCESS, or MEDIA_STATUS_ERROR if the backend block
+ * size is not a multiple of the AES block size or the buffer is too small
+ */
+extern uint8_t media_xts_initialize(struct _media* media,
+		struct _media_xts* xts, struct _media* backend,
+		const struct _media_xts_engine* engine,
+		uint8_t* buffer, uint32_t buffer_size);
+
+/**
+ * \brief Encrypt or decrypt blocks in place, as done by the media layer.
+ *
+ * Exposed so that existing plaintext media contents can be converted, and
+ * for comparing engines against each other.
+ *
+ * \param xts XTS descriptor
+ * \param encrypt true to encrypt, false to decrypt
+ * \param block Absolute block number of the first block (tweak)
+ * \param data Data to process in place
+ * \param count Number of blocks
+ * \return 0 on success, <0 on error
+ */
+extern int media_xts_process(struct _media_xts* xts, bool encrypt,
+		uint32_t block, uint8_t* data, uint32_t count);
+
+#ifdef CONFIG_HAVE_AES
+/**
+ * \brief Initialize an ECB engine using the AES peripheral.
+ *
+ * The key size and transfer mode (polling or DMA) are taken from the AESD
+ * descriptor configuration.
+ *
+ * \param engine Engine to initialize
+ * \param ctx Engine context, must stay valid while the engine is used
+ * \param aesd Initialized AESD descriptor (see aesd_init())
+ * \param key1 Data key
+ * \param key2 Tweak key
+ */
+extern void media_xts_aesd_engine_init(struct _media_xts_engine* engine,
+		struct _media_xts_aesd* ctx, struct _aesd_desc* aesd,
+		const uint32_t* key1, const uint32_t* key2);
+#endif
+
+/**
+ * \brief Initialize a software AES ECB engine (reference implementation).
+ *
+ * \param engine Engine to initialize
+ * \param ctx Engine context, must stay valid while the engine is used
+ * \param key1 Data key
+ * \param key2 Tweak key
+ * \param key_len Length of each key in bytes: 16, 24 or 32
+ * \return 0 on success, -EINVAL if the key length is not supported
+ */
+extern int media_xts_soft_engine_init(struct _media_xts_engine* engine,
+		struct _media_xts_soft* ctx, const uint8_t* key1,
+		const uint8_t* key2, uint32_t key_len);
+
+#endif /* _MEDIA_XTS_H */
@@ -0,0 +1,279 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Portable software AES-ECB engine for the XTS media layer.
+ *
+ * This is a straightforward byte-oriented implementation of FIPS-197. It
+ * does not depend on any peripheral, so it is used as the reference
+ * implementation (e.g. in host builds) and as a fallback on devices without
+ * an AES peripheral. It is not hardened against timing side channels.
+ */
+
+/*---------------------------------------------------------------------------
+ *         Headers
+ *---------------------------------------------------------------------------*/
+
+#include "errno.h"
+
+#include "media_xts.h"
+
+#include <string.h>
+
+/*---------------------------------------------------------------------------
+ *      Local constants
+ *---------------------------------------------------------------------------*/
+
+static const uint8_t _sbox[256] = {
+	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+	0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+	0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+	0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+	0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+	0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+	0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+	0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+	0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+	0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+	0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+	0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+	0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+	0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+	0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+	0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static const uint8_t _inv_sbox[256] = {
+	0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
+	0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
+	0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
+	0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2, 0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25,
+	0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92,
+	0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda, 0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84,
+	0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a, 0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06,
+	0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02, 0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b,
+	0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea, 0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73,
+	0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85, 0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e,
+	0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89, 0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b,
+	0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20, 0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4,
+	0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31, 0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f,
+	0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
+	0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
+	0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d,
+};
+
+/*---------------------------------------------------------------------------
+ *      Local functions
+ *---------------------------------------------------------------------------*/
+
+static uint8_t _xtime(uint8_t x)
+{
+	return (uint8_t)((x << 1) ^ ((x & 0x80) ? 0x1b : 0));
+}
+
+static uint8_t _gmul(uint8_t a, uint8_t b)
+{
+	uint8_t r = 0;
+
+	while (b) {
+		if (b & 1)
+			r ^= a;
+		a = _xtime(a);
+		b >>= 1;
+	}
+	return r;
+}
+
+static void _aes_expand_key(uint8_t* rk, const uint8_t* key, uint32_t key_len, uint8_t rounds)
+{
+	uint32_t nk = key_len / 4;
+	uint32_t total = 4 * (rounds + 1);
+	uint8_t rcon = 1;
+	uint32_t i;
+
+	memcpy(rk, key, key_len);
+
+	for (i = nk; i < total; i++) {
+		uint8_t t[4];
+
+		memcpy(t, rk + 4 * (i - 1), 4);
+		if ((i % nk) == 0) {
+			uint8_t tmp = t[0];
+			t[0] = _sbox[t[1]] ^ rcon;
+			t[1] = _sbox[t[2]];
+			t[2] = _sbox[t[3]];
+			t[3] = _sbox[tmp];
+			rcon = _xtime(rcon);
+		} else if (nk > 6 && (i % nk) == 4) {
+			t[0] = _sbox[t[0]];
+			t[1] = _sbox[t[1]];
+			t[2] = _sbox[t[2]];
+			t[3] = _sbox[t[3]];
+		}
+		rk[4 * i + 0] = rk[4 * (i - nk) + 0] ^ t[0];
+		rk[4 * i + 1] = rk[4 * (i - nk) + 1] ^ t[1];
+		rk[4 * i + 2] = rk[4 * (i - nk) + 2] ^ t[2];
+		rk[4 * i + 3] = rk[4 * (i - nk) + 3] ^ t[3];
+	}
+}
+
+static void _aes_add_round_key(uint8_t* s, const uint8_t* rk)
+{
+	int i;
+
+	for (i = 0; i < 16; i++)
+		s[i] ^= rk[i];
+}
+
+static void _aes_encrypt_block(const uint8_t* rk, uint8_t rounds, uint8_t* s)
+{
+	uint8_t t[16];
+	uint8_t round;
+	int c;
+
+	_aes_add_round_key(s, rk);
+
+	for (round = 1; round <= rounds; round++) {
+		/* SubBytes and ShiftRows */
+		for (c = 0; c < 4; c++) {
+			t[4 * c + 0] = _sbox[s[4 * c + 0]];
+			t[4 * c + 1] = _sbox[s[4 * ((c + 1) & 3) + 1]];
+			t[4 * c + 2] = _sbox[s[4 * ((c + 2) & 3) + 2]];
+			t[4 * c + 3] = _sbox[s[4 * ((c + 3) & 3) + 3]];
+		}
+
+		/* MixColumns (skipped on the last round) */
+		if (round != rounds) {
+			for (c = 0; c < 4; c++) {
+				uint8_t* col = &t[4 * c];
+				uint8_t all = col[0] ^ col[1] ^ col[2] ^ col[3];
+				uint8_t a0 = col[0];
+
+				s[4 * c + 0] = col[0] ^ all ^ _xtime(col[0] ^ col[1]);
+				s[4 * c + 1] = col[1] ^ all ^ _xtime(col[1] ^ col[2]);
+				s[4 * c + 2] = col[2] ^ all ^ _xtime(col[2] ^ col[3]);
+				s[4 * c + 3] = col[3] ^ all ^ _xtime(col[3] ^ a0);
+			}
+		} else {
+			memcpy(s, t, 16);
+		}
+
+		_aes_add_round_key(s, rk + 16 * round);
+	}
+}
+
+static void _aes_decrypt_block(const uint8_t* rk, uint8_t rounds, uint8_t* s)
+{
+	uint8_t t[16];
+	uint8_t round;
+	int c;
+
+	_aes_add_round_key(s, rk + 16 * rounds);
+
+	for (round = rounds; round >= 1; round--) {
+		/* InvShiftRows and InvSubBytes */
+		for (c = 0; c < 4; c++) {
+			t[4 * c + 0] = _inv_sbox[s[4 * c + 0]];
+			t[4 * c + 1] = _inv_sbox[s[4 * ((c + 3) & 3) + 1]];
+			t[4 * c + 2] = _inv_sbox[s[4 * ((c + 2) & 3) + 2]];
+			t[4 * c + 3] = _inv_sbox[s[4 * ((c + 1) & 3) + 3]];
+		}
+
+		_aes_add_round_key(t, rk + 16 * (round - 1));
+
+		/* InvMixColumns (skipped on the last round) */
+		if (round != 1) {
+			for (c = 0; c < 4; c++) {
+				uint8_t* col = &t[4 * c];
+
+				s[4 * c + 0] = _gmul(col[0], 14) ^ _gmul(col[1], 11) ^ _gmul(col[2], 13) ^ _gmul(col[3], 9);
+				s[4 * c + 1] = _gmul(col[0], 9) ^ _gmul(col[1], 14) ^ _gmul(col[2], 11) ^ _gmul(col[3], 13);
+				s[4 * c + 2] = _gmul(col[0], 13) ^ _gmul(col[1], 9) ^ _gmul(col[2], 14) ^ _gmul(col[3], 11);
+				s[4 * c + 3] = _gmul(col[0], 11) ^ _gmul(col[1], 13) ^ _gmul(col[2], 9) ^ _gmul(col[3], 14);
+			}
+		} else {
+			memcpy(s, t, 16);
+		}
+	}
+}
+
+static int _media_xts_soft_ecb(void* arg, bool tweak_key, bool encrypt,
+		const uint8_t* in, uint8_t* out, uint32_t length)
+{
+	struct _media_xts_soft* ctx = (struct _media_xts_soft*)arg;
+	const uint8_t* rk = tweak_key ? ctx->rk2 : ctx->rk1;
+	uint32_t i;
+
+	if (length % MEDIA_XTS_AES_BLOCK_SIZE)
+		return -EINVAL;
+
+	for (i = 0; i < length; i += MEDIA_XTS_AES_BLOCK_SIZE) {
+		if (out != in)
+			memcpy(out + i, in + i, MEDIA_XTS_AES_BLOCK_SIZE);
+		if (encrypt)
+			_aes_encrypt_block(rk, ctx->rounds, out + i);
+		else
+			_aes_decrypt_block(rk, ctx->rounds, out + i);
+	}
+
+	return 0;
+}
+
+/*---------------------------------------------------------------------------
+ *      Exported Functions
+ *---------------------------------------------------------------------------*/
+
+int media_xts_soft_engine_init(struct _media_xts_engine* engine,
+		struct _media_xts_soft* ctx, const uint8_t* key1,
+		const uint8_t* key2, uint32_t key_len)
+{
+	switch (key_len) {
+	case 16:
+		ctx->rounds = 10;
+		break;
+	case 24:
+		ctx->rounds = 12;
+		break;
+	case 32:
+		ctx->rounds = 14;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	_aes_expand_key(ctx->rk1, key1, key_len, ctx->rounds);
+	_aes_expand_key(ctx->rk2, key2, key_len, ctx->rounds);
+
+	engine->ecb = _media_xts_soft_ecb;
+	engine->arg = ctx;
+
+	return 0;
+}
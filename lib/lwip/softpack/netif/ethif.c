@@ -46,6 +46,7 @@
 #include "chip.h"
 #include "compiler.h"
 #include "gpio/pio.h"
+#include "heap.h"
 #include "lwip/opt.h"
 #include "netif/etharp.h"
 #include "netif/ethif.h"
@@ -70,6 +71,9 @@
 #define IFNAME0 'e'
 #define IFNAME1 'n'
 
+/* Largest frame exchanged with the driver, without FCS */
+#define ETHIF_FRAME_SIZE 1514
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -171,10 +175,19 @@ static err_t glow_level_output(struct netif *netif, struct pbuf *p)
 {
 
     struct pbuf *q;
-    uint8_t buf[1514];
-    uint8_t *bufptr = &buf[0];
+    uint8_t *buf;
+    uint8_t *bufptr;
     uint8_t rc;
 
+    /* frame buffer from the shared driver region, only held during the
+       copy to the driver */
+    buf = heap_alloc(ETHIF_FRAME_SIZE, 0);
+    if (buf == NULL) {
+        LINK_STATS_INC(link.memerr);
+        return ERR_MEM;
+    }
+    bufptr = buf;
+
 #if ETH_PAD_SIZE
     pbuf_header(p, -ETH_PAD_SIZE);    /* drop the padding word */
 #endif
@@ -191,6 +204,7 @@ static err_t glow_level_output(struct netif *netif, struct pbuf *p)
 
     /* signal that packet should be sent(); */
     rc = ethd_send(board_get_eth(netif->num), 0, buf, p->tot_len, NULL);
+    heap_free(buf);
     if (rc != ETH_OK) {
         return ERR_BUF;
     }
@@ -215,17 +229,25 @@ static struct pbuf *glow_level_input(struct netif *netif)
 {
     struct pbuf *p, *q;
     u16_t len;
-    uint8_t buf[1514];
-    uint8_t *bufptr = &buf[0];
+    uint8_t *buf;
+    uint8_t *bufptr;
 
     uint32_t frmlen;
     uint8_t rc;
 
+    buf = heap_alloc(ETHIF_FRAME_SIZE, 0);
+    if (buf == NULL)
+    {
+      return NULL;
+    }
+    bufptr = buf;
+
     /* Obtain the size of the packet and put it into the "len"
        variable. */
-    rc = ethd_poll(board_get_eth(netif->num), 0, buf, (uint32_t)sizeof(buf), (uint32_t*)&frmlen);
+    rc = ethd_poll(board_get_eth(netif->num), 0, buf, ETHIF_FRAME_SIZE, (uint32_t*)&frmlen);
     if (rc != ETH_OK)
     {
+      heap_free(buf);
       return NULL;
     }
     len = frmlen;
@@ -262,6 +284,7 @@ static struct pbuf *glow_level_input(struct netif *netif)
         LINK_STATS_INC(link.memerr);
         LINK_STATS_INC(link.drop);
     }
+    heap_free(buf);
     return p;
 }
 
@@ -59,6 +59,14 @@
 #define FRAME_BPP         (16)
 /** Video frame buffer size calculation */
 #define FRAME_BUFFER_SIZEC(W,H)  ((W)*(H)*FRAME_BPP/8)
+/** Payload header area reserved after each frame of the capture ring, sized
+ *  for the smallest (full speed) payloads */
+#define FRAME_HEADERS_SIZEC(W,H) ROUND_UP_MULT((FRAME_BUFFER_SIZEC(W,H) / \
+		(FRAME_PACKET_SIZE_FS - FRAME_PAYLOAD_HDR_SIZE) + 1) * \
+		FRAME_PAYLOAD_HDR_SIZE, L1_CACHE_BYTES)
+/** Capture ring slot size: frame followed by its payload headers */
+#define FRAME_SLOT_SIZEC(W,H) (ROUND_UP_MULT(FRAME_BUFFER_SIZEC(W,H), L1_CACHE_BYTES) + \
+		FRAME_HEADERS_SIZEC(W,H))
 /** Video frame bit-rate calculation */
 #define FRAME_BITRATEC(W,H,FR)  ((FR)*FRAME_BUFFER_SIZEC(W,H)*8)
 /** Video frame interval calculation (100ns) */
@@ -88,6 +96,11 @@
 #define VIDCAMD_IsoInEndpointNum        2
 #endif
 
+/** Index of the uncompressed YUY2 format */
+#define VIDCAMD_FormatIndexYUY2         1
+/** Index of the Motion-JPEG format, when declared */
+#define VIDCAMD_FormatIndexMJPEG        2
+
 /** Number of Video Frame Types */
 #define VIDCAMD_NumFrameTypes           3
 
@@ -138,6 +151,26 @@ typedef PACKED_STRUCT _UsbVideoInputHeaderDescriptor1 {
 	uint8_t     bmaControls1;
 } UsbVideoInputHeaderDescriptor1;
 
+/**
+ * Input header descriptor (with 2 formats)
+ */
+typedef PACKED_STRUCT _UsbVideoInputHeaderDescriptor2 {
+	uint8_t     bLength;
+	uint8_t     bDescriptorType;
+	uint8_t     bDescriptorSubType;
+	uint8_t     bNumFormats;
+	uint16_t    wTotalLength;
+	uint8_t     bEndpointAddress;
+	uint8_t     bmInfo;
+	uint8_t     bTerminalLink;
+	uint8_t     bStillCaptureMethod;
+	uint8_t     bTriggerSupport;
+	uint8_t     bTriggerUsage;
+	uint8_t     bControlSize;
+	uint8_t     bmaControls1;
+	uint8_t     bmaControls2;
+} UsbVideoInputHeaderDescriptor2;
+
 /**
  * Class-specific USB VideoControl Interface descriptor list
  */
@@ -161,6 +194,22 @@ typedef PACKED_STRUCT _UsbVideoStreamingInterfaceDescriptor {
 	UsbVideoFormatDescriptor format;
 } UsbVideoStreamingInterfaceDescriptor;
 
+/** USB Video Motion-JPEG Format with the same frames as the uncompressed one */
+typedef PACKED_STRUCT _UsbVideoFormatMJPEGDescriptor {
+	USBVideoMJPEGFormatDescriptor payload;
+	USBVideoMJPEGFrameDescriptor1 frame320x240;
+	USBVideoMJPEGFrameDescriptor1 frame640x480;
+	USBVideoMJPEGFrameDescriptor1 frame160x120;
+	USBVideoColorMatchingDescriptor colorMJPEG;
+} UsbVideoFormatMJPEGDescriptor;
+
+/** Streaming interface with the uncompressed and Motion-JPEG formats */
+typedef PACKED_STRUCT _UsbVideoStreamingInterfaceDescriptor2 {
+	UsbVideoInputHeaderDescriptor2 inHeader;
+	UsbVideoFormatDescriptor format;
+	UsbVideoFormatMJPEGDescriptor formatMJPEG;
+} UsbVideoStreamingInterfaceDescriptor2;
+
 PACKED_STRUCT UsbVideoCamConfigurationDescriptors {
 	/* Configuration descriptor */
 	USBConfigurationDescriptor configuration;
@@ -180,6 +229,26 @@ PACKED_STRUCT UsbVideoCamConfigurationDescriptors {
 	USBEndpointDescriptor ep11;
 };
 
+/** Configuration with the uncompressed and Motion-JPEG formats */
+PACKED_STRUCT UsbVideoCamMJPEGConfigurationDescriptors {
+	/* Configuration descriptor */
+	USBConfigurationDescriptor configuration;
+	/* IAD */
+	USBInterfaceAssociationDescriptor iad;
+	/* VideoControl I/F */
+	USBInterfaceDescriptor interface0;
+	/* VideoControl I/F Descriptors */
+	UsbVideoControlInterfaceDescriptor vcInterface;
+	/* VideoStreaming I/F */
+	USBInterfaceDescriptor interface10;
+	/* VideoStreaming I/F Descriptors */
+	UsbVideoStreamingInterfaceDescriptor2 vsInterface;
+	/* VideoStreaming I/F */
+	USBInterfaceDescriptor interface11;
+	/* Endpoint */
+	USBEndpointDescriptor ep11;
+};
+
 
 /**@}*/
 #endif /* _VIDEODESCRIPTORS_H_ */
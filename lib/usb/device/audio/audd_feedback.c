@@ -0,0 +1,201 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/** \addtogroup usbd_audio_feedback
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "usb/device/audio/audd_feedback.h"
+#include "usb/device/usbd.h"
+
+/*------------------------------------------------------------------------------
+ *         Local definitions
+ *------------------------------------------------------------------------------*/
+
+/** Frame counter wraps every 2^14 units of 125us */
+#define FRAME_NUMBER_MASK       0x3FFF
+
+/** Number of 125us units in one ms frame */
+#define MICROFRAMES_PER_FRAME   8
+
+/** Consumption rate filter, as a right shift (1/8 of the new measurement) */
+#define MEASURE_FILTER_SHIFT    3
+
+/** Allowed deviation from the nominal rate, as a right shift (1/8) */
+#define DEVIATION_SHIFT         3
+
+/** Maximum contribution of the integral term, as a right shift (1/64) */
+#define INTEGRAL_LIMIT_SHIFT    6
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Initialize a feedback rate controller.
+ * \param fb          Pointer to AUDDFeedback instance.
+ * \param sample_rate Nominal sample rate of the stream in Hz.
+ * \param target      Target fill level of the device buffer, in samples.
+ * \param refresh     Feedback refresh exponent: the rate is measured over
+ *                    2^refresh ms (bRefresh of the feedback endpoint).
+ */
+void audd_feedback_initialize(AUDDFeedback *fb, uint32_t sample_rate,
+		uint32_t target, uint8_t refresh)
+{
+	fb->dNominal = (uint32_t)(((uint64_t)sample_rate << 16) / 1000);
+	fb->dTarget = target;
+	fb->wPeriod = (1u << refresh) * MICROFRAMES_PER_FRAME;
+	fb->bKpShift = AUDD_FEEDBACK_KP_SHIFT;
+	fb->bKiShift = AUDD_FEEDBACK_KI_SHIFT;
+	fb->dConsumed = 0;
+	audd_feedback_reset(fb);
+}
+
+/**
+ * Restart the controller from the nominal rate, typically when the host
+ * selects the streaming alternate setting.
+ * \param fb Pointer to AUDDFeedback instance.
+ */
+void audd_feedback_reset(AUDDFeedback *fb)
+{
+	fb->dValue = fb->dNominal;
+	fb->dMeasured = fb->dNominal;
+	fb->lIntegral = 0;
+	fb->dLastConsumed = fb->dConsumed;
+	fb->bHighSpeed = usbd_is_high_speed() ? 1 : 0;
+	fb->bStarted = 0;
+	fb->dUpdates = 0;
+}
+
+/**
+ * Account for samples played by the codec. Must be called from a single
+ * context (e.g. the audio DMA completion callback).
+ * \param fb      Pointer to AUDDFeedback instance.
+ * \param samples Number of samples (per channel) consumed.
+ */
+void audd_feedback_consumed(AUDDFeedback *fb, uint32_t samples)
+{
+	fb->dConsumed += samples;
+}
+
+/**
+ * Update the feedback value. Should be called on each received isochronous
+ * packet; the consumption rate is measured against the SOF frame counter
+ * once per refresh period.
+ * \param fb    Pointer to AUDDFeedback instance.
+ * \param level Current fill level of the device buffer, in samples.
+ */
+void audd_feedback_update(AUDDFeedback *fb, uint32_t level)
+{
+	uint16_t frame = usbd_get_frame_number();
+	uint32_t consumed = fb->dConsumed;
+	uint32_t elapsed, rate, deviation, limit;
+	int32_t error, delta;
+	int64_t value;
+
+	if (!fb->bStarted) {
+		fb->wLastFrame = frame;
+		fb->dLastConsumed = consumed;
+		fb->bStarted = 1;
+		return;
+	}
+
+	elapsed = (uint16_t)(frame - fb->wLastFrame) & FRAME_NUMBER_MASK;
+	if (elapsed < fb->wPeriod)
+		return;
+	fb->wLastFrame = frame;
+
+	/* Codec consumption rate, in samples per ms (16.16) */
+	rate = (uint32_t)((((uint64_t)(consumed - fb->dLastConsumed) << 16)
+				* MICROFRAMES_PER_FRAME) / elapsed);
+	fb->dLastConsumed = consumed;
+	delta = (int32_t)(rate - fb->dMeasured);
+	fb->dMeasured += delta >> MEASURE_FILTER_SHIFT;
+
+	/* PI correction on the fill level */
+	error = (int32_t)fb->dTarget - (int32_t)level;
+	limit = (uint32_t)((((uint64_t)fb->dNominal >> INTEGRAL_LIMIT_SHIFT)
+				<< fb->bKiShift) >> 16);
+	fb->lIntegral += error;
+	if (fb->lIntegral > (int32_t)limit)
+		fb->lIntegral = (int32_t)limit;
+	else if (fb->lIntegral < -(int32_t)limit)
+		fb->lIntegral = -(int32_t)limit;
+
+	/* The terms are negative when above the target, scale them with a
+	 * multiplication as left shifts of negative values are undefined */
+	value = (int64_t)fb->dMeasured
+	      + (((int64_t)error * (1 << 16)) >> fb->bKpShift)
+	      + (((int64_t)fb->lIntegral * (1 << 16)) >> fb->bKiShift);
+
+	deviation = fb->dNominal >> DEVIATION_SHIFT;
+	if (value > (int64_t)(fb->dNominal + deviation))
+		value = fb->dNominal + deviation;
+	else if (value < (int64_t)(fb->dNominal - deviation))
+		value = fb->dNominal - deviation;
+
+	fb->dValue = (uint32_t)value;
+	fb->dUpdates++;
+}
+
+/**
+ * Build the feedback packet for the current bus speed: 10.14 samples per
+ * frame on 3 bytes at full-speed, 16.16 samples per microframe on 4 bytes
+ * at high-speed.
+ * \param fb     Pointer to AUDDFeedback instance.
+ * \param buffer Buffer of at least AUDD_FEEDBACK_MAX_SIZE bytes.
+ * \return Size of the feedback packet in bytes.
+ */
+uint32_t audd_feedback_encode(const AUDDFeedback *fb, uint8_t *buffer)
+{
+	uint32_t value;
+
+	if (fb->bHighSpeed) {
+		value = fb->dValue / MICROFRAMES_PER_FRAME;
+		buffer[0] = value & 0xFF;
+		buffer[1] = (value >> 8) & 0xFF;
+		buffer[2] = (value >> 16) & 0xFF;
+		buffer[3] = (value >> 24) & 0xFF;
+		return 4;
+	} else {
+		value = fb->dValue >> 2;
+		buffer[0] = value & 0xFF;
+		buffer[1] = (value >> 8) & 0xFF;
+		buffer[2] = (value >> 16) & 0xFF;
+		return 3;
+	}
+}
+
+/**@}*/
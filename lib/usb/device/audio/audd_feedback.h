@@ -0,0 +1,127 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ *  USB Audio asynchronous OUT stream feedback.
+ */
+
+/** \addtogroup usbd_audio_feedback
+ *@{
+ *  Computes the explicit feedback value reported to the host for an
+ *  asynchronous isochronous OUT stream. The host adjusts the number of
+ *  samples it sends in each frame so that the device buffer stays at a
+ *  target depth, whatever the drift between the USB SOF clock and the
+ *  codec clock.
+ *
+ *  The device measures how many samples the codec consumed against the SOF
+ *  frame counter, and corrects this rate with a PI controller acting on the
+ *  buffer fill level:
+ *  -# Initialize with audd_feedback_initialize() and call
+ *     audd_feedback_reset() each time the stream starts.
+ *  -# Call audd_feedback_consumed() each time the codec has played samples.
+ *  -# Call audd_feedback_update() each time a packet is received (the
+ *     reception of the isochronous packet stands in for the SOF event).
+ *  -# Send the value built by audd_feedback_encode() on the feedback
+ *     endpoint.
+ */
+
+#ifndef _AUDD_FEEDBACK_H_
+#define _AUDD_FEEDBACK_H_
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Maximum size of a feedback packet in bytes (16.16 high-speed format) */
+#define AUDD_FEEDBACK_MAX_SIZE          4
+
+/** Default proportional gain, as a right shift of the fill error */
+#define AUDD_FEEDBACK_KP_SHIFT          6
+/** Default integral gain, as a right shift of the fill error integral */
+#define AUDD_FEEDBACK_KI_SHIFT          12
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** Feedback rate controller instance */
+typedef struct _AUDDFeedback {
+	/** Nominal rate in samples per ms, 16.16 */
+	uint32_t dNominal;
+	/** Current feedback value in samples per ms, 16.16 */
+	uint32_t dValue;
+	/** Filtered codec consumption rate in samples per ms, 16.16 */
+	uint32_t dMeasured;
+	/** Target fill level of the device buffer, in samples */
+	uint32_t dTarget;
+	/** Integral of the fill level error, in samples */
+	int32_t lIntegral;
+	/** Samples consumed by the codec (free running, single writer) */
+	volatile uint32_t dConsumed;
+	/** Value of dConsumed at the last measurement */
+	uint32_t dLastConsumed;
+	/** (Micro)frame number of the last measurement, 125us units */
+	uint16_t wLastFrame;
+	/** Measurement period, 125us units */
+	uint16_t wPeriod;
+	/** Proportional gain (right shift) */
+	uint8_t bKpShift;
+	/** Integral gain (right shift) */
+	uint8_t bKiShift;
+	/** Encode the high-speed 16.16 format instead of the full-speed 10.14 */
+	uint8_t bHighSpeed;
+	/** A reference frame has been taken since the last reset */
+	uint8_t bStarted;
+	/** Number of controller updates since the last reset */
+	uint32_t dUpdates;
+} AUDDFeedback;
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern void audd_feedback_initialize(AUDDFeedback *fb, uint32_t sample_rate,
+		uint32_t target, uint8_t refresh);
+
+extern void audd_feedback_reset(AUDDFeedback *fb);
+
+extern void audd_feedback_consumed(AUDDFeedback *fb, uint32_t samples);
+
+extern void audd_feedback_update(AUDDFeedback *fb, uint32_t level);
+
+extern uint32_t audd_feedback_encode(const AUDDFeedback *fb, uint8_t *buffer);
+
+/**@}*/
+#endif /* _AUDD_FEEDBACK_H_ */
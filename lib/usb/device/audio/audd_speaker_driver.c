@@ -220,4 +220,28 @@ uint8_t audd_speaker_driver_read(void *buffer, uint32_t length,
 			buffer, length, callback, argument);
 }
 
+/**
+ * Sends a feedback value for the asynchronous audio stream to the USB host.
+ * The packet is sent on the next poll of the feedback endpoint, see
+ * audd_feedback_encode() for its format.
+ * \param buffer Pointer to the feedback packet.
+ * \param length Size of the feedback packet in bytes (3 or 4).
+ * \param callback Optional callback function.
+ * \param argument Optional argument to the callback function.
+ * \return USBD_STATUS_SUCCESS if the transfer is started successfully;
+ *         otherwise an error code.
+ */
+uint8_t audd_speaker_driver_write_feedback(const void *buffer, uint32_t length,
+		usbd_xfer_cb_t callback, void *argument)
+{
+	AUDDSpeakerDriver *p_audd = &audd_speaker_driver;
+	AUDDSpeakerPhone *p_audf  = &p_audd->fun;
+
+	if (p_audf->pSpeaker->bEndpointFeedback == 0)
+		return USBRC_STATE_ERR;
+
+	return usbd_write(p_audf->pSpeaker->bEndpointFeedback,
+			buffer, length, callback, argument);
+}
+
 /**@}*/
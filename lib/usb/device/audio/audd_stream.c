@@ -134,7 +134,12 @@ static uint32_t audd_speaker_phone_parse(USBGenericDescriptor *desc,
 		/* Find Streaming Interface & Endpoints */
 		if (desc->bDescriptorType == USBGenericDescriptor_ENDPOINT
 			&& (pEp->bmAttributes & 0x3) == USBEndpointDescriptor_ISOCHRONOUS) {
-			if (pEp->bEndpointAddress & 0x80 && p_mic) {
+			if ((pEp->bmAttributes & 0x30) == USBEndpointDescriptor_Feedback_ISOCHRONOUS) {
+				/* Feedback endpoint of the asynchronous speaker stream */
+				if (p_speaker)
+					p_speaker->bEndpointFeedback = pEp->bEndpointAddress & 0x7F;
+			}
+			else if (pEp->bEndpointAddress & 0x80 && p_mic) {
 				p_mic->bEndpointIn = pEp->bEndpointAddress & 0x7F;
 				p_mic->bAsInterface = p_arg->p_if_desc->bInterfaceNumber;
 				/* Fixed FU */
@@ -337,6 +342,7 @@ void audd_stream_initialize(AUDDStream *p_auds,
 	p_auds->bAsInterface    = 0xFF;
 	p_auds->bEndpointOut    = 0;
 	p_auds->bEndpointIn     = 0;
+	p_auds->bEndpointFeedback = 0;
 
 	p_auds->bNumChannels   = num_channels;
 	p_auds->bmMute         = 0;
@@ -506,6 +512,11 @@ uint32_t audd_stream_close(AUDDStream *stream)
 		bm_eps |= 1 << stream->bEndpointOut;
 	}
 
+	/* Close feedback endpoint */
+	if (stream->bEndpointFeedback) {
+		bm_eps |= 1 << stream->bEndpointFeedback;
+	}
+
 	usbd_hal_reset_endpoints(bm_eps, USBRC_CANCELED, 1);
 
 	return USBRC_SUCCESS;
@@ -536,6 +547,7 @@ void audd_speaker_phone_initializeStream(AUDDStream *p_auds,
 	p_auds->bAsInterface    = 0xFF;
 	p_auds->bEndpointOut    = 0;
 	p_auds->bEndpointIn     = 0;
+	p_auds->bEndpointFeedback = 0;
 
 	p_auds->bNumChannels   = numChannels;
 	p_auds->bmMute         = 0;
@@ -0,0 +1,347 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ * Implementation of the USB CDC serial port to USART bridge.
+ */
+
+/** \addtogroup usbd_cdc
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "queue.h"
+#include "trace.h"
+
+#include "usb/common/cdc/cdc_notifications.h"
+#include "usb/device/cdc/cdcd_serial.h"
+#include "usb/device/cdc/cdcd_serial_bridge.h"
+#include "usb/device/usbd.h"
+
+/*------------------------------------------------------------------------------
+ *         Internal functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Returns the size of the bulk endpoints for the current bus speed.
+ */
+static uint32_t _bridge_packet_size(void)
+{
+	return usbd_is_high_speed() ? 512 : 64;
+}
+
+/**
+ * Callback invoked from interrupt context each time a quarter of the USART
+ * ring is filled, and when the line is idle.
+ */
+static int _bridge_usart_rx_callback(void* arg, void* arg2)
+{
+	struct _cdcd_serial_bridge* bridge = (struct _cdcd_serial_bridge*)arg;
+	uint32_t count = (uint32_t)arg2;
+	uint32_t size = bridge->usart_to_usb.size;
+
+	/* Idle line: flush the data to the host */
+	if (bridge->usart->ring.idle)
+		bridge->priv.flush = true;
+
+	/* Flow control: stop the remote before the ring is full */
+	if (bridge->rts_flow_control && !bridge->priv.rts_off &&
+	    size - count < size / 4) {
+		usart_set_rts_enabled(bridge->usart->addr, false);
+		bridge->priv.rts_off = true;
+		bridge->priv.stats.rts_off++;
+	}
+
+	return 0;
+}
+
+/**
+ * Starts the USART DMA reception into the USART to USB ring.
+ */
+static void _bridge_start_usart_rx(struct _cdcd_serial_bridge* bridge)
+{
+	struct _callback cb;
+
+	callback_set(&cb, _bridge_usart_rx_callback, bridge);
+	bridge->priv.usart_rx_stopped =
+		usartd_start_rx_ring(bridge->usart_iface, &bridge->usart_to_usb,
+				0, &cb) != USARTD_SUCCESS;
+}
+
+/**
+ * Callback invoked when a USART DMA transmission is finished.
+ */
+static int _bridge_usart_tx_callback(void* arg, void* arg2)
+{
+	struct _cdcd_serial_bridge* bridge = (struct _cdcd_serial_bridge*)arg;
+	struct _spsc_queue* tx = &bridge->priv.tx;
+
+	spsc_queue_read_commit(tx, bridge->priv.usart_tx_len);
+	bridge->priv.stats.usart_tx += bridge->priv.usart_tx_len;
+	bridge->priv.usart_tx_busy = false;
+	return 0;
+}
+
+/**
+ * Callback invoked when a packet buffer is received from the host: copies
+ * it into the USB to USART ring.
+ */
+static void _bridge_usb_rx_callback(void* arg, uint8_t status,
+		uint32_t transferred, uint32_t remaining)
+{
+	struct _cdcd_serial_bridge* bridge = (struct _cdcd_serial_bridge*)arg;
+	struct _spsc_queue* tx = &bridge->priv.tx;
+
+	if (status == USBD_STATUS_SUCCESS) {
+		/* Room for the whole buffer was checked before the read */
+		spsc_queue_write(tx, bridge->usb_packet.data, transferred);
+		bridge->priv.stats.usb_rx += transferred;
+	}
+
+	bridge->priv.usb_rx_busy = false;
+}
+
+/**
+ * Callback invoked when a transfer to the host is finished.
+ */
+static void _bridge_usb_tx_callback(void* arg, uint8_t status,
+		uint32_t transferred, uint32_t remaining)
+{
+	struct _cdcd_serial_bridge* bridge = (struct _cdcd_serial_bridge*)arg;
+	uint32_t len = bridge->priv.usb_tx_len;
+
+	/* On error, the data is dropped: the host has gone. If the USART
+	 * overwrote the span while it was sent, the host got torn data, the
+	 * lost bytes are reported as overruns. */
+	if (usartd_rx_ring_consume(bridge->usart_iface, bridge->priv.usb_tx_tail,
+			len) != USARTD_SUCCESS)
+		bridge->priv.stats.torn++;
+	if (status == USBD_STATUS_SUCCESS) {
+		bridge->priv.stats.usb_tx += len;
+		if (len == 0)
+			bridge->priv.stats.usb_zlp++;
+	}
+
+	/* A transfer ending on a packet boundary does not terminate the host
+	 * read: a short packet or a ZLP must follow */
+	bridge->priv.zlp = (len > 0) && (len % _bridge_packet_size()) == 0;
+
+	bridge->priv.usb_tx_busy = false;
+}
+
+/**
+ * Starts a transfer to the host straight from the USART ring if there is
+ * enough data to aggregate, or if the line is idle.
+ */
+static void _bridge_process_usb_tx(struct _cdcd_serial_bridge* bridge)
+{
+	uint32_t packet_size = _bridge_packet_size();
+	uint32_t count, count_to_end, tail;
+	uint8_t* span;
+
+	if (bridge->priv.usb_tx_busy)
+		return;
+
+	count_to_end = usartd_rx_ring_peek(bridge->usart_iface, &span, &tail);
+	count = usartd_rx_ring_count(bridge->usart_iface);
+
+	if (count_to_end >= packet_size) {
+		/* Whole packets only, the stream goes on */
+		count_to_end -= count_to_end % packet_size;
+	} else if (count_to_end > 0 && (bridge->priv.flush || count > count_to_end)) {
+		/* Short packet: line is idle, or the ring wraps */
+	} else if (count == 0 && bridge->priv.flush && bridge->priv.zlp) {
+		/* Terminate the host read */
+		count_to_end = 0;
+	} else {
+		if (count == 0)
+			bridge->priv.flush = false;
+		return;
+	}
+
+	bridge->priv.usb_tx_len = count_to_end;
+	bridge->priv.usb_tx_tail = tail;
+	bridge->priv.usb_tx_busy = true;
+	if (cdcd_serial_write(span, count_to_end,
+			_bridge_usb_tx_callback, bridge) != USBD_STATUS_SUCCESS)
+		bridge->priv.usb_tx_busy = false;
+	else if (count_to_end == 0)
+		bridge->priv.flush = false;
+}
+
+/**
+ * Starts a reception from the host if the whole packet buffer fits in the
+ * USB to USART ring. Otherwise the host is NAKed until the USART drains the
+ * ring.
+ */
+static void _bridge_process_usb_rx(struct _cdcd_serial_bridge* bridge)
+{
+	struct _spsc_queue* tx = &bridge->priv.tx;
+	uint32_t packet_size = _bridge_packet_size();
+	uint32_t len;
+
+	if (bridge->priv.usb_rx_busy)
+		return;
+
+	len = bridge->usb_packet.size - bridge->usb_packet.size % packet_size;
+	if (len == 0 || spsc_queue_space(tx) < len)
+		return;
+
+	bridge->priv.usb_rx_busy = true;
+	if (cdcd_serial_read(bridge->usb_packet.data, len,
+			_bridge_usb_rx_callback, bridge) != USBD_STATUS_SUCCESS)
+		bridge->priv.usb_rx_busy = false;
+}
+
+/**
+ * Starts a USART DMA transmission from the USB to USART ring.
+ */
+static void _bridge_process_usart_tx(struct _cdcd_serial_bridge* bridge)
+{
+	struct _spsc_queue* tx = &bridge->priv.tx;
+	struct _buffer buf;
+	struct _callback cb;
+	uint32_t len;
+	void* span;
+
+	if (bridge->priv.usart_tx_busy)
+		return;
+
+	len = spsc_queue_read_span(tx, &span);
+	if (len == 0)
+		return;
+
+	bridge->priv.usart_tx_len = len;
+	bridge->priv.usart_tx_busy = true;
+	buf.data = span;
+	buf.size = len;
+	buf.attr = USARTD_BUF_ATTR_WRITE;
+	callback_set(&cb, _bridge_usart_tx_callback, bridge);
+	if (usartd_transfer(bridge->usart_iface, &buf, &cb) != USARTD_SUCCESS)
+		bridge->priv.usart_tx_busy = false;
+}
+
+/**
+ * Re-asserts RTS once the host has read enough data, and reports the bytes
+ * lost on a full ring or by the USART.
+ */
+static void _bridge_process_usart_rx(struct _cdcd_serial_bridge* bridge)
+{
+	struct _usartd_rx_stats rx_stats;
+	uint32_t size = bridge->usart_to_usb.size;
+	uint32_t overruns;
+
+	/* Restart a reception that could not be started at initialization */
+	if (bridge->priv.usart_rx_stopped) {
+		_bridge_start_usart_rx(bridge);
+		if (bridge->priv.usart_rx_stopped)
+			return;
+	}
+
+	if (bridge->priv.rts_off &&
+	    usartd_rx_ring_count(bridge->usart_iface) <= size / 2) {
+		usart_set_rts_enabled(bridge->usart->addr, true);
+		bridge->priv.rts_off = false;
+	}
+
+	usartd_rx_ring_get_stats(bridge->usart_iface, &rx_stats);
+	overruns = rx_stats.overruns + rx_stats.hw_overruns;
+	bridge->priv.stats.usart_rx = rx_stats.received;
+	bridge->priv.stats.overruns = overruns;
+
+	if (overruns != bridge->priv.reported_overruns) {
+		bridge->priv.reported_overruns = overruns;
+		cdcd_serial_set_serial_state(cdcd_serial_get_serial_state()
+				| CDCSerialState_OVERRUN);
+	}
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Initializes the bridge and starts the USART reception. The USART must be
+ * configured with usartd_configure() first, in DMA mode and with a receiver
+ * time-out to detect the end of the incoming frames.
+ * \param bridge  Pointer to the bridge, with public fields set.
+ */
+void cdcd_serial_bridge_initialize(struct _cdcd_serial_bridge* bridge)
+{
+	assert(IS_POWER_OF_TWO(bridge->usart_to_usb.size));
+	assert(IS_POWER_OF_TWO(bridge->usb_to_usart.size));
+
+	memset(&bridge->priv, 0, sizeof(bridge->priv));
+	spsc_queue_init(&bridge->priv.tx, bridge->usb_to_usart.data, 1,
+			bridge->usb_to_usart.size);
+
+	if (bridge->rts_flow_control)
+		usart_set_rts_enabled(bridge->usart->addr, true);
+
+	_bridge_start_usart_rx(bridge);
+}
+
+/**
+ * Moves the data through the bridge. To be called from the main loop, as
+ * often as possible.
+ * \param bridge  Pointer to the bridge.
+ */
+void cdcd_serial_bridge_process(struct _cdcd_serial_bridge* bridge)
+{
+	_bridge_process_usart_rx(bridge);
+	_bridge_process_usart_tx(bridge);
+
+	/* No USB transfer until the host opens the port */
+	if (usbd_get_state() < USBD_STATE_CONFIGURED ||
+	    !(cdcd_serial_get_control_line_state() & CDCControlLineState_DTR))
+		return;
+
+	_bridge_process_usb_rx(bridge);
+	_bridge_process_usb_tx(bridge);
+}
+
+/**
+ * Gets a copy of the bridge counters.
+ * \param bridge  Pointer to the bridge.
+ * \param stats   Pointer to the structure to fill.
+ */
+void cdcd_serial_bridge_get_stats(struct _cdcd_serial_bridge* bridge,
+		struct _cdcd_serial_bridge_stats* stats)
+{
+	memcpy(stats, &bridge->priv.stats, sizeof(*stats));
+}
+
+/**@}*/
@@ -0,0 +1,134 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * USB CDC serial port to USART bridge.
+ *
+ * Both directions go through a ring buffer:
+ * - USART to USB: the USART receives by circular DMA straight into the ring
+ *   (see usartd_start_rx_ring()), which is never stopped, and the data is
+ *   sent to the host from the ring without copy. Transfers are aggregated to
+ *   a multiple of the bulk endpoint size. A short packet, or a zero-length
+ *   packet, terminates the host read once the line is idle (USART receiver
+ *   time-out).
+ * - USB to USART: each packet buffer received from the host is copied into
+ *   the ring and sent on the USART by DMA. No new packet is accepted from the
+ *   host (NAK) until there is room for it in the ring.
+ *
+ * When enabled, RTS is de-asserted while the USART to USB ring is nearly
+ * full.
+ */
+
+#ifndef CDCD_SERIAL_BRIDGE_H
+#define CDCD_SERIAL_BRIDGE_H
+
+/** \addtogroup usbd_cdc
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "io.h"
+#include "queue.h"
+#include "serial/usartd.h"
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** Bridge counters */
+struct _cdcd_serial_bridge_stats {
+	uint32_t usart_rx;      /**< Bytes received on the USART */
+	uint32_t usart_tx;      /**< Bytes sent on the USART */
+	uint32_t usb_rx;        /**< Bytes received from the host */
+	uint32_t usb_tx;        /**< Bytes sent to the host */
+	uint32_t usb_zlp;       /**< Zero-length packets sent to the host */
+	uint32_t rts_off;       /**< Times RTS was de-asserted */
+	uint32_t overruns;      /**< Bytes received on the USART and dropped */
+	uint32_t torn;          /**< Transfers to the host overwritten by the
+	                             USART while being sent */
+};
+
+struct _cdcd_serial_bridge {
+	/** usartd interface, configured by the application */
+	uint8_t usart_iface;
+	/** usartd descriptor of the interface */
+	struct _usart_desc* usart;
+	/** De-assert RTS when the USART to USB ring is nearly full */
+	bool rts_flow_control;
+
+	/** Cache-aligned ring for the data received on the USART, the size
+	 * must be a power of two */
+	struct _buffer usart_to_usb;
+	/** Ring for the data received from the host, the size must be a power
+	 * of two */
+	struct _buffer usb_to_usart;
+	/** Cache-aligned buffer for the USB reception, the size must be a
+	 * multiple of the bulk endpoint size */
+	struct _buffer usb_packet;
+
+	/* Private fields */
+	struct {
+		struct _spsc_queue tx;
+		volatile bool usb_rx_busy;
+		volatile bool usb_tx_busy;
+		volatile bool usart_tx_busy;
+		volatile bool usart_rx_stopped;
+		volatile bool flush;
+		bool zlp;
+		bool rts_off;
+		uint32_t usb_tx_len;
+		uint32_t usb_tx_tail;
+		uint32_t usart_tx_len;
+		uint32_t reported_overruns;
+		struct _cdcd_serial_bridge_stats stats;
+	} priv;
+};
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern void cdcd_serial_bridge_initialize(struct _cdcd_serial_bridge* bridge);
+
+extern void cdcd_serial_bridge_process(struct _cdcd_serial_bridge* bridge);
+
+extern void cdcd_serial_bridge_get_stats(struct _cdcd_serial_bridge* bridge,
+		struct _cdcd_serial_bridge_stats* stats);
+
+/**@}*/
+
+#endif /* CDCD_SERIAL_BRIDGE_H */
@@ -70,6 +70,43 @@ void msd_io_fifo_init(MSDIOFifo *p_fifo,
 
 	p_fifo->fullCnt = 0;
 	p_fifo->nullCnt = 0;
+	p_fifo->paused = 0;
+
+#ifdef MSDIO_READ_AHEAD
+	p_fifo->nextLba = 0;
+	p_fifo->aheadLba = 0;
+	p_fifo->aheadSize = 0;
+	p_fifo->aheadState = MSDIO_IDLE;
+	p_fifo->aheadStatus = 0;
+	p_fifo->aheadHitCnt = 0;
+#endif
+}
+
+/**
+ * \brief  Computes the chunk size for a transfer, so that the FIFO buffer is
+ *         split in MSDIO_BUFFER_COUNT chunks and USB and media transfers can
+ *         overlap.
+ * \param  p_fifo         Pointer to the MSDIOFifo instance, with blockSize set
+ * \param  max_chunk_size Maximum size of a chunk in bytes
+ * \return Chunk size in bytes, a multiple of the block size
+ */
+unsigned int msd_io_fifo_get_chunk_size(MSDIOFifo *p_fifo,
+					unsigned int max_chunk_size)
+{
+	unsigned int chunk_size = p_fifo->bufferSize / MSDIO_BUFFER_COUNT;
+
+	if (chunk_size > max_chunk_size)
+		chunk_size = max_chunk_size;
+
+	/* Whole blocks, and whole chunks in the buffer for index wrapping */
+	chunk_size -= chunk_size % p_fifo->blockSize;
+	while (chunk_size > p_fifo->blockSize &&
+			(p_fifo->bufferSize % chunk_size) != 0)
+		chunk_size -= p_fifo->blockSize;
+	if (chunk_size < p_fifo->blockSize)
+		chunk_size = p_fifo->blockSize;
+
+	return chunk_size;
 }
 
 /**@}*/
@@ -70,6 +70,18 @@
 #define MSDIO_WRITE10_CHUNK_SIZE    (128 * 512)
 #endif
 
+/** Number of chunks the FIFO buffer is split into. While the USB transfers
+ * one chunk, the media access of the next chunk can proceed. */
+#ifndef MSDIO_BUFFER_COUNT
+#define MSDIO_BUFFER_COUNT          4
+#endif
+
+/** Speculatively read the LBA range following sequential READ10 commands
+ * into the FIFO while the CSW is sent and the next CBW is awaited. */
+#if defined(MSDIO_READ10_CHUNK_SIZE) && !defined(MSDIO_NO_READ_AHEAD)
+#define MSDIO_READ_AHEAD
+#endif
+
 /*------------------------------------------------------------------------------
  *         Types
  *------------------------------------------------------------------------------*/
@@ -113,6 +125,27 @@ typedef struct _MSDIOFifo {
 	unsigned short  nullCnt;
 	/** Times when fifo can not load more input data */
 	unsigned short  fullCnt;
+	/** Tick when the input or output was paused waiting for the other */
+	unsigned int    pauseTick;
+	/** The input or output is paused waiting for the other */
+	unsigned char   paused;
+
+#ifdef MSDIO_READ_AHEAD
+	/*- Read-ahead */
+
+	/** LBA following the last READ10, to detect sequential streams */
+	unsigned int    nextLba;
+	/** First LBA of the data read ahead at the start of the buffer */
+	unsigned int    aheadLba;
+	/** Size of the data read ahead, in bytes */
+	unsigned int    aheadSize;
+	/** State of the read-ahead (IDLE, START, WAIT or DONE) */
+	volatile unsigned char aheadState;
+	/** Result code of the read-ahead media operation */
+	unsigned char   aheadStatus;
+	/** Times when a READ10 was served from read-ahead data */
+	unsigned short  aheadHitCnt;
+#endif
 } MSDIOFifo, *PMSDIOFifo;
 
 /*------------------------------------------------------------------------------
@@ -138,6 +171,9 @@ typedef struct _MSDIOFifo {
 extern void msd_io_fifo_init(MSDIOFifo *pFifo,
 						   void * pBuffer, unsigned int bufferSize);
 
+extern unsigned int msd_io_fifo_get_chunk_size(MSDIOFifo *pFifo,
+						   unsigned int maxChunkSize);
+
 /**@}*/
 
 #endif /* _MSDIOFIFO_H */
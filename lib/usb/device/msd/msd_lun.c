@@ -150,6 +150,8 @@ void lun_init(MSDLun    *lun,
 	data_buffer += ROUND_UP_MULT(sizeof(SBCReadCapacity10Data), L1_CACHE_BYTES);
 	lun->inquiryData = (SBCInquiryData*)data_buffer;
 	data_buffer += ROUND_UP_MULT(sizeof(SBCInquiryData), L1_CACHE_BYTES);
+	lun->statisticsData = (MSDLunStatistics*)data_buffer;
+	data_buffer += ROUND_UP_MULT(sizeof(MSDLunStatistics), L1_CACHE_BYTES);
 	/* overflow check */
 	assert(lun->dataBuffer + sizeof(lun->dataBuffer) >= data_buffer);
 
@@ -183,6 +185,8 @@ void lun_init(MSDLun    *lun,
 	STORE_DWORDB(0, lun->readCapacityData->pLogicalBlockAddress);
 	STORE_DWORDB(0, lun->readCapacityData->pLogicalBlockLength);
 
+	lun_reset_statistics(lun);
+
 	/* Initialize LUN */
 
 	lun->media = media;
@@ -412,4 +416,60 @@ uint32_t lun_read(MSDLun        *lun,
 	return status;
 }
 
+/**
+ * \brief  Get a snapshot of the statistics of a LUN
+ * \param  lun          Pointer to the MSDLun instance
+ * \param  statistics   Pointer to the structure to fill
+ */
+void lun_get_statistics(MSDLun *lun, MSDLunStatistics *statistics)
+{
+	memcpy(statistics, &lun->statistics, sizeof(MSDLunStatistics));
+}
+
+/**
+ * \brief  Clear the statistics of a LUN
+ * \param  lun          Pointer to the MSDLun instance
+ */
+void lun_reset_statistics(MSDLun *lun)
+{
+	memset(&lun->statistics, 0, sizeof(MSDLunStatistics));
+	lun->statistics.bVersion = MSD_LUN_STATISTICS_VERSION;
+	lun->statistics.bLatencyBins = MSD_LUN_LATENCY_BINS;
+	lun->statistics.wLength = sizeof(MSDLunStatistics);
+}
+
+/**
+ * \brief  Account a completed command in the statistics of a LUN
+ * \param  lun            Pointer to the MSDLun instance
+ * \param  operation_code SCSI operation code of the command
+ * \param  length         Number of bytes transferred in the data phase
+ * \param  failed         The command is completed with a failed status
+ * \param  time           Time spent processing the command, in ms
+ */
+void lun_update_statistics(MSDLun *lun, uint8_t operation_code,
+			   uint32_t length, bool failed, uint32_t time)
+{
+	MSDLunStatistics *stats = &lun->statistics;
+	uint32_t bin = 0;
+
+	stats->dCommands++;
+	if (failed)
+		stats->dFailedCommands++;
+
+	while (bin < MSD_LUN_LATENCY_BINS - 1 && (time >> bin) != 0)
+		bin++;
+
+	if (operation_code == SBC_READ_10) {
+		stats->dReadCommands++;
+		stats->qReadBytes += length;
+		stats->dReadTime += time;
+		stats->pReadLatency[bin]++;
+	} else if (operation_code == SBC_WRITE_10) {
+		stats->dWriteCommands++;
+		stats->qWriteBytes += length;
+		stats->dWriteTime += time;
+		stats->pWriteLatency[bin]++;
+	}
+}
+
 /**@}*/
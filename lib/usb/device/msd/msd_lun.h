@@ -53,6 +53,7 @@
  *         Headers
  *------------------------------------------------------------------------------*/
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "chip.h"
@@ -81,10 +82,19 @@
 /** Media of LUN is ready */
 #define LUN_READY                   0x11
 
+/** Version of the MSDLunStatistics layout */
+#define MSD_LUN_STATISTICS_VERSION  1
+
+/** Number of bins of the READ10/WRITE10 latency histograms. Bin 0 counts the
+ * commands completed in less than 1ms, bin n the commands completed in
+ * 2^(n-1) to 2^n - 1 ms, and the last bin all the slower commands. */
+#define MSD_LUN_LATENCY_BINS        12
+
 #define MSD_LUN_DATA_BUFFER_SIZE (L1_CACHE_BYTES +\
 	ROUND_UP_MULT(sizeof(SBCRequestSenseData), L1_CACHE_BYTES) +\
 	ROUND_UP_MULT(sizeof(SBCReadCapacity10Data), L1_CACHE_BYTES) +\
-	ROUND_UP_MULT(sizeof(SBCInquiryData), L1_CACHE_BYTES))
+	ROUND_UP_MULT(sizeof(SBCInquiryData), L1_CACHE_BYTES) +\
+	ROUND_UP_MULT(sizeof(MSDLunStatistics), L1_CACHE_BYTES))
 
 /*------------------------------------------------------------------------------
  *      Types
@@ -106,6 +116,49 @@ typedef void(*MSDLunDataMonitorFunction)(uint8_t  flowDirection,
  *      Structures
  *------------------------------------------------------------------------------*/
 
+/** \brief LUN statistics, also sent as is (little-endian) to the host in
+ * response to the SBC_VENDOR_GET_STATISTICS command. Times are in ms. */
+typedef PACKED_STRUCT _MSDLunStatistics {
+	/** Layout version, MSD_LUN_STATISTICS_VERSION */
+	uint8_t  bVersion;
+	/** Number of bins of the latency histograms */
+	uint8_t  bLatencyBins;
+	/** Size of the structure in bytes */
+	uint16_t wLength;
+	/** Number of commands processed */
+	uint32_t dCommands;
+	/** Number of commands completed with a failed CSW status */
+	uint32_t dFailedCommands;
+	/** Number of READ10 commands */
+	uint32_t dReadCommands;
+	/** Number of WRITE10 commands */
+	uint32_t dWriteCommands;
+	/** Number of bytes sent to the host by READ10 commands */
+	uint64_t qReadBytes;
+	/** Number of bytes received from the host by WRITE10 commands */
+	uint64_t qWriteBytes;
+	/** Total time spent processing READ10 commands */
+	uint32_t dReadTime;
+	/** Total time spent processing WRITE10 commands */
+	uint32_t dWriteTime;
+	/** Latency histogram of READ10 commands */
+	uint32_t pReadLatency[MSD_LUN_LATENCY_BINS];
+	/** Latency histogram of WRITE10 commands */
+	uint32_t pWriteLatency[MSD_LUN_LATENCY_BINS];
+	/** Times the USB waited for the media (FIFO empty) */
+	uint32_t dFifoNullCount;
+	/** Times the media waited for the USB (FIFO full) */
+	uint32_t dFifoFullCount;
+	/** Total time one side of the FIFO was paused waiting for the other */
+	uint32_t dPauseTime;
+	/** Number of times a bulk endpoint was stalled */
+	uint32_t dStallCount;
+	/** Total time waiting for the host to clear the stalls */
+	uint32_t dStallTime;
+	/** Number of READ10 commands started with read-ahead data */
+	uint32_t dReadAheadHits;
+} MSDLunStatistics;
+
 /** \brief LUN structure */
 typedef struct {
 	/** Fifo for USB transfer, must be assigned. */
@@ -141,6 +194,10 @@ typedef struct {
 	SBCReadCapacity10Data *readCapacityData;
 	/** Pointer to a SBCInquiryData instance. */
 	SBCInquiryData        *inquiryData;
+	/** Pointer to the statistics snapshot sent to the host. */
+	MSDLunStatistics      *statisticsData;
+	/** Statistics of the LUN. */
+	MSDLunStatistics      statistics;
 } MSDLun;
 
 /*------------------------------------------------------------------------------
@@ -181,6 +238,13 @@ extern uint32_t lun_read(MSDLun             *lun,
 					  usbd_xfer_cb_t   callback,
 					  void               *argument);
 
+extern void lun_get_statistics(MSDLun *lun, MSDLunStatistics *statistics);
+
+extern void lun_reset_statistics(MSDLun *lun);
+
+extern void lun_update_statistics(MSDLun *lun, uint8_t operation_code,
+					  uint32_t length, bool failed, uint32_t time);
+
 /**@}*/
 
 #endif /*#ifndef MSDLUN_H */
@@ -37,6 +37,7 @@
  *-----------------------------------------------------------------------------*/
 
 #include "trace.h"
+#include "timer.h"
 
 #include "usb/device/msd/sbc_methods.h"
 #include "usb/device/msd/msdd_state_machine.h"
@@ -359,6 +360,14 @@ static unsigned char msdd_process_command(MSDDriver * driver)
 			}
 		}
 
+		/* Account the command for the LUN */
+		if (cbw->bCBWLUN <= driver->maxLun) {
+			lun_update_statistics(lun, cbw->pCommand[0],
+				cbw->dCBWDataTransferLength - csw->dCSWDataResidue,
+				csw->bCSWStatus != MSD_CSW_COMMAND_PASSED,
+				(uint32_t)timer_get_tick() - command_state->startTick);
+		}
+
 		/* Reset command state */
 		command_state->state = 0;
 	}
@@ -366,6 +375,48 @@ static unsigned char msdd_process_command(MSDDriver * driver)
 	return command_complete;
 }
 
+/**
+ * Starts the pending read-ahead of all the LUNs, while the driver waits for
+ * the host.
+ * \param  driver Pointer to a MSDDriver instance
+ * \return true if a read-ahead is in progress on any LUN
+ */
+static bool msdd_read_ahead(MSDDriver *driver)
+{
+	bool busy = false;
+	uint8_t i;
+
+	for (i = 0; i <= driver->maxLun; i++) {
+		if (sbc_read_ahead(&driver->luns[i]))
+			busy = true;
+	}
+
+	return busy;
+}
+
+/**
+ * Prepares the LUN FIFOs for a new command: LUNs may share the same buffer,
+ * so the read-ahead in progress are waited for and the data read ahead for
+ * LUNs other than the one addressed by the command are dropped.
+ * \param  driver Pointer to a MSDDriver instance
+ * \return true if the command can be processed
+ */
+static bool msdd_prepare_fifos(MSDDriver *driver)
+{
+	uint8_t lun = driver->commandState.cbw.bCBWLUN;
+	uint8_t i;
+
+	if (msdd_read_ahead(driver))
+		return false;
+
+	for (i = 0; i <= driver->maxLun; i++) {
+		if (i != lun)
+			sbc_cancel_read_ahead(&driver->luns[i]);
+	}
+
+	return true;
+}
+
 /**
  * State machine for the MSD %device driver
  * \param  driver Pointer to a MSDDriver instance
@@ -390,6 +441,7 @@ void msdd_state_machine(MSDDriver * driver)
 		
 		if (!usbd_get_data_size(command_state->pipeOUT)) {
 			LIBUSB_TRACE("<NoData!>");
+			msdd_read_ahead(driver);
 			break;
 		}
 		/* Start the CBW read operation */
@@ -431,8 +483,13 @@ void msdd_state_machine(MSDDriver * driver)
 
 		/* Check if this is a new command */
 		if (command_state->state == 0) {
+			/* Wait for the FIFO buffers to be released */
+			if (!msdd_prepare_fifos(driver))
+				break;
+
 			/* Copy the CBW tag */
 			csw->dCSWTag = cbw->dCBWTag;
+			command_state->startTick = (uint32_t)timer_get_tick();
 
 			/* Check that the CBW is 31 bytes long and check CBW Signature */
 			if ((transfer->transferred != MSD_CBW_SIZE) ||
@@ -467,6 +524,7 @@ void msdd_state_machine(MSDDriver * driver)
 		/* Post-process command if it is finished */
 		if (msdd_postprocess_command(driver)) {
 			LIBUSB_TRACE("WaitHALT ");
+			command_state->haltTick = (uint32_t)timer_get_tick();
 			driver->state = MSDD_STATE_WAIT_HALT;
 		} else {
 			driver->state = MSDD_STATE_SEND_CSW;
@@ -493,6 +551,9 @@ void msdd_state_machine(MSDDriver * driver)
 	case MSDD_STATE_WAIT_CSW:
 		//LIBUSB_TRACE("<WaitCSW>");
 
+		/* Use the bus turnaround to read ahead */
+		msdd_read_ahead(driver);
+
 		/* Check transfer semaphore */
 		if (transfer->semaphore > 0) {
 			/* Take semaphore and terminate transfer */
@@ -516,6 +577,12 @@ void msdd_state_machine(MSDDriver * driver)
 		//LIBUSB_TRACE("<WaitHalt>");
 
 		if (!usbd_is_halted(command_state->pipeIN)) {
+			if (cbw->bCBWLUN <= driver->maxLun) {
+				MSDLun *lun = &driver->luns[cbw->bCBWLUN];
+				lun->statistics.dStallCount++;
+				lun->statistics.dStallTime += (uint32_t)timer_get_tick()
+					- command_state->haltTick;
+			}
 			driver->state = MSDD_STATE_SEND_CSW;
 		}
 		break;
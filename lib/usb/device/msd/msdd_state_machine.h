@@ -194,6 +194,8 @@ typedef struct _MSDCommandState {
 	uint8_t         postprocess; /**< Actions to perform when command is complete */
 	uint8_t         pipeIN;      /**< Pipe ID for input */
 	uint8_t         pipeOUT;     /**< Pipe ID for output */
+	uint32_t        startTick;   /**< Tick when the command was received */
+	uint32_t        haltTick;    /**< Tick when a pipe was halted */
 } MSDCommandState;
 
 /**
@@ -82,6 +82,9 @@
  * - SBC_MODE_SENSE_6
  * - SBC_VERIFY_10
  * - SBC_READ_FORMAT_CAPACITIES
+ *
+ * \section Vendor Specific Codes
+ * - SBC_VENDOR_GET_STATISTICS
  */
 
 /** Request information regarding parameters of the target and Logical Unit. */
@@ -106,6 +109,9 @@
 #define SBC_VERIFY_10                                   0x2F
 /** Request a list of the possible capacities that can be formatted on medium */
 #define SBC_READ_FORMAT_CAPACITIES                      0x23
+
+/** Vendor specific: request the statistics of the LUN (MSDLunStatistics) */
+#define SBC_VENDOR_GET_STATISTICS                       0xC0
 /**      @}*/
 
 /** \addtogroup usbd_sbc_periph_quali SBC Periph. Qualifiers
@@ -576,6 +582,21 @@ typedef PACKED_STRUCT _SBCModeSense6 {
 
 } SBCModeSense6;
 
+/**
+ * \typedef SBCVendorGetStatistics
+ * \brief  Structure for the vendor specific GET STATISTICS command
+ */
+typedef PACKED_STRUCT _SBCVendorGetStatistics {
+
+	uint8_t bOperationCode;        /*!< 0xC0 : SBC_VENDOR_GET_STATISTICS */
+	uint8_t isReset:1,             /*!< Clear statistics once returned */
+				  bReserved1:7;          /*!< Reserved bits */
+	uint8_t pReserved2[5];         /*!< Reserved bytes */
+	uint8_t pAllocationLength[2];  /*!< Host buffer allocated size */
+	uint8_t bControl;              /*!< 0x00 */
+
+} SBCVendorGetStatistics;
+
 /**
  * \typedef SBCModeParameterHeader6
  * \brief  Header for the data returned after a MODE SENSE (6) command
@@ -658,6 +679,7 @@ typedef PACKED_STRUCT _SBCReadWriteErrorRecovery {
  * \see    SBCWrite10
  * \see    SBCMediumRemoval
  * \see    SBCModeSense6
+ * \see    SBCVendorGetStatistics
  */
 typedef PACKED_UNION _SBCCommand {
 
@@ -670,6 +692,7 @@ typedef PACKED_UNION _SBCCommand {
 	SBCWrite10        write10;        /*!< WRITE (10) command */
 	SBCMediumRemoval  mediumRemoval;  /*!< PREVENT/ALLOW MEDIUM REMOVAL command */
 	SBCModeSense6     modeSense6;     /*!< MODE SENSE (6) command */
+	SBCVendorGetStatistics getStatistics; /*!< GET STATISTICS command */
 
 } SBCCommand;
 
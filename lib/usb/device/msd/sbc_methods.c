@@ -38,6 +38,7 @@
 
 #include "trace.h"
 #include "intmath.h"
+#include "timer.h"
 
 #include "libstoragemedia/media.h"
 
@@ -139,6 +140,108 @@ static bool sbc_lun_can_be_written(MSDLun *lun)
 	return canbe_written;
 }
 
+/**
+ * \brief  Records that the input or output of the FIFO waits for the other.
+ * \param  fifo         Pointer to the FIFO of the LUN
+ */
+static void sbc_fifo_pause(MSDIOFifo *fifo)
+{
+	fifo->pauseTick = (uint32_t)timer_get_tick();
+	fifo->paused = 1;
+}
+
+/**
+ * \brief  Accounts the time the FIFO was paused, if it was.
+ * \param  lun          Pointer to the LUN of the FIFO
+ */
+static void sbc_fifo_resume(MSDLun *lun)
+{
+	MSDIOFifo *fifo = &lun->ioFifo;
+
+	if (fifo->paused) {
+		lun->statistics.dPauseTime +=
+			(uint32_t)timer_get_tick() - fifo->pauseTick;
+		fifo->paused = 0;
+	}
+}
+
+/**
+ * \brief  Accounts the FIFO counters of a finished READ10 or WRITE10 command.
+ * \param  lun          Pointer to the LUN affected by the command
+ */
+static void sbc_fifo_done(MSDLun *lun)
+{
+	MSDIOFifo *fifo = &lun->ioFifo;
+
+	sbc_fifo_resume(lun);
+	lun->statistics.dFifoNullCount += fifo->nullCnt;
+	lun->statistics.dFifoFullCount += fifo->fullCnt;
+}
+
+#ifdef MSDIO_READ_AHEAD
+/**
+ * Callback invoked when the read-ahead media operation is finished.
+ * \param  arg         Pointer to the MSDIOFifo the data was read into
+ * \param  status      Operation result code
+ * \param  transferred Number of bytes transferred by the command
+ * \param  remaining   Number of bytes not transferred
+ */
+static void sbc_read_ahead_callback(void *arg, uint8_t status,
+		uint32_t transferred, uint32_t remaining)
+{
+	MSDIOFifo *fifo = (MSDIOFifo*)arg;
+
+	fifo->aheadStatus = status;
+	fifo->aheadState = MSDIO_DONE;
+}
+
+/**
+ * \brief  Serves the beginning of a READ10 command from the data read ahead,
+ *         and arms the read-ahead of the following range if the command
+ *         continues a sequential stream.
+ * \param  lun          Pointer to the LUN affected by the command
+ * \param  command_state Current state of the command, FIFO initialized
+ */
+static void sbc_read10_use_read_ahead(MSDLun *lun,
+		MSDCommandState *command_state)
+{
+	SBCRead10 *command = (SBCRead10*)command_state->cbw.pCommand;
+	MSDIOFifo *fifo = &lun->ioFifo;
+	uint32_t lba = DWORDB(command->pLogicalBlockAddress);
+	bool sequential = (lba == fifo->nextLba);
+
+	fifo->nextLba = lba + fifo->dataTotal / fifo->blockSize;
+
+	if (fifo->aheadState == MSDIO_DONE &&
+			fifo->aheadStatus == USBD_STATUS_SUCCESS &&
+			fifo->aheadLba == lba &&
+			(fifo->aheadSize == fifo->chunkSize ||
+			 fifo->aheadSize >= fifo->dataTotal)) {
+		/* The first chunk is already at the start of the buffer */
+		fifo->inputTotal = min_u32(fifo->aheadSize, fifo->dataTotal);
+		MSDIOFifo_IncNdx(fifo->inputNdx, fifo->inputTotal,
+				fifo->bufferSize);
+		lba += fifo->inputTotal / fifo->blockSize;
+		STORE_DWORDB(lba, command->pLogicalBlockAddress);
+		if (fifo->inputTotal < fifo->dataTotal)
+			fifo->inputState = MSDIO_START;
+		else
+			fifo->inputState = MSDIO_IDLE;
+		fifo->aheadHitCnt++;
+		lun->statistics.dReadAheadHits++;
+		LIBUSB_TRACE("dAhead ");
+	}
+
+	/* Read the range following a sequential command once it is done */
+	if (sequential) {
+		fifo->aheadLba = fifo->nextLba;
+		fifo->aheadState = MSDIO_START;
+	} else {
+		fifo->aheadState = MSDIO_IDLE;
+	}
+}
+#endif
+
 /**
  * \brief  Performs a WRITE (10) command on the specified LUN.
  *
@@ -177,11 +280,16 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 			fifo->blockSize = lun->blockSize *
 				media_get_block_size(lun->media);
 #ifdef MSDIO_WRITE10_CHUNK_SIZE
-			fifo->chunkSize = max_u32(fifo->blockSize,
+			fifo->chunkSize = msd_io_fifo_get_chunk_size(fifo,
 						  MSDIO_WRITE10_CHUNK_SIZE);
+#endif
+#ifdef MSDIO_READ_AHEAD
+			/* Data read ahead is overwritten and may become stale */
+			fifo->aheadState = MSDIO_IDLE;
 #endif
 			fifo->fullCnt = 0;
 			fifo->nullCnt = 0;
+			fifo->paused = 0;
 
 			/* Initialize FIFO output (Disk) */
 			fifo->outputNdx = 0;
@@ -199,6 +307,7 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 
 	if (command_state->length == 0) {
 		/* Perform the callback! */
+		sbc_fifo_done(lun);
 		if (lun->dataMonitor) {
 			lun->dataMonitor(0, fifo->dataTotal, fifo->nullCnt, fifo->fullCnt);
 		}
@@ -216,6 +325,7 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 	case MSDIO_IDLE:
 		if (fifo->inputTotal < fifo->dataTotal &&
 				fifo->inputTotal - fifo->outputTotal < fifo->bufferSize) {
+			sbc_fifo_resume(lun);
 			fifo->inputState = MSDIO_START;
 		}
 		break;
@@ -320,6 +430,7 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 				else if (fifo->inputNdx == fifo->outputNdx) {
 					fifo->inputState = MSDIO_IDLE;
 					fifo->fullCnt++;
+					sbc_fifo_pause(fifo);
 					LIBUSB_TRACE("ufFull%d ", fifo->inputNdx);
 				}
 				/* - More data to transfer? */
@@ -347,6 +458,7 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 	switch(fifo->outputState) {
 	case MSDIO_IDLE:
 		if (fifo->outputTotal < fifo->inputTotal) {
+			sbc_fifo_resume(lun);
 			fifo->outputState = MSDIO_START;
 		}
 		break;
@@ -447,6 +559,7 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 				else {
 					fifo->outputState = MSDIO_IDLE;
 					fifo->nullCnt ++;
+					sbc_fifo_pause(fifo);
 					LIBUSB_TRACE("dfNull%d ", fifo->outputNdx);
 				}
 			}
@@ -497,11 +610,12 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 			fifo->blockSize = lun->blockSize *
 				media_get_block_size(lun->media);
 #ifdef MSDIO_READ10_CHUNK_SIZE
-			fifo->chunkSize = max_u32(fifo->blockSize,
+			fifo->chunkSize = msd_io_fifo_get_chunk_size(fifo,
 						  MSDIO_READ10_CHUNK_SIZE);
 #endif
 			fifo->fullCnt = 0;
 			fifo->nullCnt = 0;
+			fifo->paused = 0;
 
 #ifdef MSDIO_FIFO_OFFSET
 			/* Enable offset if total size >= 2*bufferSize */
@@ -522,12 +636,18 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 			fifo->inputTotal = 0;
 			fifo->inputState = MSDIO_START;
 			disktransfer->semaphore = 0;
+
+#ifdef MSDIO_READ_AHEAD
+			if (!media_is_mapped_read_supported(lun->media))
+				sbc_read10_use_read_ahead(lun, command_state);
+#endif
 		}
 	}
 
 	/* Check length */
 	if (command_state->length == 0) {
 		/* Perform the callback! */
+		sbc_fifo_done(lun);
 		if (lun->dataMonitor) {
 			lun->dataMonitor(1, fifo->dataTotal, fifo->nullCnt, fifo->fullCnt);
 		}
@@ -545,6 +665,7 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 	case MSDIO_IDLE:
 		if (fifo->inputTotal < fifo->dataTotal &&
 				fifo->inputTotal - fifo->outputTotal < fifo->bufferSize) {
+			sbc_fifo_resume(lun);
 			fifo->inputState = MSDIO_START;
 		}
 		break;
@@ -646,6 +767,7 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 					LIBUSB_TRACE("dfFull%d ", (int)fifo->inputNdx);
 					fifo->inputState = MSDIO_IDLE;
 					fifo->fullCnt ++;
+					sbc_fifo_pause(fifo);
 				}
 				/* - More data to transfer? */
 				else if (fifo->inputTotal < fifo->dataTotal) {
@@ -680,6 +802,7 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 				fifo->bufferOffset = 0;
 			}
 #endif
+			sbc_fifo_resume(lun);
 			fifo->outputState = MSDIO_START;
 		}
 		break;
@@ -770,6 +893,7 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 					LIBUSB_TRACE("ufNull%d ", (int)fifo->outputNdx);
 					fifo->outputState = MSDIO_IDLE;
 					fifo->nullCnt ++;
+					sbc_fifo_pause(fifo);
 				}
 				/* - Send next? */
 				else if (fifo->outputTotal < fifo->inputTotal) {
@@ -1120,6 +1244,83 @@ static uint8_t sbc_test_unit_ready(MSDLun *lun)
 	return result;
 }
 
+/**
+ * \brief  Performs a vendor specific GET STATISTICS command: sends the
+ *         MSDLunStatistics of the LUN, and optionally clears them.
+ *
+ *         This function operates asynchronously and must be called multiple
+ *         times to complete. A result code of MSDD_STATUS_INCOMPLETE
+ *         indicates that at least another call of the method is necessary.
+ * \param  lun          Pointer to the LUN affected by the command
+ * \param  command_state Current state of the command
+ * \return Operation result code (SUCCESS, ERROR, INCOMPLETE or PARAMETER)
+ * \see    MSDLun
+ * \see    MSDCommandState
+ */
+static uint8_t sbc_vendor_get_statistics(MSDLun *lun,
+		MSDCommandState *command_state)
+{
+	uint8_t result = MSDD_STATUS_INCOMPLETE;
+	uint8_t status;
+	SBCCommand *command = (SBCCommand*)command_state->cbw.pCommand;
+	MSDTransfer *transfer = &(command_state->transfer);
+
+	/* Check if required length is 0 */
+	if (command_state->length == 0) {
+		/* Nothing to do */
+		result = MSDD_STATUS_SUCCESS;
+	}
+	/* Initialize command state if needed */
+	else if (command_state->state == 0) {
+		command_state->state = SBC_STATE_WRITE;
+
+		/* Take a snapshot, statistics keep on changing while sent */
+		lun_get_statistics(lun, lun->statisticsData);
+		if (command->getStatistics.isReset)
+			lun_reset_statistics(lun);
+	}
+
+	switch (command_state->state) {
+	case SBC_STATE_WRITE:
+		/* Start write operation */
+		status = usbd_write(command_state->pipeIN,
+				lun->statisticsData, command_state->length,
+				msd_driver_callback, transfer);
+
+		/* Check operation result code */
+		if (status != USBD_STATUS_SUCCESS) {
+			trace_warning("SBC_GetStatistics: Cannot start sending data\n\r");
+			result = MSDD_STATUS_ERROR;
+		} else {
+			/* Proceed to next state */
+			LIBUSB_TRACE("Sending ");
+			command_state->state = SBC_STATE_WAIT_WRITE;
+		}
+		break;
+
+	case SBC_STATE_WAIT_WRITE:
+		/* Check the semaphore value */
+		if (transfer->semaphore > 0) {
+			/* Take semaphore and terminate command */
+			transfer->semaphore--;
+
+			if (transfer->status != USBD_STATUS_SUCCESS) {
+				trace_warning("SBC_GetStatistics: Data transfer failed\n\r");
+				result = MSDD_STATUS_ERROR;
+			} else {
+				LIBUSB_TRACE("Sent ");
+				result = MSDD_STATUS_SUCCESS;
+			}
+
+			/* Update length field */
+			command_state->length -= transfer->transferred;
+		}
+		break;
+	}
+
+	return result;
+}
+
 /*------------------------------------------------------------------------------
  *      Exported functions
  *------------------------------------------------------------------------------*/
@@ -1204,6 +1405,12 @@ bool sbc_get_command_information(void *command_ptr, uint32_t *length,
 		(*type) = MSDD_NO_TRANSFER;
 		break;
 
+	case SBC_VENDOR_GET_STATISTICS:
+		(*type) = MSDD_DEVICE_TO_HOST;
+		(*length) = min_u32(WORDB(command->getStatistics.pAllocationLength),
+				sizeof(MSDLunStatistics));
+		break;
+
 	default:
 		LIBUSB_TRACE("sbc_get_command_information: unknown command 0x%x\r\n",
 				(unsigned)command->bOperationCode);
@@ -1218,6 +1425,62 @@ bool sbc_get_command_information(void *command_ptr, uint32_t *length,
 	return command_supported;
 }
 
+/**
+ * \brief  Starts the read-ahead armed by the last sequential READ10 command,
+ *         if any. Must only be called between commands, when the FIFO buffer
+ *         of the LUN is not in use.
+ * \param  lun          Pointer to the affected LUN
+ * \return true if a read-ahead is in progress in the FIFO buffer
+ */
+bool sbc_read_ahead(MSDLun *lun)
+{
+#ifdef MSDIO_READ_AHEAD
+	MSDIOFifo *fifo = &lun->ioFifo;
+	uint32_t lun_blocks, blocks;
+
+	if (fifo->aheadState == MSDIO_START) {
+		fifo->aheadState = MSDIO_IDLE;
+		if (!lun->media || media_is_mapped_read_supported(lun->media))
+			return false;
+
+		lun_blocks = lun->size / lun->blockSize;
+		if (fifo->aheadLba >= lun_blocks)
+			return false;
+
+		fifo->aheadSize = msd_io_fifo_get_chunk_size(fifo,
+					MSDIO_READ10_CHUNK_SIZE);
+		blocks = min_u32(fifo->aheadSize / fifo->blockSize,
+				 lun_blocks - fifo->aheadLba);
+		fifo->aheadSize = blocks * fifo->blockSize;
+
+		fifo->aheadState = MSDIO_WAIT;
+		if (lun_read(lun, fifo->aheadLba, fifo->pBuffer, blocks,
+				sbc_read_ahead_callback, fifo) != USBD_STATUS_SUCCESS)
+			fifo->aheadState = MSDIO_IDLE;
+		else
+			LIBUSB_TRACE("dRdAhead ");
+	}
+
+	return fifo->aheadState == MSDIO_WAIT;
+#else
+	return false;
+#endif
+}
+
+/**
+ * \brief  Drops the data read ahead for a LUN, e.g. because another LUN is
+ *         about to use the same FIFO buffer. A read-ahead in progress must
+ *         be waited for (see sbc_read_ahead) before calling this function.
+ * \param  lun          Pointer to the affected LUN
+ */
+void sbc_cancel_read_ahead(MSDLun *lun)
+{
+#ifdef MSDIO_READ_AHEAD
+	if (lun->ioFifo.aheadState != MSDIO_WAIT)
+		lun->ioFifo.aheadState = MSDIO_IDLE;
+#endif
+}
+
 /**
  * \brief  Processes a SBC command by dispatching it to a subfunction.
  * \param  lun          Pointer to the affected LUN
@@ -1282,6 +1545,11 @@ uint8_t sbc_process_command(MSDLun *lun, MSDCommandState *command_state)
 		result = MSDD_STATUS_PARAMETER;
 		break;
 
+	case SBC_VENDOR_GET_STATISTICS:
+		/* Send the LUN statistics */
+		result = sbc_vendor_get_statistics(lun, command_state);
+		break;
+
 	default:
 		result = MSDD_STATUS_PARAMETER;
 	}
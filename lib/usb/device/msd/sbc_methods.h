@@ -107,6 +107,10 @@ bool sbc_get_command_information(void *command,
 
 uint8_t sbc_process_command(MSDLun *lun, MSDCommandState *command_state);
 
+bool sbc_read_ahead(MSDLun *lun);
+
+void sbc_cancel_read_ahead(MSDLun *lun);
+
 /**@}*/
 
 #endif /*#ifndef SBCMETHODS_H */
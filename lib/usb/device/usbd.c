@@ -40,6 +40,9 @@
  *@{
  */
 
+/* Runtime trace filtering of this file, see trace_set_module_level() */
+#define TRACE_MODULE TRACE_MODULE_USB
+
 /*---------------------------------------------------------------------------
  *      Headers
  *---------------------------------------------------------------------------*/
@@ -263,6 +266,15 @@ bool usbd_is_high_speed(void)
 	return usbd_hal_is_high_speed();
 }
 
+/**
+ * Returns the current USB (micro)frame number in 125us units. The counter
+ * wraps every 16384 units (2.048 seconds).
+ */
+uint16_t usbd_get_frame_number(void)
+{
+	return usbd_hal_get_frame_number();
+}
+
 /**
  * Causes the given endpoint to acknowledge the next packet it receives
  * with a STALL handshake.
@@ -50,6 +50,16 @@
 #include "usb/common/usb_requests.h"
 #include "usb/device/usbd.h"
 
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of DMA descriptors for usbd_hal_write_payloads(): one per header
+ *  plus one per bank of each payload */
+#ifndef USBD_HAL_CHAIN_DESC_COUNT
+#define USBD_HAL_CHAIN_DESC_COUNT 64
+#endif
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -87,6 +97,8 @@ extern void usbd_hal_force_full_speed(void);
 
 extern bool usbd_hal_is_high_speed(void);
 
+extern uint16_t usbd_hal_get_frame_number(void);
+
 extern void usbd_hal_suspend(void);
 
 extern void usbd_hal_activate(void);
@@ -110,6 +122,11 @@ extern uint8_t usbd_hal_write_with_header(uint8_t endpoint,
 		const void *header, uint32_t header_length,
 		const void *data, uint32_t data_length);
 
+extern uint8_t usbd_hal_write_payloads(uint8_t endpoint,
+		const void *headers, uint32_t header_length,
+		const void *data, uint32_t data_length,
+		uint32_t payload_length, uint8_t count);
+
 extern uint16_t usbd_hal_get_data_size(uint8_t endpoint);
 
 extern uint8_t usbd_hal_read(uint8_t endpoint,
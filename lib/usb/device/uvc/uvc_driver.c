@@ -53,7 +53,6 @@ static struct _uvc_driver uvc_driver;
 
 void uvc_driver_initialize(const USBDDriverDescriptors *descriptors, uint32_t buff_addr, uint8_t multi_buffers)
 {
-	uvc_driver.frm_offset = 0;
 	uvc_driver.is_frame_xfring = 0;
 	uvc_driver.buf_start_addr = buff_addr;
 	uvc_driver.multi_buffers = multi_buffers;
@@ -130,7 +129,9 @@ void uvc_driver_interface_setting_changed_handler(uint8_t interface,
 	if (setting) {
 		uvc_driver.is_video_on = 1;
 		uvc_driver.frm_count = 0;
-		uvc_driver.frm_offset = 0;
+		uvc_driver.captured = 0;
+		uvc_driver.dropped = 0;
+		uvc_driver.torn = 0;
 	} else {
 		uvc_driver.is_video_on = 0;
 		uvc_driver.is_frame_xfring = 0;
@@ -57,11 +57,31 @@ struct _uvc_driver {
 	volatile uint8_t is_video_on;
 	volatile uint8_t is_frame_xfring; //=0 default
 	uint32_t frm_format;
+	/** Format index selected by the host */
+	uint8_t  frm_format_index;
 	uint32_t frm_count;
-	uint32_t frm_offset;
 	uint32_t stream_frm_index;
 	uint32_t buf_start_addr;
 	uint8_t  multi_buffers;
+	/** Frames completed by the capture since streaming started */
+	volatile uint32_t captured;
+	/** Size of the last frame completed, 0 for a full uncompressed frame */
+	volatile uint32_t captured_size;
+	/** Capture sequence number of the frame being sent */
+	uint32_t stream_seq;
+	/** Slot of the frame being sent */
+	uint8_t  stream_slot;
+	/** Size of the frame being sent */
+	uint32_t stream_size;
+	/** Next payload of the frame being sent, and payload count */
+	uint32_t payload_idx;
+	uint32_t payload_count;
+	/** Frames captured but never sent */
+	uint32_t dropped;
+	/** Frames overwritten by the capture while being sent */
+	uint32_t torn;
+	/** The frame being sent has been overwritten */
+	uint8_t  stream_torn;
 	/** Array for storing the current setting of each interface */
 	uint8_t alternate_interfaces[4];
 };
@@ -32,6 +32,7 @@
  *------------------------------------------------------------------------------*/
 #include "chip.h"
 
+#include "intmath.h"
 #include "trace.h"
 #include "mm/cache.h"
 #include "usb/common/uvc/usb_video.h"
@@ -43,6 +44,9 @@
 #include "timer.h"
 #include <string.h>
 
+/** Maximum number of payloads sent with one DMA descriptor chain */
+#define UVC_CHAIN_PAYLOADS  (USBD_HAL_CHAIN_DESC_COUNT / (ISO_HIGH_BW_MODE + 2))
+
 /** Probe & Commit Controls */
 
 static const struct _USBVideoProbeCommitData vidd_probe_data_init =
@@ -80,12 +84,8 @@ static uint32_t frm_max_pkt_size = FRAME_PACKET_SIZE_HS * (ISO_HIGH_BW_MODE + 1)
 /** Buffer for USB requests data */
 CACHE_ALIGNED static uint8_t control_buffer[64];
 
-CACHE_ALIGNED static uint8_t stream_header[32];
-
 static struct _uvc_driver *uvc_driver;
 
-static volatile uint32_t frame_buffer_addr;
-
 static uint32_t uvc_frame_count = 0;
 /*-----------------------------------------------------------------------------
  *      Exported functions
@@ -101,13 +101,15 @@ static uint32_t uvc_frame_count = 0;
 static void vidd_update_high_bw_max_packetsize(void)
 {
 #if (ISO_HIGH_BW_MODE == 1 || ISO_HIGH_BW_MODE == 2)
-	uint32_t frm_size = frm_width * frm_height * 2 + FRAME_PAYLOAD_HDR_SIZE;
+	/* Each payload carries its own header */
+	uint32_t frm_size = FRAME_BUFFER_SIZEC(frm_width, frm_height);
 	uint32_t pkt_size = FRAME_PACKET_SIZE_HS * (ISO_HIGH_BW_MODE + 1);
-	uint32_t nb_last = frm_size % pkt_size;
+	uint32_t nb_last;
 
 	while(1) {
-		nb_last = frm_size % pkt_size;
-		if (nb_last == 0 || nb_last > (FRAME_PACKET_SIZE_HS * ISO_HIGH_BW_MODE))
+		nb_last = frm_size % (pkt_size - FRAME_PAYLOAD_HDR_SIZE);
+		if (nb_last == 0 ||
+		    nb_last + FRAME_PAYLOAD_HDR_SIZE > (FRAME_PACKET_SIZE_HS * ISO_HIGH_BW_MODE))
 			break;
 		pkt_size--;
 	}
@@ -148,6 +150,7 @@ static void vidd_status_stage(void *arg, uint8_t status,
 	vidd_probe_data.wDelay = 0;
 	vidd_probe_data.dwMaxVideoFrameSize = FRAME_BUFFER_SIZEC(frm_width, frm_height);
 	uvc_driver->frm_format = pProbe->bFrameIndex;
+	uvc_driver->frm_format_index = pProbe->bFormatIndex;
 	usbd_write(0, NULL, 0, NULL, NULL);
 }
 
@@ -273,6 +276,8 @@ void uvc_function_get_res(const USBGenericRequest *request)
 void uvc_reset_frame_count(void)
 {
 	uvc_frame_count = 0;
+	uvc_driver->dropped = 0;
+	uvc_driver->torn = 0;
 }
 
 uint32_t uvc_get_frame_count(void)
@@ -280,47 +285,157 @@ uint32_t uvc_get_frame_count(void)
 	return uvc_frame_count;
 }
 
+uint32_t uvc_get_dropped_frame_count(void)
+{
+	return uvc_driver->dropped;
+}
+
+uint32_t uvc_get_torn_frame_count(void)
+{
+	return uvc_driver->torn;
+}
+
+static uint32_t _uvc_payload_size(void)
+{
+	return usbd_is_high_speed() ? frm_max_pkt_size : FRAME_PACKET_SIZE_FS;
+}
+
+static uint8_t* _uvc_slot_frame(uint8_t slot)
+{
+	return (uint8_t*)(uvc_driver->buf_start_addr +
+			slot * FRAME_SLOT_SIZEC(frm_width, frm_height));
+}
+
+static uint8_t* _uvc_slot_headers(uint8_t slot)
+{
+	return _uvc_slot_frame(slot) +
+		ROUND_UP_MULT(FRAME_BUFFER_SIZEC(frm_width, frm_height), L1_CACHE_BYTES);
+}
+
 /**
- * Callback that invoked when USB packet is sent.
+ * Number of bytes sent for a frame of the given size, 0 meaning a full
+ * uncompressed frame. In high bandwidth mode the last payload must use
+ * all the transactions of its microframe, compressed frames are then
+ * extended with the bytes following their end marker in the slot.
  */
-void uvc_function_payload_sent(void *arg, uint8_t state,
-		uint32_t transferred, uint32_t remaining)
+static uint32_t _uvc_stream_size(uint32_t size)
 {
-	uint32_t dma_transfer_size;
 	uint32_t frame_size = FRAME_BUFFER_SIZEC(frm_width, frm_height);
-	uint8_t *uncompressed_stream = (uint8_t*)(uvc_driver->buf_start_addr +
-									frame_buffer_addr * FRAME_BUFFER_SIZEC(frm_width, frm_height));
-	USBVideoPayloadHeader *header = (USBVideoPayloadHeader*)stream_header;
-	uint32_t max_pkt_size = usbd_is_high_speed() ? frm_max_pkt_size : FRAME_PACKET_SIZE_FS;
-	if (remaining){
+#if (ISO_HIGH_BW_MODE == 1 || ISO_HIGH_BW_MODE == 2)
+	uint32_t payload_data = _uvc_payload_size() - FRAME_PAYLOAD_HDR_SIZE;
+	uint32_t last_min = FRAME_PACKET_SIZE_HS * ISO_HIGH_BW_MODE + 1 -
+		FRAME_PAYLOAD_HDR_SIZE;
+	uint32_t last;
+
+	if (size && usbd_is_high_speed()) {
+		last = size % payload_data;
+		if (last && last < last_min)
+			size += last_min - last;
+	}
+#endif
+	if (!size || size > frame_size)
+		return frame_size;
+	return size;
+}
+
+/**
+ * Pick the latest frame completed by the capture and fill in the payload
+ * headers reserved after it in its slot.
+ * \return true if a frame is ready to be sent.
+ */
+static bool _uvc_prepare_frame(void)
+{
+	uint32_t payload_data = _uvc_payload_size() - FRAME_PAYLOAD_HDR_SIZE;
+	USBVideoPayloadHeader *header;
+	uint32_t captured, index, size, i;
+
+	/* Sample the capture state consistently */
+	do {
+		captured = uvc_driver->captured;
+		index = uvc_driver->stream_frm_index;
+		size = uvc_driver->captured_size;
+	} while (captured != uvc_driver->captured);
+
+	if (captured == uvc_driver->stream_seq)
+		return false;
+
+	/* Frames completed meanwhile are skipped */
+	uvc_driver->dropped += captured - uvc_driver->stream_seq - 1;
+	uvc_driver->stream_seq = captured;
+	uvc_driver->stream_torn = 0;
+
+	/* The capture moves to the next slot when a frame completes */
+	uvc_driver->stream_slot = (index == 0) ? (uvc_driver->multi_buffers - 1) : (index - 1);
+	uvc_driver->stream_size = _uvc_stream_size(size);
+	uvc_driver->payload_idx = 0;
+	uvc_driver->payload_count = (uvc_driver->stream_size + payload_data - 1) / payload_data;
+
+	header = (USBVideoPayloadHeader*)_uvc_slot_headers(uvc_driver->stream_slot);
+	for (i = 0; i < uvc_driver->payload_count; i++) {
+		header[i].bHeaderLength = FRAME_PAYLOAD_HDR_SIZE;
+		header[i].bmHeaderInfo.B = 0;
+		header[i].bmHeaderInfo.bm.FID = (uvc_driver->frm_count & 1);
+		header[i].bmHeaderInfo.bm.EOH = 1;
+	}
+	header[i - 1].bmHeaderInfo.bm.EoF = 1;
 
+	return true;
+}
+
+/**
+ * Queue the next payloads of the frame being sent as one DMA descriptor
+ * chain, headers being taken from the slot header area.
+ */
+static void _uvc_send_payloads(void)
+{
+	uint32_t frame_size = uvc_driver->stream_size;
+	uint32_t payload_size = _uvc_payload_size();
+	uint32_t payload_data = payload_size - FRAME_PAYLOAD_HDR_SIZE;
+	uint32_t first = uvc_driver->payload_idx;
+	uint32_t offset = first * payload_data;
+	uint32_t count = min_u32(uvc_driver->payload_count - first, UVC_CHAIN_PAYLOADS);
+	uint8_t slot = uvc_driver->stream_slot;
+
+	uvc_driver->payload_idx += count;
+	if (usbd_hal_write_payloads(VIDCAMD_IsoInEndpointNum,
+			_uvc_slot_headers(slot) + first * FRAME_PAYLOAD_HDR_SIZE,
+			FRAME_PAYLOAD_HDR_SIZE,
+			_uvc_slot_frame(slot) + offset,
+			min_u32(count * payload_data, frame_size - offset),
+			payload_size, count) != USBD_STATUS_SUCCESS)
+		uvc_driver->is_frame_xfring = 0;
+}
+
+/**
+ * Callback that invoked when a chain of payloads is sent.
+ */
+void uvc_function_payload_sent(void *arg, uint8_t state,
+		uint32_t transferred, uint32_t remaining)
+{
+	if (state != USBD_STATUS_SUCCESS || !uvc_driver->is_video_on) {
+		uvc_driver->is_frame_xfring = 0;
 		return;
 	}
-	dma_transfer_size = frame_size - uvc_driver->frm_offset;
-	header->bHeaderLength = FRAME_PAYLOAD_HDR_SIZE;
-	header->bmHeaderInfo.B = 0;
-	if (dma_transfer_size > max_pkt_size - header->bHeaderLength)
-		dma_transfer_size = max_pkt_size - header->bHeaderLength;
-	uncompressed_stream = &uncompressed_stream[uvc_driver->frm_offset];
-	uvc_driver->frm_offset += dma_transfer_size;
-	header->bmHeaderInfo.bm.FID = (uvc_driver->frm_count & 1);
-	if (uvc_driver->frm_offset >= frame_size) {
-		uvc_driver->frm_count++;
-		uvc_driver->frm_offset = 0;
-		header->bmHeaderInfo.bm.EoF = 1;
-		uvc_frame_count++;
-		frame_buffer_addr = uvc_driver ->stream_frm_index;
-		frame_buffer_addr = (frame_buffer_addr == 0) ?
-							(uvc_driver->multi_buffers - 1): (frame_buffer_addr -1);
-		if (uvc_driver->is_frame_xfring)
-			uvc_driver->is_frame_xfring = 0;
-	} else {
-		header->bmHeaderInfo.bm.EoF = 0;
+
+	/* The capture went round the ring back to the slot being sent */
+	if (uvc_driver->captured - uvc_driver->stream_seq >= uvc_driver->multi_buffers - 1u)
+		uvc_driver->stream_torn = 1;
+
+	if (uvc_driver->payload_idx < uvc_driver->payload_count) {
+		_uvc_send_payloads();
+		return;
 	}
-	header->bmHeaderInfo.bm.EOH =  1;
-	usleep(500);
-	usbd_hal_write_with_header(VIDCAMD_IsoInEndpointNum, header,
-		header->bHeaderLength, uncompressed_stream, dma_transfer_size);
+
+	/* End of frame */
+	if (uvc_driver->stream_torn)
+		uvc_driver->torn++;
+	uvc_driver->frm_count++;
+	uvc_frame_count++;
+
+	if (_uvc_prepare_frame())
+		_uvc_send_payloads();
+	else
+		uvc_driver->is_frame_xfring = 0;
 }
 
 void uvc_function_initialize(struct _uvc_driver* uvc_drv)
@@ -339,9 +454,35 @@ uint8_t uvc_function_get_frame_format(void)
 	return (uint8_t)uvc_driver->frm_format;
 }
 
+uint8_t uvc_function_get_format_index(void)
+{
+	return uvc_driver->frm_format_index;
+}
+
 void uvc_function_update_frame_idx(uint32_t idx)
+{
+	uvc_function_update_frame(idx, 0);
+}
+
+/**
+ * Signal a completed frame of variable size, such as a Motion-JPEG one.
+ * \param idx   Slot the capture moves to, the frame is in the previous one
+ * \param size  Size of the frame in bytes, 0 for a full uncompressed frame
+ */
+void uvc_function_update_frame(uint32_t idx, uint32_t size)
 {
 	uvc_driver->stream_frm_index = idx;
+	uvc_driver->captured_size = size;
+	uvc_driver->captured++;
+
+	/* Start sending if the previous frame is done */
+	if (uvc_driver->is_video_on && !uvc_driver->is_frame_xfring) {
+		uvc_driver->is_frame_xfring = 1;
+		if (_uvc_prepare_frame())
+			_uvc_send_payloads();
+		else
+			uvc_driver->is_frame_xfring = 0;
+	}
 }
 
 /**@}*/
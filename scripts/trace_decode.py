@@ -0,0 +1,241 @@
+#!/usr/bin/env python3
+# ----------------------------------------------------------------------------
+#         SAM Software Package License
+# ----------------------------------------------------------------------------
+# Copyright (c) 2015, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Decode deferred traces (CONFIG_HAVE_TRACE_DEFERRED, see utils/trace.h).
+
+The format strings are read from the .trace_fmt section of the application
+ELF. Records are read from a binary capture/dump file, from stdin ("-") or
+live from a serial port (requires pyserial). Bytes that are not part of a
+valid record, such as regular printf output, are passed through as text.
+
+Usage:
+    trace_decode.py app.elf capture.bin
+    trace_decode.py app.elf --serial /dev/ttyACM0 --baudrate 115200
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+TRACE_RECORD_SYNC = 0xA5
+TRACE_RECORD_MAX_ARGS = 16
+TRACE_LEVEL_FATAL = 1
+TRACE_LEVEL_DEBUG = 5
+
+SHT_NOBITS = 8
+SHF_ALLOC = 2
+
+FORMAT_SPEC = re.compile(
+    r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|j|z|t|L)?([diouxXcsfFeEgGpn%])")
+
+
+class Elf(object):
+    """Minimal little-endian ELF reader: sections only."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[5] != 1:
+            raise ValueError("%s: not a little-endian ELF file" % path)
+        if data[4] == 1:
+            shoff, = struct.unpack_from("<I", data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2e)
+            shdr = "<IIIIIIIIII"
+        else:
+            shoff, = struct.unpack_from("<Q", data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x3a)
+            shdr = "<IIQQQQIIQQ"
+        headers = [struct.unpack_from(shdr, data, shoff + i * shentsize)
+                   for i in range(shnum)]
+        names = headers[shstrndx]
+        self.sections = {}
+        for (name, stype, flags, addr, offset, size, _, _, _, _) in headers:
+            start = names[4] + name
+            name = data[start:data.index(b"\0", start)].decode()
+            contents = b"" if stype == SHT_NOBITS else data[offset:offset + size]
+            self.sections[name] = (addr, flags, contents)
+
+    def section(self, name):
+        return self.sections.get(name)
+
+    def read_string(self, address):
+        """Return the NUL-terminated string at address in a loaded section."""
+        for (addr, flags, contents) in self.sections.values():
+            if (flags & SHF_ALLOC) and contents and \
+                    addr <= address < addr + len(contents):
+                start = address - addr
+                end = contents.find(b"\0", start)
+                if end < 0:
+                    end = len(contents)
+                return contents[start:end].decode("latin-1")
+        return None
+
+
+class Decoder(object):
+
+    def __init__(self, elf):
+        self.elf = elf
+        fmt = elf.section(".trace_fmt")
+        if fmt is None:
+            raise ValueError("no .trace_fmt section, was the application "
+                             "built with CONFIG_HAVE_TRACE_DEFERRED=y?")
+        self.formats = {}
+        addr, _, contents = fmt
+        start = 0
+        while start < len(contents):
+            end = contents.find(b"\0", start)
+            if end < 0:
+                end = len(contents)
+            if end > start:
+                self.formats[addr + start] = contents[start:end].decode("latin-1")
+            start = end + 1
+        self.buffer = bytearray()
+        self.sequence = None
+
+    def _format(self, fmt, args):
+        args = list(args)
+
+        def next_arg():
+            return args.pop(0) if args else 0
+
+        def convert(match):
+            flags, width, precision, _, conv = match.groups()
+            if conv == "%":
+                return "%"
+            if width == "*":
+                width = str(struct.unpack("<i", struct.pack("<I", next_arg()))[0])
+            if precision == "*":
+                precision = str(next_arg())
+            spec = "%" + flags.replace("#", "#" if conv in "oxX" else "") + \
+                (width or "") + ("." + precision if precision is not None else "")
+            value = next_arg()
+            if conv in "di":
+                return (spec + "d") % struct.unpack("<i", struct.pack("<I", value))[0]
+            if conv in "uoxX":
+                return (spec + conv.replace("u", "d")) % value
+            if conv == "c":
+                return (spec + "c") % chr(value & 0xff)
+            if conv == "s":
+                string = self.elf.read_string(value)
+                if string is None:
+                    string = "<0x%08x>" % value
+                return (spec + "s") % string
+            if conv == "p":
+                return "0x%08x" % value
+            if conv in "fFeEgG":
+                return (spec + conv) % value
+            return ""
+
+        return FORMAT_SPEC.sub(convert, fmt)
+
+    def _header(self, offset):
+        """Return (level, nargs, sequence) if a record header is at offset."""
+        header, = struct.unpack_from("<I", self.buffer, offset)
+        level = (header >> 21) & 0x7
+        nargs = (header >> 16) & 0x1f
+        if (header >> 24) != TRACE_RECORD_SYNC or \
+                not TRACE_LEVEL_FATAL <= level <= TRACE_LEVEL_DEBUG or \
+                nargs > TRACE_RECORD_MAX_ARGS:
+            return None
+        return (level, nargs, header & 0xffff)
+
+    def feed(self, data, final=False):
+        """Decode as many records as possible, yield the output text."""
+        self.buffer += data
+        text = bytearray()
+        pos = 0
+        while len(self.buffer) - pos >= 12:
+            header = self._header(pos)
+            if header is not None:
+                level, nargs, sequence = header
+                size = 12 + 4 * nargs
+                if len(self.buffer) - pos < size:
+                    break
+                words = struct.unpack_from("<%dI" % (2 + nargs), self.buffer, pos + 4)
+                fmt = self.formats.get(words[0])
+                if fmt is not None:
+                    if text:
+                        yield text.decode("latin-1")
+                        text = bytearray()
+                    if self.sequence is not None:
+                        lost = (sequence - self.sequence - 1) & 0xffff
+                        if lost:
+                            yield "--- %d trace record(s) lost ---\n" % lost
+                    self.sequence = sequence
+                    yield "[%10u] %s" % (words[1], self._format(fmt, words[2:]))
+                    pos += size
+                    continue
+            text.append(self.buffer[pos])
+            pos += 1
+        if final:
+            text += self.buffer[pos:]
+            pos = len(self.buffer)
+        del self.buffer[:pos]
+        if text:
+            yield text.decode("latin-1")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decode deferred binary traces using the application ELF")
+    parser.add_argument("elf", help="application ELF file")
+    parser.add_argument("input", nargs="?", default="-",
+                        help="binary capture or dump, '-' for stdin")
+    parser.add_argument("--serial", metavar="PORT",
+                        help="decode the live stream of a serial port")
+    parser.add_argument("--baudrate", type=int, default=115200)
+    options = parser.parse_args()
+
+    decoder = Decoder(Elf(options.elf))
+    out = sys.stdout
+
+    if options.serial:
+        import serial
+        port = serial.Serial(options.serial, options.baudrate, timeout=0.1)
+        try:
+            while True:
+                for text in decoder.feed(port.read(4096)):
+                    out.write(text)
+                out.flush()
+        except KeyboardInterrupt:
+            pass
+        return
+
+    if options.input == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(options.input, "rb") as f:
+            data = f.read()
+    for text in decoder.feed(data, final=True):
+        out.write(text)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,229 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Benchmark of the audio converter: time and cycles (time stamp counter
+ * cycles, on x86 hosts) per output sample, and THD+N of a 1 kHz tone at -1 dBFS for the common rate conversions. The THD+N is the
+ * power left once the tone, fitted by least squares, is removed from the
+ * output. An optional argument sets the number of seconds of audio
+ * converted for the timing.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "audio/audio_convert.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define TONE_HZ       1000
+#define TONE_DBFS     (-1.0)
+
+/* One second of stereo input and output at up to 48 kHz, 32-bit samples */
+#define MAX_FRAMES    48000
+#define CHANNELS      2
+
+/* Output frames ignored while the filter history fills */
+#define SETTLE_FRAMES 256
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _audio_convert conv;
+static int32_t in_buffer[MAX_FRAMES * CHANNELS];
+static int32_t out_buffer[(MAX_FRAMES + 16) * 3 * CHANNELS];
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static double _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t _cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+static uint32_t _sample_size(uint16_t bits_per_sample)
+{
+	return bits_per_sample == 16 ? 2 : 4;
+}
+
+static double _full_scale(uint16_t bits_per_sample)
+{
+	return ldexp(1.0, bits_per_sample - 1);
+}
+
+/** Fills one second of the tone, returns its size in bytes */
+static uint32_t _generate(const struct _audio_format *format)
+{
+	double amplitude = _full_scale(format->bits_per_sample) *
+		pow(10.0, TONE_DBFS / 20.0);
+	uint32_t frames = format->sample_rate;
+	uint32_t i, c;
+
+	assert(frames <= MAX_FRAMES);
+	for (i = 0; i < frames; i++) {
+		double t = (double)i / format->sample_rate;
+		int32_t v = (int32_t)lrint(amplitude *
+				sin(2.0 * M_PI * TONE_HZ * t));
+		for (c = 0; c < format->num_channels; c++) {
+			uint32_t n = i * format->num_channels + c;
+			if (format->bits_per_sample == 16)
+				((int16_t*)in_buffer)[n] = (int16_t)v;
+			else
+				in_buffer[n] = v;
+		}
+	}
+	return frames * format->num_channels *
+		_sample_size(format->bits_per_sample);
+}
+
+static double _output_sample(const struct _audio_format *format, uint32_t n)
+{
+	if (format->bits_per_sample == 16)
+		return ((int16_t*)out_buffer)[n];
+	return out_buffer[n];
+}
+
+/** THD+N in dB of the first channel of the output */
+static double _thd_n(const struct _audio_format *format, uint32_t frames)
+{
+	double w = 2.0 * M_PI * TONE_HZ / format->sample_rate;
+	double ss = 0, sc = 0, cc = 0, ys = 0, yc = 0, y0 = 0;
+	double a, b, det, signal = 0, noise = 0;
+	uint32_t i, count;
+
+	/* Whole periods after the settling time */
+	count = (frames - SETTLE_FRAMES) / (format->sample_rate / TONE_HZ)
+		* (format->sample_rate / TONE_HZ);
+	assert(count > 0);
+
+	/* Least squares fit of a sin + b cos + dc */
+	for (i = SETTLE_FRAMES; i < SETTLE_FRAMES + count; i++) {
+		double s = sin(w * i), c = cos(w * i);
+		double y = _output_sample(format, i * format->num_channels);
+		ss += s * s;
+		sc += s * c;
+		cc += c * c;
+		ys += y * s;
+		yc += y * c;
+		y0 += y;
+	}
+	det = ss * cc - sc * sc;
+	a = (ys * cc - yc * sc) / det;
+	b = (yc * ss - ys * sc) / det;
+	y0 /= count;
+
+	for (i = SETTLE_FRAMES; i < SETTLE_FRAMES + count; i++) {
+		double fit = a * sin(w * i) + b * cos(w * i);
+		double y = _output_sample(format, i * format->num_channels);
+		signal += fit * fit;
+		noise += (y - y0 - fit) * (y - y0 - fit);
+	}
+	return 10.0 * log10(noise / signal);
+}
+
+static void _bench(uint32_t in_rate, uint32_t out_rate, uint16_t in_bits,
+		uint16_t out_bits, double max_thd_n, uint32_t seconds)
+{
+	struct _audio_format in = { in_rate, CHANNELS, in_bits };
+	struct _audio_format out = { out_rate, CHANNELS, out_bits };
+	uint32_t in_size, out_size, consumed, frames, i;
+	double start, elapsed, thd_n, samples;
+	uint64_t cycles;
+
+	assert(audio_convert_init(&conv, &in, &out) == 0);
+	in_size = _generate(&in);
+	assert(audio_convert_get_output_size(&conv, in_size)
+			<= sizeof(out_buffer));
+
+	out_size = audio_convert_process(&conv, in_buffer, in_size, out_buffer,
+			sizeof(out_buffer), &consumed);
+	assert(consumed == in_size);
+	frames = out_size / (CHANNELS * _sample_size(out_bits));
+	thd_n = _thd_n(&out, frames);
+
+	start = _now();
+	cycles = _cycles();
+	for (i = 0; i < seconds; i++)
+		audio_convert_process(&conv, in_buffer, in_size, out_buffer,
+				sizeof(out_buffer), NULL);
+	cycles = _cycles() - cycles;
+	elapsed = _now() - start;
+	samples = (double)frames * CHANNELS * seconds;
+
+	printf("%5u -> %5u Hz, %2u -> %2u bit: %6.1f ns/sample, "
+	       "%6.1f cycles/sample, THD+N %6.1f dB\n", (unsigned)in_rate,
+	       (unsigned)out_rate, in_bits, out_bits, elapsed * 1e9 / samples,
+	       cycles / samples, thd_n);
+	assert(thd_n < max_thd_n);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+	uint32_t seconds = argc > 1 ? strtoul(argv[1], NULL, 0) : 20;
+
+	_bench(44100, 48000, 16, 16, -70.0, seconds);
+	_bench(44100, 48000, 24, 24, -70.0, seconds);
+	_bench(48000, 44100, 16, 16, -70.0, seconds);
+	_bench(16000, 48000, 16, 16, -70.0, seconds);
+	_bench(48000, 16000, 16, 16, -70.0, seconds);
+	_bench(48000, 48000, 16, 24, -90.0, seconds);
+	return 0;
+}
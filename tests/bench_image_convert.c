@@ -0,0 +1,206 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Benchmark of the image conversion, scaling and rotation kernels on a VGA
+ * frame. An optional argument sets the number of iterations.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "video/image_convert.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define WIDTH   640
+#define HEIGHT  480
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint8_t src_buffer[WIDTH * HEIGHT * 4];
+static uint8_t src_uv_buffer[WIDTH * HEIGHT / 2];
+static uint8_t dst_buffer[WIDTH * HEIGHT * 4 * 2];
+static uint8_t dst_uv_buffer[WIDTH * HEIGHT];
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static double _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void _image(struct _image *image, uint8_t *data, uint8_t *data_uv,
+		uint16_t width, uint16_t height, uint8_t format)
+{
+	image->data = data;
+	image->data_uv = data_uv;
+	image->stride = 0;
+	image->width = width;
+	image->height = height;
+	image->format = format;
+}
+
+static void _report(const char *name, uint32_t pixels, uint32_t iterations,
+		double elapsed)
+{
+	printf("%-32s %8.1f Mpixel/s\n", name,
+	       (double)pixels * iterations / elapsed / 1e6);
+}
+
+static void _bench_convert(const char *name, uint8_t src_format,
+		uint8_t dst_format, uint32_t iterations)
+{
+	struct _image src, dst;
+	uint32_t i;
+	double start;
+
+	_image(&src, src_buffer, src_uv_buffer, WIDTH, HEIGHT, src_format);
+	_image(&dst, dst_buffer, dst_uv_buffer, WIDTH, HEIGHT, dst_format);
+	start = _now();
+	for (i = 0; i < iterations; i++)
+		assert(image_convert(&src, &dst) == 0);
+	_report(name, WIDTH * HEIGHT, iterations, _now() - start);
+}
+
+static void _bench_scale(const char *name, uint8_t format, uint16_t width,
+		uint16_t height, uint8_t scaling, uint32_t iterations)
+{
+	struct _image src, dst;
+	uint32_t i;
+	double start;
+
+	_image(&src, src_buffer, src_uv_buffer, WIDTH, HEIGHT, format);
+	_image(&dst, dst_buffer, dst_uv_buffer, width, height, format);
+	start = _now();
+	for (i = 0; i < iterations; i++)
+		assert(image_scale(&src, &dst, scaling) == 0);
+	_report(name, width * height, iterations, _now() - start);
+}
+
+static void _bench_rotate(const char *name, uint8_t format, int16_t rotation,
+		uint32_t iterations)
+{
+	struct _image src, dst;
+	uint32_t i;
+	double start;
+	bool swap = rotation == 90 || rotation == 270;
+
+	_image(&src, src_buffer, src_uv_buffer, WIDTH, HEIGHT, format);
+	_image(&dst, dst_buffer, dst_uv_buffer, swap ? HEIGHT : WIDTH,
+	       swap ? WIDTH : HEIGHT, format);
+	start = _now();
+	for (i = 0; i < iterations; i++)
+		assert(image_rotate(&src, &dst, rotation) == 0);
+	_report(name, WIDTH * HEIGHT, iterations, _now() - start);
+}
+
+/** Bilinear RGB565 scaling of a uniform image must keep its color */
+static void _check_rgb565_uniform(uint16_t color)
+{
+	uint16_t *pixels = (uint16_t*)src_buffer;
+	struct _image src, dst;
+	uint32_t i;
+
+	for (i = 0; i < 64 * 48; i++)
+		pixels[i] = color;
+	_image(&src, src_buffer, NULL, 64, 48, IMAGE_FORMAT_RGB565);
+	_image(&dst, dst_buffer, NULL, 100, 75, IMAGE_FORMAT_RGB565);
+	assert(image_scale(&src, &dst, IMAGE_SCALING_BILINEAR) == 0);
+	for (i = 0; i < 100 * 75; i++)
+		assert(((uint16_t*)dst_buffer)[i] == color);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+	uint32_t iterations = argc > 1 ? strtoul(argv[1], NULL, 0) : 50;
+	uint32_t i;
+
+	_check_rgb565_uniform(0xffff);
+	_check_rgb565_uniform(0xf800);
+	_check_rgb565_uniform(0x07e0);
+	_check_rgb565_uniform(0x001f);
+
+	/* Random pixels, including RGB565 values with the top bit set */
+	srand(1);
+	for (i = 0; i < sizeof(src_buffer); i++)
+		src_buffer[i] = rand();
+	for (i = 0; i < sizeof(src_uv_buffer); i++)
+		src_uv_buffer[i] = rand();
+
+	_bench_convert("convert YUV422 -> RGB565", IMAGE_FORMAT_YUV422,
+		       IMAGE_FORMAT_RGB565, iterations);
+	_bench_convert("convert YUV422 -> ARGB8888", IMAGE_FORMAT_YUV422,
+		       IMAGE_FORMAT_ARGB8888, iterations);
+	_bench_convert("convert RGB565 -> YUV422", IMAGE_FORMAT_RGB565,
+		       IMAGE_FORMAT_YUV422, iterations);
+	_bench_convert("convert YUV420SP -> RGB565", IMAGE_FORMAT_YUV420SP,
+		       IMAGE_FORMAT_RGB565, iterations);
+	_bench_convert("convert RGB888 -> YUV420SP", IMAGE_FORMAT_RGB888,
+		       IMAGE_FORMAT_YUV420SP, iterations);
+
+	_bench_scale("scale RGB565 nearest 800x600", IMAGE_FORMAT_RGB565,
+		     800, 600, IMAGE_SCALING_NEAREST, iterations);
+	_bench_scale("scale RGB565 bilinear 800x600", IMAGE_FORMAT_RGB565,
+		     800, 600, IMAGE_SCALING_BILINEAR, iterations);
+	_bench_scale("scale RGB565 bilinear 320x240", IMAGE_FORMAT_RGB565,
+		     320, 240, IMAGE_SCALING_BILINEAR, iterations);
+	_bench_scale("scale YUV422 bilinear 800x600", IMAGE_FORMAT_YUV422,
+		     800, 600, IMAGE_SCALING_BILINEAR, iterations);
+	_bench_scale("scale ARGB8888 bilinear 800x600", IMAGE_FORMAT_ARGB8888,
+		     800, 600, IMAGE_SCALING_BILINEAR, iterations);
+
+	_bench_rotate("rotate RGB565 90", IMAGE_FORMAT_RGB565, 90, iterations);
+	_bench_rotate("rotate RGB565 180", IMAGE_FORMAT_RGB565, 180, iterations);
+	_bench_rotate("rotate ARGB8888 270", IMAGE_FORMAT_ARGB8888, 270,
+		      iterations);
+	_bench_rotate("rotate YUV422 180", IMAGE_FORMAT_YUV422, 180, iterations);
+
+	return 0;
+}
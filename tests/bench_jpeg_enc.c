@@ -0,0 +1,148 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Benchmark of the JPEG encoder on VGA frames, as they come out of the
+ * image sensor, at several qualities. The frames are encoded by strips of
+ * 16 lines. An optional argument sets the number of frames.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "jpeg/jpeg_enc.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define WIDTH   640
+#define HEIGHT  480
+
+#define STRIP   16
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint8_t frame[WIDTH * HEIGHT * 2];
+static uint8_t gray[WIDTH * HEIGHT];
+static uint8_t out[WIDTH * HEIGHT * 2];
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static double _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Camera like content: gradients, edges and some sensor noise
+ */
+static void _make_frame(void)
+{
+	uint32_t seed = 1;
+	uint32_t x, y;
+
+	for (y = 0; y < HEIGHT; y++)
+		for (x = 0; x < WIDTH; x++) {
+			double v = 128 + 80 * sin(x * 0.03) * cos(y * 0.05) +
+				((x / 64 + y / 48) & 1 ? 20 : -20);
+
+			seed = seed * 1103515245 + 12345;
+			v += (int)((seed >> 16) & 7) - 4;
+			v = v < 0 ? 0 : v > 255 ? 255 : v;
+			frame[(y * WIDTH + x) * 2] = (uint8_t)v;
+			gray[y * WIDTH + x] = (uint8_t)v;
+			frame[(y * WIDTH + x) * 2 + 1] = (x & 1) ?
+				128 + 40 * cos(y * 0.02) : 128 + 40 * sin(x * 0.01);
+		}
+}
+
+static void _bench(enum _jpeg_enc_format format, const char *name,
+		uint8_t quality, uint32_t iterations)
+{
+	struct _jpeg_enc enc;
+	struct _jpeg_enc_cfg cfg = {
+		.format = format,
+		.width = WIDTH,
+		.height = HEIGHT,
+		.quality = quality,
+	};
+	const uint8_t *data = format == JPEG_ENC_FORMAT_GRAY ? gray : frame;
+	uint32_t stride = format == JPEG_ENC_FORMAT_GRAY ? WIDTH : 2 * WIDTH;
+	uint32_t i, y;
+	double start, elapsed;
+	int len = 0;
+
+	start = _now();
+	for (i = 0; i < iterations; i++) {
+		assert(jpeg_enc_start(&enc, &cfg, out, sizeof(out)) == 0);
+		for (y = 0; y < HEIGHT; y += STRIP)
+			assert(jpeg_enc_write_lines(&enc, data + y * stride,
+					stride, STRIP) == 0);
+		len = jpeg_enc_finish(&enc);
+		assert(len > 0);
+	}
+	elapsed = _now() - start;
+
+	printf("%-5s quality %3u %8d bytes %8.1f fps %7.1f Mpixel/s\n",
+	       name, quality, len, iterations / elapsed,
+	       (double)WIDTH * HEIGHT * iterations / elapsed / 1e6);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+	uint32_t iterations = argc > 1 ? strtoul(argv[1], NULL, 0) : 100;
+	static const uint8_t qualities[] = { 50, 75, 90, 100 };
+	uint32_t i;
+
+	_make_frame();
+	for (i = 0; i < sizeof(qualities); i++)
+		_bench(JPEG_ENC_FORMAT_YUYV, "YUYV", qualities[i], iterations);
+	_bench(JPEG_ENC_FORMAT_GRAY, "gray", JPEG_ENC_QUALITY_DEFAULT,
+	       iterations);
+	return 0;
+}
@@ -0,0 +1,186 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Benchmark of the raster operations on a 800x480 frame buffer at 16, 24
+ * and 32 bpp: full screen and small rectangle fills, lines, blending and
+ * text. An optional argument sets the number of iterations.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "graphics/font.h"
+#include "graphics/raster.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define WIDTH   800
+#define HEIGHT  480
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint32_t frame_buffer[WIDTH * HEIGHT];
+static struct _raster raster;
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+/* Cache stub, the host has no DMA to keep coherent */
+void cache_clean_region(const void *start, uint32_t length)
+{
+}
+
+static double _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void _report(const char *name, uint8_t bpp, double count,
+		const char *unit, double elapsed)
+{
+	printf("%-24s %2u bpp %9.1f %s\n", name, bpp, count / elapsed / 1e6,
+	       unit);
+}
+
+static void _bench_fill(uint8_t bpp, uint32_t iterations)
+{
+	uint32_t i, j;
+	double start;
+
+	start = _now();
+	for (i = 0; i < iterations; i++) {
+		raster_fill_rect(&raster, 0, 0, WIDTH, HEIGHT, i);
+		raster_flush(&raster);
+	}
+	_report("fill screen", bpp, (double)WIDTH * HEIGHT * iterations,
+		"Mpixel/s", _now() - start);
+
+	/* 32x32 buttons at every alignment */
+	start = _now();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < 300; j++)
+			raster_fill_rect(&raster, (j * 37) % (WIDTH - 32),
+					(j * 11) % (HEIGHT - 32), 32, 32, j);
+		raster_flush(&raster);
+	}
+	_report("fill 32x32", bpp, 300.0 * 32 * 32 * iterations, "Mpixel/s",
+		_now() - start);
+
+	start = _now();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < HEIGHT; j++)
+			raster_draw_hline(&raster, j % 13, j, WIDTH - 13, i);
+		raster_flush(&raster);
+	}
+	_report("hline", bpp, (double)(WIDTH - 13) * HEIGHT * iterations,
+		"Mpixel/s", _now() - start);
+
+	start = _now();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < WIDTH; j++)
+			raster_draw_vline(&raster, j, j % 13, HEIGHT - 13, i);
+		raster_flush(&raster);
+	}
+	_report("vline", bpp, (double)(HEIGHT - 13) * WIDTH * iterations,
+		"Mpixel/s", _now() - start);
+
+	start = _now();
+	for (i = 0; i < iterations; i++) {
+		raster_blend_rect(&raster, 0, 0, WIDTH, HEIGHT, 0x808080, 96);
+		raster_flush(&raster);
+	}
+	_report("blend screen", bpp, (double)WIDTH * HEIGHT * iterations,
+		"Mpixel/s", _now() - start);
+}
+
+static void _bench_text(uint8_t bpp, uint32_t iterations)
+{
+	static const char line[] = "The quick brown fox jumps over the lazy dog";
+	uint32_t i, j, width, height;
+	double start;
+
+	raster_get_string_size(FONT10x14, line, &width, &height);
+	assert(width < WIDTH);
+
+	start = _now();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < HEIGHT / height; j++)
+			raster_draw_string(&raster, FONT10x14, 0, j * height,
+					line, i);
+		raster_flush(&raster);
+	}
+	_report("text 10x14", bpp,
+		(double)(sizeof(line) - 1) * (HEIGHT / height) * iterations,
+		"Mchar/s", _now() - start);
+
+	start = _now();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < HEIGHT / height; j++)
+			raster_draw_string_with_bgcolor(&raster, FONT10x14, 0,
+					j * height, line, i, ~i);
+		raster_flush(&raster);
+	}
+	_report("text 10x14 background", bpp,
+		(double)(sizeof(line) - 1) * (HEIGHT / height) * iterations,
+		"Mchar/s", _now() - start);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+	uint32_t iterations = argc > 1 ? strtoul(argv[1], NULL, 0) : 200;
+	static const uint8_t bpps[] = { 16, 24, 32 };
+	uint32_t i;
+
+	for (i = 0; i < sizeof(bpps); i++) {
+		assert(raster_init(&raster, frame_buffer, WIDTH, HEIGHT,
+				bpps[i], 0) == 0);
+		_bench_fill(bpps[i], iterations);
+		_bench_text(bpps[i], iterations);
+	}
+	return 0;
+}
@@ -0,0 +1,197 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Benchmark of the timer wheel with 10000 timers spread over 10 seconds,
+ * the time unit being the microsecond. A sorted list, as used by the
+ * software timers before the wheel, gives the reference. An optional
+ * argument sets the number of iterations.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "timer_wheel.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define TIMER_COUNT 10000
+#define TIMER_SPAN  10000000
+#define TICK        1000
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _timer_wheel wheel;
+static struct _timer_wheel_entry entries[TIMER_COUNT];
+static uint64_t expiries[TIMER_COUNT];
+static uint32_t call_count;
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static double _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void _report(const char *name, uint32_t ops, uint32_t iterations,
+		double seconds)
+{
+	printf("%-28s %8.1f ns/op\n", name,
+	       seconds * 1e9 / ((double)ops * iterations));
+}
+
+static int _callback(void* arg, void* arg2)
+{
+	call_count++;
+	return 0;
+}
+
+/** Sorted singly linked list insertion, the reference */
+static void _list_insert(struct _timer_wheel_entry** head,
+		struct _timer_wheel_entry* entry)
+{
+	while (*head && (*head)->expires <= entry->expires)
+		head = &(*head)->next;
+	entry->next = *head;
+	*head = entry;
+}
+
+static void _bench_wheel(uint32_t iterations)
+{
+	double add = 0, move = 0, remove = 0, expire = 0, start;
+	uint32_t it, i;
+	uint64_t now;
+
+	for (it = 0; it < iterations; it++) {
+		timer_wheel_init(&wheel, 0);
+		call_count = 0;
+
+		start = _now();
+		for (i = 0; i < TIMER_COUNT; i++) {
+			entries[i].expires = expiries[i];
+			timer_wheel_add(&wheel, &entries[i]);
+		}
+		add += _now() - start;
+
+		/* Timeouts pushed back before they expire */
+		start = _now();
+		for (i = 0; i < TIMER_COUNT; i++) {
+			entries[i].expires = expiries[i] + TIMER_SPAN / 10;
+			timer_wheel_add(&wheel, &entries[i]);
+		}
+		move += _now() - start;
+
+		start = _now();
+		for (i = 0; i < TIMER_COUNT; i += 2)
+			timer_wheel_remove(&wheel, &entries[i]);
+		remove += _now() - start;
+
+		/* Periodic tick until the wheel is empty */
+		start = _now();
+		for (now = 0; timer_wheel_next_expiry(&wheel) != TIMER_WHEEL_NEVER;
+		     now += TICK)
+			timer_wheel_advance(&wheel, now);
+		expire += _now() - start;
+		assert(call_count == TIMER_COUNT / 2);
+	}
+
+	_report("wheel add", TIMER_COUNT, iterations, add);
+	_report("wheel move", TIMER_COUNT, iterations, move);
+	_report("wheel remove", TIMER_COUNT / 2, iterations, remove);
+	_report("wheel expire (1 ms tick)", TIMER_COUNT / 2, iterations, expire);
+}
+
+static void _bench_list(uint32_t iterations)
+{
+	struct _timer_wheel_entry* head;
+	struct _timer_wheel_entry* entry;
+	double add = 0, expire = 0, start;
+	uint32_t it, i;
+	uint64_t now;
+
+	for (it = 0; it < iterations; it++) {
+		head = NULL;
+		call_count = 0;
+
+		start = _now();
+		for (i = 0; i < TIMER_COUNT; i++) {
+			entries[i].expires = expiries[i];
+			_list_insert(&head, &entries[i]);
+		}
+		add += _now() - start;
+
+		start = _now();
+		for (now = 0; head; now += TICK) {
+			while ((entry = head) != NULL && entry->expires <= now) {
+				head = entry->next;
+				callback_call(&entry->callback, entry);
+			}
+		}
+		expire += _now() - start;
+		assert(call_count == TIMER_COUNT);
+	}
+
+	_report("sorted list add", TIMER_COUNT, iterations, add);
+	_report("sorted list expire", TIMER_COUNT, iterations, expire);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+	uint32_t iterations = argc > 1 ? strtoul(argv[1], NULL, 0) : 20;
+	uint32_t i;
+
+	srand(1);
+	for (i = 0; i < TIMER_COUNT; i++) {
+		expiries[i] = 1 + (uint64_t)rand() % TIMER_SPAN;
+		callback_set(&entries[i].callback, _callback, NULL);
+	}
+
+	_bench_wheel(iterations);
+	_bench_list(iterations);
+	return 0;
+}
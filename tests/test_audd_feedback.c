@@ -0,0 +1,280 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * USB audio feedback clock drift simulation. The host sends a packet per
+ * ms frame, sized from the feedback value it reads every refresh period,
+ * to a device that handles the packets as the USB speaker example does: a
+ * ring of packet buffers played one after the other by a codec whose clock
+ * drifts from the SOF clock. The controller must keep the ring around its
+ * target level without underruns nor overruns, while the same host with a
+ * fixed nominal rate runs into them.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "usb/device/audio/audd_feedback.h"
+#include "usb/device/usbd.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define SAMPLE_RATE       48000
+#define FRAME_SAMPLES     (SAMPLE_RATE / 1000)
+
+/* Same ring as the USB speaker example */
+#define BUFFERS           32
+#define BUFFER_THRESHOLD  8
+#define FEEDBACK_TARGET   (BUFFER_THRESHOLD * FRAME_SAMPLES)
+#define FEEDBACK_REFRESH  5
+
+/* One minute, the level is checked once the controller has settled */
+#define SIM_FRAMES        60000
+#define SETTLE_FRAMES     20000
+
+struct _sim_result {
+	unsigned underruns;
+	unsigned overruns;
+	uint32_t min_level;
+	uint32_t max_level;
+	double rate;            /* samples per ms sent once settled */
+};
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint32_t sof_frame;
+static bool high_speed;
+
+static AUDDFeedback feedback;
+
+/** Packet ring of the device */
+static struct {
+	uint32_t samples[BUFFERS];
+	uint32_t rx;
+	uint32_t tx;
+	uint32_t count;
+	uint32_t level;
+	bool playing;
+	uint32_t playing_size;
+	double play_end;        /* ms, in SOF time */
+	double codec_rate;      /* samples per ms, in SOF time */
+	unsigned underruns;
+	unsigned overruns;
+} ring;
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+/* USB device stubs */
+
+uint16_t usbd_get_frame_number(void)
+{
+	/* 125us units, microframe 0 */
+	return (uint16_t)(sof_frame * 8);
+}
+
+bool usbd_is_high_speed(void)
+{
+	return high_speed;
+}
+
+/** Hands the oldest packet to the codec, or stops playing on underrun */
+static void _play_next(double time)
+{
+	uint32_t index;
+
+	if (ring.count == 0) {
+		ring.underruns++;
+		ring.playing = false;
+		return;
+	}
+
+	index = ring.tx;
+	ring.tx = (ring.tx + 1) % BUFFERS;
+	ring.count--;
+	ring.level -= ring.samples[index];
+	ring.playing_size = ring.samples[index];
+	ring.play_end = time + ring.playing_size / ring.codec_rate;
+}
+
+/** Stores a received packet and updates the feedback */
+static void _receive(uint32_t samples)
+{
+	/* Keep one buffer for the DAC and one for the USB */
+	if (ring.count >= BUFFERS - 2) {
+		ring.level -= ring.samples[ring.tx];
+		ring.tx = (ring.tx + 1) % BUFFERS;
+		ring.count--;
+		ring.overruns++;
+	}
+
+	ring.samples[ring.rx] = samples;
+	ring.rx = (ring.rx + 1) % BUFFERS;
+	ring.count++;
+	ring.level += samples;
+
+	audd_feedback_update(&feedback, ring.level);
+
+	if (ring.count >= BUFFER_THRESHOLD && !ring.playing) {
+		ring.playing = true;
+		_play_next(sof_frame);
+	}
+}
+
+/** Decodes the feedback packet as the host does, in samples per ms */
+static double _host_decode(void)
+{
+	uint8_t packet[AUDD_FEEDBACK_MAX_SIZE];
+	uint32_t size = audd_feedback_encode(&feedback, packet);
+	uint32_t value = packet[0] | (packet[1] << 8) | (packet[2] << 16);
+
+	if (high_speed) {
+		/* 16.16 samples per microframe */
+		assert(size == 4);
+		value |= (uint32_t)packet[3] << 24;
+		return value * 8.0 / 65536.0;
+	} else {
+		/* 10.14 samples per frame */
+		assert(size == 3);
+		return value / 16384.0;
+	}
+}
+
+static void _simulate(int ppm, bool hs, bool closed_loop,
+		struct _sim_result *result)
+{
+	double host_rate = FRAME_SAMPLES;
+	double fraction = 0.0;
+	uint64_t sent = 0;
+	uint32_t samples;
+
+	memset(&ring, 0, sizeof(ring));
+	ring.codec_rate = FRAME_SAMPLES * (1.0 + ppm * 1e-6);
+	high_speed = hs;
+	sof_frame = 0;
+	audd_feedback_initialize(&feedback, SAMPLE_RATE, FEEDBACK_TARGET,
+			FEEDBACK_REFRESH);
+
+	result->min_level = UINT32_MAX;
+	result->max_level = 0;
+
+	for (sof_frame = 0; sof_frame < SIM_FRAMES; sof_frame++) {
+		/* Packets played by the codec before this SOF */
+		while (ring.playing && ring.play_end <= sof_frame) {
+			audd_feedback_consumed(&feedback, ring.playing_size);
+			_play_next(ring.play_end);
+		}
+
+		/* The host polls the feedback endpoint every refresh period */
+		if (closed_loop && sof_frame % (1 << FEEDBACK_REFRESH) == 0)
+			host_rate = _host_decode();
+		fraction += host_rate;
+		samples = (uint32_t)fraction;
+		fraction -= samples;
+		_receive(samples);
+
+		if (sof_frame >= SETTLE_FRAMES) {
+			sent += samples;
+			if (ring.level < result->min_level)
+				result->min_level = ring.level;
+			if (ring.level > result->max_level)
+				result->max_level = ring.level;
+		}
+	}
+
+	result->underruns = ring.underruns;
+	result->overruns = ring.overruns;
+	result->rate = (double)sent / (SIM_FRAMES - SETTLE_FRAMES);
+}
+
+static void test_drift(void)
+{
+	static const int drifts[] = { -2000, -500, 0, 500, 2000 };
+	struct _sim_result result;
+	double codec_rate;
+	unsigned i, hs;
+
+	for (hs = 0; hs < 2; hs++) {
+		for (i = 0; i < sizeof(drifts) / sizeof(drifts[0]); i++) {
+			_simulate(drifts[i], hs, true, &result);
+			codec_rate = FRAME_SAMPLES * (1.0 + drifts[i] * 1e-6);
+			printf("%s %+5d ppm: level %u..%u (target %u), "
+				"%.4f samples/ms for %.4f\n",
+				hs ? "high-speed" : "full-speed", drifts[i],
+				(unsigned)result.min_level,
+				(unsigned)result.max_level, FEEDBACK_TARGET,
+				result.rate, codec_rate);
+
+			assert(result.underruns == 0);
+			assert(result.overruns == 0);
+
+			/* The host follows the codec clock and the ring
+			 * stays within a few packets of the target */
+			assert(result.rate > codec_rate * (1.0 - 50e-6));
+			assert(result.rate < codec_rate * (1.0 + 50e-6));
+			assert(result.min_level + 4 * FRAME_SAMPLES
+					>= FEEDBACK_TARGET);
+			assert(result.max_level
+					<= FEEDBACK_TARGET + 4 * FRAME_SAMPLES);
+		}
+	}
+}
+
+static void test_open_loop(void)
+{
+	struct _sim_result result;
+
+	/* Without feedback, the drift drains or fills the ring */
+	_simulate(2000, false, false, &result);
+	assert(result.underruns > 0);
+	_simulate(-2000, false, false, &result);
+	assert(result.overruns > 0);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	test_drift();
+	test_open_loop();
+	return 0;
+}
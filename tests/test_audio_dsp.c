@@ -0,0 +1,386 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Capture DSP chain harness, fed with WAV files. Without arguments, test
+ * signals are built as WAV images and run through the chain in 10 ms
+ * blocks, as the audio recorder example does, to check the DC blocking,
+ * the beamformer alignment, the AGC level and the 32-bit input format.
+ *
+ * With arguments, a 16-bit PCM WAV file of up to AUDIO_DSP_MAX_CHANNELS
+ * microphones is processed with the chain of the recorder example, and
+ * the mono result is written as a WAV file:
+ *
+ *   test_audio_dsp input.wav output.wav
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio/audio_dsp.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define SAMPLE_RATE    48000
+#define BLOCK_FRAMES   (SAMPLE_RATE / 100)
+#define SIGNAL_FRAMES  (2 * SAMPLE_RATE)
+
+#define WAV_HEADER_SIZE 44
+
+struct _wav {
+	uint32_t sample_rate;
+	uint16_t num_channels;
+	uint32_t frames;
+	const int16_t *samples;
+};
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+/* rumble filter of the recorder example */
+static const struct _audio_biquad rumble_filter[] = {
+	{ 16158, -32316, 16158, -32313, 15935 },
+};
+
+static const struct _audio_dsp_config recorder_config = {
+	.num_channels = 1,
+	.bits_per_sample = 16,
+	.dc_pole = 32604,
+	.biquads = rumble_filter,
+	.num_biquads = 1,
+	.agc_target = 16000,
+	.agc_min_gain = AUDIO_DSP_AGC_UNITY / 4,
+	.agc_max_gain = AUDIO_DSP_AGC_UNITY * 8,
+	.agc_attack_shift = 6,
+	.agc_release_shift = 13,
+};
+
+static struct _audio_dsp dsp;
+
+static uint8_t wav_image[WAV_HEADER_SIZE +
+	SIGNAL_FRAMES * AUDIO_DSP_MAX_CHANNELS * sizeof(int16_t)];
+static int16_t output[SIGNAL_FRAMES];
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t _le16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static void _put_le32(uint8_t *p, uint32_t value)
+{
+	p[0] = value;
+	p[1] = value >> 8;
+	p[2] = value >> 16;
+	p[3] = value >> 24;
+}
+
+static void _put_le16(uint8_t *p, uint16_t value)
+{
+	p[0] = value;
+	p[1] = value >> 8;
+}
+
+static void _wav_header(uint8_t *header, uint32_t sample_rate,
+		uint16_t num_channels, uint32_t frames)
+{
+	uint32_t data_size = frames * num_channels * sizeof(int16_t);
+
+	memcpy(header, "RIFF", 4);
+	_put_le32(header + 4, 36 + data_size);
+	memcpy(header + 8, "WAVEfmt ", 8);
+	_put_le32(header + 16, 16);
+	_put_le16(header + 20, 1);
+	_put_le16(header + 22, num_channels);
+	_put_le32(header + 24, sample_rate);
+	_put_le32(header + 28, sample_rate * num_channels * sizeof(int16_t));
+	_put_le16(header + 32, num_channels * sizeof(int16_t));
+	_put_le16(header + 34, 16);
+	memcpy(header + 36, "data", 4);
+	_put_le32(header + 40, data_size);
+}
+
+/** Parses a 16-bit PCM WAV image, skipping the chunks it does not use */
+static int _wav_parse(const uint8_t *image, uint32_t size, struct _wav *wav)
+{
+	uint32_t pos = 12, chunk;
+	bool fmt = false;
+
+	if (size < 12 || memcmp(image, "RIFF", 4) || memcmp(image + 8, "WAVE", 4))
+		return -1;
+
+	while (pos + 8 <= size) {
+		chunk = _le32(image + pos + 4);
+		if (!memcmp(image + pos, "fmt ", 4) && chunk >= 16) {
+			if (_le16(image + pos + 8) != 1 ||
+			    _le16(image + pos + 22) != 16)
+				return -1;
+			wav->num_channels = _le16(image + pos + 10);
+			wav->sample_rate = _le32(image + pos + 12);
+			fmt = true;
+		} else if (!memcmp(image + pos, "data", 4) && fmt) {
+			if (chunk > size - pos - 8)
+				chunk = size - pos - 8;
+			wav->samples = (const int16_t*)(image + pos + 8);
+			wav->frames = chunk / (wav->num_channels * sizeof(int16_t));
+			return 0;
+		}
+		pos += 8 + chunk + (chunk & 1);
+	}
+	return -1;
+}
+
+/** Runs the chain over the WAV data in 10 ms blocks */
+static uint32_t _process(const struct _wav *wav, int16_t *out)
+{
+	uint32_t frame_size = wav->num_channels * sizeof(int16_t);
+	uint32_t done = 0, frames;
+
+	while (done < wav->frames) {
+		frames = wav->frames - done;
+		if (frames > BLOCK_FRAMES)
+			frames = BLOCK_FRAMES;
+		assert(audio_dsp_process(&dsp, wav->samples + done *
+				wav->num_channels, frames * frame_size,
+				out + done) == frames);
+		done += frames;
+	}
+	return done;
+}
+
+/** Builds a WAV image of a tone plus an offset on every channel, delayed
+ * by delays[c] samples on channel c */
+static void _build_tone(struct _wav *wav, uint16_t num_channels,
+		double frequency, double amplitude, double offset,
+		const uint8_t *delays)
+{
+	int16_t *samples = (int16_t*)(wav_image + WAV_HEADER_SIZE);
+	uint32_t i, c;
+
+	for (i = 0; i < SIGNAL_FRAMES; i++) {
+		for (c = 0; c < num_channels; c++) {
+			double t = (double)i - (delays ? delays[c] : 0);
+			samples[i * num_channels + c] = (int16_t)lrint(offset +
+				amplitude * sin(2.0 * M_PI * frequency * t /
+					SAMPLE_RATE));
+		}
+	}
+	_wav_header(wav_image, SAMPLE_RATE, num_channels, SIGNAL_FRAMES);
+	assert(_wav_parse(wav_image, sizeof(wav_image), wav) == 0);
+	assert(wav->frames == SIGNAL_FRAMES);
+}
+
+/** Mean and peak of the output over its second half */
+static void _measure(double *mean, int32_t *peak)
+{
+	double sum = 0;
+	uint32_t i;
+
+	*peak = 0;
+	for (i = SIGNAL_FRAMES / 2; i < SIGNAL_FRAMES; i++) {
+		sum += output[i];
+		if (abs(output[i]) > *peak)
+			*peak = abs(output[i]);
+	}
+	*mean = sum / (SIGNAL_FRAMES / 2);
+}
+
+static void test_dc_block(void)
+{
+	struct _audio_dsp_config cfg = { .num_channels = 1,
+		.bits_per_sample = 16, .dc_pole = 32604 };
+	struct _wav wav;
+	double mean;
+	int32_t peak;
+
+	/* a negative offset drives the filter input below zero */
+	assert(audio_dsp_init(&dsp, &cfg) == 0);
+	_build_tone(&wav, 1, 1000.0, 8000.0, -6000.0, NULL);
+	_process(&wav, output);
+	_measure(&mean, &peak);
+	assert(fabs(mean) < 1.0);
+	assert(peak > 7900 && peak < 8100);
+	assert(dsp.clipped == 0);
+}
+
+static void test_beamformer(void)
+{
+	struct _audio_dsp_config cfg = { .num_channels = 2,
+		.bits_per_sample = 16 };
+	static const uint8_t delays[] = { 0, 15 };
+	struct _wav wav;
+	double mean;
+	int32_t peak;
+
+	/* channel 1 lags by 15 samples, half a period at 1600 Hz: the sum
+	 * cancels unless channel 0 is delayed as much */
+	_build_tone(&wav, 2, 1600.0, 10000.0, 0.0, delays);
+
+	assert(audio_dsp_init(&dsp, &cfg) == 0);
+	_process(&wav, output);
+	_measure(&mean, &peak);
+	assert(peak < 200);
+
+	cfg.delays[0] = 15;
+	assert(audio_dsp_init(&dsp, &cfg) == 0);
+	_process(&wav, output);
+	_measure(&mean, &peak);
+	assert(peak > 9900 && peak <= 10001);
+}
+
+static void test_agc(void)
+{
+	struct _wav wav;
+	double mean;
+	int32_t peak;
+
+	/* a quiet tone is brought to the target level */
+	assert(audio_dsp_init(&dsp, &recorder_config) == 0);
+	_build_tone(&wav, 1, 1000.0, 2500.0, 0.0, NULL);
+	_process(&wav, output);
+	_measure(&mean, &peak);
+	assert(peak > 15000 && peak < 17000);
+	assert(dsp.clipped == 0);
+
+	/* a loud one is attenuated down to it */
+	_build_tone(&wav, 1, 1000.0, 30000.0, 0.0, NULL);
+	_process(&wav, output);
+	_measure(&mean, &peak);
+	assert(peak > 15000 && peak < 17000);
+}
+
+static void test_32bit_input(void)
+{
+	static int32_t samples[SIGNAL_FRAMES];
+	static int16_t reference[SIGNAL_FRAMES];
+	struct _audio_dsp_config cfg = recorder_config;
+	struct _wav wav;
+	uint32_t i;
+
+	_build_tone(&wav, 1, 440.0, 12000.0, 300.0, NULL);
+	assert(audio_dsp_init(&dsp, &cfg) == 0);
+	_process(&wav, reference);
+
+	/* left-aligned 16-bit data with noise in the low bits */
+	for (i = 0; i < SIGNAL_FRAMES; i++)
+		samples[i] = (int32_t)((uint32_t)(int32_t)wav.samples[i] << 16)
+			| (i & 0xffff);
+	cfg.bits_per_sample = 32;
+	assert(audio_dsp_init(&dsp, &cfg) == 0);
+	assert(audio_dsp_process(&dsp, samples, sizeof(samples), output)
+			== SIGNAL_FRAMES);
+	assert(memcmp(output, reference, sizeof(output)) == 0);
+}
+
+static int _process_file(const char *input, const char *output_path)
+{
+	struct _audio_dsp_config cfg = recorder_config;
+	uint8_t header[WAV_HEADER_SIZE];
+	uint8_t *image;
+	int16_t *out;
+	struct _wav wav;
+	FILE *file;
+	long size;
+
+	file = fopen(input, "rb");
+	if (!file || fseek(file, 0, SEEK_END) || (size = ftell(file)) < 0) {
+		perror(input);
+		return 1;
+	}
+	rewind(file);
+	image = malloc(size);
+	assert(image);
+	if (fread(image, 1, size, file) != (size_t)size) {
+		perror(input);
+		return 1;
+	}
+	fclose(file);
+
+	if (_wav_parse(image, size, &wav) ||
+	    wav.num_channels > AUDIO_DSP_MAX_CHANNELS) {
+		fprintf(stderr, "%s: not a 16-bit PCM WAV file of up to %d "
+			"channels\n", input, AUDIO_DSP_MAX_CHANNELS);
+		return 1;
+	}
+
+	cfg.num_channels = wav.num_channels;
+	assert(audio_dsp_init(&dsp, &cfg) == 0);
+	out = malloc(wav.frames * sizeof(int16_t) + 1);
+	assert(out);
+	_process(&wav, out);
+
+	_wav_header(header, wav.sample_rate, 1, wav.frames);
+	file = fopen(output_path, "wb");
+	if (!file || fwrite(header, 1, sizeof(header), file) != sizeof(header) ||
+	    fwrite(out, sizeof(int16_t), wav.frames, file) != wav.frames ||
+	    fclose(file)) {
+		perror(output_path);
+		return 1;
+	}
+	printf("%u frames, %u samples clipped\n", (unsigned)wav.frames,
+	       (unsigned)dsp.clipped);
+
+	free(out);
+	free(image);
+	return 0;
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+	if (argc == 3)
+		return _process_file(argv[1], argv[2]);
+
+	test_dc_block();
+	test_beamformer();
+	test_agc();
+	test_32bit_input();
+	return 0;
+}
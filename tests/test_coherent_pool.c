@@ -0,0 +1,205 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Coherent pool test. coherent_pool.c is included to reset the pool between
+ * the cases. The MMU is replaced by a stub that records the remapping
+ * requests. The pool must be remapped exactly once, even when the first
+ * allocations race, a failed remapping must be retried by the next call,
+ * and allocations must be aligned, disjoint and inside the pool.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mm/coherent_pool.c"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define THREAD_COUNT 4
+#define THREAD_ALLOCS 64
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static int remap_error;
+static uint32_t remap_calls;
+
+static pthread_barrier_t start_barrier;
+
+static struct {
+	uint8_t* ptr;
+	uint32_t size;
+	uint32_t align;
+} allocs[THREAD_COUNT * THREAD_ALLOCS];
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+int mmu_set_region_attrs(uint32_t start, uint32_t size, enum _mmu_attr attr)
+{
+	assert(start == (uint32_t)_pool && size == sizeof(_pool));
+	assert((start | size) % MMU_PAGE_SIZE == 0);
+	assert(attr == MMU_ATTR_WRITE_COMBINE);
+	remap_calls++;
+	/* The remapping is slow on the target: widen the race window */
+	usleep(1000);
+	return remap_error;
+}
+
+static void _reset(void)
+{
+	_pool_ready = false;
+	_pool_used = 0;
+	remap_calls = 0;
+	remap_error = 0;
+}
+
+static void test_remap_failure(void)
+{
+	_reset();
+
+	remap_error = -ENOMEM;
+	assert(coherent_pool_init() == -ENOMEM);
+	assert(coherent_alloc(16, 0) == NULL);
+	assert(remap_calls == 2);
+	assert(coherent_pool_get_free() == COHERENT_POOL_SIZE);
+
+	/* Retried until it succeeds, then never again */
+	remap_error = 0;
+	assert(coherent_alloc(16, 0) == _pool);
+	assert(coherent_pool_init() == 0);
+	assert(coherent_alloc(16, 0) == _pool + 16);
+	assert(remap_calls == 3);
+}
+
+static void test_alloc(void)
+{
+	uint8_t* p;
+
+	_reset();
+
+	/* Word alignment by default */
+	assert(coherent_alloc(1, 0) == _pool);
+	assert(coherent_alloc(1, 1) == _pool + 4);
+	assert(coherent_alloc(3, 64) == _pool + 64);
+	assert(coherent_pool_get_free() == COHERENT_POOL_SIZE - 67);
+
+	/* Too large, or too large once aligned */
+	assert(coherent_alloc(COHERENT_POOL_SIZE, 0) == NULL);
+	p = coherent_alloc(COHERENT_POOL_SIZE - 128, 0);
+	assert(p == _pool + 68);
+	assert(coherent_alloc(32, 64) == NULL);
+	assert(coherent_alloc(60, 4) == _pool + COHERENT_POOL_SIZE - 60);
+	assert(coherent_pool_get_free() == 0);
+	assert(coherent_alloc(0, 0) == _pool + COHERENT_POOL_SIZE);
+	assert(coherent_alloc(1, 0) == NULL);
+	assert(remap_calls == 1);
+}
+
+static void* _alloc_thread(void* arg)
+{
+	uint32_t first = (uint32_t)(uintptr_t)arg * THREAD_ALLOCS;
+	uint32_t i;
+
+	/* All the threads make the first allocation together */
+	pthread_barrier_wait(&start_barrier);
+	for (i = first; i < first + THREAD_ALLOCS; i++) {
+		allocs[i].size = 1 + (i * 37) % 200;
+		allocs[i].align = 1u << (i % 7);
+		allocs[i].ptr = coherent_alloc(allocs[i].size, allocs[i].align);
+		assert(allocs[i].ptr);
+		memset(allocs[i].ptr, i, allocs[i].size);
+	}
+	return NULL;
+}
+
+static int _compare_allocs(const void* a, const void* b)
+{
+	const uint8_t* pa = *(uint8_t* const*)a;
+	const uint8_t* pb = *(uint8_t* const*)b;
+
+	return (pa > pb) - (pa < pb);
+}
+
+/** Concurrent first allocations remap the pool once and never overlap */
+static void test_concurrent(void)
+{
+	pthread_t threads[THREAD_COUNT];
+	uint32_t i, used = 0;
+
+	_reset();
+	assert(pthread_barrier_init(&start_barrier, NULL, THREAD_COUNT) == 0);
+	for (i = 0; i < THREAD_COUNT; i++)
+		assert(pthread_create(&threads[i], NULL, _alloc_thread,
+				      (void*)(uintptr_t)i) == 0);
+	for (i = 0; i < THREAD_COUNT; i++)
+		assert(pthread_join(threads[i], NULL) == 0);
+	pthread_barrier_destroy(&start_barrier);
+
+	assert(remap_calls == 1);
+
+	qsort(allocs, ARRAY_SIZE(allocs), sizeof(allocs[0]), _compare_allocs);
+	for (i = 0; i < ARRAY_SIZE(allocs); i++) {
+		uint32_t align = allocs[i].align < 4 ? 4 : allocs[i].align;
+
+		assert(((uintptr_t)allocs[i].ptr & (align - 1)) == 0);
+		assert(allocs[i].ptr >= _pool &&
+		       allocs[i].ptr + allocs[i].size <= _pool + sizeof(_pool));
+		if (i > 0)
+			assert(allocs[i - 1].ptr + allocs[i - 1].size <= allocs[i].ptr);
+		used = allocs[i].ptr + allocs[i].size - _pool;
+	}
+	assert(coherent_pool_get_free() == COHERENT_POOL_SIZE - used);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	test_remap_failure();
+	test_alloc();
+	test_concurrent();
+	return 0;
+}
@@ -0,0 +1,732 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * JPEG encoder test. Images are encoded and decoded back by a minimal
+ * baseline decoder written from the specification, independent of the
+ * encoder: it reads the quantization and Huffman tables from the stream,
+ * and uses a floating point inverse DCT. The luma PSNR must increase with
+ * the quality and stay above fixed limits, odd sizes must decode to the
+ * right dimensions, the output must not depend on how the image is split
+ * into strips, and invalid calls or short buffers must be reported.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errno.h"
+
+#include "jpeg/jpeg_enc.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define MAX_WIDTH   128
+#define MAX_HEIGHT  72
+
+#define OUT_SIZE    (64 * 1024)
+
+/*----------------------------------------------------------------------------
+ *         Local types
+ *----------------------------------------------------------------------------*/
+
+/** Canonical Huffman decoding table (Annex F.2.2.3) */
+struct _huff {
+	int32_t maxcode[17];
+	int32_t valptr[17];
+	uint16_t mincode[17];
+	uint8_t vals[256];
+	bool defined;
+};
+
+struct _component {
+	uint8_t id;
+	uint8_t h, v;
+	uint8_t tq;
+	uint8_t td, ta;
+	int32_t pred;
+	/* Decoded samples, padded to whole MCUs */
+	uint32_t stride;
+	uint8_t *plane;
+};
+
+struct _decoder {
+	const uint8_t *data;
+	uint32_t size;
+	uint32_t pos;
+
+	uint32_t bits;
+	uint8_t nbits;
+
+	uint16_t qt[4][64];
+	struct _huff huff[2][4];
+
+	uint16_t width, height;
+	uint8_t ncomps;
+	struct _component comp[3];
+	uint8_t hmax, vmax;
+};
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static const uint8_t zigzag[64] = {
+	 0,  1,  8, 16,  9,  2,  3, 10,
+	17, 24, 32, 25, 18, 11,  4,  5,
+	12, 19, 26, 33, 40, 48, 41, 34,
+	27, 20, 13,  6,  7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36,
+	29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46,
+	53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+static uint8_t image[MAX_WIDTH * MAX_HEIGHT * 2];
+static uint8_t out[OUT_SIZE];
+static uint8_t ref[OUT_SIZE];
+
+static struct _decoder dec;
+static uint8_t planes[3][(MAX_WIDTH + 16) * (MAX_HEIGHT + 16)];
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint16_t _get_word(const uint8_t *p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static void _parse_dqt(const uint8_t *p, uint32_t len)
+{
+	int i;
+
+	while (len) {
+		uint8_t t = p[0] & 0xf;
+
+		/* Baseline: 8-bit precision only */
+		assert((p[0] >> 4) == 0 && t < 4 && len >= 65);
+		for (i = 0; i < 64; i++)
+			dec.qt[t][zigzag[i]] = p[1 + i];
+		p += 65;
+		len -= 65;
+	}
+}
+
+static void _parse_dht(const uint8_t *p, uint32_t len)
+{
+	while (len) {
+		uint8_t tc = p[0] >> 4, th = p[0] & 0xf;
+		struct _huff *h;
+		uint32_t count = 0, k = 0;
+		uint16_t code = 0;
+		int l;
+
+		assert(tc < 2 && th < 4 && len >= 17);
+		h = &dec.huff[tc][th];
+		for (l = 1; l <= 16; l++)
+			count += p[l];
+		assert(count <= 256 && len >= 17 + count);
+		memcpy(h->vals, p + 17, count);
+		for (l = 1; l <= 16; l++) {
+			if (p[l]) {
+				h->valptr[l] = k;
+				h->mincode[l] = code;
+				code += p[l];
+				k += p[l];
+				h->maxcode[l] = code - 1;
+			} else {
+				h->maxcode[l] = -1;
+			}
+			code <<= 1;
+		}
+		h->defined = true;
+		p += 17 + count;
+		len -= 17 + count;
+	}
+}
+
+static void _parse_sof(const uint8_t *p, uint32_t len)
+{
+	uint8_t i;
+
+	assert(p[0] == 8);
+	dec.height = _get_word(p + 1);
+	dec.width = _get_word(p + 3);
+	dec.ncomps = p[5];
+	assert(dec.ncomps == 1 || dec.ncomps == 3);
+	assert(len == 6u + 3 * dec.ncomps);
+	dec.hmax = dec.vmax = 1;
+	for (i = 0; i < dec.ncomps; i++) {
+		struct _component *c = &dec.comp[i];
+
+		c->id = p[6 + 3 * i];
+		c->h = p[7 + 3 * i] >> 4;
+		c->v = p[7 + 3 * i] & 0xf;
+		c->tq = p[8 + 3 * i];
+		if (c->h > dec.hmax)
+			dec.hmax = c->h;
+		if (c->v > dec.vmax)
+			dec.vmax = c->v;
+	}
+}
+
+static void _parse_sos(const uint8_t *p, uint32_t len)
+{
+	uint8_t i, j;
+
+	/* Single interleaved scan of all the components */
+	assert(p[0] == dec.ncomps && len == 4u + 2 * dec.ncomps);
+	for (i = 0; i < dec.ncomps; i++) {
+		for (j = 0; j < dec.ncomps; j++)
+			if (dec.comp[j].id == p[1 + 2 * i])
+				break;
+		assert(j == i);
+		dec.comp[i].td = p[2 + 2 * i] >> 4;
+		dec.comp[i].ta = p[2 + 2 * i] & 0xf;
+	}
+	/* Whole spectrum, no successive approximation */
+	assert(p[1 + 2 * dec.ncomps] == 0);
+	assert(p[2 + 2 * dec.ncomps] == 63);
+	assert(p[3 + 2 * dec.ncomps] == 0);
+}
+
+static uint32_t _get_bit(void)
+{
+	if (!dec.nbits) {
+		uint8_t byte;
+
+		assert(dec.pos < dec.size);
+		byte = dec.data[dec.pos++];
+		if (byte == 0xff) {
+			/* Stuffed zero, no marker may appear in the scan */
+			assert(dec.pos < dec.size && dec.data[dec.pos] == 0);
+			dec.pos++;
+		}
+		dec.bits = byte;
+		dec.nbits = 8;
+	}
+	dec.nbits--;
+	return (dec.bits >> dec.nbits) & 1;
+}
+
+static int32_t _receive_extend(uint8_t s)
+{
+	int32_t v = 0;
+	uint8_t i;
+
+	for (i = 0; i < s; i++)
+		v = (v << 1) | _get_bit();
+	if (s && v < (1 << (s - 1)))
+		v += 1 - (1 << s);
+	return v;
+}
+
+static uint8_t _decode_symbol(const struct _huff *h)
+{
+	int32_t code = _get_bit();
+	int l = 1;
+
+	assert(h->defined);
+	while (code > h->maxcode[l]) {
+		code = (code << 1) | _get_bit();
+		l++;
+		assert(l <= 16);
+	}
+	return h->vals[h->valptr[l] + code - h->mincode[l]];
+}
+
+/**
+ * Reference inverse DCT of Annex A.3.3, in floating point
+ */
+static void _idct(const int32_t *coefs, uint8_t *dst, uint32_t stride)
+{
+	static double cos_table[8][8];
+	static bool ready;
+	double tmp[64];
+	int x, y, u;
+
+	if (!ready) {
+		for (x = 0; x < 8; x++)
+			for (u = 0; u < 8; u++)
+				cos_table[x][u] = (u ? 1.0 : M_SQRT1_2) / 2 *
+					cos((2 * x + 1) * u * M_PI / 16);
+		ready = true;
+	}
+
+	/* Columns, then rows */
+	for (y = 0; y < 8; y++)
+		for (x = 0; x < 8; x++) {
+			double s = 0;
+
+			for (u = 0; u < 8; u++)
+				s += cos_table[y][u] * coefs[u * 8 + x];
+			tmp[y * 8 + x] = s;
+		}
+	for (y = 0; y < 8; y++)
+		for (x = 0; x < 8; x++) {
+			double s = 0;
+			long v;
+
+			for (u = 0; u < 8; u++)
+				s += cos_table[x][u] * tmp[y * 8 + u];
+			v = lround(s) + 128;
+			dst[y * stride + x] = v < 0 ? 0 : v > 255 ? 255 : v;
+		}
+}
+
+static void _decode_block(struct _component *c, uint8_t *dst)
+{
+	const uint16_t *qt = dec.qt[c->tq];
+	int32_t coefs[64];
+	uint8_t s, r;
+	int k;
+
+	memset(coefs, 0, sizeof(coefs));
+
+	s = _decode_symbol(&dec.huff[0][c->td]);
+	assert(s <= 11);
+	c->pred += _receive_extend(s);
+	coefs[0] = c->pred * qt[0];
+
+	for (k = 1; k < 64; k++) {
+		uint8_t rs = _decode_symbol(&dec.huff[1][c->ta]);
+
+		r = rs >> 4;
+		s = rs & 0xf;
+		if (!s) {
+			if (r != 15)
+				break;
+			k += 15;
+			continue;
+		}
+		k += r;
+		assert(k < 64);
+		coefs[zigzag[k]] = _receive_extend(s) * qt[zigzag[k]];
+	}
+
+	_idct(coefs, dst, c->stride);
+}
+
+/**
+ * Decode a baseline JFIF stream into dec.comp[].plane, one sample per
+ * block pixel of each component
+ */
+static void _decode(const uint8_t *data, uint32_t size)
+{
+	uint32_t mcux, mcuy, mx, my;
+	bool eoi = false;
+	uint8_t i, bx, by;
+
+	memset(&dec, 0, sizeof(dec));
+	dec.data = data;
+	dec.size = size;
+
+	assert(size >= 4 && _get_word(data) == 0xffd8);
+	dec.pos = 2;
+	while (!eoi) {
+		uint16_t marker, len;
+		const uint8_t *p;
+
+		assert(dec.pos + 4 <= size);
+		marker = _get_word(data + dec.pos);
+		len = _get_word(data + dec.pos + 2);
+		assert(len >= 2 && dec.pos + 2 + len <= size);
+		p = data + dec.pos + 4;
+		dec.pos += 2 + len;
+
+		switch (marker) {
+		case 0xffe0:
+			assert(len >= 7 && !memcmp(p, "JFIF", 5));
+			break;
+		case 0xffdb:
+			_parse_dqt(p, len - 2);
+			break;
+		case 0xffc4:
+			_parse_dht(p, len - 2);
+			break;
+		case 0xffc0:
+			_parse_sof(p, len - 2);
+			break;
+		case 0xffda:
+			_parse_sos(p, len - 2);
+			eoi = true;
+			break;
+		default:
+			assert(0);
+		}
+	}
+
+	mcux = (dec.width + 8 * dec.hmax - 1) / (8 * dec.hmax);
+	mcuy = (dec.height + 8 * dec.vmax - 1) / (8 * dec.vmax);
+	for (i = 0; i < dec.ncomps; i++) {
+		dec.comp[i].stride = mcux * 8 * dec.comp[i].h;
+		assert(dec.comp[i].stride * mcuy * 8 * dec.comp[i].v <=
+		       sizeof(planes[i]));
+		dec.comp[i].plane = planes[i];
+	}
+
+	for (my = 0; my < mcuy; my++)
+		for (mx = 0; mx < mcux; mx++)
+			for (i = 0; i < dec.ncomps; i++) {
+				struct _component *c = &dec.comp[i];
+
+				for (by = 0; by < c->v; by++)
+					for (bx = 0; bx < c->h; bx++) {
+						uint32_t x = (mx * c->h + bx) * 8;
+						uint32_t y = (my * c->v + by) * 8;
+
+						_decode_block(c, c->plane + y * c->stride + x);
+					}
+			}
+
+	/* Padding bits are ones, then EOI */
+	while (dec.nbits)
+		assert(_get_bit() == 1);
+	assert(dec.pos + 2 == size && _get_word(data + dec.pos) == 0xffd9);
+}
+
+/**
+ * Synthesize a test image: smooth gradients, a sharp edge and some noise
+ */
+static void _make_image(enum _jpeg_enc_format format, uint32_t width,
+		uint32_t height)
+{
+	uint32_t seed = 12345;
+	uint32_t x, y;
+
+	for (y = 0; y < height; y++)
+		for (x = 0; x < width; x++) {
+			double v = 128 + 60 * sin(x * 0.21) * cos(y * 0.17) +
+				(x > width / 2 ? 40 : -40);
+			int n;
+
+			seed = seed * 1103515245 + 12345;
+			n = (int)((seed >> 16) & 3) - 2;
+			v += n;
+			v = v < 0 ? 0 : v > 255 ? 255 : v;
+			if (format == JPEG_ENC_FORMAT_GRAY) {
+				image[y * width + x] = (uint8_t)v;
+			} else {
+				image[(y * width + x) * 2] = (uint8_t)v;
+				/* Cb on even pixels, Cr on odd ones */
+				image[(y * width + x) * 2 + 1] = (x & 1) ?
+					128 + 50 * cos(y * 0.1) :
+					128 + 50 * sin(x * 0.05);
+			}
+		}
+}
+
+static int _encode(enum _jpeg_enc_format format, uint32_t width,
+		uint32_t height, uint8_t quality, uint32_t strip,
+		uint8_t *buf, uint32_t size)
+{
+	struct _jpeg_enc enc;
+	struct _jpeg_enc_cfg cfg = {
+		.format = format,
+		.width = width,
+		.height = height,
+		.quality = quality,
+	};
+	uint32_t bpp = format == JPEG_ENC_FORMAT_GRAY ? 1 : 2;
+	uint32_t y;
+	int err;
+
+	err = jpeg_enc_start(&enc, &cfg, buf, size);
+	if (err < 0)
+		return err;
+	for (y = 0; y < height; y += strip) {
+		uint32_t lines = height - y < strip ? height - y : strip;
+
+		err = jpeg_enc_write_lines(&enc, image + y * width * bpp,
+				width * bpp, lines);
+		if (err < 0)
+			return err;
+	}
+	return jpeg_enc_finish(&enc);
+}
+
+static double _psnr(double sse, uint32_t count)
+{
+	return sse ? 10 * log10(255.0 * 255.0 * count / sse) : INFINITY;
+}
+
+static double _luma_psnr(enum _jpeg_enc_format format, uint32_t width,
+		uint32_t height)
+{
+	uint32_t bpp = format == JPEG_ENC_FORMAT_GRAY ? 1 : 2;
+	const struct _component *c = &dec.comp[0];
+	double sse = 0;
+	uint32_t x, y;
+
+	for (y = 0; y < height; y++)
+		for (x = 0; x < width; x++) {
+			double d = (double)c->plane[y * c->stride + x] -
+				image[(y * width + x) * bpp];
+			sse += d * d;
+		}
+	return _psnr(sse, width * height);
+}
+
+static double _chroma_psnr(uint32_t width, uint32_t height)
+{
+	double sse = 0;
+	uint32_t x, y, i;
+
+	for (i = 1; i < 3; i++) {
+		const struct _component *c = &dec.comp[i];
+
+		for (y = 0; y < height; y++)
+			for (x = 0; x < width / 2; x++) {
+				double d = (double)c->plane[y * c->stride + x] -
+					image[(y * width + 2 * x) * 2 + 2 * i - 1];
+				sse += d * d;
+			}
+	}
+	return _psnr(sse, width * height);
+}
+
+static void test_quality(void)
+{
+	static const struct {
+		uint8_t quality;
+		double luma, chroma;
+	} cases[] = {
+		{ 10, 30, 33 },
+		{ 50, 39, 42 },
+		{ 75, 41, 45 },
+		{ 90, 44, 49 },
+		{ 100, 50, 54 },
+	};
+	const uint32_t width = 120, height = 70;
+	double prev = 0;
+	unsigned i;
+
+	_make_image(JPEG_ENC_FORMAT_YUYV, width, height);
+	for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		double luma, chroma;
+		int len;
+
+		len = _encode(JPEG_ENC_FORMAT_YUYV, width, height,
+				cases[i].quality, 8, out, sizeof(out));
+		assert(len > 0);
+		_decode(out, len);
+		assert(dec.width == width && dec.height == height);
+		assert(dec.ncomps == 3 && dec.hmax == 2 && dec.vmax == 1);
+
+		luma = _luma_psnr(JPEG_ENC_FORMAT_YUYV, width, height);
+		chroma = _chroma_psnr(width, height);
+		printf("quality %3u: %5d bytes, PSNR Y %.1f dB, CbCr %.1f dB\n",
+		       cases[i].quality, len, luma, chroma);
+		assert(luma >= cases[i].luma);
+		assert(chroma >= cases[i].chroma);
+		assert(luma > prev);
+		prev = luma;
+	}
+}
+
+static void test_odd_sizes(void)
+{
+	static const struct {
+		enum _jpeg_enc_format format;
+		uint16_t width, height;
+	} cases[] = {
+		{ JPEG_ENC_FORMAT_GRAY, 1, 1 },
+		{ JPEG_ENC_FORMAT_GRAY, 7, 5 },
+		{ JPEG_ENC_FORMAT_GRAY, 17, 9 },
+		{ JPEG_ENC_FORMAT_GRAY, 33, 31 },
+		{ JPEG_ENC_FORMAT_GRAY, MAX_WIDTH - 1, MAX_HEIGHT - 1 },
+		{ JPEG_ENC_FORMAT_YUYV, 2, 1 },
+		{ JPEG_ENC_FORMAT_YUYV, 6, 7 },
+		{ JPEG_ENC_FORMAT_YUYV, 18, 9 },
+		{ JPEG_ENC_FORMAT_YUYV, 34, 31 },
+		{ JPEG_ENC_FORMAT_YUYV, MAX_WIDTH - 2, MAX_HEIGHT - 1 },
+	};
+	unsigned i;
+
+	for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		uint32_t width = cases[i].width, height = cases[i].height;
+		double luma;
+		int len;
+
+		_make_image(cases[i].format, width, height);
+		len = _encode(cases[i].format, width, height, 100, 8, out,
+				sizeof(out));
+		assert(len > 0);
+		_decode(out, len);
+		assert(dec.width == width && dec.height == height);
+		assert(dec.ncomps == (cases[i].format == JPEG_ENC_FORMAT_GRAY ? 1 : 3));
+
+		/* Edge replication must not leak into the visible samples */
+		luma = _luma_psnr(cases[i].format, width, height);
+		assert(luma >= 48);
+		if (cases[i].format == JPEG_ENC_FORMAT_YUYV)
+			assert(_chroma_psnr(width, height) >= 48);
+	}
+}
+
+static void test_strips(void)
+{
+	static const uint32_t strips[] = { 16, 24, 64, MAX_HEIGHT };
+	const uint32_t width = 120, height = 70;
+	int len, ref_len;
+	unsigned i;
+
+	/* The output only depends on the image, not on the strip size */
+	_make_image(JPEG_ENC_FORMAT_YUYV, width, height);
+	ref_len = _encode(JPEG_ENC_FORMAT_YUYV, width, height, 0, 8, ref,
+			sizeof(ref));
+	assert(ref_len > 0);
+	for (i = 0; i < sizeof(strips) / sizeof(strips[0]); i++) {
+		len = _encode(JPEG_ENC_FORMAT_YUYV, width, height, 0,
+				strips[i], out, sizeof(out));
+		assert(len == ref_len);
+		assert(!memcmp(out, ref, len));
+	}
+
+	/* Quality 0 selects the default */
+	len = _encode(JPEG_ENC_FORMAT_YUYV, width, height,
+			JPEG_ENC_QUALITY_DEFAULT, 8, out, sizeof(out));
+	assert(len == ref_len && !memcmp(out, ref, len));
+}
+
+static void test_invalid(void)
+{
+	struct _jpeg_enc enc;
+	struct _jpeg_enc_cfg cfg = {
+		.format = JPEG_ENC_FORMAT_YUYV,
+		.width = 120,
+		.height = 70,
+	};
+	const uint32_t stride = 2 * cfg.width;
+
+	_make_image(JPEG_ENC_FORMAT_YUYV, cfg.width, cfg.height);
+
+	cfg.width = 0;
+	assert(jpeg_enc_start(&enc, &cfg, out, sizeof(out)) == -EINVAL);
+	cfg.width = 120;
+	cfg.height = 0;
+	assert(jpeg_enc_start(&enc, &cfg, out, sizeof(out)) == -EINVAL);
+	cfg.height = 70;
+	/* YUYV pixels come by pairs */
+	cfg.width = 121;
+	assert(jpeg_enc_start(&enc, &cfg, out, sizeof(out)) == -EINVAL);
+	cfg.width = 120;
+	cfg.format = (enum _jpeg_enc_format)42;
+	assert(jpeg_enc_start(&enc, &cfg, out, sizeof(out)) == -EINVAL);
+	cfg.format = JPEG_ENC_FORMAT_YUYV;
+
+	assert(jpeg_enc_start(&enc, &cfg, out, sizeof(out)) == 0);
+	/* Partial MCU rows are only allowed at the end of the image */
+	assert(jpeg_enc_write_lines(&enc, image, stride, 5) == -EINVAL);
+	/* More lines than the image has */
+	assert(jpeg_enc_write_lines(&enc, image, stride, 72) == -EINVAL);
+	assert(jpeg_enc_write_lines(&enc, image, stride, 64) == 0);
+	assert(jpeg_enc_finish(&enc) == -EINVAL);
+	assert(jpeg_enc_write_lines(&enc, image + 64 * stride, stride, 8) == -EINVAL);
+	assert(jpeg_enc_write_lines(&enc, image + 64 * stride, stride, 6) == 0);
+	assert(jpeg_enc_write_lines(&enc, image, stride, 8) == -EINVAL);
+	assert(jpeg_enc_finish(&enc) > 0);
+}
+
+static void test_no_space(void)
+{
+	struct _jpeg_enc enc;
+	struct _jpeg_enc_cfg cfg = {
+		.format = JPEG_ENC_FORMAT_YUYV,
+		.width = 120,
+		.height = 70,
+	};
+	const uint32_t stride = 2 * cfg.width;
+	uint32_t headers, size;
+	int len;
+
+	_make_image(JPEG_ENC_FORMAT_YUYV, cfg.width, cfg.height);
+	len = _encode(JPEG_ENC_FORMAT_YUYV, cfg.width, cfg.height, 0, 8, ref,
+			sizeof(ref));
+	assert(len > 0);
+
+	assert(jpeg_enc_start(&enc, &cfg, out, sizeof(out)) == 0);
+	headers = enc.len;
+
+	/* Headers that do not fit */
+	memset(out, 0xa5, sizeof(out));
+	assert(jpeg_enc_start(&enc, &cfg, out, headers - 1) == -ENOSPC);
+	assert(out[headers - 1] == 0xa5);
+
+	/* Headers only, the first strip overflows */
+	assert(jpeg_enc_start(&enc, &cfg, out, headers) == 0);
+	assert(jpeg_enc_write_lines(&enc, image, stride, 8) == -ENOSPC);
+	assert(out[headers] == 0xa5);
+
+	/* One byte short, reported at the latest by finish */
+	for (size = len - 2; size < (uint32_t)len; size++) {
+		int err = 0;
+		uint32_t y;
+
+		memset(out, 0xa5, sizeof(out));
+		assert(jpeg_enc_start(&enc, &cfg, out, size) == 0);
+		for (y = 0; y < cfg.height && !err; y += 8)
+			err = jpeg_enc_write_lines(&enc, image + y * stride,
+					stride, y + 8 > cfg.height ? cfg.height - y : 8);
+		if (!err)
+			err = jpeg_enc_finish(&enc);
+		assert(err == -ENOSPC);
+		assert(out[size] == 0xa5);
+	}
+
+	/* Exact size */
+	assert(_encode(JPEG_ENC_FORMAT_YUYV, cfg.width, cfg.height, 0, 8, out,
+			len) == len);
+	assert(!memcmp(out, ref, len));
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	test_quality();
+	test_odd_sizes();
+	test_strips();
+	test_invalid();
+	test_no_space();
+	return 0;
+}
@@ -0,0 +1,404 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Swap chain test with a simulated LCDC. lcdc.c is built for SAMA5D2 against
+ * a register block in memory. At each simulated start of frame, the layers
+ * that were asked to add a descriptor to their queue load it and raise their
+ * ADD interrupt, then the LCDC handler runs.
+ *
+ * Interrupt enable and disable registers are applied to the mask registers
+ * after each driver call, disables first. The swap chain code never enables
+ * then disables the same interrupt within a call.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "chip.h"
+
+static Lcdc fake_lcdc;
+#undef LCDC
+#define LCDC (&fake_lcdc)
+
+#include "display/lcdc.c"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define BUFFER_SIZE 64
+
+/** Status register of a layer, read-only for the driver */
+#define LAYER_REG(layer, index) (*(volatile uint32_t*)&lcdc_layers[layer].reg_enable[index])
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint8_t base_buffers[LCDC_SWAP_CHAIN_MAX_BUFFERS][BUFFER_SIZE];
+static uint8_t heo_buffers[LCDC_SWAP_CHAIN_MAX_BUFFERS][BUFFER_SIZE];
+
+static irq_handler_t lcdc_handler;
+
+/** Address scanned out by each layer */
+static uint32_t scanout[ARRAY_SIZE(lcdc_layers)];
+
+/** Buffers released by the callback, in order */
+static void *released[1024];
+static uint32_t released_count;
+
+/*----------------------------------------------------------------------------
+ *         Stubs
+ *----------------------------------------------------------------------------*/
+
+uint32_t trace_level = TRACE_LEVEL_SILENT;
+uint8_t trace_module_level[TRACE_MODULE_COUNT];
+
+void cache_clean_region(const void *start, uint32_t length)
+{
+}
+
+int irq_add_handler(uint32_t source, irq_handler_t handler, void* user_arg)
+{
+	assert(source == ID_LCDC);
+	lcdc_handler = handler;
+	return 0;
+}
+
+void irq_enable(uint32_t source)
+{
+}
+
+void irq_disable(uint32_t source)
+{
+}
+
+uint32_t pmc_get_master_clock(void)
+{
+	abort();
+}
+
+bool pmc_has_system_clock(enum _pmc_system_clock clock)
+{
+	abort();
+}
+
+void pmc_enable_system_clock(enum _pmc_system_clock clock)
+{
+	abort();
+}
+
+void pmc_disable_system_clock(enum _pmc_system_clock clock)
+{
+	abort();
+}
+
+void pmc_configure_peripheral(uint32_t id, const struct _pmc_periph_cfg* cfg, bool enable)
+{
+	abort();
+}
+
+void pmc_disable_peripheral(uint32_t id)
+{
+	abort();
+}
+
+/*----------------------------------------------------------------------------
+ *         Simulated LCDC
+ *----------------------------------------------------------------------------*/
+
+static void _apply_it_mask(volatile uint32_t *ier, volatile uint32_t *idr,
+		volatile uint32_t *imr)
+{
+	*imr = (*imr & ~*idr) | *ier;
+	*ier = 0;
+	*idr = 0;
+}
+
+static void _sync_registers(void)
+{
+	uint8_t i;
+
+	_apply_it_mask(&fake_lcdc.LCDC_LCDIER, &fake_lcdc.LCDC_LCDIDR,
+		       (volatile uint32_t*)&fake_lcdc.LCDC_LCDIMR);
+	for (i = 0; i < ARRAY_SIZE(lcdc_layers); i++) {
+		if (!lcdc_layers[i].reg_enable)
+			continue;
+		_apply_it_mask(&LAYER_REG(i, 3), &LAYER_REG(i, 4),
+			       &LAYER_REG(i, 5));
+	}
+}
+
+/** Start of frame: load the queued descriptors and run the handler */
+static void _vsync(void)
+{
+	uint32_t status = LCDC_LCDISR_SOF;
+	struct _lcdc_dma_desc *desc;
+	uint8_t i;
+
+	_sync_registers();
+	for (i = 0; i < ARRAY_SIZE(lcdc_layers); i++) {
+		if (!lcdc_layers[i].reg_enable)
+			continue;
+		if (!(LAYER_REG(i, 0) & LCDC_BASECHER_A2QEN))
+			continue;
+		LAYER_REG(i, 0) = 0;
+
+		desc = (struct _lcdc_dma_desc*)(uintptr_t)lcdc_layers[i].reg_dma_head[0];
+		assert(desc->ctrl & LCDC_BASECTRL_DFETCH);
+		assert(desc->next == (uint32_t)(uintptr_t)desc);
+		scanout[i] = desc->addr;
+		if (desc->ctrl & LCDC_BASECTRL_ADDIEN) {
+			LAYER_REG(i, 6) |= LCDC_BASEISR_ADD;
+			status |= lcdc_layers[i].irq_mask;
+		}
+	}
+
+	*(volatile uint32_t*)&fake_lcdc.LCDC_LCDISR = status;
+	if (lcdc_handler && (status & fake_lcdc.LCDC_LCDIMR))
+		lcdc_handler(ID_LCDC, NULL);
+	*(volatile uint32_t*)&fake_lcdc.LCDC_LCDISR = 0;
+	for (i = 0; i < ARRAY_SIZE(lcdc_layers); i++)
+		if (lcdc_layers[i].reg_enable)
+			LAYER_REG(i, 6) = 0;
+	_sync_registers();
+}
+
+static void _buffer_released(uint8_t layer, void *buffer, void *arg)
+{
+	assert(arg == &released);
+	assert(released_count < ARRAY_SIZE(released));
+	released[released_count++] = buffer;
+}
+
+static void _reset(void)
+{
+	memset(&fake_lcdc, 0, sizeof(fake_lcdc));
+	memset(scanout, 0, sizeof(scanout));
+	released_count = 0;
+	lcdc_handler = NULL;
+	lcdc_frame_count = 0;
+
+	/* What lcdc_configure() and lcdc_put_image() leave */
+	lcdc_base.swap_chain = &base_swap_chain;
+	base_swap_chain.count = 0;
+	lcdc_base.buffer = base_buffers[0];
+	lcdc_heo.swap_chain = &heo_swap_chain;
+	heo_swap_chain.count = 0;
+	lcdc_heo.buffer = heo_buffers[0];
+	scanout[LCDC_BASE] = (uint32_t)(uintptr_t)base_buffers[0];
+	scanout[LCDC_HEO] = (uint32_t)(uintptr_t)heo_buffers[0];
+}
+
+static void _create(uint8_t layer, uint8_t (*buffers)[BUFFER_SIZE], uint8_t count)
+{
+	void *list[LCDC_SWAP_CHAIN_MAX_BUFFERS];
+	uint8_t i;
+
+	for (i = 0; i < count; i++)
+		list[i] = buffers[i];
+	assert(lcdc_swap_chain_create(layer, list, count, _buffer_released,
+				      &released) == 0);
+	_sync_registers();
+}
+
+/*----------------------------------------------------------------------------
+ *         Tests
+ *----------------------------------------------------------------------------*/
+
+static void test_flip_order(void)
+{
+	struct _lcdc_swap_chain_stats stats;
+	void *b1, *b2;
+
+	_reset();
+	_create(LCDC_BASE, base_buffers, 3);
+	assert(fake_lcdc.LCDC_LCDIMR & LCDC_LCDIMR_SOFIM);
+	assert(LAYER_REG(LCDC_BASE, 5) & LCDC_BASEIMR_ADD);
+
+	/* buffer 0 is on screen, 1 and 2 are free */
+	b1 = lcdc_swap_chain_acquire(LCDC_BASE);
+	b2 = lcdc_swap_chain_acquire(LCDC_BASE);
+	assert(b1 == base_buffers[1] && b2 == base_buffers[2]);
+	assert(lcdc_swap_chain_acquire(LCDC_BASE) == NULL);
+
+	assert(lcdc_swap_chain_present(LCDC_BASE, b1) == 0);
+	assert(lcdc_swap_chain_present(LCDC_BASE, b2) == 0);
+	assert(lcdc_swap_chain_present(LCDC_BASE, b2) == -EBUSY);
+	assert(lcdc_swap_chain_present(LCDC_BASE, base_buffers[0]) == -EBUSY);
+	assert(lcdc_swap_chain_present(LCDC_BASE, heo_buffers[1]) == -EINVAL);
+
+	/* one buffer per frame, in presentation order */
+	_vsync();
+	assert(scanout[LCDC_BASE] == (uint32_t)(uintptr_t)b1);
+	assert(released_count == 1 && released[0] == base_buffers[0]);
+	_vsync();
+	assert(scanout[LCDC_BASE] == (uint32_t)(uintptr_t)b2);
+	assert(released_count == 2 && released[1] == b1);
+
+	/* nothing queued: the last buffer stays on screen */
+	_vsync();
+	_vsync();
+	assert(scanout[LCDC_BASE] == (uint32_t)(uintptr_t)b2);
+	assert(released_count == 2);
+	assert(lcdc_swap_chain_acquire(LCDC_BASE) == base_buffers[0]);
+
+	assert(lcdc_swap_chain_get_stats(LCDC_BASE, &stats) == 0);
+	assert(stats.frames == 4);
+	assert(stats.flips == 2);
+	assert(stats.last_latency == 2 && stats.max_latency == 2);
+	assert(stats.last_interval == 1);
+	assert(lcdc_get_frame_count() == 4);
+}
+
+static void test_destroy_disables_sof(void)
+{
+	void *buffer;
+
+	_reset();
+	_create(LCDC_BASE, base_buffers, 2);
+	_create(LCDC_HEO, heo_buffers, 2);
+
+	/* the buffer about to be shown stays displayed */
+	buffer = lcdc_swap_chain_acquire(LCDC_BASE);
+	assert(lcdc_swap_chain_present(LCDC_BASE, buffer) == 0);
+	lcdc_swap_chain_destroy(LCDC_BASE);
+	_sync_registers();
+	assert(lcdc_base.buffer == buffer);
+	assert(!(LAYER_REG(LCDC_BASE, 5) & LCDC_BASEIMR_ADD));
+	assert(!(fake_lcdc.LCDC_LCDIMR & LCDC_LCDIMR_BASEIM));
+	assert(lcdc_swap_chain_acquire(LCDC_BASE) == NULL);
+
+	/* the HEO chain still needs the start of frame */
+	assert(fake_lcdc.LCDC_LCDIMR & LCDC_LCDIMR_SOFIM);
+	_vsync();
+	assert(lcdc_get_frame_count() == 1);
+
+	lcdc_swap_chain_destroy(LCDC_HEO);
+	_sync_registers();
+	assert(!(fake_lcdc.LCDC_LCDIMR & LCDC_LCDIMR_SOFIM));
+	assert(fake_lcdc.LCDC_LCDIMR == 0);
+	_vsync();
+	assert(lcdc_get_frame_count() == 1);
+}
+
+/**
+ * Random acquire/present sequences on two layers, checked against a model:
+ * buffers reach the screen in presentation order, one per frame, and each
+ * one is released once, when the next one is displayed.
+ */
+static void test_random(void)
+{
+	const uint8_t layers[2] = { LCDC_BASE, LCDC_HEO };
+	void *queue[2][LCDC_SWAP_CHAIN_MAX_BUFFERS];
+	uint32_t queue_len[2] = { 0, 0 };
+	void *acquired[2][LCDC_SWAP_CHAIN_MAX_BUFFERS];
+	uint32_t acquired_count[2] = { 0, 0 };
+	void *displayed[2];
+	uint32_t frame, l, i, expected_released;
+	void *buffer;
+
+	srand(1);
+	_reset();
+	_create(LCDC_BASE, base_buffers, LCDC_SWAP_CHAIN_MAX_BUFFERS);
+	_create(LCDC_HEO, heo_buffers, 3);
+	displayed[0] = base_buffers[0];
+	displayed[1] = heo_buffers[0];
+
+	for (frame = 0; frame < 20000; frame++) {
+		for (l = 0; l < 2; l++) {
+			switch (rand() % 3) {
+			case 0:
+				buffer = lcdc_swap_chain_acquire(layers[l]);
+				if (buffer) {
+					assert(acquired_count[l] < LCDC_SWAP_CHAIN_MAX_BUFFERS);
+					acquired[l][acquired_count[l]++] = buffer;
+				}
+				break;
+			case 1:
+				if (!acquired_count[l])
+					break;
+				i = rand() % acquired_count[l];
+				buffer = acquired[l][i];
+				acquired[l][i] = acquired[l][--acquired_count[l]];
+				assert(lcdc_swap_chain_present(layers[l], buffer) == 0);
+				queue[l][queue_len[l]++] = buffer;
+				break;
+			default:
+				break;
+			}
+		}
+
+		released_count = 0;
+		_vsync();
+		expected_released = 0;
+		for (l = 0; l < 2; l++) {
+			if (!queue_len[l])
+				continue;
+			/* the released buffers come in layer order */
+			assert(released[expected_released++] == displayed[l]);
+			displayed[l] = queue[l][0];
+			memmove(queue[l], queue[l] + 1,
+				--queue_len[l] * sizeof(queue[l][0]));
+		}
+		assert(released_count == expected_released);
+		for (l = 0; l < 2; l++) {
+			assert(scanout[layers[l]] == (uint32_t)(uintptr_t)displayed[l]);
+			/* every buffer is in exactly one place */
+			assert(1 + queue_len[l] + acquired_count[l] <=
+			       (l ? 3 : LCDC_SWAP_CHAIN_MAX_BUFFERS));
+		}
+	}
+
+	lcdc_swap_chain_destroy(LCDC_BASE);
+	_sync_registers();
+	lcdc_swap_chain_destroy(LCDC_HEO);
+	_sync_registers();
+	assert(fake_lcdc.LCDC_LCDIMR == 0);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	assert((uintptr_t)base_buffers < UINT32_MAX);
+
+	test_flip_order();
+	test_destroy_disables_sof();
+	test_random();
+	return 0;
+}
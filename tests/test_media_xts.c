@@ -0,0 +1,366 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * AES-XTS media test. IEEE P1619 vectors 1, 4, 5 and 10 are written through
+ * media_xts with the software engine, on a RAM disk whose block size is the
+ * data unit size and with the data unit number as block number. The RAM disk
+ * must then hold the vector ciphertext, and reads must give the plaintext
+ * back. Random multi-block accesses are compared with a block by block
+ * reference.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errno.h"
+#include "trace.h"
+#include "libstoragemedia/media.h"
+#include "libstoragemedia/media_private.h"
+#include "libstoragemedia/media_ramdisk.h"
+#include "libstoragemedia/media_xts.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define SECTOR_SIZE   512
+#define SECTOR_COUNT  256
+#define WORK_SIZE     (MEDIA_XTS_TWEAK_AREA_SIZE + 4 * SECTOR_SIZE)
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+uint32_t trace_level = TRACE_LEVEL_SILENT;
+uint8_t trace_module_level[TRACE_MODULE_COUNT];
+
+/* The RAM disk takes its base address in blocks, on 32 bits */
+static uint8_t disk[SECTOR_COUNT * SECTOR_SIZE] __attribute__((aligned(SECTOR_SIZE)));
+static uint8_t work[WORK_SIZE];
+
+static struct _media ramdisk;
+static struct _media media;
+static struct _media_xts xts;
+static struct _media_xts_soft soft;
+static struct _media_xts_engine engine;
+
+static const uint8_t vector1_ct[32] = {
+	0x91, 0x7c, 0xf6, 0x9e, 0xbd, 0x68, 0xb2, 0xec, 0x9b, 0x9f, 0xe9, 0xa3,
+	0xea, 0xdd, 0xa6, 0x92, 0xcd, 0x43, 0xd2, 0xf5, 0x95, 0x98, 0xed, 0x85,
+	0x8c, 0x02, 0xc2, 0x65, 0x2f, 0xbf, 0x92, 0x2e,
+};
+
+static const uint8_t vector4_ct[512] = {
+	0x27, 0xa7, 0x47, 0x9b, 0xef, 0xa1, 0xd4, 0x76, 0x48, 0x9f, 0x30, 0x8c,
+	0xd4, 0xcf, 0xa6, 0xe2, 0xa9, 0x6e, 0x4b, 0xbe, 0x32, 0x08, 0xff, 0x25,
+	0x28, 0x7d, 0xd3, 0x81, 0x96, 0x16, 0xe8, 0x9c, 0xc7, 0x8c, 0xf7, 0xf5,
+	0xe5, 0x43, 0x44, 0x5f, 0x83, 0x33, 0xd8, 0xfa, 0x7f, 0x56, 0x00, 0x00,
+	0x05, 0x27, 0x9f, 0xa5, 0xd8, 0xb5, 0xe4, 0xad, 0x40, 0xe7, 0x36, 0xdd,
+	0xb4, 0xd3, 0x54, 0x12, 0x32, 0x80, 0x63, 0xfd, 0x2a, 0xab, 0x53, 0xe5,
+	0xea, 0x1e, 0x0a, 0x9f, 0x33, 0x25, 0x00, 0xa5, 0xdf, 0x94, 0x87, 0xd0,
+	0x7a, 0x5c, 0x92, 0xcc, 0x51, 0x2c, 0x88, 0x66, 0xc7, 0xe8, 0x60, 0xce,
+	0x93, 0xfd, 0xf1, 0x66, 0xa2, 0x49, 0x12, 0xb4, 0x22, 0x97, 0x61, 0x46,
+	0xae, 0x20, 0xce, 0x84, 0x6b, 0xb7, 0xdc, 0x9b, 0xa9, 0x4a, 0x76, 0x7a,
+	0xae, 0xf2, 0x0c, 0x0d, 0x61, 0xad, 0x02, 0x65, 0x5e, 0xa9, 0x2d, 0xc4,
+	0xc4, 0xe4, 0x1a, 0x89, 0x52, 0xc6, 0x51, 0xd3, 0x31, 0x74, 0xbe, 0x51,
+	0xa1, 0x0c, 0x42, 0x11, 0x10, 0xe6, 0xd8, 0x15, 0x88, 0xed, 0xe8, 0x21,
+	0x03, 0xa2, 0x52, 0xd8, 0xa7, 0x50, 0xe8, 0x76, 0x8d, 0xef, 0xff, 0xed,
+	0x91, 0x22, 0x81, 0x0a, 0xae, 0xb9, 0x9f, 0x91, 0x72, 0xaf, 0x82, 0xb6,
+	0x04, 0xdc, 0x4b, 0x8e, 0x51, 0xbc, 0xb0, 0x82, 0x35, 0xa6, 0xf4, 0x34,
+	0x13, 0x32, 0xe4, 0xca, 0x60, 0x48, 0x2a, 0x4b, 0xa1, 0xa0, 0x3b, 0x3e,
+	0x65, 0x00, 0x8f, 0xc5, 0xda, 0x76, 0xb7, 0x0b, 0xf1, 0x69, 0x0d, 0xb4,
+	0xea, 0xe2, 0x9c, 0x5f, 0x1b, 0xad, 0xd0, 0x3c, 0x5c, 0xcf, 0x2a, 0x55,
+	0xd7, 0x05, 0xdd, 0xcd, 0x86, 0xd4, 0x49, 0x51, 0x1c, 0xeb, 0x7e, 0xc3,
+	0x0b, 0xf1, 0x2b, 0x1f, 0xa3, 0x5b, 0x91, 0x3f, 0x9f, 0x74, 0x7a, 0x8a,
+	0xfd, 0x1b, 0x13, 0x0e, 0x94, 0xbf, 0xf9, 0x4e, 0xff, 0xd0, 0x1a, 0x91,
+	0x73, 0x5c, 0xa1, 0x72, 0x6a, 0xcd, 0x0b, 0x19, 0x7c, 0x4e, 0x5b, 0x03,
+	0x39, 0x36, 0x97, 0xe1, 0x26, 0x82, 0x6f, 0xb6, 0xbb, 0xde, 0x8e, 0xcc,
+	0x1e, 0x08, 0x29, 0x85, 0x16, 0xe2, 0xc9, 0xed, 0x03, 0xff, 0x3c, 0x1b,
+	0x78, 0x60, 0xf6, 0xde, 0x76, 0xd4, 0xce, 0xcd, 0x94, 0xc8, 0x11, 0x98,
+	0x55, 0xef, 0x52, 0x97, 0xca, 0x67, 0xe9, 0xf3, 0xe7, 0xff, 0x72, 0xb1,
+	0xe9, 0x97, 0x85, 0xca, 0x0a, 0x7e, 0x77, 0x20, 0xc5, 0xb3, 0x6d, 0xc6,
+	0xd7, 0x2c, 0xac, 0x95, 0x74, 0xc8, 0xcb, 0xbc, 0x2f, 0x80, 0x1e, 0x23,
+	0xe5, 0x6f, 0xd3, 0x44, 0xb0, 0x7f, 0x22, 0x15, 0x4b, 0xeb, 0xa0, 0xf0,
+	0x8c, 0xe8, 0x89, 0x1e, 0x64, 0x3e, 0xd9, 0x95, 0xc9, 0x4d, 0x9a, 0x69,
+	0xc9, 0xf1, 0xb5, 0xf4, 0x99, 0x02, 0x7a, 0x78, 0x57, 0x2a, 0xee, 0xbd,
+	0x74, 0xd2, 0x0c, 0xc3, 0x98, 0x81, 0xc2, 0x13, 0xee, 0x77, 0x0b, 0x10,
+	0x10, 0xe4, 0xbe, 0xa7, 0x18, 0x84, 0x69, 0x77, 0xae, 0x11, 0x9f, 0x7a,
+	0x02, 0x3a, 0xb5, 0x8c, 0xca, 0x0a, 0xd7, 0x52, 0xaf, 0xe6, 0x56, 0xbb,
+	0x3c, 0x17, 0x25, 0x6a, 0x9f, 0x6e, 0x9b, 0xf1, 0x9f, 0xdd, 0x5a, 0x38,
+	0xfc, 0x82, 0xbb, 0xe8, 0x72, 0xc5, 0x53, 0x9e, 0xdb, 0x60, 0x9e, 0xf4,
+	0xf7, 0x9c, 0x20, 0x3e, 0xbb, 0x14, 0x0f, 0x2e, 0x58, 0x3c, 0xb2, 0xad,
+	0x15, 0xb4, 0xaa, 0x5b, 0x65, 0x50, 0x16, 0xa8, 0x44, 0x92, 0x77, 0xdb,
+	0xd4, 0x77, 0xef, 0x2c, 0x8d, 0x6c, 0x01, 0x7d, 0xb7, 0x38, 0xb1, 0x8d,
+	0xeb, 0x4a, 0x42, 0x7d, 0x19, 0x23, 0xce, 0x3f, 0xf2, 0x62, 0x73, 0x57,
+	0x79, 0xa4, 0x18, 0xf2, 0x0a, 0x28, 0x2d, 0xf9, 0x20, 0x14, 0x7b, 0xea,
+	0xbe, 0x42, 0x1e, 0xe5, 0x31, 0x9d, 0x05, 0x68,
+};
+
+static const uint8_t vector5_ct[512] = {
+	0x26, 0x4d, 0x3c, 0xa8, 0x51, 0x21, 0x94, 0xfe, 0xc3, 0x12, 0xc8, 0xc9,
+	0x89, 0x1f, 0x27, 0x9f, 0xef, 0xdd, 0x60, 0x8d, 0x0c, 0x02, 0x7b, 0x60,
+	0x48, 0x3a, 0x3f, 0xa8, 0x11, 0xd6, 0x5e, 0xe5, 0x9d, 0x52, 0xd9, 0xe4,
+	0x0e, 0xc5, 0x67, 0x2d, 0x81, 0x53, 0x2b, 0x38, 0xb6, 0xb0, 0x89, 0xce,
+	0x95, 0x1f, 0x0f, 0x9c, 0x35, 0x59, 0x0b, 0x8b, 0x97, 0x8d, 0x17, 0x52,
+	0x13, 0xf3, 0x29, 0xbb, 0x1c, 0x2f, 0xd3, 0x0f, 0x2f, 0x7f, 0x30, 0x49,
+	0x2a, 0x61, 0xa5, 0x32, 0xa7, 0x9f, 0x51, 0xd3, 0x6f, 0x5e, 0x31, 0xa7,
+	0xc9, 0xa1, 0x2c, 0x28, 0x60, 0x82, 0xff, 0x7d, 0x23, 0x94, 0xd1, 0x8f,
+	0x78, 0x3e, 0x1a, 0x8e, 0x72, 0xc7, 0x22, 0xca, 0xaa, 0xa5, 0x2d, 0x8f,
+	0x06, 0x56, 0x57, 0xd2, 0x63, 0x1f, 0xd2, 0x5b, 0xfd, 0x8e, 0x5b, 0xaa,
+	0xd6, 0xe5, 0x27, 0xd7, 0x63, 0x51, 0x75, 0x01, 0xc6, 0x8c, 0x5e, 0xdc,
+	0x3c, 0xdd, 0x55, 0x43, 0x5c, 0x53, 0x2d, 0x71, 0x25, 0xc8, 0x61, 0x4d,
+	0xee, 0xd9, 0xad, 0xaa, 0x3a, 0xca, 0xde, 0x58, 0x88, 0xb8, 0x7b, 0xef,
+	0x64, 0x1c, 0x4c, 0x99, 0x4c, 0x80, 0x91, 0xb5, 0xbc, 0xd3, 0x87, 0xf3,
+	0x96, 0x3f, 0xb5, 0xbc, 0x37, 0xaa, 0x92, 0x2f, 0xbf, 0xe3, 0xdf, 0x4e,
+	0x5b, 0x91, 0x5e, 0x6e, 0xb5, 0x14, 0x71, 0x7b, 0xdd, 0x2a, 0x74, 0x07,
+	0x9a, 0x50, 0x73, 0xf5, 0xc4, 0xbf, 0xd4, 0x6a, 0xdf, 0x7d, 0x28, 0x2e,
+	0x7a, 0x39, 0x3a, 0x52, 0x57, 0x9d, 0x11, 0xa0, 0x28, 0xda, 0x4d, 0x9c,
+	0xd9, 0xc7, 0x71, 0x24, 0xf9, 0x64, 0x8e, 0xe3, 0x83, 0xb1, 0xac, 0x76,
+	0x39, 0x30, 0xe7, 0x16, 0x2a, 0x8d, 0x37, 0xf3, 0x50, 0xb2, 0xf7, 0x4b,
+	0x84, 0x72, 0xcf, 0x09, 0x90, 0x20, 0x63, 0xc6, 0xb3, 0x2e, 0x8c, 0x2d,
+	0x92, 0x90, 0xce, 0xfb, 0xd7, 0x34, 0x6d, 0x1c, 0x77, 0x9a, 0x0d, 0xf5,
+	0x0e, 0xdc, 0xde, 0x45, 0x31, 0xda, 0x07, 0xb0, 0x99, 0xc6, 0x38, 0xe8,
+	0x3a, 0x75, 0x59, 0x44, 0xdf, 0x2a, 0xef, 0x1a, 0xa3, 0x17, 0x52, 0xfd,
+	0x32, 0x3d, 0xcb, 0x71, 0x0f, 0xb4, 0xbf, 0xbb, 0x9d, 0x22, 0xb9, 0x25,
+	0xbc, 0x35, 0x77, 0xe1, 0xb8, 0x94, 0x9e, 0x72, 0x9a, 0x90, 0xbb, 0xaf,
+	0xea, 0xcf, 0x7f, 0x78, 0x79, 0xe7, 0xb1, 0x14, 0x7e, 0x28, 0xba, 0x0b,
+	0xae, 0x94, 0x0d, 0xb7, 0x95, 0xa6, 0x1b, 0x15, 0xec, 0xf4, 0xdf, 0x8d,
+	0xb0, 0x7b, 0x82, 0x4b, 0xb0, 0x62, 0x80, 0x2c, 0xc9, 0x8a, 0x95, 0x45,
+	0xbb, 0x2a, 0xae, 0xed, 0x77, 0xcb, 0x3f, 0xc6, 0xdb, 0x15, 0xdc, 0xd7,
+	0xd8, 0x0d, 0x7d, 0x5b, 0xc4, 0x06, 0xc4, 0x97, 0x0a, 0x34, 0x78, 0xad,
+	0xa8, 0x89, 0x9b, 0x32, 0x91, 0x98, 0xeb, 0x61, 0xc1, 0x93, 0xfb, 0x62,
+	0x75, 0xaa, 0x8c, 0xa3, 0x40, 0x34, 0x4a, 0x75, 0xa8, 0x62, 0xae, 0xbe,
+	0x92, 0xee, 0xe1, 0xce, 0x03, 0x2f, 0xd9, 0x50, 0xb4, 0x7d, 0x77, 0x04,
+	0xa3, 0x87, 0x69, 0x23, 0xb4, 0xad, 0x62, 0x84, 0x4b, 0xf4, 0xa0, 0x9c,
+	0x4d, 0xbe, 0x8b, 0x43, 0x97, 0x18, 0x4b, 0x74, 0x71, 0x36, 0x0c, 0x95,
+	0x64, 0x88, 0x0a, 0xed, 0xdd, 0xb9, 0xba, 0xa4, 0xaf, 0x2e, 0x75, 0x39,
+	0x4b, 0x08, 0xcd, 0x32, 0xff, 0x47, 0x9c, 0x57, 0xa0, 0x7d, 0x3e, 0xab,
+	0x5d, 0x54, 0xde, 0x5f, 0x97, 0x38, 0xb8, 0xd2, 0x7f, 0x27, 0xa9, 0xf0,
+	0xab, 0x11, 0x79, 0x9d, 0x7b, 0x7f, 0xfe, 0xfb, 0x27, 0x04, 0xc9, 0x5c,
+	0x6a, 0xd1, 0x2c, 0x39, 0xf1, 0xe8, 0x67, 0xa4, 0xb7, 0xb1, 0xd7, 0x81,
+	0x8a, 0x4b, 0x75, 0x3d, 0xfd, 0x2a, 0x89, 0xcc, 0xb4, 0x5e, 0x00, 0x1a,
+	0x03, 0xa8, 0x67, 0xb1, 0x87, 0xf2, 0x25, 0xdd,
+};
+
+static const uint8_t vector10_ct[512] = {
+	0x1c, 0x3b, 0x3a, 0x10, 0x2f, 0x77, 0x03, 0x86, 0xe4, 0x83, 0x6c, 0x99,
+	0xe3, 0x70, 0xcf, 0x9b, 0xea, 0x00, 0x80, 0x3f, 0x5e, 0x48, 0x23, 0x57,
+	0xa4, 0xae, 0x12, 0xd4, 0x14, 0xa3, 0xe6, 0x3b, 0x5d, 0x31, 0xe2, 0x76,
+	0xf8, 0xfe, 0x4a, 0x8d, 0x66, 0xb3, 0x17, 0xf9, 0xac, 0x68, 0x3f, 0x44,
+	0x68, 0x0a, 0x86, 0xac, 0x35, 0xad, 0xfc, 0x33, 0x45, 0xbe, 0xfe, 0xcb,
+	0x4b, 0xb1, 0x88, 0xfd, 0x57, 0x76, 0x92, 0x6c, 0x49, 0xa3, 0x09, 0x5e,
+	0xb1, 0x08, 0xfd, 0x10, 0x98, 0xba, 0xec, 0x70, 0xaa, 0xa6, 0x69, 0x99,
+	0xa7, 0x2a, 0x82, 0xf2, 0x7d, 0x84, 0x8b, 0x21, 0xd4, 0xa7, 0x41, 0xb0,
+	0xc5, 0xcd, 0x4d, 0x5f, 0xff, 0x9d, 0xac, 0x89, 0xae, 0xba, 0x12, 0x29,
+	0x61, 0xd0, 0x3a, 0x75, 0x71, 0x23, 0xe9, 0x87, 0x0f, 0x8a, 0xcf, 0x10,
+	0x00, 0x02, 0x08, 0x87, 0x89, 0x14, 0x29, 0xca, 0x2a, 0x3e, 0x7a, 0x7d,
+	0x7d, 0xf7, 0xb1, 0x03, 0x55, 0x16, 0x5c, 0x8b, 0x9a, 0x6d, 0x0a, 0x7d,
+	0xe8, 0xb0, 0x62, 0xc4, 0x50, 0x0d, 0xc4, 0xcd, 0x12, 0x0c, 0x0f, 0x74,
+	0x18, 0xda, 0xe3, 0xd0, 0xb5, 0x78, 0x1c, 0x34, 0x80, 0x3f, 0xa7, 0x54,
+	0x21, 0xc7, 0x90, 0xdf, 0xe1, 0xde, 0x18, 0x34, 0xf2, 0x80, 0xd7, 0x66,
+	0x7b, 0x32, 0x7f, 0x6c, 0x8c, 0xd7, 0x55, 0x7e, 0x12, 0xac, 0x3a, 0x0f,
+	0x93, 0xec, 0x05, 0xc5, 0x2e, 0x04, 0x93, 0xef, 0x31, 0xa1, 0x2d, 0x3d,
+	0x92, 0x60, 0xf7, 0x9a, 0x28, 0x9d, 0x6a, 0x37, 0x9b, 0xc7, 0x0c, 0x50,
+	0x84, 0x14, 0x73, 0xd1, 0xa8, 0xcc, 0x81, 0xec, 0x58, 0x3e, 0x96, 0x45,
+	0xe0, 0x7b, 0x8d, 0x96, 0x70, 0x65, 0x5b, 0xa5, 0xbb, 0xcf, 0xec, 0xc6,
+	0xdc, 0x39, 0x66, 0x38, 0x0a, 0xd8, 0xfe, 0xcb, 0x17, 0xb6, 0xba, 0x02,
+	0x46, 0x9a, 0x02, 0x0a, 0x84, 0xe1, 0x8e, 0x8f, 0x84, 0x25, 0x20, 0x70,
+	0xc1, 0x3e, 0x9f, 0x1f, 0x28, 0x9b, 0xe5, 0x4f, 0xbc, 0x48, 0x14, 0x57,
+	0x77, 0x8f, 0x61, 0x60, 0x15, 0xe1, 0x32, 0x7a, 0x02, 0xb1, 0x40, 0xf1,
+	0x50, 0x5e, 0xb3, 0x09, 0x32, 0x6d, 0x68, 0x37, 0x8f, 0x83, 0x74, 0x59,
+	0x5c, 0x84, 0x9d, 0x84, 0xf4, 0xc3, 0x33, 0xec, 0x44, 0x23, 0x88, 0x51,
+	0x43, 0xcb, 0x47, 0xbd, 0x71, 0xc5, 0xed, 0xae, 0x9b, 0xe6, 0x9a, 0x2f,
+	0xfe, 0xce, 0xb1, 0xbe, 0xc9, 0xde, 0x24, 0x4f, 0xbe, 0x15, 0x99, 0x2b,
+	0x11, 0xb7, 0x7c, 0x04, 0x0f, 0x12, 0xbd, 0x8f, 0x6a, 0x97, 0x5a, 0x44,
+	0xa0, 0xf9, 0x0c, 0x29, 0xa9, 0xab, 0xc3, 0xd4, 0xd8, 0x93, 0x92, 0x72,
+	0x84, 0xc5, 0x87, 0x54, 0xcc, 0xe2, 0x94, 0x52, 0x9f, 0x86, 0x14, 0xdc,
+	0xd2, 0xab, 0xa9, 0x91, 0x92, 0x5f, 0xed, 0xc4, 0xae, 0x74, 0xff, 0xac,
+	0x6e, 0x33, 0x3b, 0x93, 0xeb, 0x4a, 0xff, 0x04, 0x79, 0xda, 0x9a, 0x41,
+	0x0e, 0x44, 0x50, 0xe0, 0xdd, 0x7a, 0xe4, 0xc6, 0xe2, 0x91, 0x09, 0x00,
+	0x57, 0x5d, 0xa4, 0x01, 0xfc, 0x07, 0x05, 0x9f, 0x64, 0x5e, 0x8b, 0x7e,
+	0x9b, 0xfd, 0xef, 0x33, 0x94, 0x30, 0x54, 0xff, 0x84, 0x01, 0x14, 0x93,
+	0xc2, 0x7b, 0x34, 0x29, 0xea, 0xed, 0xb4, 0xed, 0x53, 0x76, 0x44, 0x1a,
+	0x77, 0xed, 0x43, 0x85, 0x1a, 0xd7, 0x7f, 0x16, 0xf5, 0x41, 0xdf, 0xd2,
+	0x69, 0xd5, 0x0d, 0x6a, 0x5f, 0x14, 0xfb, 0x0a, 0xab, 0x1c, 0xbb, 0x4c,
+	0x15, 0x50, 0xbe, 0x97, 0xf7, 0xab, 0x40, 0x66, 0x19, 0x3c, 0x4c, 0xaa,
+	0x77, 0x3d, 0xad, 0x38, 0x01, 0x4b, 0xd2, 0x09, 0x2f, 0xa7, 0x55, 0xc8,
+	0x24, 0xbb, 0x5e, 0x54, 0xc4, 0xf3, 0x6f, 0xfd, 0xa9, 0xfc, 0xea, 0x70,
+	0xb9, 0xc6, 0xe6, 0x93, 0xe1, 0x48, 0xc1, 0x51,
+};
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _setup(const char* key1, const char* key2, uint32_t key_len,
+		uint32_t block_size)
+{
+	uint8_t k1[32], k2[32];
+	uint32_t i;
+
+	for (i = 0; i < key_len; i++) {
+		assert(sscanf(key1 + 2 * i, "%2hhx", &k1[i]) == 1);
+		assert(sscanf(key2 + 2 * i, "%2hhx", &k2[i]) == 1);
+	}
+	assert(media_xts_soft_engine_init(&engine, &soft, k1, k2, key_len) == 0);
+
+	memset(disk, 0, sizeof(disk));
+	media_ramdisk_init(&ramdisk, (uint32_t)((uintptr_t)disk / block_size),
+			sizeof(disk) / block_size, block_size);
+	assert(media_xts_initialize(&media, &xts, &ramdisk, &engine, work,
+				    sizeof(work)) == MEDIA_STATUS_SUCCESS);
+	assert(!media_is_mapped_read_supported(&media));
+	assert(media_get_block_size(&media) == block_size);
+}
+
+/** Write the plaintext of a vector, check the ciphertext on the disk */
+static void _check_vector(uint32_t unit, const uint8_t* plain,
+		const uint8_t* cipher, uint32_t size)
+{
+	uint8_t data[SECTOR_SIZE];
+
+	memcpy(data, plain, size);
+	assert(media_write(&media, unit, data, 1, NULL, NULL) == MEDIA_STATUS_SUCCESS);
+	/* the plaintext buffer is left untouched */
+	assert(memcmp(data, plain, size) == 0);
+	assert(memcmp(disk + unit * size, cipher, size) == 0);
+
+	memset(data, 0, sizeof(data));
+	assert(media_read(&media, unit, data, 1, NULL, NULL) == MEDIA_STATUS_SUCCESS);
+	assert(memcmp(data, plain, size) == 0);
+}
+
+static void test_vectors(void)
+{
+	static const uint8_t zero[32];
+	uint8_t plain[SECTOR_SIZE];
+	uint32_t i;
+
+	for (i = 0; i < SECTOR_SIZE; i++)
+		plain[i] = i;
+
+	/* Vector 1: 32-byte data unit 0, null keys and data */
+	_setup("00000000000000000000000000000000",
+	       "00000000000000000000000000000000", 16, 32);
+	_check_vector(0, zero, vector1_ct, sizeof(zero));
+
+	/* Vectors 4 and 5: data units 0 and 1, vector 5 encrypts vector 4 */
+	_setup("27182818284590452353602874713526",
+	       "31415926535897932384626433832795", 16, SECTOR_SIZE);
+	_check_vector(0, plain, vector4_ct, SECTOR_SIZE);
+	_check_vector(1, vector4_ct, vector5_ct, SECTOR_SIZE);
+
+	/* Vector 10: AES-256, data unit 0xff */
+	_setup("27182818284590452353602874713526"
+	       "62497757247093699959574966967627",
+	       "31415926535897932384626433832795"
+	       "02884197169399375105820974944592", 32, SECTOR_SIZE);
+	_check_vector(0xff, plain, vector10_ct, SECTOR_SIZE);
+}
+
+/** Batched accesses match single-block processing */
+static void test_random_access(void)
+{
+	static uint8_t plain[SECTOR_COUNT * SECTOR_SIZE];
+	static uint8_t data[SECTOR_COUNT * SECTOR_SIZE];
+	uint8_t sector[SECTOR_SIZE];
+	uint32_t step, i, start, count;
+
+	_setup("000102030405060708090a0b0c0d0e0f",
+	       "f0e0d0c0b0a090807060504030201000", 16, SECTOR_SIZE);
+	for (i = 0; i < sizeof(plain); i++)
+		plain[i] = rand();
+	assert(media_write(&media, 0, plain, SECTOR_COUNT, NULL, NULL) ==
+	       MEDIA_STATUS_SUCCESS);
+
+	for (step = 0; step < 200; step++) {
+		count = 1 + rand() % (2 * MEDIA_XTS_MAX_BATCH + 5);
+		start = rand() % (SECTOR_COUNT - count + 1);
+		if (rand() % 2) {
+			for (i = 0; i < count * SECTOR_SIZE; i++)
+				plain[start * SECTOR_SIZE + i] = rand();
+			assert(media_write(&media, start, plain + start * SECTOR_SIZE,
+					   count, NULL, NULL) == MEDIA_STATUS_SUCCESS);
+		}
+		assert(media_read(&media, start, data, count, NULL, NULL) ==
+		       MEDIA_STATUS_SUCCESS);
+		assert(memcmp(data, plain + start * SECTOR_SIZE,
+			      count * SECTOR_SIZE) == 0);
+	}
+
+	/* Each sector on the disk is the single-block encryption */
+	for (i = 0; i < SECTOR_COUNT; i++) {
+		memcpy(sector, plain + i * SECTOR_SIZE, SECTOR_SIZE);
+		assert(media_xts_process(&xts, true, i, sector, 1) == 0);
+		assert(memcmp(sector, disk + i * SECTOR_SIZE, SECTOR_SIZE) == 0);
+	}
+
+	/* Out of range accesses are refused */
+	assert(media_read(&media, SECTOR_COUNT - 1, data, 2, NULL, NULL) ==
+	       MEDIA_STATUS_ERROR);
+}
+
+static void test_errors(void)
+{
+	uint8_t key[32] = { 0 };
+
+	assert(media_xts_soft_engine_init(&engine, &soft, key, key, 20) == -EINVAL);
+	assert(media_xts_soft_engine_init(&engine, &soft, key, key, 24) == 0);
+
+	/* block size not a multiple of the AES block, work buffer too small */
+	media_ramdisk_init(&ramdisk, (uint32_t)((uintptr_t)disk / SECTOR_SIZE),
+			SECTOR_COUNT, 24);
+	assert(media_xts_initialize(&media, &xts, &ramdisk, &engine, work,
+				    sizeof(work)) == MEDIA_STATUS_ERROR);
+	media_ramdisk_init(&ramdisk, (uint32_t)((uintptr_t)disk / SECTOR_SIZE),
+			SECTOR_COUNT, SECTOR_SIZE);
+	assert(media_xts_initialize(&media, &xts, &ramdisk, &engine, work,
+				    MEDIA_XTS_TWEAK_AREA_SIZE) == MEDIA_STATUS_ERROR);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	assert((uintptr_t)disk / SECTOR_SIZE < UINT32_MAX);
+
+	test_vectors();
+	test_random_access();
+	test_errors();
+	return 0;
+}
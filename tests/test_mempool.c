@@ -0,0 +1,195 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Block pool fuzz test. Blocks are allocated and released at random, filled
+ * with a pattern while they are held, and the statistics are checked
+ * against a model of the blocks in use.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errno.h"
+#include "mempool.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define STEP_COUNT  100000
+#define BLOCK_MAX   128
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+MEMPOOL_DECLARE(dma_pool, 40, 64);
+
+static struct _mempool small_pool;
+static void* small_storage[3 * 100];
+
+/** Fill byte of each block in use, indexed by block */
+static int held[BLOCK_MAX];
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _index(struct _mempool* pool, void* block)
+{
+	uintptr_t offset = (uint8_t*)block - pool->storage;
+
+	assert((uint8_t*)block >= pool->storage);
+	assert(offset % pool->block_size == 0);
+	assert(offset / pool->block_size < pool->count);
+	return offset / pool->block_size;
+}
+
+static void _check_pattern(struct _mempool* pool, uint32_t index)
+{
+	uint8_t* block = pool->storage + index * pool->block_size;
+	uint32_t i;
+
+	for (i = 0; i < pool->block_size; i++)
+		assert(block[i] == held[index]);
+}
+
+static void _fuzz(struct _mempool* pool, uint32_t align)
+{
+	struct _mempool_stats stats;
+	uint32_t step, i, index, used = 0, high_water = 0, failures = 0;
+	void* block;
+
+	assert(pool->count <= BLOCK_MAX);
+	for (i = 0; i < pool->count; i++)
+		held[i] = -1;
+
+	for (step = 0; step < STEP_COUNT; step++) {
+		/* Drift between an empty and a full pool */
+		if (rand() % 100 < (step / 5000 % 2 ? 30 : 70)) {
+			block = mempool_alloc(pool);
+			if (!block) {
+				assert(used == pool->count);
+				failures++;
+				continue;
+			}
+			assert((uintptr_t)block % align == 0);
+			assert(mempool_contains(pool, block));
+			index = _index(pool, block);
+			assert(held[index] < 0);
+			held[index] = rand() & 0xff;
+			memset(block, held[index], pool->block_size);
+			used++;
+			if (used > high_water)
+				high_water = used;
+		} else {
+			if (!used)
+				continue;
+			do {
+				index = rand() % pool->count;
+			} while (held[index] < 0);
+			_check_pattern(pool, index);
+			mempool_free(pool, pool->storage + index * pool->block_size);
+			held[index] = -1;
+			used--;
+		}
+
+		mempool_get_stats(pool, &stats);
+		assert(stats.used == used);
+		assert(stats.high_water == high_water);
+		assert(stats.failures == failures);
+	}
+
+	/* Blocks in use are untouched by the pool */
+	for (i = 0; i < pool->count; i++)
+		if (held[i] >= 0)
+			_check_pattern(pool, i);
+
+	mempool_reset_stats(pool);
+	mempool_get_stats(pool, &stats);
+	assert(stats.high_water == used && stats.failures == 0);
+
+	for (i = 0; i < pool->count; i++)
+		if (held[i] >= 0)
+			mempool_free(pool, pool->storage + i * pool->block_size);
+	mempool_free(pool, NULL);
+	mempool_get_stats(pool, &stats);
+	assert(stats.used == 0);
+	printf("%u blocks of %u bytes: %u failures\n", pool->count,
+	       pool->block_size, failures);
+}
+
+static void test_contains(void)
+{
+	void* first;
+	void* second;
+
+	assert(mempool_init(&small_pool, small_storage, sizeof(void*) - 1, 4) == -EINVAL);
+	assert(mempool_init(&small_pool, small_storage, sizeof(void*) + 1, 4) == -EINVAL);
+	assert(mempool_init(&small_pool, small_storage, 3 * sizeof(void*), 100) == 0);
+
+	/* Blocks are carved in order, only carved blocks belong to the pool */
+	assert(!mempool_contains(&small_pool, small_storage));
+	first = mempool_alloc(&small_pool);
+	second = mempool_alloc(&small_pool);
+	assert(first == (void*)small_storage);
+	assert(second == (void*)&small_storage[3]);
+	assert(mempool_contains(&small_pool, second));
+	assert(!mempool_contains(&small_pool, (uint8_t*)second + 1));
+	assert(!mempool_contains(&small_pool, &small_storage[6]));
+	assert(!mempool_contains(&small_pool, (uint8_t*)small_storage - 3 * sizeof(void*)));
+
+	/* Released blocks are reused first */
+	mempool_free(&small_pool, first);
+	assert(mempool_alloc(&small_pool) == first);
+	mempool_free(&small_pool, first);
+	mempool_free(&small_pool, second);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	srand(1);
+	test_contains();
+	assert(mempool_init(&small_pool, small_storage, 3 * sizeof(void*), 100) == 0);
+	_fuzz(&small_pool, sizeof(void*));
+	_fuzz(&dma_pool, L1_CACHE_BYTES);
+	assert(dma_pool.block_size == MEMPOOL_BLOCK_SIZE(40, L1_CACHE_BYTES));
+	return 0;
+}
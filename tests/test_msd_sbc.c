@@ -0,0 +1,562 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Mass storage SBC simulation. The BOT state machine, the SBC methods, the
+ * LUNs and their FIFO run unchanged against a simulated host and media, in
+ * virtual time: the USB endpoints and the media complete their transfers
+ * after a delay computed from their latency and throughput, and every pass
+ * of the state machine costs CPU_NS. Transfers copy their data when they
+ * complete, so a buffer reused while it is still in flight is caught.
+ *
+ * The host checks every byte it reads against its own copy of the disks.
+ * The sequential and random access throughputs are reported, and the
+ * read-ahead is checked to hit on sequential streams only, and to be
+ * dropped when a WRITE10 or another LUN reuses the FIFO buffer.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+#include "timer.h"
+#include "libstoragemedia/media.h"
+#include "libstoragemedia/media_private.h"
+#include "usb/device/usbd.h"
+#include "usb/device/msd/msd.h"
+#include "usb/device/msd/msd_lun.h"
+#include "usb/device/msd/msdd_state_machine.h"
+#include "usb/device/msd/sbc.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define BLOCK_SIZE        512
+#define LUN_COUNT         2
+#define LUN_BLOCKS        (8 * 1024 * 1024 / BLOCK_SIZE)
+#define FIFO_SIZE         (128 * 1024)
+
+#define EP_OUT            1
+#define EP_IN             2
+
+/* Costs in virtual time (ns): a pass of the state machine, a bulk transfer
+ * on a high-speed bus, the host between a CSW and the next CBW, and an
+ * access to a managed NAND or SD card */
+#define CPU_NS            500
+#define USB_XFER_NS       2000
+#define USB_BYTE_NS       25
+#define HOST_CMD_NS       20000
+#define MEDIA_ACCESS_NS   100000
+#define MEDIA_BYTE_NS     30
+
+#define SEQ_BLOCKS        128
+#define SEQ_COMMANDS      64
+#define RANDOM_BLOCKS     8
+#define RANDOM_COMMANDS   256
+
+/** Transfer in flight on an endpoint or a media */
+struct _xfer {
+	bool pending;
+	uint64_t time;
+	uint8_t *data;
+	uint32_t length;
+	usbd_xfer_cb_t callback;
+	void *arg;
+};
+
+struct _sim_media {
+	struct _media media;
+	uint8_t *blocks;
+	bool write;
+	uint32_t address;
+	struct _xfer xfer;
+};
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+uint32_t trace_level = TRACE_LEVEL_SILENT;
+uint8_t trace_module_level[TRACE_MODULE_COUNT];
+
+/* The LUNs align their buffers through 32-bit addresses */
+static MSDDriver driver;
+static MSDLun luns[LUN_COUNT];
+static uint8_t fifo[FIFO_SIZE] __attribute__((aligned(32)));
+
+static struct _sim_media medias[LUN_COUNT];
+
+static uint64_t sim_time;
+static struct _xfer usb_out;
+static struct _xfer usb_in;
+static unsigned halts;
+
+/** Simulated host, one command at a time */
+static struct {
+	uint8_t *disks[LUN_COUNT];  /* what the host expects to read */
+	MSCbw cbw;
+	bool cbw_pending;           /* CBW not read by the device yet */
+	uint64_t cbw_time;          /* when the host sends the CBW */
+	const uint8_t *out_data;    /* WRITE10 data not read yet */
+	uint32_t out_length;
+	const uint8_t *in_data;     /* READ10 data expected */
+	uint32_t in_length;
+	bool busy;                  /* CSW not received yet */
+	uint8_t csw_status;
+	uint32_t tag;
+} host;
+
+static uint8_t write_data[SEQ_BLOCKS * BLOCK_SIZE];
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+/* USB device and timer stubs */
+
+uint64_t timer_get_tick(void)
+{
+	return sim_time / 1000000;
+}
+
+uint16_t usbd_get_data_size(uint8_t endpoint)
+{
+	assert(endpoint == EP_OUT);
+	if (sim_time < host.cbw_time)
+		return 0;
+	if (host.cbw_pending)
+		return MSD_CBW_SIZE;
+	return host.out_length > 512 ? 512 : host.out_length;
+}
+
+static void _xfer_start(struct _xfer *xfer, uint64_t delay, void *data,
+		uint32_t length, usbd_xfer_cb_t callback, void *arg)
+{
+	assert(!xfer->pending);
+	xfer->pending = true;
+	xfer->time = sim_time + delay;
+	xfer->data = data;
+	xfer->length = length;
+	xfer->callback = callback;
+	xfer->arg = arg;
+}
+
+uint8_t usbd_read(uint8_t endpoint, void *data, uint32_t length,
+		usbd_xfer_cb_t callback, void *callback_arg)
+{
+	assert(endpoint == EP_OUT);
+	if (usb_out.pending)
+		return USBD_STATUS_LOCKED;
+
+	/* The transfer ends with the CBW or with the data phase */
+	if (host.cbw_pending) {
+		assert(sim_time >= host.cbw_time);
+		length = length < MSD_CBW_SIZE ? length : MSD_CBW_SIZE;
+	} else {
+		assert(host.out_length > 0);
+		length = length < host.out_length ? length : host.out_length;
+	}
+	_xfer_start(&usb_out, USB_XFER_NS + length * USB_BYTE_NS,
+			data, length, callback, callback_arg);
+	return USBD_STATUS_SUCCESS;
+}
+
+uint8_t usbd_write(uint8_t endpoint, const void *data, uint32_t length,
+		usbd_xfer_cb_t callback, void *callback_arg)
+{
+	assert(endpoint == EP_IN);
+	if (usb_in.pending)
+		return USBD_STATUS_LOCKED;
+
+	_xfer_start(&usb_in, USB_XFER_NS + length * USB_BYTE_NS,
+			(void*)data, length, callback, callback_arg);
+	return USBD_STATUS_SUCCESS;
+}
+
+void usbd_halt(uint8_t endpoint)
+{
+	halts++;
+}
+
+bool usbd_is_halted(uint8_t endpoint)
+{
+	return false;
+}
+
+/* Simulated media */
+
+static uint8_t _media_start(struct _media *media, bool write,
+		uint32_t address, void *data, uint32_t length,
+		media_callback_t callback, void *callback_arg)
+{
+	struct _sim_media *sim = (struct _sim_media*)media->interface;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+	if (address + length > media->size)
+		return MEDIA_STATUS_ERROR;
+
+	media->state = MEDIA_STATE_BUSY;
+	sim->write = write;
+	sim->address = address;
+	_xfer_start(&sim->xfer, MEDIA_ACCESS_NS +
+			(uint64_t)length * BLOCK_SIZE * MEDIA_BYTE_NS,
+			data, length, callback, callback_arg);
+	return MEDIA_STATUS_SUCCESS;
+}
+
+static uint8_t _media_read(struct _media *media, uint32_t address,
+		void *data, uint32_t length, media_callback_t callback,
+		void *callback_arg)
+{
+	return _media_start(media, false, address, data, length,
+			callback, callback_arg);
+}
+
+static uint8_t _media_write(struct _media *media, uint32_t address,
+		void *data, uint32_t length, media_callback_t callback,
+		void *callback_arg)
+{
+	return _media_start(media, true, address, data, length,
+			callback, callback_arg);
+}
+
+/* Completions */
+
+static void _complete_usb_out(void)
+{
+	usb_out.pending = false;
+	if (host.cbw_pending) {
+		memcpy(usb_out.data, &host.cbw, usb_out.length);
+		host.cbw_pending = false;
+	} else {
+		memcpy(usb_out.data, host.out_data, usb_out.length);
+		host.out_data += usb_out.length;
+		host.out_length -= usb_out.length;
+	}
+	if (usb_out.callback)
+		usb_out.callback(usb_out.arg, USBD_STATUS_SUCCESS,
+				usb_out.length, 0);
+}
+
+static void _complete_usb_in(void)
+{
+	MSCsw csw;
+
+	usb_in.pending = false;
+	if (host.in_length > 0) {
+		assert(usb_in.length <= host.in_length);
+		assert(memcmp(usb_in.data, host.in_data, usb_in.length) == 0);
+		host.in_data += usb_in.length;
+		host.in_length -= usb_in.length;
+	} else {
+		assert(usb_in.length == MSD_CSW_SIZE);
+		memcpy(&csw, usb_in.data, MSD_CSW_SIZE);
+		assert(csw.dCSWSignature == MSD_CSW_SIGNATURE);
+		assert(csw.dCSWTag == host.tag);
+		assert(host.out_length == 0);
+		if (csw.bCSWStatus == MSD_CSW_COMMAND_PASSED)
+			assert(csw.dCSWDataResidue == 0);
+		host.csw_status = csw.bCSWStatus;
+		host.busy = false;
+	}
+	if (usb_in.callback)
+		usb_in.callback(usb_in.arg, USBD_STATUS_SUCCESS,
+				usb_in.length, 0);
+}
+
+static void _complete_media(struct _sim_media *sim)
+{
+	uint8_t *blocks = sim->blocks + sim->address * BLOCK_SIZE;
+	uint32_t size = sim->xfer.length * BLOCK_SIZE;
+
+	sim->xfer.pending = false;
+	if (sim->write)
+		memcpy(blocks, sim->xfer.data, size);
+	else
+		memcpy(sim->xfer.data, blocks, size);
+	sim->media.state = MEDIA_STATE_READY;
+	if (sim->xfer.callback)
+		sim->xfer.callback(sim->xfer.arg, MEDIA_STATUS_SUCCESS, 0, 0);
+}
+
+/** Advances the virtual time and completes the transfers due */
+static void _run(uint64_t ns)
+{
+	int i;
+
+	sim_time += ns;
+	if (usb_out.pending && usb_out.time <= sim_time)
+		_complete_usb_out();
+	if (usb_in.pending && usb_in.time <= sim_time)
+		_complete_usb_in();
+	for (i = 0; i < LUN_COUNT; i++)
+		if (medias[i].xfer.pending && medias[i].xfer.time <= sim_time)
+			_complete_media(&medias[i]);
+}
+
+/** Runs a command from the host until its CSW is received */
+static uint8_t _host_command(uint8_t lun, uint8_t opcode, uint32_t lba,
+		uint16_t blocks, const uint8_t *data)
+{
+	SBCRead10 *command = (SBCRead10*)host.cbw.pCommand;
+	uint32_t length = blocks * BLOCK_SIZE;
+
+	memset(&host.cbw, 0, sizeof(host.cbw));
+	host.cbw.dCBWSignature = MSD_CBW_SIGNATURE;
+	host.cbw.dCBWTag = ++host.tag;
+	host.cbw.bCBWLUN = lun;
+	host.cbw.bCBWCBLength = 10;
+	command->bOperationCode = opcode;
+
+	if (opcode == SBC_READ_10 || opcode == SBC_WRITE_10) {
+		/* Both commands have the same layout */
+		STORE_DWORDB(lba, command->pLogicalBlockAddress);
+		STORE_WORDB(blocks, command->pTransferLength);
+		host.cbw.dCBWDataTransferLength = length;
+	}
+	if (opcode == SBC_READ_10) {
+		host.cbw.bmCBWFlags = MSD_CBW_DEVICE_TO_HOST;
+		host.in_data = host.disks[lun] + lba * BLOCK_SIZE;
+		host.in_length = length;
+	} else if (opcode == SBC_WRITE_10) {
+		memcpy(host.disks[lun] + lba * BLOCK_SIZE, data, length);
+		host.out_data = data;
+		host.out_length = length;
+	}
+
+	host.cbw_pending = true;
+	host.cbw_time = sim_time + HOST_CMD_NS;
+	host.busy = true;
+	while (host.busy) {
+		msdd_state_machine(&driver);
+		_run(CPU_NS);
+	}
+	return host.csw_status;
+}
+
+static uint32_t _rand(void)
+{
+	static uint32_t state = 0x2545f491;
+
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+static void _fill_random(uint8_t *data, uint32_t size)
+{
+	uint32_t i;
+
+	for (i = 0; i < size; i++)
+		data[i] = (uint8_t)_rand();
+}
+
+static double _mb_per_s(uint64_t bytes, uint64_t ns)
+{
+	return bytes * 1000.0 / ns;
+}
+
+static void _init(void)
+{
+	struct _sim_media *sim;
+	int i;
+
+	for (i = 0; i < LUN_COUNT; i++) {
+		sim = &medias[i];
+		sim->blocks = malloc(LUN_BLOCKS * BLOCK_SIZE);
+		host.disks[i] = malloc(LUN_BLOCKS * BLOCK_SIZE);
+		assert(sim->blocks && host.disks[i]);
+		_fill_random(sim->blocks, LUN_BLOCKS * BLOCK_SIZE);
+		memcpy(host.disks[i], sim->blocks, LUN_BLOCKS * BLOCK_SIZE);
+
+		sim->media.read = _media_read;
+		sim->media.write = _media_write;
+		sim->media.block_size = BLOCK_SIZE;
+		sim->media.size = LUN_BLOCKS;
+		sim->media.interface = sim;
+		sim->media.state = MEDIA_STATE_READY;
+
+		/* The LUNs share the FIFO buffer */
+		lun_init(&luns[i], &sim->media, fifo, FIFO_SIZE, 0, 0, 0, 0, NULL);
+	}
+
+	driver.luns = luns;
+	driver.maxLun = LUN_COUNT - 1;
+	driver.commandState.pipeIN = EP_IN;
+	driver.commandState.pipeOUT = EP_OUT;
+	driver.state = MSDD_STATE_READ_CBW;
+
+	/* The first TEST UNIT READY reports the media change */
+	for (i = 0; i < LUN_COUNT; i++) {
+		assert(_host_command(i, SBC_TEST_UNIT_READY, 0, 0, NULL)
+				!= MSD_CSW_COMMAND_PASSED);
+		assert(_host_command(i, SBC_TEST_UNIT_READY, 0, 0, NULL)
+				== MSD_CSW_COMMAND_PASSED);
+	}
+}
+
+static void test_sequential_read(void)
+{
+	uint32_t hits = luns[0].statistics.dReadAheadHits;
+	uint64_t start = sim_time;
+	int i;
+
+	for (i = 0; i < SEQ_COMMANDS; i++)
+		assert(_host_command(0, SBC_READ_10, i * SEQ_BLOCKS, SEQ_BLOCKS,
+				NULL) == MSD_CSW_COMMAND_PASSED);
+
+	hits = luns[0].statistics.dReadAheadHits - hits;
+	printf("sequential read  %6.1f MB/s, %u read-ahead hits in %u commands\n",
+		_mb_per_s(SEQ_COMMANDS * SEQ_BLOCKS * BLOCK_SIZE, sim_time - start),
+		(unsigned)hits, SEQ_COMMANDS);
+
+	/* Every command but the first continues the stream */
+	assert(hits == SEQ_COMMANDS - 1);
+}
+
+static void test_random_read(void)
+{
+	uint32_t hits = luns[0].statistics.dReadAheadHits;
+	uint64_t start = sim_time;
+	uint32_t lba, next = 0;
+	int i;
+
+	for (i = 0; i < RANDOM_COMMANDS; i++) {
+		do {
+			lba = _rand() % (LUN_BLOCKS / RANDOM_BLOCKS) * RANDOM_BLOCKS;
+		} while (lba == next);
+		next = lba + RANDOM_BLOCKS;
+		assert(_host_command(0, SBC_READ_10, lba, RANDOM_BLOCKS, NULL)
+				== MSD_CSW_COMMAND_PASSED);
+	}
+
+	hits = luns[0].statistics.dReadAheadHits - hits;
+	printf("random read      %6.1f MB/s, %u read-ahead hits in %u commands\n",
+		_mb_per_s(RANDOM_COMMANDS * RANDOM_BLOCKS * BLOCK_SIZE,
+			sim_time - start), (unsigned)hits, RANDOM_COMMANDS);
+	assert(hits == 0);
+}
+
+static void test_sequential_write(void)
+{
+	uint32_t base = LUN_BLOCKS / 2;
+	uint64_t start = sim_time;
+	int i;
+
+	for (i = 0; i < SEQ_COMMANDS; i++) {
+		_fill_random(write_data, sizeof(write_data));
+		assert(_host_command(0, SBC_WRITE_10, base + i * SEQ_BLOCKS,
+				SEQ_BLOCKS, write_data) == MSD_CSW_COMMAND_PASSED);
+	}
+
+	printf("sequential write %6.1f MB/s\n",
+		_mb_per_s(SEQ_COMMANDS * SEQ_BLOCKS * BLOCK_SIZE, sim_time - start));
+	assert(memcmp(medias[0].blocks, host.disks[0],
+			LUN_BLOCKS * BLOCK_SIZE) == 0);
+}
+
+static void test_read_ahead_cancel(void)
+{
+	MSDIOFifo *fifo = &luns[0].ioFifo;
+	uint32_t base = 1024;
+	uint32_t hits;
+	int i;
+
+	/* The third command of a stream hits */
+	for (i = 0; i < 3; i++) {
+		hits = luns[0].statistics.dReadAheadHits;
+		assert(_host_command(0, SBC_READ_10, base + i * SEQ_BLOCKS,
+				SEQ_BLOCKS, NULL) == MSD_CSW_COMMAND_PASSED);
+	}
+	assert(luns[0].statistics.dReadAheadHits == hits + 1);
+
+	/* A WRITE10 in the range read ahead waits for the read-ahead and
+	 * drops it, the next READ10 gets the new data from the media */
+	assert(fifo->aheadState == MSDIO_WAIT);
+	_fill_random(write_data, BLOCK_SIZE);
+	assert(_host_command(0, SBC_WRITE_10, base + 3 * SEQ_BLOCKS + 1, 1,
+			write_data) == MSD_CSW_COMMAND_PASSED);
+	hits = luns[0].statistics.dReadAheadHits;
+	assert(_host_command(0, SBC_READ_10, base + 3 * SEQ_BLOCKS, SEQ_BLOCKS,
+			NULL) == MSD_CSW_COMMAND_PASSED);
+	assert(luns[0].statistics.dReadAheadHits == hits);
+}
+
+static void test_lun_interleave(void)
+{
+	uint32_t hits[LUN_COUNT];
+	uint32_t base = 4096;
+	int i;
+
+	for (i = 0; i < LUN_COUNT; i++)
+		hits[i] = luns[i].statistics.dReadAheadHits;
+
+	/* Each LUN reads a sequential stream, but the commands of the other
+	 * LUN overwrite the shared FIFO buffer in between */
+	for (i = 0; i < 16; i++) {
+		assert(_host_command(i % LUN_COUNT, SBC_READ_10,
+				base + i / LUN_COUNT * SEQ_BLOCKS, SEQ_BLOCKS, NULL)
+				== MSD_CSW_COMMAND_PASSED);
+		if (i == 8) {
+			_fill_random(write_data, sizeof(write_data));
+			assert(_host_command(1, SBC_WRITE_10, base + 5 * SEQ_BLOCKS,
+					SEQ_BLOCKS, write_data) == MSD_CSW_COMMAND_PASSED);
+		}
+	}
+
+	for (i = 0; i < LUN_COUNT; i++)
+		assert(luns[i].statistics.dReadAheadHits == hits[i]);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	_init();
+
+	test_sequential_read();
+	test_random_read();
+	test_sequential_write();
+	test_read_ahead_cancel();
+	test_lun_interleave();
+
+	assert(halts == 0);
+	return 0;
+}
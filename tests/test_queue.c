@@ -0,0 +1,192 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Queue stress test with host threads. Each element carries its producer
+ * and a per-producer sequence number. The consumer checks that the elements
+ * of each producer come out in order, and that none is lost or duplicated.
+ * The queues are small so that producers often find them full.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "errno.h"
+#include "queue.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define PRODUCER_COUNT 4
+#define ELEM_COUNT     200000
+#define QUEUE_SIZE     16
+
+struct _elem {
+	uint32_t producer;
+	uint32_t seq;
+};
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _spsc_queue spsc;
+static struct _elem spsc_buffer[QUEUE_SIZE];
+
+static struct _mpsc_queue mpsc;
+static struct _elem mpsc_buffer[QUEUE_SIZE];
+static uint32_t mpsc_seq[QUEUE_SIZE];
+
+static uint32_t full_count[PRODUCER_COUNT];
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+/** SPSC producer, pushing batches of random length */
+static void* _spsc_producer(void* arg)
+{
+	struct _elem batch[QUEUE_SIZE];
+	uint32_t seq = 0, len, written, i;
+	unsigned int rand_state = 1;
+
+	while (seq < ELEM_COUNT) {
+		len = 1 + rand_r(&rand_state) % QUEUE_SIZE;
+		if (len > ELEM_COUNT - seq)
+			len = ELEM_COUNT - seq;
+		for (i = 0; i < len; i++) {
+			batch[i].producer = 0;
+			batch[i].seq = seq + i;
+		}
+		if (len == 1)
+			written = spsc_queue_push(&spsc, batch) ? 1 : 0;
+		else
+			written = spsc_queue_write(&spsc, batch, len);
+		seq += written;
+		if (written < len)
+			sched_yield();
+	}
+	return NULL;
+}
+
+static void test_spsc(void)
+{
+	struct _elem batch[QUEUE_SIZE];
+	uint32_t expected = 0, len, i;
+	unsigned int rand_state = 2;
+	pthread_t producer;
+
+	assert(spsc_queue_init(&spsc, spsc_buffer, sizeof(struct _elem), 12) == -EINVAL);
+	assert(spsc_queue_init(&spsc, spsc_buffer, sizeof(struct _elem), QUEUE_SIZE) == 0);
+	assert(pthread_create(&producer, NULL, _spsc_producer, NULL) == 0);
+
+	while (expected < ELEM_COUNT) {
+		if (rand_r(&rand_state) % 2)
+			len = spsc_queue_pop(&spsc, batch) ? 1 : 0;
+		else
+			len = spsc_queue_read(&spsc, batch,
+					1 + rand_r(&rand_state) % QUEUE_SIZE);
+		for (i = 0; i < len; i++)
+			assert(batch[i].seq == expected++);
+		if (!len)
+			sched_yield();
+	}
+
+	assert(pthread_join(producer, NULL) == 0);
+	assert(spsc_queue_is_empty(&spsc));
+	assert(spsc_queue_space(&spsc) == QUEUE_SIZE);
+}
+
+static void* _mpsc_producer(void* arg)
+{
+	struct _elem elem = { .producer = (uint32_t)(uintptr_t)arg };
+
+	for (elem.seq = 0; elem.seq < ELEM_COUNT; elem.seq++) {
+		while (!mpsc_queue_push(&mpsc, &elem)) {
+			full_count[elem.producer]++;
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static void test_mpsc(void)
+{
+	uint32_t expected[PRODUCER_COUNT] = { 0 };
+	pthread_t producers[PRODUCER_COUNT];
+	uint32_t received = 0, full = 0, p;
+	struct _elem elem;
+
+	assert(mpsc_queue_init(&mpsc, mpsc_buffer, mpsc_seq, sizeof(elem), 12) == -EINVAL);
+	assert(mpsc_queue_init(&mpsc, mpsc_buffer, mpsc_seq, sizeof(elem), QUEUE_SIZE) == 0);
+	for (p = 0; p < PRODUCER_COUNT; p++)
+		assert(pthread_create(&producers[p], NULL, _mpsc_producer,
+				      (void*)(uintptr_t)p) == 0);
+
+	while (received < PRODUCER_COUNT * ELEM_COUNT) {
+		if (!mpsc_queue_pop(&mpsc, &elem)) {
+			sched_yield();
+			continue;
+		}
+		/* in order per producer: nothing lost, nothing duplicated */
+		assert(elem.producer < PRODUCER_COUNT);
+		assert(elem.seq == expected[elem.producer]);
+		expected[elem.producer]++;
+		received++;
+	}
+
+	for (p = 0; p < PRODUCER_COUNT; p++) {
+		assert(pthread_join(producers[p], NULL) == 0);
+		assert(expected[p] == ELEM_COUNT);
+		full += full_count[p];
+	}
+	assert(mpsc_queue_count(&mpsc) == 0);
+	assert(!mpsc_queue_pop(&mpsc, &elem));
+	printf("mpsc: %u elements from %u producers, found full %u times\n",
+	       received, PRODUCER_COUNT, full);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	test_spsc();
+	test_mpsc();
+	return 0;
+}
@@ -0,0 +1,183 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Random generator test. random.c is included to check the ChaCha20 block
+ * function against the RFC 8439 vector. The generator must refuse output
+ * while a due reseed fails, and concurrent requests must never be served
+ * the same block.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "random.c"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define THREAD_COUNT 4
+#define THREAD_BLOCKS 20000
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static int source_error;
+static uint32_t source_calls;
+
+static uint32_t blocks[THREAD_COUNT * THREAD_BLOCKS][CHACHA_BLOCK_WORDS];
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static int _source(uint8_t* buffer, uint32_t len, void* arg)
+{
+	source_calls++;
+	if (source_error)
+		return source_error;
+	memset(buffer, source_calls, len);
+	return 0;
+}
+
+/** RFC 8439 section 2.3.2 */
+static void test_block(void)
+{
+	static const uint32_t expected[CHACHA_BLOCK_WORDS] = {
+		0xe4e7f110, 0x15593bd1, 0x1fdd0f50, 0xc47120a3,
+		0xc7f4d1c7, 0x0368c033, 0x9aaa2204, 0x4e6cd4c3,
+		0x466482d2, 0x09aa9f07, 0x05d7c214, 0xa2028bd9,
+		0xd19c12b5, 0xb94e16de, 0xe883d0cb, 0x4e3c50a2,
+	};
+	uint32_t key[CHACHA_KEY_WORDS], out[CHACHA_BLOCK_WORDS];
+	uint32_t i;
+
+	for (i = 0; i < CHACHA_KEY_WORDS; i++)
+		key[i] = 0x03020100 + 0x04040404 * i;
+	/* counter 1, nonce 00:00:00:09:00:00:00:4a:00:00:00:00 */
+	_chacha20_block(key, 1 | (UINT64_C(0x09000000) << 32), 0x4a000000, out);
+	for (i = 0; i < CHACHA_BLOCK_WORDS; i++)
+		assert(out[i] == expected[i]);
+}
+
+static void test_reseed_failure(void)
+{
+	uint8_t buffer[100], copy[100];
+	uint32_t value;
+
+	source_error = 0;
+	assert(random_init(_source, NULL) == 0);
+	assert(!random_is_deterministic());
+	assert(random_fill(buffer, sizeof(buffer)) == 0);
+	assert(random_u32(&value) == 0);
+
+	/* A due reseed that fails stops the output */
+	_random.since_reseed = RANDOM_RESEED_INTERVAL;
+	source_error = -EIO;
+	memcpy(copy, buffer, sizeof(buffer));
+	assert(random_fill(buffer, sizeof(buffer)) == -EIO);
+	assert(memcmp(buffer, copy, sizeof(buffer)) == 0);
+	assert(random_u32(&value) == -EIO);
+	assert(random_reseed() == -EIO);
+
+	/* and resumes once the source recovers */
+	source_error = 0;
+	assert(random_fill(buffer + 1, sizeof(buffer) - 1) == 0);
+	assert(_random.since_reseed == 2 * CHACHA_BLOCK_SIZE);
+}
+
+static void test_deterministic(void)
+{
+	uint8_t first[200], second[200];
+
+	assert(random_init(NULL, NULL) == 0);
+	assert(random_is_deterministic());
+	assert(random_fill(first, sizeof(first)) == 0);
+	assert(random_init(NULL, NULL) == 0);
+	assert(random_fill(second, sizeof(second)) == 0);
+	assert(memcmp(first, second, sizeof(first)) == 0);
+
+	/* fast key erasure: the next request is not a continuation */
+	assert(random_fill(second, sizeof(second)) == 0);
+	assert(memcmp(first, second, sizeof(first)) != 0);
+}
+
+static void* _fill_thread(void* arg)
+{
+	uint32_t first = (uint32_t)(uintptr_t)arg * THREAD_BLOCKS;
+	uint32_t i;
+
+	for (i = 0; i < THREAD_BLOCKS; i++)
+		assert(random_fill(blocks[first + i], sizeof(blocks[0])) == 0);
+	return NULL;
+}
+
+static int _compare_blocks(const void* a, const void* b)
+{
+	return memcmp(a, b, sizeof(blocks[0]));
+}
+
+/** Requests from concurrent contexts never get the same block */
+static void test_concurrent(void)
+{
+	pthread_t threads[THREAD_COUNT];
+	uint32_t i;
+
+	assert(random_init(NULL, NULL) == 0);
+	for (i = 0; i < THREAD_COUNT; i++)
+		assert(pthread_create(&threads[i], NULL, _fill_thread,
+				      (void*)(uintptr_t)i) == 0);
+	for (i = 0; i < THREAD_COUNT; i++)
+		assert(pthread_join(threads[i], NULL) == 0);
+
+	qsort(blocks, ARRAY_SIZE(blocks), sizeof(blocks[0]), _compare_blocks);
+	for (i = 1; i < ARRAY_SIZE(blocks); i++)
+		assert(_compare_blocks(blocks[i - 1], blocks[i]) != 0);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	test_block();
+	test_reseed_failure();
+	test_deterministic();
+	test_concurrent();
+	return 0;
+}
@@ -0,0 +1,301 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Raster fill and clip test. Random rectangles, horizontal and vertical
+ * lines, some of them partly or fully outside the raster or with negative
+ * sizes, are filled at 16, 24 and 32 bpp under random clip rectangles, and
+ * the frame buffer is compared with a pixel by pixel reference. The line
+ * padding must stay untouched, and every byte modified must be cleaned
+ * from the data cache by the next raster_flush(). Strings are drawn at
+ * random positions to check that they respect the clip rectangle too.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "graphics/font.h"
+#include "graphics/raster.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+/* Odd sizes, so that spans start and end at every alignment */
+#define WIDTH     97
+#define HEIGHT    61
+
+#define FUZZ_OPS  3000
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _raster raster;
+static uint8_t *buffer;
+static uint8_t *reference;
+static uint8_t *flushed;
+static uint8_t *cleaned;
+static uint32_t buffer_size;
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+/* Cache stub, records the bytes cleaned */
+void cache_clean_region(const void *start, uint32_t length)
+{
+	const uint8_t *p = (const uint8_t*)start;
+
+	assert(p >= buffer && p + length <= buffer + buffer_size);
+	memset(cleaned + (p - buffer), 1, length);
+}
+
+static int32_t _rand_range(int32_t min, int32_t max)
+{
+	return min + rand() % (max - min + 1);
+}
+
+static uint32_t _rand32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static void _setup(uint8_t bpp, uint32_t padding)
+{
+	uint32_t stride;
+
+	free(buffer);
+	free(reference);
+	free(flushed);
+	free(cleaned);
+
+	stride = ((WIDTH * (bpp / 8) + 3) & ~3) + padding;
+	buffer_size = stride * HEIGHT;
+	buffer = malloc(buffer_size);
+	reference = malloc(buffer_size);
+	flushed = malloc(buffer_size);
+	cleaned = calloc(1, buffer_size);
+	assert(buffer && reference && flushed && cleaned);
+
+	memset(buffer, 0x5a, buffer_size);
+	memcpy(reference, buffer, buffer_size);
+	memcpy(flushed, buffer, buffer_size);
+
+	assert(raster_init(&raster, buffer, WIDTH, HEIGHT, bpp,
+			padding ? stride : 0) == 0);
+	assert(raster.stride == stride);
+}
+
+/** Reference fill, pixel by pixel */
+static void _ref_fill(int32_t x, int32_t y, int32_t w, int32_t h,
+		uint32_t color)
+{
+	uint32_t bytes = raster.bpp / 8;
+	int32_t i, j;
+	uint32_t b;
+
+	for (j = y; j < y + h; j++) {
+		for (i = x; i < x + w; i++) {
+			if (i < raster.clip.x0 || i >= raster.clip.x1 ||
+			    j < raster.clip.y0 || j >= raster.clip.y1)
+				continue;
+			for (b = 0; b < bytes; b++)
+				reference[j * raster.stride + i * bytes + b] =
+					color >> (8 * b);
+		}
+	}
+}
+
+/** Every byte modified since the last flush must have been cleaned */
+static void _check_flush(void)
+{
+	uint32_t i;
+
+	raster_flush(&raster);
+	assert(!raster_is_dirty(&raster));
+	for (i = 0; i < buffer_size; i++)
+		if (buffer[i] != flushed[i])
+			assert(cleaned[i]);
+	memcpy(flushed, buffer, buffer_size);
+	memset(cleaned, 0, buffer_size);
+}
+
+static void _random_clip(void)
+{
+	switch (rand() % 4) {
+	case 0:
+		raster_reset_clip(&raster);
+		break;
+	default:
+		raster_set_clip(&raster, _rand_range(-20, WIDTH),
+				_rand_range(-20, HEIGHT), _rand_range(-5, WIDTH + 20),
+				_rand_range(-5, HEIGHT + 20));
+		break;
+	}
+
+	/* The clip rectangle never leaves the raster */
+	assert(raster.clip.x0 >= 0 && raster.clip.x0 <= raster.clip.x1);
+	assert(raster.clip.y0 >= 0 && raster.clip.y0 <= raster.clip.y1);
+	assert(raster.clip.x1 <= WIDTH && raster.clip.y1 <= HEIGHT);
+}
+
+static void _fuzz_fill(uint8_t bpp, uint32_t padding)
+{
+	uint32_t color;
+	int32_t x, y, w, h;
+	int op;
+
+	_setup(bpp, padding);
+
+	for (op = 0; op < FUZZ_OPS; op++) {
+		if (op % 16 == 0)
+			_random_clip();
+
+		color = _rand32();
+		x = _rand_range(-WIDTH, 2 * WIDTH);
+		y = _rand_range(-HEIGHT, 2 * HEIGHT);
+		w = _rand_range(-4, WIDTH + 8);
+		h = _rand_range(-4, HEIGHT + 8);
+
+		switch (rand() % 3) {
+		case 0:
+			raster_fill_rect(&raster, x, y, w, h, color);
+			_ref_fill(x, y, w, h, color);
+			break;
+		case 1:
+			raster_draw_hline(&raster, x, y, w, color);
+			_ref_fill(x, y, w, 1, color);
+			break;
+		case 2:
+			raster_draw_vline(&raster, x, y, h, color);
+			_ref_fill(x, y, 1, h, color);
+			break;
+		}
+		assert(memcmp(buffer, reference, buffer_size) == 0);
+
+		if (op % 8 == 7)
+			_check_flush();
+	}
+	_check_flush();
+}
+
+static void test_fill(void)
+{
+	srand(1);
+	_fuzz_fill(16, 0);
+	_fuzz_fill(16, 6);
+	_fuzz_fill(24, 0);
+	_fuzz_fill(24, 4);
+	_fuzz_fill(32, 0);
+	_fuzz_fill(32, 8);
+}
+
+static void test_clip_edges(void)
+{
+	_setup(16, 0);
+
+	/* Empty and inverted clip rectangles draw nothing */
+	raster_set_clip(&raster, 10, 10, 0, 5);
+	raster_fill_rect(&raster, 0, 0, WIDTH, HEIGHT, 0xffff);
+	raster_set_clip(&raster, 10, 10, -5, -5);
+	raster_fill_rect(&raster, 0, 0, WIDTH, HEIGHT, 0xffff);
+	raster_set_clip(&raster, WIDTH + 10, HEIGHT + 10, 5, 5);
+	raster_fill_rect(&raster, 0, 0, WIDTH, HEIGHT, 0xffff);
+	assert(memcmp(buffer, reference, buffer_size) == 0);
+	assert(!raster_is_dirty(&raster));
+
+	/* Spans ending exactly on the clip edges */
+	raster_set_clip(&raster, 3, 4, 10, 10);
+	raster_fill_rect(&raster, 13, 4, 1, 10, 0x1234);
+	raster_fill_rect(&raster, 3, 14, 10, 1, 0x1234);
+	assert(memcmp(buffer, reference, buffer_size) == 0);
+	raster_fill_rect(&raster, 12, 13, 1, 1, 0x1234);
+	raster_fill_rect(&raster, 2, 3, 2, 2, 0x1234);
+	_ref_fill(12, 13, 1, 1, 0x1234);
+	_ref_fill(3, 4, 1, 1, 0x1234);
+	assert(memcmp(buffer, reference, buffer_size) == 0);
+	assert(raster_read_pixel(&raster, 12, 13) == 0x1234);
+	assert(raster_read_pixel(&raster, 3, 4) == 0x1234);
+	_check_flush();
+}
+
+static void test_text_clip(void)
+{
+	static const char text[] = "Hello,\nraster! 0123456789";
+	uint32_t bytes;
+	int32_t x, y;
+	uint32_t i;
+	int op;
+
+	_setup(24, 0);
+	bytes = raster.bpp / 8;
+	srand(2);
+
+	for (op = 0; op < 500; op++) {
+		_random_clip();
+		if (rand() & 1)
+			raster_draw_string(&raster, rand() % NB_FONT,
+					_rand_range(-40, WIDTH), _rand_range(-30, HEIGHT),
+					text, _rand32());
+		else
+			raster_draw_string_with_bgcolor(&raster, rand() % NB_FONT,
+					_rand_range(-40, WIDTH), _rand_range(-30, HEIGHT),
+					text, _rand32(), _rand32());
+
+		/* Nothing changed outside the clip rectangle */
+		for (i = 0; i < buffer_size; i++) {
+			if (buffer[i] == flushed[i])
+				continue;
+			y = i / raster.stride;
+			x = i % raster.stride / bytes;
+			assert(x >= raster.clip.x0 && x < raster.clip.x1);
+			assert(y >= raster.clip.y0 && y < raster.clip.y1);
+		}
+		_check_flush();
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	test_fill();
+	test_clip_edges();
+	test_text_clip();
+	return 0;
+}
@@ -0,0 +1,311 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Timer wheel test against a reference model that keeps the pending entries
+ * in a list sorted by expiry. Entries are added, moved and removed at random,
+ * with one-shot and periodic entries and expiries from one unit to 2^40
+ * units away. Callbacks modify the wheel too. Each callback must be the
+ * earliest entry of the model, called at its expiry.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "timer_wheel.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define ENTRY_COUNT 256
+#define STEP_COUNT  200000
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _timer_wheel wheel;
+static struct _timer_wheel_entry entries[ENTRY_COUNT];
+
+/** Reference model: pending entries sorted by time of call */
+static uint32_t model[ENTRY_COUNT];
+static uint64_t model_due[ENTRY_COUNT];
+static uint32_t model_count;
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15;
+static uint32_t call_count;
+static bool callbacks_modify;
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint64_t _rand64(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 7;
+	rng_state ^= rng_state << 17;
+	return rng_state;
+}
+
+/** Delay of one unit up to 2^40 units, small delays being the most common */
+static uint64_t _rand_delay(void)
+{
+	return 1 + (_rand64() >> (24 + _rand64() % 40));
+}
+
+static int _model_find(uint32_t id)
+{
+	uint32_t i;
+
+	for (i = 0; i < model_count; i++)
+		if (model[i] == id)
+			return i;
+	return -1;
+}
+
+static void _model_remove(uint32_t id)
+{
+	int i = _model_find(id);
+
+	if (i < 0)
+		return;
+	memmove(&model[i], &model[i + 1], (model_count - i - 1) * sizeof(model[0]));
+	model_count--;
+}
+
+static void _model_insert(uint32_t id)
+{
+	/* The wheel calls late entries at its current time */
+	uint64_t due = entries[id].expires > wheel.now ? entries[id].expires : wheel.now;
+	uint32_t i;
+
+	_model_remove(id);
+	for (i = model_count; i > 0 && model_due[model[i - 1]] > due; i--)
+		model[i] = model[i - 1];
+	model[i] = id;
+	model_due[id] = due;
+	model_count++;
+}
+
+static void _check(void)
+{
+	uint64_t next = timer_wheel_next_expiry(&wheel);
+	uint32_t i;
+
+	for (i = 0; i < ENTRY_COUNT; i++)
+		assert(timer_wheel_is_pending(&entries[i]) == (_model_find(i) >= 0));
+
+	/* Cascades may make the wheel wake up before the first expiry */
+	if (model_count == 0)
+		assert(next == TIMER_WHEEL_NEVER);
+	else
+		assert(next >= wheel.now && next <= model_due[model[0]]);
+}
+
+static void _add(uint32_t id, uint64_t base)
+{
+	struct _timer_wheel_entry* entry = &entries[id];
+
+	/* Some entries are late */
+	if (_rand64() % 16 == 0)
+		entry->expires = base - _rand64() % (base < 1000 ? base + 1 : 1000);
+	else
+		entry->expires = base + _rand64() % 4 * _rand_delay();
+	entry->period = _rand64() % 4 == 0 ? _rand_delay() : 0;
+	timer_wheel_add(&wheel, entry);
+	_model_insert(id);
+}
+
+static void _remove(uint32_t id)
+{
+	timer_wheel_remove(&wheel, &entries[id]);
+	_model_remove(id);
+}
+
+static int _callback(void* arg, void* arg2)
+{
+	struct _timer_wheel_entry* entry = arg2;
+	uint32_t id = (uint32_t)(uintptr_t)arg;
+	uint32_t other;
+
+	assert(entry == &entries[id]);
+	assert(model_count > 0);
+	/* Entries due at the same time may be called in any order */
+	assert(model_due[id] == model_due[model[0]]);
+	assert(model_due[id] == wheel.now);
+	call_count++;
+
+	/* The wheel inserted periodic entries again before the call */
+	_model_remove(id);
+	if (entry->period) {
+		assert(entry->expires > wheel.now);
+		assert(entry->expires - entry->period <= wheel.now);
+		_model_insert(id);
+	}
+	assert(timer_wheel_is_pending(entry) == (entry->period != 0));
+
+	if (!callbacks_modify)
+		return 0;
+
+	switch (_rand64() % 8) {
+	case 0:
+		_add(id, wheel.now);
+		break;
+	case 1:
+		_remove(id);
+		break;
+	case 2:
+		other = _rand64() % ENTRY_COUNT;
+		if (_rand64() % 2)
+			_add(other, wheel.now);
+		else
+			_remove(other);
+		break;
+	}
+	return 0;
+}
+
+static void _advance(uint64_t now)
+{
+	uint32_t calls = call_count;
+
+	assert(timer_wheel_advance(&wheel, now) == call_count - calls);
+	assert(wheel.now == now);
+	assert(model_count == 0 || model_due[model[0]] > now);
+}
+
+static void test_random(uint64_t start)
+{
+	uint64_t now = start;
+	uint32_t step, i;
+
+	call_count = 0;
+	model_count = 0;
+	callbacks_modify = true;
+	timer_wheel_init(&wheel, now);
+	for (i = 0; i < ENTRY_COUNT; i++) {
+		memset(&entries[i], 0, sizeof(entries[i]));
+		callback_set(&entries[i].callback, _callback, (void*)(uintptr_t)i);
+	}
+
+	for (step = 0; step < STEP_COUNT; step++) {
+		switch (_rand64() % 4) {
+		case 0:
+			_add(_rand64() % ENTRY_COUNT, now);
+			break;
+		case 1:
+			_remove(_rand64() % ENTRY_COUNT);
+			break;
+		default:
+			/* Move to the next wake-up, a bit before or past it */
+			if (_rand64() % 2 && model_count)
+				now = timer_wheel_next_expiry(&wheel) - 1 +
+				      _rand64() % 3;
+			else
+				now += _rand64() % 2 ? _rand64() % 100 : _rand_delay();
+			if (now < wheel.now)
+				now = wheel.now;
+			_advance(now);
+			break;
+		}
+		_check();
+	}
+
+	/* Drain the one-shot entries */
+	callbacks_modify = false;
+	for (i = 0; i < ENTRY_COUNT; i++)
+		if (entries[i].period)
+			_remove(i);
+	while (model_count) {
+		_advance(model_due[model[0]]);
+		_check();
+	}
+	assert(timer_wheel_next_expiry(&wheel) == TIMER_WHEEL_NEVER);
+	printf("start %#llx: %u callbacks\n", (unsigned long long)start,
+	       call_count);
+}
+
+/** timer_wheel_expire() leaves the calls to its caller */
+static void test_expire(void)
+{
+	struct _timer_wheel_entry* entry;
+	uint32_t i;
+
+	timer_wheel_init(&wheel, 1000);
+	for (i = 0; i < 3; i++) {
+		memset(&entries[i], 0, sizeof(entries[i]));
+		entries[i].expires = 1000 + 100 * (3 - i);
+		timer_wheel_add(&wheel, &entries[i]);
+	}
+	entries[0].period = 50;
+
+	for (i = 3; i-- > 0;) {
+		entry = timer_wheel_expire(&wheel, 1300);
+		assert(entry == &entries[i]);
+		assert(wheel.now == 1000 + 100 * (3 - i));
+	}
+	/* The periodic entry was inserted again, one period later */
+	assert(timer_wheel_is_pending(&entries[0]));
+	assert(entries[0].expires == 1350);
+	assert(timer_wheel_expire(&wheel, 1300) == NULL);
+	assert(wheel.now == 1300);
+
+	/* A late periodic entry is called once, missed periods are skipped */
+	entries[0].expires = 520;
+	timer_wheel_add(&wheel, &entries[0]);
+	assert(timer_wheel_expire(&wheel, 2000) == &entries[0]);
+	assert(wheel.now == 1300);
+	assert(entries[0].expires == 1320);
+	timer_wheel_remove(&wheel, &entries[0]);
+	assert(timer_wheel_expire(&wheel, 2000) == NULL);
+	assert(wheel.now == 2000);
+	assert(timer_wheel_next_expiry(&wheel) == TIMER_WHEEL_NEVER);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	test_expire();
+	test_random(0);
+	test_random(UINT64_C(0x3ffffffffff0));
+	test_random(UINT64_C(1) << 62);
+	return 0;
+}
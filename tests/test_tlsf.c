@@ -0,0 +1,272 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * TLSF fuzz test. Random allocations of random sizes and alignments are
+ * filled with a pattern and released in random order. tlsf.c is included so
+ * that the test can walk the physical blocks and the free lists after the
+ * operations, and check the statistics against them.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tlsf.c"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define REGION_SIZE (64 * 1024)
+#define SLOT_COUNT  128
+#define STEP_COUNT  200000
+
+struct _slot {
+	uint8_t* ptr;
+	uint32_t size;
+	uint32_t align;
+	uint8_t fill;
+};
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint8_t region[REGION_SIZE] __attribute__((aligned(256)));
+static uint8_t* heap;
+static struct _tlsf tlsf;
+static struct _slot slots[SLOT_COUNT];
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _effective_align(uint32_t align)
+{
+	return align < TLSF_ALIGN_SIZE ? TLSF_ALIGN_SIZE : align;
+}
+
+/** Bytes reserved for a slot: its header, and its size in alignment units */
+static void _extent(const struct _slot* slot, uintptr_t* start, uintptr_t* end)
+{
+	uint32_t align = _effective_align(slot->align);
+
+	*start = (uintptr_t)slot->ptr - BLOCK_HEADER;
+	*end = (uintptr_t)slot->ptr + ROUND_UP_MULT(slot->size, align);
+}
+
+/** Walk the blocks and the free lists, and check them against the stats */
+static void _check_heap(void)
+{
+	struct _tlsf_block* block;
+	struct _tlsf_block* next;
+	struct _tlsf_block* prev_free = NULL;
+	uint32_t total = 0, used = 0, free_blocks = 0, listed = 0;
+	uint32_t fl, sl, map_fl, map_sl;
+
+	block = (struct _tlsf_block*)ROUND_UP_MULT((uintptr_t)heap,
+			(uintptr_t)TLSF_ALIGN_SIZE);
+	assert(!(block->size & BLOCK_PREV_FREE));
+	while (_block_size(block) || (block->size & BLOCK_FREE)) {
+		next = _block_next(block);
+		assert((uint8_t*)next < region + REGION_SIZE);
+		assert(_block_size(block) % TLSF_ALIGN_SIZE == 0);
+		total += _block_size(block) + BLOCK_HEADER;
+		if (block->size & BLOCK_FREE) {
+			/* free blocks are merged, and linked back from the next */
+			assert(!(block->size & BLOCK_PREV_FREE));
+			assert(_block_size(block) >= BLOCK_SIZE_MIN);
+			assert(next->size & BLOCK_PREV_FREE);
+			assert(next->prev_phys == block);
+			free_blocks++;
+		} else {
+			assert(!(next->size & BLOCK_PREV_FREE));
+			used += _block_size(block) + BLOCK_HEADER;
+		}
+		block = next;
+	}
+	assert(total == tlsf.stats.size + BLOCK_HEADER);
+	assert(used == tlsf.stats.used);
+	assert(tlsf.stats.high_water >= used);
+
+	for (fl = 0; fl < TLSF_FL_INDEX_COUNT; fl++) {
+		assert(!!(tlsf.fl_bitmap & (1u << fl)) == !!tlsf.sl_bitmap[fl]);
+		for (sl = 0; sl < TLSF_SL_INDEX_COUNT; sl++) {
+			block = tlsf.blocks[fl][sl];
+			assert(!!(tlsf.sl_bitmap[fl] & (1u << sl)) == !!block);
+			for (prev_free = NULL; block; block = block->next_free) {
+				assert(block->size & BLOCK_FREE);
+				assert(block->prev_free == prev_free);
+				_mapping_insert(_block_size(block), &map_fl, &map_sl);
+				assert(map_fl == fl && map_sl == sl);
+				prev_free = block;
+				listed++;
+			}
+		}
+	}
+	assert(listed == free_blocks);
+}
+
+static uint32_t _rand_size(void)
+{
+	switch (rand() % 10) {
+	case 0:
+		return 1 + rand() % 8192;
+	case 1: case 2: case 3: case 4:
+		return 1 + rand() % 1024;
+	default:
+		return 1 + rand() % 64;
+	}
+}
+
+static void _alloc(struct _slot* slot)
+{
+	static const uint32_t aligns[] = { 0, 4, 8, 16, 32, 64, 128, 256 };
+	struct _tlsf_stats before;
+	uintptr_t start, end, other_start, other_end;
+	uint32_t i;
+
+	slot->size = _rand_size();
+	slot->align = rand() % 2 ? aligns[rand() % 8] : 0;
+	slot->fill = rand();
+	before = tlsf.stats;
+	slot->ptr = tlsf_alloc_aligned(&tlsf, slot->size, slot->align);
+	if (!slot->ptr) {
+		assert(tlsf.stats.failures == before.failures + 1);
+		assert(tlsf.stats.used == before.used);
+		return;
+	}
+
+	assert((uintptr_t)slot->ptr % _effective_align(slot->align) == 0);
+	assert(tlsf_get_size(slot->ptr) >=
+	       ROUND_UP_MULT(slot->size, _effective_align(slot->align)));
+	assert(tlsf.stats.used ==
+	       before.used + tlsf_get_size(slot->ptr) + BLOCK_HEADER);
+	assert(tlsf.stats.high_water >= tlsf.stats.used);
+
+	/* The aligned end of a region is not shared with any other one */
+	_extent(slot, &start, &end);
+	assert(start >= (uintptr_t)region && end <= (uintptr_t)region + REGION_SIZE);
+	for (i = 0; i < SLOT_COUNT; i++) {
+		if (!slots[i].ptr || &slots[i] == slot)
+			continue;
+		_extent(&slots[i], &other_start, &other_end);
+		assert(end <= other_start || start >= other_end);
+	}
+	memset(slot->ptr, slot->fill, slot->size);
+}
+
+static void _free(struct _slot* slot)
+{
+	uint32_t i;
+
+	for (i = 0; i < slot->size; i++)
+		assert(slot->ptr[i] == slot->fill);
+	tlsf_free(&tlsf, slot->ptr);
+	slot->ptr = NULL;
+}
+
+static void test_random(void)
+{
+	struct _tlsf_stats stats;
+	uint32_t step, i, allocs = 0, failures = 0, high_water = 0;
+	struct _slot* slot;
+
+	/* Unaligned region */
+	heap = region + 4;
+	assert(tlsf_init(&tlsf, heap, REGION_SIZE - 4) == 0);
+	for (step = 0; step < STEP_COUNT; step++) {
+		slot = &slots[rand() % SLOT_COUNT];
+		if (slot->ptr) {
+			_free(slot);
+		} else {
+			_alloc(slot);
+			if (slot->ptr)
+				allocs++;
+			else
+				failures++;
+		}
+		if (tlsf.stats.used > high_water)
+			high_water = tlsf.stats.used;
+		if (step % 16 == 0)
+			_check_heap();
+	}
+
+	tlsf_get_stats(&tlsf, &stats);
+	assert(stats.failures == failures);
+	assert(stats.high_water == high_water);
+	printf("%u allocations, %u failures, high water %u/%u bytes\n",
+	       allocs, failures, stats.high_water, stats.size);
+
+	/* Everything merges back into a single free block */
+	for (i = 0; i < SLOT_COUNT; i++)
+		if (slots[i].ptr)
+			_free(&slots[i]);
+	_check_heap();
+	assert(tlsf.stats.used == 0);
+	assert(_block_size((struct _tlsf_block*)ROUND_UP_MULT((uintptr_t)heap,
+			(uintptr_t)TLSF_ALIGN_SIZE)) == tlsf.stats.size);
+}
+
+static void test_limits(void)
+{
+	uint8_t* ptr;
+
+	heap = region;
+	assert(tlsf_init(&tlsf, heap, 2 * BLOCK_HEADER) == -EINVAL);
+	assert(tlsf_init(&tlsf, heap, REGION_SIZE) == 0);
+	assert(tlsf_alloc(&tlsf, 0) == NULL);
+	assert(tlsf_alloc(&tlsf, REGION_SIZE) == NULL);
+	assert(tlsf.stats.failures == 2);
+
+	/* A one-byte cache-line buffer owns its whole line */
+	ptr = tlsf_alloc_aligned(&tlsf, 1, 32);
+	assert((uintptr_t)ptr % 32 == 0);
+	assert(tlsf_get_size(ptr) >= 32);
+	tlsf_free(&tlsf, ptr);
+	tlsf_free(&tlsf, NULL);
+	_check_heap();
+	assert(tlsf.stats.used == 0);
+}
+
+/*----------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	srand(1);
+	test_limits();
+	test_random();
+	return 0;
+}
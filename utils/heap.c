@@ -0,0 +1,88 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "chip.h"
+#include "compiler.h"
+#include "heap.h"
+#include "irqflags.h"
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+ALIGNED(L1_CACHE_BYTES) static uint8_t _heap_storage[HEAP_SIZE];
+
+static struct _tlsf _heap;
+
+static bool _heap_ready;
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static struct _tlsf* _get_heap(void)
+{
+	uint32_t flags;
+
+	if (!_heap_ready) {
+		flags = arch_irq_save();
+		if (!_heap_ready) {
+			tlsf_init(&_heap, _heap_storage, sizeof(_heap_storage));
+			_heap_ready = true;
+		}
+		arch_irq_restore(flags);
+	}
+	return &_heap;
+}
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+void* heap_alloc(uint32_t size, uint32_t align)
+{
+	return tlsf_alloc_aligned(_get_heap(), size, align);
+}
+
+void heap_free(void* ptr)
+{
+	tlsf_free(_get_heap(), ptr);
+}
+
+void heap_get_stats(struct _tlsf_stats* stats)
+{
+	tlsf_get_stats(_get_heap(), stats);
+}
@@ -0,0 +1,80 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef HEAP_H_
+#define HEAP_H_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include "tlsf.h"
+
+/*----------------------------------------------------------------------------
+ *         Definitions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Region shared by drivers for buffers only needed during an operation,
+ * instead of each driver reserving its own worst-case buffer. Backed by a
+ * TLSF allocator on static storage, initialized on first use.
+ */
+
+/** Size of the shared driver region */
+#ifndef HEAP_SIZE
+#define HEAP_SIZE (8 * 1024)
+#endif
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Allocate a buffer from the shared driver region.
+ *
+ * \param size  Size of the buffer in bytes
+ * \param align  Alignment in bytes (power of two), L1_CACHE_BYTES for DMA
+ * buffers, 0 for the default TLSF_ALIGN_SIZE
+ * \return a pointer to the buffer, or NULL if the region is exhausted.
+ */
+extern void* heap_alloc(uint32_t size, uint32_t align);
+
+/**
+ * \brief Release a buffer allocated by heap_alloc(). NULL is ignored.
+ */
+extern void heap_free(void* ptr);
+
+/**
+ * \brief Get the usage statistics of the shared driver region.
+ */
+extern void heap_get_stats(struct _tlsf_stats* stats);
+
+#endif /* HEAP_H_ */
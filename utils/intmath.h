@@ -86,6 +86,26 @@ static inline uint32_t max_u32(uint32_t a, uint32_t b)
 	return a > b ? a : b;
 }
 
+/**
+ *  Returns the minimum value between two signed integers.
+ *  \param a First integer to compare
+ *  \param b Second integer to compare
+ */
+static inline int32_t min_s32(int32_t a, int32_t b)
+{
+	return a < b ? a : b;
+}
+
+/**
+ *  Returns the maximum value between two signed integers.
+ *  \param a First integer to compare
+ *  \param b Second integer to compare
+ */
+static inline int32_t max_s32(int32_t a, int32_t b)
+{
+	return a > b ? a : b;
+}
+
 /**
  *  Returns the absolute value of an integer.
  *  \param value Integer value
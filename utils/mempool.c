@@ -0,0 +1,128 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "errno.h"
+#include "irqflags.h"
+#include "mempool.h"
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+int mempool_init(struct _mempool* pool, void* storage,
+		uint32_t block_size, uint32_t count)
+{
+	if (block_size < sizeof(void*) || (block_size % sizeof(void*)) != 0)
+		return -EINVAL;
+
+	pool->storage = (uint8_t*)storage;
+	pool->block_size = block_size;
+	pool->count = count;
+	pool->carved = 0;
+	pool->free_list = NULL;
+	pool->stats.used = 0;
+	pool->stats.high_water = 0;
+	pool->stats.failures = 0;
+	return 0;
+}
+
+void* mempool_alloc(struct _mempool* pool)
+{
+	uint32_t flags;
+	void* block;
+
+	flags = arch_irq_save();
+	block = pool->free_list;
+	if (block) {
+		pool->free_list = *(void**)block;
+	} else if (pool->carved < pool->count) {
+		block = pool->storage + pool->carved * pool->block_size;
+		pool->carved++;
+	} else {
+		pool->stats.failures++;
+		arch_irq_restore(flags);
+		return NULL;
+	}
+	pool->stats.used++;
+	if (pool->stats.used > pool->stats.high_water)
+		pool->stats.high_water = pool->stats.used;
+	arch_irq_restore(flags);
+
+	return block;
+}
+
+void mempool_free(struct _mempool* pool, void* block)
+{
+	uint32_t flags;
+
+	if (!block)
+		return;
+	assert(mempool_contains(pool, block));
+
+	flags = arch_irq_save();
+	*(void**)block = pool->free_list;
+	pool->free_list = block;
+	pool->stats.used--;
+	arch_irq_restore(flags);
+}
+
+bool mempool_contains(const struct _mempool* pool, const void* ptr)
+{
+	uint32_t offset = (uint32_t)((const uint8_t*)ptr - pool->storage);
+
+	return (const uint8_t*)ptr >= pool->storage &&
+	       offset < pool->carved * pool->block_size &&
+	       (offset % pool->block_size) == 0;
+}
+
+void mempool_get_stats(struct _mempool* pool, struct _mempool_stats* stats)
+{
+	uint32_t flags;
+
+	flags = arch_irq_save();
+	*stats = pool->stats;
+	arch_irq_restore(flags);
+}
+
+void mempool_reset_stats(struct _mempool* pool)
+{
+	uint32_t flags;
+
+	flags = arch_irq_save();
+	pool->stats.high_water = pool->stats.used;
+	pool->stats.failures = 0;
+	arch_irq_restore(flags);
+}
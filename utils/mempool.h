@@ -0,0 +1,146 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef MEMPOOL_H_
+#define MEMPOOL_H_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "chip.h"
+#include "compiler.h"
+
+/*----------------------------------------------------------------------------
+ *         Definitions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Fixed-size block pool. Blocks are handed out from a free list, or carved
+ * from the never-used tail of the storage, so a pool needs no initialization
+ * loop and can be defined statically with MEMPOOL_DECLARE(). Allocation and
+ * release are O(1) and mask interrupts for a few instructions only, so they
+ * can be used from interrupt handlers.
+ *
+ * Blocks declared with MEMPOOL_DECLARE() are cache-line aligned and padded:
+ * two blocks never share a cache line and can be used as DMA buffers.
+ */
+
+/** Size of a block of \a size bytes aligned on \a align bytes */
+#define MEMPOOL_BLOCK_SIZE(size, align) \
+	ROUND_UP_MULT(ROUND_UP_MULT((size), sizeof(void*)), (align))
+
+/**
+ * \brief Define a file-local pool of \a nblocks blocks of \a size bytes, each
+ * aligned on \a align bytes (power of two).
+ */
+#define MEMPOOL_DECLARE_ALIGNED(name, size, nblocks, align) \
+	ALIGNED(align) static uint8_t name##_storage[(nblocks) * MEMPOOL_BLOCK_SIZE(size, align)]; \
+	static struct _mempool name = { \
+		.storage = name##_storage, \
+		.block_size = MEMPOOL_BLOCK_SIZE(size, align), \
+		.count = (nblocks), \
+	}
+
+/**
+ * \brief Define a file-local pool of \a nblocks cache-line aligned blocks of
+ * \a size bytes.
+ */
+#define MEMPOOL_DECLARE(name, size, nblocks) \
+	MEMPOOL_DECLARE_ALIGNED(name, size, nblocks, L1_CACHE_BYTES)
+
+/*----------------------------------------------------------------------------
+ *         Type definitions
+ *----------------------------------------------------------------------------*/
+
+struct _mempool_stats {
+	uint32_t used;        /**< Blocks currently allocated */
+	uint32_t high_water;  /**< Maximum number of blocks allocated at once */
+	uint32_t failures;    /**< Allocations that found the pool empty */
+};
+
+struct _mempool {
+	uint8_t* storage;
+	uint32_t block_size;
+	uint32_t count;
+	uint32_t carved;      /* blocks taken from the storage so far */
+	void* free_list;
+	struct _mempool_stats stats;
+};
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a pool on caller-provided storage.
+ *
+ * \param pool  Pointer to the pool
+ * \param storage  Storage of at least \a count * \a block_size bytes, aligned
+ * as the blocks need to be
+ * \param block_size  Size of a block, multiple of sizeof(void*)
+ * \param count  Number of blocks
+ * \return 0 on success, -EINVAL if the block size is invalid.
+ */
+extern int mempool_init(struct _mempool* pool, void* storage,
+		uint32_t block_size, uint32_t count);
+
+/**
+ * \brief Allocate a block.
+ *
+ * \return a pointer to the block, or NULL if the pool is empty.
+ */
+extern void* mempool_alloc(struct _mempool* pool);
+
+/**
+ * \brief Release a block allocated by mempool_alloc(). NULL is ignored.
+ */
+extern void mempool_free(struct _mempool* pool, void* block);
+
+/**
+ * \brief Check if a pointer is a block of the pool.
+ */
+extern bool mempool_contains(const struct _mempool* pool, const void* ptr);
+
+/**
+ * \brief Get the usage statistics of a pool.
+ */
+extern void mempool_get_stats(struct _mempool* pool,
+		struct _mempool_stats* stats);
+
+/**
+ * \brief Restart the high-water mark and failure count from the current
+ * usage.
+ */
+extern void mempool_reset_stats(struct _mempool* pool);
+
+#endif /* MEMPOOL_H_ */
@@ -0,0 +1,236 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "barriers.h"
+#include "compiler.h"
+#include "errno.h"
+#include "intmath.h"
+#include "irqflags.h"
+#include "queue.h"
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Atomically replace \a *value by \a desired if it equals \a expected.
+ * \return true if the value was replaced.
+ */
+static bool _compare_and_swap(volatile uint32_t* value, uint32_t expected,
+		uint32_t desired)
+{
+#if defined(CONFIG_ARCH_ARMV7A) || defined(CONFIG_ARCH_ARMV7M)
+	uint32_t current, failed;
+
+	do {
+		__asm volatile("ldrex %0, [%1]" : "=r"(current) : "r"(value) : "memory");
+		if (current != expected) {
+			__asm volatile("clrex" ::: "memory");
+			return false;
+		}
+		__asm volatile("strex %0, %1, [%2]" : "=&r"(failed) : "r"(desired), "r"(value) : "memory");
+	} while (failed);
+	return true;
+#else
+	/* no exclusive access before ARMv6 */
+	uint32_t flags = arch_irq_save();
+	bool swapped = *value == expected;
+
+	if (swapped)
+		*value = desired;
+	arch_irq_restore(flags);
+	return swapped;
+#endif
+}
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+int spsc_queue_init(struct _spsc_queue* queue, void* buffer,
+		uint32_t elem_size, uint32_t count)
+{
+	if (!IS_POWER_OF_TWO(count))
+		return -EINVAL;
+
+	queue->buffer = buffer;
+	queue->elem_size = elem_size;
+	queue->mask = count - 1;
+	queue->head = 0;
+	queue->tail = 0;
+	return 0;
+}
+
+uint32_t spsc_queue_write(struct _spsc_queue* queue, const void* elems,
+		uint32_t count)
+{
+	const uint8_t* src = elems;
+	uint32_t written = 0;
+	uint32_t len;
+	void* span;
+
+	/* at most two spans, before and after the end of the buffer */
+	while (written < count && (len = spsc_queue_write_span(queue, &span))) {
+		len = min_u32(len, count - written);
+		memcpy(span, src, len * queue->elem_size);
+		spsc_queue_write_commit(queue, len);
+		src += len * queue->elem_size;
+		written += len;
+	}
+	return written;
+}
+
+uint32_t spsc_queue_read(struct _spsc_queue* queue, void* elems,
+		uint32_t count)
+{
+	uint8_t* dst = elems;
+	uint32_t read = 0;
+	uint32_t len;
+	void* span;
+
+	while (read < count && (len = spsc_queue_read_span(queue, &span))) {
+		len = min_u32(len, count - read);
+		memcpy(dst, span, len * queue->elem_size);
+		spsc_queue_read_commit(queue, len);
+		dst += len * queue->elem_size;
+		read += len;
+	}
+	return read;
+}
+
+uint32_t spsc_queue_write_span(struct _spsc_queue* queue, void** span)
+{
+	uint32_t head = queue->head;
+	uint32_t index = head & queue->mask;
+	uint32_t len = queue->mask + 1 - (head - queue->tail);
+
+	/* the consumer is done with the slots before they are overwritten */
+	dmb();
+	*span = queue->buffer + index * queue->elem_size;
+	return min_u32(len, queue->mask + 1 - index);
+}
+
+void spsc_queue_write_commit(struct _spsc_queue* queue, uint32_t count)
+{
+	/* the elements are visible before the consumer can see them */
+	dmb();
+	queue->head += count;
+}
+
+uint32_t spsc_queue_read_span(struct _spsc_queue* queue, void** span)
+{
+	uint32_t tail = queue->tail;
+	uint32_t index = tail & queue->mask;
+	uint32_t len = queue->head - tail;
+
+	/* read the elements published by the head just read */
+	dmb();
+	*span = queue->buffer + index * queue->elem_size;
+	return min_u32(len, queue->mask + 1 - index);
+}
+
+void spsc_queue_read_commit(struct _spsc_queue* queue, uint32_t count)
+{
+	/* the elements are read before the producer can reuse the slots */
+	dmb();
+	queue->tail += count;
+}
+
+int mpsc_queue_init(struct _mpsc_queue* queue, void* buffer,
+		uint32_t* seq, uint32_t elem_size, uint32_t count)
+{
+	uint32_t i;
+
+	if (!IS_POWER_OF_TWO(count))
+		return -EINVAL;
+
+	queue->buffer = buffer;
+	queue->seq = seq;
+	queue->elem_size = elem_size;
+	queue->mask = count - 1;
+	queue->head = 0;
+	queue->tail = 0;
+	/* slot i is free for position i */
+	for (i = 0; i < count; i++)
+		seq[i] = i;
+	dmb();
+	return 0;
+}
+
+bool mpsc_queue_push(struct _mpsc_queue* queue, const void* elem)
+{
+	uint32_t pos, index;
+
+	while (true) {
+		int32_t diff;
+
+		pos = queue->head;
+		index = pos & queue->mask;
+		diff = (int32_t)(queue->seq[index] - pos);
+		/* the slot still holds the element of the previous lap */
+		if (diff < 0)
+			return false;
+		/* otherwise another producer reserved it since head was read */
+		if (diff == 0 && _compare_and_swap(&queue->head, pos, pos + 1))
+			break;
+	}
+
+	/* the consumer is done with the slot before it is overwritten */
+	dmb();
+	memcpy(queue->buffer + index * queue->elem_size, elem, queue->elem_size);
+	/* the element is visible before its slot is published */
+	dmb();
+	queue->seq[index] = pos + 1;
+	return true;
+}
+
+bool mpsc_queue_pop(struct _mpsc_queue* queue, void* elem)
+{
+	uint32_t pos = queue->tail;
+	uint32_t index = pos & queue->mask;
+
+	if (queue->seq[index] != pos + 1)
+		return false;
+	/* read the element published by the sequence number just read */
+	dmb();
+	memcpy(elem, queue->buffer + index * queue->elem_size, queue->elem_size);
+	/* the element is read before the slot is free for the next lap */
+	dmb();
+	queue->seq[index] = pos + queue->mask + 1;
+	queue->tail = pos + 1;
+	return true;
+}
@@ -0,0 +1,252 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef QUEUE_H_
+#define QUEUE_H_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "barriers.h"
+#include "compiler.h"
+
+/*----------------------------------------------------------------------------
+ *         Definitions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Ring queues of fixed-size elements, with a power of two number of slots.
+ * Head and tail are free-running counters: the slot index is the counter
+ * modulo the size, and the queue uses all its slots.
+ *
+ * struct _spsc_queue has a single producer and a single consumer, for
+ * instance an interrupt handler and the main loop. Each side only writes its
+ * own counter, and dmb() orders the element accesses with the counter
+ * updates, so no locking is needed.
+ *
+ * struct _mpsc_queue accepts producers in any context. They reserve a slot
+ * by moving head with ldrex/strex, and publish it through a per-slot
+ * sequence number. The consumer stops at the oldest slot not yet published.
+ * ARMv5 has no exclusive access, the reservation masks interrupts there.
+ */
+
+/**
+ * \brief Define a file-local SPSC queue of \a count elements of \a type,
+ * \a count must be a power of two.
+ */
+#define SPSC_QUEUE_DECLARE(name, type, count) \
+	static type name##_buffer[count]; \
+	static struct _spsc_queue name = { \
+		.buffer = (uint8_t*)name##_buffer, \
+		.elem_size = sizeof(type), \
+		.mask = (count) - 1 + 0 * sizeof(char[IS_POWER_OF_TWO(count) ? 1 : -1]), \
+	}
+
+/*----------------------------------------------------------------------------
+ *         Type definitions
+ *----------------------------------------------------------------------------*/
+
+struct _spsc_queue {
+	uint8_t* buffer;
+	uint32_t elem_size;
+	uint32_t mask;          /* number of slots - 1 */
+	volatile uint32_t head; /* written by the producer only */
+	volatile uint32_t tail; /* written by the consumer only */
+};
+
+struct _mpsc_queue {
+	uint8_t* buffer;
+	volatile uint32_t* seq; /* per-slot sequence numbers */
+	uint32_t elem_size;
+	uint32_t mask;          /* number of slots - 1 */
+	volatile uint32_t head; /* next slot to reserve, shared by producers */
+	volatile uint32_t tail; /* written by the consumer only */
+};
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize an empty SPSC queue on caller-provided storage.
+ *
+ * \param queue  Pointer to the queue
+ * \param buffer  Storage for \a count elements
+ * \param elem_size  Size of an element in bytes
+ * \param count  Number of elements, a power of two
+ * \return 0 on success, -EINVAL if count is not a power of two.
+ */
+extern int spsc_queue_init(struct _spsc_queue* queue, void* buffer,
+		uint32_t elem_size, uint32_t count);
+
+/**
+ * \brief Get the number of elements in the queue. Exact for the consumer,
+ * a lower bound for the producer.
+ */
+static inline uint32_t spsc_queue_count(const struct _spsc_queue* queue)
+{
+	return queue->head - queue->tail;
+}
+
+/**
+ * \brief Get the number of free slots. Exact for the producer, a lower
+ * bound for the consumer.
+ */
+static inline uint32_t spsc_queue_space(const struct _spsc_queue* queue)
+{
+	return queue->mask + 1 - (queue->head - queue->tail);
+}
+
+static inline bool spsc_queue_is_empty(const struct _spsc_queue* queue)
+{
+	return queue->head == queue->tail;
+}
+
+/**
+ * \brief Append an element, producer side.
+ * \return false if the queue is full.
+ */
+static inline bool spsc_queue_push(struct _spsc_queue* queue, const void* elem)
+{
+	uint32_t head = queue->head;
+
+	if (head - queue->tail > queue->mask)
+		return false;
+	/* the consumer is done with the slot before it is overwritten */
+	dmb();
+	memcpy(queue->buffer + (head & queue->mask) * queue->elem_size,
+	       elem, queue->elem_size);
+	/* the element is visible before the consumer can see it */
+	dmb();
+	queue->head = head + 1;
+	return true;
+}
+
+/**
+ * \brief Remove the oldest element, consumer side.
+ * \return false if the queue is empty.
+ */
+static inline bool spsc_queue_pop(struct _spsc_queue* queue, void* elem)
+{
+	uint32_t tail = queue->tail;
+
+	if (queue->head == tail)
+		return false;
+	/* read the element published by the head just read */
+	dmb();
+	memcpy(elem, queue->buffer + (tail & queue->mask) * queue->elem_size,
+	       queue->elem_size);
+	/* the element is read before the producer can reuse the slot */
+	dmb();
+	queue->tail = tail + 1;
+	return true;
+}
+
+/**
+ * \brief Append up to \a count elements, producer side.
+ * \return the number of elements appended.
+ */
+extern uint32_t spsc_queue_write(struct _spsc_queue* queue, const void* elems,
+		uint32_t count);
+
+/**
+ * \brief Remove up to \a count elements, consumer side.
+ * \return the number of elements removed.
+ */
+extern uint32_t spsc_queue_read(struct _spsc_queue* queue, void* elems,
+		uint32_t count);
+
+/**
+ * \brief Get the free slots contiguous in memory from the head, to be filled
+ * in place (for instance by DMA) and published with spsc_queue_write_commit().
+ *
+ * \param span  Set to the first free slot
+ * \return the number of contiguous free slots.
+ */
+extern uint32_t spsc_queue_write_span(struct _spsc_queue* queue, void** span);
+
+/**
+ * \brief Publish \a count elements filled in place, producer side.
+ */
+extern void spsc_queue_write_commit(struct _spsc_queue* queue, uint32_t count);
+
+/**
+ * \brief Get the elements contiguous in memory from the tail, to be used in
+ * place (for instance by DMA) and released with spsc_queue_read_commit().
+ *
+ * \param span  Set to the oldest element
+ * \return the number of contiguous elements.
+ */
+extern uint32_t spsc_queue_read_span(struct _spsc_queue* queue, void** span);
+
+/**
+ * \brief Release \a count elements used in place, consumer side.
+ */
+extern void spsc_queue_read_commit(struct _spsc_queue* queue, uint32_t count);
+
+/**
+ * \brief Initialize an empty MPSC queue on caller-provided storage.
+ *
+ * \param queue  Pointer to the queue
+ * \param buffer  Storage for \a count elements
+ * \param seq  Storage for \a count sequence numbers
+ * \param elem_size  Size of an element in bytes
+ * \param count  Number of elements, a power of two
+ * \return 0 on success, -EINVAL if count is not a power of two.
+ */
+extern int mpsc_queue_init(struct _mpsc_queue* queue, void* buffer,
+		uint32_t* seq, uint32_t elem_size, uint32_t count);
+
+/**
+ * \brief Append an element, from any context.
+ * \return false if the queue is full.
+ */
+extern bool mpsc_queue_push(struct _mpsc_queue* queue, const void* elem);
+
+/**
+ * \brief Remove the oldest element, consumer side.
+ * \return false if the queue is empty or the oldest element is still being
+ * written by a preempted producer.
+ */
+extern bool mpsc_queue_pop(struct _mpsc_queue* queue, void* elem);
+
+/**
+ * \brief Get the number of slots reserved by producers and not yet removed.
+ */
+static inline uint32_t mpsc_queue_count(const struct _mpsc_queue* queue)
+{
+	return queue->head - queue->tail;
+}
+
+#endif /* QUEUE_H_ */
@@ -0,0 +1,275 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*------------------------------------------------------------------------------
+ *         Header
+ *------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "errno.h"
+#include "irqflags.h"
+#include "random.h"
+
+/*------------------------------------------------------------------------------
+ *         Local definitions
+ *------------------------------------------------------------------------------*/
+
+#define CHACHA_BLOCK_WORDS 16
+#define CHACHA_BLOCK_SIZE  (CHACHA_BLOCK_WORDS * 4)
+#define CHACHA_KEY_WORDS   8
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define CHACHA_QUARTER_ROUND(a, b, c, d) \
+	do { \
+		a += b; d ^= a; d = ROTL32(d, 16); \
+		c += d; b ^= c; b = ROTL32(b, 12); \
+		a += b; d ^= a; d = ROTL32(d, 8);  \
+		c += d; b ^= c; b = ROTL32(b, 7);  \
+	} while (0)
+
+/*------------------------------------------------------------------------------
+ *         Local variables
+ *------------------------------------------------------------------------------*/
+
+/* Key, counter and reseed state are only accessed with interrupts masked.
+ * Each request claims a range of counter values and the key that goes with
+ * it, and rekeys before unmasking, so no two requests share a block. */
+static struct {
+	bool initialized;
+	random_seed_source_t source;
+	void* source_arg;
+	uint32_t key[CHACHA_KEY_WORDS];
+	uint64_t counter;
+	uint32_t reseed_count;
+	uint32_t since_reseed;
+} _random;
+
+/* "expand 32-byte k" */
+static const uint32_t _chacha_constants[4] = {
+	0x61707865, 0x3320646e, 0x79622d32, 0x6b206574
+};
+
+/*------------------------------------------------------------------------------
+ *         Local functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Compute one ChaCha20 block.
+ * \param key key of CHACHA_KEY_WORDS words
+ * \param counter block counter
+ * \param nonce reseed count the key belongs to
+ * \param out destination of CHACHA_BLOCK_WORDS words
+ */
+static void _chacha20_block(const uint32_t* key, uint64_t counter,
+		uint32_t nonce, uint32_t* out)
+{
+	uint32_t x[CHACHA_BLOCK_WORDS];
+	int i;
+
+	x[0] = _chacha_constants[0];
+	x[1] = _chacha_constants[1];
+	x[2] = _chacha_constants[2];
+	x[3] = _chacha_constants[3];
+	for (i = 0; i < CHACHA_KEY_WORDS; i++)
+		x[4 + i] = key[i];
+	x[12] = (uint32_t)counter;
+	x[13] = (uint32_t)(counter >> 32);
+	x[14] = nonce;
+	x[15] = 0;
+
+	for (i = 0; i < CHACHA_BLOCK_WORDS; i++)
+		out[i] = x[i];
+
+	for (i = 0; i < 10; i++) {
+		/* column rounds */
+		CHACHA_QUARTER_ROUND(x[0], x[4], x[8],  x[12]);
+		CHACHA_QUARTER_ROUND(x[1], x[5], x[9],  x[13]);
+		CHACHA_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+		CHACHA_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+		/* diagonal rounds */
+		CHACHA_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+		CHACHA_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+		CHACHA_QUARTER_ROUND(x[2], x[7], x[8],  x[13]);
+		CHACHA_QUARTER_ROUND(x[3], x[4], x[9],  x[14]);
+	}
+
+	for (i = 0; i < CHACHA_BLOCK_WORDS; i++)
+		out[i] += x[i];
+}
+
+/**
+ * \brief Replace the key with fresh generator output so that previous output
+ * cannot be recomputed from the current state. Called with interrupts masked.
+ */
+static void _random_rekey(void)
+{
+	uint32_t block[CHACHA_BLOCK_WORDS];
+
+	_chacha20_block(_random.key, _random.counter++, _random.reseed_count, block);
+	memcpy(_random.key, block, sizeof(_random.key));
+	memset(block, 0, sizeof(block));
+}
+
+/**
+ * \brief Deterministic seed source, used when no entropy source is given.
+ * Expands a fixed value with a SplitMix-like sequence.
+ */
+static int _random_deterministic_source(uint8_t* buffer, uint32_t len, void* arg)
+{
+	uint32_t state = 0x9e3779b9 + _random.reseed_count;
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		uint32_t z;
+
+		state += 0x9e3779b9;
+		z = state;
+		z = (z ^ (z >> 16)) * 0x85ebca6b;
+		z = (z ^ (z >> 13)) * 0xc2b2ae35;
+		z ^= z >> 16;
+		buffer[i] = (uint8_t)z;
+	}
+	return 0;
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported Functions
+ *------------------------------------------------------------------------------*/
+
+int random_init(random_seed_source_t source, void* arg)
+{
+	memset(&_random, 0, sizeof(_random));
+	if (source) {
+		_random.source = source;
+		_random.source_arg = arg;
+	} else {
+		_random.source = _random_deterministic_source;
+		_random.source_arg = NULL;
+	}
+	_random.initialized = true;
+
+	return random_reseed();
+}
+
+int random_reseed(void)
+{
+	uint32_t seed[RANDOM_SEED_SIZE / 4];
+	uint32_t flags;
+	int err;
+	int i;
+
+	if (!_random.initialized)
+		return -ENODEV;
+
+	/* The source may wait for entropy, it is called unmasked */
+	err = _random.source((uint8_t*)seed, sizeof(seed), _random.source_arg);
+	if (err < 0)
+		return err;
+
+	/* Mix the seed into the key, and rekey so the raw seed never stays in the
+	 * state */
+	flags = arch_irq_save();
+	for (i = 0; i < CHACHA_KEY_WORDS; i++)
+		_random.key[i] ^= seed[i];
+	_random.reseed_count++;
+	_random_rekey();
+	_random.since_reseed = 0;
+	arch_irq_restore(flags);
+	memset(seed, 0, sizeof(seed));
+
+	return 0;
+}
+
+int random_fill(void* buffer, uint32_t len)
+{
+	uint32_t block[CHACHA_BLOCK_WORDS];
+	uint32_t key[CHACHA_KEY_WORDS];
+	uint8_t* out = (uint8_t*)buffer;
+	uint32_t blocks, nonce, flags;
+	uint64_t counter;
+	int err;
+
+	if (!_random.initialized)
+		return -ENODEV;
+
+	/* No output on a state that should have been reseeded */
+	if (_random.since_reseed >= RANDOM_RESEED_INTERVAL) {
+		err = random_reseed();
+		if (err < 0)
+			return err;
+	}
+
+	/* Claim the blocks of this request, then rekey for the next one */
+	blocks = (len + CHACHA_BLOCK_SIZE - 1) / CHACHA_BLOCK_SIZE;
+	flags = arch_irq_save();
+	memcpy(key, _random.key, sizeof(key));
+	counter = _random.counter;
+	nonce = _random.reseed_count;
+	_random.counter += blocks;
+	_random.since_reseed += blocks * CHACHA_BLOCK_SIZE;
+	_random_rekey();
+	arch_irq_restore(flags);
+
+	/* Generate whole blocks straight into word-aligned destinations */
+	if (((uintptr_t)out & 3) == 0) {
+		while (len >= CHACHA_BLOCK_SIZE) {
+			_chacha20_block(key, counter++, nonce, (uint32_t*)out);
+			out += CHACHA_BLOCK_SIZE;
+			len -= CHACHA_BLOCK_SIZE;
+		}
+	}
+
+	while (len > 0) {
+		uint32_t chunk = len < CHACHA_BLOCK_SIZE ? len : CHACHA_BLOCK_SIZE;
+		_chacha20_block(key, counter++, nonce, block);
+		memcpy(out, block, chunk);
+		out += chunk;
+		len -= chunk;
+	}
+	memset(block, 0, sizeof(block));
+	memset(key, 0, sizeof(key));
+
+	return 0;
+}
+
+int random_u32(uint32_t* value)
+{
+	return random_fill(value, sizeof(*value));
+}
+
+bool random_is_deterministic(void)
+{
+	return _random.source == _random_deterministic_source;
+}
@@ -0,0 +1,133 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*------------------------------------------------------------------------------
+ *  \file
+ *
+ *  \section Purpose
+ *  Cryptographically strong pseudo-random generator based on the ChaCha20
+ *  block function.
+ *
+ *  The generator is seeded (and periodically reseeded) from an entropy
+ *  source given to random_init(). On targets with a TRNG, the buffered TRNG
+ *  driver (trngd_get_entropy()) should be used. When no source is given, a
+ *  deterministic seed is used: the output stream is then fully reproducible,
+ *  which is only useful for tests and host-side builds.
+ *
+ *  After each request, the key is replaced by fresh generator output ("fast
+ *  key erasure") so that a later state compromise does not reveal previous
+ *  output.
+ *
+ *  Requests can be made from any context, including interrupt handlers:
+ *  each one claims its blocks with interrupts masked. Reseeding calls the
+ *  entropy source unmasked.
+ *
+ *------------------------------------------------------------------------------*/
+
+#ifndef _RANDOM_H
+#define _RANDOM_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Size of the seed requested from the entropy source, in bytes */
+#define RANDOM_SEED_SIZE 32
+
+/** Number of bytes generated before the generator is reseeded */
+#ifndef RANDOM_RESEED_INTERVAL
+#define RANDOM_RESEED_INTERVAL (1024 * 1024)
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Entropy source used to (re)seed the generator.
+ * \param buffer destination buffer
+ * \param len number of bytes requested
+ * \param arg user argument given to random_init()
+ * \return 0 on success, <0 on error
+ */
+typedef int (*random_seed_source_t)(uint8_t* buffer, uint32_t len, void* arg);
+
+/*------------------------------------------------------------------------------
+ *         Global Functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize the generator and seed it from the given source.
+ * \param source entropy source, or NULL to use a deterministic seed
+ * \param arg user argument passed as-is to the source
+ * \return 0 on success, <0 on error
+ */
+extern int random_init(random_seed_source_t source, void* arg);
+
+/**
+ * \brief Mix fresh entropy from the source into the generator state.
+ * \return 0 on success, <0 on error (the previous state is kept)
+ */
+extern int random_reseed(void);
+
+/**
+ * \brief Fill a buffer with random bytes.
+ *
+ * The generator is reseeded automatically every RANDOM_RESEED_INTERVAL
+ * bytes. If reseeding fails, no output is produced and the reseed is retried
+ * on the next request.
+ *
+ * \param buffer destination buffer
+ * \param len number of bytes to generate
+ * \return 0 on success, <0 if the generator is not initialized or a reseed
+ * failed (the buffer is then left untouched)
+ */
+extern int random_fill(void* buffer, uint32_t len);
+
+/**
+ * \brief Get a random 32-bit value.
+ * \param value destination of the value
+ * \return 0 on success, <0 on error as random_fill()
+ */
+extern int random_u32(uint32_t* value);
+
+/**
+ * \brief Tell if the generator is currently seeded from a deterministic
+ * source (i.e. random_init() was called without a source).
+ */
+extern bool random_is_deterministic(void);
+
+#endif /* _RANDOM_H */
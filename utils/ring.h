@@ -27,6 +27,12 @@
  * ----------------------------------------------------------------------------
  */
 
+/*
+ * Index arithmetic for rings of any size that keep one slot free. For
+ * buffers shared between an interrupt handler and the main loop, prefer
+ * the power of two queues of queue.h, which handle the memory ordering.
+ */
+
 #ifndef _RING_H_
 #define _RING_H_
 
@@ -37,6 +37,16 @@
 #include "peripherals/pmc.h"
 #include "peripherals/tc.h"
 #include "timer.h"
+#include "timer_wheel.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define TC_CHANNEL_MASK ((1ull << TC_CHANNEL_SIZE) - 1)
+
+/** Minimum distance, in TC ticks, between the counter and a new RC value */
+#define TIMER_COMPARE_MARGIN 8
 
 /*----------------------------------------------------------------------------
  *         Local type definitions
@@ -47,6 +57,11 @@ struct _timer {
 	uint8_t channel;
 	uint32_t channel_freq;
 	volatile uint32_t upper;
+#ifndef CONFIG_TIMER_POLLING
+	volatile bool compare_armed;
+	volatile bool compare_hit;
+	volatile bool in_handler;
+#endif
 };
 
 /*----------------------------------------------------------------------------
@@ -56,15 +71,52 @@ struct _timer {
 /** System timer */
 static struct _timer _timer;
 
+#ifndef CONFIG_TIMER_POLLING
+/** Software timers, in microseconds */
+static struct _timer_wheel _swtimer_wheel;
+#endif
+
 /*----------------------------------------------------------------------------
  *         Local Functions
  *----------------------------------------------------------------------------*/
 
+#ifndef CONFIG_TIMER_POLLING
+
+/**
+ * \brief Make the RC compare match again in a few ticks.
+ *
+ * Reading the status register clears CPCS. When this happens outside of the
+ * TC handler, the interrupt is lost and the handler would not run until the
+ * next counter overflow.
+ */
+static void timer_retrigger_compare(void)
+{
+	uint32_t flags = arch_irq_save();
+	uint32_t margin = TIMER_COMPARE_MARGIN;
+	uint32_t rc;
+
+	do {
+		rc = (tc_get_cv(_timer.tc, _timer.channel) + margin) & TC_CHANNEL_MASK;
+		tc_set_ra_rb_rc(_timer.tc, _timer.channel, NULL, NULL, &rc);
+		margin <<= 1;
+	} while (((rc - tc_get_cv(_timer.tc, _timer.channel)) & TC_CHANNEL_MASK) > margin);
+	arch_irq_restore(flags);
+}
+
+#endif /* !CONFIG_TIMER_POLLING */
+
 static void timer_update_upper_tick_counter(void)
 {
 	uint32_t status = tc_get_status(_timer.tc, _timer.channel);
 	if ((status & TC_SR_COVFS) == TC_SR_COVFS)
 		_timer.upper++;
+#ifndef CONFIG_TIMER_POLLING
+	if ((status & TC_SR_CPCS) == TC_SR_CPCS && _timer.compare_armed) {
+		_timer.compare_hit = true;
+		if (!_timer.in_handler)
+			timer_retrigger_compare();
+	}
+#endif
 }
 
 static uint32_t timer_get_upper_tick_counter(void)
@@ -73,18 +125,6 @@ static uint32_t timer_get_upper_tick_counter(void)
 	return _timer.upper;
 }
 
-#ifndef CONFIG_TIMER_POLLING
-
-/**
- *  \brief Handler for timer interrupt.
- */
-static void timer_irq_handler(uint32_t source, void* user_arg)
-{
-	timer_update_upper_tick_counter();
-}
-
-#endif /* !CONFIG_TIMER_POLLING */
-
 static uint64_t _timer_get_tick(void)
 {
 	uint32_t upper, lower;
@@ -97,6 +137,98 @@ static uint64_t _timer_get_tick(void)
 	return (((uint64_t)upper) << TC_CHANNEL_SIZE) | lower;
 }
 
+static uint64_t timer_ticks_to_us(uint64_t ticks)
+{
+	uint32_t freq = _timer.channel_freq;
+
+	/* split to avoid overflowing ticks * 1000000 */
+	return (ticks / freq) * 1000000 + ((ticks % freq) * 1000000) / freq;
+}
+
+#ifndef CONFIG_TIMER_POLLING
+
+static uint64_t timer_us_to_ticks(uint64_t us)
+{
+	uint32_t freq = _timer.channel_freq;
+
+	/* round up so that the time in us has been reached when RC matches */
+	return (us / 1000000) * freq + ((us % 1000000) * freq + 999999) / 1000000;
+}
+
+/**
+ * \brief Program RC for the next software timer expiry.
+ *
+ * The TC counts up freely, the compare is done on the low bits of the
+ * deadline. A deadline more than one counter period away is left to the
+ * overflow interrupt, which reprograms the compare. Must be called with
+ * interrupts disabled.
+ */
+static void timer_program_compare(void)
+{
+	uint64_t next = timer_wheel_next_expiry(&_swtimer_wheel);
+	uint64_t deadline, now;
+	uint32_t margin = TIMER_COMPARE_MARGIN;
+	uint32_t rc;
+
+	if (next == TIMER_WHEEL_NEVER) {
+		_timer.compare_armed = false;
+		tc_disable_it(_timer.tc, _timer.channel, TC_IDR_CPCS);
+		return;
+	}
+
+	deadline = timer_us_to_ticks(next);
+	for (;;) {
+		now = _timer_get_tick();
+		if (deadline < now + margin)
+			deadline = now + margin;
+		if (deadline - now > TC_CHANNEL_MASK) {
+			_timer.compare_armed = false;
+			tc_disable_it(_timer.tc, _timer.channel, TC_IDR_CPCS);
+			return;
+		}
+		rc = deadline & TC_CHANNEL_MASK;
+		tc_set_ra_rb_rc(_timer.tc, _timer.channel, NULL, NULL, &rc);
+		_timer.compare_armed = true;
+		tc_enable_it(_timer.tc, _timer.channel, TC_IER_CPCS);
+
+		/* the counter must not have passed RC while it was written */
+		if (_timer_get_tick() < deadline)
+			return;
+		margin <<= 1;
+	}
+}
+
+/**
+ *  \brief Handler for timer interrupt.
+ *
+ * Handlers run with interrupts unmasked, the wheel is only accessed with
+ * interrupts masked so that swtimer_start() and swtimer_cancel() can be
+ * called from any handler. The mask is released around the callbacks.
+ */
+static void timer_irq_handler(uint32_t source, void* user_arg)
+{
+	struct _timer_wheel_entry* entry;
+	uint32_t flags = arch_irq_save();
+	uint64_t now;
+
+	_timer.in_handler = true;
+	timer_update_upper_tick_counter();
+	do {
+		_timer.compare_hit = false;
+		now = timer_ticks_to_us(_timer_get_tick());
+		while ((entry = timer_wheel_expire(&_swtimer_wheel, now)) != NULL) {
+			arch_irq_restore(flags);
+			callback_call(&entry->callback, entry);
+			flags = arch_irq_save();
+		}
+		timer_program_compare();
+	} while (_timer.compare_hit);
+	_timer.in_handler = false;
+	arch_irq_restore(flags);
+}
+
+#endif /* !CONFIG_TIMER_POLLING */
+
 /*----------------------------------------------------------------------------
  *         Exported Functions
  *----------------------------------------------------------------------------*/
@@ -115,11 +247,15 @@ void timer_configure(Tc* tc, uint8_t channel, uint32_t clock_source)
 			(clock_source & TC_CMR_TCCLKS_Msk));
 	_timer.channel_freq = tc_get_channel_freq(tc, channel);
 #ifndef CONFIG_TIMER_POLLING
+	_timer.compare_armed = false;
 	irq_add_handler(tc_id, timer_irq_handler, &_timer);
 	irq_enable(tc_id);
 	tc_enable_it(tc, channel, TC_IER_COVFS);
 #endif
 	tc_start(tc, channel);
+#ifndef CONFIG_TIMER_POLLING
+	timer_wheel_init(&_swtimer_wheel, timer_get_us());
+#endif
 }
 
 uint64_t timer_get_interval(uint64_t start, uint64_t end)
@@ -157,6 +293,49 @@ uint64_t timer_get_tick(void)
 	return (_timer_get_tick() * 1000) / _timer.channel_freq;
 }
 
+uint64_t timer_get_us(void)
+{
+	return timer_ticks_to_us(_timer_get_tick());
+}
+
+#ifndef CONFIG_TIMER_POLLING
+
+void swtimer_setup(struct _swtimer* timer, struct _callback* cb)
+{
+	timer->entry.pprev = NULL;
+	timer->entry.period = 0;
+	callback_copy(&timer->entry.callback, cb);
+}
+
+void swtimer_start(struct _swtimer* timer, uint64_t delay, uint64_t period)
+{
+	uint32_t flags = arch_irq_save();
+
+	timer->entry.expires = timer_get_us() + delay;
+	timer->entry.period = period;
+	timer_wheel_add(&_swtimer_wheel, &timer->entry);
+	if (!_timer.in_handler)
+		timer_program_compare();
+	arch_irq_restore(flags);
+}
+
+void swtimer_cancel(struct _swtimer* timer)
+{
+	uint32_t flags = arch_irq_save();
+
+	timer_wheel_remove(&_swtimer_wheel, &timer->entry);
+	if (!_timer.in_handler)
+		timer_program_compare();
+	arch_irq_restore(flags);
+}
+
+bool swtimer_is_pending(const struct _swtimer* timer)
+{
+	return timer_wheel_is_pending(&timer->entry);
+}
+
+#endif /* !CONFIG_TIMER_POLLING */
+
 void sleep(uint32_t count)
 {
 	timer_sleep(count * 1000);
@@ -34,9 +34,12 @@
  *         Headers
  *----------------------------------------------------------------------------*/
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "board.h"
+#include "callback.h"
+#include "timer_wheel.h"
 
 /*----------------------------------------------------------------------------
  *         Type definitions
@@ -48,6 +51,12 @@ struct _timeout
 	uint64_t count;
 };
 
+/** Software timer, see swtimer_setup() */
+struct _swtimer
+{
+	struct _timer_wheel_entry entry;
+};
+
 /*----------------------------------------------------------------------------
  *         Global functions
  *----------------------------------------------------------------------------*/
@@ -105,6 +114,49 @@ extern uint64_t timer_get_interval(uint64_t start, uint64_t end);
  */
 extern uint64_t timer_get_tick(void);
 
+/**
+ * \brief Returns the time elapsed since timer_configure(), in microseconds
+ */
+extern uint64_t timer_get_us(void);
+
+#ifndef CONFIG_TIMER_POLLING
+
+/**
+ * \brief Initialize a software timer.
+ *
+ * Software timers are kept in a timer wheel and the TC RC compare is
+ * programmed for the earliest expiry only, so any number of timers costs a
+ * single interrupt per expiry and none while idle. timer_configure() must
+ * have been called, and calling it again drops all pending timers.
+ *
+ * \param timer Software timer to initialize
+ * \param cb Callback called from the TC interrupt handler when the timer
+ * expires, with the struct _swtimer as second argument. It may start or
+ * cancel any software timer.
+ */
+extern void swtimer_setup(struct _swtimer* timer, struct _callback* cb);
+
+/**
+ * \brief Start or restart a software timer.
+ * \param timer Software timer
+ * \param delay Delay before the first expiry, in microseconds
+ * \param period Period for the next expiries in microseconds, 0 for a
+ * one-shot timer
+ */
+extern void swtimer_start(struct _swtimer* timer, uint64_t delay, uint64_t period);
+
+/**
+ * \brief Stop a software timer, nothing is done if it is not pending.
+ */
+extern void swtimer_cancel(struct _swtimer* timer);
+
+/**
+ * \brief Tells if a software timer is waiting for its expiry.
+ */
+extern bool swtimer_is_pending(const struct _swtimer* timer);
+
+#endif /* !CONFIG_TIMER_POLLING */
+
 /**
  *  \brief Wait for at least count seconds.
  */
@@ -0,0 +1,229 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stddef.h>
+
+#include "timer_wheel.h"
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline uint32_t _timer_wheel_shift(uint32_t level)
+{
+	return level * TIMER_WHEEL_SLOT_BITS;
+}
+
+/** Start of the window of the given level that contains time t */
+static inline uint64_t _timer_wheel_window(uint64_t t, uint32_t level)
+{
+	uint32_t shift = _timer_wheel_shift(level + 1);
+
+	return shift >= 64 ? 0 : t & ~((UINT64_C(1) << shift) - 1);
+}
+
+static void _timer_wheel_link(struct _timer_wheel_entry** head,
+		struct _timer_wheel_entry* entry)
+{
+	entry->next = *head;
+	if (entry->next)
+		entry->next->pprev = &entry->next;
+	entry->pprev = head;
+	*head = entry;
+}
+
+static void _timer_wheel_insert(struct _timer_wheel* wheel,
+		struct _timer_wheel_entry* entry)
+{
+	uint64_t expires = entry->expires;
+	uint64_t diff;
+	uint32_t level, slot;
+
+	/* Late entries expire on the next advance */
+	if (expires < wheel->now)
+		expires = wheel->now;
+
+	/* The level is given by the highest bit differing from the wheel time */
+	diff = expires ^ wheel->now;
+	level = diff ? (63 - __builtin_clzll(diff)) / TIMER_WHEEL_SLOT_BITS : 0;
+	slot = (expires >> _timer_wheel_shift(level)) & (TIMER_WHEEL_SLOTS - 1);
+
+	_timer_wheel_link(&wheel->slots[level][slot], entry);
+	wheel->bitmap[level] |= UINT64_C(1) << slot;
+}
+
+/** Detach the whole list of a slot, the entries stay linked to *head */
+static void _timer_wheel_take_slot(struct _timer_wheel* wheel, uint32_t level,
+		uint32_t slot, struct _timer_wheel_entry** head)
+{
+	*head = wheel->slots[level][slot];
+	if (*head)
+		(*head)->pprev = head;
+	wheel->slots[level][slot] = NULL;
+	wheel->bitmap[level] &= ~(UINT64_C(1) << slot);
+}
+
+static uint64_t _timer_wheel_next(const struct _timer_wheel* wheel,
+		uint32_t* level)
+{
+	uint32_t l, shift, current;
+	uint64_t map;
+
+	for (l = 0; l < TIMER_WHEEL_LEVELS; l++) {
+		map = wheel->bitmap[l];
+		if (!map)
+			continue;
+
+		shift = _timer_wheel_shift(l);
+		current = (wheel->now >> shift) & (TIMER_WHEEL_SLOTS - 1);
+		map &= ~UINT64_C(0) << current;
+		if (!map)
+			continue;
+
+		*level = l;
+		return _timer_wheel_window(wheel->now, l)
+			| ((uint64_t)__builtin_ctzll(map) << shift);
+	}
+
+	return TIMER_WHEEL_NEVER;
+}
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+void timer_wheel_init(struct _timer_wheel* wheel, uint64_t now)
+{
+	uint32_t l, s;
+
+	wheel->now = now;
+	for (l = 0; l < TIMER_WHEEL_LEVELS; l++) {
+		wheel->bitmap[l] = 0;
+		for (s = 0; s < TIMER_WHEEL_SLOTS; s++)
+			wheel->slots[l][s] = NULL;
+	}
+}
+
+void timer_wheel_add(struct _timer_wheel* wheel,
+		struct _timer_wheel_entry* entry)
+{
+	timer_wheel_remove(wheel, entry);
+	_timer_wheel_insert(wheel, entry);
+}
+
+void timer_wheel_remove(struct _timer_wheel* wheel,
+		struct _timer_wheel_entry* entry)
+{
+	uintptr_t first = (uintptr_t)&wheel->slots[0][0];
+	uintptr_t pprev = (uintptr_t)entry->pprev;
+	uint32_t index;
+
+	if (!entry->pprev)
+		return;
+
+	*entry->pprev = entry->next;
+	if (entry->next)
+		entry->next->pprev = entry->pprev;
+
+	/* Slot emptied: clear its bit so that it does not cause a wake-up */
+	if (pprev >= first && pprev < first + sizeof(wheel->slots) &&
+	    !*entry->pprev) {
+		index = (pprev - first) / sizeof(wheel->slots[0][0]);
+		wheel->bitmap[index / TIMER_WHEEL_SLOTS] &=
+			~(UINT64_C(1) << (index % TIMER_WHEEL_SLOTS));
+	}
+
+	entry->next = NULL;
+	entry->pprev = NULL;
+}
+
+uint64_t timer_wheel_next_expiry(const struct _timer_wheel* wheel)
+{
+	uint32_t level;
+
+	return _timer_wheel_next(wheel, &level);
+}
+
+struct _timer_wheel_entry* timer_wheel_expire(struct _timer_wheel* wheel,
+		uint64_t now)
+{
+	struct _timer_wheel_entry* head;
+	struct _timer_wheel_entry* entry;
+	uint32_t level = 0, slot;
+	uint64_t next, late;
+
+	while ((next = _timer_wheel_next(wheel, &level)) != TIMER_WHEEL_NEVER &&
+	       next <= now) {
+		wheel->now = next;
+		slot = (next >> _timer_wheel_shift(level)) & (TIMER_WHEEL_SLOTS - 1);
+
+		if (level > 0) {
+			/* Cascade to the lower levels */
+			_timer_wheel_take_slot(wheel, level, slot, &head);
+			while ((entry = head) != NULL) {
+				timer_wheel_remove(wheel, entry);
+				_timer_wheel_insert(wheel, entry);
+			}
+			continue;
+		}
+
+		/* The slot stays in place, callbacks may remove its entries */
+		entry = wheel->slots[0][slot];
+		timer_wheel_remove(wheel, entry);
+		if (entry->period) {
+			/* Skip the periods missed if the wheel was late */
+			late = (next - entry->expires) / entry->period;
+			entry->expires += (late + 1) * entry->period;
+			_timer_wheel_insert(wheel, entry);
+		}
+		return entry;
+	}
+
+	if (now > wheel->now)
+		wheel->now = now;
+
+	return NULL;
+}
+
+uint32_t timer_wheel_advance(struct _timer_wheel* wheel, uint64_t now)
+{
+	struct _timer_wheel_entry* entry;
+	uint32_t count = 0;
+
+	while ((entry = timer_wheel_expire(wheel, now)) != NULL) {
+		callback_call(&entry->callback, entry);
+		count++;
+	}
+
+	return count;
+}
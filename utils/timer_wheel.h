@@ -0,0 +1,142 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "callback.h"
+
+/*----------------------------------------------------------------------------
+ *         Definitions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Hierarchical timer wheel. Level n has 64 slots of 64^n time units each, and
+ * holds the entries whose expiry differs from the wheel time only from bit
+ * 6n upward. When the wheel time reaches the start of a slot of an upper
+ * level, its entries are cascaded to the lower levels. Insert and cancel are
+ * O(1). Upper levels only hold entries later than all the entries of lower
+ * levels, so the next expiry is a bit scan of the first non-empty level.
+ *
+ * The wheel has no notion of hardware: it is driven by
+ * timer_wheel_advance(), and the caller programs its own timer for
+ * timer_wheel_next_expiry(). It does not lock either, callers serialize
+ * accesses.
+ */
+
+#define TIMER_WHEEL_SLOT_BITS  6
+#define TIMER_WHEEL_SLOTS      (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_LEVELS     11  /* covers the whole 64-bit range */
+
+/** Expiry returned when no entry is pending */
+#define TIMER_WHEEL_NEVER      UINT64_MAX
+
+/*----------------------------------------------------------------------------
+ *         Type definitions
+ *----------------------------------------------------------------------------*/
+
+struct _timer_wheel_entry {
+	struct _timer_wheel_entry* next;
+	struct _timer_wheel_entry** pprev;  /* NULL when not pending */
+	uint64_t expires;
+	uint64_t period;                    /* 0 for one-shot entries */
+	struct _callback callback;          /* called with the entry as arg2 */
+};
+
+struct _timer_wheel {
+	uint64_t now;
+	uint64_t bitmap[TIMER_WHEEL_LEVELS];
+	struct _timer_wheel_entry* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+};
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize an empty wheel.
+ * \param wheel  Wheel to initialize
+ * \param now    Current time
+ */
+extern void timer_wheel_init(struct _timer_wheel* wheel, uint64_t now);
+
+/**
+ * \brief Insert an entry. Its expires field must be set, an expiry in the
+ * past fires on the next timer_wheel_advance(). A pending entry is moved.
+ */
+extern void timer_wheel_add(struct _timer_wheel* wheel,
+		struct _timer_wheel_entry* entry);
+
+/**
+ * \brief Remove an entry, nothing is done if it is not pending.
+ */
+extern void timer_wheel_remove(struct _timer_wheel* wheel,
+		struct _timer_wheel_entry* entry);
+
+/**
+ * \brief Tell if an entry is waiting in a wheel.
+ */
+static inline bool timer_wheel_is_pending(const struct _timer_wheel_entry* entry)
+{
+	return entry->pprev != NULL;
+}
+
+/**
+ * \brief Get the earliest time at which timer_wheel_advance() has work to
+ * do, either an expiry or a cascade.
+ * \return Time, or TIMER_WHEEL_NEVER if the wheel is empty
+ */
+extern uint64_t timer_wheel_next_expiry(const struct _timer_wheel* wheel);
+
+/**
+ * \brief Move the wheel time forward up to the next expired entry, without
+ * calling its callback. A periodic entry is inserted again before it is
+ * returned. Lets the caller release its lock around the callback, the wheel
+ * may be modified before the next call.
+ * \return Entry whose callback is due, or NULL once the wheel time is now
+ */
+extern struct _timer_wheel_entry* timer_wheel_expire(struct _timer_wheel* wheel,
+		uint64_t now);
+
+/**
+ * \brief Move the wheel time forward and call the callbacks of the entries
+ * that expired, in expiry order. Periodic entries are inserted again before
+ * their callback is called. Callbacks may add or remove any entry.
+ * \return Number of callbacks called
+ */
+extern uint32_t timer_wheel_advance(struct _timer_wheel* wheel, uint64_t now);
+
+#endif /* TIMER_WHEEL_H_ */
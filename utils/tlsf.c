@@ -0,0 +1,364 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "errno.h"
+#include "irqflags.h"
+#include "tlsf.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#if TLSF_FL_INDEX_MAX > 31
+#error "TLSF_FL_INDEX_MAX must not exceed 31"
+#endif
+
+/*
+ * Block header. prev_phys is only valid when the previous block is free, and
+ * the free list links are stored in the payload of free blocks. The two low
+ * bits of size are flags: sizes are multiples of TLSF_ALIGN_SIZE.
+ */
+struct _tlsf_block {
+	struct _tlsf_block* prev_phys;
+	uint32_t size;
+	struct _tlsf_block* next_free;
+	struct _tlsf_block* prev_free;
+};
+
+#define BLOCK_FREE       (1u << 0)
+#define BLOCK_PREV_FREE  (1u << 1)
+#define BLOCK_FLAGS      (BLOCK_FREE | BLOCK_PREV_FREE)
+
+#define BLOCK_HEADER     ((uint32_t)offsetof(struct _tlsf_block, next_free))
+#define BLOCK_SIZE_MIN   ((uint32_t)sizeof(struct _tlsf_block) - BLOCK_HEADER)
+#define BLOCK_SIZE_MAX   ((1u << TLSF_FL_INDEX_MAX) - TLSF_ALIGN_SIZE)
+
+#define SMALL_BLOCK_SIZE (1u << TLSF_FL_INDEX_SHIFT)
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline uint32_t _fls(uint32_t x)
+{
+	return 31 - CLZ(x);
+}
+
+static inline uint32_t _ffs(uint32_t x)
+{
+	return __builtin_ctz(x);
+}
+
+static inline uint32_t _block_size(const struct _tlsf_block* block)
+{
+	return block->size & ~BLOCK_FLAGS;
+}
+
+static inline void* _block_payload(const struct _tlsf_block* block)
+{
+	return (uint8_t*)block + BLOCK_HEADER;
+}
+
+static inline struct _tlsf_block* _block_from_payload(const void* ptr)
+{
+	return (struct _tlsf_block*)((uint8_t*)ptr - BLOCK_HEADER);
+}
+
+static inline struct _tlsf_block* _block_next(const struct _tlsf_block* block)
+{
+	return (struct _tlsf_block*)((uint8_t*)_block_payload(block) +
+			_block_size(block));
+}
+
+static void _mapping_insert(uint32_t size, uint32_t* fl, uint32_t* sl)
+{
+	if (size < SMALL_BLOCK_SIZE) {
+		*fl = 0;
+		*sl = size / (SMALL_BLOCK_SIZE / TLSF_SL_INDEX_COUNT);
+	} else {
+		uint32_t msb = _fls(size);
+		*sl = (size >> (msb - TLSF_SL_INDEX_COUNT_LOG2)) ^ TLSF_SL_INDEX_COUNT;
+		*fl = msb - (TLSF_FL_INDEX_SHIFT - 1);
+	}
+}
+
+/* Round size up to the next list so that any block of the list fits */
+static void _mapping_search(uint32_t size, uint32_t* fl, uint32_t* sl)
+{
+	if (size >= SMALL_BLOCK_SIZE)
+		size += (1u << (_fls(size) - TLSF_SL_INDEX_COUNT_LOG2)) - 1;
+	_mapping_insert(size, fl, sl);
+}
+
+static void _insert_free(struct _tlsf* tlsf, struct _tlsf_block* block)
+{
+	uint32_t fl, sl;
+	struct _tlsf_block* head;
+
+	_mapping_insert(_block_size(block), &fl, &sl);
+	head = tlsf->blocks[fl][sl];
+	block->next_free = head;
+	block->prev_free = NULL;
+	if (head)
+		head->prev_free = block;
+	tlsf->blocks[fl][sl] = block;
+	tlsf->fl_bitmap |= 1u << fl;
+	tlsf->sl_bitmap[fl] |= 1u << sl;
+}
+
+static void _remove_free(struct _tlsf* tlsf, struct _tlsf_block* block)
+{
+	uint32_t fl, sl;
+
+	_mapping_insert(_block_size(block), &fl, &sl);
+	if (block->next_free)
+		block->next_free->prev_free = block->prev_free;
+	if (block->prev_free) {
+		block->prev_free->next_free = block->next_free;
+	} else {
+		tlsf->blocks[fl][sl] = block->next_free;
+		if (!block->next_free) {
+			tlsf->sl_bitmap[fl] &= ~(1u << sl);
+			if (!tlsf->sl_bitmap[fl])
+				tlsf->fl_bitmap &= ~(1u << fl);
+		}
+	}
+}
+
+/* Find and remove a free block of at least size bytes */
+static struct _tlsf_block* _locate_free(struct _tlsf* tlsf, uint32_t size)
+{
+	uint32_t fl, sl, sl_map;
+	struct _tlsf_block* block;
+
+	_mapping_search(size, &fl, &sl);
+	if (fl >= TLSF_FL_INDEX_COUNT)
+		return NULL;
+
+	sl_map = tlsf->sl_bitmap[fl] & (~0u << sl);
+	if (!sl_map) {
+		uint32_t fl_map = tlsf->fl_bitmap & (~0u << (fl + 1));
+		if (!fl_map)
+			return NULL;
+		fl = _ffs(fl_map);
+		sl_map = tlsf->sl_bitmap[fl];
+	}
+	sl = _ffs(sl_map);
+
+	block = tlsf->blocks[fl][sl];
+	_remove_free(tlsf, block);
+	return block;
+}
+
+/* Split the first gap bytes of a free block into a free block of their own */
+static struct _tlsf_block* _split_leading(struct _tlsf* tlsf,
+		struct _tlsf_block* block, uint32_t gap)
+{
+	struct _tlsf_block* remaining;
+
+	remaining = (struct _tlsf_block*)((uint8_t*)block + gap);
+	remaining->size = (_block_size(block) - gap) | BLOCK_FREE | BLOCK_PREV_FREE;
+	remaining->prev_phys = block;
+	_block_next(remaining)->prev_phys = remaining;
+
+	block->size = (gap - BLOCK_HEADER) | BLOCK_FREE |
+		(block->size & BLOCK_PREV_FREE);
+	_insert_free(tlsf, block);
+	return remaining;
+}
+
+/* Give back the end of a block beyond size bytes, if large enough */
+static void _trim(struct _tlsf* tlsf, struct _tlsf_block* block, uint32_t size)
+{
+	struct _tlsf_block* remaining;
+	uint32_t block_size = _block_size(block);
+
+	if (block_size < size + BLOCK_HEADER + BLOCK_SIZE_MIN)
+		return;
+
+	remaining = (struct _tlsf_block*)((uint8_t*)_block_payload(block) + size);
+	remaining->size = (block_size - size - BLOCK_HEADER) | BLOCK_FREE;
+	block->size = size | (block->size & BLOCK_FLAGS);
+	_block_next(remaining)->prev_phys = remaining;
+	_block_next(remaining)->size |= BLOCK_PREV_FREE;
+	_insert_free(tlsf, remaining);
+}
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+int tlsf_init(struct _tlsf* tlsf, void* mem, uint32_t size)
+{
+	uintptr_t start = ROUND_UP_MULT((uintptr_t)mem, (uintptr_t)TLSF_ALIGN_SIZE);
+	uintptr_t end = ((uintptr_t)mem + size) & ~(uintptr_t)(TLSF_ALIGN_SIZE - 1);
+	struct _tlsf_block* block;
+	struct _tlsf_block* sentinel;
+	uint32_t payload;
+
+	if (end <= start || end - start < 2 * BLOCK_HEADER + BLOCK_SIZE_MIN)
+		return -EINVAL;
+	payload = end - start - 2 * BLOCK_HEADER;
+	if (payload > BLOCK_SIZE_MAX)
+		return -EINVAL;
+
+	memset(tlsf, 0, sizeof(*tlsf));
+
+	block = (struct _tlsf_block*)start;
+	block->size = payload | BLOCK_FREE;
+
+	/* zero-sized used block closing the region */
+	sentinel = _block_next(block);
+	sentinel->prev_phys = block;
+	sentinel->size = BLOCK_PREV_FREE;
+
+	_insert_free(tlsf, block);
+	tlsf->stats.size = payload;
+	return 0;
+}
+
+void* tlsf_alloc(struct _tlsf* tlsf, uint32_t size)
+{
+	return tlsf_alloc_aligned(tlsf, size, TLSF_ALIGN_SIZE);
+}
+
+void* tlsf_alloc_aligned(struct _tlsf* tlsf, uint32_t size, uint32_t align)
+{
+	struct _tlsf_block* block;
+	uint32_t adjusted, search, flags;
+
+	assert(align == 0 || IS_POWER_OF_TWO(align));
+	if (align < TLSF_ALIGN_SIZE)
+		align = TLSF_ALIGN_SIZE;
+
+	if (size == 0 || size > BLOCK_SIZE_MAX - align) {
+		tlsf->stats.failures++;
+		return NULL;
+	}
+	/* Whole alignment units: the next header never shares a cache line */
+	adjusted = ROUND_UP_MULT(size, align);
+	if (adjusted < BLOCK_SIZE_MIN)
+		adjusted = BLOCK_SIZE_MIN;
+
+	/* room to split off a leading free block up to the alignment */
+	search = adjusted;
+	if (align > TLSF_ALIGN_SIZE)
+		search += align + BLOCK_HEADER + BLOCK_SIZE_MIN;
+
+	flags = arch_irq_save();
+
+	block = _locate_free(tlsf, search);
+	if (!block) {
+		tlsf->stats.failures++;
+		arch_irq_restore(flags);
+		return NULL;
+	}
+
+	if (align > TLSF_ALIGN_SIZE) {
+		uint8_t* ptr = _block_payload(block);
+		uintptr_t payload = (uintptr_t)ptr;
+		uintptr_t aligned = ROUND_UP_MULT(payload, (uintptr_t)align);
+		if (aligned != payload && aligned - payload < BLOCK_HEADER + BLOCK_SIZE_MIN)
+			aligned = ROUND_UP_MULT(payload + BLOCK_HEADER + BLOCK_SIZE_MIN, (uintptr_t)align);
+		if (aligned != payload)
+			block = _split_leading(tlsf, block, aligned - payload);
+	}
+
+	_trim(tlsf, block, adjusted);
+	block->size &= ~BLOCK_FREE;
+	_block_next(block)->size &= ~BLOCK_PREV_FREE;
+
+	tlsf->stats.used += _block_size(block) + BLOCK_HEADER;
+	if (tlsf->stats.used > tlsf->stats.high_water)
+		tlsf->stats.high_water = tlsf->stats.used;
+
+	arch_irq_restore(flags);
+
+	return _block_payload(block);
+}
+
+void tlsf_free(struct _tlsf* tlsf, void* ptr)
+{
+	struct _tlsf_block* block;
+	struct _tlsf_block* next;
+	uint32_t flags;
+
+	if (!ptr)
+		return;
+	block = _block_from_payload(ptr);
+	assert((block->size & BLOCK_FREE) == 0);
+
+	flags = arch_irq_save();
+
+	tlsf->stats.used -= _block_size(block) + BLOCK_HEADER;
+	block->size |= BLOCK_FREE;
+
+	/* merge with the previous and next blocks if they are free */
+	if (block->size & BLOCK_PREV_FREE) {
+		struct _tlsf_block* prev = block->prev_phys;
+		_remove_free(tlsf, prev);
+		prev->size += BLOCK_HEADER + _block_size(block);
+		block = prev;
+	}
+	next = _block_next(block);
+	if (next->size & BLOCK_FREE) {
+		_remove_free(tlsf, next);
+		block->size += BLOCK_HEADER + _block_size(next);
+		next = _block_next(block);
+	}
+	next->prev_phys = block;
+	next->size |= BLOCK_PREV_FREE;
+	_insert_free(tlsf, block);
+
+	arch_irq_restore(flags);
+}
+
+uint32_t tlsf_get_size(const void* ptr)
+{
+	return _block_size(_block_from_payload(ptr));
+}
+
+void tlsf_get_stats(struct _tlsf* tlsf, struct _tlsf_stats* stats)
+{
+	uint32_t flags;
+
+	flags = arch_irq_save();
+	*stats = tlsf->stats;
+	arch_irq_restore(flags);
+}
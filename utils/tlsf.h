@@ -0,0 +1,139 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2015, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef TLSF_H_
+#define TLSF_H_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Definitions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Two-Level Segregated Fit allocator for variable-size regions. Free blocks
+ * are kept in lists indexed by the position of the most significant bit of
+ * their size (first level) and by the next TLSF_SL_INDEX_COUNT_LOG2 bits
+ * (second level). A bitmap per level locates a large enough list with two
+ * bit scans, so allocation and release are O(1), and adjacent free blocks
+ * are merged on release. Each allocation has an 8-byte header.
+ *
+ * Operations mask interrupts while the lists are updated.
+ */
+
+/** log2 of the number of second-level lists per first-level range */
+#ifndef TLSF_SL_INDEX_COUNT_LOG2
+#define TLSF_SL_INDEX_COUNT_LOG2 3
+#endif
+
+/** log2 of the largest block that can be managed (default 16MB) */
+#ifndef TLSF_FL_INDEX_MAX
+#define TLSF_FL_INDEX_MAX 24
+#endif
+
+/** Alignment of the allocated regions */
+#define TLSF_ALIGN_SIZE_LOG2 3
+#define TLSF_ALIGN_SIZE      (1u << TLSF_ALIGN_SIZE_LOG2)
+
+#define TLSF_SL_INDEX_COUNT  (1u << TLSF_SL_INDEX_COUNT_LOG2)
+#define TLSF_FL_INDEX_SHIFT  (TLSF_SL_INDEX_COUNT_LOG2 + TLSF_ALIGN_SIZE_LOG2)
+#define TLSF_FL_INDEX_COUNT  (TLSF_FL_INDEX_MAX - TLSF_FL_INDEX_SHIFT + 1)
+
+/*----------------------------------------------------------------------------
+ *         Type definitions
+ *----------------------------------------------------------------------------*/
+
+struct _tlsf_block;
+
+struct _tlsf_stats {
+	uint32_t size;        /**< Bytes available for allocation when empty */
+	uint32_t used;        /**< Bytes allocated, including headers */
+	uint32_t high_water;  /**< Maximum value of \a used */
+	uint32_t failures;    /**< Allocations that could not be satisfied */
+};
+
+struct _tlsf {
+	uint32_t fl_bitmap;
+	uint32_t sl_bitmap[TLSF_FL_INDEX_COUNT];
+	struct _tlsf_block* blocks[TLSF_FL_INDEX_COUNT][TLSF_SL_INDEX_COUNT];
+	struct _tlsf_stats stats;
+};
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize an allocator managing the given memory.
+ *
+ * \param tlsf  Pointer to the allocator
+ * \param mem  Start of the memory to manage
+ * \param size  Size of the memory, less than 2^TLSF_FL_INDEX_MAX
+ * \return 0 on success, -EINVAL if the memory is too small or too large.
+ */
+extern int tlsf_init(struct _tlsf* tlsf, void* mem, uint32_t size);
+
+/**
+ * \brief Allocate a region aligned on TLSF_ALIGN_SIZE bytes.
+ *
+ * \return a pointer to the region, or NULL if no free block is large enough.
+ */
+extern void* tlsf_alloc(struct _tlsf* tlsf, uint32_t size);
+
+/**
+ * \brief Allocate a region aligned on \a align bytes (power of two, 0 for
+ * TLSF_ALIGN_SIZE), for instance L1_CACHE_BYTES for DMA buffers. The size is
+ * rounded up to a multiple of \a align, so the region ends on the alignment
+ * as well.
+ *
+ * \return a pointer to the region, or NULL if no free block is large enough.
+ */
+extern void* tlsf_alloc_aligned(struct _tlsf* tlsf, uint32_t size,
+		uint32_t align);
+
+/**
+ * \brief Release a region allocated from \a tlsf. NULL is ignored.
+ */
+extern void tlsf_free(struct _tlsf* tlsf, void* ptr);
+
+/**
+ * \brief Get the usable size of an allocated region.
+ */
+extern uint32_t tlsf_get_size(const void* ptr);
+
+/**
+ * \brief Get the usage statistics of an allocator.
+ */
+extern void tlsf_get_stats(struct _tlsf* tlsf, struct _tlsf_stats* stats);
+
+#endif /* TLSF_H_ */
@@ -33,14 +33,170 @@
  *         Headers
  *------------------------------------------------------------------------------*/
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "board.h"
+#include "compiler.h"
+#include "errno.h"
+#include "irqflags.h"
 #include "trace.h"
+#include "timer.h"
 #include "serial/console.h"
 #include "gpio/pio.h"
 
+/*------------------------------------------------------------------------------
+ *         Local types
+ *------------------------------------------------------------------------------*/
+
+#ifdef TRACE_DEFERRED
+
+/** Ring of 32-bit words holding deferred trace records */
+struct _trace_ring {
+	uint32_t* buffer;
+	uint32_t size;          /**< size in words, power of two */
+	uint32_t head;          /**< free-running write index */
+	uint32_t tail;          /**< free-running read index */
+	uint32_t dropped;
+	uint16_t sequence;
+};
+
+#endif /* TRACE_DEFERRED */
+
 /*------------------------------------------------------------------------------
  *         Internal variables
  *------------------------------------------------------------------------------*/
 
 /** Current trace level */
 uint32_t trace_level = TRACE_LEVEL;
+
+/** Current trace level of each module */
+uint8_t trace_module_level[TRACE_MODULE_COUNT] = {
+	[TRACE_MODULE_DEFAULT] = TRACE_LEVEL_DEBUG,
+	[TRACE_MODULE_SDMMC] = TRACE_LEVEL_DEBUG,
+	[TRACE_MODULE_NET] = TRACE_LEVEL_DEBUG,
+	[TRACE_MODULE_USB] = TRACE_LEVEL_DEBUG,
+};
+
+#ifdef TRACE_DEFERRED
+static struct _trace_ring trace_ring;
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+void trace_set_module_level(enum _trace_module module, uint32_t level)
+{
+	if (module < TRACE_MODULE_COUNT)
+		trace_module_level[module] = level;
+}
+
+#ifdef TRACE_DEFERRED
+
+int trace_deferred_enable(void* buffer, uint32_t size)
+{
+	uint32_t flags;
+
+	if (!buffer || ((uint32_t)buffer & 3))
+		return -EINVAL;
+	size /= sizeof(uint32_t);
+	if (!IS_POWER_OF_TWO(size))
+		return -EINVAL;
+
+	flags = arch_irq_save();
+	trace_ring.buffer = (uint32_t*)buffer;
+	trace_ring.size = size;
+	trace_ring.head = 0;
+	trace_ring.tail = 0;
+	trace_ring.dropped = 0;
+	trace_ring.sequence = 0;
+	arch_irq_restore(flags);
+
+	return 0;
+}
+
+void trace_deferred_write(uint32_t level, const char* fmt,
+		const uint32_t* args)
+{
+	struct _trace_ring* ring = &trace_ring;
+	uint32_t nargs = args[0];
+	uint32_t words = 3 + nargs;
+	uint32_t timestamp, flags, mask, i;
+
+	if (!ring->size)
+		return;
+
+	timestamp = (uint32_t)timer_get_tick();
+
+	/* Records are at most 19 words long: store them with interrupts masked
+	 * instead of reserving space and committing afterwards */
+	flags = arch_irq_save();
+	if (ring->size - (ring->head - ring->tail) < words) {
+		ring->dropped++;
+		arch_irq_restore(flags);
+		return;
+	}
+	mask = ring->size - 1;
+	ring->buffer[ring->head++ & mask] = (TRACE_RECORD_SYNC << 24) |
+		((level & 0x7) << 21) | (nargs << 16) | ring->sequence++;
+	ring->buffer[ring->head++ & mask] = (uint32_t)fmt;
+	ring->buffer[ring->head++ & mask] = timestamp;
+	for (i = 1; i <= nargs; i++)
+		ring->buffer[ring->head++ & mask] = args[i];
+	arch_irq_restore(flags);
+}
+
+uint32_t trace_deferred_flush(void)
+{
+	struct _trace_ring* ring = &trace_ring;
+	uint32_t head, tail, start, count, sent = 0;
+
+	if (!ring->size)
+		return 0;
+
+	head = ring->head;
+	tail = ring->tail;
+	while (tail != head) {
+		start = tail & (ring->size - 1);
+		count = head - tail;
+		if (count > ring->size - start)
+			count = ring->size - start;
+		console_put_buffer((const char*)&ring->buffer[start],
+				count * sizeof(uint32_t));
+		tail += count;
+		sent += count * sizeof(uint32_t);
+	}
+	ring->tail = tail;
+
+	return sent;
+}
+
+uint32_t trace_deferred_get_dropped(void)
+{
+	return trace_ring.dropped;
+}
+
+#else /* !TRACE_DEFERRED */
+
+int trace_deferred_enable(void* buffer, uint32_t size)
+{
+	return -ENOTSUP;
+}
+
+void trace_deferred_write(uint32_t level, const char* fmt,
+		const uint32_t* args)
+{
+}
+
+uint32_t trace_deferred_flush(void)
+{
+	return 0;
+}
+
+uint32_t trace_deferred_get_dropped(void)
+{
+	return 0;
+}
+
+#endif /* !TRACE_DEFERRED */
@@ -86,6 +86,20 @@
 #define TRACE_LEVEL TRACE_LEVEL_INFO
 #endif
 
+/** Modules that can be filtered independently at runtime. A source file
+ * selects its module by defining TRACE_MODULE before including any header. */
+enum _trace_module {
+	TRACE_MODULE_DEFAULT = 0,
+	TRACE_MODULE_SDMMC,
+	TRACE_MODULE_NET,
+	TRACE_MODULE_USB,
+	TRACE_MODULE_COUNT,
+};
+
+#ifndef TRACE_MODULE
+#define TRACE_MODULE TRACE_MODULE_DEFAULT
+#endif
+
 /* ------------------------------------------------------------------------------
  *         Exported variables
  * ----------------------------------------------------------------------------*/
@@ -93,21 +107,146 @@
 /** Trace level is modifable at runtime */
 extern uint32_t trace_level;
 
+/** Per-module trace level, checked in addition to trace_level */
+extern uint8_t trace_module_level[TRACE_MODULE_COUNT];
+
+/* ------------------------------------------------------------------------------
+ *         Deferred backend
+ * ----------------------------------------------------------------------------*/
+
+/*
+ * With CONFIG_HAVE_TRACE_DEFERRED, the trace macros do not format anything on
+ * the target. Each call site stores its format string in the non-allocated
+ * ".trace_fmt" section of the ELF and appends a binary record to a RAM ring:
+ *
+ *   word 0: TRACE_RECORD_SYNC << 24 | level << 21 | nargs << 16 | sequence
+ *   word 1: address of the format string in .trace_fmt
+ *   word 2: timestamp, low 32 bits of timer_get_tick()
+ *   word 3..: arguments, each converted to 32 bits
+ *
+ * The ring is sent as-is by trace_deferred_flush() and decoded on the host
+ * with scripts/trace_decode.py, which reads the format strings from the ELF.
+ *
+ * Limitations: format strings must be literals with at most
+ * TRACE_RECORD_MAX_ARGS arguments, 64-bit and floating point
+ * arguments are truncated to 32 bits, and "%s" arguments are only resolved
+ * when they point to constant data present in the ELF.
+ */
+
+#if defined(CONFIG_HAVE_TRACE_DEFERRED) && defined(__GNUC__)
+#define TRACE_DEFERRED
+#endif
+
+#define TRACE_RECORD_SYNC      0xA5
+#define TRACE_RECORD_MAX_ARGS  16
+
+#ifdef TRACE_DEFERRED
+
+#define _TRACE_NARGS(...) _TRACE_NARGS_(_, ##__VA_ARGS__, \
+	16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define _TRACE_NARGS_(_, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, \
+	a13, a14, a15, a16, n, ...) n
+
+/* Go through a local so that arguments that are calls do not trigger
+ * -Wbad-function-cast; the conditional promotes bit-fields and arrays */
+#define _TRACE_ARG(a) \
+	({ __auto_type _trace_arg = 0 ? (a) : (a); (uint32_t)_trace_arg; })
+
+#define _TRACE_ARGS(n, ...) _TRACE_ARGS_(n, ##__VA_ARGS__)
+#define _TRACE_ARGS_(n, ...) _TRACE_ARGS_##n(__VA_ARGS__)
+#define _TRACE_ARGS_0(...)
+#define _TRACE_ARGS_1(a) , _TRACE_ARG(a)
+#define _TRACE_ARGS_2(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_1(__VA_ARGS__)
+#define _TRACE_ARGS_3(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_2(__VA_ARGS__)
+#define _TRACE_ARGS_4(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_3(__VA_ARGS__)
+#define _TRACE_ARGS_5(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_4(__VA_ARGS__)
+#define _TRACE_ARGS_6(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_5(__VA_ARGS__)
+#define _TRACE_ARGS_7(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_6(__VA_ARGS__)
+#define _TRACE_ARGS_8(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_7(__VA_ARGS__)
+#define _TRACE_ARGS_9(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_8(__VA_ARGS__)
+#define _TRACE_ARGS_10(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_9(__VA_ARGS__)
+#define _TRACE_ARGS_11(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_10(__VA_ARGS__)
+#define _TRACE_ARGS_12(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_11(__VA_ARGS__)
+#define _TRACE_ARGS_13(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_12(__VA_ARGS__)
+#define _TRACE_ARGS_14(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_13(__VA_ARGS__)
+#define _TRACE_ARGS_15(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_14(__VA_ARGS__)
+#define _TRACE_ARGS_16(a, ...) , _TRACE_ARG(a) _TRACE_ARGS_15(__VA_ARGS__)
+
+/* args[0] holds the argument count, followed by the arguments */
+#define _TRACE_DEFER(lvl, fmt, ...) do { \
+	static const char _trace_fmt[] \
+		__attribute__((section(".trace_fmt"), used, aligned(1))) = fmt; \
+	const uint32_t _trace_args[] = { _TRACE_NARGS(__VA_ARGS__) \
+		_TRACE_ARGS(_TRACE_NARGS(__VA_ARGS__), ##__VA_ARGS__) }; \
+	trace_deferred_write((lvl), _trace_fmt, _trace_args); } while (0)
+
+#define _TRACE_OUT(lvl, ...) _TRACE_DEFER(lvl, __VA_ARGS__)
+
+#else /* !TRACE_DEFERRED */
+
+#define _TRACE_OUT(lvl, ...) printf(__VA_ARGS__)
+
+#endif /* !TRACE_DEFERRED */
+
+#define _TRACE_ENABLED(lvl) \
+	(trace_level >= (lvl) && trace_module_level[TRACE_MODULE] >= (lvl))
+
 /* ------------------------------------------------------------------------------
  *         Exported functions
  * ----------------------------------------------------------------------------*/
 
+/**
+ * \brief Set the runtime trace level of a single module.
+ */
+extern void trace_set_module_level(enum _trace_module module, uint32_t level);
+
+/**
+ * \brief Start recording deferred traces into the given ring.
+ *
+ * timer_configure() must have been called before, as records are timestamped
+ * with timer_get_tick().
+ *
+ * \param buffer  Ring storage, aligned on 4 bytes.
+ * \param size    Size of the ring in bytes, must be a power of two.
+ * \return 0 on success, a negative error code otherwise.
+ */
+extern int trace_deferred_enable(void* buffer, uint32_t size);
+
+/**
+ * \brief Append a record to the deferred trace ring. Called by the trace
+ * macros, can be used from interrupt context.
+ *
+ * \param level  Trace level of the record.
+ * \param fmt    Format string, located in the .trace_fmt section.
+ * \param args   Argument count followed by the arguments.
+ */
+extern void trace_deferred_write(uint32_t level, const char* fmt,
+		const uint32_t* args);
+
+/**
+ * \brief Send the pending deferred trace records on the console.
+ *
+ * \return the number of bytes sent.
+ */
+extern uint32_t trace_deferred_flush(void);
+
+/**
+ * \brief Number of records lost because the ring was full.
+ */
+extern uint32_t trace_deferred_get_dropped(void);
+
 /**
  *  Outputs a formatted string using 'printf' if the log level is high
  *  enough. Can be disabled by defining TRACE_LEVEL=0 during compilation.
+ *  Fatal traces are always formatted on the target.
  *  \param ...  Additional parameters depending on formatted string.
  */
 
 #if (TRACE_LEVEL >= 1)
 #define trace_fatal(...) \
-	do { if (trace_level >= TRACE_LEVEL_FATAL) printf("-F- " __VA_ARGS__); while (1) ; } while (0)
+	do { if (_TRACE_ENABLED(TRACE_LEVEL_FATAL)) printf("-F- " __VA_ARGS__); while (1) ; } while (0)
 #define trace_fatal_wp(...) \
-	do { if (trace_level >= TRACE_LEVEL_FATAL) printf(__VA_ARGS__); while (1) ; } while (0)
+	do { if (_TRACE_ENABLED(TRACE_LEVEL_FATAL)) printf(__VA_ARGS__); while (1) ; } while (0)
 #else
 #define trace_fatal(...) \
 	do {} while (1)
@@ -117,9 +256,9 @@ extern uint32_t trace_level;
 
 #if (TRACE_LEVEL >= 2)
 #define trace_error(...) \
-	do { if (trace_level >= TRACE_LEVEL_ERROR) printf("-E- " __VA_ARGS__); } while (0)
+	do { if (_TRACE_ENABLED(TRACE_LEVEL_ERROR)) _TRACE_OUT(TRACE_LEVEL_ERROR, "-E- " __VA_ARGS__); } while (0)
 #define trace_error_wp(...) \
-	do { if (trace_level >= TRACE_LEVEL_ERROR) printf(__VA_ARGS__); } while (0)
+	do { if (_TRACE_ENABLED(TRACE_LEVEL_ERROR)) _TRACE_OUT(TRACE_LEVEL_ERROR, __VA_ARGS__); } while (0)
 #else
 #define trace_error(...) ((void)0)
 #define trace_error_wp(...) ((void)0)
@@ -127,9 +266,9 @@ extern uint32_t trace_level;
 
 #if (TRACE_LEVEL >= 3)
 #define trace_warning(...) \
-	do { if (trace_level >= TRACE_LEVEL_WARNING) printf("-W- " __VA_ARGS__); } while (0)
+	do { if (_TRACE_ENABLED(TRACE_LEVEL_WARNING)) _TRACE_OUT(TRACE_LEVEL_WARNING, "-W- " __VA_ARGS__); } while (0)
 #define trace_warning_wp(...) \
-	do { if (trace_level >= TRACE_LEVEL_WARNING) printf(__VA_ARGS__); } while (0)
+	do { if (_TRACE_ENABLED(TRACE_LEVEL_WARNING)) _TRACE_OUT(TRACE_LEVEL_WARNING, __VA_ARGS__); } while (0)
 #else
 #define trace_warning(...) ((void)0)
 #define trace_warning_wp(...) ((void)0)
@@ -137,9 +276,9 @@ extern uint32_t trace_level;
 
 #if (TRACE_LEVEL >= 4)
 #define trace_info(...) \
-	do { if (trace_level >= TRACE_LEVEL_INFO) printf("-I- " __VA_ARGS__); } while (0)
+	do { if (_TRACE_ENABLED(TRACE_LEVEL_INFO)) _TRACE_OUT(TRACE_LEVEL_INFO, "-I- " __VA_ARGS__); } while (0)
 #define trace_info_wp(...) \
-	do { if (trace_level >= TRACE_LEVEL_INFO) printf(__VA_ARGS__); } while (0)
+	do { if (_TRACE_ENABLED(TRACE_LEVEL_INFO)) _TRACE_OUT(TRACE_LEVEL_INFO, __VA_ARGS__); } while (0)
 #else
 #define trace_info(...) ((void)0)
 #define trace_info_wp(...) ((void)0)
@@ -147,9 +286,9 @@ extern uint32_t trace_level;
 
 #if (TRACE_LEVEL >= 5)
 #define trace_debug(...) \
-	do { if (trace_level >= TRACE_LEVEL_DEBUG) printf("-D- " __FILE__ ":" STRINGIFY(__LINE__) " " __VA_ARGS__); } while (0)
+	do { if (_TRACE_ENABLED(TRACE_LEVEL_DEBUG)) _TRACE_OUT(TRACE_LEVEL_DEBUG, "-D- " __FILE__ ":" STRINGIFY(__LINE__) " " __VA_ARGS__); } while (0)
 #define trace_debug_wp(...) \
-	do { if (trace_level >= TRACE_LEVEL_DEBUG) printf(__VA_ARGS__); } while (0)
+	do { if (_TRACE_ENABLED(TRACE_LEVEL_DEBUG)) _TRACE_OUT(TRACE_LEVEL_DEBUG, __VA_ARGS__); } while (0)
 #else
 #define trace_debug(...) ((void)0)
 #define trace_debug_wp(...) ((void)0)